@@ -0,0 +1,200 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcDecoderApp.cpp
+ * \brief    Main definition of the GvcDecoderApp
+ */
+
+#include "GvcDecoderApp.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <list>
+
+#include "GvcFrameUnit.h"
+#include "GvcNal.h"
+#include "GvcPrimitives.h"
+#include "program_options_lite.h"
+
+using namespace std;
+namespace po = df::program_options_lite;
+
+GvcDecoderApp::GvcDecoderApp()
+	: m_bReconFileOpen( false )
+	, m_iNumFrames( 0 )
+	, m_iNumErrors( 0 )
+	, m_iNumCorruptFrames( 0 )
+	, m_uiNumBits( 0 )
+	, m_outputBitDepth( 0 )
+	, m_iSimdLevel( -1 )
+	, m_iNumThreads( 0 )
+	, m_iFrameThreads( 1 )
+{
+}
+
+GvcDecoderApp::~GvcDecoderApp()
+{
+}
+
+/** The bitstream is read a chunk at a time and split into NAL units as it goes, each one decoded before the next is
+ *  read; the frames are written as the decoder finishes them. A NAL unit that does not decode is reported and
+ *  skipped, the frames after it still decode from the next intra frame on.
+ */
+bool GvcDecoderApp::decode()
+{
+	std::ifstream bitstreamFile( m_bitstreamFileName.c_str(), std::ifstream::in | std::ifstream::binary );
+	if( !bitstreamFile )
+	{
+		fprintf( stderr, "\nfailed to open bitstream file `%s' for reading\n", m_bitstreamFileName.c_str() );
+		exit( EXIT_FAILURE );
+	}
+	m_cGvcDec.setSimdLevel( m_iSimdLevel );
+	m_cGvcDec.setNumThreads( m_iNumThreads );
+	m_cGvcDec.setFrameThreads( m_iFrameThreads );
+	m_cGvcDec.create();
+	printf( "SIMD kernels                           : %s\n\n", gvcCpuLevelName( getPrimitivesCpuLevel() ) );
+
+	GvcByteStreamReader cReader;
+	cReader.init( &bitstreamFile );
+	NalUnitType eType;
+	std::vector<unsigned char> aucPayload;
+	int iNumDecoded = 0;
+	while( cReader.readNALUnit( eType, aucPayload ) )
+	{
+		const unsigned long long uiNALEnd = cReader.getNumBytesRead();
+		if( !m_cGvcDec.decode( eType, aucPayload, iNumDecoded ) )
+		{
+			fprintf( stderr, "Warning: %s NAL unit ending before byte %llu could not be decoded\n",
+					 eType == NAL_UNIT_SEQUENCE_HEADER ? "sequence header" : "frame", uiNALEnd );
+			m_iNumErrors++;
+		}
+		xWriteOutput( iNumDecoded );
+	}
+	m_cGvcDec.flush( iNumDecoded );
+	xWriteOutput( iNumDecoded );
+
+	m_cGvcDec.printSummary();
+	m_cGvcDec.destroy();
+	m_cTVideoIOYuvReconFile.close();
+	printf( "\nFrames decoded: %d, bytes read: %llu", m_iNumFrames, cReader.getNumBytesRead() );
+	if( m_iNumFrames > 0 )
+	{
+		printf( ", %.2f kbits per frame", m_uiNumBits / 1000.0 / m_iNumFrames );
+	}
+	printf( "\n" );
+	if( m_iNumErrors > 0 )
+	{
+		printf( "NAL units with errors: %d\n", m_iNumErrors );
+	}
+	if( m_iNumCorruptFrames > 0 )
+	{
+		printf( "Frames with errors: %d\n", m_iNumCorruptFrames );
+	}
+	return m_iNumErrors == 0 && m_iNumCorruptFrames == 0;
+}
+
+/** The reconstruction file takes the format of the first frame, the sequence headers of a stream share it.
+ */
+void GvcDecoderApp::xWriteOutput( int iNumDecoded )
+{
+	for( int i = 0; i < iNumDecoded; i++ )
+	{
+		const GvcDecodedFrame& rcDecoded = m_cGvcDec.getDecodedFrame( i );
+		if( !m_reconFileName.empty() && !m_bReconFileOpen )
+		{
+			int aiInternalBitDepth[MAX_NUM_CHANNEL_TYPE];
+			int aiFileBitDepth[MAX_NUM_CHANNEL_TYPE];
+			for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+			{
+				aiInternalBitDepth[ch] = m_cGvcDec.getBitDepth( ChannelType( ch ) );
+				aiFileBitDepth[ch] = m_outputBitDepth > 0 ? m_outputBitDepth : aiInternalBitDepth[ch];
+			}
+			m_cTVideoIOYuvReconFile.open( m_reconFileName, true, aiFileBitDepth, aiFileBitDepth, aiInternalBitDepth );  // write mode
+			m_bReconFileOpen = true;
+		}
+		if( m_bReconFileOpen )
+		{
+			m_cTVideoIOYuvReconFile.write( rcDecoded.pcFrame, IPCOLOURSPACE_UNCHANGED, 0, 0, 0, 0, NUM_CHROMA_FORMAT, false );
+		}
+		printf( "Frame %4d ( %c-frame, QP %2d ) %10u bits%s\n", rcDecoded.iFrameNumber, rcDecoded.eType == I_FRAME ? 'I' : 'P', rcDecoded.iQP,
+				rcDecoded.uiNumBytes * 8, rcDecoded.bCorrupt ? "  [corrupt]" : "" );
+		m_iNumCorruptFrames += rcDecoded.bCorrupt ? 1 : 0;
+		m_uiNumBits += rcDecoded.uiNumBytes * 8ull;
+		m_iNumFrames++;
+	}
+	fflush( stdout );
+}
+
+bool GvcDecoderApp::parseCfg( int argc, char* argv[] )
+{
+	bool do_help = true;
+
+	po::Options opts;
+	opts.addOptions()
+			( "help", do_help, false, "this help text" )
+			( "BitstreamFile,b", m_bitstreamFileName, string( "" ), "Bitstream input file name" )
+			( "ReconFile,o", m_reconFileName, string( "" ), "Reconstructed YUV output file name, not written when empty" )
+			( "OutputBitDepth,d", m_outputBitDepth, 0, "Bit depth of the YUV output file (0: the internal bit depth)" )
+			( "SIMD", m_iSimdLevel, -1, "Kernel instruction set (-1: auto, 0: C, 1: SSE4.1, 2: AVX2, 3: AVX-512)" )
+			( "Threads", m_iNumThreads, 0, "Threads decoding BU rows or tiles (0: one per hardware thread)" )
+			( "FrameThreads", m_iFrameThreads, 1, "Frames decoded at once, each waiting only for the reference rows it reads" );
+
+	po::setDefaults( opts );
+	po::ErrorReporter err;
+	const list<const char*>& argv_unhandled = po::scanArgv( opts, argc, (const char**)argv, err );
+
+	for( list<const char*>::const_iterator it = argv_unhandled.begin(); it != argv_unhandled.end(); it++ )
+	{
+		fprintf( stderr, "Unhandled argument ignored: `%s'\n", *it );
+	}
+
+	if( argc == 1 || do_help )
+	{
+		/* argc == 1: no options have been specified */
+		po::doHelp( cout, opts );
+		return false;
+	}
+
+	if( err.is_errored )
+	{
+		/* error report has already been printed on stderr */
+		return false;
+	}
+
+	bool check_failed = false;
+	check_failed |= confirmPara( m_bitstreamFileName.empty(), "A bitstream file name must be specified (BitstreamFile)" );
+	check_failed |= confirmPara( m_outputBitDepth < 0 || m_outputBitDepth > 16, "OutputBitDepth must be between 0 and 16" );
+	check_failed |= confirmPara( m_iSimdLevel < -1 || m_iSimdLevel >= NUM_GVC_CPU_LEVELS, "SIMD level must be between -1 and 3" );
+	check_failed |= confirmPara( m_iNumThreads < 0, "Threads must not be negative" );
+	check_failed |= confirmPara( m_iFrameThreads < 1, "FrameThreads must be at least 1" );
+	return !check_failed;
+}
+
+bool GvcDecoderApp::confirmPara( bool bflag, const char* message )
+{
+	if( !bflag )
+	{
+		return false;
+	}
+
+	printf( "Error: %s\n", message );
+	return true;
+}
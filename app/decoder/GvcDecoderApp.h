@@ -0,0 +1,69 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcDecoderApp.h
+ * \brief    Main definition of the GvcDecoderApp
+ */
+
+#ifndef __GVCDECODERAPP_H__
+#define __GVCDECODERAPP_H__
+
+#include <string>
+
+#include "TypeDef.h"
+#include "GvcDecoder.h"
+#include "TVideoIOYuv.h"
+
+/// decoder application class
+class GvcDecoderApp
+{
+  private:
+	// class interface
+	GvcDecoder                  m_cGvcDec;                     ///< decoder class
+	TVideoIOYuv                 m_cTVideoIOYuvReconFile;       ///< output reconstruction file, opened with the first frame
+	bool                        m_bReconFileOpen;
+	int                         m_iNumFrames;                  ///< frames decoded
+	int                         m_iNumErrors;                  ///< NAL units that could not be decoded
+	int                         m_iNumCorruptFrames;           ///< frames decoded with errors
+	unsigned long long          m_uiNumBits;                   ///< of the frame NAL unit payloads
+
+  protected:
+	// file I/O
+	std::string m_bitstreamFileName;  ///< input bitstream file
+	std::string m_reconFileName;      ///< output reconstruction file
+	int       m_outputBitDepth;       ///< bit depth of the reconstruction file (0: the internal one)
+	// performance
+	int       m_iSimdLevel;           ///< instruction set of the kernels (-1: auto)
+	int       m_iNumThreads;          ///< threads decoding BU rows or tiles (0: one per hardware thread)
+	int       m_iFrameThreads;        ///< frames decoded at once
+	// internal member functions
+	bool confirmPara( bool bflag, const char* message );
+	// file I/O
+	void xWriteOutput( int iNumDecoded );  ///< write and report the frames finished by the last call of the decoder
+  public:
+	GvcDecoderApp();
+	virtual ~GvcDecoderApp();
+	/// main decoding function, false if some of the stream could not be decoded
+	bool decode();
+	GvcDecoder& getGvcDec() { return m_cGvcDec; }  ///< return decoder class reference
+	bool parseCfg( int argc, char* argv[] );  ///< parse the command line to fill member variables
+};
+
+#endif  // __GVCDECODERAPP_H__
@@ -22,9 +22,28 @@
  * \brief    Decoder app main file
  */
 
+#include <time.h>
+#include <iostream>
+#include "GvcDecoderApp.h"
+#include "program_options_lite.h"
+
 int main( int argc, char* argv[] )
 {
-	int iRet = 0;
+	GvcDecoderApp cGvcDecoderApp;
+
+	// parse configuration
+	if( !cGvcDecoderApp.parseCfg( argc, argv ) )
+	{
+		return 1;
+	}
+	// starting time
+	double dResult;
+	clock_t lBefore = clock();
+	// call decoding function
+	const bool bDecoded = cGvcDecoderApp.decode();
+	// ending time
+	dResult = (double)( clock() - lBefore ) / CLOCKS_PER_SEC;
+	printf( "\n Total Time: %12.3f sec.\n", dResult );
 
-	return iRet;
+	return bDecoded ? 0 : 1;
 }
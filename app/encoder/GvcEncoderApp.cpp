@@ -23,14 +23,42 @@
  */
 
 #include "GvcEncoderApp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
 #include "GvcFrameUnit.h"
+#include "GvcPrimitives.h"
 #include "program_options_lite.h"
 
 namespace po = df::program_options_lite;
 
+/// access units are written to the bitstream file in chunks of at least this size
+static const size_t OUTPUT_CHUNK_SIZE = 1 << 20;
+
+/// integers separated by spaces or commas
+static std::vector<int> parseIntList( const std::string& rcList )
+{
+	std::string cList = rcList;
+	std::replace( cList.begin(), cList.end(), ',', ' ' );
+	std::istringstream cStream( cList );
+	std::vector<int> aiValues;
+	int iValue;
+	while( cStream >> iValue )
+	{
+		aiValues.push_back( iValue );
+	}
+	return aiValues;
+}
+
 GvcEncoderApp::GvcEncoderApp()
 {
-	m_iFrameRcvd = 0;
 	m_totalBytes = 0;
 }
 
@@ -55,74 +83,449 @@ void GvcEncoderApp::encode()
 		fprintf(stderr, "\nfailed to open bitstream file `%s' for writing\n", m_bitstreamFileName.c_str());
 		exit(EXIT_FAILURE);
 	}
-	// Original and Recon frame
-	GvcFrameUnit*       pcFrameOrg = new GvcFrameUnit;
-	GvcFrameUnit*       pcFrameRec = new GvcFrameUnit;
-    // allocate original YUV buffer
-    pcFrameOrg->create( m_iSourceWidth, m_iSourceHeight, m_chromaFormat, m_uiMaxBUWidth, m_uiMaxBUHeight, true );
-    pcFrameRec->create( m_iSourceWidth, m_iSourceHeight, m_chromaFormat, m_uiMaxBUWidth, m_uiMaxBUHeight, true );
+	if ( !m_acStitchFileNames.empty() )
+	{
+		xStitchFiles( bitstreamFile );
+		printf("Bytes written to file: %u\n", m_totalBytes);
+		return;
+	}
 	// initialize internal class & member variables
-	xInitLibCfg();
+	xInitLibCfg( m_cGvcEnc );
 	xCreateLib();
-	// main encoder loop
-	int   iNumEncoded = 0;
-	while ( m_iFrameRcvd != m_framesToBeEncoded )
-	{
-		m_cTVideoIOYuvInputFile.read( pcFrameOrg, pcFrameOrg, IPCOLOURSPACE_UNCHANGED, m_aiPad, m_chromaFormat, false );
-		m_iFrameRcvd++;
-		m_cGvcEnc.encode(pcFrameOrg, pcFrameRec);
-		m_cTVideoIOYuvReconFile.write( pcFrameRec, IPCOLOURSPACE_UNCHANGED, 0, 0, 0, 0, NUM_CHROMA_FORMAT, false  );
-	}
-	//m_cGvcEnc.printSummary(false); // TODO: Add to GvcEncoder
-	// delete original YUV buffer
-	pcFrameOrg->destroy();
-	delete pcFrameOrg;
-	pcFrameOrg = NULL;
-	// delete used buffers in encoder class
-	//m_cGvcEnc.deletePicBuffer(); // TODO: Add to GvcEncoder
-	//cFrameYuvTrueOrg.destroy();
-	pcFrameRec->destroy();
-	delete pcFrameRec;
-	pcFrameRec = NULL;
+	printf( "SIMD kernels                           : %s\n\n", gvcCpuLevelName( getPrimitivesCpuLevel() ) );
+	const int iFirstFrame = m_iSegmentFrames > 0 ? m_iSegmentStart : 0;
+	const int iNumFrames = m_iSegmentFrames > 0 ? m_iSegmentFrames : m_framesToBeEncoded;
+	if ( m_iSegmentThreads > 1 )
+	{
+		xEncodeSegments( bitstreamFile, iFirstFrame, iNumFrames );
+	}
+	else
+	{
+		GvcSegment cSegment;
+		cSegment.iFirstFrame = iFirstFrame;
+		cSegment.iNumFrames = iNumFrames;
+		xOpenInputFile( m_cTVideoIOYuvInputFile, iFirstFrame );
+		m_cGvcEnc.startSegment( iFirstFrame );
+		xEncodeSegment( m_cGvcEnc, m_cTVideoIOYuvInputFile, m_cQualityAnalyser, cSegment, &bitstreamFile );
+		m_cGvcEnc.printSummary();
+	}
+	m_cQualityAnalyser.printSummary();
 	// delete buffers & classes
 	xDestroyLib();
 	printf("Bytes written to file: %u\n", m_totalBytes);
 	return;
 }
 
-void GvcEncoderApp::xInitLibCfg()
+/** Codes the frames of rcSegment with rcEncoder in a pipeline whose stages run at once on frames of their own:
+ *  ReadThreads threads read the source, the pool prepares each frame read for the motion search, this thread encodes
+ *  FrameThreads frames at once, their in-loop filters running behind the BU rows, and a last thread writes the frames
+ *  in order while their quality is measured. The stages pass the frame numbers on through bounded queues; a frame
+ *  keeps its buffers from its read to its write, so a stage running ahead waits for a free one.
+ *  With pcBitstreamFile, the only segment of the run: the access units go to the file as they are written, along
+ *  with the reconstruction and the quality of each frame. Otherwise they are kept in rcSegment, to be written once
+ *  the segments before it are.
+ */
+void GvcEncoderApp::xEncodeSegment( GvcEncoder& rcEncoder, TVideoIOYuv& rcInputFile, GvcQualityAnalyser& rcQualityAnalyser, GvcSegment& rcSegment,
+									std::ostream* pcBitstreamFile )
 {
-	m_cGvcEnc.setSourceWidth                                       ( m_iSourceWidth );
-	m_cGvcEnc.setSourceHeight                                      ( m_iSourceHeight );
-	m_cGvcEnc.setFramesToBeEncoded                                 ( m_framesToBeEncoded );
-	m_cGvcEnc.setNumEncodedFrames                                  ( 0 );
-	m_cGvcEnc.setQP                                                ( m_iQP );
-	m_cGvcEnc.setPad                                               ( m_aiPad );
-	m_cGvcEnc.setChromaFormat                                      ( m_chromaFormat  );
-	m_cGvcEnc.setMaxBUWidth                                        ( m_uiMaxBUWidth );
-	m_cGvcEnc.setMaxBUHeight                                       ( m_uiMaxBUHeight );
-	m_cGvcEnc.setMaxTotalBUDepth                                   ( m_uiMaxBUDepth );
+	// Original and Recon frames: one of each per frame in flight in the encoder, plus the reference of the oldest,
+	// plus the frame whose quality is measured while the next one is written, plus those read ahead
+	const int iNumBuffers = m_iFrameThreads + 2 + m_iPipelineFrames;
+	GvcPipeline cPipeline;
+	cPipeline.apcFrameOrg.resize( iNumBuffers );
+	cPipeline.apcFrameRec.resize( iNumBuffers );
+	cPipeline.aaucAccessUnit.resize( iNumBuffers );
+	for ( int i = 0; i < iNumBuffers; i++ )
+	{
+		cPipeline.apcFrameOrg[i] = new GvcFrameUnit;
+		cPipeline.apcFrameRec[i] = new GvcFrameUnit;
+		cPipeline.apcFrameOrg[i]->create( m_iSourceWidth, m_iSourceHeight, m_chromaFormat, m_uiMaxBUWidth, m_uiMaxBUHeight, true );
+		cPipeline.apcFrameRec[i]->create( m_iSourceWidth, m_iSourceHeight, m_chromaFormat, m_uiMaxBUWidth, m_uiMaxBUHeight, true );
+	}
+	cPipeline.cFreeQueue.create( iNumBuffers, 0, rcSegment.iNumFrames );
+	cPipeline.cPreparedQueue.create( iNumBuffers, 0, rcSegment.iNumFrames );
+	cPipeline.cEncodedQueue.create( iNumBuffers, 0, rcSegment.iNumFrames );
+	for ( int iFrame = 0; iFrame < std::min( iNumBuffers, rcSegment.iNumFrames ); iFrame++ )
+	{
+		cPipeline.cFreeQueue.push( iFrame );
+	}
+
+	std::vector<std::thread> acThreads;
+	for ( int i = 0; i < m_iReadThreads; i++ )
+	{
+		acThreads.push_back( std::thread( [&, i]() { xReadFrames( cPipeline, rcEncoder, i ? NULL : &rcInputFile, rcSegment.iFirstFrame ); } ) );
+	}
+	acThreads.push_back( std::thread( [&]() { xWriteFrames( cPipeline, rcQualityAnalyser, rcSegment, pcBitstreamFile ); } ) );
+	xEncodeFrames( cPipeline, rcEncoder );
+	for ( size_t i = 0; i < acThreads.size(); i++ )
+	{
+		acThreads[i].join();
+	}
+	{
+		std::unique_lock<std::mutex> lock( cPipeline.cPrepareMutex );
+		cPipeline.cPrepareCond.wait( lock, [&] { return cPipeline.iNumPreparing == 0; } );
+	}
+
+	if ( pcBitstreamFile )
+	{
+		// a stage that often waits for its input is the one to give more threads to
+		printf( "\nPipeline (%d frames buffered)\n", iNumBuffers );
+		printf( "    Reads waiting for a free frame      : %llu\n", cPipeline.cFreeQueue.getNumPopWaits() );
+		printf( "    Encodes waiting for a preparation   : %llu\n", cPipeline.cPreparedQueue.getNumPopWaits() );
+		printf( "    Writes waiting for an encoded frame : %llu\n", cPipeline.cEncodedQueue.getNumPopWaits() );
+	}
+	// delete original and recon YUV buffers
+	for ( int i = 0; i < iNumBuffers; i++ )
+	{
+		cPipeline.apcFrameOrg[i]->destroy();
+		delete cPipeline.apcFrameOrg[i];
+		cPipeline.apcFrameRec[i]->destroy();
+		delete cPipeline.apcFrameRec[i];
+	}
+}
+
+/// read stage: the frames whose buffers are free, from pcInputFile or else from a file of its own
+void GvcEncoderApp::xReadFrames( GvcPipeline& rcPipeline, GvcEncoder& rcEncoder, TVideoIOYuv* pcInputFile, int iFirstFrame )
+{
+	const int iNumBuffers = (int)rcPipeline.apcFrameOrg.size();
+	TVideoIOYuv cInputFile;
+	if ( !pcInputFile )
+	{
+		xOpenInputFile( cInputFile, iFirstFrame );
+		pcInputFile = &cInputFile;
+	}
+	int iFrame;
+	int iFilePos = 0;
+	while ( rcPipeline.cFreeQueue.pop( iFrame ) )
+	{
+		GvcFrameUnit* pcFrameOrg = rcPipeline.apcFrameOrg[iFrame % iNumBuffers];
+		// the other readers took the frames in between
+		pcInputFile->skipFrames( iFrame - iFilePos, m_iSourceWidth - m_aiPad[0], m_iSourceHeight - m_aiPad[1], m_chromaFormat );
+		pcInputFile->read( pcFrameOrg, pcFrameOrg, IPCOLOURSPACE_UNCHANGED, m_aiPad, m_chromaFormat, false );
+		iFilePos = iFrame + 1;
+		xPrepareFrame( rcPipeline, rcEncoder, iFirstFrame, iFrame );
+	}
+	if ( pcInputFile == &cInputFile )
+	{
+		cInputFile.close();
+	}
+}
+
+/** Prepares a frame read for the motion search, see GvcEncoder::prepareMotionSearch: a job of the pool, or run by the
+ *  reader when the pool has no threads. The job never waits, the prepared queue having room for every frame whose
+ *  buffers are taken, so it may be queued in any order; the frame number as priority runs it ahead of the rows of the
+ *  frames after it.
+ */
+void GvcEncoderApp::xPrepareFrame( GvcPipeline& rcPipeline, GvcEncoder& rcEncoder, int iFirstFrame, int iFrame )
+{
+	GvcFrameUnit* pcFrameOrg = rcPipeline.apcFrameOrg[iFrame % rcPipeline.apcFrameOrg.size()];
+	GvcThreadPool* pcThreadPool = rcEncoder.getThreadPool();
+	if ( pcThreadPool->getNumThreads() == 0 )
+	{
+		rcEncoder.prepareMotionSearch( pcFrameOrg, iFirstFrame + iFrame );
+		rcPipeline.cPreparedQueue.push( iFrame );
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock( rcPipeline.cPrepareMutex );
+		rcPipeline.iNumPreparing++;
+	}
+	pcThreadPool->enqueue( [&rcPipeline, &rcEncoder, pcFrameOrg, iFirstFrame, iFrame]( int ) {
+		rcEncoder.prepareMotionSearch( pcFrameOrg, iFirstFrame + iFrame );
+		rcPipeline.cPreparedQueue.push( iFrame );
+		// notified under the lock, the pipeline is freed as soon as the count is seen at 0
+		std::lock_guard<std::mutex> lock( rcPipeline.cPrepareMutex );
+		if ( --rcPipeline.iNumPreparing == 0 )
+		{
+			rcPipeline.cPrepareCond.notify_all();
+		}
+	}, iFirstFrame + iFrame );
+}
+
+/// encoding stage, the frames finished are passed on with their access units
+void GvcEncoderApp::xEncodeFrames( GvcPipeline& rcPipeline, GvcEncoder& rcEncoder )
+{
+	const int iNumBuffers = (int)rcPipeline.apcFrameOrg.size();
+	int iNumFramesDone = 0;
+	int iNumEncoded = 0;
+	int iFrame;
+	while ( rcPipeline.cPreparedQueue.pop( iFrame ) )
+	{
+		// every frame after the first is predicted from the previous reconstruction, which may still be in flight
+		GvcFrameUnit* pcFrameRef = iFrame > 0 ? rcPipeline.apcFrameRec[(iFrame - 1) % iNumBuffers] : NULL;
+		rcEncoder.encode( rcPipeline.apcFrameOrg[iFrame % iNumBuffers], rcPipeline.apcFrameRec[iFrame % iNumBuffers], pcFrameRef, iNumEncoded, true );
+		xPushEncoded( rcPipeline, rcEncoder, iNumFramesDone, iNumEncoded );
+		iNumFramesDone += iNumEncoded;
+	}
+	rcEncoder.flush( iNumEncoded );
+	xPushEncoded( rcPipeline, rcEncoder, iNumFramesDone, iNumEncoded );
+}
+
+void GvcEncoderApp::xPushEncoded( GvcPipeline& rcPipeline, GvcEncoder& rcEncoder, int iFirstFrame, int iNumEncoded )
+{
+	for ( int i = 0; i < iNumEncoded; i++ )
+	{
+		const GvcAccessUnit& rcAccessUnit = rcEncoder.getAccessUnit( i );
+		rcPipeline.aaucAccessUnit[(iFirstFrame + i) % rcPipeline.aaucAccessUnit.size()].assign( rcAccessUnit.getData(), rcAccessUnit.getData() + rcAccessUnit.getSize() );
+		rcPipeline.cEncodedQueue.push( iFirstFrame + i );
+	}
+}
+
+/// write stage: the access unit and the reconstruction of each frame; the quality of a frame is measured while the
+/// next one is written, its buffers are free after that
+void GvcEncoderApp::xWriteFrames( GvcPipeline& rcPipeline, GvcQualityAnalyser& rcQualityAnalyser, GvcSegment& rcSegment, std::ostream* pcBitstreamFile )
+{
+	const int iNumBuffers = (int)rcPipeline.apcFrameOrg.size();
+	const bool bReport = pcBitstreamFile != NULL;
+	GvcFrameQuality cQuality;
+	int iFrame;
+	int iMeasured = -1;
+	while ( rcPipeline.cEncodedQueue.pop( iFrame ) )
+	{
+		std::vector<unsigned char>& raucAccessUnit = rcPipeline.aaucAccessUnit[iFrame % iNumBuffers];
+		rcSegment.aucBitstream.insert( rcSegment.aucBitstream.end(), raucAccessUnit.begin(), raucAccessUnit.end() );
+		raucAccessUnit.clear();
+		if ( pcBitstreamFile && rcSegment.aucBitstream.size() >= OUTPUT_CHUNK_SIZE )
+		{
+			xFlushOutput( *pcBitstreamFile, rcSegment.aucBitstream );
+		}
+		GvcFrameUnit* pcFrameOrg = rcPipeline.apcFrameOrg[iFrame % iNumBuffers];
+		GvcFrameUnit* pcFrameRec = rcPipeline.apcFrameRec[iFrame % iNumBuffers];
+		if ( bReport && !m_reconFileName.empty() )
+		{
+			m_cTVideoIOYuvReconFile.write( pcFrameRec, IPCOLOURSPACE_UNCHANGED, 0, 0, 0, 0, NUM_CHROMA_FORMAT, false  );
+		}
+		if ( rcQualityAnalyser.collect( cQuality ) )
+		{
+			xReportFrame( rcQualityAnalyser, rcSegment, bReport, cQuality );
+			if ( iMeasured + iNumBuffers < rcSegment.iNumFrames )
+			{
+				rcPipeline.cFreeQueue.push( iMeasured + iNumBuffers );
+			}
+		}
+		rcQualityAnalyser.submit( pcFrameOrg, pcFrameRec, rcSegment.iFirstFrame + iFrame );
+		iMeasured = iFrame;
+	}
+	if ( rcQualityAnalyser.collect( cQuality ) )
+	{
+		xReportFrame( rcQualityAnalyser, rcSegment, bReport, cQuality );
+	}
+	if ( pcBitstreamFile )
+	{
+		xFlushOutput( *pcBitstreamFile, rcSegment.aucBitstream );
+	}
+}
+
+/** Splits the frames at every intra frame and codes SegmentThreads segments at once, each with an encoder of its
+ *  own; the encoders share the pool of the run. The segments are stitched into the bitstream file in order, as soon
+ *  as the ones before them are written.
+ */
+void GvcEncoderApp::xEncodeSegments( std::ostream& bitstreamFile, int iFirstFrame, int iNumFrames )
+{
+	std::vector<GvcSegment> acSegments;
+	for ( int iFrame = iFirstFrame; iFrame < iFirstFrame + iNumFrames; iFrame += m_iIntraPeriod )
+	{
+		acSegments.push_back( GvcSegment() );
+		acSegments.back().iFirstFrame = iFrame;
+		acSegments.back().iNumFrames = std::min( m_iIntraPeriod, iFirstFrame + iNumFrames - iFrame );
+	}
+	const int iNumSegments = (int)acSegments.size();
+	const int iNumCoders = std::min( m_iSegmentThreads, iNumSegments );
+	// the encoders are created here, before any of them runs, since create() sets up the shared kernel tables
+	std::vector<GvcEncoder*> apcEncoders( iNumCoders, &m_cGvcEnc );
+	for ( int i = 1; i < iNumCoders; i++ )
+	{
+		apcEncoders[i] = new GvcEncoder;
+		xInitLibCfg( *apcEncoders[i] );
+		apcEncoders[i]->create();
+	}
+
+	std::atomic<int> iNextSegment( 0 );
+	std::mutex cMutex;
+	std::condition_variable cDoneCond;
+	std::vector<bool> abDone( iNumSegments, false );
+	std::vector<std::thread> acThreads;
+	for ( int i = 0; i < iNumCoders; i++ )
+	{
+		acThreads.push_back( std::thread( [&, i]() {
+			TVideoIOYuv cInputFile;
+			GvcQualityAnalyser cQualityAnalyser;
+			cQualityAnalyser.create( m_bitDepth, m_bPrintSSIM, &m_cThreadPool );
+			for ( int iSegment = iNextSegment++; iSegment < iNumSegments; iSegment = iNextSegment++ )
+			{
+				GvcSegment& rcSegment = acSegments[iSegment];
+				xOpenInputFile( cInputFile, rcSegment.iFirstFrame );
+				apcEncoders[i]->startSegment( rcSegment.iFirstFrame );
+				xEncodeSegment( *apcEncoders[i], cInputFile, cQualityAnalyser, rcSegment, NULL );
+				cInputFile.close();
+				{
+					std::lock_guard<std::mutex> lock( cMutex );
+					abDone[iSegment] = true;
+				}
+				cDoneCond.notify_all();
+			}
+			cQualityAnalyser.destroy();
+		} ) );
+	}
+
+	for ( int iSegment = 0; iSegment < iNumSegments; iSegment++ )
+	{
+		{
+			std::unique_lock<std::mutex> lock( cMutex );
+			cDoneCond.wait( lock, [&] { return abDone[iSegment]; } );
+		}
+		GvcSegment& rcSegment = acSegments[iSegment];
+		for ( size_t i = 0; i < rcSegment.acQuality.size(); i++ )
+		{
+			m_cQualityAnalyser.printFrame( rcSegment.acQuality[i] );
+			m_cQualityAnalyser.addFrame( rcSegment.acQuality[i] );
+		}
+		if ( !m_cStitcher.addSegment( rcSegment.aucBitstream.data(), rcSegment.aucBitstream.size() ) )
+		{
+			fprintf( stderr, "\nsegment at frame %d cannot be stitched\n", rcSegment.iFirstFrame );
+			exit( EXIT_FAILURE );
+		}
+		xFlushStitched( bitstreamFile );
+		std::vector<unsigned char>().swap( rcSegment.aucBitstream );
+	}
+	for ( int i = 0; i < iNumCoders; i++ )
+	{
+		acThreads[i].join();
+	}
+	// the pool may still hold the queued copies of the forks that the BU encoders joined themselves
+	m_cThreadPool.waitAll();
+	for ( int i = 1; i < iNumCoders; i++ )
+	{
+		apcEncoders[i]->destroy();
+		delete apcEncoders[i];
+	}
+}
+
+/// joins the bitstreams of segments coded by separate runs, in the order given
+void GvcEncoderApp::xStitchFiles( std::ostream& bitstreamFile )
+{
+	for ( size_t i = 0; i < m_acStitchFileNames.size(); i++ )
+	{
+		std::ifstream cSegmentFile( m_acStitchFileNames[i].c_str(), std::ifstream::binary );
+		if ( !cSegmentFile )
+		{
+			fprintf( stderr, "\nfailed to open segment file `%s'\n", m_acStitchFileNames[i].c_str() );
+			exit( EXIT_FAILURE );
+		}
+		std::vector<unsigned char> aucSegment( ( std::istreambuf_iterator<char>( cSegmentFile ) ), std::istreambuf_iterator<char>() );
+		if ( !m_cStitcher.addSegment( aucSegment.data(), aucSegment.size() ) )
+		{
+			fprintf( stderr, "\nsegment file `%s' cannot be stitched: it must start with an intra frame and share the coding parameters of the first\n",
+					 m_acStitchFileNames[i].c_str() );
+			exit( EXIT_FAILURE );
+		}
+		xFlushStitched( bitstreamFile );
+	}
+}
+
+/// opens the input positioned on frame iFirstFrame
+void GvcEncoderApp::xOpenInputFile( TVideoIOYuv& rcInputFile, int iFirstFrame )
+{
+	int noBitDepthShift[2];
+	noBitDepthShift[0] = noBitDepthShift[1] = 8;
+	rcInputFile.open( m_inputFileName, false, m_bitDepth, noBitDepthShift, m_bitDepth );  // read  mode
+	rcInputFile.skipFrames( iFirstFrame, m_iSourceWidth - m_aiPad[0], m_iSourceHeight - m_aiPad[1], m_chromaFormat );
+}
+
+/// prints the quality of a frame, or keeps it until the segment is written
+void GvcEncoderApp::xReportFrame( GvcQualityAnalyser& rcQualityAnalyser, GvcSegment& rcSegment, bool bReport, const GvcFrameQuality& rcQuality )
+{
+	if ( bReport )
+	{
+		rcQualityAnalyser.printFrame( rcQuality );
+	}
+	else
+	{
+		rcSegment.acQuality.push_back( rcQuality );
+	}
+}
+
+void GvcEncoderApp::xFlushOutput( std::ostream& bitstreamFile, std::vector<unsigned char>& raucData )
+{
+	bitstreamFile.write( reinterpret_cast<const char*>( raucData.data() ), raucData.size() );
+	m_totalBytes += (unsigned int)raucData.size();
+	raucData.clear();
+}
+
+void GvcEncoderApp::xFlushStitched( std::ostream& bitstreamFile )
+{
+	bitstreamFile.write( reinterpret_cast<const char*>( m_cStitcher.getData() ), m_cStitcher.getSize() );
+	m_totalBytes += m_cStitcher.getSize();
+	m_cStitcher.clear();
+}
+
+void GvcEncoderApp::xInitLibCfg( GvcEncoder& rcEncoder )
+{
+	rcEncoder.setSourceWidth                                       ( m_iSourceWidth );
+	rcEncoder.setSourceHeight                                      ( m_iSourceHeight );
+	rcEncoder.setFramesToBeEncoded                                 ( m_framesToBeEncoded );
+	rcEncoder.setNumEncodedFrames                                  ( 0 );
+	rcEncoder.setQP                                                ( m_iQP );
+	rcEncoder.setPad                                               ( m_aiPad );
+	rcEncoder.setChromaFormat                                      ( m_chromaFormat  );
+	rcEncoder.setMaxBUWidth                                        ( m_uiMaxBUWidth );
+	rcEncoder.setMaxBUHeight                                       ( m_uiMaxBUHeight );
+	rcEncoder.setMaxTotalBUDepth                                   ( m_uiMaxBUDepth );
+	rcEncoder.setQuadtreeTULog2MaxSize                             ( m_uiQuadtreeTULog2MaxSize );
+	rcEncoder.setQuadtreeTULog2MinSize                             ( m_uiQuadtreeTULog2MinSize );
+	rcEncoder.setUseRDOQ                                           ( m_useRDOQ );
+	rcEncoder.setUseScalingListId                                  ( ScalingListMode( m_useScalingListId ) );
+	rcEncoder.setPreset                                            ( m_iPreset );
+	rcEncoder.setIntraRDCandidates                                 ( m_uiIntraRDCandidates );
+	rcEncoder.setFastSearch                                        ( m_iFastSearch );
+	rcEncoder.setSearchRange                                       ( m_iSearchRange );
+	rcEncoder.setHadamardME                                        ( m_bHadamardME );
+	rcEncoder.setLoopFilterDisable                                 ( m_bLoopFilterDisable );
+	rcEncoder.setLoopFilterBetaOffsetDiv2                          ( m_iLoopFilterBetaOffsetDiv2 );
+	rcEncoder.setLoopFilterTcOffsetDiv2                            ( m_iLoopFilterTcOffsetDiv2 );
+	rcEncoder.setUseSAO                                            ( m_bUseSAO );
+	rcEncoder.setWaveFrontSynchro                                  ( m_bWaveFrontSynchro );
+	rcEncoder.setNumThreads                                        ( m_iNumThreads );
+	rcEncoder.setThreadPool                                        ( &m_cThreadPool );
+	rcEncoder.setFrameThreads                                      ( m_iFrameThreads );
+	rcEncoder.setPinThreads                                        ( m_bPinThreads );
+	rcEncoder.setModeDecisionTasks                                 ( m_bModeDecisionTasks );
+	rcEncoder.setIntraPeriod                                       ( m_iIntraPeriod );
+	rcEncoder.setNumTileColumns                                    ( m_iNumTileColumns );
+	rcEncoder.setNumTileRows                                       ( m_iNumTileRows );
+	rcEncoder.setTileUniformSpacing                                ( m_bTileUniformSpacing );
+	rcEncoder.setTileColumnWidths                                  ( m_aiTileColumnWidth );
+	rcEncoder.setTileRowHeights                                    ( m_aiTileRowHeight );
+	rcEncoder.setSimdLevel                                         ( m_iSimdLevel );
 
 	// set internal bit-depth and constants
 	for (int channelType = 0; channelType < MAX_NUM_CHANNEL_TYPE; channelType++)
 	{
-		m_cGvcEnc.setBitDepth((ChannelType)channelType, m_bitDepth[channelType]);
+		rcEncoder.setBitDepth((ChannelType)channelType, m_bitDepth[channelType]);
 	}
 }
 
 void GvcEncoderApp::xCreateLib()
 {
-	// Video I/O
-	int noBitDepthShift[2];
-	noBitDepthShift[0] = noBitDepthShift[1] = 8;
-	m_cTVideoIOYuvInputFile.open( m_inputFileName,     false, m_bitDepth, noBitDepthShift, m_bitDepth );  // read  mode
-	//m_cTVideoIOYuvInputFile.skipFrames(m_FrameSkip, m_iSourceWidth - m_aiPad[0], m_iSourceHeight - m_aiPad[1], m_InputChromaFormatIDC);
+	// Video I/O, the input is opened by each segment
 	if (!m_reconFileName.empty())
 	{
 		m_cTVideoIOYuvReconFile.open(m_reconFileName, true, m_bitDepth, m_bitDepth, m_bitDepth);  // write mode
 	}
+	// one pool for the run: the read and write threads of each segment coded at once come out of the
+	// Threads budget, the encoders of the segments share the rest
+	const int iNumFrames = m_iSegmentFrames > 0 ? m_iSegmentFrames : m_framesToBeEncoded;
+	const int iNumCoders = m_iSegmentThreads > 1 ? std::min( m_iSegmentThreads, ( iNumFrames + m_iIntraPeriod - 1 ) / m_iIntraPeriod ) : 1;
+	int iNumThreads = m_iNumThreads > 0 ? m_iNumThreads : (int)std::thread::hardware_concurrency();
+	iNumThreads -= iNumCoders * ( m_iReadThreads + 1 );
+	iNumThreads = std::min( iNumThreads, iNumCoders * m_cGvcEnc.getMaxUsefulThreads() );
+	if ( iNumThreads > 1 )
+	{
+		m_cThreadPool.create( iNumThreads, m_bPinThreads );
+	}
 	// Neo Decoder
 	m_cGvcEnc.create();
+	m_cQualityAnalyser.create( m_bitDepth, m_bPrintSSIM, &m_cThreadPool );
 }
 
 void GvcEncoderApp::xDestroyLib()
@@ -130,8 +533,11 @@ void GvcEncoderApp::xDestroyLib()
 	// Video I/O
 	m_cTVideoIOYuvInputFile.close();
 	m_cTVideoIOYuvReconFile.close();
-	// Neo Decoder
-	//m_cGvcEnc.destroy(); TODO: Add to GvcEncoder
+	// Neo Decoder, once the jobs the pool still holds for it have run
+	m_cThreadPool.waitAll();
+	m_cGvcEnc.destroy();
+	m_cQualityAnalyser.destroy();
+	m_cThreadPool.destroy();
 }
 
 bool GvcEncoderApp::parseCfg( int argc, char* argv[] )
@@ -140,6 +546,10 @@ bool GvcEncoderApp::parseCfg( int argc, char* argv[] )
 	int warnUnknowParameter = 0;
 	int tmpChromaFormat = 0;
 	int tmpInternalBitDepth = 0;
+	std::string cTileColumnWidths;
+	std::string cTileRowHeights;
+	std::string cSegment;
+	std::string cStitchFiles;
 
 	po::Options opts;
 	opts.addOptions()
@@ -155,8 +565,39 @@ bool GvcEncoderApp::parseCfg( int argc, char* argv[] )
 			("MaxBUWidth",                                      m_uiMaxBUWidth,                                     64u)
 			("MaxBUHeight",                                     m_uiMaxBUHeight,                                    64u)
 			("MaxPartitionDepth,h",                             m_uiMaxBUDepth,                                      4u, "BU depth")
+			("QuadtreeTULog2MaxSize",                           m_uiQuadtreeTULog2MaxSize,                           5u, "Log2 of maximum transform size")
+			("QuadtreeTULog2MinSize",                           m_uiQuadtreeTULog2MinSize,                           2u, "Log2 of minimum transform size")
+			("RDOQ",                                            m_useRDOQ,                                         true, "Rate-distortion optimized quantization")
+			("ScalingList",                                     m_useScalingListId,                                   0, "Scaling list (0: off, 1: default)")
+			("Preset",                                          m_iPreset,                                            1, "Speed preset (0: slow, 1: medium, 2: fast)")
+			("IntraRDCandidates",                               m_uiIntraRDCandidates,                               0u, "Intra modes coded with full RD after the SATD pass (0: preset default, 35: all)")
+			("FastSearch",                                      m_iFastSearch,                                        1, "Motion search method (0: full search, 1: TZ search, 2: pyramid search)")
+			("SearchRange",                                     m_iSearchRange,                                      64, "Motion search range in integer samples (0: whole frame)")
+			("HadamardME",                                      m_bHadamardME,                                     true, "Hadamard distortion in the fractional motion refinement")
+			("LoopFilterDisable",                               m_bLoopFilterDisable,                             false, "Disable the deblocking filter")
+			("LoopFilterBetaOffset_div2",                       m_iLoopFilterBetaOffsetDiv2,                          0, "Deblocking beta offset / 2 (-6 to 6)")
+			("LoopFilterTcOffset_div2",                         m_iLoopFilterTcOffsetDiv2,                            0, "Deblocking tc offset / 2 (-6 to 6)")
+			("SAO",                                             m_bUseSAO,                                         true, "Enable the sample adaptive offset")
+			("WaveFrontSynchro",                                m_bWaveFrontSynchro,                              false, "One substream per BU row, each row two BUs behind the row above")
+			("Threads",                                         m_iNumThreads,                                        0, "Threads of the run: the pool coding BU rows or tiles and preparing the source, and the read and write threads of each segment coded at once (0: one per hardware thread)")
+			("FrameThreads",                                    m_iFrameThreads,                                      1, "Frames coded at once, each waiting only for the reference rows it reads")
+			("PinThreads",                                      m_bPinThreads,                                    false, "Pin each thread of the pool to a core of its own")
+			("ModeDecisionTasks",                               m_bModeDecisionTasks,                             false, "Search the 2Nx2N candidates of a CU as a job of the pool while its split is searched")
+			("ReadThreads",                                     m_iReadThreads,                                       1, "Threads reading the source")
+			("PipelineFrames",                                  m_iPipelineFrames,                                    2, "Frames read and prepared ahead of the encoder")
+			("NumTileColumns",                                  m_iNumTileColumns,                                    1, "Number of tile columns")
+			("NumTileRows",                                     m_iNumTileRows,                                       1, "Number of tile rows")
+			("TileUniformSpacing",                              m_bTileUniformSpacing,                             true, "Tiles spread evenly over the frame")
+			("TileColumnWidthArray",                            cTileColumnWidths,                          string( "" ), "Widths of the tile columns but the last, in BUs, without uniform spacing")
+			("TileRowHeightArray",                              cTileRowHeights,                            string( "" ), "Heights of the tile rows but the last, in BUs, without uniform spacing")
 			("ChromaFormat",                               tmpChromaFormat,                               420, "ChromaFormat")
 			("FramesToBeEncoded,f",                             m_framesToBeEncoded,                                  0, "Number of frames to be encoded (default=all)")
+			("IntraPeriod",                                     m_iIntraPeriod,                                      -1, "Period of the intra frames (-1: only the first)")
+			("Segment",                                         cSegment,                                   string( "" ), "Frames start:count of the input coded into a stream of their own, start at an intra frame")
+			("SegmentThreads",                                  m_iSegmentThreads,                                    1, "Segments of one intra period coded at once, each by an encoder of its own")
+			("StitchSegments",                                  cStitchFiles,                               string( "" ), "Bitstreams of segments joined into BitstreamFile, in order, instead of encoding")
+			("SSIM",                                            m_bPrintSSIM,                                     false, "Compute and print the SSIM of each frame")
+			("SIMD",                                            m_iSimdLevel,                                        -1, "Kernel instruction set (-1: auto, 0: C, 1: SSE4.1, 2: AVX2, 3: AVX-512)")
 			("BitDepth",                                tmpInternalBitDepth,                8, "Bit-depth the codec operates at. (default:MSBExtendedBitDepth). If different to MSBExtendedBitDepth, source data will be converted");
 
 	po::setDefaults( opts );
@@ -185,10 +626,31 @@ bool GvcEncoderApp::parseCfg( int argc, char* argv[] )
 	}
 
 	m_chromaFormat = numberToChromaFormat(tmpChromaFormat);
+	m_aiTileColumnWidth = parseIntList( cTileColumnWidths );
+	m_aiTileRowHeight = parseIntList( cTileRowHeights );
+	m_iSegmentStart = 0;
+	m_iSegmentFrames = 0;
+	if( !cSegment.empty() && sscanf( cSegment.c_str(), "%d:%d", &m_iSegmentStart, &m_iSegmentFrames ) != 2 )
+	{
+		fprintf( stderr, "Segment must be given as start:count\n" );
+		return false;
+	}
+	std::replace( cStitchFiles.begin(), cStitchFiles.end(), ',', ' ' );
+	std::istringstream cStitchStream( cStitchFiles );
+	for( std::string cFileName; cStitchStream >> cFileName; )
+	{
+		m_acStitchFileNames.push_back( cFileName );
+	}
 	m_bitDepth[CHANNEL_TYPE_LUMA] = 8;
 	m_bitDepth[CHANNEL_TYPE_CHROMA] = 8;
 	m_aiPad[1] = m_aiPad[0] = 0;
 
+	// stitching only needs the file names
+	if( !m_acStitchFileNames.empty() )
+	{
+		return !confirmPara( m_bitstreamFileName.empty(), "A bitstream file name must be specified (BitstreamFile)" );
+	}
+
 	// check validity of input parameters
 	xCheckParameter();
 
@@ -209,7 +671,61 @@ void GvcEncoderApp::xCheckParameter()
 	xConfirmPara( ( m_iSourceHeight % 4 ) != 0, "Resulting coded frame height must be a multiple of the minimum BU size (4)" );
 	xConfirmPara( (m_uiMaxBUWidth & (m_uiMaxBUWidth - 1)) != 0, "Max BU size must be a power of 2" );
 	xConfirmPara( (m_uiMaxBUHeight & (m_uiMaxBUHeight - 1)) != 0, "Max BU size must be a power of 2" );
+	xConfirmPara( m_uiMaxBUWidth != m_uiMaxBUHeight, "Max BU width and height must be equal" );
+	xConfirmPara( m_uiMaxBUWidth > MAX_BU_SIZE, "Max BU size must not exceed 64" );
+	xConfirmPara( m_uiMaxBUDepth < 1 || m_uiMaxBUDepth > MAX_BU_DEPTH, "Max partition depth must be between 1 and 4" );
+	xConfirmPara( m_uiMaxBUDepth >= 1 && ( m_uiMaxBUWidth >> ( m_uiMaxBUDepth - 1 ) ) < MIN_BU_SIZE, "Minimum BU size (MaxBUWidth >> (MaxPartitionDepth - 1)) must be at least 8" );
+	xConfirmPara( m_uiQuadtreeTULog2MinSize < MIN_LOG2_TU_SIZE, "QuadtreeTULog2MinSize must be 2 or greater" );
+	xConfirmPara( m_uiQuadtreeTULog2MaxSize > MAX_LOG2_TU_SIZE, "QuadtreeTULog2MaxSize must be 5 or smaller" );
+	xConfirmPara( m_uiQuadtreeTULog2MaxSize < m_uiQuadtreeTULog2MinSize, "QuadtreeTULog2MaxSize must be greater than or equal to QuadtreeTULog2MinSize" );
+	xConfirmPara( ( 1u << m_uiQuadtreeTULog2MaxSize ) > m_uiMaxBUWidth, "QuadtreeTULog2MaxSize must not exceed log2 of the max BU size" );
+	xConfirmPara( m_uiMaxBUDepth >= 1 && ( 1u << m_uiQuadtreeTULog2MinSize ) >= ( m_uiMaxBUWidth >> ( m_uiMaxBUDepth - 1 ) ), "QuadtreeTULog2MinSize must be smaller than log2 of the min BU size" );
+	xConfirmPara( m_useScalingListId < SCALING_LIST_OFF || m_useScalingListId > SCALING_LIST_DEFAULT, "ScalingList must be 0 (off) or 1 (default), scaling list files are not supported" );
+	xConfirmPara( m_iPreset < 0 || m_iPreset > 2, "Preset must be 0 (slow), 1 (medium) or 2 (fast)" );
+	xConfirmPara( m_uiIntraRDCandidates > NUM_LUMA_MODE, "IntraRDCandidates must not exceed the number of luma modes (35)" );
+	xConfirmPara( m_iFastSearch < 0 || m_iFastSearch > 2, "FastSearch must be 0 (full search), 1 (TZ search) or 2 (pyramid search)" );
+	xConfirmPara( m_iSearchRange < 0, "SearchRange must not be negative" );
+	xConfirmPara( m_iLoopFilterBetaOffsetDiv2 < -6 || m_iLoopFilterBetaOffsetDiv2 > 6, "LoopFilterBetaOffset_div2 exceeds supported range (-6 to 6)" );
+	xConfirmPara( m_iLoopFilterTcOffsetDiv2 < -6 || m_iLoopFilterTcOffsetDiv2 > 6, "LoopFilterTcOffset_div2 exceeds supported range (-6 to 6)" );
+	xConfirmPara( ( m_iSourceWidth % MIN_BU_SIZE ) != 0, "Frame width must be a multiple of the minimum BU size (8)" );
+	xConfirmPara( ( m_iSourceHeight % MIN_BU_SIZE ) != 0, "Frame height must be a multiple of the minimum BU size (8)" );
 	xConfirmPara( m_chromaFormat == NUM_CHROMA_FORMAT, "Chroma format must be 400, 420, 422 or 444" );
+	const int iWidthInBUs = ( m_iSourceWidth + m_uiMaxBUWidth - 1 ) / m_uiMaxBUWidth;
+	const int iHeightInBUs = ( m_iSourceHeight + m_uiMaxBUHeight - 1 ) / m_uiMaxBUHeight;
+	xConfirmPara( m_iNumThreads < 0, "Threads must not be negative" );
+	xConfirmPara( m_iFrameThreads < 1, "FrameThreads must be at least 1" );
+	xConfirmPara( m_iReadThreads < 1, "ReadThreads must be at least 1" );
+	xConfirmPara( m_iPipelineFrames < 0, "PipelineFrames must be 0 or more" );
+	xConfirmPara( m_iIntraPeriod < -1 || m_iIntraPeriod == 0, "IntraPeriod must be -1 or positive" );
+	xConfirmPara( !m_acStitchFileNames.empty() && m_iSegmentFrames > 0, "StitchSegments joins segments, it cannot be used with Segment" );
+	xConfirmPara( m_iSegmentStart < 0 || m_iSegmentFrames < 0, "Segment start and count must not be negative" );
+	xConfirmPara( m_iSegmentStart > 0 && ( m_iIntraPeriod < 0 || m_iSegmentStart % m_iIntraPeriod != 0 ), "Segment must start at an intra frame, a multiple of IntraPeriod" );
+	xConfirmPara( m_iSegmentThreads < 1, "SegmentThreads must be at least 1" );
+	xConfirmPara( m_iSegmentThreads > 1 && m_iIntraPeriod < 0, "SegmentThreads needs an IntraPeriod to split the frames at" );
+	xConfirmPara( m_iSegmentThreads > 1 && !m_reconFileName.empty(), "ReconFile cannot be written with SegmentThreads, use Segment in separate runs" );
+	xConfirmPara( m_iNumTileColumns < 1 || m_iNumTileColumns > iWidthInBUs, "NumTileColumns must be between 1 and the frame width in BUs" );
+	xConfirmPara( m_iNumTileRows < 1 || m_iNumTileRows > iHeightInBUs, "NumTileRows must be between 1 and the frame height in BUs" );
+	xConfirmPara( m_bWaveFrontSynchro && m_iNumTileColumns * m_iNumTileRows > 1, "WaveFrontSynchro and tiles cannot be used together" );
+	if( !m_bTileUniformSpacing )
+	{
+		int iSum = 0;
+		for( size_t i = 0; i < m_aiTileColumnWidth.size(); i++ )
+		{
+			xConfirmPara( m_aiTileColumnWidth[i] < 1, "TileColumnWidthArray values must be positive" );
+			iSum += m_aiTileColumnWidth[i];
+		}
+		xConfirmPara( (int)m_aiTileColumnWidth.size() != m_iNumTileColumns - 1, "TileColumnWidthArray must hold NumTileColumns - 1 values" );
+		xConfirmPara( iSum >= iWidthInBUs, "TileColumnWidthArray leaves no BU column to the last tile column" );
+		iSum = 0;
+		for( size_t i = 0; i < m_aiTileRowHeight.size(); i++ )
+		{
+			xConfirmPara( m_aiTileRowHeight[i] < 1, "TileRowHeightArray values must be positive" );
+			iSum += m_aiTileRowHeight[i];
+		}
+		xConfirmPara( (int)m_aiTileRowHeight.size() != m_iNumTileRows - 1, "TileRowHeightArray must hold NumTileRows - 1 values" );
+		xConfirmPara( iSum >= iHeightInBUs, "TileRowHeightArray leaves no BU row to the last tile row" );
+	}
+	xConfirmPara( m_iSimdLevel < -1 || m_iSimdLevel >= NUM_GVC_CPU_LEVELS, "SIMD level must be between -1 and 3" );
 	xConfirmPara( m_framesToBeEncoded < 0, "Frame number must larger or equal to zero" );
 	xConfirmPara( m_bitDepth[CHANNEL_TYPE_LUMA] <= 0 && m_bitDepth[CHANNEL_TYPE_LUMA] > 16, "bit depth must be between 1 and 16" );
 
@@ -232,6 +748,33 @@ void GvcEncoderApp::xPrintParameter()
 	printf( "Max BU Width                           : %d\n", m_uiMaxBUWidth );
 	printf( "Max BU Height                          : %d\n", m_uiMaxBUHeight );
 	printf( "Max Partition Depth                    : %d\n", m_uiMaxBUDepth );
+	printf( "Transform Size                         : %d..%d\n", 1 << m_uiQuadtreeTULog2MinSize, 1 << m_uiQuadtreeTULog2MaxSize );
+	printf( "RDOQ                                   : %d\n", m_useRDOQ );
+	printf( "Scaling List                           : %d\n", m_useScalingListId );
+	printf( "Preset                                 : %d\n", m_iPreset );
+	printf( "Intra RD Candidates                    : %u%s\n", m_uiIntraRDCandidates, m_uiIntraRDCandidates ? "" : " (preset)" );
+	printf( "Motion Search                          : %s, range %d%s\n", m_iFastSearch == 2 ? "pyramid" : m_iFastSearch ? "TZ" : "full", m_iSearchRange, m_iSearchRange ? "" : " (whole frame)" );
+	printf( "Hadamard ME                            : %s\n", m_bHadamardME ? "Enabled" : "Disabled" );
+	printf( "Deblocking Filter                      : %s", m_bLoopFilterDisable ? "Disabled\n" : "Enabled" );
+	if( !m_bLoopFilterDisable )
+	{
+		printf( ", beta offset %d, tc offset %d\n", 2 * m_iLoopFilterBetaOffsetDiv2, 2 * m_iLoopFilterTcOffsetDiv2 );
+	}
+	printf( "SAO                                    : %s\n", m_bUseSAO ? "Enabled" : "Disabled" );
+	printf( "WaveFront Synchro                      : %s\n", m_bWaveFrontSynchro ? "Enabled" : "Disabled" );
+	printf( "Tiles                                  : %dx%d%s\n", m_iNumTileColumns, m_iNumTileRows, m_bTileUniformSpacing ? " (uniform)" : "" );
+	printf( "Threads                                : %d%s\n", m_iNumThreads, m_iNumThreads ? "" : " (auto)" );
+	printf( "Frame threads                          : %d\n", m_iFrameThreads );
+	printf( "Pin threads                            : %d\n", m_bPinThreads );
+	printf( "Mode decision tasks                    : %d\n", m_bModeDecisionTasks );
+	printf( "Read threads                           : %d\n", m_iReadThreads );
+	printf( "Pipeline frames                        : %d\n", m_iPipelineFrames );
+	printf( "Intra period                           : %d\n", m_iIntraPeriod );
+	if( m_iSegmentFrames > 0 )
+	{
+		printf( "Segment                                : frames %d to %d\n", m_iSegmentStart, m_iSegmentStart + m_iSegmentFrames - 1 );
+	}
+	printf( "Segment threads                        : %d\n", m_iSegmentThreads );
 	printf( "Chroma Format                          : %d\n", m_chromaFormat );
 	printf( "Bit Depth                              : %d\n", m_bitDepth[CHANNEL_TYPE_LUMA] );
 	printf( "\n\n" );
@@ -25,15 +25,44 @@
 #ifndef __GVCENCODERAPP_H__
 #define __GVCENCODERAPP_H__
 
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "TypeDef.h"
 #include "GvcEncoder.h"
+#include "GvcFrameQueue.h"
+#include "GvcNal.h"
+#include "GvcQuality.h"
 #include "TVideoIOYuv.h"
 
+/// frames coded by one encoder into a stream of their own, from an intra frame on
+struct GvcSegment
+{
+	int iFirstFrame;
+	int iNumFrames;
+	std::vector<unsigned char> aucBitstream;  ///< access units not yet written to the bitstream file
+	std::vector<GvcFrameQuality> acQuality;   ///< of the frames, when they are reported with the segment
+};
+
+/// buffers and queues of the stages coding a segment, the buffers of frame i are those numbered i modulo their count
+struct GvcPipeline
+{
+	GvcPipeline() : iNumPreparing( 0 ) {}
+	std::vector<GvcFrameUnit*> apcFrameOrg;
+	std::vector<GvcFrameUnit*> apcFrameRec;
+	std::vector<std::vector<unsigned char> > aaucAccessUnit;  ///< of the frames encoded, until they are written
+	GvcFrameQueue cFreeQueue;      ///< frames whose buffers are free, to the read stage
+	GvcFrameQueue cPreparedQueue;  ///< to the encoder
+	GvcFrameQueue cEncodedQueue;   ///< to the write stage
+	std::mutex cPrepareMutex;
+	std::condition_variable cPrepareCond;  ///< the last preparation queued on the pool finished
+	int iNumPreparing;                      ///< preparations queued on the pool and not finished, the buffers outlive them
+};
+
 /// encoder application class
 class GvcEncoderApp
 {
@@ -42,7 +71,9 @@ class GvcEncoderApp
 	GvcEncoder m_cGvcEnc;  ///< encoder class
 	TVideoIOYuv                 m_cTVideoIOYuvInputFile;       ///< input YUV file
 	TVideoIOYuv                 m_cTVideoIOYuvReconFile;       ///< output reconstruction file
-	int m_iFrameRcvd;  ///< number of received frames
+	GvcQualityAnalyser          m_cQualityAnalyser;            ///< PSNR/SSIM measured alongside encoding
+	GvcBitstreamStitcher        m_cStitcher;                   ///< joins the segments into the bitstream file
+	GvcThreadPool               m_cThreadPool;                 ///< shared by the encoders of the segments and the quality measures
 	unsigned int m_totalBytes;
 
   protected:
@@ -63,6 +94,45 @@ class GvcEncoderApp
 	unsigned int      m_uiMaxBUWidth;                                   ///< max. BU width in pixel
 	unsigned int      m_uiMaxBUHeight;                                  ///< max. BU height in pixel
 	unsigned int      m_uiMaxBUDepth;                                   ///< max. BU depth (as specified by command line)
+	// transform unit (TU) definition
+	unsigned int      m_uiQuadtreeTULog2MaxSize;                        ///< log2 of the largest transform size
+	unsigned int      m_uiQuadtreeTULog2MinSize;                        ///< log2 of the smallest transform size
+	// quantization
+	bool      m_useRDOQ;                                        ///< flag for using RD optimized quantization
+	int       m_useScalingListId;                               ///< scaling list mode (0: off, 1: default, 2: file)
+	// mode decision
+	int       m_iPreset;                                        ///< speed preset (0: slow, 1: medium, 2: fast)
+	unsigned int m_uiIntraRDCandidates;                         ///< intra modes kept for full RD (0: preset default)
+	int       m_iFastSearch;                                    ///< motion search method (0: full search, 1: TZ search, 2: pyramid search)
+	int       m_iSearchRange;                                   ///< motion search range in integer samples (0: whole frame)
+	bool      m_bHadamardME;                                    ///< Hadamard distortion in the fractional motion refinement
+	// deblocking filter
+	bool      m_bLoopFilterDisable;                             ///< flag for disabling the deblocking filter
+	int       m_iLoopFilterBetaOffsetDiv2;                      ///< beta offset / 2 of the deblocking filter
+	int       m_iLoopFilterTcOffsetDiv2;                        ///< tc offset / 2 of the deblocking filter
+	bool      m_bUseSAO;                                        ///< flag for enabling the sample adaptive offset
+	// parallelism
+	bool      m_bWaveFrontSynchro;                              ///< one substream per BU row, rows coded in parallel
+	int       m_iNumThreads;                                    ///< threads coding BU rows or tiles (0: one per hardware thread)
+	int       m_iFrameThreads;                                  ///< frames coded at once
+	bool      m_bPinThreads;                                    ///< each thread of the pool on a core of its own
+	bool      m_bModeDecisionTasks;                             ///< the 2Nx2N candidates of a CU searched as a job of the pool
+	int       m_iReadThreads;                                   ///< threads of the read stage of the pipeline
+	int       m_iPipelineFrames;                                ///< frames read and prepared ahead of the encoder
+	int       m_iIntraPeriod;                                   ///< period of the intra frames (-1: only the first)
+	int       m_iSegmentStart;                                  ///< first frame of the input coded by this run
+	int       m_iSegmentFrames;                                 ///< frames coded by this run (0: FramesToBeEncoded from the start)
+	int       m_iSegmentThreads;                                ///< segments of one intra period coded at once
+	std::vector<std::string> m_acStitchFileNames;               ///< segment bitstreams to join instead of encoding
+	int       m_iNumTileColumns;                                ///< tile grid
+	int       m_iNumTileRows;
+	bool      m_bTileUniformSpacing;                            ///< tiles spread evenly, otherwise the sizes below
+	std::vector<int> m_aiTileColumnWidth;                       ///< widths of the tile columns but the last, in BUs
+	std::vector<int> m_aiTileRowHeight;                         ///< heights of the tile rows but the last, in BUs
+	// quality reporting
+	bool      m_bPrintSSIM;                                     ///< compute SSIM next to PSNR
+	// performance
+	int       m_iSimdLevel;                                     ///< instruction set of the kernels (-1: auto)
 	// internal member functions
 	void xCheckParameter();  ///< check validity of configuration values
 	void xPrintParameter();  ///< print configuration values
@@ -71,7 +141,7 @@ class GvcEncoderApp
 	ChromaFormat numberToChromaFormat(int val);
 	// initialization
 	void  xCreateLib        ();                               ///< create files & encoder class
-	void  xInitLibCfg       ();                               ///< initialize internal variables
+	void  xInitLibCfg       (GvcEncoder& rcEncoder);          ///< initialize internal variables
 	void  xInitLib          ();					              ///< initialize encoder class
 	void  xDestroyLib       ();                               ///< destroy encoder class
 	/// obtain required buffers
@@ -79,7 +149,21 @@ class GvcEncoderApp
 	/// delete allocated buffers
 	void  xDeleteBuffer     ();
 	// file I/O
-	void xWriteOutput(std::ostream& bitstreamFile, int iNumEncoded); ///< write bitstream to file
+	void xOpenInputFile(TVideoIOYuv& rcInputFile, int iFirstFrame);
+	void xFlushOutput(std::ostream& bitstreamFile, std::vector<unsigned char>& raucData);  ///< write the buffered access units
+	void xFlushStitched(std::ostream& bitstreamFile);                ///< write the segments stitched so far
+	void xReportFrame(GvcQualityAnalyser& rcQualityAnalyser, GvcSegment& rcSegment, bool bReport, const GvcFrameQuality& rcQuality);
+	// pipeline stages
+	void xReadFrames(GvcPipeline& rcPipeline, GvcEncoder& rcEncoder, TVideoIOYuv* pcInputFile, int iFirstFrame);
+	void xPrepareFrame(GvcPipeline& rcPipeline, GvcEncoder& rcEncoder, int iFirstFrame, int iFrame);
+	void xEncodeFrames(GvcPipeline& rcPipeline, GvcEncoder& rcEncoder);
+	void xPushEncoded(GvcPipeline& rcPipeline, GvcEncoder& rcEncoder, int iFirstFrame, int iNumEncoded);
+	void xWriteFrames(GvcPipeline& rcPipeline, GvcQualityAnalyser& rcQualityAnalyser, GvcSegment& rcSegment, std::ostream* pcBitstreamFile);
+	// segments
+	void xEncodeSegment(GvcEncoder& rcEncoder, TVideoIOYuv& rcInputFile, GvcQualityAnalyser& rcQualityAnalyser, GvcSegment& rcSegment,
+						std::ostream* pcBitstreamFile);
+	void xEncodeSegments(std::ostream& bitstreamFile, int iFirstFrame, int iNumFrames);  ///< segments coded in parallel
+	void xStitchFiles(std::ostream& bitstreamFile);                 ///< join segments coded by separate runs
 	void printRateSummary();
   public:
 	GvcEncoderApp();
@@ -0,0 +1,305 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBUDecoder.cpp
+ * \brief    Parsing and reconstruction of a block unit
+ */
+
+#include "GvcBUDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "GvcBlockUnit.h"
+#include "GvcDecoder.h"
+#include "GvcFrameUnit.h"
+#include "GvcRom.h"
+#include "TComChromaFormat.h"
+
+GvcBUDecoder::GvcBUDecoder()
+    : m_iSourceWidth( 0 )
+    , m_iSourceHeight( 0 )
+    , m_iHeightInBUs( 0 )
+    , m_maxBUWidth( 0 )
+    , m_maxBUHeight( 0 )
+    , m_maxTotalBUDepth( 0 )
+    , m_uiQuadtreeTULog2MaxSize( 0 )
+    , m_chromaFormat( CHROMA_420 )
+    , m_pcFrameRec( NULL )
+    , m_pcFrameRef( NULL )
+    , m_iNumRefRowsReady( 0 )
+    , m_uiNumRefWaits( 0 )
+{
+}
+
+GvcBUDecoder::~GvcBUDecoder()
+{
+	destroy();
+}
+
+void GvcBUDecoder::create( GvcDecoder* pcDecoder )
+{
+	m_iSourceWidth = pcDecoder->getSourceWidth();
+	m_iSourceHeight = pcDecoder->getSourceHeight();
+	m_maxBUWidth = pcDecoder->getMaxBUWidth();
+	m_maxBUHeight = pcDecoder->getMaxBUHeight();
+	m_iHeightInBUs = ( m_iSourceHeight + m_maxBUHeight - 1 ) / m_maxBUHeight;
+	m_maxTotalBUDepth = pcDecoder->getMaxTotalBUDepth();
+	m_uiQuadtreeTULog2MaxSize = pcDecoder->getQuadtreeTULog2MaxSize();
+	m_chromaFormat = pcDecoder->getChromaFormat();
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		m_bitDepth[ch] = pcDecoder->getBitDepth( ChannelType( ch ) );
+	}
+	m_cTrQuant.create();
+	m_cTrQuant.init( false, pcDecoder->getUseScalingListId() );
+	m_cPredYuv.create( m_maxBUWidth, m_maxBUHeight, m_chromaFormat );
+	m_cResiYuv.create( m_maxBUWidth, m_maxBUHeight, m_chromaFormat );
+}
+
+void GvcBUDecoder::destroy()
+{
+	m_cTrQuant.destroy();
+	m_cPredYuv.destroy();
+	m_cResiYuv.destroy();
+}
+
+void GvcBUDecoder::initFrame( GvcFrameUnit* pcFrameRec, GvcFrameUnit* pcFrameRef, int iQP )
+{
+	m_pcFrameRec = pcFrameRec;
+	m_pcFrameRef = pcFrameRef;
+	m_iNumRefRowsReady = 0;
+	m_cTrQuant.setQP( iQP, m_chromaFormat );
+}
+
+void GvcBUDecoder::decodeBU( GvcSbacDecoder* pcSbac, unsigned int uiBUAddr )
+{
+	GvcBlockUnit* pcBU = m_pcFrameRec->getBU( uiBUAddr );
+	pcBU->initBU( m_pcFrameRec, uiBUAddr );
+	xDecodeBU( pcSbac, pcBU, 0, 0 );
+}
+
+void GvcBUDecoder::skipBU( unsigned int uiBUAddr )
+{
+	GvcBlockUnit* pcBU = m_pcFrameRec->getBU( uiBUAddr );
+	pcBU->initBU( m_pcFrameRec, uiBUAddr );
+	pcBU->setPartSizeSubParts( SIZE_2Nx2N, 0, 0 );
+	pcBU->setPredModeSubParts( MODE_INTRA, 0, 0 );
+}
+
+/** Coding tree of a BU, as written by GvcBUEncoder::xEncodeBU: the split is inferred at the frame boundary and
+ *  below the minimum size.
+ */
+void GvcBUDecoder::xDecodeBU( GvcSbacDecoder* pcSbac, GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth )
+{
+	const unsigned int uiLPelX = pcBU->getCUPelX() + g_auiZscanToPelX[uiAbsPartIdx];
+	const unsigned int uiTPelY = pcBU->getCUPelY() + g_auiZscanToPelY[uiAbsPartIdx];
+	const bool bBoundary = ( uiLPelX + ( m_maxBUWidth >> uiDepth ) > (unsigned int)m_iSourceWidth ) || ( uiTPelY + ( m_maxBUHeight >> uiDepth ) > (unsigned int)m_iSourceHeight );
+	const bool bCanSplit = xIsSplitAllowed( uiDepth );
+
+	pcBU->setDepthSubParts( uiDepth, uiAbsPartIdx );
+	if( bCanSplit && !bBoundary )
+	{
+		pcSbac->parseSplitFlag( pcBU, uiAbsPartIdx, uiDepth );
+	}
+	if( bCanSplit && ( bBoundary || pcBU->getDepth( uiAbsPartIdx ) > uiDepth ) )
+	{
+		const unsigned int uiQNumParts = pcBU->getTotalNumPart() >> ( ( uiDepth + 1 ) << 1 );
+		for( unsigned int uiPartUnitIdx = 0; uiPartUnitIdx < 4; uiPartUnitIdx++ )
+		{
+			const unsigned int uiSubPartIdx = uiAbsPartIdx + uiPartUnitIdx * uiQNumParts;
+			if( pcBU->getCUPelX() + g_auiZscanToPelX[uiSubPartIdx] < (unsigned int)m_iSourceWidth &&
+			    pcBU->getCUPelY() + g_auiZscanToPelY[uiSubPartIdx] < (unsigned int)m_iSourceHeight )
+			{
+				xDecodeBU( pcSbac, pcBU, uiSubPartIdx, uiDepth + 1 );
+			}
+		}
+		return;
+	}
+	xDecodeCUData( pcSbac, pcBU, uiAbsPartIdx, uiDepth );
+}
+
+/** Prediction data of a coding unit, then its levels. An inter unit is motion compensated as a whole before its
+ *  residual is added, an intra unit is predicted transform unit by transform unit.
+ */
+void GvcBUDecoder::xDecodeCUData( GvcSbacDecoder* pcSbac, GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth )
+{
+	pcBU->setPartSizeSubParts( SIZE_2Nx2N, uiAbsPartIdx, uiDepth );
+	if( m_pcFrameRef )
+	{
+		pcSbac->parsePredMode( pcBU, uiAbsPartIdx, uiDepth );
+	}
+	else
+	{
+		pcBU->setPredModeSubParts( MODE_INTRA, uiAbsPartIdx, uiDepth );
+	}
+	if( pcBU->getPredictionMode( uiAbsPartIdx ) == MODE_INTRA )
+	{
+		pcSbac->parseIntraDirLumaAng( pcBU, uiAbsPartIdx, uiDepth );
+		if( isChromaEnabled( m_chromaFormat ) )
+		{
+			pcSbac->parseIntraDirChroma( pcBU, uiAbsPartIdx, uiDepth );
+		}
+	}
+	else
+	{
+		const int iPelX = pcBU->getCUPelX() + g_auiZscanToPelX[uiAbsPartIdx];
+		const int iPelY = pcBU->getCUPelY() + g_auiZscanToPelY[uiAbsPartIdx];
+		const int iWidth = m_maxBUWidth >> uiDepth;
+		const int iHeight = m_maxBUHeight >> uiDepth;
+		GvcMv cMv;
+		pcSbac->parseMvd( cMv );
+		cMv += xGetMvPredictor( pcBU, uiAbsPartIdx );
+		xClipMv( cMv, iPelX, iPelY, iWidth, iHeight );
+		pcBU->setMvSubParts( cMv, uiAbsPartIdx, uiDepth );
+		xWaitForReference( iPelY + iHeight - 1 + ( cMv.getVer() >> 2 ) + NTAPS_LUMA / 2 );
+		for( unsigned int comp = 0; comp < getNumberValidComponents( m_chromaFormat ); comp++ )
+		{
+			const ComponentID compID = ComponentID( comp );
+			m_cPrediction.predInterBlk( compID, m_chromaFormat, m_pcFrameRef, iPelX, iPelY, cMv, iWidth >> getComponentScaleX( compID, m_chromaFormat ),
+			                            iHeight >> getComponentScaleY( compID, m_chromaFormat ), m_cPredYuv.getAddr( compID ), m_cPredYuv.getStride( compID ),
+			                            m_bitDepth[toChannelType( compID )] );
+		}
+	}
+	for( unsigned int comp = 0; comp < getNumberValidComponents( m_chromaFormat ); comp++ )
+	{
+		xDecodeCoeff( pcSbac, pcBU, ComponentID( comp ), uiAbsPartIdx, uiDepth );
+	}
+}
+
+/// vector of the inter partition at the left, else above, zero when there is none
+GvcMv GvcBUDecoder::xGetMvPredictor( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx )
+{
+	unsigned int uiNeighbourIdx = 0;
+	GvcBlockUnit* pcBULeft = pcBU->getPULeft( uiNeighbourIdx, uiAbsPartIdx );
+	if( pcBULeft && pcBULeft->getPredictionMode( uiNeighbourIdx ) == MODE_INTER )
+	{
+		return pcBULeft->getMv( uiNeighbourIdx );
+	}
+	GvcBlockUnit* pcBUAbove = pcBU->getPUAbove( uiNeighbourIdx, uiAbsPartIdx );
+	if( pcBUAbove && pcBUAbove->getPredictionMode( uiNeighbourIdx ) == MODE_INTER )
+	{
+		return pcBUAbove->getMv( uiNeighbourIdx );
+	}
+	return GvcMv();
+}
+
+/** Keeps the interpolation of the block, filter taps included, inside the padded reference. The encoder never
+ *  searches that far, the clip only guards against a corrupt stream.
+ */
+void GvcBUDecoder::xClipMv( GvcMv& rcMv, int iPelX, int iPelY, int iWidth, int iHeight ) const
+{
+	const int iMarginX = m_pcFrameRef->getMarginX( COMPONENT_Y ) - NTAPS_LUMA;
+	const int iMarginY = m_pcFrameRef->getMarginY( COMPONENT_Y ) - NTAPS_LUMA;
+	const int iMinHor = ( -iPelX - iMarginX ) * 4;
+	const int iMaxHor = ( m_iSourceWidth - iPelX - iWidth + iMarginX ) * 4;
+	const int iMinVer = ( -iPelY - iMarginY ) * 4;
+	const int iMaxVer = ( m_iSourceHeight - iPelY - iHeight + iMarginY ) * 4;
+	rcMv.set( Clip3( iMinHor, iMaxHor, rcMv.getHor() ), Clip3( iMinVer, iMaxVer, rcMv.getVer() ) );
+}
+
+/** Waits until the reference is final down to luma line iLastLine, the last one the interpolation of a block reads:
+ *  the rows of the reference become final from the top of the frame, after their in-loop filters. The chroma filters
+ *  are shorter and read no further down. The rows already known to be final are kept, they are most of the time.
+ */
+void GvcBUDecoder::xWaitForReference( int iLastLine )
+{
+	const int iNumRows = std::min( m_iHeightInBUs, std::max( iLastLine, 0 ) / (int)m_maxBUHeight + 1 );
+	if( iNumRows <= m_iNumRefRowsReady )
+	{
+		return;
+	}
+	GvcRowProgress& rcRefProgress = m_pcFrameRef->getRowProgress();
+	if( rcRefProgress.get() < iNumRows )
+	{
+		m_uiNumRefWaits++;
+		rcRefProgress.wait( iNumRows );
+	}
+	m_iNumRefRowsReady = rcRefProgress.get();
+}
+
+/** Levels of the transform units of one component of a coding unit, in the order of GvcBUEncoder::xEncodeCoeff, each
+ *  unit reconstructed into the frame before the next one is parsed.
+ */
+void GvcBUDecoder::xDecodeCoeff( GvcSbacDecoder* pcSbac, GvcBlockUnit* pcBU, const ComponentID compID, unsigned int uiAbsPartIdx, unsigned int uiDepth )
+{
+	const unsigned int uiScaleX = getComponentScaleX( compID, m_chromaFormat );
+	const unsigned int uiScaleY = getComponentScaleY( compID, m_chromaFormat );
+	const unsigned int uiWidth = ( m_maxBUWidth >> uiDepth ) >> uiScaleX;
+	const unsigned int uiHeight = ( m_maxBUHeight >> uiDepth ) >> uiScaleY;
+	const unsigned int uiPelX = g_auiZscanToPelX[uiAbsPartIdx];
+	const unsigned int uiPelY = g_auiZscanToPelY[uiAbsPartIdx];
+	const unsigned int uiBUAddr = pcBU->getCtuRsAddr();
+	const int iStride = m_cPredYuv.getStride( compID );
+	const int iRecStride = m_pcFrameRec->getStride( compID );
+	const int iBitDepth = m_bitDepth[toChannelType( compID )];
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	const unsigned int uiTUSize = std::min<unsigned int>( uiWidth, 1u << m_uiQuadtreeTULog2MaxSize );
+	const unsigned int uiNumTUsInSquare = ( uiWidth / uiTUSize ) * ( uiWidth / uiTUSize );
+	const PredMode ePredMode = pcBU->getPredictionMode( uiAbsPartIdx );
+	const bool bUseDST = ePredMode == MODE_INTRA && isLuma( compID ) && uiTUSize == 4;
+
+	unsigned int uiDirMode = 0;
+	if( ePredMode == MODE_INTRA )
+	{
+		uiDirMode = pcBU->getIntraDir( CHANNEL_TYPE_LUMA, uiAbsPartIdx );
+		if( isChroma( compID ) )
+		{
+			const unsigned int uiChromaDir = pcBU->getIntraDir( CHANNEL_TYPE_CHROMA, uiAbsPartIdx );
+			uiDirMode = uiChromaDir == (unsigned int)DM_CHROMA_IDX ? uiDirMode : uiChromaDir;
+			uiDirMode = m_chromaFormat == CHROMA_422 ? g_aucChroma422IntraAngleMappingTable[uiDirMode] : uiDirMode;
+		}
+	}
+	const COEFF_SCAN_TYPE eScanIdx = GvcTrQuant::getCoefScanIdx( compID, m_chromaFormat, ePredMode, uiDirMode, uiTUSize );
+
+	for( unsigned int uiSquareY = 0; uiSquareY < uiHeight; uiSquareY += uiWidth )
+	{
+		for( unsigned int uiTUIdx = 0; uiTUIdx < uiNumTUsInSquare; uiTUIdx++ )
+		{
+			const unsigned int uiTUX = g_auiZscanToPelX[uiTUIdx] / MIN_PU_SIZE * uiTUSize;
+			const unsigned int uiTUY = uiSquareY + g_auiZscanToPelY[uiTUIdx] / MIN_PU_SIZE * uiTUSize;
+			const unsigned int uiTUAbsPartIdx = g_auiRasterToZscan[( ( uiPelY + ( uiTUY << uiScaleY ) ) / MIN_PU_SIZE ) * MAX_NUM_PART_IDXS_IN_BU_WIDTH +
+			                                                       ( uiPelX + ( uiTUX << uiScaleX ) ) / MIN_PU_SIZE];
+			short* pRec = m_pcFrameRec->getAddr( compID, uiBUAddr, uiTUAbsPartIdx );
+			short* pPred = m_cPredYuv.getAddr( compID ) + uiTUY * iStride + uiTUX;
+			short* pResi = m_cResiYuv.getAddr( compID ) + uiTUY * iStride + uiTUX;
+
+			if( ePredMode == MODE_INTRA )
+			{
+				m_cPrediction.initIntraPattern( m_pcFrameRec, compID, uiBUAddr, uiTUAbsPartIdx, uiTUSize, iBitDepth );
+				m_cPrediction.predIntraAng( compID, m_chromaFormat, uiDirMode, pPred, iStride, uiTUSize, iBitDepth );
+			}
+			GvcTUCoeffInfo cInfo;
+			pcSbac->parseCoeffNxN( m_aiLevel, compID, uiTUSize, eScanIdx, cInfo );
+			m_cTrQuant.invTransformNxN( compID, ePredMode, m_aiLevel, pResi, iStride, uiTUSize, bUseDST, iBitDepth, eScanIdx, cInfo );
+			if( isLuma( compID ) )
+			{
+				pcBU->setCbfSubParts( cInfo.uiAbsSum != 0, uiTUAbsPartIdx, g_aucConvertToBit[m_maxBUWidth] - g_aucConvertToBit[uiTUSize] );
+			}
+			for( unsigned int y = 0; y < uiTUSize; y++ )
+			{
+				for( unsigned int x = 0; x < uiTUSize; x++ )
+				{
+					pRec[y * iRecStride + x] = (short)Clip3( 0, iMaxVal, pPred[y * iStride + x] + pResi[y * iStride + x] );
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,93 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBUDecoder.h
+ * \brief    Parsing and reconstruction of a block unit (header)
+ */
+
+#ifndef __GVCBUDECODER_H__
+#define __GVCBUDECODER_H__
+
+#include "TypeDef.h"
+#include "GvcPrediction.h"
+#include "GvcSbacDecoder.h"
+#include "GvcTrQuant.h"
+#include "GvcYuv.h"
+
+class GvcDecoder;
+class GvcFrameUnit;
+
+/**
+ * \class    GvcBUDecoder
+ * \brief    Parses the coding tree of a BU and reconstructs it into the frame, one instance per decoding thread
+ *
+ * The syntax is read in the order GvcBUEncoder writes it and each transform unit is reconstructed as soon as its
+ * levels are parsed, straight into the frame, where the intra prediction of the next one reads it.
+ *
+ * The reference may still be in flight: an inter block first waits for the reference rows its vector reaches, down to
+ * the last line the interpolation reads.
+ */
+class GvcBUDecoder
+{
+	int m_iSourceWidth;
+	int m_iSourceHeight;
+	int m_iHeightInBUs;
+	unsigned int m_maxBUWidth;
+	unsigned int m_maxBUHeight;
+	unsigned int m_maxTotalBUDepth;
+	unsigned int m_uiQuadtreeTULog2MaxSize;
+	ChromaFormat m_chromaFormat;
+	int m_bitDepth[MAX_NUM_CHANNEL_TYPE];
+	GvcFrameUnit* m_pcFrameRec;
+	GvcFrameUnit* m_pcFrameRef;  ///< previous frame, NULL for an intra frame
+	int m_iNumRefRowsReady;      ///< reference BU rows known to be final
+	GvcPrediction m_cPrediction;
+	GvcTrQuant m_cTrQuant;
+	GvcYuv m_cPredYuv;                            ///< prediction of the current coding unit
+	GvcYuv m_cResiYuv;                            ///< residual of the current transform unit, at its place in the coding unit
+	TCoeff m_aiLevel[MAX_TU_SIZE * MAX_TU_SIZE];  ///< levels of the current transform unit
+	// statistics
+	unsigned long long m_uiNumRefWaits;  ///< inter blocks that waited for their reference rows
+
+  public:
+	GvcBUDecoder();
+	virtual ~GvcBUDecoder();
+
+	/// takes the sequence parameters of pcDecoder and allocates the buffers
+	void create( GvcDecoder* pcDecoder );
+	void destroy();
+	void initFrame( GvcFrameUnit* pcFrameRec, GvcFrameUnit* pcFrameRef, int iQP );
+	void decodeBU( GvcSbacDecoder* pcSbac, unsigned int uiBUAddr );
+	/// a BU that cannot be parsed: one intra unit without residual over the samples already in the frame
+	void skipBU( unsigned int uiBUAddr );
+
+	unsigned long long getNumRefWaits() const { return m_uiNumRefWaits; }
+
+  private:
+	bool xIsSplitAllowed( unsigned int uiDepth ) const { return uiDepth + 1 < m_maxTotalBUDepth && ( ( m_maxBUWidth >> uiDepth ) >> 1 ) >= (unsigned int)MIN_BU_SIZE; }
+	void xDecodeBU( GvcSbacDecoder* pcSbac, GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+	void xDecodeCUData( GvcSbacDecoder* pcSbac, GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+	GvcMv xGetMvPredictor( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx );
+	void xClipMv( GvcMv& rcMv, int iPelX, int iPelY, int iWidth, int iHeight ) const;
+	void xWaitForReference( int iLastLine );
+	void xDecodeCoeff( GvcSbacDecoder* pcSbac, GvcBlockUnit* pcBU, const ComponentID compID, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+};
+
+#endif  // __GVCBUDECODER_H__
@@ -0,0 +1,687 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBUEncoder.cpp
+ * \brief    Mode decision and syntax of a block unit
+ */
+
+#include "GvcBUEncoder.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+#include "GvcBlockUnit.h"
+#include "GvcEncoder.h"
+#include "GvcFrameUnit.h"
+#include "GvcRom.h"
+#include "GvcYuv.h"
+#include "TComChromaFormat.h"
+
+/// intra RD candidate list size of each speed preset, for 8x8 to 64x64 blocks
+static const unsigned int s_auiPresetIntraModeNumFast[3][MAX_BU_DEPTH] =
+    {
+        { 8, 8, 8, 8 },
+        { 8, 8, 3, 3 },
+        { 3, 3, 2, 2 },
+};
+
+GvcBUEncoder::GvcBUEncoder()
+    : m_iSourceWidth( 0 )
+    , m_iSourceHeight( 0 )
+    , m_maxBUWidth( 0 )
+    , m_maxBUHeight( 0 )
+    , m_maxTotalBUDepth( 0 )
+    , m_uiQuadtreeTULog2MaxSize( 0 )
+    , m_chromaFormat( CHROMA_420 )
+    , m_pcFrameOrg( NULL )
+    , m_pcFrameRec( NULL )
+    , m_pcFrameRef( NULL )
+    , m_pcThreadPool( NULL )
+    , m_pcHelper( NULL )
+    , m_bForked( false )
+    , m_uiNumIntraBlocks( 0 )
+    , m_uiNumIntraRDModes( 0 )
+    , m_uiNumForks( 0 )
+{
+}
+
+GvcBUEncoder::~GvcBUEncoder()
+{
+	destroy();
+}
+
+void GvcBUEncoder::create( GvcEncoder* pcEncoder )
+{
+	xInit( pcEncoder );
+	// the helper is of no use without threads to run it
+	m_pcThreadPool = pcEncoder->getThreadPool();
+	if( pcEncoder->getModeDecisionTasks() && m_pcThreadPool->getNumThreads() > 0 )
+	{
+		m_pcHelper = new GvcBUEncoder;
+		m_pcHelper->xInit( pcEncoder );
+	}
+}
+
+void GvcBUEncoder::xInit( GvcEncoder* pcEncoder )
+{
+	m_iSourceWidth = pcEncoder->getSourceWidth();
+	m_iSourceHeight = pcEncoder->getSourceHeight();
+	m_maxBUWidth = pcEncoder->getMaxBUWidth();
+	m_maxBUHeight = pcEncoder->getMaxBUHeight();
+	m_maxTotalBUDepth = pcEncoder->getMaxTotalBUDepth();
+	m_uiQuadtreeTULog2MaxSize = pcEncoder->getQuadtreeTULog2MaxSize();
+	m_chromaFormat = pcEncoder->getChromaFormat();
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		m_bitDepth[ch] = pcEncoder->getBitDepth( ChannelType( ch ) );
+	}
+	for( int i = 0; i < MAX_BU_DEPTH; i++ )
+	{
+		m_auiIntraModeNumFast[i] = pcEncoder->getIntraRDCandidates() ? pcEncoder->getIntraRDCandidates() : s_auiPresetIntraModeNumFast[pcEncoder->getPreset()][i];
+	}
+	m_cWorkspace.create( m_maxTotalBUDepth, m_maxBUWidth, m_maxBUHeight, m_chromaFormat );
+	m_cTrQuant.create();
+	m_cTrQuant.init( pcEncoder->getUseRDOQ(), pcEncoder->getUseScalingListId() );
+	m_cMotionEstimation.init( &m_cRdCost, MESearchMethod( pcEncoder->getFastSearch() ), pcEncoder->getSearchRange(), pcEncoder->getHadamardME(),
+	                          m_bitDepth[CHANNEL_TYPE_LUMA] );
+	m_cRDSbac.init( &m_cBinEstimator );
+}
+
+void GvcBUEncoder::destroy()
+{
+	if( m_pcHelper )
+	{
+		delete m_pcHelper;
+		m_pcHelper = NULL;
+	}
+	m_cWorkspace.destroy();
+	m_cTrQuant.destroy();
+}
+
+void GvcBUEncoder::initFrame( GvcFrameUnit* pcFrameOrg, GvcFrameUnit* pcFrameRec, GvcFrameUnit* pcFrameRef, int iQP, double dLambda )
+{
+	m_pcFrameOrg = pcFrameOrg;
+	m_pcFrameRec = pcFrameRec;
+	m_pcFrameRef = pcFrameRef;
+	m_cRdCost.setLambda( dLambda );
+	m_cTrQuant.setQP( iQP, m_chromaFormat );
+	m_cTrQuant.setLambda( dLambda );
+	if( m_pcHelper )
+	{
+		m_pcHelper->initFrame( pcFrameOrg, pcFrameRec, pcFrameRef, iQP, dLambda );
+	}
+}
+
+void GvcBUEncoder::setNumRefLines( int iNumRefLines )
+{
+	m_cMotionEstimation.setNumRefLines( iNumRefLines );
+	if( m_pcHelper )
+	{
+		m_pcHelper->setNumRefLines( iNumRefLines );
+	}
+}
+
+/** Mode decision of a BU. The decision starts from the context states of pcSbac, the coder the BU is written with.
+ */
+void GvcBUEncoder::compressBU( unsigned int uiBUAddr, const GvcSbac* pcSbac )
+{
+	m_cWorkspace.getBestBU( 0 )->initBU( m_pcFrameRec, uiBUAddr );
+	m_cWorkspace.getTempBU( 0 )->initBU( m_pcFrameRec, uiBUAddr );
+	if( m_pcFrameRef && m_cMotionEstimation.getSearchMethod() == ME_PYRAMID )
+	{
+		GvcBlockUnit* pcBU = m_cWorkspace.getBestBU( 0 );
+		m_cMotionEstimation.pyramidSearch( m_pcFrameOrg, m_pcFrameRef, pcBU->getCUPelX(), pcBU->getCUPelY(), m_maxBUWidth, m_maxBUHeight );
+	}
+
+	// the mode decision starts from the contexts of the real coder, which also drive the RDOQ rates
+	pcSbac->storeContexts( m_aacRDContexts[0][CI_CURR_BEST] );
+	pcSbac->estBits( m_cTrQuant.getEstBits() );
+	if( m_pcHelper )
+	{
+		m_pcHelper->m_cTrQuant.getEstBits() = m_cTrQuant.getEstBits();
+		m_pcHelper->m_cMotionEstimation.setPyramidMv( m_cMotionEstimation.getPyramidMv() );
+	}
+	xCompressBU( 0 );
+	m_cWorkspace.addEncodedBU();
+}
+
+void GvcBUEncoder::encodeBU( GvcSbac* pcSbac, unsigned int uiBUAddr )
+{
+	xEncodeBU( pcSbac, m_pcFrameRec->getBU( uiBUAddr ), 0, 0 );
+}
+
+void GvcBUEncoder::xCompressBU( unsigned int uiDepth )
+{
+	GvcBlockUnit* pcBestBU = m_cWorkspace.getBestBU( uiDepth );
+	const unsigned int uiWidth = m_maxBUWidth >> uiDepth;
+	const unsigned int uiHeight = m_maxBUHeight >> uiDepth;
+	const unsigned int uiLPelX = pcBestBU->getCUPelX();
+	const unsigned int uiTPelY = pcBestBU->getCUPelY();
+	const bool bBoundary = ( uiLPelX + uiWidth > (unsigned int)m_iSourceWidth ) || ( uiTPelY + uiHeight > (unsigned int)m_iSourceHeight );
+	const bool bFork = xCanFork( uiDepth, bBoundary );
+	bool bSplitBest = false;
+
+	if( bFork )
+	{
+		xForkCheckRDCost2Nx2N( uiDepth );
+	}
+	else if( !bBoundary )
+	{
+		xCheckRDCost2Nx2N( uiDepth );
+	}
+
+	if( xIsSplitAllowed( uiDepth ) )
+	{
+		const unsigned int uiNextDepth = uiDepth + 1;
+		GvcBlockUnit* pcTempBU = m_cWorkspace.getTempBU( uiDepth );
+		pcTempBU->initEstData( uiDepth );
+
+		bool bFirstSubBU = true;
+		for( unsigned int uiPartUnitIdx = 0; uiPartUnitIdx < 4; uiPartUnitIdx++ )
+		{
+			m_cWorkspace.getBestBU( uiNextDepth )->initSubBU( pcTempBU, uiPartUnitIdx, uiNextDepth );
+			m_cWorkspace.getTempBU( uiNextDepth )->initSubBU( pcTempBU, uiPartUnitIdx, uiNextDepth );
+			GvcBlockUnit* pcSubBestBU = m_cWorkspace.getBestBU( uiNextDepth );
+			if( pcSubBestBU->getCUPelX() < (unsigned int)m_iSourceWidth && pcSubBestBU->getCUPelY() < (unsigned int)m_iSourceHeight )
+			{
+				// each sub unit starts from the contexts left by the best coding of the previous one
+				m_aacRDContexts[uiNextDepth][CI_CURR_BEST] = m_aacRDContexts[bFirstSubBU ? uiDepth : uiNextDepth][bFirstSubBU ? CI_CURR_BEST : CI_NEXT_BEST];
+				bFirstSubBU = false;
+				xCompressBU( uiNextDepth );
+				// the recursion may have swapped the sub unit pointers
+				pcSubBestBU = m_cWorkspace.getBestBU( uiNextDepth );
+				m_cWorkspace.addBytesCopied( pcTempBU->copyPartFrom( pcSubBestBU, uiPartUnitIdx, uiNextDepth ) );
+				m_cWorkspace.addBytesCopied( m_cWorkspace.getRecoYuvBest( uiNextDepth )->copyToPartYuv( m_cWorkspace.getRecoYuvTemp( uiDepth ), pcSubBestBU->getTotalNumPart() * uiPartUnitIdx ) );
+			}
+		}
+		// split flag, coded after the sub units as far as the contexts are concerned
+		m_cRDSbac.loadContexts( m_aacRDContexts[uiNextDepth][CI_NEXT_BEST] );
+		if( !bBoundary )
+		{
+			m_cBinEstimator.resetBits();
+			m_cRDSbac.codeSplitFlag( pcTempBU, 0, uiDepth );
+			pcTempBU->getTotalBits() += ( m_cBinEstimator.getNumFracBits() + ( 1 << ( FRAC_BITS_SCALE - 1 ) ) ) >> FRAC_BITS_SCALE;
+		}
+		m_cRDSbac.storeContexts( m_aacRDContexts[uiDepth][CI_TEMP_BEST] );
+		pcTempBU->getTotalCost() = m_cRdCost.calcRdCost( pcTempBU->getTotalBits(), pcTempBU->getTotalDistortion() );
+		if( bFork )
+		{
+			xJoinCheckRDCost2Nx2N( uiDepth );
+		}
+		bSplitBest = xCheckBestMode( uiDepth );
+	}
+
+	// the frame holds the reconstruction of the last candidate, the blocks coded next predict from the
+	// best one and take their most probable modes from its partitions. The split is the last candidate,
+	// each of its sub units left its own winner in the frame: only a 2Nx2N winner is written back
+	if( !bSplitBest )
+	{
+		m_cWorkspace.addBytesCopied( m_cWorkspace.getBestBU( uiDepth )->copyToFrame() );
+		m_cWorkspace.addBytesCopied( m_cWorkspace.getRecoYuvBest( uiDepth )->copyToFrame( m_pcFrameRec, pcBestBU->getCtuRsAddr(), pcBestBU->getZorderIdxInBU() ) );
+	}
+}
+
+/** A CU is forked when its 2Nx2N candidates are coded with one transform unit per component, so that they write
+ *  nothing to the frame, and when it may be split. The helper takes one CU at a time, the first of the quadtree.
+ */
+bool GvcBUEncoder::xCanFork( unsigned int uiDepth, bool bBoundary ) const
+{
+	return m_pcHelper && !m_bForked && !bBoundary && xIsSplitAllowed( uiDepth ) && ( m_maxBUWidth >> uiDepth ) <= ( 1u << m_uiQuadtreeTULog2MaxSize ) &&
+	       m_chromaFormat != CHROMA_422;
+}
+
+/** Hands the 2Nx2N candidates of the CU of uiDepth to the helper, which starts from the same contexts. */
+void GvcBUEncoder::xForkCheckRDCost2Nx2N( unsigned int uiDepth )
+{
+	m_pcHelper->m_aacRDContexts[uiDepth][CI_CURR_BEST] = m_aacRDContexts[uiDepth][CI_CURR_BEST];
+	m_pcHelper->m_cWorkspace.getBestBU( uiDepth )->initSameCU( m_cWorkspace.getBestBU( uiDepth ), uiDepth );
+	m_pcHelper->m_cWorkspace.getTempBU( uiDepth )->initSameCU( m_cWorkspace.getBestBU( uiDepth ), uiDepth );
+	m_bForked = true;
+	m_uiNumForks++;
+	// a job that never waits, ahead of the substreams
+	m_cHelperJob.fork(
+	    m_pcThreadPool, [this, uiDepth]() { m_pcHelper->xCheckRDCost2Nx2N( uiDepth ); }, INT_MIN );
+}
+
+/** Takes the best 2Nx2N candidate of the helper and the contexts it leaves as the best candidate of uiDepth. */
+void GvcBUEncoder::xJoinCheckRDCost2Nx2N( unsigned int uiDepth )
+{
+	m_cHelperJob.join();
+	m_bForked = false;
+	m_cWorkspace.swapBest( m_pcHelper->m_cWorkspace, uiDepth );
+	m_aacRDContexts[uiDepth][CI_NEXT_BEST] = m_pcHelper->m_aacRDContexts[uiDepth][CI_NEXT_BEST];
+}
+
+void GvcBUEncoder::xCheckRDCost2Nx2N( unsigned int uiDepth )
+{
+	if( m_pcFrameRef )
+	{
+		xCheckRDCostInter( uiDepth );
+	}
+	xCheckRDCostIntra( uiDepth );
+}
+
+/** Inter candidate: one quarter sample motion vector for the block, predicted from the left or else
+ *  the above partition, searched in the previous frame.
+ */
+void GvcBUEncoder::xCheckRDCostInter( unsigned int uiDepth )
+{
+	GvcBlockUnit* pcTempBU = m_cWorkspace.getTempBU( uiDepth );
+	GvcYuv* pcPredYuv = m_cWorkspace.getPredYuvTemp( uiDepth );
+	GvcYuv* pcResiYuv = m_cWorkspace.getResiYuvTemp( uiDepth );
+	GvcYuv* pcRecoYuv = m_cWorkspace.getRecoYuvTemp( uiDepth );
+
+	pcTempBU->initEstData( uiDepth );
+	pcTempBU->setPartSizeSubParts( SIZE_2Nx2N, 0, uiDepth );
+	pcTempBU->setPredModeSubParts( MODE_INTER, 0, uiDepth );
+
+	GvcMv acMvCands[3];
+	int iNumCands = xGetMvCandidates( pcTempBU, 0, acMvCands );
+	const GvcMv cMvPred = iNumCands ? acMvCands[0] : GvcMv();
+	m_cRdCost.setPredictor( cMvPred );
+	if( m_cMotionEstimation.getSearchMethod() == ME_PYRAMID )
+	{
+		acMvCands[iNumCands++] = m_cMotionEstimation.getPyramidMv();
+	}
+
+	GvcMv cMv;
+	m_cMotionEstimation.motionSearch( m_pcFrameOrg->getAddr( COMPONENT_Y, pcTempBU->getCtuRsAddr(), pcTempBU->getZorderIdxInBU() ), m_pcFrameOrg->getStride( COMPONENT_Y ),
+	                                  m_pcFrameRef, pcTempBU->getCUPelX(), pcTempBU->getCUPelY(), pcRecoYuv->getWidth( COMPONENT_Y ), pcRecoYuv->getHeight( COMPONENT_Y ),
+	                                  acMvCands, iNumCands, cMv );
+	pcTempBU->setMvSubParts( cMv, 0, uiDepth );
+	xMotionCompensation( pcTempBU, cMv, pcPredYuv );
+
+	for( unsigned int comp = 0; comp < getNumberValidComponents( m_chromaFormat ); comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		xCodeBlock( pcTempBU, compID, MODE_INTER, 0, pcPredYuv, pcResiYuv, pcRecoYuv );
+		pcTempBU->getTotalDistortion() += m_cRdCost.getSSE( m_pcFrameOrg->getAddr( compID, pcTempBU->getCtuRsAddr(), pcTempBU->getZorderIdxInBU() ),
+		                                                    m_pcFrameOrg->getStride( compID ), pcRecoYuv->getAddr( compID ), pcRecoYuv->getStride( compID ),
+		                                                    pcRecoYuv->getWidth( compID ), pcRecoYuv->getHeight( compID ) );
+	}
+	pcTempBU->getTotalBits() = xEstimateCUBits( pcTempBU, uiDepth );
+	pcTempBU->getTotalCost() = m_cRdCost.calcRdCost( pcTempBU->getTotalBits(), pcTempBU->getTotalDistortion() );
+	xCheckBestMode( uiDepth );
+}
+
+/** Intra candidate. The luma modes are first ranked by the SATD of their prediction of the first
+ *  transform unit, the best ones and the most probable modes are then coded with full RD. Chroma
+ *  follows the luma direction (DM).
+ */
+void GvcBUEncoder::xCheckRDCostIntra( unsigned int uiDepth )
+{
+	GvcBlockUnit* pcTempBU = m_cWorkspace.getTempBU( uiDepth );
+	GvcYuv* pcPredYuv = m_cWorkspace.getPredYuvTemp( uiDepth );
+	GvcYuv* pcResiYuv = m_cWorkspace.getResiYuvTemp( uiDepth );
+	GvcYuv* pcRecoYuv = m_cWorkspace.getRecoYuvTemp( uiDepth );
+	const int iOrgStride = m_pcFrameOrg->getStride( COMPONENT_Y );
+	const short* pOrg = m_pcFrameOrg->getAddr( COMPONENT_Y, pcTempBU->getCtuRsAddr(), pcTempBU->getZorderIdxInBU() );
+	const int iWidth = pcRecoYuv->getWidth( COMPONENT_Y );
+	const int iHeight = pcRecoYuv->getHeight( COMPONENT_Y );
+	const int iBitDepth = m_bitDepth[CHANNEL_TYPE_LUMA];
+
+	pcTempBU->initEstData( uiDepth );
+	pcTempBU->setPartSizeSubParts( SIZE_2Nx2N, 0, uiDepth );
+	pcTempBU->setPredModeSubParts( MODE_INTRA, 0, uiDepth );
+
+	int aiMPM[NUM_MOST_PROBABLE_MODES];
+	pcTempBU->getIntraDirPredictor( 0, aiMPM );
+
+	unsigned int auiRdModeList[NUM_LUMA_MODE];
+	unsigned int uiNumModesForFullRD = std::min<unsigned int>( m_auiIntraModeNumFast[g_aucConvertToBit[iWidth] - 1], NUM_LUMA_MODE );
+	if( uiNumModesForFullRD < (unsigned int)NUM_LUMA_MODE )
+	{
+		// rough pass: prediction only, SATD plus the mode signalling cost, the list is kept sorted
+		const unsigned int uiTUSize = std::min<unsigned int>( iWidth, 1u << m_uiQuadtreeTULog2MaxSize );
+		short* pPred = pcPredYuv->getAddr( COMPONENT_Y );
+		const int iPredStride = pcPredYuv->getStride( COMPONENT_Y );
+		double adCandCostList[NUM_LUMA_MODE];
+		for( unsigned int i = 0; i < uiNumModesForFullRD; i++ )
+		{
+			adCandCostList[i] = MAX_DOUBLE;
+		}
+		m_cPrediction.initIntraPattern( m_pcFrameRec, COMPONENT_Y, pcTempBU->getCtuRsAddr(), pcTempBU->getZorderIdxInBU(), uiTUSize, iBitDepth );
+		for( unsigned int uiMode = 0; uiMode < (unsigned int)NUM_LUMA_MODE; uiMode++ )
+		{
+			m_cPrediction.predIntraAng( COMPONENT_Y, m_chromaFormat, uiMode, pPred, iPredStride, uiTUSize, iBitDepth );
+			const unsigned int uiSatd = m_cRdCost.getSATD( pOrg, iOrgStride, pPred, iPredStride, uiTUSize, uiTUSize, iBitDepth );
+			const double dCost = m_cRdCost.calcRdCostSqrt( xGetIntraModeBits( uiMode, aiMPM ), uiSatd );
+			if( dCost < adCandCostList[uiNumModesForFullRD - 1] )
+			{
+				unsigned int i = uiNumModesForFullRD - 1;
+				for( ; i > 0 && dCost < adCandCostList[i - 1]; i-- )
+				{
+					adCandCostList[i] = adCandCostList[i - 1];
+					auiRdModeList[i] = auiRdModeList[i - 1];
+				}
+				adCandCostList[i] = dCost;
+				auiRdModeList[i] = uiMode;
+			}
+		}
+		// the most probable modes are cheap to signal, give them a full RD check as well
+		for( int j = 0; j < NUM_MOST_PROBABLE_MODES; j++ )
+		{
+			bool bInList = false;
+			for( unsigned int i = 0; i < uiNumModesForFullRD; i++ )
+			{
+				bInList |= auiRdModeList[i] == (unsigned int)aiMPM[j];
+			}
+			if( !bInList )
+			{
+				auiRdModeList[uiNumModesForFullRD++] = aiMPM[j];
+			}
+		}
+	}
+	else
+	{
+		for( unsigned int uiMode = 0; uiMode < (unsigned int)NUM_LUMA_MODE; uiMode++ )
+		{
+			auiRdModeList[uiMode] = uiMode;
+		}
+	}
+
+	unsigned int uiBestMode = DC_IDX;
+	double dBestCost = MAX_DOUBLE;
+	for( unsigned int i = 0; i < uiNumModesForFullRD; i++ )
+	{
+		const unsigned int uiMode = auiRdModeList[i];
+		const int iFracBits = xCodeBlock( pcTempBU, COMPONENT_Y, MODE_INTRA, uiMode, pcPredYuv, pcResiYuv, pcRecoYuv );
+		const unsigned long long uiDist = m_cRdCost.getSSE( pOrg, iOrgStride, pcRecoYuv->getAddr( COMPONENT_Y ), pcRecoYuv->getStride( COMPONENT_Y ), iWidth, iHeight );
+		const double dCost = m_cRdCost.calcRdCost( xGetIntraModeBits( uiMode, aiMPM ) + ( ( iFracBits + ( 1 << ( FRAC_BITS_SCALE - 1 ) ) ) >> FRAC_BITS_SCALE ), uiDist );
+		if( dCost < dBestCost )
+		{
+			dBestCost = dCost;
+			uiBestMode = uiMode;
+		}
+	}
+	m_uiNumIntraBlocks++;
+	m_uiNumIntraRDModes += uiNumModesForFullRD;
+	pcTempBU->setIntraDirSubParts( CHANNEL_TYPE_LUMA, uiBestMode, 0, uiDepth );
+	if( isChromaEnabled( m_chromaFormat ) )
+	{
+		pcTempBU->setIntraDirSubParts( CHANNEL_TYPE_CHROMA, DM_CHROMA_IDX, 0, uiDepth );
+	}
+
+	// the reconstruction of the last mode tried is in the buffers, code the winner again
+	const unsigned int uiChromaMode = m_chromaFormat == CHROMA_422 ? g_aucChroma422IntraAngleMappingTable[uiBestMode] : uiBestMode;
+	for( unsigned int comp = 0; comp < getNumberValidComponents( m_chromaFormat ); comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		xCodeBlock( pcTempBU, compID, MODE_INTRA, isLuma( compID ) ? uiBestMode : uiChromaMode, pcPredYuv, pcResiYuv, pcRecoYuv );
+		pcTempBU->getTotalDistortion() += m_cRdCost.getSSE( m_pcFrameOrg->getAddr( compID, pcTempBU->getCtuRsAddr(), pcTempBU->getZorderIdxInBU() ),
+		                                                    m_pcFrameOrg->getStride( compID ), pcRecoYuv->getAddr( compID ), pcRecoYuv->getStride( compID ),
+		                                                    pcRecoYuv->getWidth( compID ), pcRecoYuv->getHeight( compID ) );
+	}
+	pcTempBU->getTotalBits() = xEstimateCUBits( pcTempBU, uiDepth );
+	pcTempBU->getTotalCost() = m_cRdCost.calcRdCost( pcTempBU->getTotalBits(), pcTempBU->getTotalDistortion() );
+	xCheckBestMode( uiDepth );
+}
+
+/// bits of the luma mode: flag and truncated unary index for a most probable mode, flag and 5 bits otherwise
+unsigned int GvcBUEncoder::xGetIntraModeBits( unsigned int uiMode, const int* piMPM )
+{
+	for( int i = 0; i < NUM_MOST_PROBABLE_MODES; i++ )
+	{
+		if( (unsigned int)piMPM[i] == uiMode )
+		{
+			return i ? 3 : 2;
+		}
+	}
+	return 6;
+}
+
+/** Vectors of the inter partitions at the left and above of uiPartIdx, the first one predicts the
+ *  vector of the block (zero when there is none). Returns the number of candidates.
+ */
+int GvcBUEncoder::xGetMvCandidates( GvcBlockUnit* pcBU, unsigned int uiPartIdx, GvcMv* pcMvCands )
+{
+	int iNumCands = 0;
+	unsigned int uiNeighbourIdx = 0;
+	GvcBlockUnit* pcBULeft = pcBU->getPULeft( uiNeighbourIdx, uiPartIdx );
+	if( pcBULeft && pcBULeft->getPredictionMode( uiNeighbourIdx ) == MODE_INTER )
+	{
+		pcMvCands[iNumCands++] = pcBULeft->getMv( uiNeighbourIdx );
+	}
+	GvcBlockUnit* pcBUAbove = pcBU->getPUAbove( uiNeighbourIdx, uiPartIdx );
+	if( pcBUAbove && pcBUAbove->getPredictionMode( uiNeighbourIdx ) == MODE_INTER )
+	{
+		pcMvCands[iNumCands++] = pcBUAbove->getMv( uiNeighbourIdx );
+	}
+	return iNumCands;
+}
+
+/** Interpolates every component of the block displaced by rcMv in the reference frame. */
+void GvcBUEncoder::xMotionCompensation( GvcBlockUnit* pcBU, const GvcMv& rcMv, GvcYuv* pcPredYuv )
+{
+	for( unsigned int comp = 0; comp < getNumberValidComponents( m_chromaFormat ); comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		m_cPrediction.predInterBlk( compID, m_chromaFormat, m_pcFrameRef, pcBU->getCUPelX(), pcBU->getCUPelY(), rcMv, pcPredYuv->getWidth( compID ),
+		                            pcPredYuv->getHeight( compID ), pcPredYuv->getAddr( compID ), pcPredYuv->getStride( compID ), m_bitDepth[toChannelType( compID )] );
+	}
+}
+
+/** Transform codes one component of the block with the largest allowed transform units and
+ *  reconstructs it. Intra blocks are predicted unit by unit with uiDirMode, inter blocks come with
+ *  their prediction. The units are coded in z-order (the two squares of a 4:2:2 chroma block one
+ *  after the other) and each reconstruction but the last is written to the frame, where the intra
+ *  reference of the next unit is taken from. Returns the estimated rate of the levels in fractional bits.
+ */
+int GvcBUEncoder::xCodeBlock( GvcBlockUnit* pcBU, const ComponentID compID, PredMode ePredMode, unsigned int uiDirMode, GvcYuv* pcPredYuv, GvcYuv* pcResiYuv,
+                              GvcYuv* pcRecoYuv )
+{
+	const int iWidth = pcRecoYuv->getWidth( compID );
+	const int iHeight = pcRecoYuv->getHeight( compID );
+	const int iStride = pcRecoYuv->getStride( compID );
+	const int iOrgStride = m_pcFrameOrg->getStride( compID );
+	const int iRecStride = m_pcFrameRec->getStride( compID );
+	const unsigned int uiBUAddr = pcBU->getCtuRsAddr();
+	const unsigned int uiScaleX = pcRecoYuv->getComponentScaleX( compID );
+	const unsigned int uiScaleY = pcRecoYuv->getComponentScaleY( compID );
+	const unsigned int uiPelX = g_auiZscanToPelX[pcBU->getZorderIdxInBU()];
+	const unsigned int uiPelY = g_auiZscanToPelY[pcBU->getZorderIdxInBU()];
+	const int iBitDepth = m_bitDepth[toChannelType( compID )];
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	const unsigned int uiTUSize = std::min<unsigned int>( iWidth, 1u << m_uiQuadtreeTULog2MaxSize );
+	const unsigned int uiNumTUsInSquare = ( iWidth / uiTUSize ) * ( iWidth / uiTUSize );
+	const bool bUseDST = ePredMode == MODE_INTRA && isLuma( compID ) && uiTUSize == 4;
+	const COEFF_SCAN_TYPE eScanIdx = GvcTrQuant::getCoefScanIdx( compID, m_chromaFormat, ePredMode, uiDirMode, uiTUSize );
+
+	int iFracBits = 0;
+	for( int iSquareY = 0; iSquareY < iHeight; iSquareY += iWidth )
+	{
+		for( unsigned int uiTUIdx = 0; uiTUIdx < uiNumTUsInSquare; uiTUIdx++ )
+		{
+			const int iTUX = g_auiZscanToPelX[uiTUIdx] / MIN_PU_SIZE * uiTUSize;
+			const int iTUY = iSquareY + g_auiZscanToPelY[uiTUIdx] / MIN_PU_SIZE * uiTUSize;
+			const unsigned int uiAbsPartIdx = g_auiRasterToZscan[( ( uiPelY + ( iTUY << uiScaleY ) ) / MIN_PU_SIZE ) * MAX_NUM_PART_IDXS_IN_BU_WIDTH +
+			                                                     ( uiPelX + ( iTUX << uiScaleX ) ) / MIN_PU_SIZE];
+			const short* pOrg = m_pcFrameOrg->getAddr( compID, uiBUAddr, uiAbsPartIdx );
+			short* pRec = m_pcFrameRec->getAddr( compID, uiBUAddr, uiAbsPartIdx );
+			short* pPred = pcPredYuv->getAddr( compID ) + iTUY * iStride + iTUX;
+			short* pResi = pcResiYuv->getAddr( compID ) + iTUY * iStride + iTUX;
+			short* pReco = pcRecoYuv->getAddr( compID ) + iTUY * iStride + iTUX;
+
+			if( ePredMode == MODE_INTRA )
+			{
+				m_cPrediction.initIntraPattern( m_pcFrameRec, compID, uiBUAddr, uiAbsPartIdx, uiTUSize, iBitDepth );
+				m_cPrediction.predIntraAng( compID, m_chromaFormat, uiDirMode, pPred, iStride, uiTUSize, iBitDepth );
+			}
+			for( unsigned int y = 0; y < uiTUSize; y++ )
+			{
+				for( unsigned int x = 0; x < uiTUSize; x++ )
+				{
+					pResi[y * iStride + x] = pOrg[y * iOrgStride + x] - pPred[y * iStride + x];
+				}
+			}
+			GvcTUCoeffInfo cInfo;
+			m_cTrQuant.transformNxN( compID, ePredMode, pResi, iStride, m_aiLevel, uiTUSize, bUseDST, iBitDepth, eScanIdx, cInfo );
+			m_cTrQuant.invTransformNxN( compID, ePredMode, m_aiLevel, pResi, iStride, uiTUSize, bUseDST, iBitDepth, eScanIdx, cInfo );
+			iFracBits += cInfo.iFracBits;
+			memcpy( pcBU->getCoeff( compID, uiAbsPartIdx - pcBU->getZorderIdxInBU() ), m_aiLevel, sizeof( TCoeff ) * uiTUSize * uiTUSize );
+			if( isLuma( compID ) )
+			{
+				pcBU->setCbfSubParts( cInfo.uiAbsSum != 0, uiAbsPartIdx - pcBU->getZorderIdxInBU(), g_aucConvertToBit[m_maxBUWidth] - g_aucConvertToBit[uiTUSize] );
+			}
+			// no unit of the block predicts from the last one
+			const bool bWriteRec = iSquareY + iWidth < iHeight || uiTUIdx + 1 < uiNumTUsInSquare;
+			for( unsigned int y = 0; y < uiTUSize; y++ )
+			{
+				for( unsigned int x = 0; x < uiTUSize; x++ )
+				{
+					pReco[y * iStride + x] = (short)Clip3( 0, iMaxVal, pPred[y * iStride + x] + pResi[y * iStride + x] );
+				}
+				if( bWriteRec )
+				{
+					memcpy( pRec + y * iRecStride, pReco + y * iStride, sizeof( short ) * uiTUSize );
+				}
+			}
+		}
+	}
+	return iFracBits;
+}
+
+bool GvcBUEncoder::xCheckBestMode( unsigned int uiDepth )
+{
+	if( m_cWorkspace.getTempBU( uiDepth )->getTotalCost() < m_cWorkspace.getBestBU( uiDepth )->getTotalCost() )
+	{
+		m_cWorkspace.swapBestTemp( uiDepth );
+		m_aacRDContexts[uiDepth][CI_NEXT_BEST] = m_aacRDContexts[uiDepth][CI_TEMP_BEST];
+		return true;
+	}
+	return false;
+}
+
+/** Rate of a decided candidate: its syntax is run through the estimating coder from the contexts at
+ *  the start of the unit, the contexts it leaves are kept in case it becomes the best one.
+ */
+unsigned int GvcBUEncoder::xEstimateCUBits( GvcBlockUnit* pcBU, unsigned int uiDepth )
+{
+	m_cRDSbac.loadContexts( m_aacRDContexts[uiDepth][CI_CURR_BEST] );
+	m_cBinEstimator.resetBits();
+	if( xIsSplitAllowed( uiDepth ) )
+	{
+		m_cRDSbac.codeSplitFlag( pcBU, 0, uiDepth );
+	}
+	xEncodeCUData( &m_cRDSbac, pcBU, 0, uiDepth );
+	m_cRDSbac.storeContexts( m_aacRDContexts[uiDepth][CI_TEMP_BEST] );
+	return ( m_cBinEstimator.getNumFracBits() + ( 1 << ( FRAC_BITS_SCALE - 1 ) ) ) >> FRAC_BITS_SCALE;
+}
+
+/** Writes the coding tree of a BU as decided by xCompressBU. No split flag is sent where the split is
+ *  forced by the frame boundary or not allowed below the minimum size.
+ */
+void GvcBUEncoder::xEncodeBU( GvcSbac* pcSbac, GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth )
+{
+	const unsigned int uiLPelX = pcBU->getCUPelX() + g_auiZscanToPelX[uiAbsPartIdx];
+	const unsigned int uiTPelY = pcBU->getCUPelY() + g_auiZscanToPelY[uiAbsPartIdx];
+	const bool bBoundary = ( uiLPelX + ( m_maxBUWidth >> uiDepth ) > (unsigned int)m_iSourceWidth ) || ( uiTPelY + ( m_maxBUHeight >> uiDepth ) > (unsigned int)m_iSourceHeight );
+	const bool bCanSplit = xIsSplitAllowed( uiDepth );
+
+	if( bCanSplit && !bBoundary )
+	{
+		pcSbac->codeSplitFlag( pcBU, uiAbsPartIdx, uiDepth );
+	}
+	if( bCanSplit && ( bBoundary || pcBU->getDepth( uiAbsPartIdx ) > uiDepth ) )
+	{
+		const unsigned int uiQNumParts = pcBU->getTotalNumPart() >> ( ( uiDepth + 1 ) << 1 );
+		for( unsigned int uiPartUnitIdx = 0; uiPartUnitIdx < 4; uiPartUnitIdx++ )
+		{
+			const unsigned int uiSubPartIdx = uiAbsPartIdx + uiPartUnitIdx * uiQNumParts;
+			if( pcBU->getCUPelX() + g_auiZscanToPelX[uiSubPartIdx] < (unsigned int)m_iSourceWidth &&
+			    pcBU->getCUPelY() + g_auiZscanToPelY[uiSubPartIdx] < (unsigned int)m_iSourceHeight )
+			{
+				xEncodeBU( pcSbac, pcBU, uiSubPartIdx, uiDepth + 1 );
+			}
+		}
+		return;
+	}
+	xEncodeCUData( pcSbac, pcBU, uiAbsPartIdx, uiDepth );
+}
+
+/** Prediction data and levels of a coding unit starting at partition uiPartIdx of pcBU (a unit of the
+ *  mode decision or the BU stored in the frame).
+ */
+void GvcBUEncoder::xEncodeCUData( GvcSbac* pcSbac, GvcBlockUnit* pcBU, unsigned int uiPartIdx, unsigned int uiDepth )
+{
+	if( m_pcFrameRef )
+	{
+		pcSbac->codePredMode( pcBU, uiPartIdx );
+	}
+	if( pcBU->getPredictionMode( uiPartIdx ) == MODE_INTRA )
+	{
+		pcSbac->codeIntraDirLumaAng( pcBU, uiPartIdx );
+		if( isChromaEnabled( m_chromaFormat ) )
+		{
+			pcSbac->codeIntraDirChroma( pcBU, uiPartIdx );
+		}
+	}
+	else
+	{
+		GvcMv acMvCands[2];
+		const GvcMv cMvPred = xGetMvCandidates( pcBU, uiPartIdx, acMvCands ) ? acMvCands[0] : GvcMv();
+		pcSbac->codeMvd( pcBU->getMv( uiPartIdx ) - cMvPred );
+	}
+	for( unsigned int comp = 0; comp < getNumberValidComponents( m_chromaFormat ); comp++ )
+	{
+		xEncodeCoeff( pcSbac, pcBU, ComponentID( comp ), uiPartIdx, uiDepth );
+	}
+}
+
+/** Levels of the transform units of one component of a coding unit, in the order of xCodeBlock.
+ */
+void GvcBUEncoder::xEncodeCoeff( GvcSbac* pcSbac, GvcBlockUnit* pcBU, const ComponentID compID, unsigned int uiPartIdx, unsigned int uiDepth )
+{
+	const unsigned int uiScaleX = getComponentScaleX( compID, m_chromaFormat );
+	const unsigned int uiScaleY = getComponentScaleY( compID, m_chromaFormat );
+	const unsigned int uiWidth = ( m_maxBUWidth >> uiDepth ) >> uiScaleX;
+	const unsigned int uiHeight = ( m_maxBUHeight >> uiDepth ) >> uiScaleY;
+	const unsigned int uiPelX = g_auiZscanToPelX[pcBU->getZorderIdxInBU() + uiPartIdx];
+	const unsigned int uiPelY = g_auiZscanToPelY[pcBU->getZorderIdxInBU() + uiPartIdx];
+	const unsigned int uiTUSize = std::min<unsigned int>( uiWidth, 1u << m_uiQuadtreeTULog2MaxSize );
+	const unsigned int uiNumTUsInSquare = ( uiWidth / uiTUSize ) * ( uiWidth / uiTUSize );
+	const PredMode ePredMode = pcBU->getPredictionMode( uiPartIdx );
+
+	unsigned int uiDirMode = 0;
+	if( ePredMode == MODE_INTRA )
+	{
+		uiDirMode = pcBU->getIntraDir( CHANNEL_TYPE_LUMA, uiPartIdx );
+		if( isChroma( compID ) )
+		{
+			const unsigned int uiChromaDir = pcBU->getIntraDir( CHANNEL_TYPE_CHROMA, uiPartIdx );
+			uiDirMode = uiChromaDir == (unsigned int)DM_CHROMA_IDX ? uiDirMode : uiChromaDir;
+			uiDirMode = m_chromaFormat == CHROMA_422 ? g_aucChroma422IntraAngleMappingTable[uiDirMode] : uiDirMode;
+		}
+	}
+	const COEFF_SCAN_TYPE eScanIdx = GvcTrQuant::getCoefScanIdx( compID, m_chromaFormat, ePredMode, uiDirMode, uiTUSize );
+
+	for( unsigned int uiSquareY = 0; uiSquareY < uiHeight; uiSquareY += uiWidth )
+	{
+		for( unsigned int uiTUIdx = 0; uiTUIdx < uiNumTUsInSquare; uiTUIdx++ )
+		{
+			const unsigned int uiTUX = g_auiZscanToPelX[uiTUIdx] / MIN_PU_SIZE * uiTUSize;
+			const unsigned int uiTUY = uiSquareY + g_auiZscanToPelY[uiTUIdx] / MIN_PU_SIZE * uiTUSize;
+			const unsigned int uiTUAbsPartIdx = g_auiRasterToZscan[( ( uiPelY + ( uiTUY << uiScaleY ) ) / MIN_PU_SIZE ) * MAX_NUM_PART_IDXS_IN_BU_WIDTH +
+			                                                       ( uiPelX + ( uiTUX << uiScaleX ) ) / MIN_PU_SIZE];
+			pcSbac->codeCoeffNxN( pcBU->getCoeff( compID, uiTUAbsPartIdx - pcBU->getZorderIdxInBU() ), compID, uiTUSize, eScanIdx );
+		}
+	}
+}
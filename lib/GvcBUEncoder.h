@@ -0,0 +1,138 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBUEncoder.h
+ * \brief    Mode decision and syntax of a block unit (header)
+ */
+
+#ifndef __GVCBUENCODER_H__
+#define __GVCBUENCODER_H__
+
+#include "TypeDef.h"
+#include "GvcBUWorkspace.h"
+#include "GvcBinEstimator.h"
+#include "GvcMotionEstimation.h"
+#include "GvcPrediction.h"
+#include "GvcRdCost.h"
+#include "GvcSbac.h"
+#include "GvcThreadPool.h"
+#include "GvcTrQuant.h"
+
+class GvcEncoder;
+class GvcFrameUnit;
+
+/// context states kept per depth of the mode decision
+enum RDContextIdx
+{
+	CI_CURR_BEST = 0,  ///< at the start of the coding unit
+	CI_NEXT_BEST,      ///< after the best candidate so far
+	CI_TEMP_BEST,      ///< after the last candidate tried
+	NUM_RD_CONTEXTS
+};
+
+/**
+ * \class    GvcBUEncoder
+ * \brief    Quadtree mode decision of a BU and the writing of its syntax, one instance per encoding thread
+ *
+ * The instance owns every buffer and state the mode decision touches. The frames are shared: a BU reads the
+ * coded BUs around it from the reconstruction and writes its own samples and data back.
+ *
+ * With mode decision tasks, a helper instance searches the 2Nx2N candidates of a CU as a job of the pool while this
+ * one searches its split, from a copy of the contexts at the start of the CU. Only CUs coded with a single transform
+ * unit per component are forked: their candidates then leave the frame untouched, and the split search only reads
+ * and writes inside the CU. The search joins on the helper before comparing the split with its best candidate, in
+ * the order of a serial search, so the decision does not change.
+ */
+class GvcBUEncoder
+{
+	int m_iSourceWidth;
+	int m_iSourceHeight;
+	unsigned int m_maxBUWidth;
+	unsigned int m_maxBUHeight;
+	unsigned int m_maxTotalBUDepth;
+	unsigned int m_uiQuadtreeTULog2MaxSize;
+	unsigned int m_auiIntraModeNumFast[MAX_BU_DEPTH];  ///< size of the intra RD candidate list per block size (8x8 to 64x64)
+	ChromaFormat m_chromaFormat;
+	int m_bitDepth[MAX_NUM_CHANNEL_TYPE];
+	GvcFrameUnit* m_pcFrameOrg;
+	GvcFrameUnit* m_pcFrameRec;
+	GvcFrameUnit* m_pcFrameRef;  ///< reconstruction of the previous frame, NULL for an intra frame
+	GvcRdCost m_cRdCost;
+	GvcPrediction m_cPrediction;
+	GvcMotionEstimation m_cMotionEstimation;
+	GvcTrQuant m_cTrQuant;
+	GvcBUWorkspace m_cWorkspace;                  ///< best/temp candidates of the quadtree mode decision
+	TCoeff m_aiLevel[MAX_TU_SIZE * MAX_TU_SIZE];  ///< quantized levels of the current transform unit
+	GvcBinEstimator m_cBinEstimator;              ///< rate of the candidates of the mode decision
+	GvcSbac m_cRDSbac;
+	GvcSbacContexts m_aacRDContexts[MAX_BU_DEPTH][NUM_RD_CONTEXTS];
+	GvcThreadPool* m_pcThreadPool;
+	GvcBUEncoder* m_pcHelper;  ///< searches the 2Nx2N candidates of a forked CU, NULL without mode decision tasks
+	GvcForkedJob m_cHelperJob;
+	bool m_bForked;  ///< the helper is busy with a CU around the current one
+	// statistics
+	unsigned long long m_uiNumIntraBlocks;   ///< blocks that went through the intra mode decision
+	unsigned long long m_uiNumIntraRDModes;  ///< intra modes evaluated with full RD
+	unsigned long long m_uiNumForks;         ///< CUs whose 2Nx2N candidates were searched by the helper
+
+  public:
+	GvcBUEncoder();
+	virtual ~GvcBUEncoder();
+
+	/// takes the configuration of pcEncoder and allocates the buffers
+	void create( GvcEncoder* pcEncoder );
+	void destroy();
+	void initFrame( GvcFrameUnit* pcFrameOrg, GvcFrameUnit* pcFrameRec, GvcFrameUnit* pcFrameRef, int iQP, double dLambda );
+	/// luma lines of the reference the motion search may read, 0 once the whole reference is reconstructed
+	void setNumRefLines( int iNumRefLines );
+	void compressBU( unsigned int uiBUAddr, const GvcSbac* pcSbac );
+	/// writes the BU as decided by compressBU
+	void encodeBU( GvcSbac* pcSbac, unsigned int uiBUAddr );
+
+	const GvcBUWorkspace& getWorkspace() const { return m_cWorkspace; }
+	const GvcMotionEstimation& getMotionEstimation() const { return m_cMotionEstimation; }
+	unsigned long long getNumIntraBlocks() const { return m_uiNumIntraBlocks; }
+	unsigned long long getNumIntraRDModes() const { return m_uiNumIntraRDModes; }
+	unsigned long long getNumForks() const { return m_uiNumForks; }
+	const GvcBUEncoder* getHelper() const { return m_pcHelper; }
+
+  private:
+	void xInit( GvcEncoder* pcEncoder );
+	void xCompressBU( unsigned int uiDepth );
+	bool xCanFork( unsigned int uiDepth, bool bBoundary ) const;
+	void xForkCheckRDCost2Nx2N( unsigned int uiDepth );
+	void xJoinCheckRDCost2Nx2N( unsigned int uiDepth );
+	void xCheckRDCost2Nx2N( unsigned int uiDepth );
+	void xCheckRDCostInter( unsigned int uiDepth );
+	void xCheckRDCostIntra( unsigned int uiDepth );
+	static unsigned int xGetIntraModeBits( unsigned int uiMode, const int* piMPM );
+	int xGetMvCandidates( GvcBlockUnit* pcBU, unsigned int uiPartIdx, GvcMv* pcMvCands );
+	void xMotionCompensation( GvcBlockUnit* pcBU, const GvcMv& rcMv, GvcYuv* pcPredYuv );
+	int xCodeBlock( GvcBlockUnit* pcBU, const ComponentID compID, PredMode ePredMode, unsigned int uiDirMode, GvcYuv* pcPredYuv, GvcYuv* pcResiYuv, GvcYuv* pcRecoYuv );
+	/// true if the temporary candidate became the best one
+	bool xCheckBestMode( unsigned int uiDepth );
+	bool xIsSplitAllowed( unsigned int uiDepth ) const { return uiDepth + 1 < m_maxTotalBUDepth && ( ( m_maxBUWidth >> uiDepth ) >> 1 ) >= (unsigned int)MIN_BU_SIZE; }
+	unsigned int xEstimateCUBits( GvcBlockUnit* pcBU, unsigned int uiDepth );
+	void xEncodeBU( GvcSbac* pcSbac, GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+	void xEncodeCUData( GvcSbac* pcSbac, GvcBlockUnit* pcBU, unsigned int uiPartIdx, unsigned int uiDepth );
+	void xEncodeCoeff( GvcSbac* pcSbac, GvcBlockUnit* pcBU, const ComponentID compID, unsigned int uiPartIdx, unsigned int uiDepth );
+};
+
+#endif  // __GVCBUENCODER_H__
@@ -0,0 +1,156 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBUWorkspace.cpp
+ * \brief    Depth indexed best/temp workspace of the BU mode decision
+ */
+
+#include "GvcBUWorkspace.h"
+
+#include <utility>
+
+#include "GvcBlockUnit.h"
+#include "GvcYuv.h"
+
+GvcBUWorkspace::GvcBUWorkspace()
+	: m_uiNumDepths( 0 )
+	, m_ppcBestBU( NULL )
+	, m_ppcTempBU( NULL )
+	, m_ppcPredYuvBest( NULL )
+	, m_ppcResiYuvBest( NULL )
+	, m_ppcRecoYuvBest( NULL )
+	, m_ppcPredYuvTemp( NULL )
+	, m_ppcResiYuvTemp( NULL )
+	, m_ppcRecoYuvTemp( NULL )
+{
+	resetStatistics();
+}
+
+GvcBUWorkspace::~GvcBUWorkspace()
+{
+	destroy();
+}
+
+void GvcBUWorkspace::create( unsigned int uiNumDepths, unsigned int uiMaxWidth, unsigned int uiMaxHeight, ChromaFormat chromaFormatIDC )
+{
+	m_uiNumDepths = uiNumDepths;
+	m_ppcBestBU = new GvcBlockUnit*[uiNumDepths];
+	m_ppcTempBU = new GvcBlockUnit*[uiNumDepths];
+	m_ppcPredYuvBest = new GvcYuv*[uiNumDepths];
+	m_ppcResiYuvBest = new GvcYuv*[uiNumDepths];
+	m_ppcRecoYuvBest = new GvcYuv*[uiNumDepths];
+	m_ppcPredYuvTemp = new GvcYuv*[uiNumDepths];
+	m_ppcResiYuvTemp = new GvcYuv*[uiNumDepths];
+	m_ppcRecoYuvTemp = new GvcYuv*[uiNumDepths];
+
+	const unsigned int uiNumPartitions = ( uiMaxWidth / MIN_PU_SIZE ) * ( uiMaxHeight / MIN_PU_SIZE );
+	for( unsigned int uiDepth = 0; uiDepth < uiNumDepths; uiDepth++ )
+	{
+		const unsigned int uiWidth = uiMaxWidth >> uiDepth;
+		const unsigned int uiHeight = uiMaxHeight >> uiDepth;
+		const unsigned int uiNumPartDepth = uiNumPartitions >> ( 2 * uiDepth );
+
+		m_ppcBestBU[uiDepth] = new GvcBlockUnit;
+		m_ppcBestBU[uiDepth]->create( chromaFormatIDC, uiNumPartDepth, uiMaxWidth, uiMaxHeight, MIN_PU_SIZE );
+		m_ppcTempBU[uiDepth] = new GvcBlockUnit;
+		m_ppcTempBU[uiDepth]->create( chromaFormatIDC, uiNumPartDepth, uiMaxWidth, uiMaxHeight, MIN_PU_SIZE );
+
+		m_ppcPredYuvBest[uiDepth] = new GvcYuv;
+		m_ppcPredYuvBest[uiDepth]->create( uiWidth, uiHeight, chromaFormatIDC );
+		m_ppcResiYuvBest[uiDepth] = new GvcYuv;
+		m_ppcResiYuvBest[uiDepth]->create( uiWidth, uiHeight, chromaFormatIDC );
+		m_ppcRecoYuvBest[uiDepth] = new GvcYuv;
+		m_ppcRecoYuvBest[uiDepth]->create( uiWidth, uiHeight, chromaFormatIDC );
+		m_ppcPredYuvTemp[uiDepth] = new GvcYuv;
+		m_ppcPredYuvTemp[uiDepth]->create( uiWidth, uiHeight, chromaFormatIDC );
+		m_ppcResiYuvTemp[uiDepth] = new GvcYuv;
+		m_ppcResiYuvTemp[uiDepth]->create( uiWidth, uiHeight, chromaFormatIDC );
+		m_ppcRecoYuvTemp[uiDepth] = new GvcYuv;
+		m_ppcRecoYuvTemp[uiDepth]->create( uiWidth, uiHeight, chromaFormatIDC );
+	}
+}
+
+void GvcBUWorkspace::destroy()
+{
+	if( !m_ppcBestBU )
+	{
+		return;
+	}
+	for( unsigned int uiDepth = 0; uiDepth < m_uiNumDepths; uiDepth++ )
+	{
+		delete m_ppcBestBU[uiDepth];
+		delete m_ppcTempBU[uiDepth];
+		delete m_ppcPredYuvBest[uiDepth];
+		delete m_ppcResiYuvBest[uiDepth];
+		delete m_ppcRecoYuvBest[uiDepth];
+		delete m_ppcPredYuvTemp[uiDepth];
+		delete m_ppcResiYuvTemp[uiDepth];
+		delete m_ppcRecoYuvTemp[uiDepth];
+	}
+	delete[] m_ppcBestBU;
+	delete[] m_ppcTempBU;
+	delete[] m_ppcPredYuvBest;
+	delete[] m_ppcResiYuvBest;
+	delete[] m_ppcRecoYuvBest;
+	delete[] m_ppcPredYuvTemp;
+	delete[] m_ppcResiYuvTemp;
+	delete[] m_ppcRecoYuvTemp;
+	m_ppcBestBU = NULL;
+	m_ppcTempBU = NULL;
+	m_ppcPredYuvBest = NULL;
+	m_ppcResiYuvBest = NULL;
+	m_ppcRecoYuvBest = NULL;
+	m_ppcPredYuvTemp = NULL;
+	m_ppcResiYuvTemp = NULL;
+	m_ppcRecoYuvTemp = NULL;
+	m_uiNumDepths = 0;
+}
+
+void GvcBUWorkspace::swapBestTemp( unsigned int uiDepth )
+{
+	std::swap( m_ppcBestBU[uiDepth], m_ppcTempBU[uiDepth] );
+	std::swap( m_ppcPredYuvBest[uiDepth], m_ppcPredYuvTemp[uiDepth] );
+	std::swap( m_ppcResiYuvBest[uiDepth], m_ppcResiYuvTemp[uiDepth] );
+	std::swap( m_ppcRecoYuvBest[uiDepth], m_ppcRecoYuvTemp[uiDepth] );
+
+	m_uiNumSwaps++;
+	m_uiBytesSwapped += GvcBlockUnit::getPartDataSize( m_ppcBestBU[uiDepth]->getTotalNumPart(), m_ppcBestBU[uiDepth]->getChromaFormat() );
+	m_uiBytesSwapped += m_ppcPredYuvBest[uiDepth]->getSize() + m_ppcResiYuvBest[uiDepth]->getSize() + m_ppcRecoYuvBest[uiDepth]->getSize();
+}
+
+void GvcBUWorkspace::swapBest( GvcBUWorkspace& rcOther, unsigned int uiDepth )
+{
+	std::swap( m_ppcBestBU[uiDepth], rcOther.m_ppcBestBU[uiDepth] );
+	std::swap( m_ppcPredYuvBest[uiDepth], rcOther.m_ppcPredYuvBest[uiDepth] );
+	std::swap( m_ppcResiYuvBest[uiDepth], rcOther.m_ppcResiYuvBest[uiDepth] );
+	std::swap( m_ppcRecoYuvBest[uiDepth], rcOther.m_ppcRecoYuvBest[uiDepth] );
+
+	m_uiNumSwaps++;
+	m_uiBytesSwapped += GvcBlockUnit::getPartDataSize( m_ppcBestBU[uiDepth]->getTotalNumPart(), m_ppcBestBU[uiDepth]->getChromaFormat() );
+	m_uiBytesSwapped += m_ppcPredYuvBest[uiDepth]->getSize() + m_ppcResiYuvBest[uiDepth]->getSize() + m_ppcRecoYuvBest[uiDepth]->getSize();
+}
+
+void GvcBUWorkspace::resetStatistics()
+{
+	m_uiBytesCopied = 0;
+	m_uiBytesSwapped = 0;
+	m_uiNumSwaps = 0;
+	m_uiNumBUs = 0;
+}
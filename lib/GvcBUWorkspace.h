@@ -0,0 +1,91 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBUWorkspace.h
+ * \brief    Depth indexed best/temp workspace of the BU mode decision
+ */
+
+#ifndef __GVCBUWORKSPACE_H__
+#define __GVCBUWORKSPACE_H__
+
+#include "TypeDef.h"
+
+class GvcBlockUnit;
+class GvcYuv;
+
+/**
+ * \class    GvcBUWorkspace
+ * \brief    Preallocated best and temporary candidates for every quadtree depth
+ *
+ * Each depth owns a "best" and a "temp" copy of the BU data together with their
+ * prediction, residual and reconstruction buffers. When a temporary candidate
+ * wins it trades places with the best one by exchanging pointers, so partition
+ * arrays and samples are never copied between candidates of the same depth.
+ */
+class GvcBUWorkspace
+{
+  private:
+	unsigned int m_uiNumDepths;
+	GvcBlockUnit** m_ppcBestBU;  ///< best candidate of each depth
+	GvcBlockUnit** m_ppcTempBU;  ///< candidate under evaluation at each depth
+	GvcYuv** m_ppcPredYuvBest;
+	GvcYuv** m_ppcResiYuvBest;
+	GvcYuv** m_ppcRecoYuvBest;
+	GvcYuv** m_ppcPredYuvTemp;
+	GvcYuv** m_ppcResiYuvTemp;
+	GvcYuv** m_ppcRecoYuvTemp;
+	// statistics
+	unsigned long long m_uiBytesCopied;   ///< bytes effectively copied (sub unit merge and frame write back)
+	unsigned long long m_uiBytesSwapped;  ///< bytes a copy based best/temp exchange would have moved
+	unsigned long long m_uiNumSwaps;
+	unsigned long long m_uiNumBUs;
+
+  public:
+	GvcBUWorkspace();
+	virtual ~GvcBUWorkspace();
+
+	void create( unsigned int uiNumDepths, unsigned int uiMaxWidth, unsigned int uiMaxHeight, ChromaFormat chromaFormatIDC );
+	void destroy();
+
+	GvcBlockUnit* getBestBU( unsigned int uiDepth ) { return m_ppcBestBU[uiDepth]; }
+	GvcBlockUnit* getTempBU( unsigned int uiDepth ) { return m_ppcTempBU[uiDepth]; }
+	GvcYuv* getPredYuvBest( unsigned int uiDepth ) { return m_ppcPredYuvBest[uiDepth]; }
+	GvcYuv* getResiYuvBest( unsigned int uiDepth ) { return m_ppcResiYuvBest[uiDepth]; }
+	GvcYuv* getRecoYuvBest( unsigned int uiDepth ) { return m_ppcRecoYuvBest[uiDepth]; }
+	GvcYuv* getPredYuvTemp( unsigned int uiDepth ) { return m_ppcPredYuvTemp[uiDepth]; }
+	GvcYuv* getResiYuvTemp( unsigned int uiDepth ) { return m_ppcResiYuvTemp[uiDepth]; }
+	GvcYuv* getRecoYuvTemp( unsigned int uiDepth ) { return m_ppcRecoYuvTemp[uiDepth]; }
+	unsigned int getNumDepths() const { return m_uiNumDepths; }
+
+	/// make the temporary candidate of uiDepth the best one (pointer exchange only)
+	void swapBestTemp( unsigned int uiDepth );
+	/// take the best candidate of uiDepth from the workspace of another encoder, which gets this one in exchange
+	void swapBest( GvcBUWorkspace& rcOther, unsigned int uiDepth );
+
+	void addBytesCopied( unsigned int uiBytes ) { m_uiBytesCopied += uiBytes; }
+	void addEncodedBU() { m_uiNumBUs++; }
+	unsigned long long getBytesCopied() const { return m_uiBytesCopied; }
+	unsigned long long getBytesSwapped() const { return m_uiBytesSwapped; }
+	unsigned long long getNumSwaps() const { return m_uiNumSwaps; }
+	unsigned long long getNumBUs() const { return m_uiNumBUs; }
+	void resetStatistics();
+};
+
+#endif  // __GVCBUWORKSPACE_H__
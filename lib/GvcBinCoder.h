@@ -0,0 +1,49 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBinCoder.h
+ * \brief    Interface of the bin coders driven by the syntax coder
+ */
+
+#ifndef __GVCBINCODER_H__
+#define __GVCBINCODER_H__
+
+#include "TypeDef.h"
+#include "GvcContextModel.h"
+
+/**
+ * \class    GvcBinIf
+ * \brief    Sink of the bins of GvcSbac: the arithmetic encoder or a rate estimator
+ */
+class GvcBinIf
+{
+  public:
+	virtual ~GvcBinIf() {}
+
+	virtual void encodeBin( unsigned int uiBin, GvcContextModel& rcCtxModel ) = 0;
+	/// equiprobable bin
+	virtual void encodeBinEP( unsigned int uiBin ) = 0;
+	/// uiNumBins equiprobable bins, the most significant bit of uiBins first, up to 32 bins
+	virtual void encodeBinsEP( unsigned int uiBins, int iNumBins ) = 0;
+	/// end of frame flag
+	virtual void encodeBinTrm( unsigned int uiBin ) = 0;
+};
+
+#endif  // __GVCBINCODER_H__
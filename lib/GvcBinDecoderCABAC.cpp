@@ -0,0 +1,175 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBinDecoderCABAC.cpp
+ * \brief    Binary arithmetic decoder
+ */
+
+#include "GvcBinDecoderCABAC.h"
+
+GvcBinDecoderCABAC::GvcBinDecoderCABAC()
+	: m_pucData( NULL )
+	, m_uiSize( 0 )
+	, m_uiPos( 0 )
+	, m_uiRange( 510 )
+	, m_uiValue( 0 )
+	, m_iBitsNeeded( -8 )
+{
+}
+
+GvcBinDecoderCABAC::~GvcBinDecoderCABAC()
+{
+}
+
+void GvcBinDecoderCABAC::init( const unsigned char* pucData, unsigned int uiSize )
+{
+	m_pucData = pucData;
+	m_uiSize = uiSize;
+	m_uiPos = 0;
+}
+
+void GvcBinDecoderCABAC::start()
+{
+	m_uiRange = 510;
+	m_iBitsNeeded = -8;
+	m_uiValue = xReadByte() << 8;
+	m_uiValue |= xReadByte();
+}
+
+/** The value is compared with the MPS range scaled to the bits read ahead. As in the encoder, the shift after an
+ *  LPS comes from the renormalization table and an MPS needs at most one.
+ */
+void GvcBinDecoderCABAC::decodeBin( unsigned int& ruiBin, GvcContextModel& rcCtxModel )
+{
+	const unsigned int uiLPS = GvcContextModel::s_aucLPSTable[rcCtxModel.getState()][( m_uiRange >> 6 ) & 3];
+	m_uiRange -= uiLPS;
+	const unsigned int uiScaledRange = m_uiRange << 7;
+	if( m_uiValue < uiScaledRange )
+	{
+		ruiBin = rcCtxModel.getMps();
+		rcCtxModel.updateMPS();
+		if( uiScaledRange < ( 256 << 7 ) )
+		{
+			m_uiRange = uiScaledRange >> 6;
+			m_uiValue += m_uiValue;
+			if( ++m_iBitsNeeded == 0 )
+			{
+				m_iBitsNeeded = -8;
+				m_uiValue += xReadByte();
+			}
+		}
+	}
+	else
+	{
+		const int iNumBits = GvcContextModel::s_aucRenormTable[uiLPS >> 3];
+		m_uiValue = ( m_uiValue - uiScaledRange ) << iNumBits;
+		m_uiRange = uiLPS << iNumBits;
+		ruiBin = 1 - rcCtxModel.getMps();
+		rcCtxModel.updateLPS();
+		m_iBitsNeeded += iNumBits;
+		if( m_iBitsNeeded >= 0 )
+		{
+			m_uiValue += xReadByte() << m_iBitsNeeded;
+			m_iBitsNeeded -= 8;
+		}
+	}
+}
+
+void GvcBinDecoderCABAC::decodeBinEP( unsigned int& ruiBin )
+{
+	m_uiValue += m_uiValue;
+	if( ++m_iBitsNeeded >= 0 )
+	{
+		m_iBitsNeeded = -8;
+		m_uiValue += xReadByte();
+	}
+	ruiBin = 0;
+	const unsigned int uiScaledRange = m_uiRange << 7;
+	if( m_uiValue >= uiScaledRange )
+	{
+		ruiBin = 1;
+		m_uiValue -= uiScaledRange;
+	}
+}
+
+/** Eight bins take a whole byte, they are split off the value by comparing it with the range at each of the eight
+ *  scales; the bins left over take the bits still needed.
+ */
+void GvcBinDecoderCABAC::decodeBinsEP( unsigned int& ruiBins, int iNumBins )
+{
+	unsigned int uiBins = 0;
+	while( iNumBins > 8 )
+	{
+		m_uiValue = ( m_uiValue << 8 ) + ( xReadByte() << ( 8 + m_iBitsNeeded ) );
+		unsigned int uiScaledRange = m_uiRange << 15;
+		for( int i = 0; i < 8; i++ )
+		{
+			uiBins += uiBins;
+			uiScaledRange >>= 1;
+			if( m_uiValue >= uiScaledRange )
+			{
+				uiBins++;
+				m_uiValue -= uiScaledRange;
+			}
+		}
+		iNumBins -= 8;
+	}
+	m_iBitsNeeded += iNumBins;
+	m_uiValue <<= iNumBins;
+	if( m_iBitsNeeded >= 0 )
+	{
+		m_uiValue += xReadByte() << m_iBitsNeeded;
+		m_iBitsNeeded -= 8;
+	}
+	unsigned int uiScaledRange = m_uiRange << ( iNumBins + 7 );
+	for( int i = 0; i < iNumBins; i++ )
+	{
+		uiBins += uiBins;
+		uiScaledRange >>= 1;
+		if( m_uiValue >= uiScaledRange )
+		{
+			uiBins++;
+			m_uiValue -= uiScaledRange;
+		}
+	}
+	ruiBins = uiBins;
+}
+
+void GvcBinDecoderCABAC::decodeBinTrm( unsigned int& ruiBin )
+{
+	m_uiRange -= 2;
+	const unsigned int uiScaledRange = m_uiRange << 7;
+	if( m_uiValue >= uiScaledRange )
+	{
+		ruiBin = 1;
+		return;
+	}
+	ruiBin = 0;
+	if( uiScaledRange < ( 256 << 7 ) )
+	{
+		m_uiRange = uiScaledRange >> 6;
+		m_uiValue += m_uiValue;
+		if( ++m_iBitsNeeded == 0 )
+		{
+			m_iBitsNeeded = -8;
+			m_uiValue += xReadByte();
+		}
+	}
+}
@@ -0,0 +1,70 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBinDecoderCABAC.h
+ * \brief    Binary arithmetic decoder
+ */
+
+#ifndef __GVCBINDECODERCABAC_H__
+#define __GVCBINDECODERCABAC_H__
+
+#include "TypeDef.h"
+#include "GvcContextModel.h"
+
+/**
+ * \class    GvcBinDecoderCABAC
+ * \brief    Context adaptive binary arithmetic decoder with 9 bit range, the inverse of GvcBinEncoderCABAC
+ *
+ * The value register holds the range scaled by 7 bits plus the bits read ahead; a byte is read whenever 8 bits have
+ * been consumed. The arithmetic code of a substream is a byte range of the caller, reading past its end gives zeros.
+ */
+class GvcBinDecoderCABAC
+{
+	const unsigned char* m_pucData;
+	unsigned int m_uiSize;
+	unsigned int m_uiPos;  ///< next byte to read
+	unsigned int m_uiRange;
+	unsigned int m_uiValue;
+	int m_iBitsNeeded;  ///< -8 right after a byte was read, a new byte is due at 0
+
+	unsigned int xReadByte() { return m_uiPos < m_uiSize ? m_pucData[m_uiPos++] : ( m_uiPos++, 0 ); }
+
+  public:
+	GvcBinDecoderCABAC();
+	~GvcBinDecoderCABAC();
+
+	void init( const unsigned char* pucData, unsigned int uiSize );
+	/// reads the first bits of the arithmetic code
+	void start();
+
+	void decodeBin( unsigned int& ruiBin, GvcContextModel& rcCtxModel );
+	void decodeBinEP( unsigned int& ruiBin );
+	/// iNumBins equiprobable bins, the first one in the most significant bit of ruiBins, up to 32 bins
+	void decodeBinsEP( unsigned int& ruiBins, int iNumBins );
+	/// end of frame flag
+	void decodeBinTrm( unsigned int& ruiBin );
+
+	/// bytes of the range read so far, some of them ahead of the last bin
+	unsigned int getNumReadBytes() const { return m_uiPos; }
+	/// the arithmetic code went past the end of its byte range
+	bool getOverrun() const { return m_uiPos > m_uiSize; }
+};
+
+#endif  // __GVCBINDECODERCABAC_H__
@@ -0,0 +1,199 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBinEncoderCABAC.cpp
+ * \brief    Binary arithmetic encoder
+ */
+
+#include "GvcBinEncoderCABAC.h"
+
+#include "GvcBitstream.h"
+
+GvcBinEncoderCABAC::GvcBinEncoderCABAC()
+	: m_pcBitstream( NULL )
+	, m_uiLow( 0 )
+	, m_uiRange( 510 )
+	, m_iBitsLeft( 23 )
+	, m_uiNumBufferedBytes( 0 )
+	, m_uiBufferedByte( 0xff )
+{
+}
+
+GvcBinEncoderCABAC::~GvcBinEncoderCABAC()
+{
+}
+
+void GvcBinEncoderCABAC::start()
+{
+	m_uiLow = 0;
+	m_uiRange = 510;
+	m_iBitsLeft = 23;
+	m_uiNumBufferedBytes = 0;
+	m_uiBufferedByte = 0xff;
+}
+
+void GvcBinEncoderCABAC::finish()
+{
+	if( m_uiLow >> ( 32 - m_iBitsLeft ) )
+	{
+		// the carry propagates into the held bytes
+		m_pcBitstream->write( m_uiBufferedByte + 1, 8 );
+		while( m_uiNumBufferedBytes > 1 )
+		{
+			m_pcBitstream->write( 0x00, 8 );
+			m_uiNumBufferedBytes--;
+		}
+		m_uiLow -= 1 << ( 32 - m_iBitsLeft );
+	}
+	else
+	{
+		if( m_uiNumBufferedBytes > 0 )
+		{
+			m_pcBitstream->write( m_uiBufferedByte, 8 );
+		}
+		while( m_uiNumBufferedBytes > 1 )
+		{
+			m_pcBitstream->write( 0xff, 8 );
+			m_uiNumBufferedBytes--;
+		}
+	}
+	m_pcBitstream->write( m_uiLow >> 8, 24 - m_iBitsLeft );
+}
+
+/** The LPS range comes from the probability state and the two bits below the leading one of the
+ *  range. After an LPS the renormalization shift is read from a table instead of counting the
+ *  leading zeros of the new range, an MPS needs at most one shift.
+ */
+void GvcBinEncoderCABAC::encodeBin( unsigned int uiBin, GvcContextModel& rcCtxModel )
+{
+	const unsigned int uiLPS = GvcContextModel::s_aucLPSTable[rcCtxModel.getState()][( m_uiRange >> 6 ) & 3];
+	m_uiRange -= uiLPS;
+	if( uiBin != rcCtxModel.getMps() )
+	{
+		const int iNumBits = GvcContextModel::s_aucRenormTable[uiLPS >> 3];
+		m_uiLow = ( m_uiLow + m_uiRange ) << iNumBits;
+		m_uiRange = uiLPS << iNumBits;
+		m_iBitsLeft -= iNumBits;
+		rcCtxModel.updateLPS();
+	}
+	else
+	{
+		rcCtxModel.updateMPS();
+		if( m_uiRange >= 256 )
+		{
+			return;
+		}
+		m_uiLow <<= 1;
+		m_uiRange <<= 1;
+		m_iBitsLeft--;
+	}
+	xTestAndWriteOut();
+}
+
+void GvcBinEncoderCABAC::encodeBinEP( unsigned int uiBin )
+{
+	m_uiLow <<= 1;
+	if( uiBin )
+	{
+		m_uiLow += m_uiRange;
+	}
+	m_iBitsLeft--;
+	xTestAndWriteOut();
+}
+
+/** A bypass bin halves the interval without changing the range, so k bins shift the low register by
+ *  k and add the range times the k bit value. Eight bins are added per step, which keeps the product
+ *  inside the carry headroom of the low register.
+ */
+void GvcBinEncoderCABAC::encodeBinsEP( unsigned int uiBins, int iNumBins )
+{
+	while( iNumBins > 8 )
+	{
+		iNumBins -= 8;
+		const unsigned int uiPattern = ( uiBins >> iNumBins ) & 0xff;
+		m_uiLow = ( m_uiLow << 8 ) + m_uiRange * uiPattern;
+		m_iBitsLeft -= 8;
+		xTestAndWriteOut();
+	}
+	const unsigned int uiPattern = uiBins & ( ( 1u << iNumBins ) - 1 );
+	m_uiLow = ( m_uiLow << iNumBins ) + m_uiRange * uiPattern;
+	m_iBitsLeft -= iNumBins;
+	xTestAndWriteOut();
+}
+
+void GvcBinEncoderCABAC::encodeBinTrm( unsigned int uiBin )
+{
+	m_uiRange -= 2;
+	if( uiBin )
+	{
+		m_uiLow += m_uiRange;
+		m_uiLow <<= 7;
+		m_uiRange = 2 << 7;
+		m_iBitsLeft -= 7;
+	}
+	else if( m_uiRange >= 256 )
+	{
+		return;
+	}
+	else
+	{
+		m_uiLow <<= 1;
+		m_uiRange <<= 1;
+		m_iBitsLeft--;
+	}
+	xTestAndWriteOut();
+}
+
+unsigned int GvcBinEncoderCABAC::getNumWrittenBits() const
+{
+	return m_pcBitstream->getNumberOfWrittenBits() + 8 * m_uiNumBufferedBytes + 23 - m_iBitsLeft;
+}
+
+/** Moves the top byte of the low register out. A 0xff byte could still change with a carry, it is
+ *  only counted; the next byte that is not 0xff releases the held byte (plus carry) and the run.
+ */
+void GvcBinEncoderCABAC::xWriteOut()
+{
+	const unsigned int uiLeadByte = m_uiLow >> ( 24 - m_iBitsLeft );
+	m_iBitsLeft += 8;
+	m_uiLow &= 0xffffffffu >> m_iBitsLeft;
+	if( uiLeadByte == 0xff )
+	{
+		m_uiNumBufferedBytes++;
+		return;
+	}
+	if( m_uiNumBufferedBytes > 0 )
+	{
+		const unsigned int uiCarry = uiLeadByte >> 8;
+		m_pcBitstream->write( m_uiBufferedByte + uiCarry, 8 );
+		m_uiBufferedByte = uiLeadByte & 0xff;
+		const unsigned int uiByte = ( 0xff + uiCarry ) & 0xff;
+		while( m_uiNumBufferedBytes > 1 )
+		{
+			m_pcBitstream->write( uiByte, 8 );
+			m_uiNumBufferedBytes--;
+		}
+	}
+	else
+	{
+		m_uiNumBufferedBytes = 1;
+		m_uiBufferedByte = uiLeadByte;
+	}
+}
@@ -0,0 +1,81 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBinEncoderCABAC.h
+ * \brief    Binary arithmetic encoder
+ */
+
+#ifndef __GVCBINENCODERCABAC_H__
+#define __GVCBINENCODERCABAC_H__
+
+#include "TypeDef.h"
+#include "GvcBinCoder.h"
+#include "GvcContextModel.h"
+
+class GvcBitstream;
+
+/**
+ * \class    GvcBinEncoderCABAC
+ * \brief    Context adaptive binary arithmetic encoder with 9 bit range
+ *
+ * The low register keeps up to 32 bits; whole bytes are moved to the bitstream once fewer than 12
+ * bits are left, a run of 0xff bytes is held back until it is known whether a carry reaches it.
+ */
+class GvcBinEncoderCABAC : public GvcBinIf
+{
+	GvcBitstream* m_pcBitstream;
+	unsigned int m_uiLow;
+	unsigned int m_uiRange;
+	int m_iBitsLeft;                    ///< free bits of the low register above the 8 reserved for the carry
+	unsigned int m_uiNumBufferedBytes;  ///< held byte and the 0xff bytes following it
+	unsigned int m_uiBufferedByte;
+
+  public:
+	GvcBinEncoderCABAC();
+	virtual ~GvcBinEncoderCABAC();
+
+	void init( GvcBitstream* pcBitstream ) { m_pcBitstream = pcBitstream; }
+	void start();
+	/// flushes the low register, the bitstream then ends on a byte or bit boundary of the arithmetic code
+	void finish();
+
+	virtual void encodeBin( unsigned int uiBin, GvcContextModel& rcCtxModel );
+	/// equiprobable bin, without range subdivision
+	virtual void encodeBinEP( unsigned int uiBin );
+	/// uiNumBins equiprobable bins, the most significant bit of uiBins first, up to 32 bins
+	virtual void encodeBinsEP( unsigned int uiBins, int iNumBins );
+	/// end of frame flag, coded with a fixed LPS range of 2
+	virtual void encodeBinTrm( unsigned int uiBin );
+
+	/// bits of the arithmetic code so far, bytes still held in the coder included
+	unsigned int getNumWrittenBits() const;
+
+  private:
+	void xTestAndWriteOut()
+	{
+		if( m_iBitsLeft < 12 )
+		{
+			xWriteOut();
+		}
+	}
+	void xWriteOut();
+};
+
+#endif  // __GVCBINENCODERCABAC_H__
@@ -0,0 +1,58 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBinEstimator.h
+ * \brief    Rate estimation of the bins for the rate-distortion decisions
+ */
+
+#ifndef __GVCBINESTIMATOR_H__
+#define __GVCBINESTIMATOR_H__
+
+#include "TypeDef.h"
+#include "GvcBinCoder.h"
+
+/**
+ * \class    GvcBinEstimator
+ * \brief    Bin coder that only counts: the entropy of each regular bin under its context state, in
+ *           1 / 32768 bit, one bit per bypass bin. The context models adapt as in the real coder.
+ */
+class GvcBinEstimator : public GvcBinIf
+{
+	int m_iFracBits;
+
+  public:
+	GvcBinEstimator() : m_iFracBits( 0 ) {}
+	virtual ~GvcBinEstimator() {}
+
+	void resetBits() { m_iFracBits = 0; }
+	int getNumFracBits() const { return m_iFracBits; }
+
+	virtual void encodeBin( unsigned int uiBin, GvcContextModel& rcCtxModel )
+	{
+		m_iFracBits += rcCtxModel.getEntropyBits( uiBin );
+		rcCtxModel.update( uiBin );
+	}
+	virtual void encodeBinEP( unsigned int ) { m_iFracBits += 1 << FRAC_BITS_SCALE; }
+	virtual void encodeBinsEP( unsigned int, int iNumBins ) { m_iFracBits += iNumBins << FRAC_BITS_SCALE; }
+	/// the LPS range of the flag is 2 out of at least 256: no cost until the end of the frame, 7 bits then
+	virtual void encodeBinTrm( unsigned int uiBin ) { m_iFracBits += uiBin ? 7 << FRAC_BITS_SCALE : 0; }
+};
+
+#endif  // __GVCBINESTIMATOR_H__
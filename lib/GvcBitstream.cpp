@@ -0,0 +1,186 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBitstream.cpp
+ * \brief    Output and input bitstreams, most significant bit first
+ */
+
+#include "GvcBitstream.h"
+
+#include <assert.h>
+
+GvcBitstream::GvcBitstream()
+	: m_ullHeldBits( 0 )
+	, m_uiNumHeldBits( 0 )
+{
+}
+
+GvcBitstream::~GvcBitstream()
+{
+}
+
+void GvcBitstream::xFlushWord()
+{
+	m_uiNumHeldBits -= 32;
+	const unsigned int uiWord = (unsigned int)( m_ullHeldBits >> m_uiNumHeldBits );
+	const size_t uiPos = m_aucFifo.size();
+	m_aucFifo.resize( uiPos + 4 );
+	m_aucFifo[uiPos] = (unsigned char)( uiWord >> 24 );
+	m_aucFifo[uiPos + 1] = (unsigned char)( uiWord >> 16 );
+	m_aucFifo[uiPos + 2] = (unsigned char)( uiWord >> 8 );
+	m_aucFifo[uiPos + 3] = (unsigned char)uiWord;
+}
+
+void GvcBitstream::write( unsigned int uiBits, unsigned int uiNumberOfBits )
+{
+	if( uiNumberOfBits == 0 )
+	{
+		return;
+	}
+	if( uiNumberOfBits < 32 )
+	{
+		uiBits &= ( 1u << uiNumberOfBits ) - 1;
+	}
+	// at most 31 + 32 bits, the flushed bits above them are never read again
+	m_ullHeldBits = ( m_ullHeldBits << uiNumberOfBits ) | uiBits;
+	m_uiNumHeldBits += uiNumberOfBits;
+	if( m_uiNumHeldBits >= 32 )
+	{
+		xFlushWord();
+	}
+}
+
+void GvcBitstream::writeUvlc( unsigned int uiCode )
+{
+	unsigned int uiLength = 1;
+	unsigned int uiTemp = ++uiCode;
+	while( uiTemp > 1 )
+	{
+		uiTemp >>= 1;
+		uiLength += 2;
+	}
+	// the zero prefix, then the code with its leading one
+	write( 0, uiLength >> 1 );
+	write( uiCode, ( uiLength + 1 ) >> 1 );
+}
+
+void GvcBitstream::writeAlignZero()
+{
+	if( m_uiNumHeldBits & 7 )
+	{
+		write( 0, 8 - ( m_uiNumHeldBits & 7 ) );
+	}
+	while( m_uiNumHeldBits )
+	{
+		m_uiNumHeldBits -= 8;
+		m_aucFifo.push_back( (unsigned char)( m_ullHeldBits >> m_uiNumHeldBits ) );
+	}
+}
+
+void GvcBitstream::writeRBSPTrailingBits()
+{
+	write( 1, 1 );
+	writeAlignZero();
+}
+
+void GvcBitstream::addSubstream( const GvcBitstream& rcSubstream )
+{
+	assert( m_uiNumHeldBits == 0 && rcSubstream.m_uiNumHeldBits == 0 );
+	m_aucFifo.insert( m_aucFifo.end(), rcSubstream.m_aucFifo.begin(), rcSubstream.m_aucFifo.end() );
+}
+
+void GvcBitstream::clear()
+{
+	m_aucFifo.clear();
+	m_ullHeldBits = 0;
+	m_uiNumHeldBits = 0;
+}
+
+GvcInputBitstream::GvcInputBitstream()
+	: m_pucData( NULL )
+	, m_uiSize( 0 )
+	, m_uiBitPos( 0 )
+	, m_bOverrun( false )
+{
+}
+
+GvcInputBitstream::~GvcInputBitstream()
+{
+}
+
+void GvcInputBitstream::init( const unsigned char* pucData, unsigned int uiSize )
+{
+	m_pucData = pucData;
+	m_uiSize = uiSize;
+	m_uiBitPos = 0;
+	m_bOverrun = false;
+}
+
+unsigned int GvcInputBitstream::read( unsigned int uiNumberOfBits )
+{
+	unsigned int uiBits = 0;
+	for( unsigned int i = 0; i < uiNumberOfBits; i++ )
+	{
+		const unsigned int uiBytePos = m_uiBitPos >> 3;
+		unsigned int uiBit = 0;
+		if( uiBytePos < m_uiSize )
+		{
+			uiBit = ( m_pucData[uiBytePos] >> ( 7 - ( m_uiBitPos & 7 ) ) ) & 1;
+		}
+		else
+		{
+			m_bOverrun = true;
+		}
+		uiBits = ( uiBits << 1 ) | uiBit;
+		m_uiBitPos++;
+	}
+	return uiBits;
+}
+
+unsigned int GvcInputBitstream::readUvlc()
+{
+	unsigned int uiLength = 0;
+	while( !read( 1 ) )
+	{
+		// no code of the writer is longer, a run of zeros past the end stops here too
+		if( ++uiLength == 32 )
+		{
+			m_bOverrun = true;
+			return 0;
+		}
+	}
+	return ( ( 1u << uiLength ) - 1 ) + read( uiLength );
+}
+
+int GvcInputBitstream::readSvlc()
+{
+	const unsigned int uiCode = readUvlc();
+	return uiCode & 1 ? (int)( ( uiCode + 1 ) >> 1 ) : -(int)( uiCode >> 1 );
+}
+
+bool GvcInputBitstream::readRBSPTrailingBits()
+{
+	if( read( 1 ) != 1 )
+	{
+		return false;
+	}
+	const unsigned int uiNumAlignBits = ( 8 - ( m_uiBitPos & 7 ) ) & 7;
+	return read( uiNumAlignBits ) == 0 && !m_bOverrun;
+}
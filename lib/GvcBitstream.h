@@ -0,0 +1,103 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcBitstream.h
+ * \brief    Output and input bitstreams, most significant bit first
+ */
+
+#ifndef __GVCBITSTREAM_H__
+#define __GVCBITSTREAM_H__
+
+#include <vector>
+
+#include "TypeDef.h"
+
+/**
+ * \class    GvcBitstream
+ * \brief    Byte buffer filled with fixed length codes of up to 32 bits
+ *
+ * Bits are collected in a 64 bit register and moved to the buffer a 32 bit word at a time.
+ */
+class GvcBitstream
+{
+	std::vector<unsigned char> m_aucFifo;  ///< flushed bytes
+	unsigned long long m_ullHeldBits;      ///< bits not flushed yet, right aligned
+	unsigned int m_uiNumHeldBits;          ///< 0 to 31 between calls
+
+	void xFlushWord();
+
+  public:
+	GvcBitstream();
+	~GvcBitstream();
+
+	/// appends the uiNumberOfBits least significant bits of uiBits
+	void write( unsigned int uiBits, unsigned int uiNumberOfBits );
+	/// unsigned Exp-Golomb code
+	void writeUvlc( unsigned int uiCode );
+	/// signed Exp-Golomb code
+	void writeSvlc( int iCode ) { writeUvlc( iCode <= 0 ? -2 * iCode : 2 * iCode - 1 ); }
+	/// completes the current byte with zeros and flushes the held bytes
+	void writeAlignZero();
+	/// a one followed by the zero alignment, ends the headers and the payloads
+	void writeRBSPTrailingBits();
+	/// appends the bytes of an aligned stream, both streams have to end on a byte boundary
+	void addSubstream( const GvcBitstream& rcSubstream );
+	void clear();
+
+	/// the bytes are complete once the stream has been aligned
+	const unsigned char* getByteStream() const { return m_aucFifo.empty() ? NULL : &m_aucFifo[0]; }
+	/// number of flushed bytes
+	unsigned int getByteStreamLength() const { return (unsigned int)m_aucFifo.size(); }
+	unsigned int getNumberOfWrittenBits() const { return (unsigned int)m_aucFifo.size() * 8 + m_uiNumHeldBits; }
+};
+
+/**
+ * \class    GvcInputBitstream
+ * \brief    Fixed length and Exp-Golomb codes read from a byte buffer the caller keeps
+ *
+ * Reading past the end of the buffer gives zero bits and marks the stream as overrun.
+ */
+class GvcInputBitstream
+{
+	const unsigned char* m_pucData;
+	unsigned int m_uiSize;
+	unsigned int m_uiBitPos;  ///< bits read so far
+	bool m_bOverrun;
+
+  public:
+	GvcInputBitstream();
+	~GvcInputBitstream();
+
+	void init( const unsigned char* pucData, unsigned int uiSize );
+	/// the next uiNumberOfBits bits, up to 32
+	unsigned int read( unsigned int uiNumberOfBits );
+	/// unsigned Exp-Golomb code
+	unsigned int readUvlc();
+	/// signed Exp-Golomb code
+	int readSvlc();
+	/// the one and the zero alignment that end a header, false if they are not there
+	bool readRBSPTrailingBits();
+
+	/// bytes read, the current one included, once the stream is aligned the position of the next byte
+	unsigned int getByteLocation() const { return ( m_uiBitPos + 7 ) >> 3; }
+	bool getOverrun() const { return m_bOverrun; }
+};
+
+#endif  // __GVCBITSTREAM_H__
@@ -2,19 +2,368 @@
 // Created by rmonteiro on 24-10-2018.
 //
 
+#include <algorithm>
+#include <cstring>
+
 #include "GvcBlockUnit.h"
 #include "GvcFrameUnit.h"
+#include "GvcRom.h"
+#include "TComChromaFormat.h"
 
 GvcBlockUnit::GvcBlockUnit()
-{}
+: m_pcFrame(NULL)
+, m_uiBUAddr(0)
+, m_uiAbsIdxInBU(0)
+, m_uiBUPelX(0)
+, m_uiBUPelY(0)
+, m_uiNumPartition(0)
+, m_uiMaxWidth(0)
+, m_uiMaxHeight(0)
+, m_unitSize(MIN_PU_SIZE)
+, m_chromaFormatIDC(CHROMA_420)
+, m_puhDepth(NULL)
+, m_pePartSize(NULL)
+, m_pePredMode(NULL)
+, m_pcMv(NULL)
+, m_puhCbf(NULL)
+, m_dTotalCost(MAX_DOUBLE)
+, m_uiTotalDistortion(0)
+, m_uiTotalBits(0)
+{
+    for (unsigned int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++)
+    {
+        m_puhIntraDir[ch] = NULL;
+    }
+    for (unsigned int comp = 0; comp < MAX_NUM_COMPONENT; comp++)
+    {
+        m_pcTrCoeff[comp] = NULL;
+    }
+}
 
 GvcBlockUnit::~GvcBlockUnit()
-{}
+{
+    destroy();
+}
 
 void GvcBlockUnit::create(ChromaFormat chromaFormatIDC, unsigned int uiNumPartition, unsigned int uiWidth,
                           unsigned int uiHeight, int unitSize)
 {
     m_pcFrame              = NULL;
     m_uiNumPartition     = uiNumPartition;
+    m_uiMaxWidth = uiWidth;
+    m_uiMaxHeight = uiHeight;
     m_unitSize = unitSize;
-}
\ No newline at end of file
+    m_chromaFormatIDC = chromaFormatIDC;
+
+    m_puhDepth   = (unsigned char*)xMalloc(unsigned char, uiNumPartition);
+    m_pePartSize = (char*)xMalloc(char, uiNumPartition);
+    m_pePredMode = (char*)xMalloc(char, uiNumPartition);
+    for (unsigned int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++)
+    {
+        m_puhIntraDir[ch] = (unsigned char*)xMalloc(unsigned char, uiNumPartition);
+    }
+    m_pcMv = new GvcMv[uiNumPartition];
+    m_puhCbf = (unsigned char*)xMalloc(unsigned char, uiNumPartition);
+    for (unsigned int comp = 0; comp < getNumberValidComponents(chromaFormatIDC); comp++)
+    {
+        const ComponentID compID = ComponentID(comp);
+        const unsigned int uiNumCoeff = (uiNumPartition * unitSize * unitSize) >> (getComponentScaleX(compID, chromaFormatIDC) + getComponentScaleY(compID, chromaFormatIDC));
+        m_pcTrCoeff[comp] = (TCoeff*)xMalloc(TCoeff, uiNumCoeff);
+        memset(m_pcTrCoeff[comp], 0, sizeof(TCoeff) * uiNumCoeff);
+    }
+}
+
+void GvcBlockUnit::destroy()
+{
+    if (m_puhDepth)
+    {
+        xFree(m_puhDepth);
+        m_puhDepth = NULL;
+    }
+    if (m_pePartSize)
+    {
+        xFree(m_pePartSize);
+        m_pePartSize = NULL;
+    }
+    if (m_pePredMode)
+    {
+        xFree(m_pePredMode);
+        m_pePredMode = NULL;
+    }
+    for (unsigned int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++)
+    {
+        if (m_puhIntraDir[ch])
+        {
+            xFree(m_puhIntraDir[ch]);
+            m_puhIntraDir[ch] = NULL;
+        }
+    }
+    if (m_pcMv)
+    {
+        delete[] m_pcMv;
+        m_pcMv = NULL;
+    }
+    if (m_puhCbf)
+    {
+        xFree(m_puhCbf);
+        m_puhCbf = NULL;
+    }
+    for (unsigned int comp = 0; comp < MAX_NUM_COMPONENT; comp++)
+    {
+        if (m_pcTrCoeff[comp])
+        {
+            xFree(m_pcTrCoeff[comp]);
+            m_pcTrCoeff[comp] = NULL;
+        }
+    }
+}
+
+void GvcBlockUnit::initBU(GvcFrameUnit* pcPic, unsigned int ctuRsAddr)
+{
+    m_pcFrame = pcPic;
+    m_uiBUAddr = ctuRsAddr;
+    m_uiAbsIdxInBU = 0;
+    m_uiBUPelX = (ctuRsAddr % pcPic->getFrameWidthInBUs()) * m_uiMaxWidth;
+    m_uiBUPelY = (ctuRsAddr / pcPic->getFrameWidthInBUs()) * m_uiMaxHeight;
+    m_uiNumPartition = pcPic->getNumPartitionsInBU();
+    initEstData(0);
+}
+
+void GvcBlockUnit::initSubBU(GvcBlockUnit* pcBU, unsigned int uiPartUnitIdx, unsigned int uiDepth)
+{
+    const unsigned int uiNumPartition = pcBU->getTotalNumPart() >> 2;
+    m_pcFrame = pcBU->getFrame();
+    m_uiBUAddr = pcBU->getCtuRsAddr();
+    m_uiAbsIdxInBU = pcBU->getZorderIdxInBU() + uiPartUnitIdx * uiNumPartition;
+    m_uiBUPelX = pcBU->getCUPelX() + (uiPartUnitIdx & 1) * (m_uiMaxWidth >> uiDepth);
+    m_uiBUPelY = pcBU->getCUPelY() + (uiPartUnitIdx >> 1) * (m_uiMaxHeight >> uiDepth);
+    m_uiNumPartition = uiNumPartition;
+    initEstData(uiDepth);
+}
+
+void GvcBlockUnit::initSameCU(GvcBlockUnit* pcBU, unsigned int uiDepth)
+{
+    m_pcFrame = pcBU->getFrame();
+    m_uiBUAddr = pcBU->getCtuRsAddr();
+    m_uiAbsIdxInBU = pcBU->getZorderIdxInBU();
+    m_uiBUPelX = pcBU->getCUPelX();
+    m_uiBUPelY = pcBU->getCUPelY();
+    m_uiNumPartition = pcBU->getTotalNumPart();
+    initEstData(uiDepth);
+}
+
+void GvcBlockUnit::initEstData(unsigned int uiDepth)
+{
+    m_dTotalCost = MAX_DOUBLE;
+    m_uiTotalDistortion = 0;
+    m_uiTotalBits = 0;
+    memset(m_puhDepth, uiDepth, m_uiNumPartition);
+    memset(m_pePartSize, NUMBER_OF_PART_SIZES, m_uiNumPartition);
+    memset(m_pePredMode, NUMBER_OF_PREDICTION_MODES, m_uiNumPartition);
+    for (unsigned int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++)
+    {
+        memset(m_puhIntraDir[ch], DC_IDX, m_uiNumPartition);
+    }
+    std::fill(m_pcMv, m_pcMv + m_uiNumPartition, GvcMv());
+    memset(m_puhCbf, 0, m_uiNumPartition);
+}
+
+unsigned int GvcBlockUnit::getPartDataSize(unsigned int uiNumPartition, ChromaFormat chromaFormatIDC)
+{
+    unsigned int uiNumCoeff = 0;
+    for (unsigned int comp = 0; comp < getNumberValidComponents(chromaFormatIDC); comp++)
+    {
+        const ComponentID compID = ComponentID(comp);
+        uiNumCoeff += (uiNumPartition * MIN_PU_SIZE * MIN_PU_SIZE) >> (getComponentScaleX(compID, chromaFormatIDC) + getComponentScaleY(compID, chromaFormatIDC));
+    }
+    return uiNumPartition * (sizeof(unsigned char) + sizeof(char) + sizeof(char) + MAX_NUM_CHANNEL_TYPE * sizeof(unsigned char) + sizeof(GvcMv) + sizeof(unsigned char)) +
+           uiNumCoeff * sizeof(TCoeff);
+}
+
+unsigned int GvcBlockUnit::copyPartFrom(GvcBlockUnit* pcSubBU, unsigned int uiPartUnitIdx, unsigned int uiDepth)
+{
+    const unsigned int uiNumPartition = pcSubBU->getTotalNumPart();
+    const unsigned int uiOffset = uiPartUnitIdx * uiNumPartition;
+
+    m_uiTotalDistortion += pcSubBU->getTotalDistortion();
+    m_uiTotalBits += pcSubBU->getTotalBits();
+
+    memcpy(m_puhDepth + uiOffset, pcSubBU->getDepth(), uiNumPartition);
+    memcpy(m_pePartSize + uiOffset, pcSubBU->getPartitionSize(), uiNumPartition);
+    memcpy(m_pePredMode + uiOffset, pcSubBU->getPredictionMode(), uiNumPartition);
+    for (unsigned int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++)
+    {
+        memcpy(m_puhIntraDir[ch] + uiOffset, pcSubBU->getIntraDir(ChannelType(ch)), uiNumPartition);
+    }
+    memcpy(m_pcMv + uiOffset, pcSubBU->getMv(), sizeof(GvcMv) * uiNumPartition);
+    memcpy(m_puhCbf + uiOffset, pcSubBU->getCbf(), uiNumPartition);
+    for (unsigned int comp = 0; comp < getNumberValidComponents(m_chromaFormatIDC); comp++)
+    {
+        const ComponentID compID = ComponentID(comp);
+        const unsigned int uiShift = getComponentScaleX(compID, m_chromaFormatIDC) + getComponentScaleY(compID, m_chromaFormatIDC);
+        memcpy(getCoeff(compID, uiOffset), pcSubBU->getCoeff(compID, 0), sizeof(TCoeff) * ((uiNumPartition * m_unitSize * m_unitSize) >> uiShift));
+    }
+    return getPartDataSize(uiNumPartition, m_chromaFormatIDC);
+}
+
+unsigned int GvcBlockUnit::copyToFrame()
+{
+    GvcBlockUnit* pcFrameBU = m_pcFrame->getBU(m_uiBUAddr);
+
+    pcFrameBU->getTotalCost() = m_dTotalCost;
+    pcFrameBU->getTotalDistortion() = m_uiTotalDistortion;
+    pcFrameBU->getTotalBits() = m_uiTotalBits;
+
+    memcpy(pcFrameBU->getDepth() + m_uiAbsIdxInBU, m_puhDepth, m_uiNumPartition);
+    memcpy(pcFrameBU->getPartitionSize() + m_uiAbsIdxInBU, m_pePartSize, m_uiNumPartition);
+    memcpy(pcFrameBU->getPredictionMode() + m_uiAbsIdxInBU, m_pePredMode, m_uiNumPartition);
+    for (unsigned int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++)
+    {
+        memcpy(pcFrameBU->getIntraDir(ChannelType(ch)) + m_uiAbsIdxInBU, m_puhIntraDir[ch], m_uiNumPartition);
+    }
+    memcpy(pcFrameBU->getMv() + m_uiAbsIdxInBU, m_pcMv, sizeof(GvcMv) * m_uiNumPartition);
+    memcpy(pcFrameBU->getCbf() + m_uiAbsIdxInBU, m_puhCbf, m_uiNumPartition);
+    for (unsigned int comp = 0; comp < getNumberValidComponents(m_chromaFormatIDC); comp++)
+    {
+        const ComponentID compID = ComponentID(comp);
+        const unsigned int uiShift = getComponentScaleX(compID, m_chromaFormatIDC) + getComponentScaleY(compID, m_chromaFormatIDC);
+        memcpy(pcFrameBU->getCoeff(compID, m_uiAbsIdxInBU), m_pcTrCoeff[comp], sizeof(TCoeff) * ((m_uiNumPartition * m_unitSize * m_unitSize) >> uiShift));
+    }
+    return getPartDataSize(m_uiNumPartition, m_chromaFormatIDC);
+}
+
+void GvcBlockUnit::setDepthSubParts(unsigned int uiDepth, unsigned int uiAbsPartIdx)
+{
+    const unsigned int uiCurrPartNumb = ((m_uiMaxWidth / m_unitSize) * (m_uiMaxHeight / m_unitSize)) >> (uiDepth << 1);
+    memset(m_puhDepth + uiAbsPartIdx, uiDepth, uiCurrPartNumb);
+}
+
+void GvcBlockUnit::setPartSizeSubParts(PartSize eMode, unsigned int uiAbsPartIdx, unsigned int uiDepth)
+{
+    const unsigned int uiCurrPartNumb = ((m_uiMaxWidth / m_unitSize) * (m_uiMaxHeight / m_unitSize)) >> (uiDepth << 1);
+    memset(m_pePartSize + uiAbsPartIdx, eMode, uiCurrPartNumb);
+}
+
+void GvcBlockUnit::setPredModeSubParts(PredMode eMode, unsigned int uiAbsPartIdx, unsigned int uiDepth)
+{
+    const unsigned int uiCurrPartNumb = ((m_uiMaxWidth / m_unitSize) * (m_uiMaxHeight / m_unitSize)) >> (uiDepth << 1);
+    memset(m_pePredMode + uiAbsPartIdx, eMode, uiCurrPartNumb);
+}
+
+void GvcBlockUnit::setIntraDirSubParts(const ChannelType chType, unsigned int uiDir, unsigned int uiAbsPartIdx, unsigned int uiDepth)
+{
+    const unsigned int uiCurrPartNumb = ((m_uiMaxWidth / m_unitSize) * (m_uiMaxHeight / m_unitSize)) >> (uiDepth << 1);
+    memset(m_puhIntraDir[chType] + uiAbsPartIdx, uiDir, uiCurrPartNumb);
+}
+
+void GvcBlockUnit::setMvSubParts(const GvcMv& rcMv, unsigned int uiAbsPartIdx, unsigned int uiDepth)
+{
+    const unsigned int uiCurrPartNumb = ((m_uiMaxWidth / m_unitSize) * (m_uiMaxHeight / m_unitSize)) >> (uiDepth << 1);
+    for (unsigned int i = 0; i < uiCurrPartNumb; i++)
+    {
+        m_pcMv[uiAbsPartIdx + i] = rcMv;
+    }
+}
+
+void GvcBlockUnit::setCbfSubParts(bool bCbf, unsigned int uiAbsPartIdx, unsigned int uiTUDepth)
+{
+    const unsigned int uiCurrPartNumb = ((m_uiMaxWidth / m_unitSize) * (m_uiMaxHeight / m_unitSize)) >> (uiTUDepth << 1);
+    memset(m_puhCbf + uiAbsPartIdx, bCbf, uiCurrPartNumb);
+}
+
+TCoeff* GvcBlockUnit::getCoeff(const ComponentID compID, unsigned int uiAbsPartIdx)
+{
+    return m_pcTrCoeff[compID] + ((uiAbsPartIdx * m_unitSize * m_unitSize) >> (getComponentScaleX(compID, m_chromaFormatIDC) + getComponentScaleY(compID, m_chromaFormatIDC)));
+}
+
+GvcBlockUnit* GvcBlockUnit::getPULeft(unsigned int& ruiLPartUnitIdx, unsigned int uiCurrPartUnitIdx, bool bEnforceTileRestriction)
+{
+    const unsigned int uiAbsPartIdx = m_uiAbsIdxInBU + uiCurrPartUnitIdx;
+    const unsigned int uiRaster = g_auiZscanToRaster[uiAbsPartIdx];
+    if (uiRaster % MAX_NUM_PART_IDXS_IN_BU_WIDTH)
+    {
+        ruiLPartUnitIdx = g_auiRasterToZscan[uiRaster - 1];
+        return ruiLPartUnitIdx < uiAbsPartIdx ? m_pcFrame->getBU(m_uiBUAddr) : NULL;
+    }
+    if (m_uiBUAddr % m_pcFrame->getFrameWidthInBUs() == 0)
+    {
+        return NULL;
+    }
+    if (bEnforceTileRestriction && m_pcFrame->getTileIdxMap(m_uiBUAddr - 1) != m_pcFrame->getTileIdxMap(m_uiBUAddr))
+    {
+        return NULL;
+    }
+    ruiLPartUnitIdx = g_auiRasterToZscan[uiRaster + m_uiMaxWidth / m_unitSize - 1];
+    return m_pcFrame->getBU(m_uiBUAddr - 1);
+}
+
+GvcBlockUnit* GvcBlockUnit::getPUAbove(unsigned int& ruiAPartUnitIdx, unsigned int uiCurrPartUnitIdx, bool bEnforceTileRestriction)
+{
+    const unsigned int uiAbsPartIdx = m_uiAbsIdxInBU + uiCurrPartUnitIdx;
+    const unsigned int uiRaster = g_auiZscanToRaster[uiAbsPartIdx];
+    if (uiRaster >= (unsigned int)MAX_NUM_PART_IDXS_IN_BU_WIDTH)
+    {
+        ruiAPartUnitIdx = g_auiRasterToZscan[uiRaster - MAX_NUM_PART_IDXS_IN_BU_WIDTH];
+        return ruiAPartUnitIdx < uiAbsPartIdx ? m_pcFrame->getBU(m_uiBUAddr) : NULL;
+    }
+    if (m_uiBUAddr < (unsigned int)m_pcFrame->getFrameWidthInBUs())
+    {
+        return NULL;
+    }
+    if (bEnforceTileRestriction && m_pcFrame->getTileIdxMap(m_uiBUAddr - m_pcFrame->getFrameWidthInBUs()) != m_pcFrame->getTileIdxMap(m_uiBUAddr))
+    {
+        return NULL;
+    }
+    ruiAPartUnitIdx = g_auiRasterToZscan[uiRaster + (m_uiMaxHeight / m_unitSize - 1) * MAX_NUM_PART_IDXS_IN_BU_WIDTH];
+    return m_pcFrame->getBU(m_uiBUAddr - m_pcFrame->getFrameWidthInBUs());
+}
+
+/** The left and above partitions give two candidates (DC when not intra or not available, the above
+ *  one is not taken from another BU row), completed to three distinct modes.
+ */
+void GvcBlockUnit::getIntraDirPredictor(unsigned int uiAbsPartIdx, int* piIntraDirPred)
+{
+    unsigned int uiTempPartIdx = 0;
+    int iLeftIntraDir = DC_IDX;
+    int iAboveIntraDir = DC_IDX;
+
+    GvcBlockUnit* pcBULeft = getPULeft(uiTempPartIdx, uiAbsPartIdx);
+    if (pcBULeft && pcBULeft->getPredictionMode(uiTempPartIdx) == MODE_INTRA)
+    {
+        iLeftIntraDir = pcBULeft->getIntraDir(CHANNEL_TYPE_LUMA, uiTempPartIdx);
+    }
+    GvcBlockUnit* pcBUAbove = getPUAbove(uiTempPartIdx, uiAbsPartIdx);
+    if (pcBUAbove && pcBUAbove->getCtuRsAddr() == m_uiBUAddr && pcBUAbove->getPredictionMode(uiTempPartIdx) == MODE_INTRA)
+    {
+        iAboveIntraDir = pcBUAbove->getIntraDir(CHANNEL_TYPE_LUMA, uiTempPartIdx);
+    }
+
+    if (iLeftIntraDir == iAboveIntraDir)
+    {
+        if (iLeftIntraDir > DC_IDX)
+        {
+            piIntraDirPred[0] = iLeftIntraDir;
+            piIntraDirPred[1] = ((iLeftIntraDir + 29) % 32) + 2;
+            piIntraDirPred[2] = ((iLeftIntraDir - 2 + 1) % 32) + 2;
+        }
+        else
+        {
+            piIntraDirPred[0] = PLANAR_IDX;
+            piIntraDirPred[1] = DC_IDX;
+            piIntraDirPred[2] = VER_IDX;
+        }
+    }
+    else
+    {
+        piIntraDirPred[0] = iLeftIntraDir;
+        piIntraDirPred[1] = iAboveIntraDir;
+        if (iLeftIntraDir && iAboveIntraDir)
+        {
+            piIntraDirPred[2] = PLANAR_IDX;
+        }
+        else
+        {
+            piIntraDirPred[2] = (iLeftIntraDir + iAboveIntraDir) < 2 ? VER_IDX : DC_IDX;
+        }
+    }
+}
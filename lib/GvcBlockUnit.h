@@ -6,6 +6,7 @@
 #define GVC_GVCBLOCKUNIT_H
 
 #include "TypeDef.h"
+#include "GvcMv.h"
 
 class GvcFrameUnit;
 class GvcBlockUnit
@@ -14,10 +15,28 @@ private:
 
     GvcFrameUnit*      m_pcFrame;                                ///< picture class pointer
     unsigned int          m_uiBUAddr;                            ///< CTU (also known as LCU) address in a slice (Raster-scan address, as opposed to tile-scan/encoding order).
+    unsigned int          m_uiAbsIdxInBU;                        ///< z-order index of the first partition of this unit inside its BU
     unsigned int          m_uiBUPelX;                             ///< CU position in a pixel (X)
     unsigned int          m_uiBUPelY;                             ///< CU position in a pixel (Y)
     unsigned int          m_uiNumPartition;                       ///< total number of minimum partitions in a CU
+    unsigned int          m_uiMaxWidth;                           ///< width of the BU at depth 0
+    unsigned int          m_uiMaxHeight;                          ///< height of the BU at depth 0
     int           m_unitSize;                             ///< size of a "minimum partition"
+    ChromaFormat  m_chromaFormatIDC;
+
+    // per partition data
+    unsigned char*        m_puhDepth;                             ///< quadtree depth of the coding unit
+    char*                 m_pePartSize;                           ///< partition shape (PartSize)
+    char*                 m_pePredMode;                           ///< prediction mode (PredMode)
+    unsigned char*        m_puhIntraDir[MAX_NUM_CHANNEL_TYPE];    ///< intra prediction direction of each channel type
+    GvcMv*                m_pcMv;                                 ///< motion vector of inter partitions
+    TCoeff*               m_pcTrCoeff[MAX_NUM_COMPONENT];         ///< quantized levels, each transform unit in raster order at the offset of its first partition
+    unsigned char*        m_puhCbf;                               ///< the luma transform unit holding the partition has non-zero levels
+
+    // RD results of the candidate held by this unit
+    double                m_dTotalCost;
+    unsigned long long    m_uiTotalDistortion;
+    unsigned int          m_uiTotalBits;
 
 public:
     GvcBlockUnit();
@@ -28,13 +47,68 @@ public:
     void          destroy                       ( );
 
     void          initBU                       ( GvcFrameUnit* pcPic, unsigned int ctuRsAddr );
+    void          initSubBU                    ( GvcBlockUnit* pcBU, unsigned int uiPartUnitIdx, unsigned int uiDepth );
+    /// same area as pcBU, a coding unit of uiDepth
+    void          initSameCU                   ( GvcBlockUnit* pcBU, unsigned int uiDepth );
+    void          initEstData                  ( unsigned int uiDepth );
+
+    /// copy the data of a sub unit (quadrant uiPartUnitIdx) into this unit, returns the number of bytes copied
+    unsigned int  copyPartFrom                 ( GvcBlockUnit* pcSubBU, unsigned int uiPartUnitIdx, unsigned int uiDepth );
+    /// copy this unit into the BU stored in the frame, returns the number of bytes copied
+    unsigned int  copyToFrame                  ( );
+    /// bytes of per partition data held by a unit with uiNumPartition partitions
+    static unsigned int getPartDataSize        ( unsigned int uiNumPartition, ChromaFormat chromaFormatIDC );
 
   GvcFrameUnit* getFrame                    ( )                                                          { return m_pcFrame;                            }
     unsigned int&         getCtuRsAddr                  ( )                                                          { return m_uiBUAddr;                        }
+    unsigned int          getZorderIdxInBU              ( )                                                   { return m_uiAbsIdxInBU;                     }
     unsigned int          getCUPelX                     ( )                                                   { return m_uiBUPelX;                         }
     unsigned int          getCUPelY                     ( )                                                     { return m_uiBUPelY;                         }
     unsigned int&         getTotalNumPart               ( )                                                          { return m_uiNumPartition;    }
+    unsigned int          getMaxWidth                   ( )                                                   { return m_uiMaxWidth;                       }
+    unsigned int          getMaxHeight                  ( )                                                   { return m_uiMaxHeight;                      }
+    ChromaFormat          getChromaFormat               ( )                                                   { return m_chromaFormatIDC;                  }
+
+    unsigned char*        getDepth                      ( )                                                   { return m_puhDepth;                         }
+    unsigned char         getDepth                      ( unsigned int uiIdx )                                { return m_puhDepth[uiIdx];                  }
+    void                  setDepthSubParts              ( unsigned int uiDepth, unsigned int uiAbsPartIdx );
+    unsigned int          getWidth                      ( unsigned int uiIdx )                                { return m_uiMaxWidth  >> m_puhDepth[uiIdx]; }
+    unsigned int          getHeight                     ( unsigned int uiIdx )                                { return m_uiMaxHeight >> m_puhDepth[uiIdx]; }
+
+    char*                 getPartitionSize              ( )                                                   { return m_pePartSize;                       }
+    PartSize              getPartitionSize              ( unsigned int uiIdx )                                { return static_cast<PartSize>( m_pePartSize[uiIdx] ); }
+    void                  setPartSizeSubParts           ( PartSize eMode, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+
+    char*                 getPredictionMode             ( )                                                   { return m_pePredMode;                       }
+    PredMode              getPredictionMode             ( unsigned int uiIdx )                                { return static_cast<PredMode>( m_pePredMode[uiIdx] ); }
+    void                  setPredModeSubParts           ( PredMode eMode, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+
+    unsigned char*        getIntraDir                   ( const ChannelType chType )                          { return m_puhIntraDir[chType];              }
+    unsigned char         getIntraDir                   ( const ChannelType chType, unsigned int uiIdx )      { return m_puhIntraDir[chType][uiIdx];       }
+    void                  setIntraDirSubParts           ( const ChannelType chType, unsigned int uiDir, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+    GvcMv*                getMv                         ( )                                                   { return m_pcMv;                             }
+    const GvcMv&          getMv                         ( unsigned int uiIdx )                                { return m_pcMv[uiIdx];                      }
+    void                  setMvSubParts                 ( const GvcMv& rcMv, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+    unsigned char*        getCbf                        ( )                                                   { return m_puhCbf;                           }
+    bool                  getCbf                        ( unsigned int uiIdx )                                { return m_puhCbf[uiIdx] != 0;               }
+    /// luma coded block flag of the transform unit at uiAbsPartIdx, a square of depth uiTUDepth below the BU size
+    void                  setCbfSubParts                ( bool bCbf, unsigned int uiAbsPartIdx, unsigned int uiTUDepth );
+    /// levels of the transform unit whose first partition is uiAbsPartIdx
+    TCoeff*               getCoeff                      ( const ComponentID compID, unsigned int uiAbsPartIdx );
+
+    /// most probable luma modes of the partition at uiAbsPartIdx, from the coded partitions at its left and above
+    void                  getIntraDirPredictor          ( unsigned int uiAbsPartIdx, int* piIntraDirPred );
+
+    /// BU (as stored in the frame) holding the partition at the left of uiCurrPartUnitIdx, NULL if it is not coded yet
+    /// or, unless bEnforceTileRestriction is false, lies in another tile
+    GvcBlockUnit*         getPULeft                     ( unsigned int& ruiLPartUnitIdx, unsigned int uiCurrPartUnitIdx, bool bEnforceTileRestriction = true );
+    /// BU (as stored in the frame) holding the partition above uiCurrPartUnitIdx, NULL if it is not coded yet
+    /// or, unless bEnforceTileRestriction is false, lies in another tile
+    GvcBlockUnit*         getPUAbove                    ( unsigned int& ruiAPartUnitIdx, unsigned int uiCurrPartUnitIdx, bool bEnforceTileRestriction = true );
+
+    double&               getTotalCost                  ( )                                                   { return m_dTotalCost;                       }
+    unsigned long long&   getTotalDistortion            ( )                                                   { return m_uiTotalDistortion;                }
+    unsigned int&         getTotalBits                  ( )                                                   { return m_uiTotalBits;                      }
 };
 
 #endif //GVC_GVCBLOCKUNIT_H
-
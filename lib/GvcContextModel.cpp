@@ -0,0 +1,160 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcContextModel.cpp
+ * \brief    Adaptive probability model of the binary arithmetic coder
+ */
+
+#include "GvcContextModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * The initialization value holds a slope (4 most significant bits) and an offset (4 least significant
+ * bits) of a linear function of the QP, its result 1..126 is split into the probability state and the
+ * most probable symbol.
+ */
+void GvcContextModel::init( int iQp, int iInitValue )
+{
+	iQp = Clip3( 0, 51, iQp );
+	const int iSlope = ( iInitValue >> 4 ) * 5 - 45;
+	const int iOffset = ( ( iInitValue & 15 ) << 3 ) - 16;
+	const int iInitState = std::min( std::max( 1, ( ( iSlope * iQp ) >> 4 ) + iOffset ), 126 );
+	const int iMpState = iInitState >= 64;
+	m_ucState = (unsigned char)( ( ( iMpState ? ( iInitState - 64 ) : ( 63 - iInitState ) ) << 1 ) + iMpState );
+}
+
+const unsigned char GvcContextModel::s_aucLPSTable[64][4] =
+{
+	{ 128, 176, 208, 240 },
+	{ 128, 167, 197, 227 },
+	{ 128, 158, 187, 216 },
+	{ 123, 150, 178, 205 },
+	{ 116, 142, 169, 195 },
+	{ 111, 135, 160, 185 },
+	{ 105, 128, 152, 175 },
+	{ 100, 122, 144, 166 },
+	{  95, 116, 137, 158 },
+	{  90, 110, 130, 150 },
+	{  85, 104, 123, 142 },
+	{  81,  99, 117, 135 },
+	{  77,  94, 111, 128 },
+	{  73,  89, 105, 122 },
+	{  69,  85, 100, 116 },
+	{  66,  80,  95, 110 },
+	{  62,  76,  90, 104 },
+	{  59,  72,  86,  99 },
+	{  56,  69,  81,  94 },
+	{  53,  65,  77,  89 },
+	{  51,  62,  73,  85 },
+	{  48,  59,  69,  80 },
+	{  46,  56,  66,  76 },
+	{  43,  53,  63,  72 },
+	{  41,  50,  59,  69 },
+	{  39,  48,  56,  65 },
+	{  37,  45,  54,  62 },
+	{  35,  43,  51,  59 },
+	{  33,  41,  48,  56 },
+	{  32,  39,  46,  53 },
+	{  30,  37,  43,  50 },
+	{  29,  35,  41,  48 },
+	{  27,  33,  39,  45 },
+	{  26,  31,  37,  43 },
+	{  24,  30,  35,  41 },
+	{  23,  28,  33,  39 },
+	{  22,  27,  32,  37 },
+	{  21,  26,  30,  35 },
+	{  20,  24,  29,  33 },
+	{  19,  23,  27,  31 },
+	{  18,  22,  26,  30 },
+	{  17,  21,  25,  28 },
+	{  16,  20,  23,  27 },
+	{  15,  19,  22,  25 },
+	{  14,  18,  21,  24 },
+	{  14,  17,  20,  23 },
+	{  13,  16,  19,  22 },
+	{  12,  15,  18,  21 },
+	{  12,  14,  17,  20 },
+	{  11,  14,  16,  19 },
+	{  11,  13,  15,  18 },
+	{  10,  12,  15,  17 },
+	{  10,  12,  14,  16 },
+	{   9,  11,  13,  15 },
+	{   9,  11,  12,  14 },
+	{   8,  10,  12,  14 },
+	{   8,   9,  11,  13 },
+	{   7,   9,  11,  12 },
+	{   7,   9,  10,  12 },
+	{   7,   8,  10,  11 },
+	{   6,   8,   9,  11 },
+	{   6,   7,   9,  10 },
+	{   6,   7,   8,   9 },
+	{   2,   2,   2,   2 },
+};
+
+const unsigned char GvcContextModel::s_aucRenormTable[32] =
+{
+	6, 5, 4, 4, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+// the state moves towards the least probable symbol by one step after an MPS, last state kept
+const unsigned char GvcContextModel::s_aucNextStateMPS[128] =
+{
+	  2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,  16,  17,
+	 18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,  32,  33,
+	 34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,
+	 50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  65,
+	 66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,  80,  81,
+	 82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,  96,  97,
+	 98,  99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113,
+	114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 124, 125, 126, 127,
+};
+
+// the most probable symbol flips after an LPS in the equiprobable state
+const unsigned char GvcContextModel::s_aucNextStateLPS[128] =
+{
+	  1,   0,   0,   1,   2,   3,   4,   5,   4,   5,   8,   9,   8,   9,  10,  11,
+	 12,  13,  14,  15,  16,  17,  18,  19,  18,  19,  22,  23,  22,  23,  24,  25,
+	 26,  27,  26,  27,  30,  31,  30,  31,  32,  33,  32,  33,  36,  37,  36,  37,
+	 38,  39,  38,  39,  42,  43,  42,  43,  44,  45,  44,  45,  46,  47,  48,  49,
+	 48,  49,  50,  51,  52,  53,  52,  53,  54,  55,  54,  55,  56,  57,  58,  59,
+	 58,  59,  60,  61,  60,  61,  60,  61,  62,  63,  64,  65,  64,  65,  66,  67,
+	 66,  67,  66,  67,  68,  69,  68,  69,  70,  71,  70,  71,  70,  71,  72,  73,
+	 72,  73,  72,  73,  74,  75,  74,  75,  74,  75,  76,  77,  76,  77, 126, 127,
+};
+
+/** The LPS probability of state s is 0.5 * a^s, with a chosen so that state 63 is at 0.01875.
+ */
+int GvcContextModel::s_aiEntropyBits[128];
+
+static struct EntropyBitsInit
+{
+	EntropyBitsInit()
+	{
+		for( int iState = 0; iState < 64; iState++ )
+		{
+			const double dProbLPS = 0.5 * pow( 0.01875 / 0.5, iState / 63.0 );
+			GvcContextModel::s_aiEntropyBits[2 * iState] = (int)( -log2( 1.0 - dProbLPS ) * ( 1 << FRAC_BITS_SCALE ) + 0.5 );
+			GvcContextModel::s_aiEntropyBits[2 * iState + 1] = (int)( -log2( dProbLPS ) * ( 1 << FRAC_BITS_SCALE ) + 0.5 );
+		}
+	}
+} s_cEntropyBitsInit;
@@ -0,0 +1,65 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcContextModel.h
+ * \brief    Adaptive probability model of the binary arithmetic coder
+ */
+
+#ifndef __GVCCONTEXTMODEL_H__
+#define __GVCCONTEXTMODEL_H__
+
+#include "TypeDef.h"
+
+/**
+ * \class    GvcContextModel
+ * \brief    Probability state (64 LPS probabilities) and most probable symbol, packed in one byte
+ */
+class GvcContextModel
+{
+	unsigned char m_ucState;  ///< (probability state << 1) + most probable symbol
+
+	static const unsigned char s_aucNextStateMPS[128];
+	static const unsigned char s_aucNextStateLPS[128];
+
+  public:
+	GvcContextModel() : m_ucState( 0 ) {}
+
+	/// state of a model with initialization value iInitValue at the quantization parameter iQp
+	void init( int iQp, int iInitValue );
+
+	unsigned char getState() const { return m_ucState >> 1; }
+	unsigned char getMps() const { return m_ucState & 1; }
+
+	void updateLPS() { m_ucState = s_aucNextStateLPS[m_ucState]; }
+	void updateMPS() { m_ucState = s_aucNextStateMPS[m_ucState]; }
+	void update( unsigned int uiBin ) { m_ucState = uiBin == getMps() ? s_aucNextStateMPS[m_ucState] : s_aucNextStateLPS[m_ucState]; }
+
+	/// estimated rate of coding uiBin with the current state, in 1 / 32768 bit
+	int getEntropyBits( unsigned int uiBin ) const { return s_aiEntropyBits[m_ucState ^ uiBin]; }
+
+	/// LPS range per probability state and quantized range (bits 7 and 6 of the current range)
+	static const unsigned char s_aucLPSTable[64][4];
+	/// renormalization shift after an LPS, indexed by the LPS range >> 3
+	static const unsigned char s_aucRenormTable[32];
+	/// rate of the MPS (even entries) and of the LPS (odd entries) per state, 1 / 32768 bit
+	static int s_aiEntropyBits[128];
+};
+
+#endif  // __GVCCONTEXTMODEL_H__
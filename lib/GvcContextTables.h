@@ -0,0 +1,167 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcContextTables.h
+ * \brief    Context models of the syntax elements: number and initialization values
+ */
+
+#ifndef __GVCCONTEXTTABLES_H__
+#define __GVCCONTEXTTABLES_H__
+
+#include "TypeDef.h"
+
+// ====================================================================================================================
+// Constants
+// ====================================================================================================================
+
+#define NUM_SPLIT_FLAG_CTX            3       ///< number of context models for the split flag
+#define NUM_PRED_MODE_CTX             1       ///< number of context models for the prediction mode flag
+#define NUM_INTRA_PREDICT_CTX         1       ///< number of context models for the luma most probable mode flag
+#define NUM_CHROMA_PRED_CTX           1       ///< number of context models for the chroma mode
+#define NUM_MV_RES_CTX                2       ///< number of context models for the vector difference greater than 0/1 flags
+#define NUM_SAO_MERGE_FLAG_CTX        1       ///< number of context models for the SAO merge flags
+#define NUM_SAO_TYPE_IDX_CTX          1       ///< number of context models for the first bin of the SAO type
+
+#define NUM_QT_CBF_CTX_PER_SET        5       ///< number of context models for the coded block flag, per channel type
+
+#define NUM_SIG_CG_FLAG_CTX           2       ///< number of context models for the coefficient group flag, per channel type
+
+#define NUM_SIG_FLAG_CTX_LUMA        27       ///< number of context models for the luma significance flag
+#define NUM_SIG_FLAG_CTX_CHROMA      15       ///< number of context models for the chroma significance flag
+#define NUM_SIG_FLAG_CTX             NUM_SIG_FLAG_CTX_LUMA
+
+#define NUM_CTX_LAST_FLAG_XY         15       ///< number of context models for the last position prefix, per channel type
+
+#define NUM_ONE_FLAG_CTX_LUMA        16       ///< number of context models for greater than 1 flag of luma
+#define NUM_ONE_FLAG_CTX_CHROMA       8       ///< number of context models for greater than 1 flag of chroma
+#define NUM_ONE_FLAG_CTX             NUM_ONE_FLAG_CTX_LUMA
+
+#define NUM_ABS_FLAG_CTX_LUMA         4       ///< number of context models for greater than 2 flag of luma
+#define NUM_ABS_FLAG_CTX_CHROMA       2       ///< number of context models for greater than 2 flag of chroma
+#define NUM_ABS_FLAG_CTX             NUM_ABS_FLAG_CTX_LUMA
+
+// significance map context sets: 4x4, 8x8 and larger blocks
+static const unsigned int significanceMapContextSetStart[2][3] = { { 0, 9, 21 }, { 0, 9, 12 } };
+static const unsigned int nonDiagonalScan8x8ContextOffset[2] = { 6, 0 };
+static const unsigned int notFirstGroupNeighbourhoodContextOffset[2] = { 3, 0 };
+
+// ====================================================================================================================
+// Initialization values, per frame type (P, I)
+// ====================================================================================================================
+
+#define CNU                         154       ///< equiprobable initialization
+
+static const unsigned char INIT_SPLIT_FLAG[NUMBER_OF_FRAME_TYPES][NUM_SPLIT_FLAG_CTX] =
+{
+  { 107, 139, 126 },
+  { 139, 141, 157 },
+};
+
+static const unsigned char INIT_PRED_MODE[NUMBER_OF_FRAME_TYPES][NUM_PRED_MODE_CTX] =
+{
+  { 149 },
+  { CNU },
+};
+
+static const unsigned char INIT_INTRA_PRED_MODE[NUMBER_OF_FRAME_TYPES][NUM_INTRA_PREDICT_CTX] =
+{
+  { 154 },
+  { 184 },
+};
+
+static const unsigned char INIT_CHROMA_PRED_MODE[NUMBER_OF_FRAME_TYPES][NUM_CHROMA_PRED_CTX] =
+{
+  { 152 },
+  {  63 },
+};
+
+static const unsigned char INIT_MVD[NUMBER_OF_FRAME_TYPES][NUM_MV_RES_CTX] =
+{
+  { 140, 198 },
+  { CNU, CNU },
+};
+
+static const unsigned char INIT_SAO_MERGE_FLAG[NUMBER_OF_FRAME_TYPES][NUM_SAO_MERGE_FLAG_CTX] =
+{
+  { 153 },
+  { 153 },
+};
+
+static const unsigned char INIT_SAO_TYPE_IDX[NUMBER_OF_FRAME_TYPES][NUM_SAO_TYPE_IDX_CTX] =
+{
+  { 185 },
+  { 200 },
+};
+
+static const unsigned char INIT_QT_CBF[NUMBER_OF_FRAME_TYPES][MAX_NUM_CHANNEL_TYPE][NUM_QT_CBF_CTX_PER_SET] =
+{
+  { { 153, 111, CNU, CNU, CNU }, { 149, 107, 167, 154, 154 } },
+  { { 111, 141, CNU, CNU, CNU }, {  94, 138, 182, 154, 154 } },
+};
+
+static const unsigned char INIT_SIG_CG_FLAG[NUMBER_OF_FRAME_TYPES][MAX_NUM_CHANNEL_TYPE][NUM_SIG_CG_FLAG_CTX] =
+{
+  { { 121, 140 }, {  61, 154 } },
+  { {  91, 171 }, { 134, 141 } },
+};
+
+static const unsigned char INIT_SIG_FLAG[NUMBER_OF_FRAME_TYPES][MAX_NUM_CHANNEL_TYPE][NUM_SIG_FLAG_CTX] =
+{
+  {
+    { 155, 154, 139, 153, 139, 123, 123,  63, 153, 166, 183, 140, 136, 153, 154, 166, 183, 140, 136, 153, 154, 166, 183, 140, 136, 153, 154 },
+    { 170, 153, 123, 123, 107, 121, 107, 121, 167, 151, 183, 140, 151, 183, 140, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU },
+  },
+  {
+    { 111, 111, 125, 110, 110,  94, 124, 108, 124, 107, 125, 141, 179, 153, 125, 107, 125, 141, 179, 153, 125, 107, 125, 141, 179, 153, 125 },
+    { 140, 139, 182, 182, 152, 136, 152, 136, 153, 136, 139, 111, 136, 139, 111, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU },
+  },
+};
+
+static const unsigned char INIT_LAST[NUMBER_OF_FRAME_TYPES][MAX_NUM_CHANNEL_TYPE][NUM_CTX_LAST_FLAG_XY] =
+{
+  {
+    { 125, 110,  94, 110,  95,  79, 125, 111, 110,  78, 110, 111, 111,  95,  94 },
+    { 108, 123, 108, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU },
+  },
+  {
+    { 110, 110, 124, 125, 140, 153, 125, 127, 140, 109, 111, 143, 127, 111,  79 },
+    { 108, 123,  63, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU },
+  },
+};
+
+static const unsigned char INIT_ONE_FLAG[NUMBER_OF_FRAME_TYPES][MAX_NUM_CHANNEL_TYPE][NUM_ONE_FLAG_CTX] =
+{
+  {
+    { 154, 196, 196, 167, 154, 152, 167, 182, 182, 134, 149, 136, 153, 121, 136, 137 },
+    { 169, 194, 166, 167, 154, 167, 137, 182, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU },
+  },
+  {
+    { 140,  92, 137, 138, 140, 152, 138, 139, 153,  74, 149,  92, 139, 107, 122, 152 },
+    { 140, 179, 166, 182, 140, 227, 122, 197, CNU, CNU, CNU, CNU, CNU, CNU, CNU, CNU },
+  },
+};
+
+static const unsigned char INIT_ABS_FLAG[NUMBER_OF_FRAME_TYPES][MAX_NUM_CHANNEL_TYPE][NUM_ABS_FLAG_CTX] =
+{
+  { { 107, 167,  91, 122 }, { 107, 167, CNU, CNU } },
+  { { 138, 153, 136, 167 }, { 152, 152, CNU, CNU } },
+};
+
+#endif  // __GVCCONTEXTTABLES_H__
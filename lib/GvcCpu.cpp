@@ -0,0 +1,89 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcCpu.cpp
+ * \brief    Detection of the instruction sets available at run time
+ */
+
+#include "GvcCpu.h"
+
+#include "config.h"
+
+#if defined( GVC_ENABLE_SIMD )
+#include <cpuid.h>
+
+static unsigned long long xGetXCR0()
+{
+	unsigned int uiEax, uiEdx;
+	__asm__ volatile( "xgetbv" : "=a"( uiEax ), "=d"( uiEdx ) : "c"( 0 ) );
+	return ( (unsigned long long)uiEdx << 32 ) | uiEax;
+}
+#endif
+
+GvcCpuLevel gvcDetectCpuLevel()
+{
+	GvcCpuLevel eLevel = GVC_CPU_C;
+#if defined( GVC_ENABLE_SIMD )
+	unsigned int uiEax, uiEbx, uiEcx, uiEdx;
+	if( !__get_cpuid( 1, &uiEax, &uiEbx, &uiEcx, &uiEdx ) )
+	{
+		return eLevel;
+	}
+	if( !( uiEcx & bit_SSE4_1 ) )
+	{
+		return eLevel;
+	}
+	eLevel = GVC_CPU_SSE41;
+
+	// AVX state must be enabled by the operating system (OSXSAVE + XMM/YMM in XCR0)
+	const bool bOSXSave = ( uiEcx & bit_OSXSAVE ) != 0;
+	if( !bOSXSave || !( uiEcx & bit_AVX ) || ( xGetXCR0() & 0x6 ) != 0x6 )
+	{
+		return eLevel;
+	}
+	if( !__get_cpuid_count( 7, 0, &uiEax, &uiEbx, &uiEcx, &uiEdx ) )
+	{
+		return eLevel;
+	}
+	if( !( uiEbx & bit_AVX2 ) )
+	{
+		return eLevel;
+	}
+	eLevel = GVC_CPU_AVX2;
+
+	// AVX-512 additionally needs the opmask and ZMM state (XCR0 bits 5-7)
+	if( ( uiEbx & bit_AVX512F ) && ( uiEbx & bit_AVX512BW ) && ( xGetXCR0() & 0xE6 ) == 0xE6 )
+	{
+		eLevel = GVC_CPU_AVX512;
+	}
+#endif
+	return eLevel;
+}
+
+const char* gvcCpuLevelName( GvcCpuLevel eLevel )
+{
+	switch( eLevel )
+	{
+	case GVC_CPU_SSE41: return "SSE4.1";
+	case GVC_CPU_AVX2: return "AVX2";
+	case GVC_CPU_AVX512: return "AVX-512";
+	default: return "C";
+	}
+}
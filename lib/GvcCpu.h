@@ -0,0 +1,42 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcCpu.h
+ * \brief    Detection of the instruction sets available at run time
+ */
+
+#ifndef __GVCCPU_H__
+#define __GVCCPU_H__
+
+/// instruction set levels used to select the primitives
+enum GvcCpuLevel
+{
+	GVC_CPU_C = 0,       ///< portable C++ only
+	GVC_CPU_SSE41 = 1,   ///< SSE4.1
+	GVC_CPU_AVX2 = 2,    ///< AVX2
+	GVC_CPU_AVX512 = 3,  ///< AVX-512 F + BW
+	NUM_GVC_CPU_LEVELS = 4
+};
+
+/// highest level supported by both the processor and the operating system
+GvcCpuLevel gvcDetectCpuLevel();
+const char* gvcCpuLevelName( GvcCpuLevel eLevel );
+
+#endif  // __GVCCPU_H__
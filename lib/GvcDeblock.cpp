@@ -0,0 +1,134 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcDeblock.cpp
+ * \brief    Reference C++ implementation of the deblocking edge filters
+ */
+
+#include <cstdlib>
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+/// strong filter decision of one line, iD is twice the second derivative sum of the line
+inline bool useStrongFilter( const short* pSrc, int iOffset, int iD, int iBeta, int iTc )
+{
+	const int p0 = pSrc[-iOffset];
+	const int p3 = pSrc[-4 * iOffset];
+	const int q0 = pSrc[0];
+	const int q3 = pSrc[3 * iOffset];
+	return iD < ( iBeta >> 2 ) && ( std::abs( p3 - p0 ) + std::abs( q0 - q3 ) ) < ( iBeta >> 3 ) && std::abs( p0 - q0 ) < ( ( iTc * 5 + 1 ) >> 1 );
+}
+
+template<int iDir>
+void deblockLuma_c( short* pSrc, int iStride, int iTc, int iBeta, int iBitDepth )
+{
+	const int iOffset = iDir == EDGE_VER ? 1 : iStride;
+	const int iStep = iDir == EDGE_VER ? iStride : 1;
+	short* pLine3 = pSrc + 3 * iStep;
+
+	// the first and the last line decide for the segment
+	const int iDp0 = std::abs( pSrc[-3 * iOffset] - 2 * pSrc[-2 * iOffset] + pSrc[-iOffset] );
+	const int iDq0 = std::abs( pSrc[2 * iOffset] - 2 * pSrc[iOffset] + pSrc[0] );
+	const int iDp3 = std::abs( pLine3[-3 * iOffset] - 2 * pLine3[-2 * iOffset] + pLine3[-iOffset] );
+	const int iDq3 = std::abs( pLine3[2 * iOffset] - 2 * pLine3[iOffset] + pLine3[0] );
+	const int iD0 = iDp0 + iDq0;
+	const int iD3 = iDp3 + iDq3;
+	if( iD0 + iD3 >= iBeta )
+	{
+		return;
+	}
+	const bool bStrong = useStrongFilter( pSrc, iOffset, 2 * iD0, iBeta, iTc ) && useStrongFilter( pLine3, iOffset, 2 * iD3, iBeta, iTc );
+	const int iSideThreshold = ( iBeta + ( iBeta >> 1 ) ) >> 3;
+	const bool bFilterP = iDp0 + iDp3 < iSideThreshold;
+	const bool bFilterQ = iDq0 + iDq3 < iSideThreshold;
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+
+	for( int i = 0; i < 4; i++ )
+	{
+		short* p = pSrc + i * iStep;
+		const int p0 = p[-iOffset];
+		const int p1 = p[-2 * iOffset];
+		const int p2 = p[-3 * iOffset];
+		const int q0 = p[0];
+		const int q1 = p[iOffset];
+		const int q2 = p[2 * iOffset];
+		if( bStrong )
+		{
+			const int p3 = p[-4 * iOffset];
+			const int q3 = p[3 * iOffset];
+			const int iTc2 = 2 * iTc;
+			p[-iOffset] = (short)Clip3( p0 - iTc2, p0 + iTc2, ( p2 + 2 * p1 + 2 * p0 + 2 * q0 + q1 + 4 ) >> 3 );
+			p[-2 * iOffset] = (short)Clip3( p1 - iTc2, p1 + iTc2, ( p2 + p1 + p0 + q0 + 2 ) >> 2 );
+			p[-3 * iOffset] = (short)Clip3( p2 - iTc2, p2 + iTc2, ( 2 * p3 + 3 * p2 + p1 + p0 + q0 + 4 ) >> 3 );
+			p[0] = (short)Clip3( q0 - iTc2, q0 + iTc2, ( p1 + 2 * p0 + 2 * q0 + 2 * q1 + q2 + 4 ) >> 3 );
+			p[iOffset] = (short)Clip3( q1 - iTc2, q1 + iTc2, ( p0 + q0 + q1 + q2 + 2 ) >> 2 );
+			p[2 * iOffset] = (short)Clip3( q2 - iTc2, q2 + iTc2, ( p0 + q0 + q1 + 3 * q2 + 2 * q3 + 4 ) >> 3 );
+			continue;
+		}
+		int iDelta = ( 9 * ( q0 - p0 ) - 3 * ( q1 - p1 ) + 8 ) >> 4;
+		if( std::abs( iDelta ) >= iTc * 10 )
+		{
+			continue;
+		}
+		iDelta = Clip3( -iTc, iTc, iDelta );
+		p[-iOffset] = (short)Clip3( 0, iMaxVal, p0 + iDelta );
+		p[0] = (short)Clip3( 0, iMaxVal, q0 - iDelta );
+		if( bFilterP )
+		{
+			const int iDeltaP = Clip3( -( iTc >> 1 ), iTc >> 1, ( ( ( p2 + p0 + 1 ) >> 1 ) - p1 + iDelta ) >> 1 );
+			p[-2 * iOffset] = (short)Clip3( 0, iMaxVal, p1 + iDeltaP );
+		}
+		if( bFilterQ )
+		{
+			const int iDeltaQ = Clip3( -( iTc >> 1 ), iTc >> 1, ( ( ( q2 + q0 + 1 ) >> 1 ) - q1 - iDelta ) >> 1 );
+			p[iOffset] = (short)Clip3( 0, iMaxVal, q1 + iDeltaQ );
+		}
+	}
+}
+
+template<int iDir>
+void deblockChroma_c( short* pSrc, int iStride, int iTc, int iNumLines, int iBitDepth )
+{
+	const int iOffset = iDir == EDGE_VER ? 1 : iStride;
+	const int iStep = iDir == EDGE_VER ? iStride : 1;
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	for( int i = 0; i < iNumLines; i++ )
+	{
+		short* p = pSrc + i * iStep;
+		const int p0 = p[-iOffset];
+		const int p1 = p[-2 * iOffset];
+		const int q0 = p[0];
+		const int q1 = p[iOffset];
+		const int iDelta = Clip3( -iTc, iTc, ( 4 * ( q0 - p0 ) + p1 - q1 + 4 ) >> 3 );
+		p[-iOffset] = (short)Clip3( 0, iMaxVal, p0 + iDelta );
+		p[0] = (short)Clip3( 0, iMaxVal, q0 - iDelta );
+	}
+}
+}  // namespace
+
+void setupDeblockPrimitivesC( GvcPrimitives& p )
+{
+	p.deblockLuma[EDGE_VER] = deblockLuma_c<EDGE_VER>;
+	p.deblockLuma[EDGE_HOR] = deblockLuma_c<EDGE_HOR>;
+	p.deblockChroma[EDGE_VER] = deblockChroma_c<EDGE_VER>;
+	p.deblockChroma[EDGE_HOR] = deblockChroma_c<EDGE_HOR>;
+}
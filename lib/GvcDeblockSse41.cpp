@@ -0,0 +1,301 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcDeblockSse41.cpp
+ * \brief    SSE4.1 implementation of the deblocking edge filters
+ *
+ * The lines of an edge segment are processed side by side, one per lane. Along a horizontal edge a row of the
+ * segment is one load; along a vertical edge each line is loaded whole and the block is transposed.
+ */
+
+#include <cstring>
+#include <smmintrin.h>
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+/// four lines of 8 samples (p3 to q3) into the halves of four registers: {p3, p2}, {p1, p0}, {q0, q1}, {q2, q3}
+inline void transpose4x8( __m128i& r0, __m128i& r1, __m128i& r2, __m128i& r3 )
+{
+	const __m128i t0 = _mm_unpacklo_epi16( r0, r1 );
+	const __m128i t1 = _mm_unpacklo_epi16( r2, r3 );
+	const __m128i t2 = _mm_unpackhi_epi16( r0, r1 );
+	const __m128i t3 = _mm_unpackhi_epi16( r2, r3 );
+	r0 = _mm_unpacklo_epi32( t0, t1 );
+	r1 = _mm_unpackhi_epi32( t0, t1 );
+	r2 = _mm_unpacklo_epi32( t2, t3 );
+	r3 = _mm_unpackhi_epi32( t2, t3 );
+}
+
+/// inverse of transpose4x8
+inline void transpose8x4( __m128i& r0, __m128i& r1, __m128i& r2, __m128i& r3 )
+{
+	const __m128i t0 = _mm_unpacklo_epi16( r0, _mm_srli_si128( r0, 8 ) );
+	const __m128i t1 = _mm_unpacklo_epi16( r1, _mm_srli_si128( r1, 8 ) );
+	const __m128i t2 = _mm_unpacklo_epi16( r2, _mm_srli_si128( r2, 8 ) );
+	const __m128i t3 = _mm_unpacklo_epi16( r3, _mm_srli_si128( r3, 8 ) );
+	const __m128i t4 = _mm_unpacklo_epi32( t0, t1 );
+	const __m128i t5 = _mm_unpackhi_epi32( t0, t1 );
+	const __m128i t6 = _mm_unpacklo_epi32( t2, t3 );
+	const __m128i t7 = _mm_unpackhi_epi32( t2, t3 );
+	r0 = _mm_unpacklo_epi64( t4, t6 );
+	r1 = _mm_unpackhi_epi64( t4, t6 );
+	r2 = _mm_unpacklo_epi64( t5, t7 );
+	r3 = _mm_unpackhi_epi64( t5, t7 );
+}
+
+inline __m128i clip3( __m128i vMin, __m128i vMax, __m128i v )
+{
+	return _mm_min_epi32( _mm_max_epi32( v, vMin ), vMax );
+}
+
+/// 32-bit lanes, 12-bit samples make 9 * ( q0 - p0 ) overflow 16 bits
+template<int iDir>
+void deblockLuma_sse41( short* pSrc, int iStride, int iTc, int iBeta, int iBitDepth )
+{
+	__m128i vP3, vP2, vP1, vP0, vQ0, vQ1, vQ2, vQ3;
+	if( iDir == EDGE_VER )
+	{
+		__m128i r0 = _mm_loadu_si128( (const __m128i*)( pSrc - 4 ) );
+		__m128i r1 = _mm_loadu_si128( (const __m128i*)( pSrc + iStride - 4 ) );
+		__m128i r2 = _mm_loadu_si128( (const __m128i*)( pSrc + 2 * iStride - 4 ) );
+		__m128i r3 = _mm_loadu_si128( (const __m128i*)( pSrc + 3 * iStride - 4 ) );
+		transpose4x8( r0, r1, r2, r3 );
+		vP3 = _mm_cvtepi16_epi32( r0 );
+		vP2 = _mm_cvtepi16_epi32( _mm_srli_si128( r0, 8 ) );
+		vP1 = _mm_cvtepi16_epi32( r1 );
+		vP0 = _mm_cvtepi16_epi32( _mm_srli_si128( r1, 8 ) );
+		vQ0 = _mm_cvtepi16_epi32( r2 );
+		vQ1 = _mm_cvtepi16_epi32( _mm_srli_si128( r2, 8 ) );
+		vQ2 = _mm_cvtepi16_epi32( r3 );
+		vQ3 = _mm_cvtepi16_epi32( _mm_srli_si128( r3, 8 ) );
+	}
+	else
+	{
+		vP3 = _mm_cvtepi16_epi32( _mm_loadl_epi64( (const __m128i*)( pSrc - 4 * iStride ) ) );
+		vP2 = _mm_cvtepi16_epi32( _mm_loadl_epi64( (const __m128i*)( pSrc - 3 * iStride ) ) );
+		vP1 = _mm_cvtepi16_epi32( _mm_loadl_epi64( (const __m128i*)( pSrc - 2 * iStride ) ) );
+		vP0 = _mm_cvtepi16_epi32( _mm_loadl_epi64( (const __m128i*)( pSrc - iStride ) ) );
+		vQ0 = _mm_cvtepi16_epi32( _mm_loadl_epi64( (const __m128i*)( pSrc ) ) );
+		vQ1 = _mm_cvtepi16_epi32( _mm_loadl_epi64( (const __m128i*)( pSrc + iStride ) ) );
+		vQ2 = _mm_cvtepi16_epi32( _mm_loadl_epi64( (const __m128i*)( pSrc + 2 * iStride ) ) );
+		vQ3 = _mm_cvtepi16_epi32( _mm_loadl_epi64( (const __m128i*)( pSrc + 3 * iStride ) ) );
+	}
+
+	// second derivatives of every line, lanes 0 and 3 decide for the segment
+	const __m128i vDp = _mm_abs_epi32( _mm_add_epi32( _mm_sub_epi32( vP2, _mm_add_epi32( vP1, vP1 ) ), vP0 ) );
+	const __m128i vDq = _mm_abs_epi32( _mm_add_epi32( _mm_sub_epi32( vQ2, _mm_add_epi32( vQ1, vQ1 ) ), vQ0 ) );
+	const int iDp0 = _mm_extract_epi32( vDp, 0 );
+	const int iDp3 = _mm_extract_epi32( vDp, 3 );
+	const int iDq0 = _mm_extract_epi32( vDq, 0 );
+	const int iDq3 = _mm_extract_epi32( vDq, 3 );
+	const int iD0 = iDp0 + iDq0;
+	const int iD3 = iDp3 + iDq3;
+	if( iD0 + iD3 >= iBeta )
+	{
+		return;
+	}
+	const __m128i vFlat = _mm_add_epi32( _mm_abs_epi32( _mm_sub_epi32( vP3, vP0 ) ), _mm_abs_epi32( _mm_sub_epi32( vQ0, vQ3 ) ) );
+	const __m128i vStep = _mm_abs_epi32( _mm_sub_epi32( vP0, vQ0 ) );
+	const int iStepThreshold = ( iTc * 5 + 1 ) >> 1;
+	const bool bStrong = 2 * iD0 < ( iBeta >> 2 ) && 2 * iD3 < ( iBeta >> 2 ) && _mm_extract_epi32( vFlat, 0 ) < ( iBeta >> 3 ) &&
+						 _mm_extract_epi32( vFlat, 3 ) < ( iBeta >> 3 ) && _mm_extract_epi32( vStep, 0 ) < iStepThreshold &&
+						 _mm_extract_epi32( vStep, 3 ) < iStepThreshold;
+
+	if( bStrong )
+	{
+		const __m128i vTc2 = _mm_set1_epi32( 2 * iTc );
+		const __m128i vFour = _mm_set1_epi32( 4 );
+		const __m128i vTwo = _mm_set1_epi32( 2 );
+		const __m128i vP0Q0 = _mm_add_epi32( vP0, vQ0 );
+		// p2 + 2 * p1 + 2 * p0 + 2 * q0 + q1 + 4
+		__m128i vSum = _mm_add_epi32( _mm_add_epi32( vP2, vQ1 ), _mm_slli_epi32( _mm_add_epi32( vP1, vP0Q0 ), 1 ) );
+		const __m128i vNewP0 = clip3( _mm_sub_epi32( vP0, vTc2 ), _mm_add_epi32( vP0, vTc2 ), _mm_srai_epi32( _mm_add_epi32( vSum, vFour ), 3 ) );
+		vSum = _mm_add_epi32( _mm_add_epi32( vQ2, vP1 ), _mm_slli_epi32( _mm_add_epi32( vQ1, vP0Q0 ), 1 ) );
+		const __m128i vNewQ0 = clip3( _mm_sub_epi32( vQ0, vTc2 ), _mm_add_epi32( vQ0, vTc2 ), _mm_srai_epi32( _mm_add_epi32( vSum, vFour ), 3 ) );
+		// p2 + p1 + p0 + q0 + 2
+		vSum = _mm_add_epi32( _mm_add_epi32( vP2, vP1 ), vP0Q0 );
+		const __m128i vNewP1 = clip3( _mm_sub_epi32( vP1, vTc2 ), _mm_add_epi32( vP1, vTc2 ), _mm_srai_epi32( _mm_add_epi32( vSum, vTwo ), 2 ) );
+		// 2 * p3 + 3 * p2 + p1 + p0 + q0 + 4
+		vSum = _mm_add_epi32( _mm_add_epi32( vSum, _mm_slli_epi32( _mm_add_epi32( vP3, vP2 ), 1 ) ), vFour );
+		const __m128i vNewP2 = clip3( _mm_sub_epi32( vP2, vTc2 ), _mm_add_epi32( vP2, vTc2 ), _mm_srai_epi32( vSum, 3 ) );
+		vSum = _mm_add_epi32( _mm_add_epi32( vQ2, vQ1 ), vP0Q0 );
+		const __m128i vNewQ1 = clip3( _mm_sub_epi32( vQ1, vTc2 ), _mm_add_epi32( vQ1, vTc2 ), _mm_srai_epi32( _mm_add_epi32( vSum, vTwo ), 2 ) );
+		vSum = _mm_add_epi32( _mm_add_epi32( vSum, _mm_slli_epi32( _mm_add_epi32( vQ3, vQ2 ), 1 ) ), vFour );
+		const __m128i vNewQ2 = clip3( _mm_sub_epi32( vQ2, vTc2 ), _mm_add_epi32( vQ2, vTc2 ), _mm_srai_epi32( vSum, 3 ) );
+		vP2 = vNewP2;
+		vP1 = vNewP1;
+		vP0 = vNewP0;
+		vQ0 = vNewQ0;
+		vQ1 = vNewQ1;
+		vQ2 = vNewQ2;
+	}
+	else
+	{
+		const int iSideThreshold = ( iBeta + ( iBeta >> 1 ) ) >> 3;
+		const __m128i vZero = _mm_setzero_si128();
+		const __m128i vMaxVal = _mm_set1_epi32( ( 1 << iBitDepth ) - 1 );
+		const __m128i vTc = _mm_set1_epi32( iTc );
+		const __m128i vMinusTc = _mm_set1_epi32( -iTc );
+		// 9 * ( q0 - p0 ) - 3 * ( q1 - p1 ) + 8
+		const __m128i vDiff0 = _mm_sub_epi32( vQ0, vP0 );
+		const __m128i vDiff1 = _mm_sub_epi32( vQ1, vP1 );
+		__m128i vDelta = _mm_add_epi32( _mm_sub_epi32( _mm_add_epi32( _mm_slli_epi32( vDiff0, 3 ), vDiff0 ), _mm_add_epi32( _mm_add_epi32( vDiff1, vDiff1 ), vDiff1 ) ),
+										_mm_set1_epi32( 8 ) );
+		vDelta = _mm_srai_epi32( vDelta, 4 );
+		// lines with a large step are left alone
+		const __m128i vFilter = _mm_cmplt_epi32( _mm_abs_epi32( vDelta ), _mm_set1_epi32( iTc * 10 ) );
+		vDelta = _mm_and_si128( clip3( vMinusTc, vTc, vDelta ), vFilter );
+		const __m128i vNewP0 = clip3( vZero, vMaxVal, _mm_add_epi32( vP0, vDelta ) );
+		const __m128i vNewQ0 = clip3( vZero, vMaxVal, _mm_sub_epi32( vQ0, vDelta ) );
+		const __m128i vHalfTc = _mm_set1_epi32( iTc >> 1 );
+		const __m128i vMinusHalfTc = _mm_set1_epi32( -( iTc >> 1 ) );
+		const __m128i vOne = _mm_set1_epi32( 1 );
+		if( iDp0 + iDp3 < iSideThreshold )
+		{
+			__m128i vDeltaP = _mm_srai_epi32( _mm_add_epi32( vP2, _mm_add_epi32( vP0, vOne ) ), 1 );
+			vDeltaP = _mm_srai_epi32( _mm_add_epi32( _mm_sub_epi32( vDeltaP, vP1 ), vDelta ), 1 );
+			vDeltaP = _mm_and_si128( clip3( vMinusHalfTc, vHalfTc, vDeltaP ), vFilter );
+			vP1 = clip3( vZero, vMaxVal, _mm_add_epi32( vP1, vDeltaP ) );
+		}
+		if( iDq0 + iDq3 < iSideThreshold )
+		{
+			__m128i vDeltaQ = _mm_srai_epi32( _mm_add_epi32( vQ2, _mm_add_epi32( vQ0, vOne ) ), 1 );
+			vDeltaQ = _mm_srai_epi32( _mm_sub_epi32( _mm_sub_epi32( vDeltaQ, vQ1 ), vDelta ), 1 );
+			vDeltaQ = _mm_and_si128( clip3( vMinusHalfTc, vHalfTc, vDeltaQ ), vFilter );
+			vQ1 = clip3( vZero, vMaxVal, _mm_add_epi32( vQ1, vDeltaQ ) );
+		}
+		vP0 = vNewP0;
+		vQ0 = vNewQ0;
+	}
+
+	if( iDir == EDGE_VER )
+	{
+		__m128i r0 = _mm_packs_epi32( vP3, vP2 );
+		__m128i r1 = _mm_packs_epi32( vP1, vP0 );
+		__m128i r2 = _mm_packs_epi32( vQ0, vQ1 );
+		__m128i r3 = _mm_packs_epi32( vQ2, vQ3 );
+		transpose8x4( r0, r1, r2, r3 );
+		_mm_storeu_si128( (__m128i*)( pSrc - 4 ), r0 );
+		_mm_storeu_si128( (__m128i*)( pSrc + iStride - 4 ), r1 );
+		_mm_storeu_si128( (__m128i*)( pSrc + 2 * iStride - 4 ), r2 );
+		_mm_storeu_si128( (__m128i*)( pSrc + 3 * iStride - 4 ), r3 );
+	}
+	else
+	{
+		const __m128i vP2P1 = _mm_packs_epi32( vP2, vP1 );
+		const __m128i vP0Q0 = _mm_packs_epi32( vP0, vQ0 );
+		const __m128i vQ1Q2 = _mm_packs_epi32( vQ1, vQ2 );
+		_mm_storel_epi64( (__m128i*)( pSrc - 3 * iStride ), vP2P1 );
+		_mm_storel_epi64( (__m128i*)( pSrc - 2 * iStride ), _mm_srli_si128( vP2P1, 8 ) );
+		_mm_storel_epi64( (__m128i*)( pSrc - iStride ), vP0Q0 );
+		_mm_storel_epi64( (__m128i*)( pSrc ), _mm_srli_si128( vP0Q0, 8 ) );
+		_mm_storel_epi64( (__m128i*)( pSrc + iStride ), vQ1Q2 );
+		_mm_storel_epi64( (__m128i*)( pSrc + 2 * iStride ), _mm_srli_si128( vQ1Q2, 8 ) );
+	}
+}
+
+inline __m128i loadChromaRow( const short* pSrc, int iNumLines )
+{
+	if( iNumLines == 4 )
+	{
+		return _mm_loadl_epi64( (const __m128i*)pSrc );
+	}
+	int iPair;
+	memcpy( &iPair, pSrc, sizeof( int ) );
+	return _mm_cvtsi32_si128( iPair );
+}
+
+inline void storeChromaRow( short* pDst, __m128i v, int iNumLines )
+{
+	if( iNumLines == 4 )
+	{
+		_mm_storel_epi64( (__m128i*)pDst, v );
+		return;
+	}
+	const int iPair = _mm_cvtsi128_si32( v );
+	memcpy( pDst, &iPair, sizeof( int ) );
+}
+
+/// 16-bit lanes, 4 * ( q0 - p0 ) + p1 - q1 stays within 16 bits up to 12-bit samples
+template<int iDir>
+void deblockChroma_sse41( short* pSrc, int iStride, int iTc, int iNumLines, int iBitDepth )
+{
+	__m128i vP1, vP0, vQ0, vQ1;
+	if( iDir == EDGE_VER )
+	{
+		// lines of p1 p0 q0 q1, the missing lines of a two line segment are zero
+		const __m128i l0 = _mm_loadl_epi64( (const __m128i*)( pSrc - 2 ) );
+		const __m128i l1 = _mm_loadl_epi64( (const __m128i*)( pSrc + iStride - 2 ) );
+		const __m128i l2 = iNumLines == 4 ? _mm_loadl_epi64( (const __m128i*)( pSrc + 2 * iStride - 2 ) ) : _mm_setzero_si128();
+		const __m128i l3 = iNumLines == 4 ? _mm_loadl_epi64( (const __m128i*)( pSrc + 3 * iStride - 2 ) ) : _mm_setzero_si128();
+		const __m128i t0 = _mm_unpacklo_epi16( l0, l1 );
+		const __m128i t1 = _mm_unpacklo_epi16( l2, l3 );
+		vP1 = _mm_unpacklo_epi32( t0, t1 );
+		vQ0 = _mm_unpackhi_epi32( t0, t1 );
+		vP0 = _mm_srli_si128( vP1, 8 );
+		vQ1 = _mm_srli_si128( vQ0, 8 );
+	}
+	else
+	{
+		vP1 = loadChromaRow( pSrc - 2 * iStride, iNumLines );
+		vP0 = loadChromaRow( pSrc - iStride, iNumLines );
+		vQ0 = loadChromaRow( pSrc, iNumLines );
+		vQ1 = loadChromaRow( pSrc + iStride, iNumLines );
+	}
+
+	__m128i vDelta = _mm_add_epi16( _mm_slli_epi16( _mm_sub_epi16( vQ0, vP0 ), 2 ), _mm_sub_epi16( vP1, vQ1 ) );
+	vDelta = _mm_srai_epi16( _mm_add_epi16( vDelta, _mm_set1_epi16( 4 ) ), 3 );
+	vDelta = _mm_min_epi16( _mm_max_epi16( vDelta, _mm_set1_epi16( (short)-iTc ) ), _mm_set1_epi16( (short)iTc ) );
+	const __m128i vZero = _mm_setzero_si128();
+	const __m128i vMaxVal = _mm_set1_epi16( (short)( ( 1 << iBitDepth ) - 1 ) );
+	vP0 = _mm_min_epi16( _mm_max_epi16( _mm_add_epi16( vP0, vDelta ), vZero ), vMaxVal );
+	vQ0 = _mm_min_epi16( _mm_max_epi16( _mm_sub_epi16( vQ0, vDelta ), vZero ), vMaxVal );
+
+	if( iDir == EDGE_VER )
+	{
+		const __m128i t0 = _mm_unpacklo_epi16( vP1, vP0 );
+		const __m128i t1 = _mm_unpacklo_epi16( vQ0, vQ1 );
+		const __m128i l01 = _mm_unpacklo_epi32( t0, t1 );
+		_mm_storel_epi64( (__m128i*)( pSrc - 2 ), l01 );
+		_mm_storel_epi64( (__m128i*)( pSrc + iStride - 2 ), _mm_srli_si128( l01, 8 ) );
+		if( iNumLines == 4 )
+		{
+			const __m128i l23 = _mm_unpackhi_epi32( t0, t1 );
+			_mm_storel_epi64( (__m128i*)( pSrc + 2 * iStride - 2 ), l23 );
+			_mm_storel_epi64( (__m128i*)( pSrc + 3 * iStride - 2 ), _mm_srli_si128( l23, 8 ) );
+		}
+	}
+	else
+	{
+		storeChromaRow( pSrc - iStride, vP0, iNumLines );
+		storeChromaRow( pSrc, vQ0, iNumLines );
+	}
+}
+}  // namespace
+
+void setupDeblockPrimitivesSse41( GvcPrimitives& p )
+{
+	p.deblockLuma[EDGE_VER] = deblockLuma_sse41<EDGE_VER>;
+	p.deblockLuma[EDGE_HOR] = deblockLuma_sse41<EDGE_HOR>;
+	p.deblockChroma[EDGE_VER] = deblockChroma_sse41<EDGE_VER>;
+	p.deblockChroma[EDGE_HOR] = deblockChroma_sse41<EDGE_HOR>;
+}
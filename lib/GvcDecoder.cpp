@@ -0,0 +1,378 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcDecoder.cpp
+ * \brief    Main GVC decoder
+ */
+
+#include "GvcDecoder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#include "GvcBitstream.h"
+#include "GvcFrameUnit.h"
+#include "GvcPrimitives.h"
+#include "GvcRom.h"
+
+/// largest frame width or height taken from a sequence header
+static const int MAX_DECODED_FRAME_SIZE = 16384;
+
+GvcDecoder::GvcDecoder()
+    : m_iSourceWidth( 0 )
+    , m_iSourceHeight( 0 )
+    , m_maxBUWidth( 0 )
+    , m_maxBUHeight( 0 )
+    , m_maxTotalBUDepth( 0 )
+    , m_uiQuadtreeTULog2MaxSize( 0 )
+    , m_uiQuadtreeTULog2MinSize( 0 )
+    , m_useScalingListId( SCALING_LIST_OFF )
+    , m_bLoopFilterDisable( false )
+    , m_iLoopFilterBetaOffsetDiv2( 0 )
+    , m_iLoopFilterTcOffsetDiv2( 0 )
+    , m_bUseSAO( false )
+    , m_bWaveFrontSynchro( false )
+    , m_iNumTileColumns( 1 )
+    , m_iNumTileRows( 1 )
+    , m_chromaFormat( CHROMA_420 )
+    , m_iSimdLevel( -1 )
+    , m_iNumThreads( 0 )
+    , m_iFrameThreads( 1 )
+    , m_iNumSubstreams( 0 )
+    , m_iNumBUDecoders( 0 )
+    , m_pcBUDecoders( NULL )
+    , m_pcFrameDecoders( NULL )
+    , m_iNumFramesInFlight( 0 )
+    , m_iNextFrameDecoder( 0 )
+    , m_iNumFramesStarted( 0 )
+    , m_pcFrameRef( NULL )
+{
+	m_bitDepth[CHANNEL_TYPE_LUMA] = m_bitDepth[CHANNEL_TYPE_CHROMA] = 8;
+}
+
+GvcDecoder::~GvcDecoder()
+{
+	destroy();
+}
+
+void GvcDecoder::create()
+{
+	initROM();
+	setupPrimitives( m_iSimdLevel );
+	// the substreams of the frames in flight are decoded in parallel, each frame with its in-loop filters running
+	// behind; on a single thread the frames are decoded one after the other
+	int iNumThreads = m_iNumThreads > 0 ? m_iNumThreads : (int)std::thread::hardware_concurrency();
+	if( iNumThreads > 1 )
+	{
+		m_cThreadPool.create( iNumThreads );
+	}
+	m_iFrameThreads = iNumThreads > 1 ? std::max( m_iFrameThreads, 1 ) : 1;
+	m_iNumFramesStarted = 0;
+}
+
+void GvcDecoder::destroy()
+{
+	// the frame decoders queue on the pool, which stops first
+	m_cThreadPool.destroy();
+	xDestroySequence();
+	xDeleteFrames( m_apcRetiredFrames );
+	m_aucSequenceHeader.clear();
+	m_acDecodedFrames.clear();
+}
+
+bool GvcDecoder::decode( NalUnitType eType, std::vector<unsigned char>& raucPayload, int& riNumDecoded )
+{
+	// the frames returned by the last call are left alone until this one returns
+	std::vector<GvcDecodedFrame> acInUse;
+	acInUse.swap( m_acDecodedFrames );
+	xDeleteFrames( m_apcRetiredFrames );
+	bool bValid = true;
+	switch( eType )
+	{
+	case NAL_UNIT_SEQUENCE_HEADER:
+		bValid = xDecodeSequenceHeader( raucPayload );
+		break;
+	case NAL_UNIT_FRAME:
+		bValid = xDecodeFrame( raucPayload, acInUse );
+		break;
+	default:
+		// reserved types are skipped
+		break;
+	}
+	riNumDecoded = (int)m_acDecodedFrames.size();
+	return bValid;
+}
+
+void GvcDecoder::flush( int& riNumDecoded )
+{
+	m_acDecodedFrames.clear();
+	xDeleteFrames( m_apcRetiredFrames );
+	while( m_iNumFramesInFlight > 0 )
+	{
+		xFinishOldestFrame();
+	}
+	riNumDecoded = (int)m_acDecodedFrames.size();
+}
+
+void GvcDecoder::printSummary()
+{
+	unsigned long long uiNumRefWaits = 0;
+	for( int i = 0; i < m_iNumBUDecoders; i++ )
+	{
+		uiNumRefWaits += m_pcBUDecoders[i].getNumRefWaits();
+	}
+	printf( "\nFrame threads                           : %d\n", m_iFrameThreads );
+	printf( "    Inter blocks waiting for reference  : %llu\n", uiNumRefWaits );
+	if( m_cThreadPool.getNumThreads() > 0 )
+	{
+		printf( "\nThread pool (%d threads)\n", m_cThreadPool.getNumThreads() );
+		printf( "    Most jobs queued at once            : %d\n", m_cThreadPool.getMaxQueued() );
+		for( int i = 0; i < m_cThreadPool.getNumThreads(); i++ )
+		{
+			printf( "    Thread %-3d jobs / stolen            : %llu / %llu\n", i, m_cThreadPool.getNumJobs( i ), m_cThreadPool.getNumSteals( i ) );
+		}
+	}
+}
+
+/** The parameters written by GvcEncoder::xWriteSequenceHeader, with the limits the encoder checks its configuration
+ *  against. A new header first finishes the frames in flight, then drops the frames decoded so far; the next frame
+ *  must be an intra frame.
+ */
+bool GvcDecoder::xDecodeSequenceHeader( std::vector<unsigned char>& raucPayload )
+{
+	if( hasSequenceHeader() && raucPayload == m_aucSequenceHeader )
+	{
+		return true;
+	}
+	while( m_iNumFramesInFlight > 0 )
+	{
+		xFinishOldestFrame();
+	}
+	xDestroySequence();
+	m_aucSequenceHeader.clear();
+	if( raucPayload.empty() )
+	{
+		return false;
+	}
+
+	GvcInputBitstream cBitstream;
+	cBitstream.init( &raucPayload[0], (unsigned int)raucPayload.size() );
+	const unsigned int uiWidth = cBitstream.readUvlc();
+	const unsigned int uiHeight = cBitstream.readUvlc();
+	m_chromaFormat = ChromaFormat( cBitstream.read( 2 ) );
+	const unsigned int uiBitDepthLuma = cBitstream.readUvlc() + 8;
+	const unsigned int uiBitDepthChroma = cBitstream.readUvlc() + 8;
+	m_maxBUWidth = cBitstream.readUvlc();
+	m_maxBUHeight = cBitstream.readUvlc();
+	m_maxTotalBUDepth = cBitstream.readUvlc();
+	m_uiQuadtreeTULog2MaxSize = cBitstream.readUvlc();
+	m_uiQuadtreeTULog2MinSize = cBitstream.readUvlc();
+	const unsigned int uiScalingListId = cBitstream.readUvlc();
+	m_bLoopFilterDisable = cBitstream.read( 1 ) != 0;
+	m_iLoopFilterBetaOffsetDiv2 = m_bLoopFilterDisable ? 0 : cBitstream.readSvlc();
+	m_iLoopFilterTcOffsetDiv2 = m_bLoopFilterDisable ? 0 : cBitstream.readSvlc();
+	m_bUseSAO = cBitstream.read( 1 ) != 0;
+	m_bWaveFrontSynchro = cBitstream.read( 1 ) != 0;
+	const unsigned int uiNumTileColumns = cBitstream.readUvlc() + 1;
+	const unsigned int uiNumTileRows = cBitstream.readUvlc() + 1;
+
+	bool bValid = uiWidth > 0 && uiHeight > 0 && uiWidth <= (unsigned int)MAX_DECODED_FRAME_SIZE && uiHeight <= (unsigned int)MAX_DECODED_FRAME_SIZE;
+	bValid = bValid && uiWidth % MIN_BU_SIZE == 0 && uiHeight % MIN_BU_SIZE == 0;
+	bValid = bValid && uiBitDepthLuma <= 16 && uiBitDepthChroma <= 16;
+	bValid = bValid && m_maxBUWidth == m_maxBUHeight && ( m_maxBUWidth & ( m_maxBUWidth - 1 ) ) == 0 && m_maxBUWidth <= (unsigned int)MAX_BU_SIZE;
+	bValid = bValid && m_maxTotalBUDepth >= 1 && m_maxTotalBUDepth <= (unsigned int)MAX_BU_DEPTH && ( m_maxBUWidth >> ( m_maxTotalBUDepth - 1 ) ) >= (unsigned int)MIN_BU_SIZE;
+	bValid = bValid && m_uiQuadtreeTULog2MinSize >= (unsigned int)MIN_LOG2_TU_SIZE && m_uiQuadtreeTULog2MaxSize <= (unsigned int)MAX_LOG2_TU_SIZE;
+	bValid = bValid && m_uiQuadtreeTULog2MinSize <= m_uiQuadtreeTULog2MaxSize && ( 1u << m_uiQuadtreeTULog2MaxSize ) <= m_maxBUWidth;
+	bValid = bValid && uiScalingListId <= (unsigned int)SCALING_LIST_DEFAULT;
+	bValid = bValid && m_iLoopFilterBetaOffsetDiv2 >= -6 && m_iLoopFilterBetaOffsetDiv2 <= 6 && m_iLoopFilterTcOffsetDiv2 >= -6 && m_iLoopFilterTcOffsetDiv2 <= 6;
+	if( !bValid )
+	{
+		return false;
+	}
+	m_iSourceWidth = (int)uiWidth;
+	m_iSourceHeight = (int)uiHeight;
+	m_bitDepth[CHANNEL_TYPE_LUMA] = (int)uiBitDepthLuma;
+	m_bitDepth[CHANNEL_TYPE_CHROMA] = (int)uiBitDepthChroma;
+	m_useScalingListId = ScalingListMode( uiScalingListId );
+	const int iWidthInBUs = ( m_iSourceWidth + m_maxBUWidth - 1 ) / m_maxBUWidth;
+	const int iHeightInBUs = ( m_iSourceHeight + m_maxBUHeight - 1 ) / m_maxBUHeight;
+	if( uiNumTileColumns < 1 || uiNumTileRows < 1 || uiNumTileColumns > (unsigned int)iWidthInBUs || uiNumTileRows > (unsigned int)iHeightInBUs ||
+	    ( m_bWaveFrontSynchro && uiNumTileColumns * uiNumTileRows > 1 ) )
+	{
+		return false;
+	}
+	m_iNumTileColumns = (int)uiNumTileColumns;
+	m_iNumTileRows = (int)uiNumTileRows;
+	GvcFrameUnit::getUniformTileSizes( iWidthInBUs, m_iNumTileColumns, m_aiTileColumnWidth );
+	GvcFrameUnit::getUniformTileSizes( iHeightInBUs, m_iNumTileRows, m_aiTileRowHeight );
+	if( m_iNumTileColumns * m_iNumTileRows > 1 && !cBitstream.read( 1 ) )
+	{
+		// the last column and the last row take the rest of the frame
+		for( int i = 0; i + 1 < m_iNumTileColumns; i++ )
+		{
+			m_aiTileColumnWidth[i] = (int)std::min<unsigned long long>( cBitstream.readUvlc() + 1ull, iWidthInBUs );
+		}
+		m_aiTileColumnWidth.back() = iWidthInBUs;
+		for( int i = 0; i + 1 < m_iNumTileColumns; i++ )
+		{
+			m_aiTileColumnWidth.back() -= m_aiTileColumnWidth[i];
+		}
+		for( int i = 0; i + 1 < m_iNumTileRows; i++ )
+		{
+			m_aiTileRowHeight[i] = (int)std::min<unsigned long long>( cBitstream.readUvlc() + 1ull, iHeightInBUs );
+		}
+		m_aiTileRowHeight.back() = iHeightInBUs;
+		for( int i = 0; i + 1 < m_iNumTileRows; i++ )
+		{
+			m_aiTileRowHeight.back() -= m_aiTileRowHeight[i];
+		}
+		if( m_aiTileColumnWidth.back() < 1 || m_aiTileRowHeight.back() < 1 )
+		{
+			return false;
+		}
+	}
+	if( !cBitstream.readRBSPTrailingBits() || cBitstream.getOverrun() )
+	{
+		return false;
+	}
+
+	m_aucSequenceHeader.swap( raucPayload );
+	xCreateSequence();
+	return true;
+}
+
+/** A predicted frame needs the frame before it, a stream may only start, or start over, at an intra frame. The frame
+ *  starts on the next frame decoder of the ring, whose frame finished with the previous call.
+ */
+bool GvcDecoder::xDecodeFrame( std::vector<unsigned char>& raucPayload, const std::vector<GvcDecodedFrame>& rcInUse )
+{
+	if( !hasSequenceHeader() )
+	{
+		return false;
+	}
+	GvcFrameDecoder* pcFrameDecoder = &m_pcFrameDecoders[m_iNextFrameDecoder];
+	if( !pcFrameDecoder->parseFrameHeader( raucPayload ) )
+	{
+		return false;
+	}
+	if( pcFrameDecoder->getFrameType() == P_FRAME && !m_pcFrameRef )
+	{
+		return false;
+	}
+	GvcFrameUnit* pcFrame = xGetFreeFrame( rcInUse );
+	pcFrameDecoder->startFrame( pcFrame, m_pcFrameRef, m_iNumFramesStarted++ );
+	m_pcFrameRef = pcFrame;
+	m_iNextFrameDecoder = ( m_iNextFrameDecoder + 1 ) % m_iFrameThreads;
+	m_iNumFramesInFlight++;
+	// a single frame in flight is finished before returning
+	while( m_iNumFramesInFlight >= m_iFrameThreads )
+	{
+		xFinishOldestFrame();
+	}
+	return true;
+}
+
+void GvcDecoder::xFinishOldestFrame()
+{
+	GvcFrameDecoder* pcFrameDecoder = &m_pcFrameDecoders[( m_iNextFrameDecoder + m_iFrameThreads - m_iNumFramesInFlight ) % m_iFrameThreads];
+	GvcDecodedFrame cDecodedFrame;
+	cDecodedFrame.bCorrupt = !pcFrameDecoder->finishFrame();
+	cDecodedFrame.pcFrame = pcFrameDecoder->getFrameRec();
+	cDecodedFrame.iFrameNumber = pcFrameDecoder->getFrameNumber();
+	cDecodedFrame.eType = pcFrameDecoder->getFrameType();
+	cDecodedFrame.iQP = pcFrameDecoder->getQP();
+	cDecodedFrame.uiNumBytes = pcFrameDecoder->getNumBytes();
+	m_acDecodedFrames.push_back( cDecodedFrame );
+	m_iNumFramesInFlight--;
+}
+
+void GvcDecoder::xCreateSequence()
+{
+	const int iHeightInBUs = ( m_iSourceHeight + m_maxBUHeight - 1 ) / m_maxBUHeight;
+	m_iNumSubstreams = m_bWaveFrontSynchro ? iHeightInBUs : m_iNumTileColumns * m_iNumTileRows;
+	m_iNumBUDecoders = std::max( 1, m_cThreadPool.getNumThreads() );
+	m_pcBUDecoders = new GvcBUDecoder[m_iNumBUDecoders];
+	for( int i = 0; i < m_iNumBUDecoders; i++ )
+	{
+		m_pcBUDecoders[i].create( this );
+	}
+	m_pcFrameDecoders = new GvcFrameDecoder[m_iFrameThreads];
+	for( int i = 0; i < m_iFrameThreads; i++ )
+	{
+		m_pcFrameDecoders[i].create( this );
+	}
+	m_iNumFramesInFlight = 0;
+	m_iNextFrameDecoder = 0;
+	m_pcFrameRef = NULL;
+}
+
+void GvcDecoder::xDestroySequence()
+{
+	delete[] m_pcFrameDecoders;
+	m_pcFrameDecoders = NULL;
+	m_iNumFramesInFlight = 0;
+	delete[] m_pcBUDecoders;
+	m_pcBUDecoders = NULL;
+	m_iNumBUDecoders = 0;
+	// the frames returned by the current call stay valid until the next one
+	m_apcRetiredFrames.insert( m_apcRetiredFrames.end(), m_apcFrames.begin(), m_apcFrames.end() );
+	m_apcFrames.clear();
+	m_pcFrameRef = NULL;
+	m_iNumSubstreams = 0;
+}
+
+void GvcDecoder::xDeleteFrames( std::vector<GvcFrameUnit*>& rapcFrames )
+{
+	for( size_t i = 0; i < rapcFrames.size(); i++ )
+	{
+		rapcFrames[i]->destroy();
+		delete rapcFrames[i];
+	}
+	rapcFrames.clear();
+}
+
+/** A buffer that is neither the reference, nor read or written by a frame in flight, nor held by the caller, a new one
+ *  when there is none.
+ */
+GvcFrameUnit* GvcDecoder::xGetFreeFrame( const std::vector<GvcDecodedFrame>& rcInUse )
+{
+	for( size_t i = 0; i < m_apcFrames.size(); i++ )
+	{
+		bool bFree = m_apcFrames[i] != m_pcFrameRef;
+		for( int j = 1; j <= m_iNumFramesInFlight; j++ )
+		{
+			GvcFrameDecoder* pcFrameDecoder = &m_pcFrameDecoders[( m_iNextFrameDecoder + m_iFrameThreads - j ) % m_iFrameThreads];
+			bFree &= pcFrameDecoder->getFrameRec() != m_apcFrames[i] && pcFrameDecoder->getFrameRef() != m_apcFrames[i];
+		}
+		for( size_t j = 0; j < rcInUse.size(); j++ )
+		{
+			bFree &= rcInUse[j].pcFrame != m_apcFrames[i];
+		}
+		if( bFree )
+		{
+			return m_apcFrames[i];
+		}
+	}
+	GvcFrameUnit* pcFrame = new GvcFrameUnit;
+	pcFrame->create( m_iSourceWidth, m_iSourceHeight, m_chromaFormat, m_maxBUWidth, m_maxBUHeight, true );
+	m_apcFrames.push_back( pcFrame );
+	return pcFrame;
+}
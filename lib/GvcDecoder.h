@@ -0,0 +1,151 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcDecoder.h
+ * \brief    Main GVC decoder class (header)
+ */
+
+#ifndef __GVCDECODER_H__
+#define __GVCDECODER_H__
+
+#include <vector>
+
+#include "TypeDef.h"
+#include "GvcBUDecoder.h"
+#include "GvcFrameDecoder.h"
+#include "GvcNal.h"
+#include "GvcThreadPool.h"
+
+class GvcFrameUnit;
+
+/// a frame finished by the decoder, with what its header said
+struct GvcDecodedFrame
+{
+	GvcFrameUnit* pcFrame;
+	int iFrameNumber;
+	FrameType eType;
+	int iQP;
+	unsigned int uiNumBytes;  ///< of the NAL unit payload
+	bool bCorrupt;            ///< some of the payload did not parse, the frame is decoded as far as it could be
+};
+
+/**
+ * \class    GvcDecoder
+ * \brief    Main GVC decoder class, takes the NAL units of a stream one by one
+ *
+ * The coding parameters come from the sequence header. A header that repeats the one in use is skipped, a different
+ * one starts the decoder over with the new parameters. The frames are reconstructed into buffers of the decoder,
+ * which are reused once the caller is past them.
+ *
+ * With frame threads, up to that many frames are decoded at once, as the encoder codes them: decode starts a frame
+ * and returns the oldest one once they are all in flight, and flush returns the rest. A predicted frame waits for
+ * the rows of its reference that its motion vectors reach, not for the whole reference. The frames come out in
+ * decoding order, which is the output order of the stream.
+ */
+class GvcDecoder
+{
+	int m_iSourceWidth;
+	int m_iSourceHeight;
+	unsigned int m_maxBUWidth;
+	unsigned int m_maxBUHeight;
+	unsigned int m_maxTotalBUDepth;
+	unsigned int m_uiQuadtreeTULog2MaxSize;
+	unsigned int m_uiQuadtreeTULog2MinSize;
+	ScalingListMode m_useScalingListId;
+	bool m_bLoopFilterDisable;
+	int m_iLoopFilterBetaOffsetDiv2;
+	int m_iLoopFilterTcOffsetDiv2;
+	bool m_bUseSAO;
+	bool m_bWaveFrontSynchro;
+	int m_iNumTileColumns;
+	int m_iNumTileRows;
+	std::vector<int> m_aiTileColumnWidth;  ///< in BUs, every column
+	std::vector<int> m_aiTileRowHeight;    ///< in BUs, every row
+	ChromaFormat m_chromaFormat;
+	int m_bitDepth[MAX_NUM_CHANNEL_TYPE];
+	int m_iSimdLevel;  ///< instruction set of the kernels (-1: best available)
+	int m_iNumThreads;         ///< threads decoding BU rows or tiles (0: one per hardware thread)
+	int m_iFrameThreads;       ///< frames decoded at once, each predicted from the one before
+	std::vector<unsigned char> m_aucSequenceHeader;  ///< payload of the sequence header in use, empty before the first
+	int m_iNumSubstreams;                 ///< one per BU row with wavefront synchronisation, one per tile otherwise
+	int m_iNumBUDecoders;
+	GvcBUDecoder* m_pcBUDecoders;         ///< one per thread
+	GvcFrameDecoder* m_pcFrameDecoders;   ///< one per frame in flight, used in turn
+	int m_iNumFramesInFlight;
+	int m_iNextFrameDecoder;              ///< context of the next frame, the oldest in flight is m_iNumFramesInFlight before
+	int m_iNumFramesStarted;              ///< priority of the jobs of the next frame
+	GvcThreadPool m_cThreadPool;
+	std::vector<GvcFrameUnit*> m_apcFrames;        ///< reconstruction buffers
+	std::vector<GvcFrameUnit*> m_apcRetiredFrames; ///< buffers of a previous sequence still held by the caller
+	GvcFrameUnit* m_pcFrameRef;                    ///< last frame started, the reference of the next one
+	std::vector<GvcDecodedFrame> m_acDecodedFrames;  ///< frames finished by the last call
+
+  public:
+	GvcDecoder();
+	virtual ~GvcDecoder();
+	int       getSourceWidth                  ()      { return  m_iSourceWidth; }
+	int       getSourceHeight                 ()      { return  m_iSourceHeight; }
+	unsigned int getMaxBUWidth                ()      { return  m_maxBUWidth; }
+	unsigned int getMaxBUHeight               ()      { return  m_maxBUHeight; }
+	unsigned int getMaxTotalBUDepth           ()      { return  m_maxTotalBUDepth; }
+	unsigned int getQuadtreeTULog2MaxSize     ()      { return  m_uiQuadtreeTULog2MaxSize; }
+	ScalingListMode getUseScalingListId       ()      { return  m_useScalingListId; }
+	bool      getLoopFilterDisable            ()      { return  m_bLoopFilterDisable; }
+	int       getLoopFilterBetaOffsetDiv2     ()      { return  m_iLoopFilterBetaOffsetDiv2; }
+	int       getLoopFilterTcOffsetDiv2       ()      { return  m_iLoopFilterTcOffsetDiv2; }
+	bool      getUseSAO                       ()      { return  m_bUseSAO; }
+	bool      getWaveFrontSynchro             ()      { return  m_bWaveFrontSynchro; }
+	int       getNumTileColumns               ()      { return  m_iNumTileColumns; }
+	int       getNumTileRows                  ()      { return  m_iNumTileRows; }
+	const std::vector<int>& getTileColumnWidths() const { return m_aiTileColumnWidth; }
+	const std::vector<int>& getTileRowHeights () const { return m_aiTileRowHeight; }
+	ChromaFormat  getChromaFormat             ( )              { return m_chromaFormat; }
+	int       getBitDepth( const ChannelType chType ) { return m_bitDepth[chType]; }
+	void      setSimdLevel                    ( int   i )      { m_iSimdLevel = i; }
+	void      setNumThreads                   ( int   i )      { m_iNumThreads = i; }
+	void      setFrameThreads                 ( int   i )      { m_iFrameThreads = i; }
+	int       getFrameThreads                 ()      { return  m_iFrameThreads; }
+	int       getNumSubstreams                ()      { return  m_iNumSubstreams; }
+	GvcBUDecoder* getBUDecoder                ( int i )      { return &m_pcBUDecoders[i]; }
+	GvcThreadPool* getThreadPool              ()      { return &m_cThreadPool; }
+	/// a sequence header was decoded, the parameters above are those of the stream
+	bool      hasSequenceHeader               () const { return !m_aucSequenceHeader.empty(); }
+	/// the i-th frame finished by the last call to decode or flush, in output order; valid until the next call
+	const GvcDecodedFrame& getDecodedFrame( int i ) const { return m_acDecodedFrames[i]; }
+	void      create();
+	void      destroy();
+	/// decodes a NAL unit, its payload is taken from raucPayload; riNumDecoded frames are finished, the oldest first.
+	/// False if the NAL unit is not valid, a frame that decodes with errors is still returned, marked as corrupt
+	bool      decode(NalUnitType eType, std::vector<unsigned char>& raucPayload, int& riNumDecoded);
+	/// finishes every frame still being decoded
+	void      flush(int& riNumDecoded);
+	void      printSummary();
+
+  private:
+	bool      xDecodeSequenceHeader(std::vector<unsigned char>& raucPayload);
+	bool      xDecodeFrame(std::vector<unsigned char>& raucPayload, const std::vector<GvcDecodedFrame>& rcInUse);
+	void      xFinishOldestFrame();
+	void      xCreateSequence();
+	void      xDestroySequence();
+	static void xDeleteFrames(std::vector<GvcFrameUnit*>& rapcFrames);
+	GvcFrameUnit* xGetFreeFrame(const std::vector<GvcDecodedFrame>& rcInUse);
+};
+
+#endif  // __GVCDECODER_H__
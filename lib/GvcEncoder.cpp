@@ -22,34 +22,294 @@
  * \brief    Main GVC encoder
  */
 
+
 #include "GvcEncoder.h"
+
+#include <algorithm>
+#include <cstdio>
+
 #include "GvcFrameUnit.h"
+#include "GvcPrimitives.h"
+#include "GvcRom.h"
 
 GvcEncoder::GvcEncoder()
+    : m_useRDOQ(true)
+    , m_useScalingListId(SCALING_LIST_OFF)
+    , m_iPreset(1)
+    , m_uiIntraRDCandidates(0)
+    , m_iFastSearch(ME_TZ)
+    , m_iSearchRange(64)
+    , m_bHadamardME(true)
+    , m_bLoopFilterDisable(false)
+    , m_iLoopFilterBetaOffsetDiv2(0)
+    , m_iLoopFilterTcOffsetDiv2(0)
+    , m_bUseSAO(true)
+    , m_bWaveFrontSynchro(false)
+    , m_iNumThreads(0)
+    , m_iFrameThreads(1)
+    , m_bPinThreads(false)
+    , m_bModeDecisionTasks(false)
+    , m_iIntraPeriod(-1)
+    , m_bTileUniformSpacing(true)
+    , m_iNumTileColumns(1)
+    , m_iNumTileRows(1)
+    , m_iSimdLevel(-1)
+    , m_iNumBUEncoders(0)
+    , m_pcBUEncoders(NULL)
+    , m_iNumSubstreams(0)
+    , m_pcFrameEncoders(NULL)
+    , m_iNumFramesInFlight(0)
+    , m_iNextFrameEncoder(0)
+    , m_pcSharedThreadPool(NULL)
+    , m_bSequenceHeaderSent(false)
 {
 }
 
 GvcEncoder::~GvcEncoder()
 {
+    destroy();
 }
 
 void GvcEncoder::create()
 {
+    initROM();
+    setupPrimitives(m_iSimdLevel);
+    const int iWidthInBUs = (m_iSourceWidth + m_maxBUWidth - 1) / m_maxBUWidth;
+    const int iHeightInBUs = (m_iSourceHeight + m_maxBUHeight - 1) / m_maxBUHeight;
+    if (m_bTileUniformSpacing)
+    {
+        GvcFrameUnit::getUniformTileSizes(iWidthInBUs, m_iNumTileColumns, m_aiTileColumnWidth);
+        GvcFrameUnit::getUniformTileSizes(iHeightInBUs, m_iNumTileRows, m_aiTileRowHeight);
+    }
+    else
+    {
+        m_aiTileColumnWidth.resize(m_iNumTileColumns - 1);
+        m_aiTileColumnWidth.push_back(iWidthInBUs);
+        for (int i = 0; i + 1 < m_iNumTileColumns; i++)
+        {
+            m_aiTileColumnWidth.back() -= m_aiTileColumnWidth[i];
+        }
+        m_aiTileRowHeight.resize(m_iNumTileRows - 1);
+        m_aiTileRowHeight.push_back(iHeightInBUs);
+        for (int i = 0; i + 1 < m_iNumTileRows; i++)
+        {
+            m_aiTileRowHeight.back() -= m_aiTileRowHeight[i];
+        }
+    }
+    // the substreams are coded in parallel, a single one BU after BU, and so are the frames in flight, each with its
+    // in-loop filters running behind; with mode decision tasks every substream may have a CU search forked besides
+    m_iNumSubstreams = m_bWaveFrontSynchro ? iHeightInBUs : m_iNumTileColumns * m_iNumTileRows;
+    if (!m_pcSharedThreadPool)
+    {
+        int iNumThreads = m_iNumThreads > 0 ? m_iNumThreads : (int)std::thread::hardware_concurrency();
+        iNumThreads = std::min(iNumThreads, getMaxUsefulThreads());
+        if (iNumThreads > 1)
+        {
+            m_cThreadPool.create(iNumThreads, m_bPinThreads);
+        }
+    }
+    // the BU encoders fork on the pool, which is created first; one per thread that may run a substream
+    m_iNumBUEncoders = std::max(1, getThreadPool()->getNumThreads());
+    m_pcBUEncoders = new GvcBUEncoder[m_iNumBUEncoders];
+    for (int i = 0; i < m_iNumBUEncoders; i++)
+    {
+        m_pcBUEncoders[i].create(this);
+    }
+    // with frames in flight, a BU row waits for the reference rows down to the bottom of its search range; one
+    // frame at a time waits for the whole reference, so that the search window is not cut
+    const int iRefLagLines = GvcMotionEstimation::getRefLagLines(m_iSearchRange);
+    const int iRefLagRows = m_iFrameThreads > 1 && iRefLagLines > 0 ? (iRefLagLines + m_maxBUHeight - 1) / m_maxBUHeight : -1;
+    m_pcFrameEncoders = new GvcFrameEncoder[m_iFrameThreads];
+    for (int i = 0; i < m_iFrameThreads; i++)
+    {
+        m_pcFrameEncoders[i].create(this);
+        m_pcFrameEncoders[i].setRefLagRows(iRefLagRows);
+    }
+    m_iNumFramesInFlight = 0;
+    m_iNextFrameEncoder = 0;
+    m_bSequenceHeaderSent = false;
+}
+
+int GvcEncoder::getMaxUsefulThreads() const
+{
+    const int iHeightInBUs = (m_iSourceHeight + m_maxBUHeight - 1) / m_maxBUHeight;
+    const int iNumSubstreams = m_bWaveFrontSynchro ? iHeightInBUs : m_iNumTileColumns * m_iNumTileRows;
+    // one more per frame for its in-loop filters
+    return (iNumSubstreams * (m_bModeDecisionTasks ? 2 : 1) + 1) * m_iFrameThreads;
+}
+
+void GvcEncoder::destroy()
+{
+    // the frame encoders queue on the pool, which runs what is left queued as it stops; a shared pool may still hold
+    // the queued copies of the forks that the BU encoders joined themselves, its owner waits for them before this
+    m_cThreadPool.destroy();
+    delete[] m_pcFrameEncoders;
+    m_pcFrameEncoders = NULL;
+    delete[] m_pcBUEncoders;
+    m_pcBUEncoders = NULL;
+    m_iNumBUEncoders = 0;
+    m_iNumSubstreams = 0;
+}
+
+/** The pyramid search reads the downscaled levels of the source and its padded margin, an intra frame needs neither.
+ */
+void GvcEncoder::prepareMotionSearch(GvcFrameUnit* pcFrameOrg, int iFrameNumber)
+{
+    if (m_iFastSearch == ME_PYRAMID && !(m_iIntraPeriod > 0 && iFrameNumber % m_iIntraPeriod == 0))
+    {
+        // the boundary BUs are searched whole, reading the padded margin
+        pcFrameOrg->extendFrameBorder();
+        pcFrameOrg->buildPyramid();
+    }
+}
+
+void GvcEncoder::encode(GvcFrameUnit* pcFrameOrg, GvcFrameUnit* pcFrameRec, GvcFrameUnit* pcFrameRef, int& riNumEncoded, bool bPrepared)
+{
+    m_acAccessUnits.clear();
+    GvcFrameEncoder* pcFrameEncoder = &m_pcFrameEncoders[m_iNextFrameEncoder];
+    pcFrameEncoder->getAccessUnit().clear();
+    // a stream may start at any intra frame, each segment carries the coding parameters
+    if (!m_bSequenceHeaderSent)
+    {
+        xWriteSequenceHeader(pcFrameEncoder->getAccessUnit());
+        m_bSequenceHeaderSent = true;
+    }
+    if (m_iIntraPeriod > 0 && m_iNumEncodedFrames % m_iIntraPeriod == 0)
+    {
+        pcFrameRef = NULL;
+    }
+    if (!bPrepared && pcFrameRef)
+    {
+        prepareMotionSearch(pcFrameOrg, m_iNumEncodedFrames);
+    }
+    pcFrameEncoder->startFrame(pcFrameOrg, pcFrameRec, pcFrameRef, m_iNumEncodedFrames);
+    m_iNextFrameEncoder = (m_iNextFrameEncoder + 1) % m_iFrameThreads;
+    m_iNumFramesInFlight++;
+    m_iNumEncodedFrames++;
+    // a single frame in flight is finished before returning
+    while (m_iNumFramesInFlight >= m_iFrameThreads)
+    {
+        xFinishOldestFrame();
+    }
+    riNumEncoded = (int)m_acAccessUnits.size();
 }
 
-void GvcEncoder::encode(GvcFrameUnit* pcFrameOrg, GvcFrameUnit* pcFrameRec)
+void GvcEncoder::flush(int& riNumEncoded)
 {
-    m_pcFrameOrg = pcFrameOrg;
-    m_pcFrameRec = pcFrameRec;
-    encodeFrameUnit();
+    m_acAccessUnits.clear();
+    while (m_iNumFramesInFlight > 0)
+    {
+        xFinishOldestFrame();
+    }
+    riNumEncoded = (int)m_acAccessUnits.size();
 }
 
-void GvcEncoder::encodeFrameUnit()
+void GvcEncoder::xFinishOldestFrame()
 {
-    encodeBlockUnit();
+    GvcFrameEncoder* pcFrameEncoder = &m_pcFrameEncoders[(m_iNextFrameEncoder + m_iFrameThreads - m_iNumFramesInFlight) % m_iFrameThreads];
+    pcFrameEncoder->finishFrame();
+    m_acAccessUnits.push_back(pcFrameEncoder->getAccessUnit());
+    m_iNumFramesInFlight--;
 }
 
-void GvcEncoder::encodeBlockUnit()
+/** Parameters the decoder needs before the first frame, in a NAL unit of their own.
+ */
+void GvcEncoder::xWriteSequenceHeader(GvcAccessUnit& rcAccessUnit)
 {
+    m_cBitstream.clear();
+    m_cBitstream.writeUvlc(m_iSourceWidth);
+    m_cBitstream.writeUvlc(m_iSourceHeight);
+    m_cBitstream.write(m_chromaFormat, 2);
+    m_cBitstream.writeUvlc(m_bitDepth[CHANNEL_TYPE_LUMA] - 8);
+    m_cBitstream.writeUvlc(m_bitDepth[CHANNEL_TYPE_CHROMA] - 8);
+    m_cBitstream.writeUvlc(m_maxBUWidth);
+    m_cBitstream.writeUvlc(m_maxBUHeight);
+    m_cBitstream.writeUvlc(m_maxTotalBUDepth);
+    m_cBitstream.writeUvlc(m_uiQuadtreeTULog2MaxSize);
+    m_cBitstream.writeUvlc(m_uiQuadtreeTULog2MinSize);
+    m_cBitstream.writeUvlc(m_useScalingListId);
+    m_cBitstream.write(m_bLoopFilterDisable, 1);
+    if (!m_bLoopFilterDisable)
+    {
+        m_cBitstream.writeSvlc(m_iLoopFilterBetaOffsetDiv2);
+        m_cBitstream.writeSvlc(m_iLoopFilterTcOffsetDiv2);
+    }
+    m_cBitstream.write(m_bUseSAO, 1);
+    m_cBitstream.write(m_bWaveFrontSynchro, 1);
+    m_cBitstream.writeUvlc(m_iNumTileColumns - 1);
+    m_cBitstream.writeUvlc(m_iNumTileRows - 1);
+    if (m_iNumTileColumns * m_iNumTileRows > 1)
+    {
+        m_cBitstream.write(m_bTileUniformSpacing, 1);
+        if (!m_bTileUniformSpacing)
+        {
+            for (int i = 0; i + 1 < m_iNumTileColumns; i++)
+            {
+                m_cBitstream.writeUvlc(m_aiTileColumnWidth[i] - 1);
+            }
+            for (int i = 0; i + 1 < m_iNumTileRows; i++)
+            {
+                m_cBitstream.writeUvlc(m_aiTileRowHeight[i] - 1);
+            }
+        }
+    }
+    m_cBitstream.writeRBSPTrailingBits();
+    rcAccessUnit.addNALUnit(NAL_UNIT_SEQUENCE_HEADER, m_cBitstream);
+}
 
-}
\ No newline at end of file
+void GvcEncoder::printSummary()
+{
+    // the statistics of every thread
+    unsigned long long uiNumBUs = 0, uiNumSwaps = 0, uiBytesCopied = 0, uiBytesSwapped = 0;
+    unsigned long long uiNumIntraBlocks = 0, uiNumIntraRDModes = 0;
+    unsigned long long uiNumSearches = 0, uiTotalSadEvals = 0, uiPyramidSadEvals = 0;
+    unsigned long long uiNumForks = 0;
+    for (int i = 0; i < m_iNumBUEncoders; i++)
+    {
+        uiNumForks += m_pcBUEncoders[i].getNumForks();
+        // the helper of an encoder searched part of its BUs
+        for (const GvcBUEncoder* pcBUEncoder = &m_pcBUEncoders[i]; pcBUEncoder; pcBUEncoder = pcBUEncoder->getHelper())
+        {
+            const GvcBUWorkspace& rcWorkspace = pcBUEncoder->getWorkspace();
+            const GvcMotionEstimation& rcMotionEstimation = pcBUEncoder->getMotionEstimation();
+            uiNumBUs += rcWorkspace.getNumBUs();
+            uiNumSwaps += rcWorkspace.getNumSwaps();
+            uiBytesCopied += rcWorkspace.getBytesCopied();
+            uiBytesSwapped += rcWorkspace.getBytesSwapped();
+            uiNumIntraBlocks += pcBUEncoder->getNumIntraBlocks();
+            uiNumIntraRDModes += pcBUEncoder->getNumIntraRDModes();
+            uiNumSearches += rcMotionEstimation.getNumSearches();
+            uiTotalSadEvals += rcMotionEstimation.getTotalSadEvals();
+            uiPyramidSadEvals += rcMotionEstimation.getPyramidSadEvals();
+        }
+    }
+    const double dNumBUs = uiNumBUs ? (double)uiNumBUs : 1.0;
+    printf("\nBU mode decision workspace\n");
+    printf("    Candidate swaps per BU              : %.1f\n", uiNumSwaps / dNumBUs);
+    printf("    Bytes copied per BU                 : %.1f\n", uiBytesCopied / dNumBUs);
+    printf("    Bytes exchanged by swap per BU      : %.1f\n", uiBytesSwapped / dNumBUs);
+    printf("    Intra modes with full RD per block  : %.2f\n", uiNumIntraBlocks ? (double)uiNumIntraRDModes / uiNumIntraBlocks : 0.0);
+    if (m_bModeDecisionTasks)
+    {
+        printf("    CUs with the 2Nx2N search forked    : %.1f per BU\n", uiNumForks / dNumBUs);
+    }
+    const double dNumSearches = uiNumSearches ? (double)uiNumSearches : 1.0;
+    static const char* s_apcSearchName[] = { "full search", "TZ search", "pyramid search" };
+    printf("\nMotion estimation (%s)\n", s_apcSearchName[m_iFastSearch]);
+    printf("    Searched blocks                     : %llu\n", uiNumSearches);
+    printf("    SAD evaluations per block           : %.1f\n", uiTotalSadEvals / dNumSearches);
+    if (m_iFastSearch == ME_PYRAMID)
+    {
+        printf("    of which on downscaled planes       : %.1f\n", uiPyramidSadEvals / dNumSearches);
+    }
+    GvcThreadPool* pcThreadPool = getThreadPool();
+    if (pcThreadPool->getNumThreads() > 0)
+    {
+        printf("\nThread pool (%d threads%s)\n", pcThreadPool->getNumThreads(), m_bPinThreads ? ", pinned" : "");
+        printf("    Most jobs queued at once            : %d\n", pcThreadPool->getMaxQueued());
+        for (int i = 0; i < pcThreadPool->getNumThreads(); i++)
+        {
+            printf("    Thread %-3d jobs / stolen            : %llu / %llu\n", i, pcThreadPool->getNumJobs(i), pcThreadPool->getNumSteals(i));
+        }
+    }
+}
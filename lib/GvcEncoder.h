@@ -25,7 +25,14 @@
 #ifndef __GVCENCODER_H__
 #define __GVCENCODER_H__
 
+#include <vector>
+
 #include "TypeDef.h"
+#include "GvcBUEncoder.h"
+#include "GvcBitstream.h"
+#include "GvcFrameEncoder.h"
+#include "GvcNal.h"
+#include "GvcThreadPool.h"
 
 /**
  * \class    GvcEncoder
@@ -43,10 +50,45 @@ class GvcEncoder
 	unsigned int m_maxBUWidth;
 	unsigned int m_maxBUHeight;
 	unsigned int m_maxTotalBUDepth;
+	unsigned int m_uiQuadtreeTULog2MaxSize;
+	unsigned int m_uiQuadtreeTULog2MinSize;
+	bool m_useRDOQ;
+	ScalingListMode m_useScalingListId;
+	int m_iPreset;                      ///< speed preset (0: slow, 1: medium, 2: fast)
+	unsigned int m_uiIntraRDCandidates;  ///< intra modes kept for full RD after the SATD pass (0: preset default)
+	unsigned int m_auiIntraModeNumFast[MAX_BU_DEPTH];  ///< size of the intra RD candidate list per block size (8x8 to 64x64)
+	int m_iFastSearch;    ///< motion search method (MESearchMethod)
+	int m_iSearchRange;   ///< motion search range in integer samples (0: whole frame)
+	bool m_bHadamardME;   ///< Hadamard distortion for the fractional motion refinement
+	bool m_bLoopFilterDisable;
+	int m_iLoopFilterBetaOffsetDiv2;
+	int m_iLoopFilterTcOffsetDiv2;
+	bool m_bUseSAO;
+	bool m_bWaveFrontSynchro;  ///< one substream per BU row, each row starting from the contexts after the second BU of the row above
+	int m_iNumThreads;         ///< threads coding BU rows or tiles (0: one per hardware thread)
+	int m_iFrameThreads;       ///< frames coded at once, each predicted from the one before
+	bool m_bPinThreads;        ///< each thread of the pool on a core of its own
+	bool m_bModeDecisionTasks; ///< the 2Nx2N candidates of a CU searched by a job of the pool while its split is searched
+	int m_iIntraPeriod;        ///< frames numbered a multiple of it are intra (-1: only the first)
+	bool m_bTileUniformSpacing;
+	int m_iNumTileColumns;
+	int m_iNumTileRows;
+	std::vector<int> m_aiTileColumnWidth;  ///< in BUs, the last column takes the rest of the frame
+	std::vector<int> m_aiTileRowHeight;    ///< in BUs, the last row takes the rest of the frame
 	ChromaFormat m_chromaFormat;
 	int m_bitDepth[MAX_NUM_CHANNEL_TYPE];
-    GvcFrameUnit* m_pcFrameOrg;
-    GvcFrameUnit* m_pcFrameRec;
+	int m_iSimdLevel;  ///< instruction set of the kernels (-1: best available)
+	GvcBitstream m_cBitstream;            ///< payload of the sequence header
+	std::vector<GvcAccessUnit> m_acAccessUnits;  ///< NAL units of the frames finished by the last call
+	int m_iNumBUEncoders;
+	GvcBUEncoder* m_pcBUEncoders;         ///< one per thread
+	int m_iNumSubstreams;                 ///< one per BU row with wavefront synchronisation, one per tile otherwise
+	GvcFrameEncoder* m_pcFrameEncoders;   ///< one per frame in flight, used in turn
+	int m_iNumFramesInFlight;
+	int m_iNextFrameEncoder;              ///< context of the next frame, the oldest in flight is m_iNumFramesInFlight before
+	GvcThreadPool m_cThreadPool;
+	GvcThreadPool* m_pcSharedThreadPool;  ///< pool of the caller, shared with other encoders, NULL for a pool of its own
+	bool m_bSequenceHeaderSent;           ///< with the first frame coded, which may not be frame 0
 
   public:
 	GvcEncoder();
@@ -59,24 +101,94 @@ class GvcEncoder
 	int       getFramesToBeEncoded            ()      { return  m_iFramesToBeEncoded; }
     void      setNumEncodedFrames                ( int   i )      { m_iNumEncodedFrames = i; }
     int       getNumEncodedFrames                ()      { return  m_iNumEncodedFrames; }
+	/// the next frame, numbered iFirstFrame, starts a stream of its own with the sequence header; none may be in flight
+	void      startSegment                    ( int   iFirstFrame ) { m_iNumEncodedFrames = iFirstFrame; m_bSequenceHeaderSent = false; }
 	void      setQP                           ( int   i )      { m_iQP = i; }
 	int       getQP                           ()      { return  m_iQP; }
 	void      setPad                          ( int*  iPad )      { for ( int i = 0; i < 2; i++ ) m_aiPad[i] = iPad[i]; }
 	int       getPad                          ( int i )      { return  m_aiPad[i]; }
 	void      setMaxBUWidth                   ( unsigned int  u )      { m_maxBUWidth  = u; }
+	unsigned int getMaxBUWidth                ()      { return  m_maxBUWidth; }
 	void      setMaxBUHeight                  ( unsigned int  u )      { m_maxBUHeight = u; }
+	unsigned int getMaxBUHeight               ()      { return  m_maxBUHeight; }
 	void      setMaxTotalBUDepth              ( unsigned int  u )      { m_maxTotalBUDepth = u; }
+	unsigned int getMaxTotalBUDepth           ()      { return  m_maxTotalBUDepth; }
+	void      setQuadtreeTULog2MaxSize        ( unsigned int  u )      { m_uiQuadtreeTULog2MaxSize = u; }
+	unsigned int getQuadtreeTULog2MaxSize     ()      { return  m_uiQuadtreeTULog2MaxSize; }
+	void      setQuadtreeTULog2MinSize        ( unsigned int  u )      { m_uiQuadtreeTULog2MinSize = u; }
+	void      setUseRDOQ                      ( bool  b )      { m_useRDOQ = b; }
+	bool      getUseRDOQ                      ()      { return  m_useRDOQ; }
+	void      setUseScalingListId             ( ScalingListMode u ) { m_useScalingListId = u; }
+	ScalingListMode getUseScalingListId       ()      { return  m_useScalingListId; }
+	void      setPreset                       ( int   i )      { m_iPreset = i; }
+	int       getPreset                       ()      { return  m_iPreset; }
+	void      setIntraRDCandidates            ( unsigned int u ) { m_uiIntraRDCandidates = u; }
+	unsigned int getIntraRDCandidates         ()      { return  m_uiIntraRDCandidates; }
+	void      setFastSearch                   ( int   i )      { m_iFastSearch = i; }
+	int       getFastSearch                   ()      { return  m_iFastSearch; }
+	void      setSearchRange                  ( int   i )      { m_iSearchRange = i; }
+	int       getSearchRange                  ()      { return  m_iSearchRange; }
+	void      setHadamardME                   ( bool  b )      { m_bHadamardME = b; }
+	bool      getHadamardME                   ()      { return  m_bHadamardME; }
+	void      setLoopFilterDisable            ( bool  b )      { m_bLoopFilterDisable = b; }
+	bool      getLoopFilterDisable            ()      { return  m_bLoopFilterDisable; }
+	void      setLoopFilterBetaOffsetDiv2     ( int   i )      { m_iLoopFilterBetaOffsetDiv2 = i; }
+	int       getLoopFilterBetaOffsetDiv2     ()      { return  m_iLoopFilterBetaOffsetDiv2; }
+	void      setLoopFilterTcOffsetDiv2       ( int   i )      { m_iLoopFilterTcOffsetDiv2 = i; }
+	int       getLoopFilterTcOffsetDiv2       ()      { return  m_iLoopFilterTcOffsetDiv2; }
+	void      setUseSAO                       ( bool  b )      { m_bUseSAO = b; }
+	bool      getUseSAO                       ()      { return  m_bUseSAO; }
+	void      setWaveFrontSynchro             ( bool  b )      { m_bWaveFrontSynchro = b; }
+	bool      getWaveFrontSynchro             ()      { return  m_bWaveFrontSynchro; }
+	void      setNumThreads                   ( int   i )      { m_iNumThreads = i; }
+	void      setFrameThreads                 ( int   i )      { m_iFrameThreads = i; }
+	int       getFrameThreads                 ()      { return  m_iFrameThreads; }
+	void      setPinThreads                   ( bool  b )      { m_bPinThreads = b; }
+	void      setModeDecisionTasks            ( bool  b )      { m_bModeDecisionTasks = b; }
+	bool      getModeDecisionTasks            ()      { return  m_bModeDecisionTasks; }
+	void      setIntraPeriod                  ( int   i )      { m_iIntraPeriod = i; }
+	int       getIntraPeriod                  ()      { return  m_iIntraPeriod; }
+	void      setTileUniformSpacing           ( bool  b )      { m_bTileUniformSpacing = b; }
+	void      setNumTileColumns               ( int   i )      { m_iNumTileColumns = i; }
+	void      setNumTileRows                  ( int   i )      { m_iNumTileRows = i; }
+	/// widths of the tile columns but the last, in BUs, without uniform spacing
+	void      setTileColumnWidths             ( const std::vector<int>& ai ) { m_aiTileColumnWidth = ai; }
+	/// heights of the tile rows but the last, in BUs, without uniform spacing
+	void      setTileRowHeights               ( const std::vector<int>& ai ) { m_aiTileRowHeight = ai; }
+	/// every column after create
+	const std::vector<int>& getTileColumnWidths() const { return m_aiTileColumnWidth; }
+	/// every row after create
+	const std::vector<int>& getTileRowHeights () const { return m_aiTileRowHeight; }
 	void      setChromaFormat                 ( ChromaFormat cf ) { m_chromaFormat = cf; }
 	ChromaFormat  getChromaFormat             ( )              { return m_chromaFormat; }
 	void      setBitDepth( const ChannelType chType, int internalBitDepthForChannel ) { m_bitDepth[chType] = internalBitDepthForChannel; }
-    GvcFrameUnit* getFrameOrg() { return m_pcFrameOrg; }
-    void setFrameOrg(GvcFrameUnit* frame) { m_pcFrameOrg = frame; }
-    GvcFrameUnit* getFrameRec() { return m_pcFrameRec; }
-    void setFrameRec(GvcFrameUnit* frame) { m_pcFrameRec = frame; }
+	int       getBitDepth( const ChannelType chType ) { return m_bitDepth[chType]; }
+	void      setSimdLevel                    ( int   i )      { m_iSimdLevel = i; }
+	int       getNumSubstreams                ()      { return  m_iNumSubstreams; }
+	GvcBUEncoder* getBUEncoder                ( int i )      { return &m_pcBUEncoders[i]; }
+	/// runs on a pool of the caller instead of creating one of Threads threads; set before create, the pool outlives
+	/// the encoder and the caller waits for it (waitAll) before destroy
+	void      setThreadPool                   ( GvcThreadPool* p ) { m_pcSharedThreadPool = p; }
+	GvcThreadPool* getThreadPool              ()      { return m_pcSharedThreadPool ? m_pcSharedThreadPool : &m_cThreadPool; }
+	/// threads the substreams of the frames in flight, and their forked searches, can keep busy at once
+	int       getMaxUsefulThreads             () const;
+	/// access unit of the i-th frame finished by the last call to encode or flush, in coding order
+	const GvcAccessUnit& getAccessUnit( int i ) const { return m_acAccessUnits[i]; }
 	void      create();
-	void      encode(GvcFrameUnit* pcFrameOrg, GvcFrameUnit* pcFrameRec);
-	void      encodeFrameUnit();
-	void      encodeBlockUnit();
+	void      destroy();
+	/// pads the source of frame iFrameNumber and builds its pyramid, for the pyramid search; may run ahead of encode, on
+	/// other threads, for frames not handed to it yet
+	void      prepareMotionSearch(GvcFrameUnit* pcFrameOrg, int iFrameNumber);
+	/// starts coding a frame, pcFrameRef may still be in flight and is ignored on an intra frame; riNumEncoded frames
+	/// are finished, the oldest first. bPrepared: prepareMotionSearch was called on pcFrameOrg
+	void      encode(GvcFrameUnit* pcFrameOrg, GvcFrameUnit* pcFrameRec, GvcFrameUnit* pcFrameRef, int& riNumEncoded, bool bPrepared = false);
+	/// finishes every frame in flight
+	void      flush(int& riNumEncoded);
+	void      printSummary();
+
+  private:
+	void      xFinishOldestFrame();
+	void      xWriteSequenceHeader(GvcAccessUnit& rcAccessUnit);
 };
 
 #endif  // __GVCENCODER_H__
@@ -0,0 +1,322 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcFrameDecoder.cpp
+ * \brief    Decoding of one frame
+ */
+
+#include "GvcFrameDecoder.h"
+
+#include <algorithm>
+
+#include "GvcBitstream.h"
+#include "GvcBUDecoder.h"
+#include "GvcDecoder.h"
+#include "GvcFrameUnit.h"
+#include "GvcSao.h"
+
+GvcFrameDecoder::GvcFrameDecoder()
+    : m_pcDecoder( NULL )
+    , m_pcFrameRec( NULL )
+    , m_pcFrameRef( NULL )
+    , m_eFrameType( I_FRAME )
+    , m_iQP( 0 )
+    , m_iFrameNumber( 0 )
+    , m_uiNumBytes( 0 )
+    , m_iNumSubstreams( 0 )
+    , m_pcSubstreams( NULL )
+    , m_pcRowProgress( NULL )
+    , m_iNumSubstreamsLeft( 0 )
+    , m_iNumRowsDecoded( 0 )
+    , m_bError( false )
+{
+}
+
+GvcFrameDecoder::~GvcFrameDecoder()
+{
+	destroy();
+}
+
+void GvcFrameDecoder::create( GvcDecoder* pcDecoder )
+{
+	m_pcDecoder = pcDecoder;
+	const int iHeightInBUs = ( pcDecoder->getSourceHeight() + pcDecoder->getMaxBUHeight() - 1 ) / pcDecoder->getMaxBUHeight();
+	m_iNumSubstreams = pcDecoder->getNumSubstreams();
+	m_pcSubstreams = new GvcSubstreamDecoder[m_iNumSubstreams];
+	for( int i = 0; i < m_iNumSubstreams; i++ )
+	{
+		m_pcSubstreams[i].cSbac.init( &m_pcSubstreams[i].cBinDecoder );
+	}
+	m_auiSubstreamOffset.resize( m_iNumSubstreams + 1 );
+	m_acSyncContexts.resize( iHeightInBUs );
+	m_pcRowProgress = new GvcRowProgress[iHeightInBUs];
+	m_aiNumBUsDecodedInRow.resize( iHeightInBUs );
+
+	int aiBitDepth[MAX_NUM_CHANNEL_TYPE];
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		aiBitDepth[ch] = pcDecoder->getBitDepth( ChannelType( ch ) );
+	}
+	m_cInLoopFilter.getLoopFilter().setParameters( pcDecoder->getLoopFilterDisable(), pcDecoder->getLoopFilterBetaOffsetDiv2(), pcDecoder->getLoopFilterTcOffsetDiv2() );
+	m_cInLoopFilter.setSaoEnabled( pcDecoder->getUseSAO() );
+	m_cInLoopFilter.setThreadPool( pcDecoder->getThreadPool() );
+	m_cInLoopFilter.create( pcDecoder->getSourceWidth(), pcDecoder->getSourceHeight(), pcDecoder->getChromaFormat(), pcDecoder->getMaxBUWidth(),
+	                        pcDecoder->getMaxBUHeight(), aiBitDepth, pcDecoder->getQuadtreeTULog2MaxSize() );
+}
+
+void GvcFrameDecoder::destroy()
+{
+	delete[] m_pcSubstreams;
+	m_pcSubstreams = NULL;
+	m_iNumSubstreams = 0;
+	delete[] m_pcRowProgress;
+	m_pcRowProgress = NULL;
+	m_cInLoopFilter.destroy();
+}
+
+/** Frame type, QP and frame number, then the byte size of each substream but the last, as written by
+ *  GvcFrameEncoder::xWriteFrameHeader. The substreams must fit in the payload.
+ */
+bool GvcFrameDecoder::parseFrameHeader( std::vector<unsigned char>& raucPayload )
+{
+	m_aucPayload.swap( raucPayload );
+	m_uiNumBytes = (unsigned int)m_aucPayload.size();
+	if( m_aucPayload.empty() )
+	{
+		return false;
+	}
+	GvcInputBitstream cBitstream;
+	cBitstream.init( &m_aucPayload[0], m_uiNumBytes );
+	m_eFrameType = FrameType( cBitstream.read( 1 ) );
+	m_iQP = cBitstream.read( 6 );
+	m_iFrameNumber = (int)std::min<unsigned int>( cBitstream.readUvlc(), MAX_INT );
+	unsigned long long uiOffset = 0;
+	for( int i = 0; i + 1 < m_iNumSubstreams; i++ )
+	{
+		m_auiSubstreamOffset[i + 1] = (unsigned int)std::min<unsigned long long>( uiOffset += cBitstream.readUvlc() + 1ull, m_uiNumBytes );
+	}
+	if( !cBitstream.readRBSPTrailingBits() || cBitstream.getOverrun() || m_iQP > MAX_QP )
+	{
+		return false;
+	}
+	// the substreams follow the header, the last one takes the rest of the payload
+	const unsigned int uiHeaderBytes = cBitstream.getByteLocation();
+	if( uiHeaderBytes + uiOffset >= m_uiNumBytes )
+	{
+		return false;
+	}
+	m_auiSubstreamOffset[0] = 0;
+	m_auiSubstreamOffset[m_iNumSubstreams] = m_uiNumBytes - uiHeaderBytes;
+	for( int i = 0; i <= m_iNumSubstreams; i++ )
+	{
+		m_auiSubstreamOffset[i] += uiHeaderBytes;
+	}
+	return true;
+}
+
+void GvcFrameDecoder::startFrame( GvcFrameUnit* pcFrameRec, GvcFrameUnit* pcFrameRef, int iPriority )
+{
+	m_pcFrameRec = pcFrameRec;
+	m_pcFrameRef = m_eFrameType == P_FRAME ? pcFrameRef : NULL;
+	m_bError = false;
+	m_pcFrameRec->initTiles( m_pcDecoder->getTileColumnWidths(), m_pcDecoder->getTileRowHeights() );
+	m_cInLoopFilter.startFrame( NULL, m_pcFrameRec, m_iQP, 0.0, iPriority );
+	for( int iBURow = 0; iBURow < m_pcFrameRec->getFrameHeightInBUs(); iBURow++ )
+	{
+		m_pcRowProgress[iBURow].reset();
+		m_aiNumBUsDecodedInRow[iBURow] = 0;
+	}
+	m_iNumRowsDecoded = 0;
+	m_iNumSubstreamsLeft = m_iNumSubstreams;
+	GvcThreadPool* pcThreadPool = m_pcDecoder->getThreadPool();
+	if( pcThreadPool->getNumThreads() > 1 )
+	{
+		// as in GvcFrameEncoder::startFrame, a substream only waits for the substreams queued before it, of this
+		// frame or of the frames before it, and for their in-loop filters, queued with a lower priority
+		for( int iSubstream = 0; iSubstream < m_iNumSubstreams; iSubstream++ )
+		{
+			pcThreadPool->enqueue( [this, iSubstream]( int iThreadIdx ) { xDecodeSubstream( iSubstream, m_pcDecoder->getBUDecoder( iThreadIdx ) ); },
+			                       iPriority );
+		}
+	}
+	else
+	{
+		for( int iSubstream = 0; iSubstream < m_iNumSubstreams; iSubstream++ )
+		{
+			xDecodeSubstream( iSubstream, m_pcDecoder->getBUDecoder( 0 ) );
+		}
+	}
+}
+
+bool GvcFrameDecoder::finishFrame()
+{
+	{
+		std::unique_lock<std::mutex> lock( m_cMutex );
+		m_cDoneCond.wait( lock, [this] { return m_iNumSubstreamsLeft == 0; } );
+	}
+	// pads the last rows, the next frame may reference this one as a whole
+	m_cInLoopFilter.finishFrame();
+	std::lock_guard<std::mutex> lock( m_cMutex );
+	return !m_bError;
+}
+
+/** Decodes a tile, or with wavefront synchronisation a BU row, in the order of GvcFrameEncoder::xEncodeSubstream.
+ *  Once a BU does not parse, the BUs left are only initialised and their rows still reported, so that the rows
+ *  waiting for them and the in-loop filters go on.
+ */
+void GvcFrameDecoder::xDecodeSubstream( int iSubstream, GvcBUDecoder* pcBUDecoder )
+{
+	const bool bWaveFrontSynchro = m_pcDecoder->getWaveFrontSynchro();
+	const int iWidthInBUs = m_pcFrameRec->getFrameWidthInBUs();
+	const int iNumBUs = m_pcFrameRec->getNumBUsInFrame();
+	const GvcTile& rcTile = m_pcFrameRec->getTile( bWaveFrontSynchro ? 0 : iSubstream );
+	const int iFirstBURow = bWaveFrontSynchro ? iSubstream : rcTile.iFirstBURow;
+	const int iEndBURow = bWaveFrontSynchro ? iSubstream + 1 : rcTile.iFirstBURow + rcTile.iHeightInBUs;
+	const int iEndBUCol = rcTile.iFirstBUCol + rcTile.iWidthInBUs;
+	GvcSubstreamDecoder* pcSubstream = &m_pcSubstreams[iSubstream];
+	GvcSbacDecoder* pcSbac = &pcSubstream->cSbac;
+	bool bParsed = true;
+
+	pcBUDecoder->initFrame( m_pcFrameRec, m_pcFrameRef, m_iQP );
+	pcSubstream->cBinDecoder.init( &m_aucPayload[m_auiSubstreamOffset[iSubstream]], m_auiSubstreamOffset[iSubstream + 1] - m_auiSubstreamOffset[iSubstream] );
+	if( bWaveFrontSynchro && iSubstream > 0 && iWidthInBUs > 1 )
+	{
+		m_pcRowProgress[iSubstream - 1].wait( 2 );
+		pcSbac->loadContexts( m_acSyncContexts[iSubstream - 1] );
+	}
+	else
+	{
+		pcSbac->resetEntropy( m_eFrameType, m_iQP );
+	}
+	pcSubstream->cBinDecoder.start();
+	for( int iBURow = iFirstBURow; iBURow < iEndBURow; iBURow++ )
+	{
+		for( int iBUCol = rcTile.iFirstBUCol; iBUCol < iEndBUCol; iBUCol++ )
+		{
+			if( bWaveFrontSynchro && iBURow > 0 )
+			{
+				m_pcRowProgress[iBURow - 1].wait( std::min( iBUCol + 2, iWidthInBUs ) );
+			}
+			const int iBUAddr = iBURow * iWidthInBUs + iBUCol;
+			if( bParsed )
+			{
+				pcBUDecoder->decodeBU( pcSbac, iBUAddr );
+				// end of frame flag, the last one follows the SAO offsets
+				if( iBUAddr + 1 < iNumBUs )
+				{
+					unsigned int uiBin;
+					pcSbac->parseTerminatingBit( uiBin );
+					bParsed = !uiBin && !pcSubstream->cBinDecoder.getOverrun();
+				}
+			}
+			else
+			{
+				pcBUDecoder->skipBU( iBUAddr );
+			}
+			if( bWaveFrontSynchro && iBUCol == 1 )
+			{
+				pcSbac->storeContexts( m_acSyncContexts[iBURow] );
+			}
+			if( bWaveFrontSynchro )
+			{
+				m_pcRowProgress[iBURow].set( iBUCol + 1 );
+			}
+		}
+		xSetRowDecoded( iBURow, rcTile.iWidthInBUs );
+	}
+	if( iSubstream + 1 == m_iNumSubstreams && m_pcDecoder->getUseSAO() )
+	{
+		bParsed = bParsed && xDecodeSaoParameters( pcSbac );
+		m_cInLoopFilter.setSaoParametersKnown();
+	}
+	// end of the frame, or of the substream
+	if( bParsed )
+	{
+		unsigned int uiBin;
+		pcSbac->parseTerminatingBit( uiBin );
+		bParsed = uiBin && !pcSubstream->cBinDecoder.getOverrun();
+	}
+	std::lock_guard<std::mutex> lock( m_cMutex );
+	m_bError |= !bParsed;
+	if( --m_iNumSubstreamsLeft == 0 )
+	{
+		m_cDoneCond.notify_all();
+	}
+}
+
+/** The in-loop filters take the rows from the top of the frame, a row is complete once every tile it crosses
+ *  has decoded it.
+ */
+void GvcFrameDecoder::xSetRowDecoded( int iBURow, int iNumBUs )
+{
+	int iNumRowsDecoded = 0;
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		m_aiNumBUsDecodedInRow[iBURow] += iNumBUs;
+		iNumRowsDecoded = m_iNumRowsDecoded;
+		while( m_iNumRowsDecoded < m_pcFrameRec->getFrameHeightInBUs() && m_aiNumBUsDecodedInRow[m_iNumRowsDecoded] == m_pcFrameRec->getFrameWidthInBUs() )
+		{
+			m_iNumRowsDecoded++;
+		}
+		if( m_iNumRowsDecoded == iNumRowsDecoded )
+		{
+			return;
+		}
+		iNumRowsDecoded = m_iNumRowsDecoded;
+	}
+	// outside the lock, the filters may run here
+	m_cInLoopFilter.rowCoded( iNumRowsDecoded - 1 );
+}
+
+/** The offsets of every BU, in raster order after the last BU. A merged BU takes the offsets of its neighbour. On a
+ *  parse error the offsets left are switched off, the SAO stage must still run.
+ */
+bool GvcFrameDecoder::xDecodeSaoParameters( GvcSbacDecoder* pcSbac )
+{
+	GvcSao& rcSao = m_cInLoopFilter.getSao();
+	const int iWidthInBUs = m_pcFrameRec->getFrameWidthInBUs();
+	const ChromaFormat chromaFormat = m_pcDecoder->getChromaFormat();
+	int aiBitDepth[MAX_NUM_CHANNEL_TYPE];
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		aiBitDepth[ch] = m_pcDecoder->getBitDepth( ChannelType( ch ) );
+	}
+	bool bParsed = true;
+	for( int iBUAddr = 0; iBUAddr < m_pcFrameRec->getNumBUsInFrame(); iBUAddr++ )
+	{
+		GvcSaoBlkParam& rcParam = rcSao.getBlkParam( iBUAddr );
+		if( !bParsed )
+		{
+			rcParam.reset();
+			continue;
+		}
+		bool bLeftAvail, bAboveAvail;
+		GvcSao::getMergeAvail( m_pcFrameRec, iBUAddr, bLeftAvail, bAboveAvail );
+		pcSbac->parseSaoBlkParam( rcParam, bLeftAvail, bAboveAvail, chromaFormat, aiBitDepth );
+		if( rcParam.eMerge != SAO_MERGE_NONE )
+		{
+			const SaoMergeMode eMerge = rcParam.eMerge;
+			rcParam = rcSao.getBlkParam( eMerge == SAO_MERGE_LEFT ? iBUAddr - 1 : iBUAddr - iWidthInBUs );
+			rcParam.eMerge = eMerge;
+		}
+		bParsed = !m_pcSubstreams[m_iNumSubstreams - 1].cBinDecoder.getOverrun();
+	}
+	return bParsed;
+}
@@ -0,0 +1,111 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcFrameDecoder.h
+ * \brief    Decoding of one frame (header)
+ */
+
+#ifndef __GVCFRAMEDECODER_H__
+#define __GVCFRAMEDECODER_H__
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "TypeDef.h"
+#include "GvcBinDecoderCABAC.h"
+#include "GvcInLoopFilter.h"
+#include "GvcSbacDecoder.h"
+#include "GvcThreadPool.h"
+
+class GvcBUDecoder;
+class GvcDecoder;
+class GvcFrameUnit;
+
+/// arithmetic decoder of a substream: a tile, or a BU row with wavefront synchronisation
+struct GvcSubstreamDecoder
+{
+	GvcBinDecoderCABAC cBinDecoder;
+	GvcSbacDecoder cSbac;
+};
+
+/**
+ * \class    GvcFrameDecoder
+ * \brief    Decodes the payload of a frame NAL unit into a frame, the counterpart of GvcFrameEncoder
+ *
+ * parseFrameHeader takes the payload, startFrame decodes the substreams and finishFrame waits for them and for the
+ * in-loop filters. With a thread pool the substreams are jobs of the pool and startFrame returns at once; several
+ * frames may then be in flight, each one reading the rows of its reference as they are finished. A corrupt payload
+ * does not stop the frame: the substream that fails is left unparsed from there, so that the rows and the filters
+ * still complete, and finishFrame reports it.
+ */
+class GvcFrameDecoder
+{
+	GvcDecoder* m_pcDecoder;
+	GvcFrameUnit* m_pcFrameRec;
+	GvcFrameUnit* m_pcFrameRef;  ///< previous frame, NULL for an intra frame
+	FrameType m_eFrameType;
+	int m_iQP;
+	int m_iFrameNumber;
+	std::vector<unsigned char> m_aucPayload;  ///< NAL unit payload of the frame
+	unsigned int m_uiNumBytes;                ///< NAL unit payload size, for the statistics
+	GvcInLoopFilter m_cInLoopFilter;          ///< deblocking and SAO of the reconstruction, BU rows behind the decoding
+	int m_iNumSubstreams;
+	GvcSubstreamDecoder* m_pcSubstreams;             ///< one per BU row with wavefront synchronisation, one per tile otherwise
+	std::vector<unsigned int> m_auiSubstreamOffset;  ///< first byte of each substream in the payload, and its end
+	std::vector<GvcSbacContexts> m_acSyncContexts;   ///< contexts after the second BU of each row
+	GvcRowProgress* m_pcRowProgress;                 ///< decoded BUs of each row
+	std::mutex m_cMutex;
+	std::condition_variable m_cDoneCond;      ///< the last substream is decoded
+	int m_iNumSubstreamsLeft;                 ///< substreams of the frame not decoded yet
+	std::vector<int> m_aiNumBUsDecodedInRow;  ///< over all tiles
+	int m_iNumRowsDecoded;                    ///< complete rows at the top of the frame, handed to the in-loop filters
+	bool m_bError;                            ///< a substream does not parse
+
+  public:
+	GvcFrameDecoder();
+	virtual ~GvcFrameDecoder();
+
+	void create( GvcDecoder* pcDecoder );
+	void destroy();
+
+	/// takes the payload of a frame NAL unit, swapped out of raucPayload, false if its header is not valid; the frame
+	/// type is then known and pcFrameRef is only read by a predicted frame
+	bool parseFrameHeader( std::vector<unsigned char>& raucPayload );
+	/// decodes the frame into pcFrameRec, pcFrameRef may still be in flight; the jobs of the frame are queued with
+	/// iPriority, which must grow from frame to frame
+	void startFrame( GvcFrameUnit* pcFrameRec, GvcFrameUnit* pcFrameRef, int iPriority );
+	/// waits for the substreams and the in-loop filters, false if a substream did not parse
+	bool finishFrame();
+
+	FrameType getFrameType() const { return m_eFrameType; }
+	int getQP() const { return m_iQP; }
+	int getFrameNumber() const { return m_iFrameNumber; }
+	unsigned int getNumBytes() const { return m_uiNumBytes; }
+	GvcFrameUnit* getFrameRec() { return m_pcFrameRec; }
+	GvcFrameUnit* getFrameRef() { return m_pcFrameRef; }
+
+  private:
+	void xDecodeSubstream( int iSubstream, GvcBUDecoder* pcBUDecoder );
+	void xSetRowDecoded( int iBURow, int iNumBUs );
+	bool xDecodeSaoParameters( GvcSbacDecoder* pcSbac );
+};
+
+#endif  // __GVCFRAMEDECODER_H__
@@ -0,0 +1,289 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcFrameEncoder.cpp
+ * \brief    Coding of one frame, several frames in flight at once
+ */
+
+#include "GvcFrameEncoder.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "GvcBUEncoder.h"
+#include "GvcEncoder.h"
+#include "GvcFrameUnit.h"
+
+GvcFrameEncoder::GvcFrameEncoder()
+    : m_pcEncoder( NULL )
+    , m_pcFrameOrg( NULL )
+    , m_pcFrameRec( NULL )
+    , m_pcFrameRef( NULL )
+    , m_iQP( 0 )
+    , m_dLambda( 0.0 )
+    , m_iFrameNumber( 0 )
+    , m_iRefLagRows( -1 )
+    , m_iNumSubstreams( 0 )
+    , m_pcSubstreams( NULL )
+    , m_pcRowProgress( NULL )
+    , m_iNumRowsCoded( 0 )
+    , m_iNumSubstreamsLeft( 0 )
+{
+}
+
+GvcFrameEncoder::~GvcFrameEncoder()
+{
+	destroy();
+}
+
+void GvcFrameEncoder::create( GvcEncoder* pcEncoder )
+{
+	m_pcEncoder = pcEncoder;
+	const int iHeightInBUs = ( pcEncoder->getSourceHeight() + pcEncoder->getMaxBUHeight() - 1 ) / pcEncoder->getMaxBUHeight();
+	m_iNumSubstreams = pcEncoder->getNumSubstreams();
+	m_pcSubstreams = new GvcSubstreamCoder[m_iNumSubstreams];
+	for( int i = 0; i < m_iNumSubstreams; i++ )
+	{
+		m_pcSubstreams[i].cBinEncoder.init( &m_pcSubstreams[i].cBitstream );
+		m_pcSubstreams[i].cSbac.init( &m_pcSubstreams[i].cBinEncoder );
+	}
+	m_acSyncContexts.resize( iHeightInBUs );
+	m_pcRowProgress = new GvcRowProgress[iHeightInBUs];
+	m_aiNumBUsCodedInRow.resize( iHeightInBUs );
+
+	int aiBitDepth[MAX_NUM_CHANNEL_TYPE];
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		aiBitDepth[ch] = pcEncoder->getBitDepth( ChannelType( ch ) );
+	}
+	m_cInLoopFilter.getLoopFilter().setParameters( pcEncoder->getLoopFilterDisable(), pcEncoder->getLoopFilterBetaOffsetDiv2(), pcEncoder->getLoopFilterTcOffsetDiv2() );
+	m_cInLoopFilter.setSaoEnabled( pcEncoder->getUseSAO() );
+	m_cInLoopFilter.setBuildPyramid( pcEncoder->getFastSearch() == ME_PYRAMID );
+	m_cInLoopFilter.setThreadPool( pcEncoder->getThreadPool() );
+	m_cInLoopFilter.create( pcEncoder->getSourceWidth(), pcEncoder->getSourceHeight(), pcEncoder->getChromaFormat(), pcEncoder->getMaxBUWidth(),
+	                        pcEncoder->getMaxBUHeight(), aiBitDepth, pcEncoder->getQuadtreeTULog2MaxSize() );
+}
+
+void GvcFrameEncoder::destroy()
+{
+	delete[] m_pcSubstreams;
+	m_pcSubstreams = NULL;
+	m_iNumSubstreams = 0;
+	delete[] m_pcRowProgress;
+	m_pcRowProgress = NULL;
+	m_cInLoopFilter.destroy();
+}
+
+void GvcFrameEncoder::startFrame( GvcFrameUnit* pcFrameOrg, GvcFrameUnit* pcFrameRec, GvcFrameUnit* pcFrameRef, int iFrameNumber )
+{
+	m_pcFrameOrg = pcFrameOrg;
+	m_pcFrameRec = pcFrameRec;
+	m_pcFrameRef = pcFrameRef;
+	m_iFrameNumber = iFrameNumber;
+	m_iQP = m_pcEncoder->getQP();
+	m_dLambda = 0.57 * pow( 2.0, ( m_iQP - 12 ) / 3.0 );
+	m_pcFrameRec->initTiles( m_pcEncoder->getTileColumnWidths(), m_pcEncoder->getTileRowHeights() );
+	m_cInLoopFilter.startFrame( m_pcFrameOrg, m_pcFrameRec, m_iQP, m_dLambda, m_iFrameNumber );
+	for( int iBURow = 0; iBURow < m_pcFrameRec->getFrameHeightInBUs(); iBURow++ )
+	{
+		m_pcRowProgress[iBURow].reset();
+		m_aiNumBUsCodedInRow[iBURow] = 0;
+	}
+	m_iNumRowsCoded = 0;
+	m_iNumSubstreamsLeft = m_iNumSubstreams;
+	GvcThreadPool* pcThreadPool = m_pcEncoder->getThreadPool();
+	if( pcThreadPool->getNumThreads() > 1 )
+	{
+		// the substreams are queued in order with the frame number as priority, a substream only waits for the
+		// substreams queued before it, of this frame or of the older ones, which the pool starts first
+		for( int iSubstream = 0; iSubstream < m_iNumSubstreams; iSubstream++ )
+		{
+			pcThreadPool->enqueue( [this, iSubstream]( int iThreadIdx ) { xEncodeSubstream( iSubstream, m_pcEncoder->getBUEncoder( iThreadIdx ) ); },
+			                       m_iFrameNumber );
+		}
+	}
+	else
+	{
+		for( int iSubstream = 0; iSubstream < m_iNumSubstreams; iSubstream++ )
+		{
+			xEncodeSubstream( iSubstream, m_pcEncoder->getBUEncoder( 0 ) );
+		}
+	}
+}
+
+void GvcFrameEncoder::finishFrame()
+{
+	{
+		std::unique_lock<std::mutex> lock( m_cMutex );
+		m_cDoneCond.wait( lock, [this] { return m_iNumSubstreamsLeft == 0; } );
+	}
+
+	// the entry points in the header are only known once every substream is complete
+	m_cBitstream.clear();
+	xWriteFrameHeader();
+	for( int i = 0; i < m_iNumSubstreams; i++ )
+	{
+		m_cBitstream.addSubstream( m_pcSubstreams[i].cBitstream );
+	}
+	m_cAccessUnit.addNALUnit( NAL_UNIT_FRAME, m_cBitstream );
+	// pads and builds the pyramid of the last rows, the next frame may reference this one as a whole
+	m_cInLoopFilter.finishFrame();
+}
+
+/** Codes a tile, or with wavefront synchronisation a BU row of the frame, which then is a single tile. Every
+ *  substream starts from the initial context states, except that with wavefronts a row starts from the states
+ *  left after the second BU of the row above. A BU of a wavefront is coded once the row above is two BUs ahead,
+ *  when the BUs above and above right are reconstructed. A BU row of a predicted frame first waits for the rows
+ *  of the reference its motion search reads.
+ */
+void GvcFrameEncoder::xEncodeSubstream( int iSubstream, GvcBUEncoder* pcBUEncoder )
+{
+	const bool bWaveFrontSynchro = m_pcEncoder->getWaveFrontSynchro();
+	const int iWidthInBUs = m_pcFrameRec->getFrameWidthInBUs();
+	const int iHeightInBUs = m_pcFrameRec->getFrameHeightInBUs();
+	const int iNumBUs = m_pcFrameRec->getNumBUsInFrame();
+	const GvcTile& rcTile = m_pcFrameRec->getTile( bWaveFrontSynchro ? 0 : iSubstream );
+	const int iFirstBURow = bWaveFrontSynchro ? iSubstream : rcTile.iFirstBURow;
+	const int iEndBURow = bWaveFrontSynchro ? iSubstream + 1 : rcTile.iFirstBURow + rcTile.iHeightInBUs;
+	const int iEndBUCol = rcTile.iFirstBUCol + rcTile.iWidthInBUs;
+	GvcSubstreamCoder* pcSubstream = &m_pcSubstreams[iSubstream];
+	GvcSbac* pcSbac = &pcSubstream->cSbac;
+
+	pcBUEncoder->initFrame( m_pcFrameOrg, m_pcFrameRec, m_pcFrameRef, m_iQP, m_dLambda );
+	pcSubstream->cBitstream.clear();
+	if( bWaveFrontSynchro && iSubstream > 0 && iWidthInBUs > 1 )
+	{
+		m_pcRowProgress[iSubstream - 1].wait( 2 );
+		pcSbac->loadContexts( m_acSyncContexts[iSubstream - 1] );
+	}
+	else
+	{
+		pcSbac->resetEntropy( m_pcFrameRef ? P_FRAME : I_FRAME, m_iQP );
+	}
+	pcSubstream->cBinEncoder.start();
+	for( int iBURow = iFirstBURow; iBURow < iEndBURow; iBURow++ )
+	{
+		if( m_pcFrameRef )
+		{
+			// the window does not depend on how far the reference is, the frame is the same with any thread count
+			const int iNumRefRows = m_iRefLagRows < 0 ? iHeightInBUs : std::min( iHeightInBUs, iBURow + 1 + m_iRefLagRows );
+			m_pcFrameRef->getRowProgress().wait( iNumRefRows );
+			pcBUEncoder->setNumRefLines( iNumRefRows < iHeightInBUs ? iNumRefRows * m_pcFrameRec->getMaxBUHeight() : 0 );
+		}
+		for( int iBUCol = rcTile.iFirstBUCol; iBUCol < iEndBUCol; iBUCol++ )
+		{
+			if( bWaveFrontSynchro && iBURow > 0 )
+			{
+				m_pcRowProgress[iBURow - 1].wait( std::min( iBUCol + 2, iWidthInBUs ) );
+			}
+			const int iBUAddr = iBURow * iWidthInBUs + iBUCol;
+			pcBUEncoder->compressBU( iBUAddr, pcSbac );
+			pcBUEncoder->encodeBU( pcSbac, iBUAddr );
+			if( bWaveFrontSynchro && iBUCol == 1 )
+			{
+				pcSbac->storeContexts( m_acSyncContexts[iBURow] );
+			}
+			// end of frame flag, the last one follows the SAO offsets
+			if( iBUAddr + 1 < iNumBUs )
+			{
+				pcSbac->codeTerminatingBit( 0 );
+			}
+			if( bWaveFrontSynchro )
+			{
+				m_pcRowProgress[iBURow].set( iBUCol + 1 );
+			}
+		}
+		xSetRowCoded( iBURow, rcTile.iWidthInBUs );
+	}
+	if( iSubstream + 1 == m_iNumSubstreams && m_pcEncoder->getUseSAO() )
+	{
+		xEncodeSaoParameters( pcSbac );
+	}
+	// end of the frame, or of the substream
+	pcSbac->codeTerminatingBit( 1 );
+	pcSubstream->cBinEncoder.finish();
+	pcSubstream->cBitstream.writeRBSPTrailingBits();
+
+	std::lock_guard<std::mutex> lock( m_cMutex );
+	if( --m_iNumSubstreamsLeft == 0 )
+	{
+		m_cDoneCond.notify_all();
+	}
+}
+
+/** The in-loop filters take the rows from the top of the frame, a row is complete once every tile it crosses
+ *  has coded it.
+ */
+void GvcFrameEncoder::xSetRowCoded( int iBURow, int iNumBUs )
+{
+	int iNumRowsCoded = 0;
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		m_aiNumBUsCodedInRow[iBURow] += iNumBUs;
+		iNumRowsCoded = m_iNumRowsCoded;
+		while( m_iNumRowsCoded < m_pcFrameRec->getFrameHeightInBUs() && m_aiNumBUsCodedInRow[m_iNumRowsCoded] == m_pcFrameRec->getFrameWidthInBUs() )
+		{
+			m_iNumRowsCoded++;
+		}
+		if( m_iNumRowsCoded == iNumRowsCoded )
+		{
+			return;
+		}
+		iNumRowsCoded = m_iNumRowsCoded;
+	}
+	// outside the lock, the filters may run here
+	m_cInLoopFilter.rowCoded( iNumRowsCoded - 1 );
+}
+
+/** Frame type, QP and frame number, then the byte size of each substream but the last so that a decoder can start
+ *  every BU row at once. Byte aligned so that the arithmetic coder starts on a byte.
+ */
+void GvcFrameEncoder::xWriteFrameHeader()
+{
+	m_cBitstream.write( m_pcFrameRef ? P_FRAME : I_FRAME, 1 );
+	m_cBitstream.write( m_iQP, 6 );
+	m_cBitstream.writeUvlc( m_iFrameNumber );
+	for( int i = 0; i + 1 < m_iNumSubstreams; i++ )
+	{
+		m_cBitstream.writeUvlc( m_pcSubstreams[i].cBitstream.getByteStreamLength() - 1 );
+	}
+	m_cBitstream.writeRBSPTrailingBits();
+}
+
+/** The offsets of every BU, in raster order after the last BU: they are decided from the statistics of whole BU
+ *  rows, while the BUs are written as soon as they are coded.
+ */
+void GvcFrameEncoder::xEncodeSaoParameters( GvcSbac* pcSbac )
+{
+	m_cInLoopFilter.waitSaoParameters();
+	const GvcSao& rcSao = m_cInLoopFilter.getSao();
+	const ChromaFormat chromaFormat = m_pcEncoder->getChromaFormat();
+	int aiBitDepth[MAX_NUM_CHANNEL_TYPE];
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		aiBitDepth[ch] = m_pcEncoder->getBitDepth( ChannelType( ch ) );
+	}
+	for( int iBUAddr = 0; iBUAddr < m_pcFrameRec->getNumBUsInFrame(); iBUAddr++ )
+	{
+		bool bLeftAvail, bAboveAvail;
+		GvcSao::getMergeAvail( m_pcFrameRec, iBUAddr, bLeftAvail, bAboveAvail );
+		pcSbac->codeSaoBlkParam( rcSao.getBlkParam( iBUAddr ), bLeftAvail, bAboveAvail, chromaFormat, aiBitDepth );
+	}
+}
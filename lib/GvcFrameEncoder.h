@@ -0,0 +1,105 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcFrameEncoder.h
+ * \brief    Coding of one frame, several frames in flight at once (header)
+ */
+
+#ifndef __GVCFRAMEENCODER_H__
+#define __GVCFRAMEENCODER_H__
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "TypeDef.h"
+#include "GvcBinEncoderCABAC.h"
+#include "GvcBitstream.h"
+#include "GvcInLoopFilter.h"
+#include "GvcNal.h"
+#include "GvcSbac.h"
+#include "GvcThreadPool.h"
+
+class GvcBUEncoder;
+class GvcEncoder;
+class GvcFrameUnit;
+
+/// arithmetic coder of a substream: a tile, or a BU row with wavefront synchronisation
+struct GvcSubstreamCoder
+{
+	GvcBitstream cBitstream;
+	GvcBinEncoderCABAC cBinEncoder;
+	GvcSbac cSbac;
+};
+
+/**
+ * \class    GvcFrameEncoder
+ * \brief    Codes a frame from its substreams to its access unit, one instance per frame in flight
+ *
+ * startFrame queues the substreams on the thread pool of the encoder and returns, finishFrame waits for them and
+ * writes the NAL unit. A frame predicted from one still in flight waits, row by row, for the reference rows its
+ * motion search reads: the lag set by setRefLagRows bounds how far below the BU row the search may go.
+ */
+class GvcFrameEncoder
+{
+	GvcEncoder* m_pcEncoder;
+	GvcFrameUnit* m_pcFrameOrg;
+	GvcFrameUnit* m_pcFrameRec;
+	GvcFrameUnit* m_pcFrameRef;  ///< reconstruction of the previous frame, NULL for an intra frame
+	int m_iQP;
+	double m_dLambda;
+	int m_iFrameNumber;
+	int m_iRefLagRows;                ///< reference BU rows read below the BU row being coded, -1: the whole reference
+	GvcInLoopFilter m_cInLoopFilter;  ///< deblocking and SAO of the reconstruction, BU rows behind the encoding
+	GvcBitstream m_cBitstream;        ///< payload of the NAL unit being written
+	GvcAccessUnit m_cAccessUnit;      ///< NAL units of the frame
+	int m_iNumSubstreams;
+	GvcSubstreamCoder* m_pcSubstreams;              ///< one per BU row with wavefront synchronisation, one per tile otherwise
+	std::vector<GvcSbacContexts> m_acSyncContexts;  ///< contexts after the second BU of each row
+	GvcRowProgress* m_pcRowProgress;                ///< coded BUs of each row
+	std::mutex m_cMutex;
+	std::condition_variable m_cDoneCond;    ///< the last substream is complete
+	std::vector<int> m_aiNumBUsCodedInRow;  ///< over all tiles
+	int m_iNumRowsCoded;                    ///< complete rows at the top of the frame, handed to the in-loop filters
+	int m_iNumSubstreamsLeft;
+
+  public:
+	GvcFrameEncoder();
+	virtual ~GvcFrameEncoder();
+
+	void create( GvcEncoder* pcEncoder );
+	void destroy();
+	GvcInLoopFilter& getInLoopFilter() { return m_cInLoopFilter; }
+	void setRefLagRows( int i ) { m_iRefLagRows = i; }
+	GvcAccessUnit& getAccessUnit() { return m_cAccessUnit; }
+
+	/// starts coding pcFrameOrg into pcFrameRec, predicted from pcFrameRef which may still be in flight
+	void startFrame( GvcFrameUnit* pcFrameOrg, GvcFrameUnit* pcFrameRec, GvcFrameUnit* pcFrameRef, int iFrameNumber );
+	/// waits for the substreams and the in-loop filters, then appends the frame to the access unit
+	void finishFrame();
+
+  private:
+	void xEncodeSubstream( int iSubstream, GvcBUEncoder* pcBUEncoder );
+	void xSetRowCoded( int iBURow, int iNumBUs );
+	void xWriteFrameHeader();
+	void xEncodeSaoParameters( GvcSbac* pcSbac );
+};
+
+#endif  // __GVCFRAMEENCODER_H__
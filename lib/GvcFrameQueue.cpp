@@ -0,0 +1,88 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcFrameQueue.cpp
+ * \brief    Frames handed from one stage of a pipeline to the next
+ */
+
+#include "GvcFrameQueue.h"
+
+GvcFrameQueue::GvcFrameQueue()
+	: m_iNextFrame( 0 )
+	, m_iEndFrame( 0 )
+	, m_uiNumPushWaits( 0 )
+	, m_uiNumPopWaits( 0 )
+{
+}
+
+GvcFrameQueue::~GvcFrameQueue()
+{
+}
+
+void GvcFrameQueue::create( int iCapacity, int iFirstFrame, int iEndFrame )
+{
+	m_abQueued.assign( iCapacity, false );
+	m_iNextFrame = iFirstFrame;
+	m_iEndFrame = iEndFrame;
+	m_uiNumPushWaits = 0;
+	m_uiNumPopWaits = 0;
+}
+
+void GvcFrameQueue::push( int iFrame )
+{
+	const int iCapacity = (int)m_abQueued.size();
+	{
+		std::unique_lock<std::mutex> lock( m_cMutex );
+		if( iFrame >= m_iNextFrame + iCapacity )
+		{
+			m_uiNumPushWaits++;
+			m_cPushCond.wait( lock, [this, iFrame, iCapacity] { return iFrame < m_iNextFrame + iCapacity; } );
+		}
+		m_abQueued[iFrame % iCapacity] = true;
+	}
+	m_cPopCond.notify_all();
+}
+
+bool GvcFrameQueue::pop( int& riFrame )
+{
+	const int iCapacity = (int)m_abQueued.size();
+	{
+		std::unique_lock<std::mutex> lock( m_cMutex );
+		if( m_iNextFrame >= m_iEndFrame )
+		{
+			return false;
+		}
+		if( !m_abQueued[m_iNextFrame % iCapacity] )
+		{
+			m_uiNumPopWaits++;
+			m_cPopCond.wait( lock, [this, iCapacity] { return m_iNextFrame >= m_iEndFrame || m_abQueued[m_iNextFrame % iCapacity]; } );
+			if( m_iNextFrame >= m_iEndFrame )
+			{
+				return false;
+			}
+		}
+		m_abQueued[m_iNextFrame % iCapacity] = false;
+		riFrame = m_iNextFrame++;
+	}
+	// the pop may let a frame in, or the end reached wakes the other takers
+	m_cPushCond.notify_all();
+	m_cPopCond.notify_all();
+	return true;
+}
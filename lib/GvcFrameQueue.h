@@ -0,0 +1,68 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcFrameQueue.h
+ * \brief    Frames handed from one stage of a pipeline to the next (header)
+ */
+
+#ifndef __GVCFRAMEQUEUE_H__
+#define __GVCFRAMEQUEUE_H__
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "TypeDef.h"
+
+/**
+ * \class    GvcFrameQueue
+ * \brief    Bounded queue of frame numbers between two stages of a pipeline, handed out in order
+ *
+ * The threads of a stage may push their frames in any order; a frame is only taken once it is less than the capacity
+ * ahead of the next one to pop, so a stage that runs ahead waits for the next one to catch up. The frames are popped
+ * in order, by any number of threads. The buffers of a frame are found from its number, the queue only carries it.
+ */
+class GvcFrameQueue
+{
+	std::vector<bool> m_abQueued;  ///< per slot, frame number modulo the capacity
+	int m_iNextFrame;              ///< next frame to pop
+	int m_iEndFrame;               ///< frames from this one on are never pushed
+	std::mutex m_cMutex;
+	std::condition_variable m_cPushCond;  ///< the next frame was popped
+	std::condition_variable m_cPopCond;   ///< the next frame was pushed
+	// statistics
+	unsigned long long m_uiNumPushWaits;  ///< pushes that waited for the next stage
+	unsigned long long m_uiNumPopWaits;   ///< pops that waited for the stage before
+
+  public:
+	GvcFrameQueue();
+	virtual ~GvcFrameQueue();
+
+	/// frames iFirstFrame to iEndFrame - 1 pass the queue, at most iCapacity of them at once
+	void create( int iCapacity, int iFirstFrame, int iEndFrame );
+	void push( int iFrame );
+	/// takes the next frame, false once every frame was taken
+	bool pop( int& riFrame );
+
+	unsigned long long getNumPushWaits() const { return m_uiNumPushWaits; }
+	unsigned long long getNumPopWaits() const { return m_uiNumPopWaits; }
+};
+
+#endif  // __GVCFRAMEQUEUE_H__
@@ -2,8 +2,12 @@
     \brief    picture class
 */
 
+#include <algorithm>
+#include <cstring>
+
 #include "GvcFrameUnit.h"
 #include "GvcBlockUnit.h"
+#include "GvcRom.h"
 
 //! \ingroup TLibCommon
 //! \{
@@ -13,11 +17,24 @@
 // ====================================================================================================================
 
 GvcFrameUnit::GvcFrameUnit()
+: m_apBU(NULL)
+, m_iNumBUsInFrame(0)
 {
+  for(unsigned int comp=0; comp<MAX_NUM_COMPONENT; comp++)
+  {
+    m_apsFrameBuf[comp] = NULL;
+    m_apsFrameOrg[comp] = NULL;
+  }
+  for(int level=0; level<NUM_PYRAMID_LEVELS; level++)
+  {
+    m_apsPyramidBuf[level] = NULL;
+    m_apsPyramidOrg[level] = NULL;
+  }
 }
 
 GvcFrameUnit::~GvcFrameUnit()
 {
+  destroy();
 }
 
 void GvcFrameUnit:: create(const int picWidth, const int picHeight, const ChromaFormat chromaFormatIDC, const unsigned int maxCUWidth, const unsigned int maxCUHeight, const bool bUseMargin)
@@ -34,9 +51,201 @@ void GvcFrameUnit:: create(const int picWidth, const int picHeight, const Chroma
     m_apsFrameBuf[comp] = (short*)xMalloc( short, getStride(ch) * getTotalHeight(ch));
     m_apsFrameOrg[comp]  = m_apsFrameBuf[comp] + (m_iMarginY >> getComponentScaleY(ch)) * getStride(ch) + (m_iMarginX >> getComponentScaleX(ch));
   }
+  // block unit grid, only available when the BU size is known
+  m_iMaxBUWidth       = maxCUWidth;
+  m_iMaxBUHeight      = maxCUHeight;
+  m_iMinBUWidth       = MIN_PU_SIZE;
+  m_iMinBUHeight      = MIN_PU_SIZE;
+  m_iFrameWidthInBUs  = maxCUWidth  ? (picWidth  + maxCUWidth  - 1) / maxCUWidth  : 0;
+  m_iFrameHeightInBUs = maxCUHeight ? (picHeight + maxCUHeight - 1) / maxCUHeight : 0;
+  m_iNumBUsInFrame    = m_iFrameWidthInBUs * m_iFrameHeightInBUs;
+  if (m_iNumBUsInFrame > 0)
+  {
+    initROM();
+    m_apBU = new GvcBlockUnit*[m_iNumBUsInFrame];
+    for (int buRsAddr = 0; buRsAddr < m_iNumBUsInFrame; buRsAddr++)
+    {
+      m_apBU[buRsAddr] = new GvcBlockUnit;
+      m_apBU[buRsAddr]->create(chromaFormatIDC, getNumPartitionsInBU(), maxCUWidth, maxCUHeight, MIN_PU_SIZE);
+      m_apBU[buRsAddr]->initBU(this, buRsAddr);
+    }
+    initTiles(std::vector<int>(1, m_iFrameWidthInBUs), std::vector<int>(1, m_iFrameHeightInBUs));
+  }
+}
+
+void GvcFrameUnit::initTiles(const std::vector<int>& aiColumnWidths, const std::vector<int>& aiRowHeights)
+{
+  m_acTiles.clear();
+  m_aiTileIdxMap.resize(m_iNumBUsInFrame);
+  GvcTile cTile;
+  cTile.iFirstBURow = 0;
+  for (size_t row = 0; row < aiRowHeights.size(); row++)
+  {
+    cTile.iHeightInBUs = aiRowHeights[row];
+    cTile.iFirstBUCol = 0;
+    for (size_t col = 0; col < aiColumnWidths.size(); col++)
+    {
+      cTile.iWidthInBUs = aiColumnWidths[col];
+      for (int y = cTile.iFirstBURow; y < cTile.iFirstBURow + cTile.iHeightInBUs; y++)
+      {
+        for (int x = cTile.iFirstBUCol; x < cTile.iFirstBUCol + cTile.iWidthInBUs; x++)
+        {
+          m_aiTileIdxMap[y * m_iFrameWidthInBUs + x] = (int)m_acTiles.size();
+        }
+      }
+      m_acTiles.push_back(cTile);
+      cTile.iFirstBUCol += cTile.iWidthInBUs;
+    }
+    cTile.iFirstBURow += cTile.iHeightInBUs;
+  }
+}
+
+void GvcFrameUnit::getUniformTileSizes(const int iSizeInBUs, const int iNumTiles, std::vector<int>& aiSizes)
+{
+  aiSizes.resize(iNumTiles);
+  for (int i = 0; i < iNumTiles; i++)
+  {
+    aiSizes[i] = ((i + 1) * iSizeInBUs) / iNumTiles - (i * iSizeInBUs) / iNumTiles;
+  }
 }
 
 void GvcFrameUnit::destroy()
-{}
+{
+  for(unsigned int comp=0; comp<MAX_NUM_COMPONENT; comp++)
+  {
+    if (m_apsFrameBuf[comp])
+    {
+      xFree(m_apsFrameBuf[comp]);
+    }
+    m_apsFrameBuf[comp] = NULL;
+    m_apsFrameOrg[comp] = NULL;
+  }
+  for (int level = 0; level < NUM_PYRAMID_LEVELS; level++)
+  {
+    if (m_apsPyramidBuf[level])
+    {
+      xFree(m_apsPyramidBuf[level]);
+    }
+    m_apsPyramidBuf[level] = NULL;
+    m_apsPyramidOrg[level] = NULL;
+  }
+  if (m_apBU)
+  {
+    for (int buRsAddr = 0; buRsAddr < m_iNumBUsInFrame; buRsAddr++)
+    {
+      m_apBU[buRsAddr]->destroy();
+      delete m_apBU[buRsAddr];
+    }
+    delete[] m_apBU;
+    m_apBU = NULL;
+  }
+  m_iNumBUsInFrame = 0;
+}
+
+short* GvcFrameUnit::getAddr(const ComponentID ch, const unsigned int buRsAddr, const unsigned int uiAbsZorderIdx)
+{
+  const int buPelX = (buRsAddr % m_iFrameWidthInBUs) * m_iMaxBUWidth + g_auiZscanToPelX[uiAbsZorderIdx];
+  const int buPelY = (buRsAddr / m_iFrameWidthInBUs) * m_iMaxBUHeight + g_auiZscanToPelY[uiAbsZorderIdx];
+  return m_apsFrameOrg[ch] + (buPelY >> getComponentScaleY(ch)) * getStride(ch) + (buPelX >> getComponentScaleX(ch));
+}
+
+/** Lines iFirstLine to iEndLine - 1 are extended to the left and right margins, the top margin is filled along with
+ *  the first line and the bottom margin along with the last one.
+ */
+static void extendPlaneBorder(short* pPlane, const int iWidth, const int iHeight, const int iStride, const int iMarginX, const int iMarginY,
+                              const int iFirstLine, const int iEndLine)
+{
+  short* pRow = pPlane + iFirstLine * iStride;
+  for (int y = iFirstLine; y < iEndLine; y++, pRow += iStride)
+  {
+    for (int x = 0; x < iMarginX; x++)
+    {
+      pRow[-iMarginX + x] = pRow[0];
+      pRow[iWidth + x] = pRow[iWidth - 1];
+    }
+  }
+  short* pFirst = pPlane - iMarginX;
+  short* pLast = pFirst + (iHeight - 1) * iStride;
+  for (int y = 1; y <= iMarginY; y++)
+  {
+    if (iFirstLine == 0)
+    {
+      memcpy(pFirst - y * iStride, pFirst, sizeof(short) * iStride);
+    }
+    if (iEndLine == iHeight)
+    {
+      memcpy(pLast + y * iStride, pLast, sizeof(short) * iStride);
+    }
+  }
+}
+
+void GvcFrameUnit::extendFrameBorder()
+{
+  for (unsigned int comp = 0; comp < getNumberValidComponents(m_chromaFormatIDC); comp++)
+  {
+    const ComponentID compID = ComponentID(comp);
+    extendPlaneBorder(getAddr(compID), getWidth(compID), getHeight(compID), getStride(compID), getMarginX(compID), getMarginY(compID), 0, getHeight(compID));
+  }
+}
+
+void GvcFrameUnit::extendRowBorder(const int iBURow)
+{
+  for (unsigned int comp = 0; comp < getNumberValidComponents(m_chromaFormatIDC); comp++)
+  {
+    const ComponentID compID = ComponentID(comp);
+    const int iScaleY = getComponentScaleY(compID);
+    const int iFirstLine = (iBURow * m_iMaxBUHeight) >> iScaleY;
+    const int iEndLine = std::min((iBURow + 1) * m_iMaxBUHeight, m_iFrameHeight) >> iScaleY;
+    extendPlaneBorder(getAddr(compID), getWidth(compID), getHeight(compID), getStride(compID), getMarginX(compID), getMarginY(compID), iFirstLine, iEndLine);
+  }
+}
+
+/** Each level averages 2x2 samples of the level above it, the last column and row are repeated
+ *  when the level above has an odd size. The margins are padded like those of the frame, so a
+ *  search window clamped to them never reads outside the planes.
+ */
+void GvcFrameUnit::buildPyramid()
+{
+  for (int iBURow = 0; iBURow < m_iFrameHeightInBUs; iBURow++)
+  {
+    buildPyramidRow(iBURow);
+  }
+}
+
+/** Line y of a level reads lines 2y and 2y + 1 of the level above, so the lines of a BU row only depend on that row
+ *  and the rows above.
+ */
+void GvcFrameUnit::buildPyramidRow(const int iBURow)
+{
+  for (int level = 1; level < NUM_PYRAMID_LEVELS; level++)
+  {
+    const int iWidth = getPyramidWidth(level);
+    const int iHeight = getPyramidHeight(level);
+    const int iStride = getPyramidStride(level);
+    if (!m_apsPyramidBuf[level])
+    {
+      m_apsPyramidBuf[level] = (short*)xMalloc(short, iStride * (iHeight + (getPyramidMarginY(level) << 1)));
+      m_apsPyramidOrg[level] = m_apsPyramidBuf[level] + getPyramidMarginY(level) * iStride + getPyramidMarginX(level);
+    }
+    const int iSrcWidth = getPyramidWidth(level - 1);
+    const int iSrcHeight = getPyramidHeight(level - 1);
+    const int iSrcStride = getPyramidStride(level - 1);
+    const short* pSrc = getPyramidAddr(level - 1);
+    short* pDst = m_apsPyramidOrg[level];
+    const int iFirstLine = (iBURow * m_iMaxBUHeight) >> level;
+    const int iEndLine = iBURow + 1 == m_iFrameHeightInBUs ? iHeight : ((iBURow + 1) * m_iMaxBUHeight) >> level;
+    for (int y = iFirstLine; y < iEndLine; y++)
+    {
+      const short* pRow0 = pSrc + (2 * y) * iSrcStride;
+      const short* pRow1 = pSrc + std::min(2 * y + 1, iSrcHeight - 1) * iSrcStride;
+      for (int x = 0; x < iWidth; x++)
+      {
+        const int x1 = std::min(2 * x + 1, iSrcWidth - 1);
+        pDst[y * iStride + x] = (short)((pRow0[2 * x] + pRow0[x1] + pRow1[2 * x] + pRow1[x1] + 2) >> 2);
+      }
+    }
+    extendPlaneBorder(pDst, iWidth, iHeight, iStride, getPyramidMarginX(level), getPyramidMarginY(level), iFirstLine, iEndLine);
+  }
+}
 
 //! \}
@@ -26,6 +26,7 @@
 #define __GVCFRAMEUNIT__
 
 #include "TypeDef.h"
+#include "GvcThreadPool.h"
 #include "TComChromaFormat.h"
 
 //! \ingroup TLibCommon
@@ -35,6 +36,15 @@
 // Class definition
 // ====================================================================================================================
 
+/// rectangle of BUs coded independently of the rest of the frame, in BU units
+struct GvcTile
+{
+    int iFirstBUCol;
+    int iFirstBURow;
+    int iWidthInBUs;
+    int iHeightInBUs;
+};
+
 /// picture class (symbol + YUV buffers)
 class GvcBlockUnit;
 class GvcFrameUnit
@@ -56,6 +66,11 @@ private:
     int   m_iMaxDepth;
     int   m_iNumBUsInFrame;
     ChromaFormat m_chromaFormatIDC;                       ///< Chroma Format
+    short*  m_apsPyramidBuf[NUM_PYRAMID_LEVELS];          ///< downscaled luma (including margin), level 0 is the frame itself
+    short*  m_apsPyramidOrg[NUM_PYRAMID_LEVELS];
+    std::vector<GvcTile> m_acTiles;                       ///< in raster order
+    std::vector<int> m_aiTileIdxMap;                      ///< tile of each BU
+    GvcRowProgress m_cRowProgress;                        ///< BU rows reconstructed, filtered and padded
 
 public:
     GvcFrameUnit();
@@ -63,6 +78,19 @@ public:
     virtual void  destroy();
     void          create            (const int picWidth, const int picHeight, const ChromaFormat chromaFormatIDC, const unsigned int maxCUWidth=0, const unsigned int maxCUHeight=0, const bool bUseMargin=false);   ///< if true, then a margin of uiMaxCUWidth+16 and uiMaxCUHeight+16 is created around the image.
     GvcBlockUnit*   getBU( unsigned int buRsAddr ) { return  m_apBU[buRsAddr]; }
+    int           getFrameWidthInBUs() const             { return  m_iFrameWidthInBUs;  }
+    int           getFrameHeightInBUs() const            { return  m_iFrameHeightInBUs; }
+    int           getNumBUsInFrame  () const             { return  m_iNumBUsInFrame;    }
+    int           getMaxBUWidth     () const             { return  m_iMaxBUWidth;       }
+    int           getMaxBUHeight    () const             { return  m_iMaxBUHeight;      }
+    //  Tile grid, column widths and row heights in BUs adding up to the frame; a single tile after create()
+    void          initTiles         (const std::vector<int>& aiColumnWidths, const std::vector<int>& aiRowHeights);
+    //  Sizes of iNumTiles tiles spread as evenly as possible over iSizeInBUs BUs
+    static void   getUniformTileSizes(const int iSizeInBUs, const int iNumTiles, std::vector<int>& aiSizes);
+    int           getNumTiles       () const             { return  (int)m_acTiles.size(); }
+    const GvcTile& getTile          (const int iTileIdx) const { return m_acTiles[iTileIdx]; }
+    int           getTileIdxMap     (const unsigned int buRsAddr) const { return m_aiTileIdxMap[buRsAddr]; }
+    int           getNumPartitionsInBU() const           { return  ( m_iMaxBUWidth / MIN_PU_SIZE ) * ( m_iMaxBUHeight / MIN_PU_SIZE ); }
     int           getWidth          (const ComponentID id) const { return  m_iFrameWidth >> getComponentScaleX(id);   }
     int           getHeight         (const ComponentID id) const { return  m_iFrameHeight >> getComponentScaleY(id);  }
     int           getTotalHeight    (const ComponentID id) const { return ((m_iFrameHeight    ) + (m_iMarginY  <<1)) >> getComponentScaleY(id); } /// height + margin Y * 2
@@ -80,6 +108,24 @@ public:
     //  Access starting position of original picture
     short*          getAddr           (const ComponentID ch)       { return  m_apsFrameOrg[ch];   }
     const short*    getAddr           (const ComponentID ch) const { return  m_apsFrameOrg[ch];   }
+    //  Access starting position of a (sub) block unit given the BU raster address and the z-order partition index
+    short*          getAddr           (const ComponentID ch, const unsigned int buRsAddr, const unsigned int uiAbsZorderIdx = 0);
+    //  Replicate the frame edges into the margin, so that motion vectors may point outside the frame
+    void            extendFrameBorder ();
+    //  Same for the lines of a BU row, the top and bottom margins with the first and the last row
+    void            extendRowBorder   (const int iBURow);
+    //  Downscaled luma planes, level l has 1/2^l of the frame width and height and a margin scaled alike
+    void            buildPyramid      ();
+    //  Lines of the levels below a BU row, padded, once the row and the rows above are final
+    void            buildPyramidRow   (const int iBURow);
+    //  Rows a frame predicting from this one may read, see extendRowBorder
+    GvcRowProgress& getRowProgress    ()                     { return m_cRowProgress; }
+    int             getPyramidWidth   (const int level) const { return (m_iFrameWidth  + (1 << level) - 1) >> level; }
+    int             getPyramidHeight  (const int level) const { return (m_iFrameHeight + (1 << level) - 1) >> level; }
+    int             getPyramidStride  (const int level) const { return level ? getPyramidWidth(level) + ((m_iMarginX >> level) << 1) : getStride(COMPONENT_Y); }
+    int             getPyramidMarginX (const int level) const { return m_iMarginX >> level; }
+    int             getPyramidMarginY (const int level) const { return m_iMarginY >> level; }
+    const short*    getPyramidAddr    (const int level) const { return level ? m_apsPyramidOrg[level] : m_apsFrameOrg[COMPONENT_Y]; }
 };// END CLASS DEFINITION GvcFrameUnit
 
 //! \}
@@ -0,0 +1,220 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcInLoopFilter.cpp
+ * \brief    In-loop filter stages of a frame, BU row by BU row behind the encoder
+ */
+
+#include "GvcInLoopFilter.h"
+
+#include <algorithm>
+
+#include "GvcFrameUnit.h"
+
+GvcInLoopFilter::GvcInLoopFilter()
+	: m_bSaoEnabled( false )
+	, m_bBuildPyramid( false )
+	, m_pcThreadPool( NULL )
+	, m_iPriority( 0 )
+	, m_bScheduled( false )
+	, m_bActive( false )
+	, m_pcFrameOrg( NULL )
+	, m_bSaoParametersKnown( false )
+	, m_pcFrame( NULL )
+	, m_iNumRows( 0 )
+	, m_iNumRowsCoded( 0 )
+{
+	for( int i = 0; i < NUM_IN_LOOP_STAGES; i++ )
+	{
+		m_aiNumRowsDone[i] = 0;
+	}
+}
+
+GvcInLoopFilter::~GvcInLoopFilter()
+{
+	destroy();
+}
+
+void GvcInLoopFilter::create( int iWidth, int iHeight, ChromaFormat chromaFormat, int iMaxBUWidth, int iMaxBUHeight, const int* piBitDepth,
+							  unsigned int uiTULog2MaxSize )
+{
+	m_cLoopFilter.create( piBitDepth, uiTULog2MaxSize );
+	m_cSao.create( iWidth, iHeight, chromaFormat, iMaxBUWidth, iMaxBUHeight, piBitDepth );
+}
+
+void GvcInLoopFilter::destroy()
+{
+	m_cSao.destroy();
+}
+
+void GvcInLoopFilter::startFrame( const GvcFrameUnit* pcFrameOrg, GvcFrameUnit* pcFrame, int iQP, double dLambda, int iPriority )
+{
+	std::lock_guard<std::mutex> lock( m_cMutex );
+	m_iPriority = iPriority;
+	m_cLoopFilter.setQP( iQP, pcFrame->getChromaFormat() );
+	m_cSao.setLambda( dLambda );
+	m_pcFrameOrg = pcFrameOrg;
+	m_bSaoParametersKnown = pcFrameOrg != NULL || !m_bSaoEnabled;
+	m_pcFrame = pcFrame;
+	m_iNumRows = pcFrame->getFrameHeightInBUs();
+	m_iNumRowsCoded = 0;
+	pcFrame->getRowProgress().reset();
+	for( int i = 0; i < NUM_IN_LOOP_STAGES; i++ )
+	{
+		m_aiNumRowsDone[i] = 0;
+	}
+}
+
+void GvcInLoopFilter::rowCoded( int iBURow )
+{
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		// the rows may be reported out of order by the threads coding them
+		m_iNumRowsCoded = std::max( m_iNumRowsCoded, iBURow + 1 );
+		if( m_pcThreadPool && m_pcThreadPool->getNumThreads() > 0 && m_iNumRowsCoded < m_iNumRows )
+		{
+			if( !m_bScheduled && !m_bActive )
+			{
+				m_bScheduled = true;
+				m_pcThreadPool->enqueue( [this]( int ) {
+					{
+						std::lock_guard<std::mutex> lock( m_cMutex );
+						m_bScheduled = false;
+					}
+					xRunStages();
+				}, m_iPriority );
+			}
+			return;
+		}
+	}
+	xRunStages();
+}
+
+void GvcInLoopFilter::waitSaoParameters()
+{
+	xRunStages();
+	std::unique_lock<std::mutex> lock( m_cMutex );
+	m_cCond.wait( lock, [this] { return m_aiNumRowsDone[STAGE_SAO_STATISTICS] == m_iNumRows; } );
+}
+
+void GvcInLoopFilter::setSaoParametersKnown()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		m_bSaoParametersKnown = true;
+	}
+	xRunStages();
+}
+
+void GvcInLoopFilter::finishFrame()
+{
+	rowCoded( m_iNumRows - 1 );
+	std::unique_lock<std::mutex> lock( m_cMutex );
+	// a runner still queued would take the stages of the next frame
+	m_cCond.wait( lock, [this] { return m_aiNumRowsDone[STAGE_SAO] == m_iNumRows && !m_bScheduled && !m_bActive; } );
+	m_pcFrameOrg = NULL;
+	m_pcFrame = NULL;
+}
+
+/// the next row of the stage may run, called with the mutex held
+bool GvcInLoopFilter::xIsStageReady( int iStage ) const
+{
+	const int iBURow = m_aiNumRowsDone[iStage];
+	if( iBURow == m_iNumRows )
+	{
+		return false;
+	}
+	if( iStage == STAGE_SAO_STATISTICS )
+	{
+		return iBURow < m_iNumRowsCoded;
+	}
+	if( iStage == STAGE_SAO && !m_bSaoParametersKnown )
+	{
+		return false;
+	}
+	// the later stages also need the next row through the previous stage
+	const int iNumRowsBefore = m_aiNumRowsDone[iStage - 1];
+	return iBURow + 1 < iNumRowsBefore || iNumRowsBefore == m_iNumRows;
+}
+
+void GvcInLoopFilter::xRunStage( int iStage, int iBURow )
+{
+	switch( iStage )
+	{
+	case STAGE_SAO_STATISTICS:
+		if( m_bSaoEnabled && m_pcFrameOrg )
+		{
+			m_cSao.getStatistics( m_pcFrameOrg, m_pcFrame, iBURow );
+			m_cSao.decideBlkParams( m_pcFrame, iBURow );
+		}
+		break;
+	case STAGE_DEBLOCK:
+		if( !m_cLoopFilter.getDisabled() )
+		{
+			m_cLoopFilter.loopFilterRow( m_pcFrame, iBURow );
+		}
+		break;
+	case STAGE_SAO:
+		if( m_bSaoEnabled )
+		{
+			m_cSao.applyRow( m_pcFrame, iBURow );
+		}
+		m_pcFrame->extendRowBorder( iBURow );
+		if( m_bBuildPyramid )
+		{
+			m_pcFrame->buildPyramidRow( iBURow );
+		}
+		m_pcFrame->getRowProgress().set( iBURow + 1 );
+		break;
+	}
+}
+
+/// takes the stages that are ready until none is, unless another runner is already at it
+void GvcInLoopFilter::xRunStages()
+{
+	std::unique_lock<std::mutex> lock( m_cMutex );
+	if( m_bActive )
+	{
+		return;
+	}
+	m_bActive = true;
+	while( true )
+	{
+		int iStage = 0;
+		while( iStage < NUM_IN_LOOP_STAGES && !xIsStageReady( iStage ) )
+		{
+			iStage++;
+		}
+		if( iStage == NUM_IN_LOOP_STAGES )
+		{
+			break;
+		}
+		const int iBURow = m_aiNumRowsDone[iStage];
+		lock.unlock();
+
+		xRunStage( iStage, iBURow );
+
+		lock.lock();
+		m_aiNumRowsDone[iStage]++;
+		m_cCond.notify_all();
+	}
+	m_bActive = false;
+	m_cCond.notify_all();
+}
@@ -0,0 +1,121 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcInLoopFilter.h
+ * \brief    In-loop filter stages of a frame, BU row by BU row behind the encoder (header)
+ */
+
+#ifndef __GVCINLOOPFILTER_H__
+#define __GVCINLOOPFILTER_H__
+
+#include <condition_variable>
+#include <mutex>
+
+#include "TypeDef.h"
+#include "GvcLoopFilter.h"
+#include "GvcSao.h"
+#include "GvcThreadPool.h"
+
+class GvcFrameUnit;
+
+/// stages each BU row goes through, in this order
+enum InLoopStage
+{
+	STAGE_SAO_STATISTICS = 0,  ///< sample adaptive offset statistics and decision, on the samples before deblocking
+	STAGE_DEBLOCK,
+	STAGE_SAO,
+	NUM_IN_LOOP_STAGES
+};
+
+/**
+ * \class    GvcInLoopFilter
+ * \brief    Runs the in-loop filters of a frame as jobs of the thread pool while the encoder codes the next BU rows
+ *
+ * A stage of BU row r starts once the rows its samples depend on are through the previous stage:
+ *  - the statistics of row r read row r and the bottom line of row r - 1 as coded, they run as soon as row r is;
+ *  - deblocking row r changes the bottom lines of row r - 1 and the samples of row r, which the statistics of row r + 1
+ *    and the intra prediction of row r + 1 read unfiltered, so it waits for the statistics of row r + 1;
+ *  - the offsets of row r compare with the first line of row r + 1, which is final once row r + 1 is deblocked.
+ * A disabled stage still goes through the rows, as a no-op, so that the order holds in every configuration.
+ * After the last stage the row is final: its margins are padded, the lines of the pyramid below it built when asked
+ * for, and the row progress of the frame tells the frames predicting from it that they may read it.
+ *
+ * One runner at a time takes the stages that are ready, in the order above, and returns when none is. A coded row
+ * queues a runner on the pool, while the thread coding the last row, or waiting for the SAO offsets, runs the stages
+ * itself: the filters of a frame never wait for a free worker, which may all be held by rows of the next frames
+ * waiting for this one. Without a pool, every stage runs on the thread that coded its row.
+ *
+ * Without a source frame the offsets come from elsewhere, in a decoder from the end of the frame payload: the SAO
+ * stage then holds until setSaoParametersKnown.
+ */
+class GvcInLoopFilter
+{
+	GvcLoopFilter m_cLoopFilter;
+	GvcSao m_cSao;
+	bool m_bSaoEnabled;
+	bool m_bBuildPyramid;  ///< downscaled planes of the reconstruction, for the hierarchical motion search
+
+	// runners
+	GvcThreadPool* m_pcThreadPool;
+	int m_iPriority;                   ///< of the runners on the pool
+	std::mutex m_cMutex;
+	std::condition_variable m_cCond;   ///< a stage is through one more row
+	bool m_bScheduled;                 ///< a runner is queued on the pool
+	bool m_bActive;                    ///< a runner takes the stages
+	const GvcFrameUnit* m_pcFrameOrg;  ///< source of the SAO statistics, NULL when the offsets are already known
+	bool m_bSaoParametersKnown;        ///< the offsets of every BU are set, the SAO stage may run
+	GvcFrameUnit* m_pcFrame;
+	int m_iNumRows;
+	int m_iNumRowsCoded;
+	int m_aiNumRowsDone[NUM_IN_LOOP_STAGES];
+
+  public:
+	GvcInLoopFilter();
+	virtual ~GvcInLoopFilter();
+
+	void create( int iWidth, int iHeight, ChromaFormat chromaFormat, int iMaxBUWidth, int iMaxBUHeight, const int* piBitDepth, unsigned int uiTULog2MaxSize );
+	void destroy();
+	GvcLoopFilter& getLoopFilter() { return m_cLoopFilter; }
+	GvcSao& getSao() { return m_cSao; }
+	void setSaoEnabled( bool b ) { m_bSaoEnabled = b; }
+	bool getSaoEnabled() const { return m_bSaoEnabled; }
+	void setBuildPyramid( bool b ) { m_bBuildPyramid = b; }
+	/// pool the stages run on, NULL or one without threads to run them on the threads coding the rows
+	void setThreadPool( GvcThreadPool* pcThreadPool ) { m_pcThreadPool = pcThreadPool; }
+
+	/// no BU row is coded yet; pcFrameOrg is NULL when the SAO offsets are not decided here, iPriority is that of the
+	/// pool jobs of the frame
+	void startFrame( const GvcFrameUnit* pcFrameOrg, GvcFrameUnit* pcFrame, int iQP, double dLambda, int iPriority );
+	/// the BU rows up to iBURow are coded
+	void rowCoded( int iBURow );
+	/// waits until the SAO offsets of every BU are decided
+	void waitSaoParameters();
+	/// the offsets of every BU are set in getSao(), for a frame started without a source
+	void setSaoParametersKnown();
+	/// runs the remaining stages and waits until the whole frame is filtered
+	void finishFrame();
+
+  private:
+	bool xIsStageReady( int iStage ) const;
+	void xRunStage( int iStage, int iBURow );
+	void xRunStages();
+};
+
+#endif  // __GVCINLOOPFILTER_H__
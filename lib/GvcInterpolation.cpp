@@ -0,0 +1,178 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcInterpolation.cpp
+ * \brief    Reference C++ implementation of the luma and chroma interpolation filters and of the
+ *           bi-prediction and weighted prediction
+ */
+
+#include <cstring>
+
+#include "GvcPrimitives.h"
+#include "GvcRom.h"
+
+namespace
+{
+/// rounding shift and offset of one pass, as in the HM interpolation filter
+inline void getStageParams( bool bFirst, bool bLast, int iBitDepth, int& riShift, int& riOffset )
+{
+	const int iHeadRoom = std::max( 2, IF_INTERNAL_PREC - iBitDepth );
+	riShift = IF_FILTER_PREC;
+	if( bLast )
+	{
+		riShift += bFirst ? 0 : iHeadRoom;
+		riOffset = ( 1 << ( riShift - 1 ) ) + ( bFirst ? 0 : IF_INTERNAL_OFFS << IF_FILTER_PREC );
+	}
+	else
+	{
+		riShift -= bFirst ? iHeadRoom : 0;
+		riOffset = bFirst ? -IF_INTERNAL_OFFS * ( 1 << riShift ) : 0;
+	}
+}
+
+template <int N>
+inline const short* getCoeff( int iFrac )
+{
+	return N == NTAPS_LUMA ? g_aiLumaFilter[iFrac] : g_aiChromaFilter[iFrac];
+}
+
+template <int N, bool bVertical, bool bFirst, bool bLast>
+void filter_c( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iFrac, int iBitDepth )
+{
+	const short* piCoeff = getCoeff<N>( iFrac );
+	const int iStep = bVertical ? iSrcStride : 1;
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	int iShift, iOffset;
+	getStageParams( bFirst, bLast, iBitDepth, iShift, iOffset );
+	pSrc -= ( N / 2 - 1 ) * iStep;
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth; x++ )
+		{
+			int iSum = 0;
+			for( int k = 0; k < N; k++ )
+			{
+				iSum += pSrc[x + k * iStep] * piCoeff[k];
+			}
+			const int iVal = ( iSum + iOffset ) >> iShift;
+			pDst[x] = (short)( bLast ? Clip3( 0, iMaxVal, iVal ) : iVal );
+		}
+		pSrc += iSrcStride;
+		pDst += iDstStride;
+	}
+}
+
+template <int N, bool bLast>
+void filterHV_c( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iFracX, int iFracY, int iBitDepth )
+{
+	short asTmp[( MAX_BU_SIZE + N - 1 ) * MAX_BU_SIZE];
+	filter_c<N, false, true, false>( pSrc - ( N / 2 - 1 ) * iSrcStride, iSrcStride, asTmp, MAX_BU_SIZE, iWidth, iHeight + N - 1, iFracX, iBitDepth );
+	filter_c<N, true, false, bLast>( asTmp + ( N / 2 - 1 ) * MAX_BU_SIZE, MAX_BU_SIZE, pDst, iDstStride, iWidth, iHeight, iFracY, iBitDepth );
+}
+
+template <bool bFirst, bool bLast>
+void copy_c( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iBitDepth )
+{
+	const int iShift = std::max( 2, IF_INTERNAL_PREC - iBitDepth );
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	for( int y = 0; y < iHeight; y++ )
+	{
+		if( bFirst == bLast )
+		{
+			memcpy( pDst, pSrc, sizeof( short ) * iWidth );
+		}
+		else
+		{
+			for( int x = 0; x < iWidth; x++ )
+			{
+				if( bFirst )
+				{
+					pDst[x] = (short)( ( pSrc[x] << iShift ) - IF_INTERNAL_OFFS );
+				}
+				else
+				{
+					pDst[x] = (short)Clip3( 0, iMaxVal, ( pSrc[x] + IF_INTERNAL_OFFS + ( 1 << ( iShift - 1 ) ) ) >> iShift );
+				}
+			}
+		}
+		pSrc += iSrcStride;
+		pDst += iDstStride;
+	}
+}
+
+void addAvg_c( const short* pSrc0, int iSrc0Stride, const short* pSrc1, int iSrc1Stride, short* pDst, int iDstStride, int iWidth, int iHeight, int iBitDepth )
+{
+	const int iShift = std::max( 2, IF_INTERNAL_PREC - iBitDepth ) + 1;
+	const int iOffset = ( 1 << ( iShift - 1 ) ) + 2 * IF_INTERNAL_OFFS;
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth; x++ )
+		{
+			pDst[x] = (short)Clip3( 0, iMaxVal, ( pSrc0[x] + pSrc1[x] + iOffset ) >> iShift );
+		}
+		pSrc0 += iSrc0Stride;
+		pSrc1 += iSrc1Stride;
+		pDst += iDstStride;
+	}
+}
+
+void weightUni_c( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iWeight, int iOffset, int iLog2Wd,
+				  int iBitDepth )
+{
+	const int iShift = iLog2Wd + std::max( 2, IF_INTERNAL_PREC - iBitDepth );
+	const int iRound = 1 << ( iShift - 1 );
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth; x++ )
+		{
+			pDst[x] = (short)Clip3( 0, iMaxVal, ( ( iWeight * ( pSrc[x] + IF_INTERNAL_OFFS ) + iRound ) >> iShift ) + iOffset );
+		}
+		pSrc += iSrcStride;
+		pDst += iDstStride;
+	}
+}
+
+template <int N>
+void setupFilter( GvcPrimitives& p, int iFilter )
+{
+	p.interpHor[iFilter][INTERP_PEL_TO_PEL] = filter_c<N, false, true, true>;
+	p.interpHor[iFilter][INTERP_PEL_TO_INT] = filter_c<N, false, true, false>;
+	p.interpVer[iFilter][INTERP_PEL_TO_PEL] = filter_c<N, true, true, true>;
+	p.interpVer[iFilter][INTERP_PEL_TO_INT] = filter_c<N, true, true, false>;
+	p.interpVer[iFilter][INTERP_INT_TO_PEL] = filter_c<N, true, false, true>;
+	p.interpVer[iFilter][INTERP_INT_TO_INT] = filter_c<N, true, false, false>;
+	p.interpHV[iFilter][INTERP_PEL_TO_PEL] = filterHV_c<N, true>;
+	p.interpHV[iFilter][INTERP_PEL_TO_INT] = filterHV_c<N, false>;
+}
+}  // namespace
+
+void setupInterpPrimitivesC( GvcPrimitives& p )
+{
+	setupFilter<NTAPS_LUMA>( p, INTERP_LUMA );
+	setupFilter<NTAPS_CHROMA>( p, INTERP_CHROMA );
+	p.interpCopy[INTERP_PEL_TO_PEL] = copy_c<true, true>;
+	p.interpCopy[INTERP_PEL_TO_INT] = copy_c<true, false>;
+	p.interpCopy[INTERP_INT_TO_PEL] = copy_c<false, true>;
+	p.interpCopy[INTERP_INT_TO_INT] = copy_c<false, false>;
+	p.addAvg = addAvg_c;
+	p.weightUni = weightUni_c;
+}
@@ -0,0 +1,334 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcInterpolationAvx2.cpp
+ * \brief    AVX2 implementation of the interpolation filters and of the bi-prediction and weighted prediction
+ *
+ * Every pass interleaves the samples of two consecutive taps (the next column for the horizontal
+ * filter, the next row for the vertical one) and multiplies them with the matching coefficient pair
+ * in one madd, so the sums are exact in 32 bits for any bit depth. Rows are filtered 16, 8 and then
+ * 4 samples at a time, which covers every width multiple of 4. The two dimensional filter runs in
+ * strips of 16 columns, whose horizontal output stays in a small buffer in L1.
+ */
+
+#include <immintrin.h>
+
+#include "GvcPrimitives.h"
+#include "GvcRom.h"
+
+namespace
+{
+inline void getStageParams( bool bFirst, bool bLast, int iBitDepth, int& riShift, int& riOffset )
+{
+	const int iHeadRoom = std::max( 2, IF_INTERNAL_PREC - iBitDepth );
+	riShift = IF_FILTER_PREC;
+	if( bLast )
+	{
+		riShift += bFirst ? 0 : iHeadRoom;
+		riOffset = ( 1 << ( riShift - 1 ) ) + ( bFirst ? 0 : IF_INTERNAL_OFFS << IF_FILTER_PREC );
+	}
+	else
+	{
+		riShift -= bFirst ? iHeadRoom : 0;
+		riOffset = bFirst ? -IF_INTERNAL_OFFS * ( 1 << riShift ) : 0;
+	}
+}
+
+/// rounding and clipping shared by the rows of one pass
+struct FilterState
+{
+	__m256i avCoeff[NTAPS_LUMA / 2];  ///< coefficient pairs ( c[2k], c[2k + 1] )
+	__m256i vOffset;
+	__m128i vShift;
+	__m256i vMaxVal;
+};
+
+template <int N>
+inline void initState( FilterState& rcState, int iFrac, bool bFirst, bool bLast, int iBitDepth )
+{
+	const short* piCoeff = N == NTAPS_LUMA ? g_aiLumaFilter[iFrac] : g_aiChromaFilter[iFrac];
+	for( int k = 0; k < N; k += 2 )
+	{
+		rcState.avCoeff[k >> 1] = _mm256_set1_epi32( ( (unsigned short)piCoeff[k] ) | ( (unsigned int)(unsigned short)piCoeff[k + 1] << 16 ) );
+	}
+	int iShift, iOffset;
+	getStageParams( bFirst, bLast, iBitDepth, iShift, iOffset );
+	rcState.vOffset = _mm256_set1_epi32( iOffset );
+	rcState.vShift = _mm_cvtsi32_si128( iShift );
+	rcState.vMaxVal = _mm256_set1_epi16( (short)( ( 1 << iBitDepth ) - 1 ) );
+}
+
+template <bool bLast>
+inline __m256i roundPack( __m256i vLo, __m256i vHi, const FilterState& rcState )
+{
+	vLo = _mm256_sra_epi32( _mm256_add_epi32( vLo, rcState.vOffset ), rcState.vShift );
+	vHi = _mm256_sra_epi32( _mm256_add_epi32( vHi, rcState.vOffset ), rcState.vShift );
+	__m256i vOut = _mm256_packs_epi32( vLo, vHi );
+	if( bLast )
+	{
+		vOut = _mm256_min_epi16( _mm256_max_epi16( vOut, _mm256_setzero_si256() ), rcState.vMaxVal );
+	}
+	return vOut;
+}
+
+/// 16 outputs; unpacklo/hi keep the lanes, so packing the low and high sums restores the sample order
+template <int N, bool bLast>
+inline void filter16( const short* pSrc, int iStep, short* pDst, const FilterState& rcState )
+{
+	__m256i vLo = _mm256_setzero_si256();
+	__m256i vHi = _mm256_setzero_si256();
+	for( int k = 0; k < N; k += 2 )
+	{
+		const __m256i vA = _mm256_loadu_si256( (const __m256i*)( pSrc + k * iStep ) );
+		const __m256i vB = _mm256_loadu_si256( (const __m256i*)( pSrc + ( k + 1 ) * iStep ) );
+		vLo = _mm256_add_epi32( vLo, _mm256_madd_epi16( _mm256_unpacklo_epi16( vA, vB ), rcState.avCoeff[k >> 1] ) );
+		vHi = _mm256_add_epi32( vHi, _mm256_madd_epi16( _mm256_unpackhi_epi16( vA, vB ), rcState.avCoeff[k >> 1] ) );
+	}
+	_mm256_storeu_si256( (__m256i*)pDst, roundPack<bLast>( vLo, vHi, rcState ) );
+}
+
+/// 8 outputs, the low and high halves of the interleaved samples fill the two lanes
+template <int N, bool bLast>
+inline void filter8( const short* pSrc, int iStep, short* pDst, const FilterState& rcState )
+{
+	__m256i vSum = _mm256_setzero_si256();
+	for( int k = 0; k < N; k += 2 )
+	{
+		const __m128i vA = _mm_loadu_si128( (const __m128i*)( pSrc + k * iStep ) );
+		const __m128i vB = _mm_loadu_si128( (const __m128i*)( pSrc + ( k + 1 ) * iStep ) );
+		const __m256i vPairs = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_unpacklo_epi16( vA, vB ) ), _mm_unpackhi_epi16( vA, vB ), 1 );
+		vSum = _mm256_add_epi32( vSum, _mm256_madd_epi16( vPairs, rcState.avCoeff[k >> 1] ) );
+	}
+	const __m256i vOut = roundPack<bLast>( vSum, vSum, rcState );
+	_mm_storeu_si128( (__m128i*)pDst, _mm256_castsi256_si128( _mm256_permute4x64_epi64( vOut, 0x08 ) ) );
+}
+
+template <int N, bool bLast>
+inline void filter4( const short* pSrc, int iStep, short* pDst, const FilterState& rcState )
+{
+	__m128i vSum = _mm_setzero_si128();
+	for( int k = 0; k < N; k += 2 )
+	{
+		const __m128i vA = _mm_loadl_epi64( (const __m128i*)( pSrc + k * iStep ) );
+		const __m128i vB = _mm_loadl_epi64( (const __m128i*)( pSrc + ( k + 1 ) * iStep ) );
+		vSum = _mm_add_epi32( vSum, _mm_madd_epi16( _mm_unpacklo_epi16( vA, vB ), _mm256_castsi256_si128( rcState.avCoeff[k >> 1] ) ) );
+	}
+	const __m256i vOut = roundPack<bLast>( _mm256_castsi128_si256( vSum ), _mm256_castsi128_si256( vSum ), rcState );
+	_mm_storel_epi64( (__m128i*)pDst, _mm256_castsi256_si128( vOut ) );
+}
+
+template <int N, bool bLast>
+inline void filterRows( const short* pSrc, int iSrcStride, int iStep, short* pDst, int iDstStride, int iWidth, int iHeight, const FilterState& rcState )
+{
+	for( int y = 0; y < iHeight; y++ )
+	{
+		int x = 0;
+		for( ; x + 16 <= iWidth; x += 16 )
+		{
+			filter16<N, bLast>( pSrc + x, iStep, pDst + x, rcState );
+		}
+		if( x + 8 <= iWidth )
+		{
+			filter8<N, bLast>( pSrc + x, iStep, pDst + x, rcState );
+			x += 8;
+		}
+		if( x < iWidth )
+		{
+			filter4<N, bLast>( pSrc + x, iStep, pDst + x, rcState );
+		}
+		pSrc += iSrcStride;
+		pDst += iDstStride;
+	}
+}
+
+template <int N, bool bVertical, bool bFirst, bool bLast>
+void filter_avx2( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iFrac, int iBitDepth )
+{
+	FilterState cState;
+	initState<N>( cState, iFrac, bFirst, bLast, iBitDepth );
+	const int iStep = bVertical ? iSrcStride : 1;
+	filterRows<N, bLast>( pSrc - ( N / 2 - 1 ) * iStep, iSrcStride, iStep, pDst, iDstStride, iWidth, iHeight, cState );
+}
+
+template <int N, bool bLast>
+void filterHV_avx2( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iFracX, int iFracY, int iBitDepth )
+{
+	const int iStripWidth = 16;
+	alignas( 32 ) short asTmp[( MAX_BU_SIZE + N - 1 ) * iStripWidth];
+	FilterState cHor, cVer;
+	initState<N>( cHor, iFracX, true, false, iBitDepth );
+	initState<N>( cVer, iFracY, false, bLast, iBitDepth );
+	pSrc -= ( N / 2 - 1 ) * iSrcStride + ( N / 2 - 1 );
+	for( int x = 0; x < iWidth; x += iStripWidth )
+	{
+		const int iWidthStrip = std::min( iStripWidth, iWidth - x );
+		filterRows<N, false>( pSrc + x, iSrcStride, 1, asTmp, iStripWidth, iWidthStrip, iHeight + N - 1, cHor );
+		filterRows<N, bLast>( asTmp, iStripWidth, iStripWidth, pDst + x, iDstStride, iWidthStrip, iHeight, cVer );
+	}
+}
+
+template <bool bFirst, bool bLast>
+inline __m256i convert( __m256i v, __m128i vShift, __m256i vOffset, __m256i vMaxVal )
+{
+	if( bFirst && !bLast )
+	{
+		return _mm256_add_epi16( _mm256_sll_epi16( v, vShift ), vOffset );
+	}
+	if( bLast && !bFirst )
+	{
+		v = _mm256_sra_epi16( _mm256_add_epi16( v, vOffset ), vShift );
+		return _mm256_min_epi16( _mm256_max_epi16( v, _mm256_setzero_si256() ), vMaxVal );
+	}
+	return v;
+}
+
+template <bool bFirst, bool bLast>
+void copy_avx2( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iBitDepth )
+{
+	const int iShift = std::max( 2, IF_INTERNAL_PREC - iBitDepth );
+	const __m128i vShift = _mm_cvtsi32_si128( iShift );
+	const __m256i vOffset = _mm256_set1_epi16( bFirst ? (short)-IF_INTERNAL_OFFS : (short)( IF_INTERNAL_OFFS + ( 1 << ( iShift - 1 ) ) ) );
+	const __m256i vMaxVal = _mm256_set1_epi16( (short)( ( 1 << iBitDepth ) - 1 ) );
+	for( int y = 0; y < iHeight; y++ )
+	{
+		int x = 0;
+		for( ; x + 16 <= iWidth; x += 16 )
+		{
+			const __m256i v = _mm256_loadu_si256( (const __m256i*)( pSrc + x ) );
+			_mm256_storeu_si256( (__m256i*)( pDst + x ), convert<bFirst, bLast>( v, vShift, vOffset, vMaxVal ) );
+		}
+		if( x + 8 <= iWidth )
+		{
+			const __m256i v = _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)( pSrc + x ) ) );
+			_mm_storeu_si128( (__m128i*)( pDst + x ), _mm256_castsi256_si128( convert<bFirst, bLast>( v, vShift, vOffset, vMaxVal ) ) );
+			x += 8;
+		}
+		if( x < iWidth )
+		{
+			const __m256i v = _mm256_castsi128_si256( _mm_loadl_epi64( (const __m128i*)( pSrc + x ) ) );
+			_mm_storel_epi64( (__m128i*)( pDst + x ), _mm256_castsi256_si128( convert<bFirst, bLast>( v, vShift, vOffset, vMaxVal ) ) );
+		}
+		pSrc += iSrcStride;
+		pDst += iDstStride;
+	}
+}
+
+/// the sum of two intermediates needs 17 bits, it is formed in 32 bits by a madd with ones
+inline __m256i average( __m256i vA, __m256i vB, __m256i vOffset, __m128i vShift, __m256i vMaxVal )
+{
+	const __m256i vOnes = _mm256_set1_epi16( 1 );
+	__m256i vLo = _mm256_madd_epi16( _mm256_unpacklo_epi16( vA, vB ), vOnes );
+	__m256i vHi = _mm256_madd_epi16( _mm256_unpackhi_epi16( vA, vB ), vOnes );
+	vLo = _mm256_sra_epi32( _mm256_add_epi32( vLo, vOffset ), vShift );
+	vHi = _mm256_sra_epi32( _mm256_add_epi32( vHi, vOffset ), vShift );
+	return _mm256_min_epi16( _mm256_max_epi16( _mm256_packs_epi32( vLo, vHi ), _mm256_setzero_si256() ), vMaxVal );
+}
+
+void addAvg_avx2( const short* pSrc0, int iSrc0Stride, const short* pSrc1, int iSrc1Stride, short* pDst, int iDstStride, int iWidth, int iHeight, int iBitDepth )
+{
+	const int iShift = std::max( 2, IF_INTERNAL_PREC - iBitDepth ) + 1;
+	const __m128i vShift = _mm_cvtsi32_si128( iShift );
+	const __m256i vOffset = _mm256_set1_epi32( ( 1 << ( iShift - 1 ) ) + 2 * IF_INTERNAL_OFFS );
+	const __m256i vMaxVal = _mm256_set1_epi16( (short)( ( 1 << iBitDepth ) - 1 ) );
+	for( int y = 0; y < iHeight; y++ )
+	{
+		int x = 0;
+		for( ; x + 16 <= iWidth; x += 16 )
+		{
+			const __m256i vA = _mm256_loadu_si256( (const __m256i*)( pSrc0 + x ) );
+			const __m256i vB = _mm256_loadu_si256( (const __m256i*)( pSrc1 + x ) );
+			_mm256_storeu_si256( (__m256i*)( pDst + x ), average( vA, vB, vOffset, vShift, vMaxVal ) );
+		}
+		if( x + 8 <= iWidth )
+		{
+			const __m256i vA = _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)( pSrc0 + x ) ) );
+			const __m256i vB = _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)( pSrc1 + x ) ) );
+			_mm_storeu_si128( (__m128i*)( pDst + x ), _mm256_castsi256_si128( average( vA, vB, vOffset, vShift, vMaxVal ) ) );
+			x += 8;
+		}
+		if( x < iWidth )
+		{
+			const __m256i vA = _mm256_castsi128_si256( _mm_loadl_epi64( (const __m128i*)( pSrc0 + x ) ) );
+			const __m256i vB = _mm256_castsi128_si256( _mm_loadl_epi64( (const __m128i*)( pSrc1 + x ) ) );
+			_mm_storel_epi64( (__m128i*)( pDst + x ), _mm256_castsi256_si128( average( vA, vB, vOffset, vShift, vMaxVal ) ) );
+		}
+		pSrc0 += iSrc0Stride;
+		pSrc1 += iSrc1Stride;
+		pDst += iDstStride;
+	}
+}
+
+void weightUni_avx2( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iWeight, int iOffset, int iLog2Wd,
+					 int iBitDepth )
+{
+	const int iShift = iLog2Wd + std::max( 2, IF_INTERNAL_PREC - iBitDepth );
+	const __m128i vShift = _mm_cvtsi32_si128( iShift );
+	const __m256i vWeight = _mm256_set1_epi32( iWeight );
+	const __m256i vRound = _mm256_set1_epi32( iWeight * IF_INTERNAL_OFFS + ( 1 << ( iShift - 1 ) ) );
+	const __m256i vOffset = _mm256_set1_epi32( iOffset );
+	const __m128i vMaxVal = _mm_set1_epi16( (short)( ( 1 << iBitDepth ) - 1 ) );
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth; x += 8 )
+		{
+			const __m128i vSrc = x + 8 <= iWidth ? _mm_loadu_si128( (const __m128i*)( pSrc + x ) ) : _mm_loadl_epi64( (const __m128i*)( pSrc + x ) );
+			__m256i v = _mm256_mullo_epi32( _mm256_cvtepi16_epi32( vSrc ), vWeight );
+			v = _mm256_add_epi32( _mm256_sra_epi32( _mm256_add_epi32( v, vRound ), vShift ), vOffset );
+			__m128i vOut = _mm_packs_epi32( _mm256_castsi256_si128( v ), _mm256_extracti128_si256( v, 1 ) );
+			vOut = _mm_min_epi16( _mm_max_epi16( vOut, _mm_setzero_si128() ), vMaxVal );
+			if( x + 8 <= iWidth )
+			{
+				_mm_storeu_si128( (__m128i*)( pDst + x ), vOut );
+			}
+			else
+			{
+				_mm_storel_epi64( (__m128i*)( pDst + x ), vOut );
+			}
+		}
+		pSrc += iSrcStride;
+		pDst += iDstStride;
+	}
+}
+
+template <int N>
+void setupFilter( GvcPrimitives& p, int iFilter )
+{
+	p.interpHor[iFilter][INTERP_PEL_TO_PEL] = filter_avx2<N, false, true, true>;
+	p.interpHor[iFilter][INTERP_PEL_TO_INT] = filter_avx2<N, false, true, false>;
+	p.interpVer[iFilter][INTERP_PEL_TO_PEL] = filter_avx2<N, true, true, true>;
+	p.interpVer[iFilter][INTERP_PEL_TO_INT] = filter_avx2<N, true, true, false>;
+	p.interpVer[iFilter][INTERP_INT_TO_PEL] = filter_avx2<N, true, false, true>;
+	p.interpVer[iFilter][INTERP_INT_TO_INT] = filter_avx2<N, true, false, false>;
+	p.interpHV[iFilter][INTERP_PEL_TO_PEL] = filterHV_avx2<N, true>;
+	p.interpHV[iFilter][INTERP_PEL_TO_INT] = filterHV_avx2<N, false>;
+}
+}  // namespace
+
+void setupInterpPrimitivesAvx2( GvcPrimitives& p )
+{
+	setupFilter<NTAPS_LUMA>( p, INTERP_LUMA );
+	setupFilter<NTAPS_CHROMA>( p, INTERP_CHROMA );
+	p.interpCopy[INTERP_PEL_TO_PEL] = copy_avx2<true, true>;
+	p.interpCopy[INTERP_PEL_TO_INT] = copy_avx2<true, false>;
+	p.interpCopy[INTERP_INT_TO_PEL] = copy_avx2<false, true>;
+	p.interpCopy[INTERP_INT_TO_INT] = copy_avx2<false, false>;
+	p.addAvg = addAvg_avx2;
+	p.weightUni = weightUni_avx2;
+}
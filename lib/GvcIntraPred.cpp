@@ -0,0 +1,182 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcIntraPred.cpp
+ * \brief    Reference C++ implementation of the planar, DC and angular intra prediction
+ */
+
+#include "GvcPrimitives.h"
+#include "GvcRom.h"
+
+namespace
+{
+const int s_aiAngTable[9] = { 0, 2, 5, 9, 13, 17, 21, 26, 32 };
+const int s_aiInvAngTable[9] = { 0, 4096, 1638, 910, 630, 482, 390, 315, 256 };  ///< (256 * 32) / angle
+
+template <int N, int LOG2N>
+void planar_c( short* pDst, int iDstStride, const short* pRef, int, int, bool )
+{
+	const short* pAbove = pRef + 1;
+	const short* pLeft = pRef + 2 * N + 1;
+	const int iTopRight = pAbove[N];
+	const int iBottomLeft = pLeft[N];
+	for( int y = 0; y < N; y++ )
+	{
+		for( int x = 0; x < N; x++ )
+		{
+			pDst[y * iDstStride + x] =
+				(short)( ( ( N - 1 - x ) * pLeft[y] + ( x + 1 ) * iTopRight + ( N - 1 - y ) * pAbove[x] + ( y + 1 ) * iBottomLeft + N ) >> ( LOG2N + 1 ) );
+		}
+	}
+}
+
+template <int N, int LOG2N>
+void dc_c( short* pDst, int iDstStride, const short* pRef, int, int, bool bFilter )
+{
+	const short* pAbove = pRef + 1;
+	const short* pLeft = pRef + 2 * N + 1;
+	int iSum = N;
+	for( int i = 0; i < N; i++ )
+	{
+		iSum += pAbove[i] + pLeft[i];
+	}
+	const short iDC = (short)( iSum >> ( LOG2N + 1 ) );
+	for( int y = 0; y < N; y++ )
+	{
+		for( int x = 0; x < N; x++ )
+		{
+			pDst[y * iDstStride + x] = iDC;
+		}
+	}
+	if( bFilter )
+	{
+		pDst[0] = (short)( ( pAbove[0] + pLeft[0] + 2 * iDC + 2 ) >> 2 );
+		for( int x = 1; x < N; x++ )
+		{
+			pDst[x] = (short)( ( pAbove[x] + 3 * iDC + 2 ) >> 2 );
+		}
+		for( int y = 1; y < N; y++ )
+		{
+			pDst[y * iDstStride] = (short)( ( pLeft[y] + 3 * iDC + 2 ) >> 2 );
+		}
+	}
+}
+
+/**
+ * Vertical modes project each row onto the samples above, horizontal modes are predicted the same way
+ * from the samples at the left and transposed. For negative angles the main reference is extended
+ * to the left with samples of the side reference projected along the prediction direction.
+ */
+template <int N>
+void angular_c( short* pDst, int iDstStride, const short* pRef, int iDirMode, int iBitDepth, bool bFilter )
+{
+	const bool bIsModeVer = iDirMode >= DIA_IDX;
+	const int iPredAngleMode = bIsModeVer ? iDirMode - VER_IDX : -( iDirMode - HOR_IDX );
+	const int iAbsAngMode = iPredAngleMode < 0 ? -iPredAngleMode : iPredAngleMode;
+	const int iPredAngle = ( iPredAngleMode < 0 ? -1 : 1 ) * s_aiAngTable[iAbsAngMode];
+
+	// index N is the top-left sample, the main reference runs to the right of it and may extend to its left
+	short asRefAbove[3 * N + 1];
+	short asRefLeft[3 * N + 1];
+	asRefAbove[N] = asRefLeft[N] = pRef[0];
+	for( int i = 0; i < 2 * N; i++ )
+	{
+		asRefAbove[N + 1 + i] = pRef[1 + i];
+		asRefLeft[N + 1 + i] = pRef[2 * N + 1 + i];
+	}
+	short* pRefMain = ( bIsModeVer ? asRefAbove : asRefLeft ) + N;
+	const short* pRefSide = ( bIsModeVer ? asRefLeft : asRefAbove ) + N;
+	if( iPredAngle < 0 )
+	{
+		const int iInvAngle = s_aiInvAngTable[iAbsAngMode];
+		int iInvAngleSum = 128;
+		for( int k = -1; k > ( N * iPredAngle ) >> 5; k-- )
+		{
+			iInvAngleSum += iInvAngle;
+			pRefMain[k] = pRefSide[iInvAngleSum >> 8];
+		}
+	}
+
+	short asPred[N * N];
+	short* pPred = bIsModeVer ? pDst : asPred;
+	const int iPredStride = bIsModeVer ? iDstStride : N;
+	int iDeltaPos = 0;
+	for( int y = 0; y < N; y++ )
+	{
+		iDeltaPos += iPredAngle;
+		const int iDeltaInt = iDeltaPos >> 5;
+		const int iDeltaFract = iDeltaPos & 31;
+		const short* pMain = pRefMain + iDeltaInt + 1;
+		short* pRow = pPred + y * iPredStride;
+		if( iDeltaFract )
+		{
+			for( int x = 0; x < N; x++ )
+			{
+				pRow[x] = (short)( ( ( 32 - iDeltaFract ) * pMain[x] + iDeltaFract * pMain[x + 1] + 16 ) >> 5 );
+			}
+		}
+		else
+		{
+			for( int x = 0; x < N; x++ )
+			{
+				pRow[x] = pMain[x];
+			}
+		}
+	}
+
+	if( bFilter && iPredAngle == 0 )
+	{
+		const int iMaxVal = ( 1 << iBitDepth ) - 1;
+		for( int y = 0; y < N; y++ )
+		{
+			pPred[y * iPredStride] = (short)Clip3( 0, iMaxVal, pPred[y * iPredStride] + ( ( pRefSide[y + 1] - pRefSide[0] ) >> 1 ) );
+		}
+	}
+	if( !bIsModeVer )
+	{
+		for( int y = 0; y < N; y++ )
+		{
+			for( int x = 0; x < N; x++ )
+			{
+				pDst[y * iDstStride + x] = asPred[x * N + y];
+			}
+		}
+	}
+}
+
+template <int N, int LOG2N>
+void setupIntraSize( GvcPrimitives& p, int iSizeIdx )
+{
+	p.intraPred[iSizeIdx][PLANAR_IDX] = planar_c<N, LOG2N>;
+	p.intraPred[iSizeIdx][DC_IDX] = dc_c<N, LOG2N>;
+	for( int iMode = 2; iMode < NUM_LUMA_MODE; iMode++ )
+	{
+		p.intraPred[iSizeIdx][iMode] = angular_c<N>;
+	}
+}
+}  // namespace
+
+void setupIntraPrimitivesC( GvcPrimitives& p )
+{
+	setupIntraSize<4, 2>( p, TRANSFORM_4x4 );
+	setupIntraSize<8, 3>( p, TRANSFORM_8x8 );
+	setupIntraSize<16, 4>( p, TRANSFORM_16x16 );
+	setupIntraSize<32, 5>( p, TRANSFORM_32x32 );
+}
@@ -0,0 +1,337 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcIntraPredAvx2.cpp
+ * \brief    AVX2 implementation of the intra prediction of the 8x8 to 32x32 blocks
+ *
+ * Angular modes are split in classes: the pure horizontal and vertical modes copy or broadcast the
+ * reference, the diagonal modes (integer angle) copy shifted reference rows and the other modes
+ * interpolate two reference samples per output with one madd. Horizontal modes are predicted as
+ * vertical ones from the left reference and transposed. The 4x4 blocks stay on the C path.
+ */
+
+#include <immintrin.h>
+
+#include "GvcPrimitives.h"
+#include "GvcRom.h"
+
+namespace
+{
+const int s_aiAngTable[9] = { 0, 2, 5, 9, 13, 17, 21, 26, 32 };
+const int s_aiInvAngTable[9] = { 0, 4096, 1638, 910, 630, 482, 390, 315, 256 };
+
+template <int N>
+inline void copyRow( short* pDst, const short* pSrc )
+{
+	if( N == 8 )
+	{
+		_mm_storeu_si128( (__m128i*)pDst, _mm_loadu_si128( (const __m128i*)pSrc ) );
+		return;
+	}
+	for( int x = 0; x < N; x += 16 )
+	{
+		_mm256_storeu_si256( (__m256i*)( pDst + x ), _mm256_loadu_si256( (const __m256i*)( pSrc + x ) ) );
+	}
+}
+
+template <int N>
+inline void fillRow( short* pDst, short iValue )
+{
+	if( N == 8 )
+	{
+		_mm_storeu_si128( (__m128i*)pDst, _mm_set1_epi16( iValue ) );
+		return;
+	}
+	const __m256i v = _mm256_set1_epi16( iValue );
+	for( int x = 0; x < N; x += 16 )
+	{
+		_mm256_storeu_si256( (__m256i*)( pDst + x ), v );
+	}
+}
+
+/// ( ( 32 - f ) * a + f * b + 16 ) >> 5 with a, b interleaved so that one madd weights both
+template <int N>
+inline void interpolateRow( short* pDst, const short* pSrc, int iFract )
+{
+	if( N == 8 )
+	{
+		const __m128i vWeights = _mm_set1_epi32( ( iFract << 16 ) | ( 32 - iFract ) );
+		const __m128i vRound = _mm_set1_epi32( 16 );
+		const __m128i a = _mm_loadu_si128( (const __m128i*)pSrc );
+		const __m128i b = _mm_loadu_si128( (const __m128i*)( pSrc + 1 ) );
+		const __m128i lo = _mm_srai_epi32( _mm_add_epi32( _mm_madd_epi16( _mm_unpacklo_epi16( a, b ), vWeights ), vRound ), 5 );
+		const __m128i hi = _mm_srai_epi32( _mm_add_epi32( _mm_madd_epi16( _mm_unpackhi_epi16( a, b ), vWeights ), vRound ), 5 );
+		_mm_storeu_si128( (__m128i*)pDst, _mm_packs_epi32( lo, hi ) );
+		return;
+	}
+	const __m256i vWeights = _mm256_set1_epi32( ( iFract << 16 ) | ( 32 - iFract ) );
+	const __m256i vRound = _mm256_set1_epi32( 16 );
+	for( int x = 0; x < N; x += 16 )
+	{
+		const __m256i a = _mm256_loadu_si256( (const __m256i*)( pSrc + x ) );
+		const __m256i b = _mm256_loadu_si256( (const __m256i*)( pSrc + x + 1 ) );
+		const __m256i lo = _mm256_srai_epi32( _mm256_add_epi32( _mm256_madd_epi16( _mm256_unpacklo_epi16( a, b ), vWeights ), vRound ), 5 );
+		const __m256i hi = _mm256_srai_epi32( _mm256_add_epi32( _mm256_madd_epi16( _mm256_unpackhi_epi16( a, b ), vWeights ), vRound ), 5 );
+		_mm256_storeu_si256( (__m256i*)( pDst + x ), _mm256_packs_epi32( lo, hi ) );
+	}
+}
+
+/// rows of a vertical mode, pRefMain[0] is the top-left sample; fractional angles interpolate, integer ones copy
+template <int N, bool FRACT>
+inline void predictRows( short* pDst, int iDstStride, const short* pRefMain, int iPredAngle )
+{
+	int iDeltaPos = 0;
+	for( int y = 0; y < N; y++ )
+	{
+		iDeltaPos += iPredAngle;
+		const short* pMain = pRefMain + ( iDeltaPos >> 5 ) + 1;
+		if( FRACT && ( iDeltaPos & 31 ) )
+		{
+			interpolateRow<N>( pDst + y * iDstStride, pMain, iDeltaPos & 31 );
+		}
+		else
+		{
+			copyRow<N>( pDst + y * iDstStride, pMain );
+		}
+	}
+}
+
+/**
+ * Main reference of an angular mode in pBuf + N: the top-left sample, the 2N main samples and, for
+ * negative angles, the side samples projected to the left of the top-left one.
+ */
+template <int N>
+inline const short* prepareRefMain( short* pBuf, short iTopLeft, const short* pMain, const short* pSide, int iAbsAngMode, int iPredAngle )
+{
+	short* pRefMain = pBuf + N;
+	pRefMain[0] = iTopLeft;
+	for( int x = 0; x < 2 * N; x += 8 )
+	{
+		_mm_storeu_si128( (__m128i*)( pRefMain + 1 + x ), _mm_loadu_si128( (const __m128i*)( pMain + x ) ) );
+	}
+	if( iPredAngle < 0 )
+	{
+		// pSide[i - 1] is side sample i, the top-left sample being side sample 0
+		const int iInvAngle = s_aiInvAngTable[iAbsAngMode];
+		int iInvAngleSum = 128;
+		for( int k = -1; k > ( N * iPredAngle ) >> 5; k-- )
+		{
+			iInvAngleSum += iInvAngle;
+			const int iSideIdx = iInvAngleSum >> 8;
+			pRefMain[k] = iSideIdx ? pSide[iSideIdx - 1] : iTopLeft;
+		}
+	}
+	return pRefMain;
+}
+
+inline void transpose8x8( const short* pSrc, int iSrcStride, short* pDst, int iDstStride )
+{
+	__m128i r[8], t[8];
+	for( int i = 0; i < 8; i++ )
+	{
+		r[i] = _mm_loadu_si128( (const __m128i*)( pSrc + i * iSrcStride ) );
+	}
+	for( int i = 0; i < 4; i++ )
+	{
+		t[i] = _mm_unpacklo_epi16( r[2 * i], r[2 * i + 1] );
+		t[i + 4] = _mm_unpackhi_epi16( r[2 * i], r[2 * i + 1] );
+	}
+	for( int h = 0; h < 2; h++ )
+	{
+		const __m128i a = _mm_unpacklo_epi32( t[4 * h], t[4 * h + 1] );
+		const __m128i b = _mm_unpacklo_epi32( t[4 * h + 2], t[4 * h + 3] );
+		const __m128i c = _mm_unpackhi_epi32( t[4 * h], t[4 * h + 1] );
+		const __m128i d = _mm_unpackhi_epi32( t[4 * h + 2], t[4 * h + 3] );
+		_mm_storeu_si128( (__m128i*)( pDst + ( 4 * h + 0 ) * iDstStride ), _mm_unpacklo_epi64( a, b ) );
+		_mm_storeu_si128( (__m128i*)( pDst + ( 4 * h + 1 ) * iDstStride ), _mm_unpackhi_epi64( a, b ) );
+		_mm_storeu_si128( (__m128i*)( pDst + ( 4 * h + 2 ) * iDstStride ), _mm_unpacklo_epi64( c, d ) );
+		_mm_storeu_si128( (__m128i*)( pDst + ( 4 * h + 3 ) * iDstStride ), _mm_unpackhi_epi64( c, d ) );
+	}
+}
+
+template <int N>
+void planar_avx2( short* pDst, int iDstStride, const short* pRef, int, int, bool )
+{
+	const int iLog2N = N == 8 ? 3 : N == 16 ? 4 : 5;
+	const short* pAbove = pRef + 1;
+	const short* pLeft = pRef + 2 * N + 1;
+	const __m256i vTopRight = _mm256_set1_epi32( pAbove[N] );
+	const __m256i vBottomLeft = _mm256_set1_epi32( pLeft[N] );
+	const __m128i vShift = _mm_cvtsi32_si128( iLog2N + 1 );
+	__m256i vAbove[N / 8], vTop[N / 8], vRight[N / 8], vLeftWeight[N / 8];
+	for( int i = 0; i < N / 8; i++ )
+	{
+		const __m256i vX = _mm256_add_epi32( _mm256_set1_epi32( 8 * i ), _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ) );
+		vAbove[i] = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i*)( pAbove + 8 * i ) ) );
+		// ( N - 1 - y ) * above + ( y + 1 ) * bottom left, for y = -1
+		vTop[i] = _mm256_mullo_epi32( vAbove[i], _mm256_set1_epi32( N ) );
+		vRight[i] = _mm256_add_epi32( _mm256_mullo_epi32( _mm256_add_epi32( vX, _mm256_set1_epi32( 1 ) ), vTopRight ), _mm256_set1_epi32( N ) );
+		vLeftWeight[i] = _mm256_sub_epi32( _mm256_set1_epi32( N - 1 ), vX );
+	}
+	for( int y = 0; y < N; y++ )
+	{
+		const __m256i vLeft = _mm256_set1_epi32( pLeft[y] );
+		for( int i = 0; i < N / 8; i++ )
+		{
+			vTop[i] = _mm256_add_epi32( _mm256_sub_epi32( vTop[i], vAbove[i] ), vBottomLeft );
+			__m256i v = _mm256_add_epi32( _mm256_add_epi32( vTop[i], vRight[i] ), _mm256_mullo_epi32( vLeftWeight[i], vLeft ) );
+			v = _mm256_sra_epi32( v, vShift );
+			const __m128i vPacked = _mm_packs_epi32( _mm256_castsi256_si128( v ), _mm256_extracti128_si256( v, 1 ) );
+			_mm_storeu_si128( (__m128i*)( pDst + y * iDstStride + 8 * i ), vPacked );
+		}
+	}
+}
+
+template <int N>
+void dc_avx2( short* pDst, int iDstStride, const short* pRef, int, int, bool bFilter )
+{
+	const int iLog2N = N == 8 ? 3 : N == 16 ? 4 : 5;
+	const short* pAbove = pRef + 1;
+	const short* pLeft = pRef + 2 * N + 1;
+	__m256i vSum = _mm256_setzero_si256();
+	for( int i = 0; i < N; i += 8 )
+	{
+		vSum = _mm256_add_epi32( vSum, _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i*)( pAbove + i ) ) ) );
+		vSum = _mm256_add_epi32( vSum, _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i*)( pLeft + i ) ) ) );
+	}
+	__m128i vSum128 = _mm_add_epi32( _mm256_castsi256_si128( vSum ), _mm256_extracti128_si256( vSum, 1 ) );
+	vSum128 = _mm_add_epi32( vSum128, _mm_shuffle_epi32( vSum128, 0x4E ) );
+	vSum128 = _mm_add_epi32( vSum128, _mm_shuffle_epi32( vSum128, 0xB1 ) );
+	const short iDC = (short)( ( _mm_cvtsi128_si32( vSum128 ) + N ) >> ( iLog2N + 1 ) );
+	for( int y = 0; y < N; y++ )
+	{
+		fillRow<N>( pDst + y * iDstStride, iDC );
+	}
+	if( bFilter )
+	{
+		pDst[0] = (short)( ( pAbove[0] + pLeft[0] + 2 * iDC + 2 ) >> 2 );
+		for( int x = 1; x < N; x++ )
+		{
+			pDst[x] = (short)( ( pAbove[x] + 3 * iDC + 2 ) >> 2 );
+		}
+		for( int y = 1; y < N; y++ )
+		{
+			pDst[y * iDstStride] = (short)( ( pLeft[y] + 3 * iDC + 2 ) >> 2 );
+		}
+	}
+}
+
+template <int N>
+void ver_avx2( short* pDst, int iDstStride, const short* pRef, int, int iBitDepth, bool bFilter )
+{
+	for( int y = 0; y < N; y++ )
+	{
+		copyRow<N>( pDst + y * iDstStride, pRef + 1 );
+	}
+	if( bFilter )
+	{
+		const int iMaxVal = ( 1 << iBitDepth ) - 1;
+		const short* pLeft = pRef + 2 * N + 1;
+		for( int y = 0; y < N; y++ )
+		{
+			pDst[y * iDstStride] = (short)Clip3( 0, iMaxVal, pRef[1] + ( ( pLeft[y] - pRef[0] ) >> 1 ) );
+		}
+	}
+}
+
+template <int N>
+void hor_avx2( short* pDst, int iDstStride, const short* pRef, int, int iBitDepth, bool bFilter )
+{
+	const short* pLeft = pRef + 2 * N + 1;
+	for( int y = 0; y < N; y++ )
+	{
+		fillRow<N>( pDst + y * iDstStride, pLeft[y] );
+	}
+	if( bFilter )
+	{
+		const int iMaxVal = ( 1 << iBitDepth ) - 1;
+		for( int x = 0; x < N; x++ )
+		{
+			pDst[x] = (short)Clip3( 0, iMaxVal, pLeft[0] + ( ( pRef[1 + x] - pRef[0] ) >> 1 ) );
+		}
+	}
+}
+
+/// modes 18 to 34 but 26, predicted from the samples above
+template <int N>
+void angularVer_avx2( short* pDst, int iDstStride, const short* pRef, int iDirMode, int, bool )
+{
+	const int iPredAngleMode = iDirMode - VER_IDX;
+	const int iAbsAngMode = iPredAngleMode < 0 ? -iPredAngleMode : iPredAngleMode;
+	const int iPredAngle = ( iPredAngleMode < 0 ? -1 : 1 ) * s_aiAngTable[iAbsAngMode];
+	short asBuf[3 * N + 1];
+	const short* pRefMain = iPredAngle < 0 ? prepareRefMain<N>( asBuf, pRef[0], pRef + 1, pRef + 2 * N + 1, iAbsAngMode, iPredAngle ) : pRef;
+	if( iAbsAngMode == 8 )
+	{
+		predictRows<N, false>( pDst, iDstStride, pRefMain, iPredAngle );
+	}
+	else
+	{
+		predictRows<N, true>( pDst, iDstStride, pRefMain, iPredAngle );
+	}
+}
+
+/// modes 2 to 17 but 10, predicted as vertical modes from the samples at the left and transposed
+template <int N>
+void angularHor_avx2( short* pDst, int iDstStride, const short* pRef, int iDirMode, int, bool )
+{
+	const int iPredAngleMode = HOR_IDX - iDirMode;
+	const int iAbsAngMode = iPredAngleMode < 0 ? -iPredAngleMode : iPredAngleMode;
+	const int iPredAngle = ( iPredAngleMode < 0 ? -1 : 1 ) * s_aiAngTable[iAbsAngMode];
+	short asBuf[3 * N + 1];
+	const short* pRefMain = prepareRefMain<N>( asBuf, pRef[0], pRef + 2 * N + 1, pRef + 1, iAbsAngMode, iPredAngle );
+	short asPred[N * N];
+	if( iAbsAngMode == 8 )
+	{
+		predictRows<N, false>( asPred, N, pRefMain, iPredAngle );
+	}
+	else
+	{
+		predictRows<N, true>( asPred, N, pRefMain, iPredAngle );
+	}
+	for( int y = 0; y < N; y += 8 )
+	{
+		for( int x = 0; x < N; x += 8 )
+		{
+			transpose8x8( asPred + x * N + y, N, pDst + y * iDstStride + x, iDstStride );
+		}
+	}
+}
+
+template <int N>
+void setupIntraSize( GvcPrimitives& p, int iSizeIdx )
+{
+	p.intraPred[iSizeIdx][PLANAR_IDX] = planar_avx2<N>;
+	p.intraPred[iSizeIdx][DC_IDX] = dc_avx2<N>;
+	for( int iMode = 2; iMode < NUM_LUMA_MODE; iMode++ )
+	{
+		p.intraPred[iSizeIdx][iMode] = iMode < DIA_IDX ? angularHor_avx2<N> : angularVer_avx2<N>;
+	}
+	p.intraPred[iSizeIdx][HOR_IDX] = hor_avx2<N>;
+	p.intraPred[iSizeIdx][VER_IDX] = ver_avx2<N>;
+}
+}  // namespace
+
+void setupIntraPrimitivesAvx2( GvcPrimitives& p )
+{
+	setupIntraSize<8>( p, TRANSFORM_8x8 );
+	setupIntraSize<16>( p, TRANSFORM_16x16 );
+	setupIntraSize<32>( p, TRANSFORM_32x32 );
+}
@@ -0,0 +1,179 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcLoopFilter.cpp
+ * \brief    Deblocking filter
+ */
+
+#include "GvcLoopFilter.h"
+#include "GvcBlockUnit.h"
+#include "GvcFrameUnit.h"
+#include "GvcRom.h"
+#include "TComChromaFormat.h"
+
+/// tC of each QP + 2 * ( bS - 1 ) + tc offset, for 8-bit samples
+static const unsigned char s_aucTcTable[MAX_QP + 3] =
+{
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 5, 5, 6, 6, 7, 8, 9, 10, 11, 13, 14, 16, 18, 20, 22, 24
+};
+
+/// beta of each QP + beta offset, for 8-bit samples
+static const unsigned char s_aucBetaTable[MAX_QP + 1] =
+{
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 20, 22, 24, 26, 28, 30, 32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62, 64
+};
+
+GvcLoopFilter::GvcLoopFilter()
+	: m_bDisabled( false )
+	, m_iBetaOffsetDiv2( 0 )
+	, m_iTcOffsetDiv2( 0 )
+	, m_uiTULog2MaxSize( 5 )
+	, m_iBeta( 0 )
+{
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		m_aiBitDepth[ch] = 8;
+	}
+	for( int i = 0; i < 3; i++ )
+	{
+		m_aiTc[i] = 0;
+	}
+}
+
+GvcLoopFilter::~GvcLoopFilter()
+{
+}
+
+void GvcLoopFilter::create( const int* piBitDepth, unsigned int uiTULog2MaxSize )
+{
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		m_aiBitDepth[ch] = piBitDepth[ch];
+	}
+	m_uiTULog2MaxSize = uiTULog2MaxSize;
+}
+
+void GvcLoopFilter::setParameters( bool bDisabled, int iBetaOffsetDiv2, int iTcOffsetDiv2 )
+{
+	m_bDisabled = bDisabled;
+	m_iBetaOffsetDiv2 = iBetaOffsetDiv2;
+	m_iTcOffsetDiv2 = iTcOffsetDiv2;
+}
+
+void GvcLoopFilter::setQP( int iQP, ChromaFormat chromaFormat )
+{
+	m_iBeta = s_aucBetaTable[Clip3( 0, MAX_QP, iQP + 2 * m_iBetaOffsetDiv2 )] << ( m_aiBitDepth[CHANNEL_TYPE_LUMA] - 8 );
+	for( int iBs = 1; iBs <= 2; iBs++ )
+	{
+		m_aiTc[iBs - 1] = s_aucTcTable[Clip3( 0, MAX_QP + 2, iQP + 2 * ( iBs - 1 ) + 2 * m_iTcOffsetDiv2 )] << ( m_aiBitDepth[CHANNEL_TYPE_LUMA] - 8 );
+	}
+	// chroma edges are only filtered next to intra blocks (bS 2)
+	const int iQPC = chromaFormat == CHROMA_400 ? iQP : getScaledChromaQP( iQP, chromaFormat );
+	m_aiTc[2] = s_aucTcTable[Clip3( 0, MAX_QP + 2, iQPC + 2 + 2 * m_iTcOffsetDiv2 )] << ( m_aiBitDepth[CHANNEL_TYPE_CHROMA] - 8 );
+}
+
+void GvcLoopFilter::loopFilterRow( GvcFrameUnit* pcFrame, int iBURow )
+{
+	const int iWidthInBUs = pcFrame->getFrameWidthInBUs();
+	for( int iBUCol = 0; iBUCol < iWidthInBUs; iBUCol++ )
+	{
+		xDeblockBU( pcFrame, iBURow * iWidthInBUs + iBUCol, EDGE_VER );
+	}
+	for( int iBUCol = 0; iBUCol < iWidthInBUs; iBUCol++ )
+	{
+		xDeblockBU( pcFrame, iBURow * iWidthInBUs + iBUCol, EDGE_HOR );
+	}
+}
+
+/** Edges of one direction of a BU, in 4 line segments. An edge of the 8x8 grid is filtered where the transform
+ *  unit of the q side starts, coding unit boundaries included, except on the frame boundary.
+ */
+void GvcLoopFilter::xDeblockBU( GvcFrameUnit* pcFrame, unsigned int uiBUAddr, GvcDeblockEdgeDir eDir )
+{
+	GvcBlockUnit* pcBU = pcFrame->getBU( uiBUAddr );
+	const ChromaFormat chFmt = pcFrame->getChromaFormat();
+	const unsigned int uiBUPelX = pcBU->getCUPelX();
+	const unsigned int uiBUPelY = pcBU->getCUPelY();
+	const unsigned int uiNumPartX = std::min<unsigned int>( pcFrame->getMaxBUWidth(), pcFrame->getWidth( COMPONENT_Y ) - uiBUPelX ) / MIN_PU_SIZE;
+	const unsigned int uiNumPartY = std::min<unsigned int>( pcFrame->getMaxBUHeight(), pcFrame->getHeight( COMPONENT_Y ) - uiBUPelY ) / MIN_PU_SIZE;
+	const unsigned int uiNumEdges = eDir == EDGE_VER ? uiNumPartX : uiNumPartY;
+	const unsigned int uiEdgeLength = eDir == EDGE_VER ? uiNumPartY : uiNumPartX;
+	const unsigned int uiMaxTUSize = 1u << m_uiTULog2MaxSize;
+	const int iLumaStride = pcFrame->getStride( COMPONENT_Y );
+
+	for( unsigned int uiEdge = ( eDir == EDGE_VER ? uiBUPelX : uiBUPelY ) ? 0 : 2; uiEdge < uiNumEdges; uiEdge += 8 / MIN_PU_SIZE )
+	{
+		const unsigned int uiEdgePel = uiEdge * MIN_PU_SIZE;
+		for( unsigned int uiIdx = 0; uiIdx < uiEdgeLength; uiIdx++ )
+		{
+			const unsigned int uiPartQ =
+				g_auiRasterToZscan[eDir == EDGE_VER ? uiIdx * MAX_NUM_PART_IDXS_IN_BU_WIDTH + uiEdge : uiEdge * MAX_NUM_PART_IDXS_IN_BU_WIDTH + uiIdx];
+			if( uiEdgePel % std::min( pcBU->getWidth( uiPartQ ), uiMaxTUSize ) )
+			{
+				continue;
+			}
+			const unsigned int uiBs = xGetBoundaryStrength( pcBU, uiPartQ, eDir );
+			if( uiBs == 0 )
+			{
+				continue;
+			}
+			g_gvcPrimitives.deblockLuma[eDir]( pcFrame->getAddr( COMPONENT_Y, uiBUAddr, uiPartQ ), iLumaStride, m_aiTc[uiBs - 1], m_iBeta,
+											   m_aiBitDepth[CHANNEL_TYPE_LUMA] );
+			if( uiBs < 2 )
+			{
+				continue;
+			}
+			for( unsigned int comp = COMPONENT_Cb; comp < getNumberValidComponents( chFmt ); comp++ )
+			{
+				const ComponentID compID = ComponentID( comp );
+				const unsigned int uiScaleAcross = eDir == EDGE_VER ? getComponentScaleX( compID, chFmt ) : getComponentScaleY( compID, chFmt );
+				const unsigned int uiScaleAlong = eDir == EDGE_VER ? getComponentScaleY( compID, chFmt ) : getComponentScaleX( compID, chFmt );
+				// chroma edges follow the 8x8 grid of the chroma samples
+				if( ( uiEdgePel >> uiScaleAcross ) % 8 )
+				{
+					continue;
+				}
+				g_gvcPrimitives.deblockChroma[eDir]( pcFrame->getAddr( compID, uiBUAddr, uiPartQ ), pcFrame->getStride( compID ), m_aiTc[2],
+													 MIN_PU_SIZE >> uiScaleAlong, m_aiBitDepth[CHANNEL_TYPE_CHROMA] );
+			}
+		}
+	}
+}
+
+/** 2 next to an intra block, 1 if either transform unit has coded levels or the motion vectors differ by a
+ *  luma sample or more, 0 otherwise. There is a single reference frame.
+ */
+unsigned int GvcLoopFilter::xGetBoundaryStrength( GvcBlockUnit* pcBUQ, unsigned int uiPartQ, GvcDeblockEdgeDir eDir )
+{
+	unsigned int uiPartP = 0;
+	// the edges between tiles are filtered too
+	GvcBlockUnit* pcBUP = eDir == EDGE_VER ? pcBUQ->getPULeft( uiPartP, uiPartQ, false ) : pcBUQ->getPUAbove( uiPartP, uiPartQ, false );
+	if( pcBUP->getPredictionMode( uiPartP ) == MODE_INTRA || pcBUQ->getPredictionMode( uiPartQ ) == MODE_INTRA )
+	{
+		return 2;
+	}
+	if( pcBUP->getCbf( uiPartP ) || pcBUQ->getCbf( uiPartQ ) )
+	{
+		return 1;
+	}
+	const GvcMv& rcMvP = pcBUP->getMv( uiPartP );
+	const GvcMv& rcMvQ = pcBUQ->getMv( uiPartQ );
+	return ( abs( rcMvP.getHor() - rcMvQ.getHor() ) >= 4 || abs( rcMvP.getVer() - rcMvQ.getVer() ) >= 4 ) ? 1 : 0;
+}
@@ -0,0 +1,74 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcLoopFilter.h
+ * \brief    Deblocking filter
+ */
+
+#ifndef __GVCLOOPFILTER_H__
+#define __GVCLOOPFILTER_H__
+
+#include "TypeDef.h"
+#include "GvcPrimitives.h"
+
+class GvcBlockUnit;
+class GvcFrameUnit;
+
+/**
+ * \class    GvcLoopFilter
+ * \brief    Deblocking of the coding and transform unit edges on the 8x8 grid, BU row by BU row
+ *
+ * The vertical edges of a BU row are filtered before its horizontal edges, which reproduces the frame level
+ * order: filtering row r changes the samples of that row and the three bottom lines of row r - 1 only. The
+ * intra prediction of row r + 1 reads the unfiltered bottom line of row r, so GvcInLoopFilter filters row r
+ * once row r + 1 is coded, one BU row behind the encoder.
+ */
+class GvcLoopFilter
+{
+	bool m_bDisabled;
+	int m_iBetaOffsetDiv2;
+	int m_iTcOffsetDiv2;
+	unsigned int m_uiTULog2MaxSize;
+	int m_aiBitDepth[MAX_NUM_CHANNEL_TYPE];
+	// thresholds of the frame being filtered
+	int m_iBeta;
+	int m_aiTc[3];  ///< luma for boundary strength 1 and 2, chroma
+
+  public:
+	GvcLoopFilter();
+	virtual ~GvcLoopFilter();
+
+	void create( const int* piBitDepth, unsigned int uiTULog2MaxSize );
+	void setParameters( bool bDisabled, int iBetaOffsetDiv2, int iTcOffsetDiv2 );
+	bool getDisabled() const { return m_bDisabled; }
+	int getBetaOffsetDiv2() const { return m_iBetaOffsetDiv2; }
+	int getTcOffsetDiv2() const { return m_iTcOffsetDiv2; }
+
+	/// thresholds for a frame coded with iQP
+	void setQP( int iQP, ChromaFormat chromaFormat );
+	/// filtering of one BU row, the rows above it must be filtered already
+	void loopFilterRow( GvcFrameUnit* pcFrame, int iBURow );
+
+  private:
+	void xDeblockBU( GvcFrameUnit* pcFrame, unsigned int uiBUAddr, GvcDeblockEdgeDir eDir );
+	unsigned int xGetBoundaryStrength( GvcBlockUnit* pcBUQ, unsigned int uiPartQ, GvcDeblockEdgeDir eDir );
+};
+
+#endif  // __GVCLOOPFILTER_H__
@@ -0,0 +1,472 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcMotionEstimation.cpp
+ * \brief    Motion estimation: integer search (TZ, full and hierarchical) and quarter sample refinement
+ */
+
+#include "GvcMotionEstimation.h"
+
+#include <algorithm>
+
+#include "GvcFrameUnit.h"
+#include "GvcPrediction.h"
+#include "GvcPrimitives.h"
+#include "GvcRdCost.h"
+
+static const int s_iFilterMargin = 4;            ///< samples of the margin kept for the interpolation filter
+static const int s_iRaster = 5;                  ///< step of the raster search
+static const int s_iFirstSearchRounds = 3;       ///< rounds without improvement ending the first search
+static const int s_iPyramidRefineRange = 2;      ///< full search range of the finer pyramid levels
+static const int s_iPyramidBlockRange = 8;       ///< largest diamond of the block searches seeded by the BU vector
+
+GvcMotionEstimation::GvcMotionEstimation()
+	: m_pcRdCost( NULL )
+	, m_eSearchMethod( ME_TZ )
+	, m_iSearchRange( 64 )
+	, m_bHadamardME( true )
+	, m_iBitDepth( 8 )
+	, m_iNumRefLines( 0 )
+	, m_iMinX( 0 )
+	, m_iMaxX( 0 )
+	, m_iMinY( 0 )
+	, m_iMaxY( 0 )
+	, m_iMaxDistance( 0 )
+	, m_iMvShift( 2 )
+	, m_uiNumSadEvals( 0 )
+	, m_uiTotalSadEvals( 0 )
+	, m_uiNumSearches( 0 )
+	, m_uiPyramidSadEvals( 0 )
+{
+}
+
+GvcMotionEstimation::~GvcMotionEstimation()
+{
+}
+
+void GvcMotionEstimation::init( GvcRdCost* pcRdCost, MESearchMethod eSearchMethod, int iSearchRange, bool bHadamardME, int iBitDepth )
+{
+	m_iBitDepth = iBitDepth;
+	m_pcRdCost = pcRdCost;
+	m_eSearchMethod = eSearchMethod;
+	m_iSearchRange = iSearchRange;
+	m_bHadamardME = bHadamardME;
+}
+
+int GvcMotionEstimation::getRefLagLines( int iSearchRange )
+{
+	// the filter margin holds on the coarsest pyramid level too
+	return iSearchRange > 0 ? iSearchRange + ( s_iFilterMargin << ( NUM_PYRAMID_LEVELS - 1 ) ) : 0;
+}
+
+/**
+ * The window spans iRange samples around the centre, clamped to the frame and its margin less the
+ * filter support, and above the first iNumRefLines lines when they are given. A range of 0 opens it
+ * to the whole frame.
+ */
+void GvcMotionEstimation::xSetSearchWindow( int iFrameWidth, int iFrameHeight, int iMarginX, int iMarginY, int iNumRefLines, int iPelX, int iPelY, int iWidth,
+											int iHeight, int iCentreX, int iCentreY, int iRange )
+{
+	const int iMinX = -iPelX - iMarginX + s_iFilterMargin;
+	const int iMaxX = iFrameWidth - iPelX - iWidth + iMarginX - s_iFilterMargin;
+	const int iMinY = -iPelY - iMarginY + s_iFilterMargin;
+	int iMaxY = iFrameHeight - iPelY - iHeight + iMarginY - s_iFilterMargin;
+	if( iNumRefLines > 0 )
+	{
+		iMaxY = std::min( iMaxY, iNumRefLines - iPelY - iHeight - s_iFilterMargin );
+	}
+	if( iRange <= 0 )
+	{
+		m_iMinX = iMinX;
+		m_iMaxX = iMaxX;
+		m_iMinY = iMinY;
+		m_iMaxY = iMaxY;
+		m_iMaxDistance = std::max( iMaxX - iMinX, iMaxY - iMinY );
+		return;
+	}
+	iCentreX = Clip3( iMinX, iMaxX, iCentreX );
+	iCentreY = Clip3( iMinY, iMaxY, iCentreY );
+	m_iMinX = std::max( iMinX, iCentreX - iRange );
+	m_iMaxX = std::min( iMaxX, iCentreX + iRange );
+	m_iMinY = std::max( iMinY, iCentreY - iRange );
+	m_iMaxY = std::min( iMaxY, iCentreY + iRange );
+	m_iMaxDistance = iRange;
+}
+
+double GvcMotionEstimation::xGetCost( unsigned int uiSad, int iX, int iY ) const
+{
+	return m_pcRdCost->calcRdCostSqrt( m_pcRdCost->getBitsOfVectorWithPredictor( iX * ( 1 << m_iMvShift ), iY * ( 1 << m_iMvShift ) ), uiSad );
+}
+
+void GvcMotionEstimation::xCheckPoint( TZSearchStruct& rcStruct, int iX, int iY, int iDistance )
+{
+	if( !xInWindow( iX, iY ) )
+	{
+		return;
+	}
+	const unsigned int uiSad =
+		g_gvcPrimitives.sad[rcStruct.iSizeIdx]( rcStruct.pOrg, rcStruct.iOrgStride, rcStruct.pRef + iY * rcStruct.iRefStride + iX, rcStruct.iRefStride );
+	m_uiNumSadEvals++;
+	const double dCost = xGetCost( uiSad, iX, iY );
+	if( dCost < rcStruct.dBestCost )
+	{
+		rcStruct.dBestCost = dCost;
+		rcStruct.iBestX = iX;
+		rcStruct.iBestY = iY;
+		rcStruct.iBestDistance = iDistance;
+		rcStruct.iBestRound = 0;
+	}
+}
+
+/** Points outside the window are dropped, the others are evaluated four (or three) at a time. */
+void GvcMotionEstimation::xCheckPoints( TZSearchStruct& rcStruct, const int* piX, const int* piY, int iNumPoints, int iDistance )
+{
+	int aiX[16], aiY[16];
+	int iNum = 0;
+	for( int i = 0; i < iNumPoints; i++ )
+	{
+		if( xInWindow( piX[i], piY[i] ) )
+		{
+			aiX[iNum] = piX[i];
+			aiY[iNum] = piY[i];
+			iNum++;
+		}
+	}
+
+	const short* pRef = rcStruct.pRef;
+	const int iRefStride = rcStruct.iRefStride;
+	int i = 0;
+	for( ; i + 4 <= iNum; i += 4 )
+	{
+		unsigned int auiSad[4];
+		g_gvcPrimitives.sadX4[rcStruct.iSizeIdx]( rcStruct.pOrg, rcStruct.iOrgStride, pRef + aiY[i] * iRefStride + aiX[i], pRef + aiY[i + 1] * iRefStride + aiX[i + 1],
+												  pRef + aiY[i + 2] * iRefStride + aiX[i + 2], pRef + aiY[i + 3] * iRefStride + aiX[i + 3], iRefStride, auiSad );
+		m_uiNumSadEvals += 4;
+		for( int k = 0; k < 4; k++ )
+		{
+			const double dCost = xGetCost( auiSad[k], aiX[i + k], aiY[i + k] );
+			if( dCost < rcStruct.dBestCost )
+			{
+				rcStruct.dBestCost = dCost;
+				rcStruct.iBestX = aiX[i + k];
+				rcStruct.iBestY = aiY[i + k];
+				rcStruct.iBestDistance = iDistance;
+				rcStruct.iBestRound = 0;
+			}
+		}
+	}
+	if( i + 3 == iNum )
+	{
+		unsigned int auiSad[3];
+		g_gvcPrimitives.sadX3[rcStruct.iSizeIdx]( rcStruct.pOrg, rcStruct.iOrgStride, pRef + aiY[i] * iRefStride + aiX[i], pRef + aiY[i + 1] * iRefStride + aiX[i + 1],
+												  pRef + aiY[i + 2] * iRefStride + aiX[i + 2], iRefStride, auiSad );
+		m_uiNumSadEvals += 3;
+		for( int k = 0; k < 3; k++ )
+		{
+			const double dCost = xGetCost( auiSad[k], aiX[i + k], aiY[i + k] );
+			if( dCost < rcStruct.dBestCost )
+			{
+				rcStruct.dBestCost = dCost;
+				rcStruct.iBestX = aiX[i + k];
+				rcStruct.iBestY = aiY[i + k];
+				rcStruct.iBestDistance = iDistance;
+				rcStruct.iBestRound = 0;
+			}
+		}
+		return;
+	}
+	for( ; i < iNum; i++ )
+	{
+		xCheckPoint( rcStruct, aiX[i], aiY[i], iDistance );
+	}
+}
+
+/**
+ * Eight points of a diamond of radius iDistance around the start position, for distances above 8
+ * the edges of the diamond are sampled every iDistance / 4 samples.
+ */
+void GvcMotionEstimation::xDiamondSearch( TZSearchStruct& rcStruct, int iStartX, int iStartY, int iDistance )
+{
+	int aiX[16], aiY[16];
+	int iNum = 0;
+	const int iTop = iStartY - iDistance;
+	const int iBottom = iStartY + iDistance;
+	const int iLeft = iStartX - iDistance;
+	const int iRight = iStartX + iDistance;
+	rcStruct.iBestRound++;
+
+	if( iDistance == 1 )
+	{
+		const int aiPointX[4] = { iStartX, iLeft, iRight, iStartX };
+		const int aiPointY[4] = { iTop, iStartY, iStartY, iBottom };
+		xCheckPoints( rcStruct, aiPointX, aiPointY, 4, iDistance );
+		return;
+	}
+	if( iDistance <= 8 )
+	{
+		const int iHalf = iDistance >> 1;
+		const int aiPointX[8] = { iStartX, iStartX - iHalf, iStartX + iHalf, iLeft, iRight, iStartX - iHalf, iStartX + iHalf, iStartX };
+		const int aiPointY[8] = { iTop, iStartY - iHalf, iStartY - iHalf, iStartY, iStartY, iStartY + iHalf, iStartY + iHalf, iBottom };
+		xCheckPoints( rcStruct, aiPointX, aiPointY, 8, iDistance );
+		return;
+	}
+	aiX[iNum] = iStartX, aiY[iNum++] = iTop;
+	aiX[iNum] = iLeft, aiY[iNum++] = iStartY;
+	aiX[iNum] = iRight, aiY[iNum++] = iStartY;
+	aiX[iNum] = iStartX, aiY[iNum++] = iBottom;
+	const int iStep = iDistance >> 2;
+	for( int iIdx = 1; iIdx < 4; iIdx++ )
+	{
+		const int iPosYT = iTop + iStep * iIdx;
+		const int iPosYB = iBottom - iStep * iIdx;
+		const int iPosXL = iStartX - iStep * iIdx;
+		const int iPosXR = iStartX + iStep * iIdx;
+		aiX[iNum] = iPosXL, aiY[iNum++] = iPosYT;
+		aiX[iNum] = iPosXR, aiY[iNum++] = iPosYT;
+		aiX[iNum] = iPosXL, aiY[iNum++] = iPosYB;
+		aiX[iNum] = iPosXR, aiY[iNum++] = iPosYB;
+	}
+	xCheckPoints( rcStruct, aiX, aiY, iNum, iDistance );
+}
+
+/**
+ * TZ search: the best of the predictors and the zero vector seeds diamonds of growing radius, stopped
+ * after three rounds without improvement. A raster scan covers the window when the best position is
+ * still far from the start, then diamonds around the best position refine it until it stays put.
+ */
+void GvcMotionEstimation::xTZSearch( TZSearchStruct& rcStruct, const GvcMv* pcMvCands, int iNumCands )
+{
+	const GvcMv& rcPred = m_pcRdCost->getPredictor();
+	const int iMaxDistance = m_iMaxDistance;
+	xCheckPoint( rcStruct, Clip3( m_iMinX, m_iMaxX, ( rcPred.getHor() + 2 ) >> 2 ), Clip3( m_iMinY, m_iMaxY, ( rcPred.getVer() + 2 ) >> 2 ), 0 );
+	for( int i = 0; i < iNumCands; i++ )
+	{
+		xCheckPoint( rcStruct, ( pcMvCands[i].getHor() + 2 ) >> 2, ( pcMvCands[i].getVer() + 2 ) >> 2, 0 );
+	}
+	xCheckPoint( rcStruct, 0, 0, 0 );
+
+	// first search
+	const int iStartX = rcStruct.iBestX;
+	const int iStartY = rcStruct.iBestY;
+	rcStruct.iBestRound = 0;
+	for( int iDist = 1; iDist <= iMaxDistance; iDist <<= 1 )
+	{
+		xDiamondSearch( rcStruct, iStartX, iStartY, iDist );
+		if( rcStruct.iBestRound >= s_iFirstSearchRounds )
+		{
+			break;
+		}
+	}
+
+	// raster search, left to the downscaled planes in a pyramid search
+	if( m_eSearchMethod != ME_PYRAMID && rcStruct.iBestDistance > s_iRaster )
+	{
+		int aiX[4], aiY[4];
+		for( int iY = m_iMinY; iY <= m_iMaxY; iY += s_iRaster )
+		{
+			int iNum = 0;
+			for( int iX = m_iMinX; iX <= m_iMaxX; iX += s_iRaster )
+			{
+				aiX[iNum] = iX;
+				aiY[iNum++] = iY;
+				if( iNum == 4 )
+				{
+					xCheckPoints( rcStruct, aiX, aiY, iNum, s_iRaster );
+					iNum = 0;
+				}
+			}
+			xCheckPoints( rcStruct, aiX, aiY, iNum, s_iRaster );
+		}
+	}
+
+	// star refinement
+	while( rcStruct.iBestDistance > 0 )
+	{
+		const int iRefineX = rcStruct.iBestX;
+		const int iRefineY = rcStruct.iBestY;
+		rcStruct.iBestDistance = 0;
+		for( int iDist = 1; iDist <= iMaxDistance; iDist <<= 1 )
+		{
+			xDiamondSearch( rcStruct, iRefineX, iRefineY, iDist );
+		}
+	}
+}
+
+void GvcMotionEstimation::xFullSearch( TZSearchStruct& rcStruct )
+{
+	int aiX[4], aiY[4];
+	for( int iY = m_iMinY; iY <= m_iMaxY; iY++ )
+	{
+		int iNum = 0;
+		for( int iX = m_iMinX; iX <= m_iMaxX; iX++ )
+		{
+			aiX[iNum] = iX;
+			aiY[iNum++] = iY;
+			if( iNum == 4 )
+			{
+				xCheckPoints( rcStruct, aiX, aiY, iNum, 0 );
+				iNum = 0;
+			}
+		}
+		xCheckPoints( rcStruct, aiX, aiY, iNum, 0 );
+	}
+}
+
+double GvcMotionEstimation::motionSearch( const short* pOrg, int iOrgStride, GvcFrameUnit* pcRefFrame, int iPelX, int iPelY, int iWidth, int iHeight,
+										  const GvcMv* pcMvCands, int iNumCands, GvcMv& rcMv )
+{
+	TZSearchStruct cStruct;
+	cStruct.pOrg = pOrg;
+	cStruct.iOrgStride = iOrgStride;
+	cStruct.iRefStride = pcRefFrame->getStride( COMPONENT_Y );
+	cStruct.pRef = pcRefFrame->getAddr( COMPONENT_Y ) + iPelY * cStruct.iRefStride + iPelX;
+	cStruct.iSizeIdx = getBlockSizeIdx( iWidth, iHeight );
+	cStruct.iBestX = 0;
+	cStruct.iBestY = 0;
+	cStruct.dBestCost = MAX_DOUBLE;
+	cStruct.iBestDistance = 0;
+	cStruct.iBestRound = 0;
+
+	m_uiNumSadEvals = 0;
+	m_iMvShift = 2;
+	const GvcMv& rcPred = m_pcRdCost->getPredictor();
+	xSetSearchWindow( pcRefFrame->getWidth( COMPONENT_Y ), pcRefFrame->getHeight( COMPONENT_Y ), pcRefFrame->getMarginX( COMPONENT_Y ),
+					  pcRefFrame->getMarginY( COMPONENT_Y ), m_iNumRefLines, iPelX, iPelY, iWidth, iHeight, ( rcPred.getHor() + 2 ) >> 2, ( rcPred.getVer() + 2 ) >> 2,
+					  m_iSearchRange );
+	if( m_eSearchMethod == ME_PYRAMID )
+	{
+		// the BU vector already covers the range, the seeds are only refined locally
+		m_iMaxDistance = std::min( m_iMaxDistance, s_iPyramidBlockRange );
+	}
+	if( m_eSearchMethod == ME_FULL )
+	{
+		xFullSearch( cStruct );
+	}
+	else
+	{
+		xTZSearch( cStruct, pcMvCands, iNumCands );
+	}
+	m_uiTotalSadEvals += m_uiNumSadEvals;
+	m_uiNumSearches++;
+
+	return xSubPelRefine( cStruct, iWidth, iHeight, rcMv );
+}
+
+unsigned int GvcMotionEstimation::xGetFracDistortion( const TZSearchStruct& rcStruct, const short* pCur, int iCurStride, int iWidth, int iHeight ) const
+{
+	if( m_bHadamardME )
+	{
+		return GvcRdCost::getSATD( rcStruct.pOrg, rcStruct.iOrgStride, pCur, iCurStride, iWidth, iHeight, m_iBitDepth );
+	}
+	return GvcRdCost::getSAD( rcStruct.pOrg, rcStruct.iOrgStride, pCur, iCurStride, iWidth, iHeight );
+}
+
+/**
+ * Eight half sample positions around the best integer vector, then eight quarter sample positions
+ * around the best of those. The integer position is measured again first, so that all candidates
+ * share the distortion measure.
+ */
+double GvcMotionEstimation::xSubPelRefine( const TZSearchStruct& rcStruct, int iWidth, int iHeight, GvcMv& rcMv )
+{
+	int iBestX = rcStruct.iBestX * 4;
+	int iBestY = rcStruct.iBestY * 4;
+	const unsigned int uiDist = xGetFracDistortion( rcStruct, rcStruct.pRef + rcStruct.iBestY * rcStruct.iRefStride + rcStruct.iBestX, rcStruct.iRefStride, iWidth,
+													iHeight );
+	double dBestCost = m_pcRdCost->calcRdCostSqrt( m_pcRdCost->getBitsOfVectorWithPredictor( iBestX, iBestY ), uiDist );
+	for( int iStep = 2; iStep >= 1; iStep >>= 1 )
+	{
+		const int iCentreX = iBestX;
+		const int iCentreY = iBestY;
+		for( int iDy = -1; iDy <= 1; iDy++ )
+		{
+			for( int iDx = -1; iDx <= 1; iDx++ )
+			{
+				if( iDx == 0 && iDy == 0 )
+				{
+					continue;
+				}
+				const int iX = iCentreX + iDx * iStep;
+				const int iY = iCentreY + iDy * iStep;
+				GvcPrediction::interpolateBlock( INTERP_LUMA, rcStruct.pRef + ( iY >> 2 ) * rcStruct.iRefStride + ( iX >> 2 ), rcStruct.iRefStride, m_asFracBuf,
+												 MAX_BU_SIZE, iWidth, iHeight, iX & 3, iY & 3, m_iBitDepth );
+				const double dCost =
+					m_pcRdCost->calcRdCostSqrt( m_pcRdCost->getBitsOfVectorWithPredictor( iX, iY ), xGetFracDistortion( rcStruct, m_asFracBuf, MAX_BU_SIZE, iWidth, iHeight ) );
+				if( dCost < dBestCost )
+				{
+					dBestCost = dCost;
+					iBestX = iX;
+					iBestY = iY;
+				}
+			}
+		}
+	}
+	rcMv.set( iBestX, iBestY );
+	return dBestCost;
+}
+
+/** Full search of the BU on one pyramid level, vectors in samples of that level. */
+void GvcMotionEstimation::xPyramidLevelSearch( const GvcFrameUnit* pcOrgFrame, const GvcFrameUnit* pcRefFrame, int iLevel, int iPelX, int iPelY, int iWidth,
+											   int iHeight, int iCentreX, int iCentreY, int iRange, int& riBestX, int& riBestY )
+{
+	iPelX >>= iLevel;
+	iPelY >>= iLevel;
+	iWidth >>= iLevel;
+	iHeight >>= iLevel;
+	TZSearchStruct cStruct;
+	cStruct.iOrgStride = pcOrgFrame->getPyramidStride( iLevel );
+	cStruct.pOrg = pcOrgFrame->getPyramidAddr( iLevel ) + iPelY * cStruct.iOrgStride + iPelX;
+	cStruct.iRefStride = pcRefFrame->getPyramidStride( iLevel );
+	cStruct.pRef = pcRefFrame->getPyramidAddr( iLevel ) + iPelY * cStruct.iRefStride + iPelX;
+	cStruct.iSizeIdx = getBlockSizeIdx( iWidth, iHeight );
+	cStruct.iBestX = 0;
+	cStruct.iBestY = 0;
+	cStruct.dBestCost = MAX_DOUBLE;
+	cStruct.iBestDistance = 0;
+	cStruct.iBestRound = 0;
+
+	m_iMvShift = 2 + iLevel;
+	xSetSearchWindow( pcRefFrame->getPyramidWidth( iLevel ), pcRefFrame->getPyramidHeight( iLevel ), pcRefFrame->getPyramidMarginX( iLevel ),
+					  pcRefFrame->getPyramidMarginY( iLevel ), m_iNumRefLines >> iLevel, iPelX, iPelY, iWidth, iHeight, iCentreX, iCentreY, iRange );
+	xFullSearch( cStruct );
+	riBestX = cStruct.iBestX;
+	riBestY = cStruct.iBestY;
+}
+
+/**
+ * The coarsest level is searched over the whole search range scaled down to it, every finer level
+ * refines the doubled vector within +-2 samples. Vector bits are counted against the zero vector.
+ */
+void GvcMotionEstimation::pyramidSearch( const GvcFrameUnit* pcOrgFrame, const GvcFrameUnit* pcRefFrame, int iPelX, int iPelY, int iWidth, int iHeight )
+{
+	const int iTopLevel = NUM_PYRAMID_LEVELS - 1;
+	m_pcRdCost->setPredictor( GvcMv() );
+	m_uiNumSadEvals = 0;
+	int iBestX = 0;
+	int iBestY = 0;
+	xPyramidLevelSearch( pcOrgFrame, pcRefFrame, iTopLevel, iPelX, iPelY, iWidth, iHeight, 0, 0,
+						 ( m_iSearchRange + ( 1 << iTopLevel ) - 1 ) >> iTopLevel, iBestX, iBestY );
+	for( int iLevel = iTopLevel - 1; iLevel >= 0; iLevel-- )
+	{
+		xPyramidLevelSearch( pcOrgFrame, pcRefFrame, iLevel, iPelX, iPelY, iWidth, iHeight, iBestX * 2, iBestY * 2, s_iPyramidRefineRange, iBestX, iBestY );
+	}
+	m_cPyramidMv.set( iBestX * 4, iBestY * 4 );
+	m_uiPyramidSadEvals += m_uiNumSadEvals;
+	m_uiTotalSadEvals += m_uiNumSadEvals;
+}
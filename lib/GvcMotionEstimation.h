@@ -0,0 +1,146 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcMotionEstimation.h
+ * \brief    Motion estimation: integer search (TZ, full and hierarchical) and quarter sample refinement
+ */
+
+#ifndef __GVCMOTIONESTIMATION_H__
+#define __GVCMOTIONESTIMATION_H__
+
+#include "TypeDef.h"
+#include "GvcMv.h"
+
+class GvcFrameUnit;
+class GvcRdCost;
+
+/// motion search method, as selected by FastSearch
+enum MESearchMethod
+{
+	ME_FULL = 0,  ///< every position of the window, reference for validation
+	ME_TZ = 1,    ///< predictor seeded diamond and raster search
+	ME_PYRAMID = 2,  ///< TZ search refining locally a vector found per BU on the downscaled planes
+};
+
+/**
+ * \class    GvcMotionEstimation
+ * \brief    Finds the motion vector of a luma block that minimizes SAD + sqrt(lambda) * mvd bits
+ *
+ * The window spans SearchRange samples around the vector predictor set in the RD cost and is
+ * clamped so that the displaced block, with the interpolation filter support, stays inside the
+ * padded margin of the reference frame, or above the lines set by setNumRefLines. The best integer vector is then refined to half and to
+ * quarter samples on interpolated blocks, measured with SATD when HadamardME is enabled.
+ *
+ * With ME_PYRAMID, pyramidSearch covers the search range once per BU: a full search on the quarter
+ * resolution planes, refined at half and full resolution. The block searches take that vector as a
+ * seed and refine locally without the raster scan, so large motion costs a fraction of the SAD
+ * evaluations of a wide TZ search.
+ */
+class GvcMotionEstimation
+{
+  private:
+	/// state of a TZ search
+	struct TZSearchStruct
+	{
+		const short* pOrg;
+		int iOrgStride;
+		const short* pRef;  ///< reference block at the zero vector
+		int iRefStride;
+		int iSizeIdx;  ///< primitive table index of the block size
+		int iBestX;
+		int iBestY;
+		double dBestCost;
+		int iBestDistance;  ///< distance of the search pattern that found the best position
+		int iBestRound;     ///< pattern rounds run since the best position was found
+	};
+
+	GvcRdCost* m_pcRdCost;
+	MESearchMethod m_eSearchMethod;
+	int m_iSearchRange;
+	bool m_bHadamardME;
+	int m_iBitDepth;
+	int m_iNumRefLines;  ///< luma lines of the reference the search may read, 0: the whole frame and its margins
+	// window of the current search, integer sample vectors
+	int m_iMinX;
+	int m_iMaxX;
+	int m_iMinY;
+	int m_iMaxY;
+	int m_iMaxDistance;  ///< largest diamond of the TZ search
+	int m_iMvShift;      ///< from the vectors of the searched plane to quarter samples of the frame
+	GvcMv m_cPyramidMv;  ///< vector of the current BU found by the hierarchical search
+	short m_asFracBuf[MAX_BU_SIZE * MAX_BU_SIZE];  ///< interpolated candidate of the sub-sample refinement
+	// statistics
+	unsigned int m_uiNumSadEvals;            ///< SAD evaluations of the last search
+	unsigned long long m_uiTotalSadEvals;
+	unsigned long long m_uiNumSearches;
+	unsigned long long m_uiPyramidSadEvals;  ///< part of the total spent on the downscaled planes
+
+	void xSetSearchWindow( int iFrameWidth, int iFrameHeight, int iMarginX, int iMarginY, int iNumRefLines, int iPelX, int iPelY, int iWidth, int iHeight,
+						   int iCentreX, int iCentreY, int iRange );
+	bool xInWindow( int iX, int iY ) const { return iX >= m_iMinX && iX <= m_iMaxX && iY >= m_iMinY && iY <= m_iMaxY; }
+	double xGetCost( unsigned int uiSad, int iX, int iY ) const;
+	void xCheckPoint( TZSearchStruct& rcStruct, int iX, int iY, int iDistance );
+	void xCheckPoints( TZSearchStruct& rcStruct, const int* piX, const int* piY, int iNumPoints, int iDistance );
+	void xDiamondSearch( TZSearchStruct& rcStruct, int iStartX, int iStartY, int iDistance );
+	void xTZSearch( TZSearchStruct& rcStruct, const GvcMv* pcMvCands, int iNumCands );
+	void xFullSearch( TZSearchStruct& rcStruct );
+	unsigned int xGetFracDistortion( const TZSearchStruct& rcStruct, const short* pCur, int iCurStride, int iWidth, int iHeight ) const;
+	double xSubPelRefine( const TZSearchStruct& rcStruct, int iWidth, int iHeight, GvcMv& rcMv );
+	void xPyramidLevelSearch( const GvcFrameUnit* pcOrgFrame, const GvcFrameUnit* pcRefFrame, int iLevel, int iPelX, int iPelY, int iWidth, int iHeight,
+							  int iCentreX, int iCentreY, int iRange, int& riBestX, int& riBestY );
+
+  public:
+	GvcMotionEstimation();
+	virtual ~GvcMotionEstimation();
+
+	void init( GvcRdCost* pcRdCost, MESearchMethod eSearchMethod, int iSearchRange, bool bHadamardME, int iBitDepth );
+	/// limits the reads to the first iNumRefLines luma lines of the reference, while the frame is still being reconstructed
+	void setNumRefLines( int iNumRefLines ) { m_iNumRefLines = iNumRefLines; }
+	/// luma lines below a block that a search over iSearchRange reads, the support of the filters included (0: unbounded)
+	static int getRefLagLines( int iSearchRange );
+
+	/**
+	 * Searches the luma block of iWidth x iHeight at (iPelX, iPelY) in pcRefFrame. The vector predictor
+	 * of the RD cost centres the window, pcMvCands are further start candidates for the TZ search.
+	 * Returns the cost of the best vector after the sub-sample refinement, written to rcMv in
+	 * quarter sample units.
+	 */
+	double motionSearch( const short* pOrg, int iOrgStride, GvcFrameUnit* pcRefFrame, int iPelX, int iPelY, int iWidth, int iHeight, const GvcMv* pcMvCands,
+						 int iNumCands, GvcMv& rcMv );
+
+	/**
+	 * Searches the BU of iWidth x iHeight luma samples at (iPelX, iPelY) from coarse to fine on the
+	 * pyramids of both frames, see GvcFrameUnit::buildPyramid. The vector, in quarter sample units,
+	 * is returned by getPyramidMv to seed the block searches of the BU.
+	 */
+	void pyramidSearch( const GvcFrameUnit* pcOrgFrame, const GvcFrameUnit* pcRefFrame, int iPelX, int iPelY, int iWidth, int iHeight );
+	const GvcMv& getPyramidMv() const { return m_cPyramidMv; }
+	/// seeds the block searches with the vector another instance found for the BU
+	void setPyramidMv( const GvcMv& rcMv ) { m_cPyramidMv = rcMv; }
+	MESearchMethod getSearchMethod() const { return m_eSearchMethod; }
+
+	bool getHadamardME() const { return m_bHadamardME; }
+	unsigned int getNumSadEvals() const { return m_uiNumSadEvals; }
+	unsigned long long getTotalSadEvals() const { return m_uiTotalSadEvals; }
+	unsigned long long getNumSearches() const { return m_uiNumSearches; }
+	unsigned long long getPyramidSadEvals() const { return m_uiPyramidSadEvals; }
+};
+
+#endif  // __GVCMOTIONESTIMATION_H__
@@ -0,0 +1,96 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcMv.h
+ * \brief    Motion vector
+ */
+
+#ifndef __GVCMV_H__
+#define __GVCMV_H__
+
+#include "TypeDef.h"
+
+/**
+ * \class    GvcMv
+ * \brief    Motion vector in quarter luma sample units
+ */
+class GvcMv
+{
+  private:
+	short m_iHor;
+	short m_iVer;
+
+  public:
+	GvcMv()
+		: m_iHor( 0 )
+		, m_iVer( 0 )
+	{
+	}
+	GvcMv( int iHor, int iVer )
+		: m_iHor( (short)iHor )
+		, m_iVer( (short)iVer )
+	{
+	}
+
+	void set( int iHor, int iVer )
+	{
+		m_iHor = (short)iHor;
+		m_iVer = (short)iVer;
+	}
+	void setHor( int i ) { m_iHor = (short)i; }
+	void setVer( int i ) { m_iVer = (short)i; }
+	void setZero() { m_iHor = m_iVer = 0; }
+
+	int getHor() const { return m_iHor; }
+	int getVer() const { return m_iVer; }
+	int getAbsHor() const { return m_iHor < 0 ? -m_iHor : m_iHor; }
+	int getAbsVer() const { return m_iVer < 0 ? -m_iVer : m_iVer; }
+
+	const GvcMv& operator+=( const GvcMv& rcMv )
+	{
+		m_iHor += rcMv.m_iHor;
+		m_iVer += rcMv.m_iVer;
+		return *this;
+	}
+	const GvcMv& operator-=( const GvcMv& rcMv )
+	{
+		m_iHor -= rcMv.m_iHor;
+		m_iVer -= rcMv.m_iVer;
+		return *this;
+	}
+	const GvcMv& operator<<=( int i )
+	{
+		m_iHor <<= i;
+		m_iVer <<= i;
+		return *this;
+	}
+	const GvcMv& operator>>=( int i )
+	{
+		m_iHor >>= i;
+		m_iVer >>= i;
+		return *this;
+	}
+	const GvcMv operator+( const GvcMv& rcMv ) const { return GvcMv( m_iHor + rcMv.m_iHor, m_iVer + rcMv.m_iVer ); }
+	const GvcMv operator-( const GvcMv& rcMv ) const { return GvcMv( m_iHor - rcMv.m_iHor, m_iVer - rcMv.m_iVer ); }
+	bool operator==( const GvcMv& rcMv ) const { return m_iHor == rcMv.m_iHor && m_iVer == rcMv.m_iVer; }
+	bool operator!=( const GvcMv& rcMv ) const { return !( *this == rcMv ); }
+};
+
+#endif  // __GVCMV_H__
@@ -0,0 +1,224 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcNal.cpp
+ * \brief    NAL units and access units of the byte stream
+ */
+
+#include <cstring>
+
+#include "GvcNal.h"
+#include "GvcBitstream.h"
+
+/// true if any byte of the word is zero
+static inline bool hasZeroByte( unsigned long long ullWord )
+{
+	return ( ( ullWord - 0x0101010101010101ULL ) & ~ullWord & 0x8080808080808080ULL ) != 0;
+}
+
+void GvcAccessUnit::addNALUnit( NalUnitType eType, const GvcBitstream& rcBitstream )
+{
+	static const unsigned char s_aucStartCode[4] = { 0x00, 0x00, 0x00, 0x01 };
+	m_aucData.insert( m_aucData.end(), s_aucStartCode, s_aucStartCode + 4 );
+	m_aucData.push_back( (unsigned char)( ( eType & 0x3f ) << 1 ) );
+	xWriteEscaped( rcBitstream.getByteStream(), rcBitstream.getByteStreamLength() );
+}
+
+/** Copies the payload inserting 0x03 after two zero bytes followed by a byte up to 0x03. Only a
+ *  zero byte can start such a pattern, so the payload is scanned eight bytes at a time and words
+ *  without a zero byte are copied whole; the bytes are examined one by one from a zero byte on.
+ *  The payload ends with its RBSP trailing bits, a nonzero byte, so it never runs into the next
+ *  start code.
+ */
+void GvcAccessUnit::xWriteEscaped( const unsigned char* pucPayload, size_t uiSize )
+{
+	m_aucData.reserve( m_aucData.size() + uiSize + ( uiSize >> 6 ) + 1 );
+	size_t uiPos = 0;
+	unsigned int uiNumZeros = 0;
+	while( uiPos < uiSize )
+	{
+		if( uiNumZeros == 0 )
+		{
+			size_t uiEnd = uiPos;
+			unsigned long long ullWord;
+			while( uiEnd + 8 <= uiSize )
+			{
+				memcpy( &ullWord, pucPayload + uiEnd, 8 );
+				if( hasZeroByte( ullWord ) )
+				{
+					break;
+				}
+				uiEnd += 8;
+			}
+			m_aucData.insert( m_aucData.end(), pucPayload + uiPos, pucPayload + uiEnd );
+			uiPos = uiEnd;
+			if( uiPos == uiSize )
+			{
+				break;
+			}
+		}
+		const unsigned char ucByte = pucPayload[uiPos++];
+		if( uiNumZeros >= 2 && ucByte <= 0x03 )
+		{
+			m_aucData.push_back( 0x03 );
+			uiNumZeros = 0;
+		}
+		m_aucData.push_back( ucByte );
+		uiNumZeros = ucByte ? 0 : uiNumZeros + 1;
+	}
+}
+
+/** The NAL units are split at the start code prefixes, which emulation prevention keeps out of the payloads. The
+ *  zero byte in front of a prefix belongs to the NAL unit that follows.
+ */
+bool GvcBitstreamStitcher::addSegment( const unsigned char* pucData, size_t uiSize )
+{
+	std::vector<size_t> auiNALUnitStart;
+	for( size_t uiPos = 0; uiPos + 3 < uiSize; uiPos++ )
+	{
+		if( pucData[uiPos] == 0x00 && pucData[uiPos + 1] == 0x00 && pucData[uiPos + 2] == 0x01 )
+		{
+			auiNALUnitStart.push_back( uiPos > 0 && pucData[uiPos - 1] == 0x00 ? uiPos - 1 : uiPos );
+			uiPos += 2;
+		}
+	}
+	if( auiNALUnitStart.size() < 2 || auiNALUnitStart[0] != 0 )
+	{
+		return false;
+	}
+	auiNALUnitStart.push_back( uiSize );
+
+	// a sequence header, then an intra frame: the frame type is the first bit of the frame header
+	const size_t uiHeaderEnd = auiNALUnitStart[1];
+	const size_t uiFrame = auiNALUnitStart[1] + ( pucData[auiNALUnitStart[1]] == 0x00 ? 4 : 3 );
+	const unsigned char* pucHeader = pucData + ( pucData[0] == 0x00 && pucData[1] == 0x00 && pucData[2] == 0x00 ? 4 : 3 );
+	if( ( ( *pucHeader >> 1 ) & 0x3f ) != NAL_UNIT_SEQUENCE_HEADER || uiFrame + 1 >= uiSize ||
+		( ( pucData[uiFrame] >> 1 ) & 0x3f ) != NAL_UNIT_FRAME || ( pucData[uiFrame + 1] >> 7 ) != I_FRAME )
+	{
+		return false;
+	}
+	if( m_aucSequenceHeader.empty() )
+	{
+		m_aucSequenceHeader.assign( pucData, pucData + uiHeaderEnd );
+		m_aucData.insert( m_aucData.end(), pucData, pucData + uiSize );
+		return true;
+	}
+	if( uiHeaderEnd != m_aucSequenceHeader.size() || memcmp( pucData, &m_aucSequenceHeader[0], uiHeaderEnd ) != 0 )
+	{
+		return false;
+	}
+	m_aucData.insert( m_aucData.end(), pucData + uiHeaderEnd, pucData + uiSize );
+	return true;
+}
+
+/// bytes read from the stream at once
+static const size_t BYTE_STREAM_CHUNK_SIZE = 1 << 16;
+
+GvcByteStreamReader::GvcByteStreamReader()
+	: m_pcStream( NULL )
+	, m_uiPos( 0 )
+	, m_uiNumZeros( 0 )
+	, m_uiNumBytesRead( 0 )
+{
+}
+
+void GvcByteStreamReader::init( std::istream* pcStream )
+{
+	m_pcStream = pcStream;
+	m_aucBuffer.clear();
+	m_uiPos = 0;
+	m_uiNumZeros = 0;
+	m_uiNumBytesRead = 0;
+}
+
+/// true if a byte is left at m_uiPos, the bytes before it are dropped when the buffer is refilled
+bool GvcByteStreamReader::xMoreBytes()
+{
+	if( m_uiPos < m_aucBuffer.size() )
+	{
+		return true;
+	}
+	m_aucBuffer.resize( BYTE_STREAM_CHUNK_SIZE );
+	m_pcStream->read( reinterpret_cast<char*>( &m_aucBuffer[0] ), BYTE_STREAM_CHUNK_SIZE );
+	m_aucBuffer.resize( (size_t)m_pcStream->gcount() );
+	m_uiNumBytesRead += m_aucBuffer.size();
+	m_uiPos = 0;
+	return !m_aucBuffer.empty();
+}
+
+/** The payload ends where two zero bytes are followed by a byte up to 0x01, the start of the next start code (with
+ *  or without its leading zero byte), which is left for the next call. Inside a payload the escaping leaves only
+ *  0x03 after two zero bytes, which is dropped.
+ */
+bool GvcByteStreamReader::readNALUnit( NalUnitType& reType, std::vector<unsigned char>& raucPayload )
+{
+	raucPayload.clear();
+	// start code prefix, possibly begun by the end of the previous NAL unit
+	unsigned int uiNumZeros = m_uiNumZeros;
+	m_uiNumZeros = 0;
+	while( true )
+	{
+		if( !xMoreBytes() )
+		{
+			return false;
+		}
+		const unsigned char ucByte = m_aucBuffer[m_uiPos++];
+		if( ucByte == 0x01 && uiNumZeros >= 2 )
+		{
+			break;
+		}
+		uiNumZeros = ucByte ? 0 : uiNumZeros + 1;
+	}
+	if( !xMoreBytes() )
+	{
+		return false;
+	}
+	reType = NalUnitType( ( m_aucBuffer[m_uiPos++] >> 1 ) & 0x3f );
+
+	uiNumZeros = 0;
+	while( xMoreBytes() )
+	{
+		const unsigned char ucByte = m_aucBuffer[m_uiPos];
+		if( uiNumZeros >= 2 )
+		{
+			if( ucByte <= 0x01 )
+			{
+				raucPayload.resize( raucPayload.size() - 2 );
+				m_uiNumZeros = 2;
+				return true;
+			}
+			if( ucByte == 0x03 )
+			{
+				m_uiPos++;
+				uiNumZeros = 0;
+				continue;
+			}
+		}
+		raucPayload.push_back( ucByte );
+		m_uiPos++;
+		uiNumZeros = ucByte ? 0 : uiNumZeros + 1;
+	}
+	// trailing zero bytes at the end of the stream
+	while( !raucPayload.empty() && raucPayload.back() == 0x00 )
+	{
+		raucPayload.pop_back();
+	}
+	return true;
+}
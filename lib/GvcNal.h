@@ -0,0 +1,116 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcNal.h
+ * \brief    NAL units and access units of the byte stream
+ */
+
+#ifndef __GVCNAL_H__
+#define __GVCNAL_H__
+
+#include <istream>
+#include <vector>
+
+#include "TypeDef.h"
+
+class GvcBitstream;
+
+/// payload carried by a NAL unit
+enum NalUnitType
+{
+	NAL_UNIT_SEQUENCE_HEADER = 0,  ///< coding parameters, sent before the first frame
+	NAL_UNIT_FRAME = 1,            ///< frame header followed by the coded BUs
+	NUMBER_OF_NAL_UNIT_TYPES
+};
+
+/**
+ * \class    GvcAccessUnit
+ * \brief    NAL units of one frame in byte stream format
+ *
+ * Each NAL unit is a start code, a one byte header (forbidden zero bit, 6 bit type, reserved zero
+ * bit) and the payload with emulation prevention bytes inserted, so that no start code prefix
+ * occurs inside it.
+ */
+class GvcAccessUnit
+{
+	std::vector<unsigned char> m_aucData;
+
+	void xWriteEscaped( const unsigned char* pucPayload, size_t uiSize );
+
+  public:
+	/// appends the aligned payload of pcBitstream as a NAL unit of type eType
+	void addNALUnit( NalUnitType eType, const GvcBitstream& rcBitstream );
+	void clear() { m_aucData.clear(); }
+
+	const unsigned char* getData() const { return m_aucData.empty() ? NULL : &m_aucData[0]; }
+	unsigned int getSize() const { return (unsigned int)m_aucData.size(); }
+};
+
+/**
+ * \class    GvcBitstreamStitcher
+ * \brief    Joins the byte streams of segments coded apart into one stream
+ *
+ * A segment is a stream starting at an intra frame, its frames numbered where the segment sits in the sequence. The
+ * sequence header of the first segment is kept and the identical ones of the others are dropped, so that the
+ * stitched stream is the stream a single encoder would have written. The data of the segments is copied unchanged.
+ */
+class GvcBitstreamStitcher
+{
+	std::vector<unsigned char> m_aucSequenceHeader;  ///< NAL unit of the first segment, start code included
+	std::vector<unsigned char> m_aucData;
+
+  public:
+	/// appends a segment, false if it does not start with an intra frame or its sequence header differs
+	bool addSegment( const unsigned char* pucData, size_t uiSize );
+	/// drops the data appended so far, the next segments are still checked against the first one
+	void clear() { m_aucData.clear(); }
+
+	const unsigned char* getData() const { return m_aucData.empty() ? NULL : &m_aucData[0]; }
+	unsigned int getSize() const { return (unsigned int)m_aucData.size(); }
+};
+
+/**
+ * \class    GvcByteStreamReader
+ * \brief    Splits a byte stream into NAL units while it is read, a chunk at a time
+ *
+ * Only the bytes of the NAL unit being split and the chunk after it are held, whatever the length of the stream.
+ * The zero bytes in front of a start code prefix are dropped with it, and so are the emulation prevention bytes of
+ * the payloads.
+ */
+class GvcByteStreamReader
+{
+	std::istream* m_pcStream;
+	std::vector<unsigned char> m_aucBuffer;  ///< bytes read from the stream
+	size_t m_uiPos;                          ///< next byte of the buffer to look at
+	unsigned int m_uiNumZeros;               ///< zero bytes just before m_uiPos
+	unsigned long long m_uiNumBytesRead;
+
+	bool xMoreBytes();
+
+  public:
+	GvcByteStreamReader();
+
+	void init( std::istream* pcStream );
+	/// the next NAL unit: its type and its payload without emulation prevention bytes, false at the end of the stream
+	bool readNALUnit( NalUnitType& reType, std::vector<unsigned char>& raucPayload );
+	unsigned long long getNumBytesRead() const { return m_uiNumBytesRead; }
+};
+
+#endif  // __GVCNAL_H__
@@ -0,0 +1,329 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcPixel.cpp
+ * \brief    Reference C++ implementation of the pixel comparison kernels
+ */
+
+#include <cstdlib>
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+template <int W, int H>
+unsigned int sad_c( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	unsigned int uiSum = 0;
+	for( int y = 0; y < H; y++ )
+	{
+		for( int x = 0; x < W; x++ )
+		{
+			uiSum += abs( pOrg[x] - pCur[x] );
+		}
+		pOrg += iOrgStride;
+		pCur += iCurStride;
+	}
+	return uiSum;
+}
+
+template <int W, int H>
+void sad_x3_c( const short* pOrg, int iOrgStride, const short* pCur0, const short* pCur1, const short* pCur2, int iCurStride, unsigned int* puiSad )
+{
+	puiSad[0] = sad_c<W, H>( pOrg, iOrgStride, pCur0, iCurStride );
+	puiSad[1] = sad_c<W, H>( pOrg, iOrgStride, pCur1, iCurStride );
+	puiSad[2] = sad_c<W, H>( pOrg, iOrgStride, pCur2, iCurStride );
+}
+
+template <int W, int H>
+void sad_x4_c( const short* pOrg, int iOrgStride, const short* pCur0, const short* pCur1, const short* pCur2, const short* pCur3, int iCurStride, unsigned int* puiSad )
+{
+	puiSad[0] = sad_c<W, H>( pOrg, iOrgStride, pCur0, iCurStride );
+	puiSad[1] = sad_c<W, H>( pOrg, iOrgStride, pCur1, iCurStride );
+	puiSad[2] = sad_c<W, H>( pOrg, iOrgStride, pCur2, iCurStride );
+	puiSad[3] = sad_c<W, H>( pOrg, iOrgStride, pCur3, iCurStride );
+}
+
+unsigned int satd_4x4_c( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	int k, satd = 0, diff[16], m[16], d[16];
+	for( k = 0; k < 16; k += 4 )
+	{
+		diff[k + 0] = pOrg[0] - pCur[0];
+		diff[k + 1] = pOrg[1] - pCur[1];
+		diff[k + 2] = pOrg[2] - pCur[2];
+		diff[k + 3] = pOrg[3] - pCur[3];
+		pOrg += iOrgStride;
+		pCur += iCurStride;
+	}
+
+	m[0] = diff[0] + diff[12];
+	m[1] = diff[1] + diff[13];
+	m[2] = diff[2] + diff[14];
+	m[3] = diff[3] + diff[15];
+	m[4] = diff[4] + diff[8];
+	m[5] = diff[5] + diff[9];
+	m[6] = diff[6] + diff[10];
+	m[7] = diff[7] + diff[11];
+	m[8] = diff[4] - diff[8];
+	m[9] = diff[5] - diff[9];
+	m[10] = diff[6] - diff[10];
+	m[11] = diff[7] - diff[11];
+	m[12] = diff[0] - diff[12];
+	m[13] = diff[1] - diff[13];
+	m[14] = diff[2] - diff[14];
+	m[15] = diff[3] - diff[15];
+
+	d[0] = m[0] + m[4];
+	d[1] = m[1] + m[5];
+	d[2] = m[2] + m[6];
+	d[3] = m[3] + m[7];
+	d[4] = m[8] + m[12];
+	d[5] = m[9] + m[13];
+	d[6] = m[10] + m[14];
+	d[7] = m[11] + m[15];
+	d[8] = m[0] - m[4];
+	d[9] = m[1] - m[5];
+	d[10] = m[2] - m[6];
+	d[11] = m[3] - m[7];
+	d[12] = m[12] - m[8];
+	d[13] = m[13] - m[9];
+	d[14] = m[14] - m[10];
+	d[15] = m[15] - m[11];
+
+	m[0] = d[0] + d[3];
+	m[1] = d[1] + d[2];
+	m[2] = d[1] - d[2];
+	m[3] = d[0] - d[3];
+	m[4] = d[4] + d[7];
+	m[5] = d[5] + d[6];
+	m[6] = d[5] - d[6];
+	m[7] = d[4] - d[7];
+	m[8] = d[8] + d[11];
+	m[9] = d[9] + d[10];
+	m[10] = d[9] - d[10];
+	m[11] = d[8] - d[11];
+	m[12] = d[12] + d[15];
+	m[13] = d[13] + d[14];
+	m[14] = d[13] - d[14];
+	m[15] = d[12] - d[15];
+
+	d[0] = m[0] + m[1];
+	d[1] = m[0] - m[1];
+	d[2] = m[2] + m[3];
+	d[3] = m[3] - m[2];
+	d[4] = m[4] + m[5];
+	d[5] = m[4] - m[5];
+	d[6] = m[6] + m[7];
+	d[7] = m[7] - m[6];
+	d[8] = m[8] + m[9];
+	d[9] = m[8] - m[9];
+	d[10] = m[10] + m[11];
+	d[11] = m[11] - m[10];
+	d[12] = m[12] + m[13];
+	d[13] = m[12] - m[13];
+	d[14] = m[14] + m[15];
+	d[15] = m[15] - m[14];
+
+	for( k = 0; k < 16; ++k )
+	{
+		satd += abs( d[k] );
+	}
+	return ( satd + 1 ) >> 1;
+}
+
+unsigned int satd_8x8_c( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	int k, i, j, jj, sad = 0;
+	int diff[64], m1[8][8], m2[8][8], m3[8][8];
+
+	for( k = 0; k < 64; k += 8 )
+	{
+		for( i = 0; i < 8; i++ )
+		{
+			diff[k + i] = pOrg[i] - pCur[i];
+		}
+		pOrg += iOrgStride;
+		pCur += iCurStride;
+	}
+
+	// horizontal
+	for( j = 0; j < 8; j++ )
+	{
+		jj = j << 3;
+		m2[j][0] = diff[jj] + diff[jj + 4];
+		m2[j][1] = diff[jj + 1] + diff[jj + 5];
+		m2[j][2] = diff[jj + 2] + diff[jj + 6];
+		m2[j][3] = diff[jj + 3] + diff[jj + 7];
+		m2[j][4] = diff[jj] - diff[jj + 4];
+		m2[j][5] = diff[jj + 1] - diff[jj + 5];
+		m2[j][6] = diff[jj + 2] - diff[jj + 6];
+		m2[j][7] = diff[jj + 3] - diff[jj + 7];
+
+		m1[j][0] = m2[j][0] + m2[j][2];
+		m1[j][1] = m2[j][1] + m2[j][3];
+		m1[j][2] = m2[j][0] - m2[j][2];
+		m1[j][3] = m2[j][1] - m2[j][3];
+		m1[j][4] = m2[j][4] + m2[j][6];
+		m1[j][5] = m2[j][5] + m2[j][7];
+		m1[j][6] = m2[j][4] - m2[j][6];
+		m1[j][7] = m2[j][5] - m2[j][7];
+
+		m2[j][0] = m1[j][0] + m1[j][1];
+		m2[j][1] = m1[j][0] - m1[j][1];
+		m2[j][2] = m1[j][2] + m1[j][3];
+		m2[j][3] = m1[j][2] - m1[j][3];
+		m2[j][4] = m1[j][4] + m1[j][5];
+		m2[j][5] = m1[j][4] - m1[j][5];
+		m2[j][6] = m1[j][6] + m1[j][7];
+		m2[j][7] = m1[j][6] - m1[j][7];
+	}
+
+	// vertical
+	for( i = 0; i < 8; i++ )
+	{
+		m3[0][i] = m2[0][i] + m2[4][i];
+		m3[1][i] = m2[1][i] + m2[5][i];
+		m3[2][i] = m2[2][i] + m2[6][i];
+		m3[3][i] = m2[3][i] + m2[7][i];
+		m3[4][i] = m2[0][i] - m2[4][i];
+		m3[5][i] = m2[1][i] - m2[5][i];
+		m3[6][i] = m2[2][i] - m2[6][i];
+		m3[7][i] = m2[3][i] - m2[7][i];
+
+		m1[0][i] = m3[0][i] + m3[2][i];
+		m1[1][i] = m3[1][i] + m3[3][i];
+		m1[2][i] = m3[0][i] - m3[2][i];
+		m1[3][i] = m3[1][i] - m3[3][i];
+		m1[4][i] = m3[4][i] + m3[6][i];
+		m1[5][i] = m3[5][i] + m3[7][i];
+		m1[6][i] = m3[4][i] - m3[6][i];
+		m1[7][i] = m3[5][i] - m3[7][i];
+
+		m2[0][i] = m1[0][i] + m1[1][i];
+		m2[1][i] = m1[0][i] - m1[1][i];
+		m2[2][i] = m1[2][i] + m1[3][i];
+		m2[3][i] = m1[2][i] - m1[3][i];
+		m2[4][i] = m1[4][i] + m1[5][i];
+		m2[5][i] = m1[4][i] - m1[5][i];
+		m2[6][i] = m1[6][i] + m1[7][i];
+		m2[7][i] = m1[6][i] - m1[7][i];
+	}
+
+	for( i = 0; i < 8; i++ )
+	{
+		for( j = 0; j < 8; j++ )
+		{
+			sad += abs( m2[i][j] );
+		}
+	}
+	return ( sad + 2 ) >> 2;
+}
+
+unsigned int satd_16x16_c( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	unsigned int uiSum = 0;
+	for( int y = 0; y < 16; y += 8 )
+	{
+		for( int x = 0; x < 16; x += 8 )
+		{
+			uiSum += satd_8x8_c( pOrg + y * iOrgStride + x, iOrgStride, pCur + y * iCurStride + x, iCurStride );
+		}
+	}
+	return uiSum;
+}
+
+template <int W, int H>
+unsigned long long sse_c( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	unsigned long long uiSum = 0;
+	for( int y = 0; y < H; y++ )
+	{
+		for( int x = 0; x < W; x++ )
+		{
+			const int iDiff = pOrg[x] - pCur[x];
+			uiSum += iDiff * iDiff;
+		}
+		pOrg += iOrgStride;
+		pCur += iCurStride;
+	}
+	return uiSum;
+}
+
+unsigned long long sse_plane_c( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride, int iWidth, int iHeight )
+{
+	unsigned long long uiSum = 0;
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth; x++ )
+		{
+			const int iDiff = pOrg[x] - pCur[x];
+			uiSum += iDiff * iDiff;
+		}
+		pOrg += iOrgStride;
+		pCur += iCurStride;
+	}
+	return uiSum;
+}
+
+void ssim_sums_4x4_c( const short* pOrg, int iOrgStride, const short* pRec, int iRecStride, int iNumBlocks, int ( *paiSums )[4] )
+{
+	for( int n = 0; n < iNumBlocks; n++, pOrg += 4, pRec += 4 )
+	{
+		int s1 = 0, s2 = 0, ss = 0, s12 = 0;
+		for( int y = 0; y < 4; y++ )
+		{
+			for( int x = 0; x < 4; x++ )
+			{
+				const int a = pOrg[y * iOrgStride + x];
+				const int b = pRec[y * iRecStride + x];
+				s1 += a;
+				s2 += b;
+				ss += a * a + b * b;
+				s12 += a * b;
+			}
+		}
+		paiSums[n][0] = s1;
+		paiSums[n][1] = s2;
+		paiSums[n][2] = ss;
+		paiSums[n][3] = s12;
+	}
+}
+}  // namespace
+
+void setupPixelPrimitivesC( GvcPrimitives& p )
+{
+#define SETUP_SAD( W, H )                         \
+	p.sad[BLOCK_##W##x##H] = sad_c<W, H>;       \
+	p.sadX3[BLOCK_##W##x##H] = sad_x3_c<W, H>; \
+	p.sadX4[BLOCK_##W##x##H] = sad_x4_c<W, H>;
+	GVC_FOR_EACH_BLOCK_SIZE( SETUP_SAD )
+#undef SETUP_SAD
+
+	p.satd[SATD_4x4] = p.satdHbd[SATD_4x4] = satd_4x4_c;
+	p.satd[SATD_8x8] = p.satdHbd[SATD_8x8] = satd_8x8_c;
+	p.satd[SATD_16x16] = p.satdHbd[SATD_16x16] = satd_16x16_c;
+
+#define SETUP_SSE( W, H ) p.sse[BLOCK_##W##x##H] = sse_c<W, H>;
+	GVC_FOR_EACH_BLOCK_SIZE( SETUP_SSE )
+#undef SETUP_SSE
+	p.ssePlane = sse_plane_c;
+	p.ssimSums4x4 = ssim_sums_4x4_c;
+}
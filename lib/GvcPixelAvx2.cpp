@@ -0,0 +1,368 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcPixelAvx2.cpp
+ * \brief    AVX2 implementation of the pixel comparison kernels
+ */
+
+#include <immintrin.h>
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+inline unsigned int horizontalSum( __m256i vSum256, __m128i vSum128 )
+{
+	__m128i vSum = _mm_add_epi32( vSum128, _mm_add_epi32( _mm256_castsi256_si128( vSum256 ), _mm256_extracti128_si256( vSum256, 1 ) ) );
+	vSum = _mm_add_epi32( vSum, _mm_shuffle_epi32( vSum, 0x4E ) );
+	vSum = _mm_add_epi32( vSum, _mm_shuffle_epi32( vSum, 0xB1 ) );
+	return (unsigned int)_mm_cvtsi128_si32( vSum );
+}
+
+/// SAD of one source block against N candidates: 16 samples per ymm, the 8 and 4 sample tails in xmm
+template <int W, int H, int N>
+inline void sadN( const short* pOrg, int iOrgStride, const short* const* ppCur, int iCurStride, unsigned int* puiSad )
+{
+	const __m256i vOnes256 = _mm256_set1_epi16( 1 );
+	const __m128i vOnes128 = _mm_set1_epi16( 1 );
+	const int iTail = W & ~15;
+	__m256i avSum256[N];
+	__m128i avSum128[N];
+	for( int n = 0; n < N; n++ )
+	{
+		avSum256[n] = _mm256_setzero_si256();
+		avSum128[n] = _mm_setzero_si128();
+	}
+	for( int y = 0; y < H; y++ )
+	{
+		const int iCurOffset = y * iCurStride;
+		for( int x = 0; x + 16 <= W; x += 16 )
+		{
+			const __m256i vOrg = _mm256_loadu_si256( (const __m256i*)( pOrg + x ) );
+			for( int n = 0; n < N; n++ )
+			{
+				const __m256i vCur = _mm256_loadu_si256( (const __m256i*)( ppCur[n] + iCurOffset + x ) );
+				const __m256i vAbs = _mm256_abs_epi16( _mm256_sub_epi16( vOrg, vCur ) );
+				avSum256[n] = _mm256_add_epi32( avSum256[n], _mm256_madd_epi16( vAbs, vOnes256 ) );
+			}
+		}
+		if( W & 8 )
+		{
+			const __m128i vOrg = _mm_loadu_si128( (const __m128i*)( pOrg + iTail ) );
+			for( int n = 0; n < N; n++ )
+			{
+				const __m128i vCur = _mm_loadu_si128( (const __m128i*)( ppCur[n] + iCurOffset + iTail ) );
+				const __m128i vAbs = _mm_abs_epi16( _mm_sub_epi16( vOrg, vCur ) );
+				avSum128[n] = _mm_add_epi32( avSum128[n], _mm_madd_epi16( vAbs, vOnes128 ) );
+			}
+		}
+		if( W & 4 )
+		{
+			const __m128i vOrg = _mm_loadl_epi64( (const __m128i*)( pOrg + W - 4 ) );
+			for( int n = 0; n < N; n++ )
+			{
+				const __m128i vCur = _mm_loadl_epi64( (const __m128i*)( ppCur[n] + iCurOffset + W - 4 ) );
+				const __m128i vAbs = _mm_abs_epi16( _mm_sub_epi16( vOrg, vCur ) );
+				avSum128[n] = _mm_add_epi32( avSum128[n], _mm_madd_epi16( vAbs, vOnes128 ) );
+			}
+		}
+		pOrg += iOrgStride;
+	}
+	for( int n = 0; n < N; n++ )
+	{
+		puiSad[n] = horizontalSum( avSum256[n], avSum128[n] );
+	}
+}
+
+template <int W, int H>
+unsigned int sad_avx2( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	unsigned int uiSad;
+	sadN<W, H, 1>( pOrg, iOrgStride, &pCur, iCurStride, &uiSad );
+	return uiSad;
+}
+
+template <int W, int H>
+void sad_x3_avx2( const short* pOrg, int iOrgStride, const short* pCur0, const short* pCur1, const short* pCur2, int iCurStride, unsigned int* puiSad )
+{
+	const short* apCur[3] = {pCur0, pCur1, pCur2};
+	sadN<W, H, 3>( pOrg, iOrgStride, apCur, iCurStride, puiSad );
+}
+
+template <int W, int H>
+void sad_x4_avx2( const short* pOrg, int iOrgStride, const short* pCur0, const short* pCur1, const short* pCur2, const short* pCur3, int iCurStride, unsigned int* puiSad )
+{
+	const short* apCur[4] = {pCur0, pCur1, pCur2, pCur3};
+	sadN<W, H, 4>( pOrg, iOrgStride, apCur, iCurStride, puiSad );
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Hadamard SATD
+// --------------------------------------------------------------------------------------------------------------------
+
+inline void butterfly16( __m256i& a, __m256i& b )
+{
+	const __m256i t = a;
+	a = _mm256_add_epi16( t, b );
+	b = _mm256_sub_epi16( t, b );
+}
+
+inline void butterfly32( __m256i& a, __m256i& b )
+{
+	const __m256i t = a;
+	a = _mm256_add_epi32( t, b );
+	b = _mm256_sub_epi32( t, b );
+}
+
+template <void ( *BUTTERFLY )( __m256i&, __m256i& )>
+inline void hadamard8( __m256i* r )
+{
+	BUTTERFLY( r[0], r[1] );
+	BUTTERFLY( r[2], r[3] );
+	BUTTERFLY( r[4], r[5] );
+	BUTTERFLY( r[6], r[7] );
+	BUTTERFLY( r[0], r[2] );
+	BUTTERFLY( r[1], r[3] );
+	BUTTERFLY( r[4], r[6] );
+	BUTTERFLY( r[5], r[7] );
+	BUTTERFLY( r[0], r[4] );
+	BUTTERFLY( r[1], r[5] );
+	BUTTERFLY( r[2], r[6] );
+	BUTTERFLY( r[3], r[7] );
+}
+
+/// transposes the two 8x8 blocks of 16-bit values held in the low and high 128-bit lanes
+inline void transpose8x8x2( __m256i* r )
+{
+	const __m256i t0 = _mm256_unpacklo_epi16( r[0], r[1] );
+	const __m256i t1 = _mm256_unpackhi_epi16( r[0], r[1] );
+	const __m256i t2 = _mm256_unpacklo_epi16( r[2], r[3] );
+	const __m256i t3 = _mm256_unpackhi_epi16( r[2], r[3] );
+	const __m256i t4 = _mm256_unpacklo_epi16( r[4], r[5] );
+	const __m256i t5 = _mm256_unpackhi_epi16( r[4], r[5] );
+	const __m256i t6 = _mm256_unpacklo_epi16( r[6], r[7] );
+	const __m256i t7 = _mm256_unpackhi_epi16( r[6], r[7] );
+	const __m256i u0 = _mm256_unpacklo_epi32( t0, t2 );
+	const __m256i u1 = _mm256_unpackhi_epi32( t0, t2 );
+	const __m256i u2 = _mm256_unpacklo_epi32( t1, t3 );
+	const __m256i u3 = _mm256_unpackhi_epi32( t1, t3 );
+	const __m256i u4 = _mm256_unpacklo_epi32( t4, t6 );
+	const __m256i u5 = _mm256_unpackhi_epi32( t4, t6 );
+	const __m256i u6 = _mm256_unpacklo_epi32( t5, t7 );
+	const __m256i u7 = _mm256_unpackhi_epi32( t5, t7 );
+	r[0] = _mm256_unpacklo_epi64( u0, u4 );
+	r[1] = _mm256_unpackhi_epi64( u0, u4 );
+	r[2] = _mm256_unpacklo_epi64( u1, u5 );
+	r[3] = _mm256_unpackhi_epi64( u1, u5 );
+	r[4] = _mm256_unpacklo_epi64( u2, u6 );
+	r[5] = _mm256_unpackhi_epi64( u2, u6 );
+	r[6] = _mm256_unpacklo_epi64( u3, u7 );
+	r[7] = _mm256_unpackhi_epi64( u3, u7 );
+}
+
+/// transposes an 8x8 block of 32-bit values, one row per register
+inline void transpose8x8x32( __m256i* r )
+{
+	const __m256i t0 = _mm256_unpacklo_epi32( r[0], r[1] );
+	const __m256i t1 = _mm256_unpackhi_epi32( r[0], r[1] );
+	const __m256i t2 = _mm256_unpacklo_epi32( r[2], r[3] );
+	const __m256i t3 = _mm256_unpackhi_epi32( r[2], r[3] );
+	const __m256i t4 = _mm256_unpacklo_epi32( r[4], r[5] );
+	const __m256i t5 = _mm256_unpackhi_epi32( r[4], r[5] );
+	const __m256i t6 = _mm256_unpacklo_epi32( r[6], r[7] );
+	const __m256i t7 = _mm256_unpackhi_epi32( r[6], r[7] );
+	const __m256i u0 = _mm256_unpacklo_epi64( t0, t2 );
+	const __m256i u1 = _mm256_unpackhi_epi64( t0, t2 );
+	const __m256i u2 = _mm256_unpacklo_epi64( t1, t3 );
+	const __m256i u3 = _mm256_unpackhi_epi64( t1, t3 );
+	const __m256i u4 = _mm256_unpacklo_epi64( t4, t6 );
+	const __m256i u5 = _mm256_unpackhi_epi64( t4, t6 );
+	const __m256i u6 = _mm256_unpacklo_epi64( t5, t7 );
+	const __m256i u7 = _mm256_unpackhi_epi64( t5, t7 );
+	r[0] = _mm256_permute2x128_si256( u0, u4, 0x20 );
+	r[1] = _mm256_permute2x128_si256( u1, u5, 0x20 );
+	r[2] = _mm256_permute2x128_si256( u2, u6, 0x20 );
+	r[3] = _mm256_permute2x128_si256( u3, u7, 0x20 );
+	r[4] = _mm256_permute2x128_si256( u0, u4, 0x31 );
+	r[5] = _mm256_permute2x128_si256( u1, u5, 0x31 );
+	r[6] = _mm256_permute2x128_si256( u2, u6, 0x31 );
+	r[7] = _mm256_permute2x128_si256( u3, u7, 0x31 );
+}
+
+inline unsigned int laneSum( __m128i vSum )
+{
+	vSum = _mm_add_epi32( vSum, _mm_shuffle_epi32( vSum, 0x4E ) );
+	vSum = _mm_add_epi32( vSum, _mm_shuffle_epi32( vSum, 0xB1 ) );
+	return (unsigned int)_mm_cvtsi128_si32( vSum );
+}
+
+/// 8-bit samples: each ymm row holds two horizontally adjacent 8x8 blocks, one per 128-bit lane
+unsigned int satd_16x16_avx2( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	const __m256i vOnes = _mm256_set1_epi16( 1 );
+	unsigned int uiSum = 0;
+	for( int iHalf = 0; iHalf < 2; iHalf++ )
+	{
+		__m256i r[8];
+		for( int i = 0; i < 8; i++ )
+		{
+			const __m256i vOrg = _mm256_loadu_si256( (const __m256i*)( pOrg + i * iOrgStride ) );
+			const __m256i vCur = _mm256_loadu_si256( (const __m256i*)( pCur + i * iCurStride ) );
+			r[i] = _mm256_sub_epi16( vOrg, vCur );
+		}
+		hadamard8<butterfly16>( r );
+		transpose8x8x2( r );
+		hadamard8<butterfly16>( r );
+
+		__m256i vSum = _mm256_setzero_si256();
+		for( int i = 0; i < 8; i++ )
+		{
+			vSum = _mm256_add_epi32( vSum, _mm256_madd_epi16( _mm256_abs_epi16( r[i] ), vOnes ) );
+		}
+		uiSum += ( laneSum( _mm256_castsi256_si128( vSum ) ) + 2 ) >> 2;
+		uiSum += ( laneSum( _mm256_extracti128_si256( vSum, 1 ) ) + 2 ) >> 2;
+		pOrg += 8 * iOrgStride;
+		pCur += 8 * iCurStride;
+	}
+	return uiSum;
+}
+
+/// high bit depth: one 8x8 block, differences widened to 32 bits (8 lanes per row)
+unsigned int satd_8x8_hbd_avx2( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	__m256i r[8];
+	for( int i = 0; i < 8; i++ )
+	{
+		const __m256i vOrg = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i*)( pOrg + i * iOrgStride ) ) );
+		const __m256i vCur = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i*)( pCur + i * iCurStride ) ) );
+		r[i] = _mm256_sub_epi32( vOrg, vCur );
+	}
+	hadamard8<butterfly32>( r );
+	transpose8x8x32( r );
+	hadamard8<butterfly32>( r );
+
+	__m256i vSum = _mm256_setzero_si256();
+	for( int i = 0; i < 8; i++ )
+	{
+		vSum = _mm256_add_epi32( vSum, _mm256_abs_epi32( r[i] ) );
+	}
+	return ( laneSum( _mm_add_epi32( _mm256_castsi256_si128( vSum ), _mm256_extracti128_si256( vSum, 1 ) ) ) + 2 ) >> 2;
+}
+
+unsigned int satd_16x16_hbd_avx2( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	return satd_8x8_hbd_avx2( pOrg, iOrgStride, pCur, iCurStride ) + satd_8x8_hbd_avx2( pOrg + 8, iOrgStride, pCur + 8, iCurStride ) +
+		   satd_8x8_hbd_avx2( pOrg + 8 * iOrgStride, iOrgStride, pCur + 8 * iCurStride, iCurStride ) +
+		   satd_8x8_hbd_avx2( pOrg + 8 * iOrgStride + 8, iOrgStride, pCur + 8 * iCurStride + 8, iCurStride );
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Squared error
+// --------------------------------------------------------------------------------------------------------------------
+
+/// squared differences of one row in 32-bit lanes, iWidth must be a multiple of 8
+inline __m256i sseRow( const short* pOrg, const short* pCur, int iWidth )
+{
+	__m256i vRow = _mm256_setzero_si256();
+	int x = 0;
+	for( ; x + 16 <= iWidth; x += 16 )
+	{
+		const __m256i vDiff = _mm256_sub_epi16( _mm256_loadu_si256( (const __m256i*)( pOrg + x ) ), _mm256_loadu_si256( (const __m256i*)( pCur + x ) ) );
+		vRow = _mm256_add_epi32( vRow, _mm256_madd_epi16( vDiff, vDiff ) );
+	}
+	if( x + 8 <= iWidth )
+	{
+		const __m256i vDiff = _mm256_cvtepu16_epi32( _mm_sub_epi16( _mm_loadu_si128( (const __m128i*)( pOrg + x ) ), _mm_loadu_si128( (const __m128i*)( pCur + x ) ) ) );
+		vRow = _mm256_add_epi32( vRow, _mm256_madd_epi16( vDiff, vDiff ) );
+	}
+	return vRow;
+}
+
+inline __m256i widenAdd( __m256i vAcc64, __m256i vRow32 )
+{
+	vAcc64 = _mm256_add_epi64( vAcc64, _mm256_cvtepu32_epi64( _mm256_castsi256_si128( vRow32 ) ) );
+	return _mm256_add_epi64( vAcc64, _mm256_cvtepu32_epi64( _mm256_extracti128_si256( vRow32, 1 ) ) );
+}
+
+inline unsigned long long horizontalSum64( __m256i vSum )
+{
+	const __m128i v = _mm_add_epi64( _mm256_castsi256_si128( vSum ), _mm256_extracti128_si256( vSum, 1 ) );
+	return (unsigned long long)_mm_cvtsi128_si64( v ) + (unsigned long long)_mm_extract_epi64( v, 1 );
+}
+
+template <int W, int H>
+unsigned long long sse_avx2( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	__m256i vSum = _mm256_setzero_si256();
+	for( int y = 0; y < H; y++ )
+	{
+		vSum = widenAdd( vSum, sseRow( pOrg, pCur, W ) );
+		pOrg += iOrgStride;
+		pCur += iCurStride;
+	}
+	return horizontalSum64( vSum );
+}
+
+unsigned long long sse_plane_avx2( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride, int iWidth, int iHeight )
+{
+	const int iSimdWidth = iWidth & ~7;
+	unsigned long long uiTail = 0;
+	__m256i vSum = _mm256_setzero_si256();
+	for( int y = 0; y < iHeight; y++ )
+	{
+		vSum = widenAdd( vSum, sseRow( pOrg, pCur, iSimdWidth ) );
+		for( int x = iSimdWidth; x < iWidth; x++ )
+		{
+			const int iDiff = pOrg[x] - pCur[x];
+			uiTail += iDiff * iDiff;
+		}
+		pOrg += iOrgStride;
+		pCur += iCurStride;
+	}
+	return horizontalSum64( vSum ) + uiTail;
+}
+}  // namespace
+
+void setupPixelPrimitivesAvx2( GvcPrimitives& p )
+{
+	// blocks narrower than 16 samples do not fill a ymm register, the SSE4.1 kernels are kept for them
+#define SETUP_SAD( W, H )                                 \
+	if( W >= 16 )                                         \
+	{                                                     \
+		p.sad[BLOCK_##W##x##H] = sad_avx2<W, H>;       \
+		p.sadX3[BLOCK_##W##x##H] = sad_x3_avx2<W, H>; \
+		p.sadX4[BLOCK_##W##x##H] = sad_x4_avx2<W, H>; \
+	}
+	GVC_FOR_EACH_BLOCK_SIZE( SETUP_SAD )
+#undef SETUP_SAD
+
+	p.satd[SATD_16x16] = satd_16x16_avx2;
+	p.satdHbd[SATD_8x8] = satd_8x8_hbd_avx2;
+	p.satdHbd[SATD_16x16] = satd_16x16_hbd_avx2;
+
+#define SETUP_SSE( W, H )                         \
+	if( W >= 16 )                                 \
+	{                                             \
+		p.sse[BLOCK_##W##x##H] = sse_avx2<W, H>; \
+	}
+	GVC_FOR_EACH_BLOCK_SIZE( SETUP_SSE )
+#undef SETUP_SSE
+	p.ssePlane = sse_plane_avx2;
+}
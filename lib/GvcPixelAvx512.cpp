@@ -0,0 +1,119 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcPixelAvx512.cpp
+ * \brief    AVX-512 implementation of the pixel comparison kernels
+ */
+
+// GCC 12 flags the self initialized placeholders of its own AVX-512 headers (_mm256_undefined_si256)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+/// SAD of one source block against N candidates: 32 samples per zmm and a 16 sample ymm tail (48 wide blocks)
+template <int W, int H, int N>
+inline void sadN( const short* pOrg, int iOrgStride, const short* const* ppCur, int iCurStride, unsigned int* puiSad )
+{
+	const __m512i vOnes512 = _mm512_set1_epi16( 1 );
+	const __m256i vOnes256 = _mm256_set1_epi16( 1 );
+	const int iTail = W & ~31;
+	__m512i avSum512[N];
+	__m256i avSum256[N];
+	for( int n = 0; n < N; n++ )
+	{
+		avSum512[n] = _mm512_setzero_si512();
+		avSum256[n] = _mm256_setzero_si256();
+	}
+	for( int y = 0; y < H; y++ )
+	{
+		const int iCurOffset = y * iCurStride;
+		for( int x = 0; x + 32 <= W; x += 32 )
+		{
+			const __m512i vOrg = _mm512_loadu_si512( (const void*)( pOrg + x ) );
+			for( int n = 0; n < N; n++ )
+			{
+				const __m512i vCur = _mm512_loadu_si512( (const void*)( ppCur[n] + iCurOffset + x ) );
+				const __m512i vAbs = _mm512_abs_epi16( _mm512_sub_epi16( vOrg, vCur ) );
+				avSum512[n] = _mm512_add_epi32( avSum512[n], _mm512_madd_epi16( vAbs, vOnes512 ) );
+			}
+		}
+		if( W & 16 )
+		{
+			const __m256i vOrg = _mm256_loadu_si256( (const __m256i*)( pOrg + iTail ) );
+			for( int n = 0; n < N; n++ )
+			{
+				const __m256i vCur = _mm256_loadu_si256( (const __m256i*)( ppCur[n] + iCurOffset + iTail ) );
+				const __m256i vAbs = _mm256_abs_epi16( _mm256_sub_epi16( vOrg, vCur ) );
+				avSum256[n] = _mm256_add_epi32( avSum256[n], _mm256_madd_epi16( vAbs, vOnes256 ) );
+			}
+		}
+		pOrg += iOrgStride;
+	}
+	for( int n = 0; n < N; n++ )
+	{
+		__m256i vSum = _mm256_add_epi32( avSum256[n], _mm256_add_epi32( _mm512_castsi512_si256( avSum512[n] ), _mm512_extracti64x4_epi64( avSum512[n], 1 ) ) );
+		__m128i vSum128 = _mm_add_epi32( _mm256_castsi256_si128( vSum ), _mm256_extracti128_si256( vSum, 1 ) );
+		vSum128 = _mm_add_epi32( vSum128, _mm_shuffle_epi32( vSum128, 0x4E ) );
+		vSum128 = _mm_add_epi32( vSum128, _mm_shuffle_epi32( vSum128, 0xB1 ) );
+		puiSad[n] = (unsigned int)_mm_cvtsi128_si32( vSum128 );
+	}
+}
+
+template <int W, int H>
+unsigned int sad_avx512( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	unsigned int uiSad;
+	sadN<W, H, 1>( pOrg, iOrgStride, &pCur, iCurStride, &uiSad );
+	return uiSad;
+}
+
+template <int W, int H>
+void sad_x3_avx512( const short* pOrg, int iOrgStride, const short* pCur0, const short* pCur1, const short* pCur2, int iCurStride, unsigned int* puiSad )
+{
+	const short* apCur[3] = {pCur0, pCur1, pCur2};
+	sadN<W, H, 3>( pOrg, iOrgStride, apCur, iCurStride, puiSad );
+}
+
+template <int W, int H>
+void sad_x4_avx512( const short* pOrg, int iOrgStride, const short* pCur0, const short* pCur1, const short* pCur2, const short* pCur3, int iCurStride, unsigned int* puiSad )
+{
+	const short* apCur[4] = {pCur0, pCur1, pCur2, pCur3};
+	sadN<W, H, 4>( pOrg, iOrgStride, apCur, iCurStride, puiSad );
+}
+}  // namespace
+
+void setupPixelPrimitivesAvx512( GvcPrimitives& p )
+{
+	// only blocks at least one zmm wide, narrower ones keep the AVX2/SSE4.1 kernels
+#define SETUP_SAD( W, H )                                   \
+	if( W >= 32 && ( W & 15 ) == 0 )                        \
+	{                                                       \
+		p.sad[BLOCK_##W##x##H] = sad_avx512<W, H>;       \
+		p.sadX3[BLOCK_##W##x##H] = sad_x3_avx512<W, H>; \
+		p.sadX4[BLOCK_##W##x##H] = sad_x4_avx512<W, H>; \
+	}
+	GVC_FOR_EACH_BLOCK_SIZE( SETUP_SAD )
+#undef SETUP_SAD
+}
@@ -0,0 +1,384 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcPixelSse41.cpp
+ * \brief    SSE4.1 implementation of the pixel comparison kernels
+ */
+
+#include <smmintrin.h>
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+inline unsigned int horizontalSum( __m128i sum )
+{
+	sum = _mm_add_epi32( sum, _mm_shuffle_epi32( sum, 0x4E ) );
+	sum = _mm_add_epi32( sum, _mm_shuffle_epi32( sum, 0xB1 ) );
+	return (unsigned int)_mm_cvtsi128_si32( sum );
+}
+
+inline __m128i absDiff( __m128i a, __m128i b )
+{
+	return _mm_abs_epi16( _mm_sub_epi16( a, b ) );
+}
+
+/// SAD of one source block against N candidates, the source row is loaded once for all of them
+template <int W, int H, int N>
+inline void sadN( const short* pOrg, int iOrgStride, const short* const* ppCur, int iCurStride, unsigned int* puiSad )
+{
+	const __m128i vOnes = _mm_set1_epi16( 1 );
+	__m128i avSum[N];
+	for( int n = 0; n < N; n++ )
+	{
+		avSum[n] = _mm_setzero_si128();
+	}
+	for( int y = 0; y < H; y++ )
+	{
+		const int iCurOffset = y * iCurStride;
+		for( int x = 0; x + 8 <= W; x += 8 )
+		{
+			const __m128i vOrg = _mm_loadu_si128( (const __m128i*)( pOrg + x ) );
+			for( int n = 0; n < N; n++ )
+			{
+				const __m128i vCur = _mm_loadu_si128( (const __m128i*)( ppCur[n] + iCurOffset + x ) );
+				avSum[n] = _mm_add_epi32( avSum[n], _mm_madd_epi16( absDiff( vOrg, vCur ), vOnes ) );
+			}
+		}
+		if( W & 4 )
+		{
+			const __m128i vOrg = _mm_loadl_epi64( (const __m128i*)( pOrg + W - 4 ) );
+			for( int n = 0; n < N; n++ )
+			{
+				const __m128i vCur = _mm_loadl_epi64( (const __m128i*)( ppCur[n] + iCurOffset + W - 4 ) );
+				avSum[n] = _mm_add_epi32( avSum[n], _mm_madd_epi16( absDiff( vOrg, vCur ), vOnes ) );
+			}
+		}
+		pOrg += iOrgStride;
+	}
+	for( int n = 0; n < N; n++ )
+	{
+		puiSad[n] = horizontalSum( avSum[n] );
+	}
+}
+
+template <int W, int H>
+unsigned int sad_sse41( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	unsigned int uiSad;
+	sadN<W, H, 1>( pOrg, iOrgStride, &pCur, iCurStride, &uiSad );
+	return uiSad;
+}
+
+template <int W, int H>
+void sad_x3_sse41( const short* pOrg, int iOrgStride, const short* pCur0, const short* pCur1, const short* pCur2, int iCurStride, unsigned int* puiSad )
+{
+	const short* apCur[3] = {pCur0, pCur1, pCur2};
+	sadN<W, H, 3>( pOrg, iOrgStride, apCur, iCurStride, puiSad );
+}
+
+template <int W, int H>
+void sad_x4_sse41( const short* pOrg, int iOrgStride, const short* pCur0, const short* pCur1, const short* pCur2, const short* pCur3, int iCurStride, unsigned int* puiSad )
+{
+	const short* apCur[4] = {pCur0, pCur1, pCur2, pCur3};
+	sadN<W, H, 4>( pOrg, iOrgStride, apCur, iCurStride, puiSad );
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Hadamard SATD
+// --------------------------------------------------------------------------------------------------------------------
+
+inline void butterfly16( __m128i& a, __m128i& b )
+{
+	const __m128i t = a;
+	a = _mm_add_epi16( t, b );
+	b = _mm_sub_epi16( t, b );
+}
+
+inline void butterfly32( __m128i& a, __m128i& b )
+{
+	const __m128i t = a;
+	a = _mm_add_epi32( t, b );
+	b = _mm_sub_epi32( t, b );
+}
+
+/// 8-point Hadamard across eight registers (one row per register)
+inline void hadamard8( __m128i* r )
+{
+	butterfly16( r[0], r[1] );
+	butterfly16( r[2], r[3] );
+	butterfly16( r[4], r[5] );
+	butterfly16( r[6], r[7] );
+	butterfly16( r[0], r[2] );
+	butterfly16( r[1], r[3] );
+	butterfly16( r[4], r[6] );
+	butterfly16( r[5], r[7] );
+	butterfly16( r[0], r[4] );
+	butterfly16( r[1], r[5] );
+	butterfly16( r[2], r[6] );
+	butterfly16( r[3], r[7] );
+}
+
+inline void transpose8x8( __m128i* r )
+{
+	const __m128i t0 = _mm_unpacklo_epi16( r[0], r[1] );
+	const __m128i t1 = _mm_unpackhi_epi16( r[0], r[1] );
+	const __m128i t2 = _mm_unpacklo_epi16( r[2], r[3] );
+	const __m128i t3 = _mm_unpackhi_epi16( r[2], r[3] );
+	const __m128i t4 = _mm_unpacklo_epi16( r[4], r[5] );
+	const __m128i t5 = _mm_unpackhi_epi16( r[4], r[5] );
+	const __m128i t6 = _mm_unpacklo_epi16( r[6], r[7] );
+	const __m128i t7 = _mm_unpackhi_epi16( r[6], r[7] );
+	const __m128i u0 = _mm_unpacklo_epi32( t0, t2 );
+	const __m128i u1 = _mm_unpackhi_epi32( t0, t2 );
+	const __m128i u2 = _mm_unpacklo_epi32( t1, t3 );
+	const __m128i u3 = _mm_unpackhi_epi32( t1, t3 );
+	const __m128i u4 = _mm_unpacklo_epi32( t4, t6 );
+	const __m128i u5 = _mm_unpackhi_epi32( t4, t6 );
+	const __m128i u6 = _mm_unpacklo_epi32( t5, t7 );
+	const __m128i u7 = _mm_unpackhi_epi32( t5, t7 );
+	r[0] = _mm_unpacklo_epi64( u0, u4 );
+	r[1] = _mm_unpackhi_epi64( u0, u4 );
+	r[2] = _mm_unpacklo_epi64( u1, u5 );
+	r[3] = _mm_unpackhi_epi64( u1, u5 );
+	r[4] = _mm_unpacklo_epi64( u2, u6 );
+	r[5] = _mm_unpackhi_epi64( u2, u6 );
+	r[6] = _mm_unpacklo_epi64( u3, u7 );
+	r[7] = _mm_unpackhi_epi64( u3, u7 );
+}
+
+/// 8-bit samples: the 16 transformed differences stay below 4080 in magnitude
+unsigned int satd_4x4_sse41( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	__m128i r[4];
+	for( int i = 0; i < 4; i++ )
+	{
+		r[i] = _mm_sub_epi16( _mm_loadl_epi64( (const __m128i*)( pOrg + i * iOrgStride ) ), _mm_loadl_epi64( (const __m128i*)( pCur + i * iCurStride ) ) );
+	}
+	// vertical
+	butterfly16( r[0], r[1] );
+	butterfly16( r[2], r[3] );
+	butterfly16( r[0], r[2] );
+	butterfly16( r[1], r[3] );
+	// transpose: columns 0|1 in a, 2|3 in b
+	const __m128i t0 = _mm_unpacklo_epi16( r[0], r[1] );
+	const __m128i t1 = _mm_unpacklo_epi16( r[2], r[3] );
+	__m128i a = _mm_unpacklo_epi32( t0, t1 );
+	__m128i b = _mm_unpackhi_epi32( t0, t1 );
+	// horizontal
+	butterfly16( a, b );
+	__m128i c = _mm_unpacklo_epi64( a, b );
+	__m128i d = _mm_unpackhi_epi64( a, b );
+	butterfly16( c, d );
+
+	const __m128i vOnes = _mm_set1_epi16( 1 );
+	__m128i vSum = _mm_add_epi32( _mm_madd_epi16( _mm_abs_epi16( c ), vOnes ), _mm_madd_epi16( _mm_abs_epi16( d ), vOnes ) );
+	return ( horizontalSum( vSum ) + 1 ) >> 1;
+}
+
+/// 8-bit samples: two 3-stage passes keep the coefficients within 16 bits (|c| <= 16320)
+unsigned int satd_8x8_sse41( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	__m128i r[8];
+	for( int i = 0; i < 8; i++ )
+	{
+		r[i] = _mm_sub_epi16( _mm_loadu_si128( (const __m128i*)( pOrg + i * iOrgStride ) ), _mm_loadu_si128( (const __m128i*)( pCur + i * iCurStride ) ) );
+	}
+	hadamard8( r );
+	transpose8x8( r );
+	hadamard8( r );
+
+	const __m128i vOnes = _mm_set1_epi16( 1 );
+	__m128i vSum = _mm_setzero_si128();
+	for( int i = 0; i < 8; i++ )
+	{
+		vSum = _mm_add_epi32( vSum, _mm_madd_epi16( _mm_abs_epi16( r[i] ), vOnes ) );
+	}
+	return ( horizontalSum( vSum ) + 2 ) >> 2;
+}
+
+unsigned int satd_16x16_sse41( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	return satd_8x8_sse41( pOrg, iOrgStride, pCur, iCurStride ) + satd_8x8_sse41( pOrg + 8, iOrgStride, pCur + 8, iCurStride ) +
+		   satd_8x8_sse41( pOrg + 8 * iOrgStride, iOrgStride, pCur + 8 * iCurStride, iCurStride ) +
+		   satd_8x8_sse41( pOrg + 8 * iOrgStride + 8, iOrgStride, pCur + 8 * iCurStride + 8, iCurStride );
+}
+
+/// high bit depth: differences are widened to 32 bits before the transform
+unsigned int satd_4x4_hbd_sse41( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	__m128i r[4];
+	for( int i = 0; i < 4; i++ )
+	{
+		const __m128i vOrg = _mm_cvtepi16_epi32( _mm_loadl_epi64( (const __m128i*)( pOrg + i * iOrgStride ) ) );
+		const __m128i vCur = _mm_cvtepi16_epi32( _mm_loadl_epi64( (const __m128i*)( pCur + i * iCurStride ) ) );
+		r[i] = _mm_sub_epi32( vOrg, vCur );
+	}
+	butterfly32( r[0], r[1] );
+	butterfly32( r[2], r[3] );
+	butterfly32( r[0], r[2] );
+	butterfly32( r[1], r[3] );
+	// transpose 4x4
+	const __m128i t0 = _mm_unpacklo_epi32( r[0], r[1] );
+	const __m128i t1 = _mm_unpackhi_epi32( r[0], r[1] );
+	const __m128i t2 = _mm_unpacklo_epi32( r[2], r[3] );
+	const __m128i t3 = _mm_unpackhi_epi32( r[2], r[3] );
+	r[0] = _mm_unpacklo_epi64( t0, t2 );
+	r[1] = _mm_unpackhi_epi64( t0, t2 );
+	r[2] = _mm_unpacklo_epi64( t1, t3 );
+	r[3] = _mm_unpackhi_epi64( t1, t3 );
+	butterfly32( r[0], r[1] );
+	butterfly32( r[2], r[3] );
+	butterfly32( r[0], r[2] );
+	butterfly32( r[1], r[3] );
+
+	__m128i vSum = _mm_add_epi32( _mm_add_epi32( _mm_abs_epi32( r[0] ), _mm_abs_epi32( r[1] ) ), _mm_add_epi32( _mm_abs_epi32( r[2] ), _mm_abs_epi32( r[3] ) ) );
+	return ( horizontalSum( vSum ) + 1 ) >> 1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Squared error and SSIM statistics
+// --------------------------------------------------------------------------------------------------------------------
+
+/// adds the squared differences of one row to 32-bit lanes, a row never overflows them for bit depths up to 12
+inline __m128i sseRow( const short* pOrg, const short* pCur, int iWidth )
+{
+	__m128i vRow = _mm_setzero_si128();
+	int x = 0;
+	for( ; x + 8 <= iWidth; x += 8 )
+	{
+		const __m128i vDiff = _mm_sub_epi16( _mm_loadu_si128( (const __m128i*)( pOrg + x ) ), _mm_loadu_si128( (const __m128i*)( pCur + x ) ) );
+		vRow = _mm_add_epi32( vRow, _mm_madd_epi16( vDiff, vDiff ) );
+	}
+	if( x + 4 <= iWidth )
+	{
+		const __m128i vDiff = _mm_sub_epi16( _mm_loadl_epi64( (const __m128i*)( pOrg + x ) ), _mm_loadl_epi64( (const __m128i*)( pCur + x ) ) );
+		vRow = _mm_add_epi32( vRow, _mm_madd_epi16( vDiff, vDiff ) );
+	}
+	return vRow;
+}
+
+inline __m128i widenAdd( __m128i vAcc64, __m128i vRow32 )
+{
+	vAcc64 = _mm_add_epi64( vAcc64, _mm_cvtepu32_epi64( vRow32 ) );
+	return _mm_add_epi64( vAcc64, _mm_cvtepu32_epi64( _mm_srli_si128( vRow32, 8 ) ) );
+}
+
+inline unsigned long long horizontalSum64( __m128i vSum )
+{
+	return (unsigned long long)_mm_cvtsi128_si64( vSum ) + (unsigned long long)_mm_extract_epi64( vSum, 1 );
+}
+
+template <int W, int H>
+unsigned long long sse_sse41( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride )
+{
+	__m128i vSum = _mm_setzero_si128();
+	for( int y = 0; y < H; y++ )
+	{
+		vSum = widenAdd( vSum, sseRow( pOrg, pCur, W ) );
+		pOrg += iOrgStride;
+		pCur += iCurStride;
+	}
+	return horizontalSum64( vSum );
+}
+
+unsigned long long sse_plane_sse41( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride, int iWidth, int iHeight )
+{
+	const int iSimdWidth = iWidth & ~3;
+	unsigned long long uiTail = 0;
+	__m128i vSum = _mm_setzero_si128();
+	for( int y = 0; y < iHeight; y++ )
+	{
+		vSum = widenAdd( vSum, sseRow( pOrg, pCur, iSimdWidth ) );
+		for( int x = iSimdWidth; x < iWidth; x++ )
+		{
+			const int iDiff = pOrg[x] - pCur[x];
+			uiTail += iDiff * iDiff;
+		}
+		pOrg += iOrgStride;
+		pCur += iCurStride;
+	}
+	return horizontalSum64( vSum ) + uiTail;
+}
+
+/// two 4x4 blocks per iteration, block 0 in the low half of each row register and block 1 in the high half
+void ssim_sums_4x4_sse41( const short* pOrg, int iOrgStride, const short* pRec, int iRecStride, int iNumBlocks, int ( *paiSums )[4] )
+{
+	const __m128i vOnes = _mm_set1_epi16( 1 );
+	int n = 0;
+	for( ; n < iNumBlocks; n += 2 )
+	{
+		__m128i vS1 = _mm_setzero_si128();
+		__m128i vS2 = _mm_setzero_si128();
+		__m128i vSS = _mm_setzero_si128();
+		__m128i vS12 = _mm_setzero_si128();
+		for( int y = 0; y < 4; y++ )
+		{
+			__m128i vOrg, vRec;
+			if( n + 1 < iNumBlocks )
+			{
+				vOrg = _mm_loadu_si128( (const __m128i*)( pOrg + y * iOrgStride + 4 * n ) );
+				vRec = _mm_loadu_si128( (const __m128i*)( pRec + y * iRecStride + 4 * n ) );
+			}
+			else
+			{
+				vOrg = _mm_loadl_epi64( (const __m128i*)( pOrg + y * iOrgStride + 4 * n ) );
+				vRec = _mm_loadl_epi64( (const __m128i*)( pRec + y * iRecStride + 4 * n ) );
+			}
+			vS1 = _mm_add_epi32( vS1, _mm_madd_epi16( vOrg, vOnes ) );
+			vS2 = _mm_add_epi32( vS2, _mm_madd_epi16( vRec, vOnes ) );
+			vSS = _mm_add_epi32( vSS, _mm_add_epi32( _mm_madd_epi16( vOrg, vOrg ), _mm_madd_epi16( vRec, vRec ) ) );
+			vS12 = _mm_add_epi32( vS12, _mm_madd_epi16( vOrg, vRec ) );
+		}
+		// {s1 b0, s1 b1, s2 b0, s2 b1} and {ss b0, ss b1, s12 b0, s12 b1}
+		const __m128i vA = _mm_hadd_epi32( vS1, vS2 );
+		const __m128i vB = _mm_hadd_epi32( vSS, vS12 );
+		// {s1, s2, ss, s12} of each block
+		const __m128i vBlock0 = _mm_unpacklo_epi64( _mm_shuffle_epi32( vA, 0xD8 ), _mm_shuffle_epi32( vB, 0xD8 ) );
+		_mm_storeu_si128( (__m128i*)paiSums[n], vBlock0 );
+		if( n + 1 < iNumBlocks )
+		{
+			const __m128i vBlock1 = _mm_unpackhi_epi64( _mm_shuffle_epi32( vA, 0xD8 ), _mm_shuffle_epi32( vB, 0xD8 ) );
+			_mm_storeu_si128( (__m128i*)paiSums[n + 1], vBlock1 );
+		}
+	}
+}
+}  // namespace
+
+void setupPixelPrimitivesSse41( GvcPrimitives& p )
+{
+#define SETUP_SAD( W, H )                             \
+	p.sad[BLOCK_##W##x##H] = sad_sse41<W, H>;       \
+	p.sadX3[BLOCK_##W##x##H] = sad_x3_sse41<W, H>; \
+	p.sadX4[BLOCK_##W##x##H] = sad_x4_sse41<W, H>;
+	GVC_FOR_EACH_BLOCK_SIZE( SETUP_SAD )
+#undef SETUP_SAD
+
+	p.satd[SATD_4x4] = satd_4x4_sse41;
+	p.satd[SATD_8x8] = satd_8x8_sse41;
+	p.satd[SATD_16x16] = satd_16x16_sse41;
+	p.satdHbd[SATD_4x4] = satd_4x4_hbd_sse41;
+
+#define SETUP_SSE( W, H ) p.sse[BLOCK_##W##x##H] = sse_sse41<W, H>;
+	GVC_FOR_EACH_BLOCK_SIZE( SETUP_SSE )
+#undef SETUP_SSE
+	p.ssePlane = sse_plane_sse41;
+	p.ssimSums4x4 = ssim_sums_4x4_sse41;
+}
@@ -0,0 +1,255 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcPrediction.cpp
+ * \brief    Intra reference samples and prediction of a transform unit
+ */
+
+#include "GvcPrediction.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "GvcFrameUnit.h"
+#include "GvcPrimitives.h"
+#include "GvcRom.h"
+
+GvcPrediction::GvcPrediction()
+	: m_bStrongIntraSmoothing( true )
+{
+}
+
+GvcPrediction::~GvcPrediction()
+{
+}
+
+/** A neighbouring sample is available when it lies inside the frame and belongs to a BU of the same tile coded
+ *  before the current one, or to a partition of the current BU that precedes the block in z-order.
+ */
+bool GvcPrediction::xIsAvailable( GvcFrameUnit* pcFrame, int iPelX, int iPelY, unsigned int uiBUAddr, unsigned int uiAbsPartIdx ) const
+{
+	if( iPelX < 0 || iPelY < 0 || iPelX >= pcFrame->getWidth( COMPONENT_Y ) || iPelY >= pcFrame->getHeight( COMPONENT_Y ) )
+	{
+		return false;
+	}
+	const int iBUWidth = pcFrame->getMaxBUWidth();
+	const int iBUHeight = pcFrame->getMaxBUHeight();
+	const unsigned int uiNeighbourBUAddr = ( iPelY / iBUHeight ) * pcFrame->getFrameWidthInBUs() + iPelX / iBUWidth;
+	if( uiNeighbourBUAddr != uiBUAddr )
+	{
+		// the BUs of a tile are coded in raster order
+		return uiNeighbourBUAddr < uiBUAddr && pcFrame->getTileIdxMap( uiNeighbourBUAddr ) == pcFrame->getTileIdxMap( uiBUAddr );
+	}
+	const unsigned int uiRaster = ( ( iPelY % iBUHeight ) / MIN_PU_SIZE ) * MAX_NUM_PART_IDXS_IN_BU_WIDTH + ( iPelX % iBUWidth ) / MIN_PU_SIZE;
+	return g_auiRasterToZscan[uiRaster] < uiAbsPartIdx;
+}
+
+void GvcPrediction::initIntraPattern( GvcFrameUnit* pcFrame, const ComponentID compID, unsigned int uiBUAddr, unsigned int uiAbsPartIdx, unsigned int uiSize,
+									  int iBitDepth )
+{
+	const int iScaleX = pcFrame->getComponentScaleX( compID );
+	const int iScaleY = pcFrame->getComponentScaleY( compID );
+	const int iStride = pcFrame->getStride( compID );
+	const short* pRec = pcFrame->getAddr( compID, uiBUAddr, uiAbsPartIdx );
+	const int iPelX = ( uiBUAddr % pcFrame->getFrameWidthInBUs() ) * pcFrame->getMaxBUWidth() + g_auiZscanToPelX[uiAbsPartIdx];
+	const int iPelY = ( uiBUAddr / pcFrame->getFrameWidthInBUs() ) * pcFrame->getMaxBUHeight() + g_auiZscanToPelY[uiAbsPartIdx];
+	const int iUnitWidth = MIN_PU_SIZE >> iScaleX;
+	const int iUnitHeight = MIN_PU_SIZE >> iScaleY;
+	const int iNumSamples = 4 * uiSize + 1;
+
+	// scan order of the substitution process: bottom-left to top-left, then left to right above
+	short asLine[4 * MAX_TU_SIZE + 1];
+	bool abAvail[4 * MAX_TU_SIZE + 1];
+	short* pLineCorner = asLine + 2 * uiSize;
+	bool* pAvailCorner = abAvail + 2 * uiSize;
+	int iNumAvail = 0;
+
+	*pAvailCorner = xIsAvailable( pcFrame, iPelX - 1, iPelY - 1, uiBUAddr, uiAbsPartIdx );
+	if( *pAvailCorner )
+	{
+		*pLineCorner = pRec[-iStride - 1];
+		iNumAvail++;
+	}
+	for( int i = 0; i < (int)( 2 * uiSize ); i += iUnitWidth )
+	{
+		const bool bAvail = xIsAvailable( pcFrame, iPelX + ( i << iScaleX ), iPelY - 1, uiBUAddr, uiAbsPartIdx );
+		for( int k = i; k < i + iUnitWidth; k++ )
+		{
+			pAvailCorner[1 + k] = bAvail;
+			if( bAvail )
+			{
+				pLineCorner[1 + k] = pRec[-iStride + k];
+			}
+		}
+		iNumAvail += bAvail;
+	}
+	for( int j = 0; j < (int)( 2 * uiSize ); j += iUnitHeight )
+	{
+		const bool bAvail = xIsAvailable( pcFrame, iPelX - 1, iPelY + ( j << iScaleY ), uiBUAddr, uiAbsPartIdx );
+		for( int k = j; k < j + iUnitHeight; k++ )
+		{
+			pAvailCorner[-1 - k] = bAvail;
+			if( bAvail )
+			{
+				pLineCorner[-1 - k] = pRec[k * iStride - 1];
+			}
+		}
+		iNumAvail += bAvail;
+	}
+
+	if( !iNumAvail )
+	{
+		for( int i = 0; i < iNumSamples; i++ )
+		{
+			asLine[i] = (short)( 1 << ( iBitDepth - 1 ) );
+		}
+	}
+	else
+	{
+		if( !abAvail[0] )
+		{
+			int i = 1;
+			while( !abAvail[i] )
+			{
+				i++;
+			}
+			asLine[0] = asLine[i];
+		}
+		for( int i = 1; i < iNumSamples; i++ )
+		{
+			if( !abAvail[i] )
+			{
+				asLine[i] = asLine[i - 1];
+			}
+		}
+	}
+
+	m_asRefUnfiltered[0] = *pLineCorner;
+	for( unsigned int i = 0; i < 2 * uiSize; i++ )
+	{
+		m_asRefUnfiltered[1 + i] = pLineCorner[1 + i];
+		m_asRefUnfiltered[2 * uiSize + 1 + i] = pLineCorner[-1 - (int)i];
+	}
+	xFilterReference( toChannelType( compID ), uiSize, iBitDepth );
+}
+
+/** [1 2 1] smoothing along the reference, or the bilinear interpolation between the corners of the
+ *  reference for flat 32x32 luma blocks.
+ */
+void GvcPrediction::xFilterReference( const ChannelType chType, unsigned int uiSize, int iBitDepth )
+{
+	const int N = uiSize;
+	const short* pAbove = m_asRefUnfiltered + 1;
+	const short* pLeft = m_asRefUnfiltered + 2 * N + 1;
+	const int iTopLeft = m_asRefUnfiltered[0];
+	short* pFiltAbove = m_asRefFiltered + 1;
+	short* pFiltLeft = m_asRefFiltered + 2 * N + 1;
+
+	if( m_bStrongIntraSmoothing && isLuma( chType ) && N == MAX_TU_SIZE )
+	{
+		const int iThreshold = 1 << ( iBitDepth - 5 );
+		const int iBottomLeft = pLeft[2 * N - 1];
+		const int iTopRight = pAbove[2 * N - 1];
+		if( abs( iBottomLeft + iTopLeft - 2 * pLeft[N - 1] ) < iThreshold && abs( iTopLeft + iTopRight - 2 * pAbove[N - 1] ) < iThreshold )
+		{
+			m_asRefFiltered[0] = (short)iTopLeft;
+			for( int i = 0; i < 2 * N - 1; i++ )
+			{
+				pFiltAbove[i] = (short)( ( ( 2 * N - 1 - i ) * iTopLeft + ( i + 1 ) * iTopRight + N ) >> 6 );
+				pFiltLeft[i] = (short)( ( ( 2 * N - 1 - i ) * iTopLeft + ( i + 1 ) * iBottomLeft + N ) >> 6 );
+			}
+			pFiltAbove[2 * N - 1] = (short)iTopRight;
+			pFiltLeft[2 * N - 1] = (short)iBottomLeft;
+			return;
+		}
+	}
+
+	m_asRefFiltered[0] = (short)( ( pAbove[0] + 2 * iTopLeft + pLeft[0] + 2 ) >> 2 );
+	pFiltAbove[0] = (short)( ( iTopLeft + 2 * pAbove[0] + pAbove[1] + 2 ) >> 2 );
+	pFiltLeft[0] = (short)( ( iTopLeft + 2 * pLeft[0] + pLeft[1] + 2 ) >> 2 );
+	for( int i = 1; i < 2 * N - 1; i++ )
+	{
+		pFiltAbove[i] = (short)( ( pAbove[i - 1] + 2 * pAbove[i] + pAbove[i + 1] + 2 ) >> 2 );
+		pFiltLeft[i] = (short)( ( pLeft[i - 1] + 2 * pLeft[i] + pLeft[i + 1] + 2 ) >> 2 );
+	}
+	pFiltAbove[2 * N - 1] = pAbove[2 * N - 1];
+	pFiltLeft[2 * N - 1] = pLeft[2 * N - 1];
+}
+
+bool GvcPrediction::useFilteredReference( const ChannelType chType, const ChromaFormat chFmt, unsigned int uiDirMode, unsigned int uiSize )
+{
+	if( !filterintraReferenceSamples( chType, chFmt, false ) || uiDirMode == DC_IDX )
+	{
+		return false;
+	}
+	const int iDiff = std::min<int>( abs( (int)uiDirMode - HOR_IDX ), abs( (int)uiDirMode - VER_IDX ) );
+	return iDiff > g_aucIntraFilter[chType][g_aucConvertToBit[uiSize]];
+}
+
+void GvcPrediction::predIntraAng( const ComponentID compID, const ChromaFormat chFmt, unsigned int uiDirMode, short* pDst, int iDstStride, unsigned int uiSize,
+								 int iBitDepth )
+{
+	const ChannelType chType = toChannelType( compID );
+	const short* pRef = useFilteredReference( chType, chFmt, uiDirMode, uiSize ) ? m_asRefFiltered : m_asRefUnfiltered;
+	const bool bEdgeFilter = isLuma( chType ) && uiSize <= 16;
+	g_gvcPrimitives.intraPred[g_aucConvertToBit[uiSize]][uiDirMode]( pDst, iDstStride, pRef, uiDirMode, iBitDepth, bEdgeFilter );
+}
+
+void GvcPrediction::interpolateBlock( GvcInterpFilter eFilter, const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight,
+									  int iFracX, int iFracY, int iBitDepth )
+{
+	if( iFracX == 0 && iFracY == 0 )
+	{
+		g_gvcPrimitives.interpCopy[INTERP_PEL_TO_PEL]( pSrc, iSrcStride, pDst, iDstStride, iWidth, iHeight, iBitDepth );
+	}
+	else if( iFracY == 0 )
+	{
+		g_gvcPrimitives.interpHor[eFilter][INTERP_PEL_TO_PEL]( pSrc, iSrcStride, pDst, iDstStride, iWidth, iHeight, iFracX, iBitDepth );
+	}
+	else if( iFracX == 0 )
+	{
+		g_gvcPrimitives.interpVer[eFilter][INTERP_PEL_TO_PEL]( pSrc, iSrcStride, pDst, iDstStride, iWidth, iHeight, iFracY, iBitDepth );
+	}
+	else
+	{
+		g_gvcPrimitives.interpHV[eFilter][INTERP_PEL_TO_PEL]( pSrc, iSrcStride, pDst, iDstStride, iWidth, iHeight, iFracX, iFracY, iBitDepth );
+	}
+}
+
+/** Chroma takes the luma vector at its own resolution, the phase is always expressed in eighth samples. */
+void GvcPrediction::predInterBlk( const ComponentID compID, const ChromaFormat chFmt, const GvcFrameUnit* pcRefFrame, int iPelX, int iPelY, const GvcMv& rcMv,
+								  int iWidth, int iHeight, short* pDst, int iDstStride, int iBitDepth )
+{
+	const int iScaleX = getComponentScaleX( compID, chFmt );
+	const int iScaleY = getComponentScaleY( compID, chFmt );
+	const int iShiftHor = 2 + iScaleX;
+	const int iShiftVer = 2 + iScaleY;
+	const int iStride = pcRefFrame->getStride( compID );
+	const short* pRef = pcRefFrame->getAddr( compID ) + ( ( iPelY >> iScaleY ) + ( rcMv.getVer() >> iShiftVer ) ) * iStride + ( iPelX >> iScaleX ) +
+						( rcMv.getHor() >> iShiftHor );
+	int iFracX = rcMv.getHor() & ( ( 1 << iShiftHor ) - 1 );
+	int iFracY = rcMv.getVer() & ( ( 1 << iShiftVer ) - 1 );
+	if( !isLuma( compID ) )
+	{
+		iFracX <<= 1 - iScaleX;
+		iFracY <<= 1 - iScaleY;
+	}
+	interpolateBlock( isLuma( compID ) ? INTERP_LUMA : INTERP_CHROMA, pRef, iStride, pDst, iDstStride, iWidth, iHeight, iFracX, iFracY, iBitDepth );
+}
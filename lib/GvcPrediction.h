@@ -0,0 +1,82 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcPrediction.h
+ * \brief    Intra reference samples and prediction of a transform unit, motion compensated prediction
+ */
+
+#ifndef __GVCPREDICTION_H__
+#define __GVCPREDICTION_H__
+
+#include "TypeDef.h"
+#include "TComChromaFormat.h"
+#include "GvcMv.h"
+#include "GvcPrimitives.h"
+
+class GvcFrameUnit;
+
+/**
+ * \class    GvcPrediction
+ * \brief    Builds the intra reference of a block from the reconstructed frame and predicts it
+ *
+ * The reference holds the top-left sample, the 2N samples above and the 2N samples at the left
+ * of the block, in this order. Samples that are outside the frame or not reconstructed yet are
+ * substituted, then a smoothed copy is derived for the modes that use it.
+ *
+ * Inter prediction interpolates the reference frame at the quarter sample luma vector with the
+ * 8-tap luma and 4-tap chroma filters; the padded margin of the frame covers the filter support.
+ */
+class GvcPrediction
+{
+  private:
+	short m_asRefUnfiltered[4 * MAX_TU_SIZE + 1];
+	short m_asRefFiltered[4 * MAX_TU_SIZE + 1];
+	bool m_bStrongIntraSmoothing;
+
+	bool xIsAvailable( GvcFrameUnit* pcFrame, int iPelX, int iPelY, unsigned int uiBUAddr, unsigned int uiAbsPartIdx ) const;
+	void xFilterReference( const ChannelType chType, unsigned int uiSize, int iBitDepth );
+
+  public:
+	GvcPrediction();
+	virtual ~GvcPrediction();
+
+	void setStrongIntraSmoothing( bool b ) { m_bStrongIntraSmoothing = b; }
+
+	/// gathers the reference of the uiSize x uiSize block of compID whose top-left partition is uiAbsPartIdx (z-order) in BU uiBUAddr
+	void initIntraPattern( GvcFrameUnit* pcFrame, const ComponentID compID, unsigned int uiBUAddr, unsigned int uiAbsPartIdx, unsigned int uiSize,
+						   int iBitDepth );
+	/// predicts the block of the last initIntraPattern() call with intra mode uiDirMode
+	void predIntraAng( const ComponentID compID, const ChromaFormat chFmt, unsigned int uiDirMode, short* pDst, int iDstStride, unsigned int uiSize,
+					   int iBitDepth );
+
+	/// motion compensated prediction of the iWidth x iHeight block of compID whose top-left luma sample is (iPelX, iPelY)
+	void predInterBlk( const ComponentID compID, const ChromaFormat chFmt, const GvcFrameUnit* pcRefFrame, int iPelX, int iPelY, const GvcMv& rcMv, int iWidth,
+					   int iHeight, short* pDst, int iDstStride, int iBitDepth );
+	/// interpolates the block at pSrc at the given phases, through the horizontal, vertical or two dimensional kernel
+	static void interpolateBlock( GvcInterpFilter eFilter, const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iFracX,
+								  int iFracY, int iBitDepth );
+
+	const short* getRefUnfiltered() const { return m_asRefUnfiltered; }
+	const short* getRefFiltered() const { return m_asRefFiltered; }
+	/// whether mode uiDirMode of a uiSize block uses the smoothed reference
+	static bool useFilteredReference( const ChannelType chType, const ChromaFormat chFmt, unsigned int uiDirMode, unsigned int uiSize );
+};
+
+#endif  // __GVCPREDICTION_H__
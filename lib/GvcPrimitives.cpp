@@ -0,0 +1,100 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcPrimitives.cpp
+ * \brief    Table of optimized kernels selected at start up
+ */
+
+#include "GvcPrimitives.h"
+
+#include "config.h"
+
+GvcPrimitives g_gvcPrimitives;
+
+static GvcCpuLevel s_ePrimitivesLevel = GVC_CPU_C;
+
+int getBlockSizeIdx( int iWidth, int iHeight )
+{
+	static int s_aiBlockSizeIdx[MAX_BU_SIZE / 4][MAX_BU_SIZE / 4];
+	static bool s_bInit = false;
+	if( !s_bInit )
+	{
+		for( int i = 0; i < MAX_BU_SIZE / 4; i++ )
+		{
+			for( int j = 0; j < MAX_BU_SIZE / 4; j++ )
+			{
+				s_aiBlockSizeIdx[i][j] = -1;
+			}
+		}
+#define GVC_BLOCK_SIZE_IDX( W, H ) s_aiBlockSizeIdx[( W >> 2 ) - 1][( H >> 2 ) - 1] = BLOCK_##W##x##H;
+		GVC_FOR_EACH_BLOCK_SIZE( GVC_BLOCK_SIZE_IDX )
+#undef GVC_BLOCK_SIZE_IDX
+		s_bInit = true;
+	}
+	if( iWidth < 4 || iHeight < 4 || iWidth > MAX_BU_SIZE || iHeight > MAX_BU_SIZE || ( iWidth & 3 ) || ( iHeight & 3 ) )
+	{
+		return -1;
+	}
+	return s_aiBlockSizeIdx[( iWidth >> 2 ) - 1][( iHeight >> 2 ) - 1];
+}
+
+void setupPrimitives( int iCpuLevel )
+{
+	const GvcCpuLevel eDetected = gvcDetectCpuLevel();
+	GvcCpuLevel eLevel = ( iCpuLevel < 0 || iCpuLevel > eDetected ) ? eDetected : GvcCpuLevel( iCpuLevel );
+
+	getBlockSizeIdx( 4, 4 );
+	setupPixelPrimitivesC( g_gvcPrimitives );
+	setupTransformPrimitivesC( g_gvcPrimitives );
+	setupIntraPrimitivesC( g_gvcPrimitives );
+	setupInterpPrimitivesC( g_gvcPrimitives );
+	setupQuantPrimitivesC( g_gvcPrimitives );
+	setupDeblockPrimitivesC( g_gvcPrimitives );
+	setupSaoPrimitivesC( g_gvcPrimitives );
+#if defined( GVC_ENABLE_SIMD )
+	if( eLevel >= GVC_CPU_SSE41 )
+	{
+		setupPixelPrimitivesSse41( g_gvcPrimitives );
+		setupQuantPrimitivesSse41( g_gvcPrimitives );
+		setupDeblockPrimitivesSse41( g_gvcPrimitives );
+		setupSaoPrimitivesSse41( g_gvcPrimitives );
+	}
+	if( eLevel >= GVC_CPU_AVX2 )
+	{
+		setupPixelPrimitivesAvx2( g_gvcPrimitives );
+		setupTransformPrimitivesAvx2( g_gvcPrimitives );
+		setupIntraPrimitivesAvx2( g_gvcPrimitives );
+		setupInterpPrimitivesAvx2( g_gvcPrimitives );
+		setupQuantPrimitivesAvx2( g_gvcPrimitives );
+	}
+	if( eLevel >= GVC_CPU_AVX512 )
+	{
+		setupPixelPrimitivesAvx512( g_gvcPrimitives );
+	}
+#else
+	eLevel = GVC_CPU_C;
+#endif
+	s_ePrimitivesLevel = eLevel;
+}
+
+GvcCpuLevel getPrimitivesCpuLevel()
+{
+	return s_ePrimitivesLevel;
+}
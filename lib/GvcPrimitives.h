@@ -0,0 +1,271 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcPrimitives.h
+ * \brief    Table of optimized kernels selected at start up
+ */
+
+#ifndef __GVCPRIMITIVES_H__
+#define __GVCPRIMITIVES_H__
+
+#include "TypeDef.h"
+#include "GvcCpu.h"
+
+// ====================================================================================================================
+// Block sizes
+// ====================================================================================================================
+
+/// every rectangular block from 4x4 to 64x64 plus the asymmetric motion partition shapes
+#define GVC_FOR_EACH_BLOCK_SIZE( MACRO ) \
+	MACRO( 4, 4 )                        \
+	MACRO( 4, 8 )                        \
+	MACRO( 4, 16 )                       \
+	MACRO( 4, 32 )                       \
+	MACRO( 4, 64 )                       \
+	MACRO( 8, 4 )                        \
+	MACRO( 8, 8 )                        \
+	MACRO( 8, 16 )                       \
+	MACRO( 8, 32 )                       \
+	MACRO( 8, 64 )                       \
+	MACRO( 16, 4 )                       \
+	MACRO( 16, 8 )                       \
+	MACRO( 16, 16 )                      \
+	MACRO( 16, 32 )                      \
+	MACRO( 16, 64 )                      \
+	MACRO( 32, 4 )                       \
+	MACRO( 32, 8 )                       \
+	MACRO( 32, 16 )                      \
+	MACRO( 32, 32 )                      \
+	MACRO( 32, 64 )                      \
+	MACRO( 64, 4 )                       \
+	MACRO( 64, 8 )                       \
+	MACRO( 64, 16 )                      \
+	MACRO( 64, 32 )                      \
+	MACRO( 64, 64 )                      \
+	MACRO( 12, 16 )                      \
+	MACRO( 16, 12 )                      \
+	MACRO( 24, 32 )                      \
+	MACRO( 32, 24 )                      \
+	MACRO( 48, 64 )                      \
+	MACRO( 64, 48 )
+
+#define GVC_BLOCK_SIZE_ENUM( W, H ) BLOCK_##W##x##H,
+enum GvcBlockSize
+{
+	GVC_FOR_EACH_BLOCK_SIZE( GVC_BLOCK_SIZE_ENUM )
+	NUM_BLOCK_SIZES
+};
+#undef GVC_BLOCK_SIZE_ENUM
+
+/// index of a width x height block in the primitive tables, -1 if the shape has no kernel
+int getBlockSizeIdx( int iWidth, int iHeight );
+
+/// square Hadamard transform sizes
+enum GvcSatdSize
+{
+	SATD_4x4 = 0,
+	SATD_8x8 = 1,
+	SATD_16x16 = 2,  ///< four 8x8 transforms, normalized as such
+	NUM_SATD_SIZES = 3
+};
+
+/// square transform sizes
+enum GvcTransformSize
+{
+	TRANSFORM_4x4 = 0,
+	TRANSFORM_8x8 = 1,
+	TRANSFORM_16x16 = 2,
+	TRANSFORM_32x32 = 3,
+	NUM_TRANSFORM_SIZES = 4
+};
+
+/// interpolation filters
+enum GvcInterpFilter
+{
+	INTERP_LUMA = 0,    ///< 8 taps, quarter sample phases
+	INTERP_CHROMA = 1,  ///< 4 taps, eighth sample phases
+	NUM_INTERP_FILTERS = 2
+};
+
+/// input and output of one interpolation pass: samples or 14-bit intermediates centred on zero
+enum GvcInterpStage
+{
+	INTERP_PEL_TO_PEL = 0,  ///< single pass
+	INTERP_PEL_TO_INT = 1,  ///< first of two passes, or a prediction to be averaged
+	INTERP_INT_TO_PEL = 2,  ///< second pass
+	INTERP_INT_TO_INT = 3,  ///< second pass of a prediction to be averaged
+	NUM_INTERP_STAGES = 4
+};
+
+/// direction of a deblocked edge
+enum GvcDeblockEdgeDir
+{
+	EDGE_VER = 0,  ///< vertical edge, the samples across it are adjacent in a row
+	EDGE_HOR = 1,  ///< horizontal edge, the samples across it are one stride apart
+	NUM_EDGE_DIRS = 2
+};
+
+/// sample adaptive offset edge classes, named after the direction of the two neighbours a sample is compared with
+enum GvcSaoEOClass
+{
+	SAO_EO_0 = 0,    ///< left and right
+	SAO_EO_90 = 1,   ///< above and below
+	SAO_EO_135 = 2,  ///< above left and below right
+	SAO_EO_45 = 3,   ///< above right and below left
+	NUM_SAO_EO_CLASSES = 4
+};
+
+#define NUM_SAO_EO_CATEGORIES         5       ///< none, local minimum, concave corner, convex corner, local maximum
+#define NUM_SAO_BO_BANDS             32       ///< bands of equal width over the sample range
+
+// ====================================================================================================================
+// Kernel signatures
+// ====================================================================================================================
+
+/// sum of absolute differences between a source block and a candidate block
+typedef unsigned int ( *GvcSadFunc )( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride );
+/// SAD of one source block against three candidates sharing a stride
+typedef void ( *GvcSadX3Func )( const short* pOrg, int iOrgStride, const short* pCur0, const short* pCur1, const short* pCur2, int iCurStride, unsigned int* puiSad );
+/// SAD of one source block against four candidates sharing a stride
+typedef void ( *GvcSadX4Func )( const short* pOrg, int iOrgStride, const short* pCur0, const short* pCur1, const short* pCur2, const short* pCur3, int iCurStride, unsigned int* puiSad );
+
+/// sum of absolute Hadamard transformed differences (HM normalization: 4x4 halved, 8x8 quartered)
+typedef unsigned int ( *GvcSatdFunc )( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride );
+
+/// sum of squared differences of a block (sample bit depth up to 12)
+typedef unsigned long long ( *GvcSseFunc )( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride );
+/// sum of squared differences of an arbitrary width x height area, used for whole planes
+typedef unsigned long long ( *GvcSsePlaneFunc )( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride, int iWidth, int iHeight );
+/// SSIM statistics {sum org, sum rec, sum org^2 + rec^2, sum org * rec} of iNumBlocks horizontally adjacent 4x4 blocks
+typedef void ( *GvcSsimSumsFunc )( const short* pOrg, int iOrgStride, const short* pRec, int iRecStride, int iNumBlocks, int ( *paiSums )[4] );
+
+/// 2D forward transform of a residual block into a contiguous block of coefficients
+typedef void ( *GvcFwdTransformFunc )( const short* pResi, int iResiStride, TCoeff* pCoeff, int iBitDepth );
+/// 2D inverse transform, only the iNumRows x iNumCols top-left coefficients may be non-zero
+typedef void ( *GvcInvTransformFunc )( const TCoeff* pCoeff, short* pResi, int iResiStride, int iBitDepth, int iNumRows, int iNumCols );
+
+/**
+ * intra prediction of a square block, pRef holds the top-left sample, the 2N samples above (from left to right)
+ * and the 2N samples at the left (from top to bottom); bFilter enables the DC and pure horizontal/vertical edge filters
+ */
+typedef void ( *GvcIntraPredFunc )( short* pDst, int iDstStride, const short* pRef, int iDirMode, int iBitDepth, bool bFilter );
+
+/// one direction of the separable interpolation with the filter of phase iFrac (> 0), any width multiple of 4
+typedef void ( *GvcInterpFunc )( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iFrac, int iBitDepth );
+/// horizontal then vertical interpolation from samples, the intermediate rows stay in a small local buffer
+typedef void ( *GvcInterpHVFunc )( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iFracX, int iFracY, int iBitDepth );
+/// integer position, converted between samples and intermediates as the stage requires
+typedef void ( *GvcInterpCopyFunc )( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iBitDepth );
+/// bi-prediction: rounded average of two intermediate blocks, clipped to samples
+typedef void ( *GvcAddAvgFunc )( const short* pSrc0, int iSrc0Stride, const short* pSrc1, int iSrc1Stride, short* pDst, int iDstStride, int iWidth, int iHeight,
+								  int iBitDepth );
+/// weighted prediction of an intermediate block: ( ( w * sample + round ) >> iLog2Wd ) + offset, clipped
+typedef void ( *GvcWeightFunc )( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, int iWeight, int iOffset, int iLog2Wd,
+								 int iBitDepth );
+
+/// level = sign( c ) * ( ( |c| * scale + iAdd ) >> iQBits ) clipped to 16 bits, returns the sum of absolute levels; iNumCoeff is a multiple of 8
+typedef unsigned int ( *GvcQuantFunc )( const TCoeff* pCoeff, TCoeff* pLevel, const int* piQuantCoeff, int iQBits, int iAdd, int iNumCoeff );
+/// coefficient = level * scale rounded and right shifted by iShift (left shifted if negative), clipped to 16 bits
+typedef void ( *GvcDequantFunc )( const TCoeff* pLevel, TCoeff* pCoeff, const int* piDequantCoeff, int iShift, int iNumCoeff );
+
+/**
+ * luma deblocking of an edge segment of 4 lines, on/off, strong/normal and side decisions included; pSrc is the q0
+ * sample of the first line, the next lines follow down a vertical edge and to the right of a horizontal one
+ */
+typedef void ( *GvcDeblockLumaFunc )( short* pSrc, int iStride, int iTc, int iBeta, int iBitDepth );
+/// chroma deblocking (p0 and q0 only) of an edge segment of iNumLines lines, 2 or 4
+typedef void ( *GvcDeblockChromaFunc )( short* pSrc, int iStride, int iTc, int iNumLines, int iBitDepth );
+
+/**
+ * sample adaptive offset statistics of an area whose samples all have both neighbours of the edge class: sum of
+ * original - reconstruction and sample count per edge category, added to piDiff and piCount
+ */
+typedef void ( *GvcSaoStatsEOFunc )( const short* pRec, int iRecStride, const short* pOrg, int iOrgStride, int iWidth, int iHeight, int* piDiff, int* piCount );
+/// band offset statistics of an area, per band of sample >> iShift, added to piDiff and piCount
+typedef void ( *GvcSaoStatsBOFunc )( const short* pRec, int iRecStride, const short* pOrg, int iOrgStride, int iWidth, int iHeight, int iShift, int* piDiff,
+									 int* piCount );
+/// adds the offset of the edge category of each sample of pSrc (piOffset[0] is 0) and writes the clipped sum to pDst
+typedef void ( *GvcSaoApplyEOFunc )( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, const int* piOffset, int iBitDepth );
+/// adds the offset of the band of each sample of pSrc (piBandOffset has NUM_SAO_BO_BANDS entries) and writes the clipped sum to pDst
+typedef void ( *GvcSaoApplyBOFunc )( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, const int* piBandOffset,
+									 int iBitDepth );
+
+/**
+ * \struct   GvcPrimitives
+ * \brief    Function pointers to the fastest implementation of each kernel
+ */
+struct GvcPrimitives
+{
+	GvcSadFunc sad[NUM_BLOCK_SIZES];
+	GvcSadX3Func sadX3[NUM_BLOCK_SIZES];
+	GvcSadX4Func sadX4[NUM_BLOCK_SIZES];
+	GvcSatdFunc satd[NUM_SATD_SIZES];     ///< samples up to 8 bits, 16-bit intermediates
+	GvcSatdFunc satdHbd[NUM_SATD_SIZES];  ///< high bit depth samples, 32-bit intermediates
+	GvcSseFunc sse[NUM_BLOCK_SIZES];
+	GvcSsePlaneFunc ssePlane;
+	GvcSsimSumsFunc ssimSums4x4;
+	GvcFwdTransformFunc fwdDct[NUM_TRANSFORM_SIZES];
+	GvcInvTransformFunc invDct[NUM_TRANSFORM_SIZES];
+	GvcFwdTransformFunc fwdDst4x4;
+	GvcInvTransformFunc invDst4x4;
+	GvcIntraPredFunc intraPred[NUM_TRANSFORM_SIZES][NUM_LUMA_MODE];
+	GvcQuantFunc quant;
+	GvcDequantFunc dequant;
+	GvcInterpFunc interpHor[NUM_INTERP_FILTERS][NUM_INTERP_STAGES];  ///< only the stages starting from samples
+	GvcInterpFunc interpVer[NUM_INTERP_FILTERS][NUM_INTERP_STAGES];
+	GvcInterpHVFunc interpHV[NUM_INTERP_FILTERS][NUM_INTERP_STAGES];  ///< only the stages starting from samples
+	GvcInterpCopyFunc interpCopy[NUM_INTERP_STAGES];
+	GvcAddAvgFunc addAvg;
+	GvcWeightFunc weightUni;
+	GvcDeblockLumaFunc deblockLuma[NUM_EDGE_DIRS];
+	GvcDeblockChromaFunc deblockChroma[NUM_EDGE_DIRS];
+	GvcSaoStatsEOFunc saoStatsEO[NUM_SAO_EO_CLASSES];
+	GvcSaoStatsBOFunc saoStatsBO;
+	GvcSaoApplyEOFunc saoApplyEO[NUM_SAO_EO_CLASSES];
+	GvcSaoApplyBOFunc saoApplyBO;
+};
+
+extern GvcPrimitives g_gvcPrimitives;
+
+/// fill g_gvcPrimitives for the given level, clamped to what the processor supports (-1 selects the best one)
+void setupPrimitives( int iCpuLevel = -1 );
+/// level g_gvcPrimitives was set up with
+GvcCpuLevel getPrimitivesCpuLevel();
+
+// per instruction set initialization, each one only overrides the kernels it implements
+void setupPixelPrimitivesC( GvcPrimitives& p );
+void setupPixelPrimitivesSse41( GvcPrimitives& p );
+void setupPixelPrimitivesAvx2( GvcPrimitives& p );
+void setupPixelPrimitivesAvx512( GvcPrimitives& p );
+void setupTransformPrimitivesC( GvcPrimitives& p );
+void setupTransformPrimitivesAvx2( GvcPrimitives& p );
+void setupIntraPrimitivesC( GvcPrimitives& p );
+void setupIntraPrimitivesAvx2( GvcPrimitives& p );
+void setupInterpPrimitivesC( GvcPrimitives& p );
+void setupInterpPrimitivesAvx2( GvcPrimitives& p );
+void setupQuantPrimitivesC( GvcPrimitives& p );
+void setupQuantPrimitivesSse41( GvcPrimitives& p );
+void setupQuantPrimitivesAvx2( GvcPrimitives& p );
+void setupDeblockPrimitivesC( GvcPrimitives& p );
+void setupDeblockPrimitivesSse41( GvcPrimitives& p );
+void setupSaoPrimitivesC( GvcPrimitives& p );
+void setupSaoPrimitivesSse41( GvcPrimitives& p );
+
+#endif  // __GVCPRIMITIVES_H__
@@ -0,0 +1,284 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcQuality.cpp
+ * \brief    Objective quality (PSNR/SSIM) of the reconstructed frames
+ */
+
+#include "GvcQuality.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "GvcFrameUnit.h"
+#include "GvcPrimitives.h"
+
+GvcQualityAnalyser::GvcQualityAnalyser()
+	: m_bSSIM( false )
+	, m_pcThreadPool( NULL )
+	, m_bRunning( false )
+	, m_bPending( false )
+	, m_bDone( false )
+	, m_pcFrameOrg( NULL )
+	, m_pcFrameRec( NULL )
+	, m_iNumFrames( 0 )
+	, m_iNumComponents( 0 )
+{
+	for( int i = 0; i < MAX_NUM_COMPONENT; i++ )
+	{
+		m_adSumPSNR[i] = 0;
+		m_adSumSSIM[i] = 0;
+	}
+}
+
+GvcQualityAnalyser::~GvcQualityAnalyser()
+{
+	destroy();
+}
+
+void GvcQualityAnalyser::create( const int* piBitDepth, bool bSSIM, GvcThreadPool* pcThreadPool )
+{
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		m_aiBitDepth[ch] = piBitDepth[ch];
+	}
+	m_bSSIM = bSSIM;
+	// a thread of its own only when there is no pool to share
+	m_pcThreadPool = pcThreadPool && pcThreadPool->getNumThreads() > 0 ? pcThreadPool : NULL;
+	if( !m_pcThreadPool )
+	{
+		m_bRunning = true;
+		m_cThread = std::thread( &GvcQualityAnalyser::xWorker, this );
+	}
+}
+
+void GvcQualityAnalyser::destroy()
+{
+	if( m_pcThreadPool )
+	{
+		// the job of a frame never collected still reads it
+		std::unique_lock<std::mutex> lock( m_cMutex );
+		m_cCond.wait( lock, [this] { return !m_bPending || m_bDone; } );
+		m_pcThreadPool = NULL;
+		return;
+	}
+	if( !m_cThread.joinable() )
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		m_bRunning = false;
+	}
+	m_cCond.notify_all();
+	m_cThread.join();
+}
+
+void GvcQualityAnalyser::submit( const GvcFrameUnit* pcFrameOrg, const GvcFrameUnit* pcFrameRec, int iPOC )
+{
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		m_pcFrameOrg = pcFrameOrg;
+		m_pcFrameRec = pcFrameRec;
+		m_cResult.iPOC = iPOC;
+		m_bPending = true;
+		m_bDone = false;
+	}
+	if( m_pcThreadPool )
+	{
+		m_pcThreadPool->enqueue( [this]( int ) { xMeasure(); }, iPOC );
+		return;
+	}
+	m_cCond.notify_all();
+}
+
+bool GvcQualityAnalyser::collect( GvcFrameQuality& rcQuality )
+{
+	std::unique_lock<std::mutex> lock( m_cMutex );
+	if( !m_bPending )
+	{
+		return false;
+	}
+	m_cCond.wait( lock, [this] { return m_bDone; } );
+	m_bPending = false;
+	rcQuality = m_cResult;
+	xAddFrame( rcQuality );
+	return true;
+}
+
+void GvcQualityAnalyser::addFrame( const GvcFrameQuality& rcQuality )
+{
+	std::lock_guard<std::mutex> lock( m_cMutex );
+	xAddFrame( rcQuality );
+}
+
+/// called with the mutex held
+void GvcQualityAnalyser::xAddFrame( const GvcFrameQuality& rcQuality )
+{
+	m_iNumFrames++;
+	m_iNumComponents = rcQuality.iNumComponents;
+	for( int comp = 0; comp < rcQuality.iNumComponents; comp++ )
+	{
+		m_adSumPSNR[comp] += rcQuality.adPSNR[comp];
+		m_adSumSSIM[comp] += rcQuality.adSSIM[comp];
+	}
+}
+
+void GvcQualityAnalyser::xWorker()
+{
+	std::unique_lock<std::mutex> lock( m_cMutex );
+	while( true )
+	{
+		m_cCond.wait( lock, [this] { return !m_bRunning || ( m_bPending && !m_bDone ); } );
+		if( !m_bRunning )
+		{
+			return;
+		}
+		lock.unlock();
+		xMeasure();
+		lock.lock();
+	}
+}
+
+/// measures the pending frame, on the worker thread or as a job of the pool
+void GvcQualityAnalyser::xMeasure()
+{
+	std::unique_lock<std::mutex> lock( m_cMutex );
+	const GvcFrameUnit* pcFrameOrg = m_pcFrameOrg;
+	const GvcFrameUnit* pcFrameRec = m_pcFrameRec;
+	GvcFrameQuality cQuality = m_cResult;
+	lock.unlock();
+
+	calcFrameQuality( pcFrameOrg, pcFrameRec, m_aiBitDepth, m_bSSIM, cQuality );
+
+	lock.lock();
+	m_cResult = cQuality;
+	m_bDone = true;
+	m_cCond.notify_all();
+}
+
+void GvcQualityAnalyser::printFrame( const GvcFrameQuality& rcQuality ) const
+{
+	printf( "POC %4d [Y %6.4lf dB    U %6.4lf dB    V %6.4lf dB]", rcQuality.iPOC, rcQuality.adPSNR[COMPONENT_Y],
+			rcQuality.iNumComponents > 1 ? rcQuality.adPSNR[COMPONENT_Cb] : 0.0, rcQuality.iNumComponents > 1 ? rcQuality.adPSNR[COMPONENT_Cr] : 0.0 );
+	if( m_bSSIM )
+	{
+		printf( " [SSIM Y %6.4lf    U %6.4lf    V %6.4lf]", rcQuality.adSSIM[COMPONENT_Y], rcQuality.iNumComponents > 1 ? rcQuality.adSSIM[COMPONENT_Cb] : 0.0,
+				rcQuality.iNumComponents > 1 ? rcQuality.adSSIM[COMPONENT_Cr] : 0.0 );
+	}
+	printf( "\n" );
+}
+
+void GvcQualityAnalyser::printSummary() const
+{
+	if( m_iNumFrames == 0 )
+	{
+		return;
+	}
+	const double dScale = 1.0 / m_iNumFrames;
+	printf( "\nSUMMARY --------------------------------------------------------\n" );
+	printf( "\tTotal Frames |   Y-PSNR    U-PSNR    V-PSNR" );
+	if( m_bSSIM )
+	{
+		printf( " |   Y-SSIM    U-SSIM    V-SSIM" );
+	}
+	printf( "\n\t %8d    a  %8.4lf  %8.4lf  %8.4lf", m_iNumFrames, m_adSumPSNR[COMPONENT_Y] * dScale, m_adSumPSNR[COMPONENT_Cb] * dScale, m_adSumPSNR[COMPONENT_Cr] * dScale );
+	if( m_bSSIM )
+	{
+		printf( "    %8.6lf  %8.6lf  %8.6lf", m_adSumSSIM[COMPONENT_Y] * dScale, m_adSumSSIM[COMPONENT_Cb] * dScale, m_adSumSSIM[COMPONENT_Cr] * dScale );
+	}
+	printf( "\n" );
+}
+
+/**
+ * PSNR follows HM: the peak is 255 scaled to the bit depth and an identical plane reports 999.99 dB.
+ */
+void GvcQualityAnalyser::calcFrameQuality( const GvcFrameUnit* pcFrameOrg, const GvcFrameUnit* pcFrameRec, const int* piBitDepth, bool bSSIM, GvcFrameQuality& rcQuality )
+{
+	rcQuality.iNumComponents = getNumberValidComponents( pcFrameRec->getChromaFormat() );
+	for( int comp = 0; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		rcQuality.auiSSE[comp] = 0;
+		rcQuality.adPSNR[comp] = 0;
+		rcQuality.adSSIM[comp] = 0;
+	}
+	for( int comp = 0; comp < rcQuality.iNumComponents; comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		const int iBitDepth = piBitDepth[toChannelType( compID )];
+		const int iWidth = pcFrameRec->getWidth( compID );
+		const int iHeight = pcFrameRec->getHeight( compID );
+		const short* pOrg = pcFrameOrg->getAddr( compID );
+		const short* pRec = pcFrameRec->getAddr( compID );
+		const int iOrgStride = pcFrameOrg->getStride( compID );
+		const int iRecStride = pcFrameRec->getStride( compID );
+
+		const unsigned long long uiSSE = g_gvcPrimitives.ssePlane( pOrg, iOrgStride, pRec, iRecStride, iWidth, iHeight );
+		const double dMaxValue = 255 << ( iBitDepth - 8 );
+		rcQuality.auiSSE[comp] = uiSSE;
+		rcQuality.adPSNR[comp] = uiSSE ? 10.0 * log10( dMaxValue * dMaxValue * iWidth * iHeight / (double)uiSSE ) : 999.99;
+		if( bSSIM )
+		{
+			rcQuality.adSSIM[comp] = calcSSIM( pOrg, iOrgStride, pRec, iRecStride, iWidth, iHeight, iBitDepth );
+		}
+	}
+}
+
+/**
+ * SSIM over 8x8 windows placed every 4 samples, built from the statistics of non-overlapping 4x4 blocks
+ * so that each sample is read once. Constants follow the usual K1 = 0.01, K2 = 0.03.
+ */
+double GvcQualityAnalyser::calcSSIM( const short* pOrg, int iOrgStride, const short* pRec, int iRecStride, int iWidth, int iHeight, int iBitDepth )
+{
+	const int iBlocksX = iWidth >> 2;
+	const int iBlocksY = iHeight >> 2;
+	if( iBlocksX < 2 || iBlocksY < 2 )
+	{
+		return 1.0;
+	}
+	const double dMaxValue = ( 1 << iBitDepth ) - 1;
+	const double dC1 = 0.01 * 0.01 * dMaxValue * dMaxValue * 64 * 64;
+	const double dC2 = 0.03 * 0.03 * dMaxValue * dMaxValue * 64 * 63;
+
+	std::vector<int> aiSumsBuf( 2 * 4 * iBlocksX );
+	int( *paiSums[2] )[4] = { (int( * )[4]) & aiSumsBuf[0], (int( * )[4]) & aiSumsBuf[4 * iBlocksX] };
+
+	double dSSIM = 0;
+	g_gvcPrimitives.ssimSums4x4( pOrg, iOrgStride, pRec, iRecStride, iBlocksX, paiSums[0] );
+	for( int y = 1; y < iBlocksY; y++ )
+	{
+		g_gvcPrimitives.ssimSums4x4( pOrg + 4 * y * iOrgStride, iOrgStride, pRec + 4 * y * iRecStride, iRecStride, iBlocksX, paiSums[y & 1] );
+		const int( *pTop )[4] = paiSums[( y - 1 ) & 1];
+		const int( *pBot )[4] = paiSums[y & 1];
+		for( int x = 0; x + 1 < iBlocksX; x++ )
+		{
+			double s[4];
+			for( int k = 0; k < 4; k++ )
+			{
+				s[k] = (double)pTop[x][k] + pTop[x + 1][k] + pBot[x][k] + pBot[x + 1][k];
+			}
+			const double dVars = s[2] * 64 - s[0] * s[0] - s[1] * s[1];
+			const double dCovar = s[3] * 64 - s[0] * s[1];
+			dSSIM += ( 2 * s[0] * s[1] + dC1 ) * ( 2 * dCovar + dC2 ) / ( ( s[0] * s[0] + s[1] * s[1] + dC1 ) * ( dVars + dC2 ) );
+		}
+	}
+	return dSSIM / ( ( iBlocksX - 1 ) * ( iBlocksY - 1 ) );
+}
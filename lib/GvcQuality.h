@@ -0,0 +1,104 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcQuality.h
+ * \brief    Objective quality (PSNR/SSIM) of the reconstructed frames
+ */
+
+#ifndef __GVCQUALITY_H__
+#define __GVCQUALITY_H__
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "TypeDef.h"
+#include "GvcThreadPool.h"
+
+class GvcFrameUnit;
+
+/// distortion of one reconstructed frame, per component
+struct GvcFrameQuality
+{
+	int iPOC;
+	int iNumComponents;
+	unsigned long long auiSSE[MAX_NUM_COMPONENT];
+	double adPSNR[MAX_NUM_COMPONENT];
+	double adSSIM[MAX_NUM_COMPONENT];  ///< only filled when SSIM is enabled
+};
+
+/**
+ * \class    GvcQualityAnalyser
+ * \brief    Measures PSNR/SSIM on a worker thread while the encoder moves on to the next frame
+ *
+ * The measurement is a job of the thread pool when one is given, otherwise it runs on a thread of the analyser.
+ *
+ * One frame is in flight at a time: the frames handed to submit() must stay untouched until collect() returns.
+ */
+class GvcQualityAnalyser
+{
+	int m_aiBitDepth[MAX_NUM_CHANNEL_TYPE];
+	bool m_bSSIM;
+
+	// worker thread
+	GvcThreadPool* m_pcThreadPool;  ///< runs the measurements instead of the thread when set
+	std::thread m_cThread;
+	std::mutex m_cMutex;
+	std::condition_variable m_cCond;
+	bool m_bRunning;
+	bool m_bPending;  ///< a frame was submitted and not collected yet
+	bool m_bDone;     ///< the worker finished the pending frame
+	const GvcFrameUnit* m_pcFrameOrg;
+	const GvcFrameUnit* m_pcFrameRec;
+	GvcFrameQuality m_cResult;
+
+	// sequence totals
+	int m_iNumFrames;
+	int m_iNumComponents;
+	double m_adSumPSNR[MAX_NUM_COMPONENT];
+	double m_adSumSSIM[MAX_NUM_COMPONENT];
+
+  public:
+	GvcQualityAnalyser();
+	virtual ~GvcQualityAnalyser();
+
+	void create( const int* piBitDepth, bool bSSIM, GvcThreadPool* pcThreadPool = NULL );
+	void destroy();
+
+	void submit( const GvcFrameUnit* pcFrameOrg, const GvcFrameUnit* pcFrameRec, int iPOC );
+	/// waits for the frame in flight and adds it to the totals, false if nothing was submitted
+	bool collect( GvcFrameQuality& rcQuality );
+	/// adds a frame measured elsewhere to the totals
+	void addFrame( const GvcFrameQuality& rcQuality );
+
+	void printFrame( const GvcFrameQuality& rcQuality ) const;
+	void printSummary() const;
+
+	/// synchronous measurement, also used by the worker
+	static void calcFrameQuality( const GvcFrameUnit* pcFrameOrg, const GvcFrameUnit* pcFrameRec, const int* piBitDepth, bool bSSIM, GvcFrameQuality& rcQuality );
+	static double calcSSIM( const short* pOrg, int iOrgStride, const short* pRec, int iRecStride, int iWidth, int iHeight, int iBitDepth );
+
+  private:
+	void xAddFrame( const GvcFrameQuality& rcQuality );
+	void xMeasure();
+	void xWorker();
+};
+
+#endif  // __GVCQUALITY_H__
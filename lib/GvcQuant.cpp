@@ -0,0 +1,75 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcQuant.cpp
+ * \brief    Reference C++ implementation of the scalar quantization kernels
+ */
+
+#include <cstdlib>
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+unsigned int quant_c( const TCoeff* pCoeff, TCoeff* pLevel, const int* piQuantCoeff, int iQBits, int iAdd, int iNumCoeff )
+{
+	unsigned int uiAbsSum = 0;
+	for( int n = 0; n < iNumCoeff; n++ )
+	{
+		const TCoeff iCoeff = pCoeff[n];
+		const long long iTmp = (long long)std::abs( iCoeff ) * piQuantCoeff[n];
+		const int iLevel = (int)std::min<long long>( ( iTmp + iAdd ) >> iQBits, 32767 );
+		uiAbsSum += iLevel;
+		pLevel[n] = iCoeff < 0 ? -iLevel : iLevel;
+	}
+	return uiAbsSum;
+}
+
+void dequant_c( const TCoeff* pLevel, TCoeff* pCoeff, const int* piDequantCoeff, int iShift, int iNumCoeff )
+{
+	if( iShift > 0 )
+	{
+		const int iAdd = 1 << ( iShift - 1 );
+		for( int n = 0; n < iNumCoeff; n++ )
+		{
+			const int iLevel = Clip3( -32768, 32767, pLevel[n] );
+			pCoeff[n] = Clip3( -32768, 32767, ( iLevel * piDequantCoeff[n] + iAdd ) >> iShift );
+		}
+	}
+	else
+	{
+		// saturating the product before the shift keeps it in 32 bits and gives the same clipped result
+		const int iLeftShift = -iShift;
+		const int iMax = 1 << ( 15 - iLeftShift );
+		for( int n = 0; n < iNumCoeff; n++ )
+		{
+			const int iLevel = Clip3( -32768, 32767, pLevel[n] );
+			const int iProduct = Clip3( -iMax, iMax, iLevel * piDequantCoeff[n] );
+			pCoeff[n] = Clip3( -32768, 32767, iProduct * ( 1 << iLeftShift ) );
+		}
+	}
+}
+}  // namespace
+
+void setupQuantPrimitivesC( GvcPrimitives& p )
+{
+	p.quant = quant_c;
+	p.dequant = dequant_c;
+}
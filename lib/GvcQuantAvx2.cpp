@@ -0,0 +1,92 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcQuantAvx2.cpp
+ * \brief    AVX2 implementation of the scalar quantization kernels
+ *
+ * Transform coefficients fit in 16 bits and the scales of the default and flat scaling lists in 15 bits,
+ * so all products are exact in 32-bit lanes.
+ */
+
+#include <immintrin.h>
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+unsigned int quant_avx2( const TCoeff* pCoeff, TCoeff* pLevel, const int* piQuantCoeff, int iQBits, int iAdd, int iNumCoeff )
+{
+	const __m256i vAdd = _mm256_set1_epi32( iAdd );
+	const __m128i vShift = _mm_cvtsi32_si128( iQBits );
+	const __m256i vMax = _mm256_set1_epi32( 32767 );
+	__m256i vSum = _mm256_setzero_si256();
+	for( int n = 0; n < iNumCoeff; n += 8 )
+	{
+		const __m256i vCoeff = _mm256_loadu_si256( (const __m256i*)( pCoeff + n ) );
+		__m256i vLevel = _mm256_mullo_epi32( _mm256_abs_epi32( vCoeff ), _mm256_loadu_si256( (const __m256i*)( piQuantCoeff + n ) ) );
+		vLevel = _mm256_min_epi32( _mm256_srl_epi32( _mm256_add_epi32( vLevel, vAdd ), vShift ), vMax );
+		vSum = _mm256_add_epi32( vSum, vLevel );
+		_mm256_storeu_si256( (__m256i*)( pLevel + n ), _mm256_sign_epi32( vLevel, vCoeff ) );
+	}
+	__m128i vSum128 = _mm_add_epi32( _mm256_castsi256_si128( vSum ), _mm256_extracti128_si256( vSum, 1 ) );
+	vSum128 = _mm_add_epi32( vSum128, _mm_shuffle_epi32( vSum128, 0x4E ) );
+	vSum128 = _mm_add_epi32( vSum128, _mm_shuffle_epi32( vSum128, 0xB1 ) );
+	return (unsigned int)_mm_cvtsi128_si32( vSum128 );
+}
+
+void dequant_avx2( const TCoeff* pLevel, TCoeff* pCoeff, const int* piDequantCoeff, int iShift, int iNumCoeff )
+{
+	const __m256i vMin16 = _mm256_set1_epi32( -32768 );
+	const __m256i vMax16 = _mm256_set1_epi32( 32767 );
+	if( iShift > 0 )
+	{
+		const __m256i vAdd = _mm256_set1_epi32( 1 << ( iShift - 1 ) );
+		const __m128i vShift = _mm_cvtsi32_si128( iShift );
+		for( int n = 0; n < iNumCoeff; n += 8 )
+		{
+			__m256i v = _mm256_loadu_si256( (const __m256i*)( pLevel + n ) );
+			v = _mm256_min_epi32( _mm256_max_epi32( v, vMin16 ), vMax16 );
+			v = _mm256_mullo_epi32( v, _mm256_loadu_si256( (const __m256i*)( piDequantCoeff + n ) ) );
+			v = _mm256_sra_epi32( _mm256_add_epi32( v, vAdd ), vShift );
+			_mm256_storeu_si256( (__m256i*)( pCoeff + n ), _mm256_min_epi32( _mm256_max_epi32( v, vMin16 ), vMax16 ) );
+		}
+	}
+	else
+	{
+		const __m128i vShift = _mm_cvtsi32_si128( -iShift );
+		const __m256i vMax = _mm256_set1_epi32( 1 << ( 15 + iShift ) );
+		const __m256i vMin = _mm256_sub_epi32( _mm256_setzero_si256(), vMax );
+		for( int n = 0; n < iNumCoeff; n += 8 )
+		{
+			__m256i v = _mm256_loadu_si256( (const __m256i*)( pLevel + n ) );
+			v = _mm256_min_epi32( _mm256_max_epi32( v, vMin16 ), vMax16 );
+			v = _mm256_mullo_epi32( v, _mm256_loadu_si256( (const __m256i*)( piDequantCoeff + n ) ) );
+			v = _mm256_sll_epi32( _mm256_min_epi32( _mm256_max_epi32( v, vMin ), vMax ), vShift );
+			_mm256_storeu_si256( (__m256i*)( pCoeff + n ), _mm256_min_epi32( _mm256_max_epi32( v, vMin16 ), vMax16 ) );
+		}
+	}
+}
+}  // namespace
+
+void setupQuantPrimitivesAvx2( GvcPrimitives& p )
+{
+	p.quant = quant_avx2;
+	p.dequant = dequant_avx2;
+}
@@ -0,0 +1,91 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcQuantSse41.cpp
+ * \brief    SSE4.1 implementation of the scalar quantization kernels
+ *
+ * Transform coefficients fit in 16 bits and the scales of the default and flat scaling lists in 15 bits,
+ * so all products are exact in 32-bit lanes.
+ */
+
+#include <smmintrin.h>
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+unsigned int quant_sse41( const TCoeff* pCoeff, TCoeff* pLevel, const int* piQuantCoeff, int iQBits, int iAdd, int iNumCoeff )
+{
+	const __m128i vAdd = _mm_set1_epi32( iAdd );
+	const __m128i vShift = _mm_cvtsi32_si128( iQBits );
+	const __m128i vMax = _mm_set1_epi32( 32767 );
+	__m128i vSum = _mm_setzero_si128();
+	for( int n = 0; n < iNumCoeff; n += 4 )
+	{
+		const __m128i vCoeff = _mm_loadu_si128( (const __m128i*)( pCoeff + n ) );
+		__m128i vLevel = _mm_mullo_epi32( _mm_abs_epi32( vCoeff ), _mm_loadu_si128( (const __m128i*)( piQuantCoeff + n ) ) );
+		vLevel = _mm_min_epi32( _mm_srl_epi32( _mm_add_epi32( vLevel, vAdd ), vShift ), vMax );
+		vSum = _mm_add_epi32( vSum, vLevel );
+		_mm_storeu_si128( (__m128i*)( pLevel + n ), _mm_sign_epi32( vLevel, vCoeff ) );
+	}
+	vSum = _mm_add_epi32( vSum, _mm_shuffle_epi32( vSum, 0x4E ) );
+	vSum = _mm_add_epi32( vSum, _mm_shuffle_epi32( vSum, 0xB1 ) );
+	return (unsigned int)_mm_cvtsi128_si32( vSum );
+}
+
+void dequant_sse41( const TCoeff* pLevel, TCoeff* pCoeff, const int* piDequantCoeff, int iShift, int iNumCoeff )
+{
+	const __m128i vMin16 = _mm_set1_epi32( -32768 );
+	const __m128i vMax16 = _mm_set1_epi32( 32767 );
+	if( iShift > 0 )
+	{
+		const __m128i vAdd = _mm_set1_epi32( 1 << ( iShift - 1 ) );
+		const __m128i vShift = _mm_cvtsi32_si128( iShift );
+		for( int n = 0; n < iNumCoeff; n += 4 )
+		{
+			__m128i v = _mm_loadu_si128( (const __m128i*)( pLevel + n ) );
+			v = _mm_min_epi32( _mm_max_epi32( v, vMin16 ), vMax16 );
+			v = _mm_mullo_epi32( v, _mm_loadu_si128( (const __m128i*)( piDequantCoeff + n ) ) );
+			v = _mm_sra_epi32( _mm_add_epi32( v, vAdd ), vShift );
+			_mm_storeu_si128( (__m128i*)( pCoeff + n ), _mm_min_epi32( _mm_max_epi32( v, vMin16 ), vMax16 ) );
+		}
+	}
+	else
+	{
+		const __m128i vShift = _mm_cvtsi32_si128( -iShift );
+		const __m128i vMax = _mm_set1_epi32( 1 << ( 15 + iShift ) );
+		const __m128i vMin = _mm_sub_epi32( _mm_setzero_si128(), vMax );
+		for( int n = 0; n < iNumCoeff; n += 4 )
+		{
+			__m128i v = _mm_loadu_si128( (const __m128i*)( pLevel + n ) );
+			v = _mm_min_epi32( _mm_max_epi32( v, vMin16 ), vMax16 );
+			v = _mm_mullo_epi32( v, _mm_loadu_si128( (const __m128i*)( piDequantCoeff + n ) ) );
+			v = _mm_sll_epi32( _mm_min_epi32( _mm_max_epi32( v, vMin ), vMax ), vShift );
+			_mm_storeu_si128( (__m128i*)( pCoeff + n ), _mm_min_epi32( _mm_max_epi32( v, vMin16 ), vMax16 ) );
+		}
+	}
+}
+}  // namespace
+
+void setupQuantPrimitivesSse41( GvcPrimitives& p )
+{
+	p.quant = quant_sse41;
+	p.dequant = dequant_sse41;
+}
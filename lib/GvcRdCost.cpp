@@ -0,0 +1,114 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcRdCost.cpp
+ * \brief    Rate-distortion cost and distortion measures
+ */
+
+#include "GvcRdCost.h"
+
+#include <cmath>
+
+#include "GvcPrimitives.h"
+
+GvcRdCost::GvcRdCost()
+	: m_dLambda( 0 )
+	, m_dSqrtLambda( 0 )
+{
+}
+
+void GvcRdCost::setLambda( double dLambda )
+{
+	m_dLambda = dLambda;
+	m_dSqrtLambda = sqrt( dLambda );
+}
+
+unsigned int GvcRdCost::getComponentBits( int iVal )
+{
+	unsigned int uiLength = 1;
+	unsigned int uiTemp = iVal <= 0 ? ( (unsigned int)-iVal << 1 ) + 1 : ( (unsigned int)iVal << 1 );
+	while( uiTemp != 1 )
+	{
+		uiTemp >>= 1;
+		uiLength += 2;
+	}
+	return uiLength;
+}
+
+unsigned int GvcRdCost::getSAD( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride, int iWidth, int iHeight )
+{
+	const int iSizeIdx = getBlockSizeIdx( iWidth, iHeight );
+	if( iSizeIdx >= 0 )
+	{
+		return g_gvcPrimitives.sad[iSizeIdx]( pOrg, iOrgStride, pCur, iCurStride );
+	}
+	unsigned int uiSum = 0;
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth; x++ )
+		{
+			uiSum += abs( pOrg[x] - pCur[x] );
+		}
+		pOrg += iOrgStride;
+		pCur += iCurStride;
+	}
+	return uiSum;
+}
+
+/**
+ * Tiles the block with the largest Hadamard transform that fits: 16x16 (as four 8x8) when both
+ * dimensions allow it, otherwise 8x8, otherwise 4x4, as HM does for its non-square cases.
+ */
+unsigned int GvcRdCost::getSATD( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride, int iWidth, int iHeight, int iBitDepth )
+{
+	const GvcSatdFunc* pfSatd = iBitDepth > 8 ? g_gvcPrimitives.satdHbd : g_gvcPrimitives.satd;
+	int iSize = 4;
+	GvcSatdSize eSize = SATD_4x4;
+	if( iWidth % 16 == 0 && iHeight % 16 == 0 )
+	{
+		iSize = 16;
+		eSize = SATD_16x16;
+	}
+	else if( iWidth % 8 == 0 && iHeight % 8 == 0 )
+	{
+		iSize = 8;
+		eSize = SATD_8x8;
+	}
+
+	unsigned int uiSum = 0;
+	for( int y = 0; y < iHeight; y += iSize )
+	{
+		for( int x = 0; x < iWidth; x += iSize )
+		{
+			uiSum += pfSatd[eSize]( pOrg + y * iOrgStride + x, iOrgStride, pCur + y * iCurStride + x, iCurStride );
+		}
+	}
+	return uiSum;
+}
+
+unsigned long long GvcRdCost::getSSE( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride, int iWidth, int iHeight )
+{
+	const int iSizeIdx = getBlockSizeIdx( iWidth, iHeight );
+	if( iSizeIdx >= 0 )
+	{
+		return g_gvcPrimitives.sse[iSizeIdx]( pOrg, iOrgStride, pCur, iCurStride );
+	}
+	return g_gvcPrimitives.ssePlane( pOrg, iOrgStride, pCur, iCurStride, iWidth, iHeight );
+}
@@ -0,0 +1,68 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcRdCost.h
+ * \brief    Rate-distortion cost and distortion measures
+ */
+
+#ifndef __GVCRDCOST_H__
+#define __GVCRDCOST_H__
+
+#include "TypeDef.h"
+#include "GvcMv.h"
+
+/**
+ * \class    GvcRdCost
+ * \brief    Lambda handling and block distortion (SAD, SATD, SSE) through the primitive table
+ */
+class GvcRdCost
+{
+	double m_dLambda;
+	double m_dSqrtLambda;
+	GvcMv m_cMvPredictor;  ///< predictor the motion vector costs are taken against
+
+  public:
+	GvcRdCost();
+
+	void setLambda( double dLambda );
+	double getLambda() const { return m_dLambda; }
+	double getSqrtLambda() const { return m_dSqrtLambda; }
+
+	/// full RD cost: D + lambda * R
+	double calcRdCost( unsigned int uiBits, unsigned long long uiDistortion ) const { return (double)uiDistortion + m_dLambda * uiBits; }
+	/// motion/mode estimation cost on SAD/SATD scale: D + sqrt(lambda) * R
+	double calcRdCostSqrt( unsigned int uiBits, unsigned int uiDistortion ) const { return (double)uiDistortion + m_dSqrtLambda * uiBits; }
+
+	void setPredictor( const GvcMv& rcMv ) { m_cMvPredictor = rcMv; }
+	const GvcMv& getPredictor() const { return m_cMvPredictor; }
+	/// bits of the difference between the quarter sample vector (iHor, iVer) and the predictor
+	unsigned int getBitsOfVectorWithPredictor( int iHor, int iVer ) const
+	{
+		return getComponentBits( iHor - m_cMvPredictor.getHor() ) + getComponentBits( iVer - m_cMvPredictor.getVer() );
+	}
+	/// length of the signed Exp-Golomb code of a vector difference component
+	static unsigned int getComponentBits( int iVal );
+
+	static unsigned int getSAD( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride, int iWidth, int iHeight );
+	static unsigned int getSATD( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride, int iWidth, int iHeight, int iBitDepth );
+	static unsigned long long getSSE( const short* pOrg, int iOrgStride, const short* pCur, int iCurStride, int iWidth, int iHeight );
+};
+
+#endif  // __GVCRDCOST_H__
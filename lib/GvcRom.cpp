@@ -0,0 +1,285 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcRom.cpp
+ * \brief    Global tables shared by the encoder and the decoder
+ */
+
+#include "GvcRom.h"
+
+#include <algorithm>
+
+unsigned int g_auiZscanToRaster[MAX_NUM_PART_IDXS_IN_BU] = {0};
+unsigned int g_auiRasterToZscan[MAX_NUM_PART_IDXS_IN_BU] = {0};
+unsigned int g_auiZscanToPelX[MAX_NUM_PART_IDXS_IN_BU] = {0};
+unsigned int g_auiZscanToPelY[MAX_NUM_PART_IDXS_IN_BU] = {0};
+unsigned char g_aucConvertToBit[MAX_BU_SIZE + 1];
+
+const short g_aiT4[4][4] =
+{
+	{  64,  64,  64,  64 },
+	{  83,  36, -36, -83 },
+	{  64, -64, -64,  64 },
+	{  36, -83,  83, -36 },
+};
+
+const short g_aiT8[8][8] =
+{
+	{  64,  64,  64,  64,  64,  64,  64,  64 },
+	{  89,  75,  50,  18, -18, -50, -75, -89 },
+	{  83,  36, -36, -83, -83, -36,  36,  83 },
+	{  75, -18, -89, -50,  50,  89,  18, -75 },
+	{  64, -64, -64,  64,  64, -64, -64,  64 },
+	{  50, -89,  18,  75, -75, -18,  89, -50 },
+	{  36, -83,  83, -36, -36,  83, -83,  36 },
+	{  18, -50,  75, -89,  89, -75,  50, -18 },
+};
+
+const short g_aiT16[16][16] =
+{
+	{  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64 },
+	{  90,  87,  80,  70,  57,  43,  25,   9,  -9, -25, -43, -57, -70, -80, -87, -90 },
+	{  89,  75,  50,  18, -18, -50, -75, -89, -89, -75, -50, -18,  18,  50,  75,  89 },
+	{  87,  57,   9, -43, -80, -90, -70, -25,  25,  70,  90,  80,  43,  -9, -57, -87 },
+	{  83,  36, -36, -83, -83, -36,  36,  83,  83,  36, -36, -83, -83, -36,  36,  83 },
+	{  80,   9, -70, -87, -25,  57,  90,  43, -43, -90, -57,  25,  87,  70,  -9, -80 },
+	{  75, -18, -89, -50,  50,  89,  18, -75, -75,  18,  89,  50, -50, -89, -18,  75 },
+	{  70, -43, -87,   9,  90,  25, -80, -57,  57,  80, -25, -90,  -9,  87,  43, -70 },
+	{  64, -64, -64,  64,  64, -64, -64,  64,  64, -64, -64,  64,  64, -64, -64,  64 },
+	{  57, -80, -25,  90,  -9, -87,  43,  70, -70, -43,  87,   9, -90,  25,  80, -57 },
+	{  50, -89,  18,  75, -75, -18,  89, -50, -50,  89, -18, -75,  75,  18, -89,  50 },
+	{  43, -90,  57,  25, -87,  70,   9, -80,  80,  -9, -70,  87, -25, -57,  90, -43 },
+	{  36, -83,  83, -36, -36,  83, -83,  36,  36, -83,  83, -36, -36,  83, -83,  36 },
+	{  25, -70,  90, -80,  43,   9, -57,  87, -87,  57,  -9, -43,  80, -90,  70, -25 },
+	{  18, -50,  75, -89,  89, -75,  50, -18, -18,  50, -75,  89, -89,  75, -50,  18 },
+	{   9, -25,  43, -57,  70, -80,  87, -90,  90, -87,  80, -70,  57, -43,  25,  -9 },
+};
+
+const short g_aiT32[32][32] =
+{
+	{  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64,  64 },
+	{  90,  90,  88,  85,  82,  78,  73,  67,  61,  54,  46,  38,  31,  22,  13,   4,  -4, -13, -22, -31, -38, -46, -54, -61, -67, -73, -78, -82, -85, -88, -90, -90 },
+	{  90,  87,  80,  70,  57,  43,  25,   9,  -9, -25, -43, -57, -70, -80, -87, -90, -90, -87, -80, -70, -57, -43, -25,  -9,   9,  25,  43,  57,  70,  80,  87,  90 },
+	{  90,  82,  67,  46,  22,  -4, -31, -54, -73, -85, -90, -88, -78, -61, -38, -13,  13,  38,  61,  78,  88,  90,  85,  73,  54,  31,   4, -22, -46, -67, -82, -90 },
+	{  89,  75,  50,  18, -18, -50, -75, -89, -89, -75, -50, -18,  18,  50,  75,  89,  89,  75,  50,  18, -18, -50, -75, -89, -89, -75, -50, -18,  18,  50,  75,  89 },
+	{  88,  67,  31, -13, -54, -82, -90, -78, -46,  -4,  38,  73,  90,  85,  61,  22, -22, -61, -85, -90, -73, -38,   4,  46,  78,  90,  82,  54,  13, -31, -67, -88 },
+	{  87,  57,   9, -43, -80, -90, -70, -25,  25,  70,  90,  80,  43,  -9, -57, -87, -87, -57,  -9,  43,  80,  90,  70,  25, -25, -70, -90, -80, -43,   9,  57,  87 },
+	{  85,  46, -13, -67, -90, -73, -22,  38,  82,  88,  54,  -4, -61, -90, -78, -31,  31,  78,  90,  61,   4, -54, -88, -82, -38,  22,  73,  90,  67,  13, -46, -85 },
+	{  83,  36, -36, -83, -83, -36,  36,  83,  83,  36, -36, -83, -83, -36,  36,  83,  83,  36, -36, -83, -83, -36,  36,  83,  83,  36, -36, -83, -83, -36,  36,  83 },
+	{  82,  22, -54, -90, -61,  13,  78,  85,  31, -46, -90, -67,   4,  73,  88,  38, -38, -88, -73,  -4,  67,  90,  46, -31, -85, -78, -13,  61,  90,  54, -22, -82 },
+	{  80,   9, -70, -87, -25,  57,  90,  43, -43, -90, -57,  25,  87,  70,  -9, -80, -80,  -9,  70,  87,  25, -57, -90, -43,  43,  90,  57, -25, -87, -70,   9,  80 },
+	{  78,  -4, -82, -73,  13,  85,  67, -22, -88, -61,  31,  90,  54, -38, -90, -46,  46,  90,  38, -54, -90, -31,  61,  88,  22, -67, -85, -13,  73,  82,   4, -78 },
+	{  75, -18, -89, -50,  50,  89,  18, -75, -75,  18,  89,  50, -50, -89, -18,  75,  75, -18, -89, -50,  50,  89,  18, -75, -75,  18,  89,  50, -50, -89, -18,  75 },
+	{  73, -31, -90, -22,  78,  67, -38, -90, -13,  82,  61, -46, -88,  -4,  85,  54, -54, -85,   4,  88,  46, -61, -82,  13,  90,  38, -67, -78,  22,  90,  31, -73 },
+	{  70, -43, -87,   9,  90,  25, -80, -57,  57,  80, -25, -90,  -9,  87,  43, -70, -70,  43,  87,  -9, -90, -25,  80,  57, -57, -80,  25,  90,   9, -87, -43,  70 },
+	{  67, -54, -78,  38,  85, -22, -90,   4,  90,  13, -88, -31,  82,  46, -73, -61,  61,  73, -46, -82,  31,  88, -13, -90,  -4,  90,  22, -85, -38,  78,  54, -67 },
+	{  64, -64, -64,  64,  64, -64, -64,  64,  64, -64, -64,  64,  64, -64, -64,  64,  64, -64, -64,  64,  64, -64, -64,  64,  64, -64, -64,  64,  64, -64, -64,  64 },
+	{  61, -73, -46,  82,  31, -88, -13,  90,  -4, -90,  22,  85, -38, -78,  54,  67, -67, -54,  78,  38, -85, -22,  90,   4, -90,  13,  88, -31, -82,  46,  73, -61 },
+	{  57, -80, -25,  90,  -9, -87,  43,  70, -70, -43,  87,   9, -90,  25,  80, -57, -57,  80,  25, -90,   9,  87, -43, -70,  70,  43, -87,  -9,  90, -25, -80,  57 },
+	{  54, -85,  -4,  88, -46, -61,  82,  13, -90,  38,  67, -78, -22,  90, -31, -73,  73,  31, -90,  22,  78, -67, -38,  90, -13, -82,  61,  46, -88,   4,  85, -54 },
+	{  50, -89,  18,  75, -75, -18,  89, -50, -50,  89, -18, -75,  75,  18, -89,  50,  50, -89,  18,  75, -75, -18,  89, -50, -50,  89, -18, -75,  75,  18, -89,  50 },
+	{  46, -90,  38,  54, -90,  31,  61, -88,  22,  67, -85,  13,  73, -82,   4,  78, -78,  -4,  82, -73, -13,  85, -67, -22,  88, -61, -31,  90, -54, -38,  90, -46 },
+	{  43, -90,  57,  25, -87,  70,   9, -80,  80,  -9, -70,  87, -25, -57,  90, -43, -43,  90, -57, -25,  87, -70,  -9,  80, -80,   9,  70, -87,  25,  57, -90,  43 },
+	{  38, -88,  73,  -4, -67,  90, -46, -31,  85, -78,  13,  61, -90,  54,  22, -82,  82, -22, -54,  90, -61, -13,  78, -85,  31,  46, -90,  67,   4, -73,  88, -38 },
+	{  36, -83,  83, -36, -36,  83, -83,  36,  36, -83,  83, -36, -36,  83, -83,  36,  36, -83,  83, -36, -36,  83, -83,  36,  36, -83,  83, -36, -36,  83, -83,  36 },
+	{  31, -78,  90, -61,   4,  54, -88,  82, -38, -22,  73, -90,  67, -13, -46,  85, -85,  46,  13, -67,  90, -73,  22,  38, -82,  88, -54,  -4,  61, -90,  78, -31 },
+	{  25, -70,  90, -80,  43,   9, -57,  87, -87,  57,  -9, -43,  80, -90,  70, -25, -25,  70, -90,  80, -43,  -9,  57, -87,  87, -57,   9,  43, -80,  90, -70,  25 },
+	{  22, -61,  85, -90,  73, -38,  -4,  46, -78,  90, -82,  54, -13, -31,  67, -88,  88, -67,  31,  13, -54,  82, -90,  78, -46,   4,  38, -73,  90, -85,  61, -22 },
+	{  18, -50,  75, -89,  89, -75,  50, -18, -18,  50, -75,  89, -89,  75, -50,  18,  18, -50,  75, -89,  89, -75,  50, -18, -18,  50, -75,  89, -89,  75, -50,  18 },
+	{  13, -38,  61, -78,  88, -90,  85, -73,  54, -31,   4,  22, -46,  67, -82,  90, -90,  82, -67,  46, -22,  -4,  31, -54,  73, -85,  90, -88,  78, -61,  38, -13 },
+	{   9, -25,  43, -57,  70, -80,  87, -90,  90, -87,  80, -70,  57, -43,  25,  -9,  -9,  25, -43,  57, -70,  80, -87,  90, -90,  87, -80,  70, -57,  43, -25,   9 },
+	{   4, -13,  22, -31,  38, -46,  54, -61,  67, -73,  78, -82,  85, -88,  90, -90,  90, -90,  88, -85,  82, -78,  73, -67,  61, -54,  46, -38,  31, -22,  13,  -4 },
+};
+
+const short g_as_DST_MAT_4[4][4] =
+{
+	{  29,  55,  74,  84 },
+	{  74,  74,   0, -74 },
+	{  84, -29, -74,  55 },
+	{  55, -84,  74, -29 },
+};
+
+const unsigned char g_aucChromaScale[NUM_CHROMA_FORMAT][chromaQPMappingTableSize] =
+{
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 51, 51, 51, 51, 51, 51 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 29, 30, 31, 32, 33, 33, 34, 34, 35, 35, 36, 36, 37, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 51, 51, 51, 51, 51, 51 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 51, 51, 51, 51, 51, 51 },
+};
+
+const int g_quantScales[SCALING_LIST_REM_NUM] = { 26214, 23302, 20560, 18396, 16384, 14564 };
+const int g_invQuantScales[SCALING_LIST_REM_NUM] = { 40, 45, 51, 57, 64, 72 };
+
+const int g_quantIntraDefault8x8[64] =
+{
+	 16,  16,  16,  16,  16,  16,  16,  16,  16,  16,  17,  16,  17,  16,  17,  18,
+	 17,  18,  18,  17,  18,  21,  19,  20,  21,  20,  19,  21,  24,  22,  22,  24,
+	 24,  22,  22,  24,  25,  25,  27,  30,  27,  25,  25,  29,  31,  35,  35,  31,
+	 29,  36,  41,  44,  41,  36,  47,  54,  54,  47,  65,  70,  65,  88,  88, 115,
+};
+
+const int g_quantInterDefault8x8[64] =
+{
+	 16,  16,  16,  16,  16,  16,  16,  16,  16,  16,  17,  17,  17,  17,  17,  18,
+	 18,  18,  18,  18,  18,  20,  20,  20,  20,  20,  20,  20,  24,  24,  24,  24,
+	 24,  24,  24,  24,  25,  25,  25,  25,  25,  25,  25,  28,  28,  28,  28,  28,
+	 28,  33,  33,  33,  33,  33,  41,  41,  41,  41,  54,  54,  54,  71,  71,  91,
+};
+
+unsigned short g_auiScanOrder[SCAN_NUMBER_OF_TYPES][MAX_LOG2_TU_SIZE - MIN_LOG2_TU_SIZE + 1][MAX_TU_SIZE * MAX_TU_SIZE];
+unsigned short g_auiDiagScan8x8[64];
+
+const unsigned char g_uiGroupIdx[MAX_TU_SIZE] = { 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7, 8, 8, 8, 8, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9, 9, 9 };
+const unsigned char g_uiMinInGroup[LAST_SIGNIFICANT_GROUPS] = { 0, 1, 2, 3, 4, 6, 8, 12, 16, 24 };
+
+const unsigned char g_aucIntraFilter[MAX_NUM_CHANNEL_TYPE][MAX_LOG2_TU_SIZE - MIN_LOG2_TU_SIZE + 1] =
+{
+	{ 10, 7, 1, 0 },
+	{ 10, 7, 1, 0 },
+};
+
+const unsigned char g_aucChroma422IntraAngleMappingTable[NUM_LUMA_MODE + 1] =
+{
+	0, 1, 2, 2, 2, 2, 3, 5, 7, 8, 10, 11, 13, 15, 16, 18, 19, 20, 21, 22, 23, 23, 24, 24, 25, 25, 26, 27, 27, 28, 28, 29, 29, 30, 31, DM_CHROMA_IDX
+};
+
+const short g_aiLumaFilter[LUMA_INTERPOLATION_FILTER_SUB_SAMPLE_POSITIONS][NTAPS_LUMA] =
+{
+	{ 0, 0, 0, 64, 0, 0, 0, 0 },
+	{ -1, 4, -10, 58, 17, -5, 1, 0 },
+	{ -1, 4, -11, 40, 40, -11, 4, -1 },
+	{ 0, 1, -5, 17, 58, -10, 4, -1 },
+};
+
+const short g_aiChromaFilter[CHROMA_INTERPOLATION_FILTER_SUB_SAMPLE_POSITIONS][NTAPS_CHROMA] =
+{
+	{ 0, 64, 0, 0 },
+	{ -2, 58, 10, -2 },
+	{ -4, 54, 16, -2 },
+	{ -6, 46, 28, -4 },
+	{ -4, 36, 36, -4 },
+	{ -4, 28, 46, -6 },
+	{ -2, 16, 54, -4 },
+	{ -2, 10, 58, -2 },
+};
+
+static bool s_bROMInitialized = false;
+
+/// positions of a iWidth x iWidth block in up-right diagonal, horizontal or vertical order
+static void initScan( COEFF_SCAN_TYPE eScanIdx, int iWidth, unsigned int* puiX, unsigned int* puiY )
+{
+	int i = 0;
+	switch( eScanIdx )
+	{
+	case SCAN_HOR:
+		for( int y = 0; y < iWidth; y++ )
+		{
+			for( int x = 0; x < iWidth; x++, i++ )
+			{
+				puiX[i] = x;
+				puiY[i] = y;
+			}
+		}
+		break;
+	case SCAN_VER:
+		for( int x = 0; x < iWidth; x++ )
+		{
+			for( int y = 0; y < iWidth; y++, i++ )
+			{
+				puiX[i] = x;
+				puiY[i] = y;
+			}
+		}
+		break;
+	default:
+		for( int d = 0; d < 2 * iWidth - 1; d++ )
+		{
+			for( int y = std::min( d, iWidth - 1 ); y >= 0 && d - y < iWidth; y-- )
+			{
+				puiX[i] = d - y;
+				puiY[i] = y;
+				i++;
+			}
+		}
+		break;
+	}
+}
+
+void initROM()
+{
+	if( s_bROMInitialized )
+	{
+		return;
+	}
+	// The z-order index is the bit interleave of the partition column (even bits) and row (odd bits),
+	// so the tables do not depend on the configured BU size.
+	for( unsigned int uiIdx = 0; uiIdx < MAX_NUM_PART_IDXS_IN_BU; uiIdx++ )
+	{
+		unsigned int uiX = 0;
+		unsigned int uiY = 0;
+		for( unsigned int uiBit = 0; ( 1u << ( 2 * uiBit ) ) < MAX_NUM_PART_IDXS_IN_BU; uiBit++ )
+		{
+			uiX |= ( ( uiIdx >> ( 2 * uiBit ) ) & 1 ) << uiBit;
+			uiY |= ( ( uiIdx >> ( 2 * uiBit + 1 ) ) & 1 ) << uiBit;
+		}
+		const unsigned int uiRaster = uiY * MAX_NUM_PART_IDXS_IN_BU_WIDTH + uiX;
+		g_auiZscanToRaster[uiIdx] = uiRaster;
+		g_auiRasterToZscan[uiRaster] = uiIdx;
+		g_auiZscanToPelX[uiIdx] = uiX * MIN_PU_SIZE;
+		g_auiZscanToPelY[uiIdx] = uiY * MIN_PU_SIZE;
+	}
+
+	for( int i = 0, iSize = MIN_PU_SIZE; iSize <= MAX_BU_SIZE; i++, iSize <<= 1 )
+	{
+		g_aucConvertToBit[iSize] = (unsigned char)i;
+	}
+
+	// coefficient scans: the 4x4 groups follow the scan pattern and so do the positions inside each group
+	unsigned int auiGroupX[64], auiGroupY[64], auiPosX[16], auiPosY[16];
+	for( int iScan = 0; iScan < SCAN_NUMBER_OF_TYPES; iScan++ )
+	{
+		initScan( COEFF_SCAN_TYPE( iScan ), 4, auiPosX, auiPosY );
+		for( int iLog2Size = MIN_LOG2_TU_SIZE; iLog2Size <= MAX_LOG2_TU_SIZE; iLog2Size++ )
+		{
+			const int iSize = 1 << iLog2Size;
+			const int iGroups = iSize >> 2;
+			initScan( COEFF_SCAN_TYPE( iScan ), iGroups, auiGroupX, auiGroupY );
+			unsigned short* puiScan = g_auiScanOrder[iScan][iLog2Size - MIN_LOG2_TU_SIZE];
+			for( int g = 0; g < iGroups * iGroups; g++ )
+			{
+				for( int p = 0; p < 16; p++ )
+				{
+					puiScan[16 * g + p] = ( 4 * auiGroupY[g] + auiPosY[p] ) * iSize + 4 * auiGroupX[g] + auiPosX[p];
+				}
+			}
+		}
+	}
+	unsigned int auiX[64], auiY[64];
+	initScan( SCAN_DIAG, 8, auiX, auiY );
+	for( int i = 0; i < 64; i++ )
+	{
+		g_auiDiagScan8x8[i] = auiY[i] * 8 + auiX[i];
+	}
+	s_bROMInitialized = true;
+}
+
+void destroyROM()
+{
+}
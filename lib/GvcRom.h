@@ -0,0 +1,104 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcRom.h
+ * \brief    Global tables shared by the encoder and the decoder
+ */
+
+#ifndef __GVCROM_H__
+#define __GVCROM_H__
+
+#include "TypeDef.h"
+
+// ====================================================================================================================
+// Initialize / destroy functions
+// ====================================================================================================================
+
+void initROM();
+void destroyROM();
+
+// ====================================================================================================================
+// Partition indexing
+// ====================================================================================================================
+
+/// z-order partition index to raster index (raster rows are MAX_NUM_PART_IDXS_IN_BU_WIDTH partitions wide)
+extern unsigned int g_auiZscanToRaster[MAX_NUM_PART_IDXS_IN_BU];
+/// raster index to z-order partition index
+extern unsigned int g_auiRasterToZscan[MAX_NUM_PART_IDXS_IN_BU];
+/// z-order partition index to luma pixel offset inside the BU
+extern unsigned int g_auiZscanToPelX[MAX_NUM_PART_IDXS_IN_BU];
+extern unsigned int g_auiZscanToPelY[MAX_NUM_PART_IDXS_IN_BU];
+/// log2 of a block size minus 2, for sizes 4 to MAX_BU_SIZE
+extern unsigned char g_aucConvertToBit[MAX_BU_SIZE + 1];
+
+// ====================================================================================================================
+// Transform matrices
+// ====================================================================================================================
+
+/// HEVC integer DCT basis, row k holds the k-th basis function
+extern const short g_aiT4[4][4];
+extern const short g_aiT8[8][8];
+extern const short g_aiT16[16][16];
+extern const short g_aiT32[32][32];
+/// 4x4 integer DST used for intra luma residuals
+extern const short g_as_DST_MAT_4[4][4];
+
+// ====================================================================================================================
+// Quantization and coefficient scanning
+// ====================================================================================================================
+
+static const int chromaQPMappingTableSize = 58;
+static const int LAST_SIGNIFICANT_GROUPS = 10;
+static const int SCALING_LIST_NUM = 6;      ///< intra Y/Cb/Cr and inter Y/Cb/Cr lists
+static const int SCALING_LIST_REM_NUM = 6;  ///< QP remainders
+
+extern const unsigned char g_aucChromaScale[NUM_CHROMA_FORMAT][chromaQPMappingTableSize];
+extern const int g_quantScales[SCALING_LIST_REM_NUM];     ///< forward quantization step for each QP remainder
+extern const int g_invQuantScales[SCALING_LIST_REM_NUM];  ///< inverse quantization step for each QP remainder
+extern const int g_quantIntraDefault8x8[64];              ///< default intra scaling list, up-right diagonal order
+extern const int g_quantInterDefault8x8[64];              ///< default inter scaling list, up-right diagonal order
+
+/// raster position of each scan position, scanned in 4x4 coefficient groups; indexed by scan type and log2 size - 2
+extern unsigned short g_auiScanOrder[SCAN_NUMBER_OF_TYPES][MAX_LOG2_TU_SIZE - MIN_LOG2_TU_SIZE + 1][MAX_TU_SIZE * MAX_TU_SIZE];
+/// raster position of each scan position of an 8x8 block without coefficient groups (scaling list order)
+extern unsigned short g_auiDiagScan8x8[64];
+/// last significant position prefix group of a coordinate, and first coordinate of each group
+extern const unsigned char g_uiGroupIdx[MAX_TU_SIZE];
+extern const unsigned char g_uiMinInGroup[LAST_SIGNIFICANT_GROUPS];
+
+// ====================================================================================================================
+// Intra prediction
+// ====================================================================================================================
+
+/// reference samples are smoothed for a mode whose distance to horizontal and vertical exceeds the threshold; indexed by log2 size - 2
+extern const unsigned char g_aucIntraFilter[MAX_NUM_CHANNEL_TYPE][MAX_LOG2_TU_SIZE - MIN_LOG2_TU_SIZE + 1];
+/// 4:2:2 chroma blocks are twice as tall as wide, the luma direction is remapped to keep its angle
+extern const unsigned char g_aucChroma422IntraAngleMappingTable[NUM_LUMA_MODE + 1];
+
+// ====================================================================================================================
+// Inter prediction
+// ====================================================================================================================
+
+/// luma interpolation filters, indexed by the quarter sample phase
+extern const short g_aiLumaFilter[LUMA_INTERPOLATION_FILTER_SUB_SAMPLE_POSITIONS][NTAPS_LUMA];
+/// chroma interpolation filters, indexed by the eighth sample phase
+extern const short g_aiChromaFilter[CHROMA_INTERPOLATION_FILTER_SUB_SAMPLE_POSITIONS][NTAPS_CHROMA];
+
+#endif  // __GVCROM_H__
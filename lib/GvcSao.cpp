@@ -0,0 +1,425 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcSao.cpp
+ * \brief    Sample adaptive offset of the deblocked reconstruction
+ */
+
+#include "GvcSao.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "GvcFrameUnit.h"
+
+// ====================================================================================================================
+// Parameters
+// ====================================================================================================================
+
+void GvcSaoOffset::reset()
+{
+	eType = SAO_TYPE_OFF;
+	iTypeAux = 0;
+	for( int i = 0; i < NUM_SAO_OFFSETS; i++ )
+	{
+		aiOffset[i] = 0;
+	}
+}
+
+void GvcSaoBlkParam::reset()
+{
+	eMerge = SAO_MERGE_NONE;
+	for( int comp = 0; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		acOffset[comp].reset();
+	}
+}
+
+void GvcSaoStats::reset()
+{
+	memset( this, 0, sizeof( GvcSaoStats ) );
+}
+
+// ====================================================================================================================
+// Constructor / destructor / create / destroy
+// ====================================================================================================================
+
+GvcSao::GvcSao()
+	: m_chromaFormat( CHROMA_420 )
+	, m_iWidth( 0 )
+	, m_iHeight( 0 )
+	, m_iMaxBUWidth( 0 )
+	, m_iMaxBUHeight( 0 )
+	, m_iWidthInBUs( 0 )
+	, m_iHeightInBUs( 0 )
+	, m_dLambda( 0 )
+{
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		m_aiBitDepth[ch] = 8;
+	}
+	for( int comp = 0; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		m_aiBufStride[comp] = 0;
+	}
+}
+
+GvcSao::~GvcSao()
+{
+	destroy();
+}
+
+void GvcSao::create( int iWidth, int iHeight, ChromaFormat chromaFormat, int iMaxBUWidth, int iMaxBUHeight, const int* piBitDepth )
+{
+	m_chromaFormat = chromaFormat;
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		m_aiBitDepth[ch] = piBitDepth[ch];
+	}
+	m_iWidth = iWidth;
+	m_iHeight = iHeight;
+	m_iMaxBUWidth = iMaxBUWidth;
+	m_iMaxBUHeight = iMaxBUHeight;
+	m_iWidthInBUs = ( iWidth + iMaxBUWidth - 1 ) / iMaxBUWidth;
+	m_iHeightInBUs = ( iHeight + iMaxBUHeight - 1 ) / iMaxBUHeight;
+	m_acBlkParams.resize( m_iWidthInBUs * m_iHeightInBUs );
+	for( size_t i = 0; i < m_acBlkParams.size(); i++ )
+	{
+		m_acBlkParams[i].reset();
+	}
+	m_acStats.resize( m_iWidthInBUs * MAX_NUM_COMPONENT );
+	for( unsigned int comp = 0; comp < getNumberValidComponents( chromaFormat ); comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		const int iCompWidth = iWidth >> getComponentScaleX( compID, chromaFormat );
+		m_aiBufStride[comp] = iCompWidth + 2;
+		m_asRowBuf[comp].resize( ( ( iMaxBUHeight >> getComponentScaleY( compID, chromaFormat ) ) + 2 ) * m_aiBufStride[comp] );
+		m_asLineAbove[comp].resize( iCompWidth );
+	}
+}
+
+void GvcSao::destroy()
+{
+	m_acBlkParams.clear();
+	m_acStats.clear();
+	for( int comp = 0; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		m_asRowBuf[comp].clear();
+		m_asLineAbove[comp].clear();
+	}
+}
+
+// ====================================================================================================================
+// Encoder decision
+// ====================================================================================================================
+
+void GvcSao::getStatistics( const GvcFrameUnit* pcFrameOrg, const GvcFrameUnit* pcFrameRec, int iBURow )
+{
+	for( int iBUCol = 0; iBUCol < m_iWidthInBUs; iBUCol++ )
+	{
+		for( unsigned int comp = 0; comp < getNumberValidComponents( m_chromaFormat ); comp++ )
+		{
+			const ComponentID compID = ComponentID( comp );
+			const unsigned int uiScaleX = getComponentScaleX( compID, m_chromaFormat );
+			const unsigned int uiScaleY = getComponentScaleY( compID, m_chromaFormat );
+			const int iCompWidth = m_iWidth >> uiScaleX;
+			const int iX0 = ( iBUCol * m_iMaxBUWidth ) >> uiScaleX;
+			const int iY0 = ( iBURow * m_iMaxBUHeight ) >> uiScaleY;
+			const int iWidth = std::min( m_iMaxBUWidth >> uiScaleX, iCompWidth - iX0 );
+			const int iHeight = std::min( m_iMaxBUHeight >> uiScaleY, ( m_iHeight >> uiScaleY ) - iY0 );
+			const int iRecStride = pcFrameRec->getStride( compID );
+			const int iOrgStride = pcFrameOrg->getStride( compID );
+			const short* pRec = pcFrameRec->getAddr( compID ) + iY0 * iRecStride + iX0;
+			const short* pOrg = pcFrameOrg->getAddr( compID ) + iY0 * iOrgStride + iX0;
+			GvcSaoStats& rcStats = m_acStats[iBUCol * MAX_NUM_COMPONENT + comp];
+			rcStats.reset();
+
+			for( int iClass = 0; iClass < NUM_SAO_EO_CLASSES; iClass++ )
+			{
+				// samples without one of the two neighbours in the frame are left out, as is the bottom line: the
+				// row below is not coded yet
+				const bool bHor = iClass != SAO_EO_90;
+				const bool bVer = iClass != SAO_EO_0;
+				const int iStartX = bHor && iX0 == 0 ? 1 : 0;
+				const int iEndX = bHor && iX0 + iWidth == iCompWidth ? iWidth - 1 : iWidth;
+				const int iStartY = bVer && iY0 == 0 ? 1 : 0;
+				const int iEndY = bVer ? iHeight - 1 : iHeight;
+				if( iEndX <= iStartX || iEndY <= iStartY )
+				{
+					continue;
+				}
+				g_gvcPrimitives.saoStatsEO[iClass]( pRec + iStartY * iRecStride + iStartX, iRecStride, pOrg + iStartY * iOrgStride + iStartX, iOrgStride,
+													iEndX - iStartX, iEndY - iStartY, rcStats.aaiEODiff[iClass], rcStats.aaiEOCount[iClass] );
+			}
+			g_gvcPrimitives.saoStatsBO( pRec, iRecStride, pOrg, iOrgStride, iWidth, iHeight, xGetBitDepth( compID ) - 5, rcStats.aiBODiff, rcStats.aiBOCount );
+		}
+	}
+}
+
+/** Cost of the best offset between iMinOffset and iMaxOffset, from the rounded mean difference down to 0: the
+ *  distortion change of the iCount samples plus the bins of the truncated unary magnitude and of the sign.
+ */
+double GvcSao::xGetOffsetCost( int iCount, int iDiff, int iMinOffset, int iMaxOffset, int iShift, bool bSign, int& riOffset ) const
+{
+	const int iMaxAbs = std::max( -iMinOffset, iMaxOffset );
+	int iOffset = iCount ? Clip3( iMinOffset, iMaxOffset, (int)lround( (double)iDiff / ( (double)iCount * ( 1 << iShift ) ) ) ) : 0;
+	const int iStep = iOffset > 0 ? -1 : 1;
+	double dBestCost = MAX_DOUBLE;
+	riOffset = 0;
+	while( true )
+	{
+		const long long iScaled = (long long)iOffset * ( 1 << iShift );
+		const long long iDist = iCount * iScaled * iScaled - 2 * iScaled * iDiff;
+		const int iAbs = abs( iOffset );
+		const int iBits = ( iAbs < iMaxAbs ? iAbs + 1 : iMaxAbs ) + ( bSign && iAbs );
+		const double dCost = (double)iDist + m_dLambda * iBits;
+		if( dCost < dBestCost )
+		{
+			dBestCost = dCost;
+			riOffset = iOffset;
+		}
+		if( iOffset == 0 )
+		{
+			break;
+		}
+		iOffset += iStep;
+	}
+	return dBestCost;
+}
+
+/** Best of off, the four edge classes and the band offset for one component. The rate counts the bins of the
+ *  type (1 for off, 2 otherwise), of the edge class (2) or the first band (5), and of the offsets.
+ */
+double GvcSao::xDecideOffset( const GvcSaoStats& rcStats, ComponentID compID, GvcSaoOffset& rcOffset ) const
+{
+	const int iMaxOffset = getMaxOffset( xGetBitDepth( compID ) );
+	const int iShift = xGetBitDepth( compID ) - std::min( xGetBitDepth( compID ), 10 );
+	rcOffset.reset();
+	double dBestCost = m_dLambda;
+
+	for( int iClass = 0; iClass < NUM_SAO_EO_CLASSES; iClass++ )
+	{
+		GvcSaoOffset cOffset;
+		cOffset.eType = SAO_TYPE_EO;
+		cOffset.iTypeAux = iClass;
+		double dCost = m_dLambda * 4;
+		for( int i = 0; i < NUM_SAO_OFFSETS; i++ )
+		{
+			// local minima and concave corners are raised, convex corners and local maxima lowered
+			const bool bPositive = i < 2;
+			dCost += xGetOffsetCost( rcStats.aaiEOCount[iClass][i + 1], rcStats.aaiEODiff[iClass][i + 1], bPositive ? 0 : -iMaxOffset,
+									 bPositive ? iMaxOffset : 0, iShift, false, cOffset.aiOffset[i] );
+		}
+		if( dCost < dBestCost )
+		{
+			dBestCost = dCost;
+			rcOffset = cOffset;
+		}
+	}
+
+	double adBandCost[NUM_SAO_BO_BANDS];
+	int aiBandOffset[NUM_SAO_BO_BANDS];
+	for( int iBand = 0; iBand < NUM_SAO_BO_BANDS; iBand++ )
+	{
+		adBandCost[iBand] =
+			xGetOffsetCost( rcStats.aiBOCount[iBand], rcStats.aiBODiff[iBand], -iMaxOffset, iMaxOffset, iShift, true, aiBandOffset[iBand] );
+	}
+	int iBestBand = 0;
+	double dBestBandCost = MAX_DOUBLE;
+	for( int iBand = 0; iBand < NUM_SAO_BO_BANDS; iBand++ )
+	{
+		double dCost = 0;
+		for( int i = 0; i < NUM_SAO_OFFSETS; i++ )
+		{
+			dCost += adBandCost[( iBand + i ) % NUM_SAO_BO_BANDS];
+		}
+		if( dCost < dBestBandCost )
+		{
+			dBestBandCost = dCost;
+			iBestBand = iBand;
+		}
+	}
+	if( dBestBandCost + m_dLambda * 7 < dBestCost )
+	{
+		dBestCost = dBestBandCost + m_dLambda * 7;
+		rcOffset.eType = SAO_TYPE_BO;
+		rcOffset.iTypeAux = iBestBand;
+		for( int i = 0; i < NUM_SAO_OFFSETS; i++ )
+		{
+			rcOffset.aiOffset[i] = aiBandOffset[( iBestBand + i ) % NUM_SAO_BO_BANDS];
+		}
+	}
+	return dBestCost;
+}
+
+/// distortion change of the offsets of a neighbour, for a merge
+double GvcSao::xGetDistortion( const GvcSaoStats& rcStats, ComponentID compID, const GvcSaoOffset& rcOffset ) const
+{
+	const int iShift = xGetBitDepth( compID ) - std::min( xGetBitDepth( compID ), 10 );
+	long long iDist = 0;
+	for( int i = 0; i < NUM_SAO_OFFSETS && rcOffset.eType != SAO_TYPE_OFF; i++ )
+	{
+		const long long iScaled = (long long)rcOffset.aiOffset[i] * ( 1 << iShift );
+		const int iCount = rcOffset.eType == SAO_TYPE_EO ? rcStats.aaiEOCount[rcOffset.iTypeAux][i + 1]
+														 : rcStats.aiBOCount[( rcOffset.iTypeAux + i ) % NUM_SAO_BO_BANDS];
+		const int iDiff = rcOffset.eType == SAO_TYPE_EO ? rcStats.aaiEODiff[rcOffset.iTypeAux][i + 1]
+														: rcStats.aiBODiff[( rcOffset.iTypeAux + i ) % NUM_SAO_BO_BANDS];
+		iDist += iCount * iScaled * iScaled - 2 * iScaled * iDiff;
+	}
+	return (double)iDist;
+}
+
+void GvcSao::getMergeAvail( const GvcFrameUnit* pcFrame, int iBUAddr, bool& rbLeftAvail, bool& rbAboveAvail )
+{
+	const int iWidthInBUs = pcFrame->getFrameWidthInBUs();
+	const int iTileIdx = pcFrame->getTileIdxMap( iBUAddr );
+	rbLeftAvail = iBUAddr % iWidthInBUs > 0 && pcFrame->getTileIdxMap( iBUAddr - 1 ) == iTileIdx;
+	rbAboveAvail = iBUAddr >= iWidthInBUs && pcFrame->getTileIdxMap( iBUAddr - iWidthInBUs ) == iTileIdx;
+}
+
+/** New offsets against the offsets of the left and of the above BU, each merge flag sent costs a bin.
+ */
+void GvcSao::decideBlkParams( const GvcFrameUnit* pcFrame, int iBURow )
+{
+	const int iNumComp = getNumberValidComponents( m_chromaFormat );
+	for( int iBUCol = 0; iBUCol < m_iWidthInBUs; iBUCol++ )
+	{
+		const int iBUAddr = iBURow * m_iWidthInBUs + iBUCol;
+		const GvcSaoStats* pcStats = &m_acStats[iBUCol * MAX_NUM_COMPONENT];
+		bool bLeftAvail, bAboveAvail;
+		getMergeAvail( pcFrame, iBUAddr, bLeftAvail, bAboveAvail );
+
+		GvcSaoBlkParam cBest;
+		cBest.reset();
+		double dBestCost = m_dLambda * ( bLeftAvail + bAboveAvail );
+		for( int comp = 0; comp < iNumComp; comp++ )
+		{
+			dBestCost += xDecideOffset( pcStats[comp], ComponentID( comp ), cBest.acOffset[comp] );
+		}
+
+		for( int iMerge = SAO_MERGE_LEFT; iMerge <= SAO_MERGE_ABOVE; iMerge++ )
+		{
+			if( iMerge == SAO_MERGE_LEFT ? !bLeftAvail : !bAboveAvail )
+			{
+				continue;
+			}
+			const GvcSaoBlkParam& rcCand = m_acBlkParams[iMerge == SAO_MERGE_LEFT ? iBUAddr - 1 : iBUAddr - m_iWidthInBUs];
+			double dCost = m_dLambda * ( iMerge == SAO_MERGE_LEFT ? 1 : bLeftAvail + 1 );
+			for( int comp = 0; comp < iNumComp; comp++ )
+			{
+				dCost += xGetDistortion( pcStats[comp], ComponentID( comp ), rcCand.acOffset[comp] );
+			}
+			if( dCost < dBestCost )
+			{
+				dBestCost = dCost;
+				cBest = rcCand;
+				cBest.eMerge = SaoMergeMode( iMerge );
+			}
+		}
+		m_acBlkParams[iBUAddr] = cBest;
+	}
+}
+
+// ====================================================================================================================
+// Application
+// ====================================================================================================================
+
+void GvcSao::applyRow( GvcFrameUnit* pcFrame, int iBURow )
+{
+	for( unsigned int comp = 0; comp < getNumberValidComponents( m_chromaFormat ); comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		const unsigned int uiScaleX = getComponentScaleX( compID, m_chromaFormat );
+		const unsigned int uiScaleY = getComponentScaleY( compID, m_chromaFormat );
+		const int iCompWidth = m_iWidth >> uiScaleX;
+		const int iCompHeight = m_iHeight >> uiScaleY;
+		const int iY0 = ( iBURow * m_iMaxBUHeight ) >> uiScaleY;
+		const int iHeight = std::min( m_iMaxBUHeight >> uiScaleY, iCompHeight - iY0 );
+		const int iStride = pcFrame->getStride( compID );
+		const int iBufStride = m_aiBufStride[comp];
+		short* pRow = pcFrame->getAddr( compID ) + iY0 * iStride;
+		short* pBuf = &m_asRowBuf[comp][1];
+		short* pLineAbove = &m_asLineAbove[comp][0];
+		const size_t uiLineSize = iCompWidth * sizeof( short );
+
+		bool bAnyOffset = false;
+		for( int iBUCol = 0; iBUCol < m_iWidthInBUs; iBUCol++ )
+		{
+			bAnyOffset |= m_acBlkParams[iBURow * m_iWidthInBUs + iBUCol].acOffset[comp].eType != SAO_TYPE_OFF;
+		}
+		if( !bAnyOffset )
+		{
+			memcpy( pLineAbove, pRow + ( iHeight - 1 ) * iStride, uiLineSize );
+			continue;
+		}
+
+		// deblocked samples around and in the row: line 0 is the line above, line iHeight + 1 the line below
+		memcpy( pBuf, pLineAbove, uiLineSize );
+		for( int y = 0; y < iHeight; y++ )
+		{
+			memcpy( pBuf + ( y + 1 ) * iBufStride, pRow + y * iStride, uiLineSize );
+		}
+		if( iY0 + iHeight < iCompHeight )
+		{
+			memcpy( pBuf + ( iHeight + 1 ) * iBufStride, pRow + iHeight * iStride, uiLineSize );
+		}
+		memcpy( pLineAbove, pBuf + iHeight * iBufStride, uiLineSize );
+
+		const int iShift = xGetBitDepth( compID ) - std::min( xGetBitDepth( compID ), 10 );
+		for( int iBUCol = 0; iBUCol < m_iWidthInBUs; iBUCol++ )
+		{
+			const GvcSaoOffset& rcOffset = m_acBlkParams[iBURow * m_iWidthInBUs + iBUCol].acOffset[comp];
+			const int iX0 = ( iBUCol * m_iMaxBUWidth ) >> uiScaleX;
+			const int iWidth = std::min( m_iMaxBUWidth >> uiScaleX, iCompWidth - iX0 );
+			const short* pSrc = pBuf + iBufStride + iX0;
+			short* pDst = pRow + iX0;
+			if( rcOffset.eType == SAO_TYPE_BO )
+			{
+				int aiBandOffset[NUM_SAO_BO_BANDS] = { 0 };
+				for( int i = 0; i < NUM_SAO_OFFSETS; i++ )
+				{
+					aiBandOffset[( rcOffset.iTypeAux + i ) % NUM_SAO_BO_BANDS] = rcOffset.aiOffset[i] * ( 1 << iShift );
+				}
+				g_gvcPrimitives.saoApplyBO( pSrc, iBufStride, pDst, iStride, iWidth, iHeight, aiBandOffset, xGetBitDepth( compID ) );
+			}
+			else if( rcOffset.eType == SAO_TYPE_EO )
+			{
+				int aiOffset[NUM_SAO_EO_CATEGORIES] = { 0 };
+				for( int i = 0; i < NUM_SAO_OFFSETS; i++ )
+				{
+					aiOffset[i + 1] = rcOffset.aiOffset[i] * ( 1 << iShift );
+				}
+				// the samples on the frame boundary that lack a neighbour keep their value
+				const bool bHor = rcOffset.iTypeAux != SAO_EO_90;
+				const bool bVer = rcOffset.iTypeAux != SAO_EO_0;
+				const int iStartX = bHor && iX0 == 0 ? 1 : 0;
+				const int iEndX = bHor && iX0 + iWidth == iCompWidth ? iWidth - 1 : iWidth;
+				const int iStartY = bVer && iY0 == 0 ? 1 : 0;
+				const int iEndY = bVer && iY0 + iHeight == iCompHeight ? iHeight - 1 : iHeight;
+				if( iEndX <= iStartX || iEndY <= iStartY )
+				{
+					continue;
+				}
+				g_gvcPrimitives.saoApplyEO[rcOffset.iTypeAux]( pSrc + iStartY * iBufStride + iStartX, iBufStride, pDst + iStartY * iStride + iStartX, iStride,
+															   iEndX - iStartX, iEndY - iStartY, aiOffset, xGetBitDepth( compID ) );
+			}
+		}
+	}
+}
@@ -0,0 +1,154 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcSao.h
+ * \brief    Sample adaptive offset of the deblocked reconstruction (header)
+ */
+
+#ifndef __GVCSAO_H__
+#define __GVCSAO_H__
+
+#include <algorithm>
+#include <vector>
+
+#include "TypeDef.h"
+#include "GvcPrimitives.h"
+#include "TComChromaFormat.h"
+
+class GvcFrameUnit;
+
+#define NUM_SAO_OFFSETS               4       ///< offsets of a component: edge categories 1 to 4, or four consecutive bands
+
+/// sao_type_idx
+enum SaoTypeIdx
+{
+	SAO_TYPE_OFF = 0,
+	SAO_TYPE_BO = 1,  ///< band offset
+	SAO_TYPE_EO = 2,  ///< edge offset
+};
+
+/// a BU either signals its own offsets or takes all of them from a neighbour
+enum SaoMergeMode
+{
+	SAO_MERGE_NONE = 0,
+	SAO_MERGE_LEFT,
+	SAO_MERGE_ABOVE,
+};
+
+/**
+ * \struct   GvcSaoOffset
+ * \brief    Offsets of one component of a BU
+ */
+struct GvcSaoOffset
+{
+	SaoTypeIdx eType;
+	int iTypeAux;                     ///< edge class (GvcSaoEOClass) or first band
+	int aiOffset[NUM_SAO_OFFSETS];  ///< edge offsets are positive for the categories 1 and 2, negative for 3 and 4
+
+	void reset();
+};
+
+/**
+ * \struct   GvcSaoBlkParam
+ * \brief    Offsets of every component of a BU
+ */
+struct GvcSaoBlkParam
+{
+	SaoMergeMode eMerge;
+	GvcSaoOffset acOffset[MAX_NUM_COMPONENT];
+
+	void reset();
+};
+
+/**
+ * \struct   GvcSaoStats
+ * \brief    Sums of original - reconstruction and sample counts of one component of a BU, per class
+ */
+struct GvcSaoStats
+{
+	int aaiEODiff[NUM_SAO_EO_CLASSES][NUM_SAO_EO_CATEGORIES];
+	int aaiEOCount[NUM_SAO_EO_CLASSES][NUM_SAO_EO_CATEGORIES];
+	int aiBODiff[NUM_SAO_BO_BANDS];
+	int aiBOCount[NUM_SAO_BO_BANDS];
+
+	void reset();
+};
+
+/**
+ * \class    GvcSao
+ * \brief    Per BU band or edge offsets, decided by the encoder and added to the deblocked frame BU row by BU row
+ *
+ * The encoder collects the statistics of a BU row from its samples before deblocking, as soon as the row is coded:
+ * the edge classes that compare with the line below skip the bottom line of the row, whose neighbours are not coded
+ * yet. The offsets of the row are decided right away with a rate estimate that counts the bins of the syntax.
+ * The offsets are added once the row and the top of the next one are deblocked; the deblocked samples of the row and
+ * of the lines around it are copied first, so that every sample is classified from deblocked neighbours only.
+ */
+class GvcSao
+{
+	ChromaFormat m_chromaFormat;
+	int m_aiBitDepth[MAX_NUM_CHANNEL_TYPE];
+	int m_iWidth;
+	int m_iHeight;
+	int m_iMaxBUWidth;
+	int m_iMaxBUHeight;
+	int m_iWidthInBUs;
+	int m_iHeightInBUs;
+	std::vector<GvcSaoBlkParam> m_acBlkParams;  ///< per BU, in raster order
+	// encoder
+	double m_dLambda;
+	std::vector<GvcSaoStats> m_acStats;  ///< per BU of the row being decided and component
+	// application
+	int m_aiBufStride[MAX_NUM_COMPONENT];
+	std::vector<short> m_asRowBuf[MAX_NUM_COMPONENT];     ///< deblocked BU row between the line above and the line below it
+	std::vector<short> m_asLineAbove[MAX_NUM_COMPONENT];  ///< deblocked bottom line of the previous BU row
+
+  public:
+	GvcSao();
+	virtual ~GvcSao();
+
+	void create( int iWidth, int iHeight, ChromaFormat chromaFormat, int iMaxBUWidth, int iMaxBUHeight, const int* piBitDepth );
+	void destroy();
+
+	GvcSaoBlkParam& getBlkParam( int iBUAddr ) { return m_acBlkParams[iBUAddr]; }
+	const GvcSaoBlkParam& getBlkParam( int iBUAddr ) const { return m_acBlkParams[iBUAddr]; }
+	/// largest offset magnitude for a bit depth
+	static int getMaxOffset( int iBitDepth ) { return ( 1 << ( std::min( iBitDepth, 10 ) - 5 ) ) - 1; }
+	/// a BU merges with the offsets of its left or above neighbour only within its tile
+	static void getMergeAvail( const GvcFrameUnit* pcFrame, int iBUAddr, bool& rbLeftAvail, bool& rbAboveAvail );
+
+	// encoder
+	void setLambda( double dLambda ) { m_dLambda = dLambda; }
+	/// statistics of the BU row, taken before it is deblocked
+	void getStatistics( const GvcFrameUnit* pcFrameOrg, const GvcFrameUnit* pcFrameRec, int iBURow );
+	/// offsets of the BUs of the row from its statistics, the rows above are decided already
+	void decideBlkParams( const GvcFrameUnit* pcFrame, int iBURow );
+
+	/// adds the offsets to the BU row, once it and the first line of the next row are deblocked
+	void applyRow( GvcFrameUnit* pcFrame, int iBURow );
+
+  private:
+	int xGetBitDepth( ComponentID compID ) const { return m_aiBitDepth[toChannelType( compID )]; }
+	double xGetOffsetCost( int iCount, int iDiff, int iMinOffset, int iMaxOffset, int iShift, bool bSign, int& riOffset ) const;
+	double xDecideOffset( const GvcSaoStats& rcStats, ComponentID compID, GvcSaoOffset& rcOffset ) const;
+	double xGetDistortion( const GvcSaoStats& rcStats, ComponentID compID, const GvcSaoOffset& rcOffset ) const;
+};
+
+#endif  // __GVCSAO_H__
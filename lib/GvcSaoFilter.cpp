@@ -0,0 +1,123 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcSaoFilter.cpp
+ * \brief    Reference C++ implementation of the sample adaptive offset classification kernels
+ */
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+/// edge category of 2 + sign( c - a ) + sign( c - b )
+const int s_aiEdgeCategory[5] = { 1, 2, 0, 3, 4 };
+
+inline int sign( int x )
+{
+	return ( x > 0 ) - ( x < 0 );
+}
+
+/// distance in samples from a sample to its first neighbour of the edge class, the second one is on the opposite side
+template<int iClass>
+inline int neighbourOffset( int iStride )
+{
+	return iClass == SAO_EO_0 ? 1 : iClass == SAO_EO_90 ? iStride : iClass == SAO_EO_135 ? iStride + 1 : iStride - 1;
+}
+
+template<int iClass>
+void saoStatsEO_c( const short* pRec, int iRecStride, const short* pOrg, int iOrgStride, int iWidth, int iHeight, int* piDiff, int* piCount )
+{
+	const int iOffset = neighbourOffset<iClass>( iRecStride );
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth; x++ )
+		{
+			const int c = pRec[x];
+			const int iCategory = s_aiEdgeCategory[2 + sign( c - pRec[x - iOffset] ) + sign( c - pRec[x + iOffset] )];
+			piDiff[iCategory] += pOrg[x] - c;
+			piCount[iCategory]++;
+		}
+		pRec += iRecStride;
+		pOrg += iOrgStride;
+	}
+}
+
+void saoStatsBO_c( const short* pRec, int iRecStride, const short* pOrg, int iOrgStride, int iWidth, int iHeight, int iShift, int* piDiff, int* piCount )
+{
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth; x++ )
+		{
+			const int iBand = pRec[x] >> iShift;
+			piDiff[iBand] += pOrg[x] - pRec[x];
+			piCount[iBand]++;
+		}
+		pRec += iRecStride;
+		pOrg += iOrgStride;
+	}
+}
+
+template<int iClass>
+void saoApplyEO_c( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, const int* piOffset, int iBitDepth )
+{
+	const int iOffset = neighbourOffset<iClass>( iSrcStride );
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth; x++ )
+		{
+			const int c = pSrc[x];
+			const int iCategory = s_aiEdgeCategory[2 + sign( c - pSrc[x - iOffset] ) + sign( c - pSrc[x + iOffset] )];
+			pDst[x] = (short)Clip3( 0, iMaxVal, c + piOffset[iCategory] );
+		}
+		pSrc += iSrcStride;
+		pDst += iDstStride;
+	}
+}
+
+void saoApplyBO_c( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, const int* piBandOffset, int iBitDepth )
+{
+	const int iShift = iBitDepth - 5;
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth; x++ )
+		{
+			pDst[x] = (short)Clip3( 0, iMaxVal, pSrc[x] + piBandOffset[pSrc[x] >> iShift] );
+		}
+		pSrc += iSrcStride;
+		pDst += iDstStride;
+	}
+}
+}  // namespace
+
+void setupSaoPrimitivesC( GvcPrimitives& p )
+{
+	p.saoStatsEO[SAO_EO_0] = saoStatsEO_c<SAO_EO_0>;
+	p.saoStatsEO[SAO_EO_90] = saoStatsEO_c<SAO_EO_90>;
+	p.saoStatsEO[SAO_EO_135] = saoStatsEO_c<SAO_EO_135>;
+	p.saoStatsEO[SAO_EO_45] = saoStatsEO_c<SAO_EO_45>;
+	p.saoStatsBO = saoStatsBO_c;
+	p.saoApplyEO[SAO_EO_0] = saoApplyEO_c<SAO_EO_0>;
+	p.saoApplyEO[SAO_EO_90] = saoApplyEO_c<SAO_EO_90>;
+	p.saoApplyEO[SAO_EO_135] = saoApplyEO_c<SAO_EO_135>;
+	p.saoApplyEO[SAO_EO_45] = saoApplyEO_c<SAO_EO_45>;
+	p.saoApplyBO = saoApplyBO_c;
+}
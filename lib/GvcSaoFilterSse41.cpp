@@ -0,0 +1,224 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcSaoFilterSse41.cpp
+ * \brief    SSE4.1 implementation of the sample adaptive offset classification kernels
+ *
+ * Eight samples are classified at a time from the signs of their differences with the two neighbours, the
+ * columns left over at the right of the area go through the scalar code.
+ */
+
+#include <smmintrin.h>
+
+#include "GvcPrimitives.h"
+
+namespace
+{
+/// edge category of 2 + sign( c - a ) + sign( c - b )
+const int s_aiEdgeCategory[5] = { 1, 2, 0, 3, 4 };
+/// sign sum of each of the categories 1 to 4
+const short s_asCategorySignSum[4] = { -2, -1, 1, 2 };
+
+inline int sign( int x )
+{
+	return ( x > 0 ) - ( x < 0 );
+}
+
+template<int iClass>
+inline int neighbourOffset( int iStride )
+{
+	return iClass == SAO_EO_0 ? 1 : iClass == SAO_EO_90 ? iStride : iClass == SAO_EO_135 ? iStride + 1 : iStride - 1;
+}
+
+/// sign( c - a ) + sign( c - b ) of 8 samples
+inline __m128i signSum( __m128i vC, __m128i vA, __m128i vB )
+{
+	const __m128i vSignA = _mm_sub_epi16( _mm_cmpgt_epi16( vA, vC ), _mm_cmpgt_epi16( vC, vA ) );
+	const __m128i vSignB = _mm_sub_epi16( _mm_cmpgt_epi16( vB, vC ), _mm_cmpgt_epi16( vC, vB ) );
+	return _mm_add_epi16( vSignA, vSignB );
+}
+
+inline int horizontalSum( __m128i v )
+{
+	v = _mm_add_epi32( v, _mm_shuffle_epi32( v, 0x4e ) );
+	v = _mm_add_epi32( v, _mm_shuffle_epi32( v, 0xb1 ) );
+	return _mm_cvtsi128_si32( v );
+}
+
+template<int iClass>
+void saoStatsEO_sse41( const short* pRec, int iRecStride, const short* pOrg, int iOrgStride, int iWidth, int iHeight, int* piDiff, int* piCount )
+{
+	const int iOffset = neighbourOffset<iClass>( iRecStride );
+	const int iWidth8 = iWidth & ~7;
+	const __m128i vOne = _mm_set1_epi16( 1 );
+	__m128i vDiffAll = _mm_setzero_si128();
+	__m128i avDiff[4];
+	__m128i avCount[4];
+	__m128i avSignSum[4];
+	for( int k = 0; k < 4; k++ )
+	{
+		avDiff[k] = _mm_setzero_si128();
+		avCount[k] = _mm_setzero_si128();
+		avSignSum[k] = _mm_set1_epi16( s_asCategorySignSum[k] );
+	}
+
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth8; x += 8 )
+		{
+			const __m128i vC = _mm_loadu_si128( (const __m128i*)( pRec + x ) );
+			const __m128i vA = _mm_loadu_si128( (const __m128i*)( pRec + x - iOffset ) );
+			const __m128i vB = _mm_loadu_si128( (const __m128i*)( pRec + x + iOffset ) );
+			const __m128i vSum = signSum( vC, vA, vB );
+			const __m128i vDiff = _mm_sub_epi16( _mm_loadu_si128( (const __m128i*)( pOrg + x ) ), vC );
+			vDiffAll = _mm_add_epi32( vDiffAll, _mm_madd_epi16( vDiff, vOne ) );
+			for( int k = 0; k < 4; k++ )
+			{
+				const __m128i vMask = _mm_cmpeq_epi16( vSum, avSignSum[k] );
+				avDiff[k] = _mm_add_epi32( avDiff[k], _mm_madd_epi16( _mm_and_si128( vMask, vDiff ), vOne ) );
+				avCount[k] = _mm_sub_epi32( avCount[k], _mm_madd_epi16( vMask, vOne ) );
+			}
+		}
+		for( int x = iWidth8; x < iWidth; x++ )
+		{
+			const int c = pRec[x];
+			const int iCategory = s_aiEdgeCategory[2 + sign( c - pRec[x - iOffset] ) + sign( c - pRec[x + iOffset] )];
+			piDiff[iCategory] += pOrg[x] - c;
+			piCount[iCategory]++;
+		}
+		pRec += iRecStride;
+		pOrg += iOrgStride;
+	}
+
+	// the samples of category 0 are the ones left
+	int iDiffRest = horizontalSum( vDiffAll );
+	int iCountRest = iWidth8 * iHeight;
+	for( int k = 0; k < 4; k++ )
+	{
+		const int iDiff = horizontalSum( avDiff[k] );
+		const int iCount = horizontalSum( avCount[k] );
+		piDiff[k + 1] += iDiff;
+		piCount[k + 1] += iCount;
+		iDiffRest -= iDiff;
+		iCountRest -= iCount;
+	}
+	piDiff[0] += iDiffRest;
+	piCount[0] += iCountRest;
+}
+
+template<int iClass>
+void saoApplyEO_sse41( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, const int* piOffset, int iBitDepth )
+{
+	const int iOffset = neighbourOffset<iClass>( iSrcStride );
+	const int iWidth8 = iWidth & ~7;
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	const __m128i vMaxVal = _mm_set1_epi16( (short)iMaxVal );
+	const __m128i vZero = _mm_setzero_si128();
+	__m128i avSignSum[4];
+	__m128i avOffset[4];
+	for( int k = 0; k < 4; k++ )
+	{
+		avSignSum[k] = _mm_set1_epi16( s_asCategorySignSum[k] );
+		avOffset[k] = _mm_set1_epi16( (short)piOffset[k + 1] );
+	}
+
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth8; x += 8 )
+		{
+			const __m128i vC = _mm_loadu_si128( (const __m128i*)( pSrc + x ) );
+			const __m128i vA = _mm_loadu_si128( (const __m128i*)( pSrc + x - iOffset ) );
+			const __m128i vB = _mm_loadu_si128( (const __m128i*)( pSrc + x + iOffset ) );
+			const __m128i vSum = signSum( vC, vA, vB );
+			__m128i vOffset = _mm_setzero_si128();
+			for( int k = 0; k < 4; k++ )
+			{
+				vOffset = _mm_or_si128( vOffset, _mm_and_si128( _mm_cmpeq_epi16( vSum, avSignSum[k] ), avOffset[k] ) );
+			}
+			const __m128i vRes = _mm_min_epi16( _mm_max_epi16( _mm_add_epi16( vC, vOffset ), vZero ), vMaxVal );
+			_mm_storeu_si128( (__m128i*)( pDst + x ), vRes );
+		}
+		for( int x = iWidth8; x < iWidth; x++ )
+		{
+			const int c = pSrc[x];
+			const int iCategory = s_aiEdgeCategory[2 + sign( c - pSrc[x - iOffset] ) + sign( c - pSrc[x + iOffset] )];
+			pDst[x] = (short)Clip3( 0, iMaxVal, c + piOffset[iCategory] );
+		}
+		pSrc += iSrcStride;
+		pDst += iDstStride;
+	}
+}
+
+/** The 32 band offsets fit in bytes (at most 31 in magnitude), the two halves of the table are looked up with a
+ *  byte shuffle each and the half is selected by the top bit of the band.
+ */
+void saoApplyBO_sse41( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iWidth, int iHeight, const int* piBandOffset, int iBitDepth )
+{
+	const int iShift = iBitDepth - 5;
+	const int iWidth8 = iWidth & ~7;
+	const int iMaxVal = ( 1 << iBitDepth ) - 1;
+	const __m128i vMaxVal = _mm_set1_epi16( (short)iMaxVal );
+	const __m128i vZero = _mm_setzero_si128();
+	const __m128i vShift = _mm_cvtsi32_si128( iShift );
+	const __m128i vFifteen = _mm_set1_epi8( 15 );
+	const __m128i vSixteen = _mm_set1_epi8( 16 );
+	signed char acTable[NUM_SAO_BO_BANDS];
+	for( int i = 0; i < NUM_SAO_BO_BANDS; i++ )
+	{
+		acTable[i] = (signed char)piBandOffset[i];
+	}
+	const __m128i vTableLo = _mm_loadu_si128( (const __m128i*)acTable );
+	const __m128i vTableHi = _mm_loadu_si128( (const __m128i*)( acTable + 16 ) );
+
+	for( int y = 0; y < iHeight; y++ )
+	{
+		for( int x = 0; x < iWidth8; x += 8 )
+		{
+			const __m128i vC = _mm_loadu_si128( (const __m128i*)( pSrc + x ) );
+			const __m128i vBand = _mm_packus_epi16( _mm_srl_epi16( vC, vShift ), vZero );
+			const __m128i vIdx = _mm_and_si128( vBand, vFifteen );
+			const __m128i vHigh = _mm_cmpeq_epi8( _mm_and_si128( vBand, vSixteen ), vSixteen );
+			const __m128i vOffset8 = _mm_blendv_epi8( _mm_shuffle_epi8( vTableLo, vIdx ), _mm_shuffle_epi8( vTableHi, vIdx ), vHigh );
+			const __m128i vOffset = _mm_cvtepi8_epi16( vOffset8 );
+			const __m128i vRes = _mm_min_epi16( _mm_max_epi16( _mm_add_epi16( vC, vOffset ), vZero ), vMaxVal );
+			_mm_storeu_si128( (__m128i*)( pDst + x ), vRes );
+		}
+		for( int x = iWidth8; x < iWidth; x++ )
+		{
+			pDst[x] = (short)Clip3( 0, iMaxVal, pSrc[x] + piBandOffset[pSrc[x] >> iShift] );
+		}
+		pSrc += iSrcStride;
+		pDst += iDstStride;
+	}
+}
+}  // namespace
+
+void setupSaoPrimitivesSse41( GvcPrimitives& p )
+{
+	p.saoStatsEO[SAO_EO_0] = saoStatsEO_sse41<SAO_EO_0>;
+	p.saoStatsEO[SAO_EO_90] = saoStatsEO_sse41<SAO_EO_90>;
+	p.saoStatsEO[SAO_EO_135] = saoStatsEO_sse41<SAO_EO_135>;
+	p.saoStatsEO[SAO_EO_45] = saoStatsEO_sse41<SAO_EO_45>;
+	p.saoApplyEO[SAO_EO_0] = saoApplyEO_sse41<SAO_EO_0>;
+	p.saoApplyEO[SAO_EO_90] = saoApplyEO_sse41<SAO_EO_90>;
+	p.saoApplyEO[SAO_EO_135] = saoApplyEO_sse41<SAO_EO_135>;
+	p.saoApplyEO[SAO_EO_45] = saoApplyEO_sse41<SAO_EO_45>;
+	p.saoApplyBO = saoApplyBO_sse41;
+}
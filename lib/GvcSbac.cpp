@@ -0,0 +1,534 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcSbac.cpp
+ * \brief    Context adaptive coding of the syntax elements of the block units
+ */
+
+#include "GvcSbac.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "GvcBlockUnit.h"
+#include "GvcRom.h"
+#include "GvcSao.h"
+#include "GvcTrQuant.h"
+#include "TComChromaFormat.h"
+
+// ====================================================================================================================
+// Context models
+// ====================================================================================================================
+
+template <int N>
+static inline void initContexts( GvcContextModel ( &acCtx )[N], const unsigned char* pucInitValue, int iQp )
+{
+	for( int i = 0; i < N; i++ )
+	{
+		acCtx[i].init( iQp, pucInitValue[i] );
+	}
+}
+
+void GvcSbacContexts::init( FrameType eFrameType, int iQp )
+{
+	initContexts( acSplitFlag, INIT_SPLIT_FLAG[eFrameType], iQp );
+	initContexts( acPredMode, INIT_PRED_MODE[eFrameType], iQp );
+	initContexts( acIntraPred, INIT_INTRA_PRED_MODE[eFrameType], iQp );
+	initContexts( acChromaPred, INIT_CHROMA_PRED_MODE[eFrameType], iQp );
+	initContexts( acMvd, INIT_MVD[eFrameType], iQp );
+	initContexts( acSaoMergeFlag, INIT_SAO_MERGE_FLAG[eFrameType], iQp );
+	initContexts( acSaoTypeIdx, INIT_SAO_TYPE_IDX[eFrameType], iQp );
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		initContexts( acQtCbf[ch], INIT_QT_CBF[eFrameType][ch], iQp );
+		initContexts( acSigCoeffGroup[ch], INIT_SIG_CG_FLAG[eFrameType][ch], iQp );
+		initContexts( acSig[ch], INIT_SIG_FLAG[eFrameType][ch], iQp );
+		initContexts( acLastX[ch], INIT_LAST[eFrameType][ch], iQp );
+		initContexts( acLastY[ch], INIT_LAST[eFrameType][ch], iQp );
+		initContexts( acOneFlag[ch], INIT_ONE_FLAG[eFrameType][ch], iQp );
+		initContexts( acAbsFlag[ch], INIT_ABS_FLAG[eFrameType][ch], iQp );
+	}
+}
+
+// ====================================================================================================================
+// Constructor / destructor
+// ====================================================================================================================
+
+GvcSbac::GvcSbac()
+	: m_pcBinIf( NULL )
+{
+}
+
+GvcSbac::~GvcSbac()
+{
+}
+
+void GvcSbac::resetEntropy( FrameType eFrameType, int iQp )
+{
+	m_cCtx.init( eFrameType, iQp );
+}
+
+// ====================================================================================================================
+// Rate estimates
+// ====================================================================================================================
+
+template <int N>
+static inline void setEstBits( int ( *paiBits )[2], const GvcContextModel ( &acCtx )[N] )
+{
+	for( int i = 0; i < N; i++ )
+	{
+		paiBits[i][0] = acCtx[i].getEntropyBits( 0 );
+		paiBits[i][1] = acCtx[i].getEntropyBits( 1 );
+	}
+}
+
+void GvcSbac::estBits( GvcEstBitsSbac& rcEstBits ) const
+{
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		setEstBits( rcEstBits.blockCbpBits[ch], m_cCtx.acQtCbf[ch] );
+		setEstBits( rcEstBits.significantCoeffGroupBits[ch], m_cCtx.acSigCoeffGroup[ch] );
+		setEstBits( rcEstBits.significantBits[ch], m_cCtx.acSig[ch] );
+		setEstBits( rcEstBits.lastXBits[ch], m_cCtx.acLastX[ch] );
+		setEstBits( rcEstBits.lastYBits[ch], m_cCtx.acLastY[ch] );
+		setEstBits( rcEstBits.greaterOneBits[ch], m_cCtx.acOneFlag[ch] );
+		setEstBits( rcEstBits.levelAbsBits[ch], m_cCtx.acAbsFlag[ch] );
+	}
+}
+
+// ====================================================================================================================
+// Block unit syntax
+// ====================================================================================================================
+
+/** The context counts the left and above coding units that are split deeper than uiDepth.
+ */
+void GvcSbac::codeSplitFlag( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth )
+{
+	unsigned int uiTempPartIdx = 0;
+	unsigned int uiCtx = 0;
+	GvcBlockUnit* pcBULeft = pcBU->getPULeft( uiTempPartIdx, uiAbsPartIdx );
+	uiCtx += pcBULeft && pcBULeft->getDepth( uiTempPartIdx ) > uiDepth;
+	GvcBlockUnit* pcBUAbove = pcBU->getPUAbove( uiTempPartIdx, uiAbsPartIdx );
+	uiCtx += pcBUAbove && pcBUAbove->getDepth( uiTempPartIdx ) > uiDepth;
+	m_pcBinIf->encodeBin( pcBU->getDepth( uiAbsPartIdx ) > uiDepth, m_cCtx.acSplitFlag[uiCtx] );
+}
+
+void GvcSbac::codePredMode( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx )
+{
+	m_pcBinIf->encodeBin( pcBU->getPredictionMode( uiAbsPartIdx ) == MODE_INTRA, m_cCtx.acPredMode[0] );
+}
+
+/** A most probable mode is sent as a flag and a truncated unary index, any other mode as its rank
+ *  among the 32 remaining modes in 5 bypass bins.
+ */
+void GvcSbac::codeIntraDirLumaAng( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx )
+{
+	unsigned int uiDir = pcBU->getIntraDir( CHANNEL_TYPE_LUMA, uiAbsPartIdx );
+	int aiPreds[NUM_MOST_PROBABLE_MODES];
+	pcBU->getIntraDirPredictor( uiAbsPartIdx, aiPreds );
+	int iPredIdx = -1;
+	for( int i = 0; i < NUM_MOST_PROBABLE_MODES; i++ )
+	{
+		if( (unsigned int)aiPreds[i] == uiDir )
+		{
+			iPredIdx = i;
+		}
+	}
+	m_pcBinIf->encodeBin( iPredIdx != -1, m_cCtx.acIntraPred[0] );
+	if( iPredIdx != -1 )
+	{
+		m_pcBinIf->encodeBinsEP( iPredIdx ? 2 + iPredIdx - 1 : 0, iPredIdx ? 2 : 1 );
+		return;
+	}
+	std::sort( aiPreds, aiPreds + NUM_MOST_PROBABLE_MODES );
+	for( int i = NUM_MOST_PROBABLE_MODES - 1; i >= 0; i-- )
+	{
+		uiDir = uiDir > (unsigned int)aiPreds[i] ? uiDir - 1 : uiDir;
+	}
+	m_pcBinIf->encodeBinsEP( uiDir, 5 );
+}
+
+void GvcSbac::codeIntraDirChroma( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx )
+{
+	const unsigned int uiDir = pcBU->getIntraDir( CHANNEL_TYPE_CHROMA, uiAbsPartIdx );
+	if( uiDir == (unsigned int)DM_CHROMA_IDX )
+	{
+		m_pcBinIf->encodeBin( 0, m_cCtx.acChromaPred[0] );
+		return;
+	}
+	unsigned int auiModeList[NUM_CHROMA_MODE - 1];
+	getAllowedChromaDir( pcBU->getIntraDir( CHANNEL_TYPE_LUMA, uiAbsPartIdx ), auiModeList );
+	unsigned int uiIdx = 0;
+	while( uiIdx < NUM_CHROMA_MODE - 2 && auiModeList[uiIdx] != uiDir )
+	{
+		uiIdx++;
+	}
+	m_pcBinIf->encodeBin( 1, m_cCtx.acChromaPred[0] );
+	m_pcBinIf->encodeBinsEP( uiIdx, 2 );
+}
+
+void GvcSbac::getAllowedChromaDir( unsigned int uiLumaDir, unsigned int* puiModeList )
+{
+	puiModeList[0] = PLANAR_IDX;
+	puiModeList[1] = VER_IDX;
+	puiModeList[2] = HOR_IDX;
+	puiModeList[3] = DC_IDX;
+	for( int i = 0; i < NUM_CHROMA_MODE - 1; i++ )
+	{
+		if( puiModeList[i] == uiLumaDir )
+		{
+			puiModeList[i] = VDIA_IDX;
+		}
+	}
+}
+
+/** Greater than 0 flags of both components, greater than 1 flags, then per component the rest of the
+ *  magnitude in first order Exp-Golomb and the sign.
+ */
+void GvcSbac::codeMvd( const GvcMv& rcMvd )
+{
+	const int iHor = rcMvd.getHor();
+	const int iVer = rcMvd.getVer();
+	const unsigned int uiHorAbs = abs( iHor );
+	const unsigned int uiVerAbs = abs( iVer );
+
+	m_pcBinIf->encodeBin( uiHorAbs > 0, m_cCtx.acMvd[0] );
+	m_pcBinIf->encodeBin( uiVerAbs > 0, m_cCtx.acMvd[0] );
+	if( uiHorAbs )
+	{
+		m_pcBinIf->encodeBin( uiHorAbs > 1, m_cCtx.acMvd[1] );
+	}
+	if( uiVerAbs )
+	{
+		m_pcBinIf->encodeBin( uiVerAbs > 1, m_cCtx.acMvd[1] );
+	}
+	if( uiHorAbs )
+	{
+		if( uiHorAbs > 1 )
+		{
+			xWriteEpExGolomb( uiHorAbs - 2, 1 );
+		}
+		m_pcBinIf->encodeBinEP( iHor < 0 );
+	}
+	if( uiVerAbs )
+	{
+		if( uiVerAbs > 1 )
+		{
+			xWriteEpExGolomb( uiVerAbs - 2, 1 );
+		}
+		m_pcBinIf->encodeBinEP( iVer < 0 );
+	}
+}
+
+/** The offsets of each component are sent on their own, luma and chroma alike. The type is a truncated unary code
+ *  with the first bin context coded, the offset magnitudes truncated unary codes in bypass bins.
+ */
+void GvcSbac::codeSaoBlkParam( const GvcSaoBlkParam& rcParam, bool bLeftAvail, bool bAboveAvail, ChromaFormat chromaFormat, const int* piBitDepth )
+{
+	if( bLeftAvail )
+	{
+		m_pcBinIf->encodeBin( rcParam.eMerge == SAO_MERGE_LEFT, m_cCtx.acSaoMergeFlag[0] );
+	}
+	if( bAboveAvail && rcParam.eMerge != SAO_MERGE_LEFT )
+	{
+		m_pcBinIf->encodeBin( rcParam.eMerge == SAO_MERGE_ABOVE, m_cCtx.acSaoMergeFlag[0] );
+	}
+	if( rcParam.eMerge != SAO_MERGE_NONE )
+	{
+		return;
+	}
+	for( unsigned int comp = 0; comp < getNumberValidComponents( chromaFormat ); comp++ )
+	{
+		const GvcSaoOffset& rcOffset = rcParam.acOffset[comp];
+		m_pcBinIf->encodeBin( rcOffset.eType != SAO_TYPE_OFF, m_cCtx.acSaoTypeIdx[0] );
+		if( rcOffset.eType == SAO_TYPE_OFF )
+		{
+			continue;
+		}
+		m_pcBinIf->encodeBinEP( rcOffset.eType == SAO_TYPE_EO );
+		const int iMaxOffset = GvcSao::getMaxOffset( piBitDepth[toChannelType( ComponentID( comp ) )] );
+		for( int i = 0; i < NUM_SAO_OFFSETS; i++ )
+		{
+			const int iAbs = abs( rcOffset.aiOffset[i] );
+			if( iAbs < iMaxOffset )
+			{
+				m_pcBinIf->encodeBinsEP( ( ( 1u << iAbs ) - 1 ) << 1, iAbs + 1 );
+			}
+			else
+			{
+				m_pcBinIf->encodeBinsEP( ( 1u << iMaxOffset ) - 1, iMaxOffset );
+			}
+		}
+		if( rcOffset.eType == SAO_TYPE_BO )
+		{
+			for( int i = 0; i < NUM_SAO_OFFSETS; i++ )
+			{
+				if( rcOffset.aiOffset[i] )
+				{
+					m_pcBinIf->encodeBinEP( rcOffset.aiOffset[i] < 0 );
+				}
+			}
+			m_pcBinIf->encodeBinsEP( rcOffset.iTypeAux, 5 );
+		}
+		else
+		{
+			m_pcBinIf->encodeBinsEP( rcOffset.iTypeAux, 2 );
+		}
+	}
+}
+
+// ====================================================================================================================
+// Residual syntax
+// ====================================================================================================================
+
+void GvcSbac::codeCoeffNxN( const TCoeff* pcCoef, const ComponentID compID, unsigned int uiSize, COEFF_SCAN_TYPE eScanIdx )
+{
+	const ChannelType chType = toChannelType( compID );
+	const bool bLuma = isLuma( chType );
+	const unsigned int uiLog2Size = g_aucConvertToBit[uiSize] + 2;
+	const unsigned short* puiScan = g_auiScanOrder[eScanIdx][uiLog2Size - MIN_LOG2_TU_SIZE];
+	const int iLog2Groups = uiLog2Size - 2;
+	const unsigned int uiSizeMask = uiSize - 1;
+
+	int iLastScanPos = uiSize * uiSize - 1;
+	while( iLastScanPos >= 0 && !pcCoef[puiScan[iLastScanPos]] )
+	{
+		iLastScanPos--;
+	}
+	m_pcBinIf->encodeBin( iLastScanPos >= 0, m_cCtx.acQtCbf[chType][0] );
+	if( iLastScanPos < 0 )
+	{
+		return;
+	}
+	xCodeLastSignificantXY( puiScan[iLastScanPos] & uiSizeMask, puiScan[iLastScanPos] >> uiLog2Size, uiLog2Size, chType, eScanIdx );
+
+	bool abSigGroup[64];
+	memset( abSigGroup, 0, sizeof( abSigGroup ) );
+	const int iGroupLastScanPos = iLastScanPos >> 4;
+	unsigned int c1 = 1;
+	for( int iGroupScanPos = iGroupLastScanPos; iGroupScanPos >= 0; iGroupScanPos-- )
+	{
+		const unsigned int uiGroupX = ( puiScan[iGroupScanPos << 4] & uiSizeMask ) >> 2;
+		const unsigned int uiGroupY = ( puiScan[iGroupScanPos << 4] >> uiLog2Size ) >> 2;
+		const int iGroupPos = ( uiGroupY << iLog2Groups ) + uiGroupX;
+		const unsigned int uiSigRight = uiGroupX + 1 < ( 1u << iLog2Groups ) ? abSigGroup[iGroupPos + 1] : 0;
+		const unsigned int uiSigLower = uiGroupY + 1 < ( 1u << iLog2Groups ) ? abSigGroup[iGroupPos + ( 1 << iLog2Groups )] : 0;
+		const int iPatternSigCtx = uiSigRight + ( uiSigLower << 1 );
+
+		// the group flag of the last group and of the DC group is inferred
+		if( iGroupScanPos > 0 && iGroupScanPos < iGroupLastScanPos )
+		{
+			bool bNonZero = false;
+			for( int iScanPos = iGroupScanPos << 4; iScanPos < ( iGroupScanPos + 1 ) << 4 && !bNonZero; iScanPos++ )
+			{
+				bNonZero = pcCoef[puiScan[iScanPos]] != 0;
+			}
+			m_pcBinIf->encodeBin( bNonZero, m_cCtx.acSigCoeffGroup[chType][std::min<unsigned int>( uiSigRight + uiSigLower, 1 )] );
+			if( !bNonZero )
+			{
+				continue;
+			}
+		}
+
+		// significance, collecting the magnitudes and signs in coding order
+		unsigned int auiAbsCoeff[16];
+		unsigned int uiNumNonZero = 0;
+		unsigned int uiSigns = 0;
+		for( int iScanPosInGroup = 15; iScanPosInGroup >= 0; iScanPosInGroup-- )
+		{
+			const int iScanPos = ( iGroupScanPos << 4 ) + iScanPosInGroup;
+			if( iScanPos > iLastScanPos )
+			{
+				continue;
+			}
+			const unsigned int uiBlkPos = puiScan[iScanPos];
+			const TCoeff iLevel = pcCoef[uiBlkPos];
+			if( iScanPos != iLastScanPos )
+			{
+				const int iCtxSig = GvcTrQuant::getSigCtxInc( iPatternSigCtx, uiLog2Size, chType, eScanIdx, uiBlkPos & uiSizeMask, uiBlkPos >> uiLog2Size );
+				m_pcBinIf->encodeBin( iLevel != 0, m_cCtx.acSig[chType][iCtxSig] );
+			}
+			if( iLevel )
+			{
+				auiAbsCoeff[uiNumNonZero++] = abs( iLevel );
+				uiSigns = ( uiSigns << 1 ) + ( iLevel < 0 );
+			}
+		}
+		if( !uiNumNonZero )
+		{
+			continue;
+		}
+		abSigGroup[iGroupPos] = true;
+
+		// greater than 1 flags of the first levels, greater than 2 flag of the first level above 1
+		const int iCtxSet = ( ( iGroupScanPos > 0 && bLuma ) ? 2 : 0 ) + ( c1 == 0 );
+		c1 = 1;
+		const unsigned int uiNumC1Flag = std::min<unsigned int>( uiNumNonZero, C1FLAG_NUMBER );
+		int iFirstC2FlagIdx = -1;
+		for( unsigned int uiIdx = 0; uiIdx < uiNumC1Flag; uiIdx++ )
+		{
+			const unsigned int uiBin = auiAbsCoeff[uiIdx] > 1;
+			m_pcBinIf->encodeBin( uiBin, m_cCtx.acOneFlag[chType][iCtxSet * 4 + c1] );
+			if( uiBin )
+			{
+				c1 = 0;
+				if( iFirstC2FlagIdx == -1 )
+				{
+					iFirstC2FlagIdx = uiIdx;
+				}
+			}
+			else if( c1 < 3 && c1 > 0 )
+			{
+				c1++;
+			}
+		}
+		// the context set of the next group looks at every level of this one
+		for( unsigned int uiIdx = uiNumC1Flag; uiIdx < uiNumNonZero; uiIdx++ )
+		{
+			c1 = auiAbsCoeff[uiIdx] > 1 ? 0 : c1;
+		}
+		if( iFirstC2FlagIdx != -1 )
+		{
+			m_pcBinIf->encodeBin( auiAbsCoeff[iFirstC2FlagIdx] > 2, m_cCtx.acAbsFlag[chType][iCtxSet] );
+		}
+
+		m_pcBinIf->encodeBinsEP( uiSigns, uiNumNonZero );
+
+		// remaining levels with the Rice parameter adapted inside the group
+		unsigned int uiFirstCoeff2 = 1;
+		unsigned int uiGoRice = 0;
+		for( unsigned int uiIdx = 0; uiIdx < uiNumNonZero; uiIdx++ )
+		{
+			const unsigned int uiBaseLevel = uiIdx < (unsigned int)C1FLAG_NUMBER ? 2 + uiFirstCoeff2 : 1;
+			if( auiAbsCoeff[uiIdx] >= uiBaseLevel )
+			{
+				xWriteCoefRemainExGolomb( auiAbsCoeff[uiIdx] - uiBaseLevel, uiGoRice );
+				if( auiAbsCoeff[uiIdx] > ( 3u << uiGoRice ) )
+				{
+					uiGoRice = std::min<unsigned int>( uiGoRice + 1, MAX_GO_RICE_PARAMETER );
+				}
+			}
+			if( auiAbsCoeff[uiIdx] >= 2 )
+			{
+				uiFirstCoeff2 = 0;
+			}
+		}
+	}
+}
+
+/** Truncated unary prefix of the group index of each coordinate (the coordinates swapped for the
+ *  vertical scan), then the offsets inside the groups above 3 in bypass bins.
+ */
+void GvcSbac::xCodeLastSignificantXY( unsigned int uiPosX, unsigned int uiPosY, unsigned int uiLog2Size, ChannelType chType, COEFF_SCAN_TYPE eScanIdx )
+{
+	if( eScanIdx == SCAN_VER )
+	{
+		std::swap( uiPosX, uiPosY );
+	}
+	int iCtxOffset, iShift;
+	GvcTrQuant::getLastSignificantContextParameters( uiLog2Size, chType, iCtxOffset, iShift );
+	const unsigned int uiMaxGroup = g_uiGroupIdx[( 1 << uiLog2Size ) - 1];
+	const unsigned int uiGroupIdxX = g_uiGroupIdx[uiPosX];
+	const unsigned int uiGroupIdxY = g_uiGroupIdx[uiPosY];
+
+	unsigned int uiCtxLast;
+	for( uiCtxLast = 0; uiCtxLast < uiGroupIdxX; uiCtxLast++ )
+	{
+		m_pcBinIf->encodeBin( 1, m_cCtx.acLastX[chType][iCtxOffset + ( uiCtxLast >> iShift )] );
+	}
+	if( uiGroupIdxX < uiMaxGroup )
+	{
+		m_pcBinIf->encodeBin( 0, m_cCtx.acLastX[chType][iCtxOffset + ( uiCtxLast >> iShift )] );
+	}
+	for( uiCtxLast = 0; uiCtxLast < uiGroupIdxY; uiCtxLast++ )
+	{
+		m_pcBinIf->encodeBin( 1, m_cCtx.acLastY[chType][iCtxOffset + ( uiCtxLast >> iShift )] );
+	}
+	if( uiGroupIdxY < uiMaxGroup )
+	{
+		m_pcBinIf->encodeBin( 0, m_cCtx.acLastY[chType][iCtxOffset + ( uiCtxLast >> iShift )] );
+	}
+	if( uiGroupIdxX > 3 )
+	{
+		m_pcBinIf->encodeBinsEP( uiPosX - g_uiMinInGroup[uiGroupIdxX], ( uiGroupIdxX - 2 ) >> 1 );
+	}
+	if( uiGroupIdxY > 3 )
+	{
+		m_pcBinIf->encodeBinsEP( uiPosY - g_uiMinInGroup[uiGroupIdxY], ( uiGroupIdxY - 2 ) >> 1 );
+	}
+}
+
+/** Truncated Rice code below COEF_REMAIN_BIN_REDUCTION << uiGoRice, Exp-Golomb escape above. Prefix and
+ *  suffix go to the engine in a single call whenever they fit in 32 bins.
+ */
+void GvcSbac::xWriteCoefRemainExGolomb( unsigned int uiSymbol, unsigned int uiGoRice )
+{
+	unsigned int uiPrefixLength, uiSuffixLength, uiSuffix;
+	if( uiSymbol < ( (unsigned int)COEF_REMAIN_BIN_REDUCTION << uiGoRice ) )
+	{
+		uiPrefixLength = ( uiSymbol >> uiGoRice ) + 1;
+		uiSuffixLength = uiGoRice;
+		uiSuffix = uiSymbol & ( ( 1u << uiGoRice ) - 1 );
+	}
+	else
+	{
+		unsigned int uiLength = uiGoRice;
+		uiSymbol -= COEF_REMAIN_BIN_REDUCTION << uiGoRice;
+		while( uiSymbol >= ( 1u << uiLength ) )
+		{
+			uiSymbol -= 1u << uiLength++;
+		}
+		uiPrefixLength = COEF_REMAIN_BIN_REDUCTION + uiLength + 1 - uiGoRice;
+		uiSuffixLength = uiLength;
+		uiSuffix = uiSymbol;
+	}
+	// the prefix is a run of ones closed by a zero
+	const unsigned int uiPrefix = ( 1u << uiPrefixLength ) - 2;
+	if( uiPrefixLength + uiSuffixLength <= 32 )
+	{
+		m_pcBinIf->encodeBinsEP( ( uiPrefix << uiSuffixLength ) | uiSuffix, uiPrefixLength + uiSuffixLength );
+	}
+	else
+	{
+		m_pcBinIf->encodeBinsEP( uiPrefix, uiPrefixLength );
+		m_pcBinIf->encodeBinsEP( uiSuffix, uiSuffixLength );
+	}
+}
+
+/** Exp-Golomb code of order uiCount in bypass bins.
+ */
+void GvcSbac::xWriteEpExGolomb( unsigned int uiSymbol, unsigned int uiCount )
+{
+	unsigned int uiBins = 0;
+	int iNumBins = 0;
+	while( uiSymbol >= ( 1u << uiCount ) )
+	{
+		uiBins = 2 * uiBins + 1;
+		iNumBins++;
+		uiSymbol -= 1u << uiCount;
+		uiCount++;
+	}
+	uiBins = 2 * uiBins;
+	iNumBins++;
+	uiBins = ( uiBins << uiCount ) | uiSymbol;
+	iNumBins += uiCount;
+	m_pcBinIf->encodeBinsEP( uiBins, iNumBins );
+}
@@ -0,0 +1,112 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcSbac.h
+ * \brief    Context adaptive coding of the syntax elements of the block units
+ */
+
+#ifndef __GVCSBAC_H__
+#define __GVCSBAC_H__
+
+#include "TypeDef.h"
+#include "GvcBinCoder.h"
+#include "GvcContextModel.h"
+#include "GvcContextTables.h"
+#include "GvcMv.h"
+
+class GvcBlockUnit;
+struct GvcEstBitsSbac;
+struct GvcSaoBlkParam;
+
+/**
+ * \struct   GvcSbacContexts
+ * \brief    Context models of every syntax element
+ */
+struct GvcSbacContexts
+{
+	GvcContextModel acSplitFlag[NUM_SPLIT_FLAG_CTX];
+	GvcContextModel acPredMode[NUM_PRED_MODE_CTX];
+	GvcContextModel acIntraPred[NUM_INTRA_PREDICT_CTX];
+	GvcContextModel acChromaPred[NUM_CHROMA_PRED_CTX];
+	GvcContextModel acMvd[NUM_MV_RES_CTX];
+	GvcContextModel acSaoMergeFlag[NUM_SAO_MERGE_FLAG_CTX];
+	GvcContextModel acSaoTypeIdx[NUM_SAO_TYPE_IDX_CTX];
+	GvcContextModel acQtCbf[MAX_NUM_CHANNEL_TYPE][NUM_QT_CBF_CTX_PER_SET];
+	GvcContextModel acSigCoeffGroup[MAX_NUM_CHANNEL_TYPE][NUM_SIG_CG_FLAG_CTX];
+	GvcContextModel acSig[MAX_NUM_CHANNEL_TYPE][NUM_SIG_FLAG_CTX];
+	GvcContextModel acLastX[MAX_NUM_CHANNEL_TYPE][NUM_CTX_LAST_FLAG_XY];
+	GvcContextModel acLastY[MAX_NUM_CHANNEL_TYPE][NUM_CTX_LAST_FLAG_XY];
+	GvcContextModel acOneFlag[MAX_NUM_CHANNEL_TYPE][NUM_ONE_FLAG_CTX];
+	GvcContextModel acAbsFlag[MAX_NUM_CHANNEL_TYPE][NUM_ABS_FLAG_CTX];
+
+	void init( FrameType eFrameType, int iQp );
+};
+
+/**
+ * \class    GvcSbac
+ * \brief    Binarization and context selection of the block unit syntax, the bins go to a CABAC engine
+ *
+ * The residual syntax follows the rate model of GvcTrQuant: per 4x4 group in reverse scan order the
+ * significance flags, up to 8 greater than 1 flags, one greater than 2 flag, the signs and the
+ * remaining levels. Signs and remaining levels are equiprobable and are passed to the engine several
+ * bins at a time.
+ */
+class GvcSbac
+{
+	GvcBinIf* m_pcBinIf;
+	GvcSbacContexts m_cCtx;
+
+  public:
+	GvcSbac();
+	~GvcSbac();
+
+	void init( GvcBinIf* pcBinIf ) { m_pcBinIf = pcBinIf; }
+	/// initial state of every context model, at the start of a frame
+	void resetEntropy( FrameType eFrameType, int iQp );
+	/// snapshot and restore of the context states, to branch the coder for a trial and roll it back
+	void loadContexts( const GvcSbacContexts& rcCtx ) { m_cCtx = rcCtx; }
+	void storeContexts( GvcSbacContexts& rcCtx ) const { rcCtx = m_cCtx; }
+	/// rate tables of the residual syntax at the current context states, for the rate-distortion optimized quantization
+	void estBits( GvcEstBitsSbac& rcEstBits ) const;
+
+	void codeSplitFlag( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+	void codePredMode( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx );
+	void codeIntraDirLumaAng( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx );
+	void codeIntraDirChroma( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx );
+	/// vector difference in quarter samples
+	void codeMvd( const GvcMv& rcMvd );
+	/// coded block flag of a transform unit, then its levels (raster order) when it has any
+	void codeCoeffNxN( const TCoeff* pcCoef, const ComponentID compID, unsigned int uiSize, COEFF_SCAN_TYPE eScanIdx );
+	/// SAO offsets of a BU: merge flags, then per component the type, the offset magnitudes and the edge class or
+	/// the signs and the first band
+	void codeSaoBlkParam( const GvcSaoBlkParam& rcParam, bool bLeftAvail, bool bAboveAvail, ChromaFormat chromaFormat, const int* piBitDepth );
+	/// end of frame flag after each BU
+	void codeTerminatingBit( unsigned int uiBin ) { m_pcBinIf->encodeBinTrm( uiBin ); }
+
+	/// candidate chroma modes other than the luma one: planar, vertical, horizontal and DC, the mode equal to the luma mode replaced by mode 34
+	static void getAllowedChromaDir( unsigned int uiLumaDir, unsigned int* puiModeList );
+
+  private:
+	void xCodeLastSignificantXY( unsigned int uiPosX, unsigned int uiPosY, unsigned int uiLog2Size, ChannelType chType, COEFF_SCAN_TYPE eScanIdx );
+	void xWriteCoefRemainExGolomb( unsigned int uiSymbol, unsigned int uiGoRice );
+	void xWriteEpExGolomb( unsigned int uiSymbol, unsigned int uiCount );
+};
+
+#endif  // __GVCSBAC_H__
@@ -0,0 +1,476 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcSbacDecoder.cpp
+ * \brief    Context adaptive parsing of the syntax elements of the block units
+ */
+
+#include "GvcSbacDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "GvcBlockUnit.h"
+#include "GvcRom.h"
+#include "GvcSao.h"
+#include "GvcTrQuant.h"
+#include "TComChromaFormat.h"
+
+GvcSbacDecoder::GvcSbacDecoder()
+	: m_pcBinDecoder( NULL )
+{
+}
+
+GvcSbacDecoder::~GvcSbacDecoder()
+{
+}
+
+void GvcSbacDecoder::resetEntropy( FrameType eFrameType, int iQp )
+{
+	m_cCtx.init( eFrameType, iQp );
+}
+
+// ====================================================================================================================
+// Block unit syntax
+// ====================================================================================================================
+
+void GvcSbacDecoder::parseSplitFlag( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth )
+{
+	unsigned int uiTempPartIdx = 0;
+	unsigned int uiCtx = 0;
+	GvcBlockUnit* pcBULeft = pcBU->getPULeft( uiTempPartIdx, uiAbsPartIdx );
+	uiCtx += pcBULeft && pcBULeft->getDepth( uiTempPartIdx ) > uiDepth;
+	GvcBlockUnit* pcBUAbove = pcBU->getPUAbove( uiTempPartIdx, uiAbsPartIdx );
+	uiCtx += pcBUAbove && pcBUAbove->getDepth( uiTempPartIdx ) > uiDepth;
+	unsigned int uiSplit;
+	m_pcBinDecoder->decodeBin( uiSplit, m_cCtx.acSplitFlag[uiCtx] );
+	pcBU->setDepthSubParts( uiDepth + uiSplit, uiAbsPartIdx );
+}
+
+void GvcSbacDecoder::parsePredMode( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth )
+{
+	unsigned int uiBin;
+	m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acPredMode[0] );
+	pcBU->setPredModeSubParts( uiBin ? MODE_INTRA : MODE_INTER, uiAbsPartIdx, uiDepth );
+}
+
+/** The rank among the modes that are not most probable is turned back into a mode by stepping over the most probable
+ *  modes, in increasing order.
+ */
+void GvcSbacDecoder::parseIntraDirLumaAng( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth )
+{
+	int aiPreds[NUM_MOST_PROBABLE_MODES];
+	pcBU->getIntraDirPredictor( uiAbsPartIdx, aiPreds );
+	unsigned int uiBin;
+	m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acIntraPred[0] );
+	unsigned int uiDir;
+	if( uiBin )
+	{
+		m_pcBinDecoder->decodeBinEP( uiBin );
+		int iPredIdx = 0;
+		if( uiBin )
+		{
+			m_pcBinDecoder->decodeBinEP( uiBin );
+			iPredIdx = 1 + uiBin;
+		}
+		uiDir = aiPreds[iPredIdx];
+	}
+	else
+	{
+		m_pcBinDecoder->decodeBinsEP( uiDir, 5 );
+		std::sort( aiPreds, aiPreds + NUM_MOST_PROBABLE_MODES );
+		for( int i = 0; i < NUM_MOST_PROBABLE_MODES; i++ )
+		{
+			uiDir = uiDir >= (unsigned int)aiPreds[i] ? uiDir + 1 : uiDir;
+		}
+	}
+	pcBU->setIntraDirSubParts( CHANNEL_TYPE_LUMA, uiDir, uiAbsPartIdx, uiDepth );
+}
+
+void GvcSbacDecoder::parseIntraDirChroma( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth )
+{
+	unsigned int uiBin;
+	m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acChromaPred[0] );
+	unsigned int uiDir = DM_CHROMA_IDX;
+	if( uiBin )
+	{
+		unsigned int uiIdx;
+		m_pcBinDecoder->decodeBinsEP( uiIdx, 2 );
+		unsigned int auiModeList[NUM_CHROMA_MODE - 1];
+		GvcSbac::getAllowedChromaDir( pcBU->getIntraDir( CHANNEL_TYPE_LUMA, uiAbsPartIdx ), auiModeList );
+		uiDir = auiModeList[uiIdx];
+	}
+	pcBU->setIntraDirSubParts( CHANNEL_TYPE_CHROMA, uiDir, uiAbsPartIdx, uiDepth );
+}
+
+void GvcSbacDecoder::parseMvd( GvcMv& rcMvd )
+{
+	unsigned int uiHorAbs, uiVerAbs, uiBin;
+	m_pcBinDecoder->decodeBin( uiHorAbs, m_cCtx.acMvd[0] );
+	m_pcBinDecoder->decodeBin( uiVerAbs, m_cCtx.acMvd[0] );
+	if( uiHorAbs )
+	{
+		m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acMvd[1] );
+		uiHorAbs += uiBin;
+	}
+	if( uiVerAbs )
+	{
+		m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acMvd[1] );
+		uiVerAbs += uiBin;
+	}
+	int iHor = 0, iVer = 0;
+	if( uiHorAbs )
+	{
+		if( uiHorAbs > 1 )
+		{
+			xReadEpExGolomb( uiBin, 1 );
+			uiHorAbs += uiBin;
+		}
+		m_pcBinDecoder->decodeBinEP( uiBin );
+		iHor = uiBin ? -(int)uiHorAbs : (int)uiHorAbs;
+	}
+	if( uiVerAbs )
+	{
+		if( uiVerAbs > 1 )
+		{
+			xReadEpExGolomb( uiBin, 1 );
+			uiVerAbs += uiBin;
+		}
+		m_pcBinDecoder->decodeBinEP( uiBin );
+		iVer = uiBin ? -(int)uiVerAbs : (int)uiVerAbs;
+	}
+	rcMvd = GvcMv( iHor, iVer );
+}
+
+/** The edge offsets carry no signs: the first two categories are positive, the last two negative.
+ */
+void GvcSbacDecoder::parseSaoBlkParam( GvcSaoBlkParam& rcParam, bool bLeftAvail, bool bAboveAvail, ChromaFormat chromaFormat, const int* piBitDepth )
+{
+	rcParam.reset();
+	unsigned int uiBin;
+	if( bLeftAvail )
+	{
+		m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acSaoMergeFlag[0] );
+		rcParam.eMerge = uiBin ? SAO_MERGE_LEFT : SAO_MERGE_NONE;
+	}
+	if( bAboveAvail && rcParam.eMerge != SAO_MERGE_LEFT )
+	{
+		m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acSaoMergeFlag[0] );
+		rcParam.eMerge = uiBin ? SAO_MERGE_ABOVE : SAO_MERGE_NONE;
+	}
+	if( rcParam.eMerge != SAO_MERGE_NONE )
+	{
+		return;
+	}
+	for( unsigned int comp = 0; comp < getNumberValidComponents( chromaFormat ); comp++ )
+	{
+		GvcSaoOffset& rcOffset = rcParam.acOffset[comp];
+		m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acSaoTypeIdx[0] );
+		if( !uiBin )
+		{
+			continue;
+		}
+		m_pcBinDecoder->decodeBinEP( uiBin );
+		rcOffset.eType = uiBin ? SAO_TYPE_EO : SAO_TYPE_BO;
+		const int iMaxOffset = GvcSao::getMaxOffset( piBitDepth[toChannelType( ComponentID( comp ) )] );
+		for( int i = 0; i < NUM_SAO_OFFSETS; i++ )
+		{
+			int iAbs = 0;
+			while( iAbs < iMaxOffset )
+			{
+				m_pcBinDecoder->decodeBinEP( uiBin );
+				if( !uiBin )
+				{
+					break;
+				}
+				iAbs++;
+			}
+			rcOffset.aiOffset[i] = iAbs;
+		}
+		unsigned int uiTypeAux;
+		if( rcOffset.eType == SAO_TYPE_BO )
+		{
+			for( int i = 0; i < NUM_SAO_OFFSETS; i++ )
+			{
+				if( rcOffset.aiOffset[i] )
+				{
+					m_pcBinDecoder->decodeBinEP( uiBin );
+					rcOffset.aiOffset[i] = uiBin ? -rcOffset.aiOffset[i] : rcOffset.aiOffset[i];
+				}
+			}
+			m_pcBinDecoder->decodeBinsEP( uiTypeAux, 5 );
+		}
+		else
+		{
+			rcOffset.aiOffset[2] = -rcOffset.aiOffset[2];
+			rcOffset.aiOffset[3] = -rcOffset.aiOffset[3];
+			m_pcBinDecoder->decodeBinsEP( uiTypeAux, 2 );
+		}
+		rcOffset.iTypeAux = (int)uiTypeAux;
+	}
+}
+
+// ====================================================================================================================
+// Residual syntax
+// ====================================================================================================================
+
+/** Groups in reverse scan order as in GvcSbac::codeCoeffNxN. The remaining level of a coefficient follows when the
+ *  flags reach its base level, the magnitude of the coefficient is then only known after it; the context set of the
+ *  next group is derived once every level of the group is.
+ */
+void GvcSbacDecoder::parseCoeffNxN( TCoeff* pcCoef, const ComponentID compID, unsigned int uiSize, COEFF_SCAN_TYPE eScanIdx, GvcTUCoeffInfo& rcInfo )
+{
+	const ChannelType chType = toChannelType( compID );
+	const bool bLuma = isLuma( chType );
+	const unsigned int uiLog2Size = g_aucConvertToBit[uiSize] + 2;
+	const unsigned short* puiScan = g_auiScanOrder[eScanIdx][uiLog2Size - MIN_LOG2_TU_SIZE];
+	const int iLog2Groups = uiLog2Size - 2;
+	const unsigned int uiSizeMask = uiSize - 1;
+
+	memset( pcCoef, 0, sizeof( TCoeff ) * uiSize * uiSize );
+	rcInfo.uiAbsSum = 0;
+	rcInfo.iLastScanPos = -1;
+	rcInfo.uiLastPosX = rcInfo.uiLastPosY = 0;
+	rcInfo.iFracBits = 0;
+
+	unsigned int uiCbf;
+	m_pcBinDecoder->decodeBin( uiCbf, m_cCtx.acQtCbf[chType][0] );
+	if( !uiCbf )
+	{
+		return;
+	}
+	unsigned int uiPosLastX, uiPosLastY;
+	xParseLastSignificantXY( uiPosLastX, uiPosLastY, uiLog2Size, chType, eScanIdx );
+	const unsigned int uiBlkPosLast = ( uiPosLastY << uiLog2Size ) + uiPosLastX;
+	int iLastScanPos = 0;
+	while( puiScan[iLastScanPos] != uiBlkPosLast )
+	{
+		iLastScanPos++;
+	}
+	rcInfo.iLastScanPos = iLastScanPos;
+	rcInfo.uiLastPosX = uiPosLastX;
+	rcInfo.uiLastPosY = uiPosLastY;
+
+	bool abSigGroup[64];
+	memset( abSigGroup, 0, sizeof( abSigGroup ) );
+	const int iGroupLastScanPos = iLastScanPos >> 4;
+	unsigned int c1 = 1;
+	for( int iGroupScanPos = iGroupLastScanPos; iGroupScanPos >= 0; iGroupScanPos-- )
+	{
+		const unsigned int uiGroupX = ( puiScan[iGroupScanPos << 4] & uiSizeMask ) >> 2;
+		const unsigned int uiGroupY = ( puiScan[iGroupScanPos << 4] >> uiLog2Size ) >> 2;
+		const int iGroupPos = ( uiGroupY << iLog2Groups ) + uiGroupX;
+		const unsigned int uiSigRight = uiGroupX + 1 < ( 1u << iLog2Groups ) ? abSigGroup[iGroupPos + 1] : 0;
+		const unsigned int uiSigLower = uiGroupY + 1 < ( 1u << iLog2Groups ) ? abSigGroup[iGroupPos + ( 1 << iLog2Groups )] : 0;
+		const int iPatternSigCtx = uiSigRight + ( uiSigLower << 1 );
+
+		if( iGroupScanPos > 0 && iGroupScanPos < iGroupLastScanPos )
+		{
+			unsigned int uiSigGroup;
+			m_pcBinDecoder->decodeBin( uiSigGroup, m_cCtx.acSigCoeffGroup[chType][std::min<unsigned int>( uiSigRight + uiSigLower, 1 )] );
+			if( !uiSigGroup )
+			{
+				continue;
+			}
+		}
+
+		// significance, the positions of the levels in coding order
+		unsigned int auiBlkPos[16];
+		unsigned int uiNumNonZero = 0;
+		for( int iScanPosInGroup = 15; iScanPosInGroup >= 0; iScanPosInGroup-- )
+		{
+			const int iScanPos = ( iGroupScanPos << 4 ) + iScanPosInGroup;
+			if( iScanPos > iLastScanPos )
+			{
+				continue;
+			}
+			const unsigned int uiBlkPos = puiScan[iScanPos];
+			unsigned int uiSig = 1;
+			if( iScanPos != iLastScanPos )
+			{
+				const int iCtxSig = GvcTrQuant::getSigCtxInc( iPatternSigCtx, uiLog2Size, chType, eScanIdx, uiBlkPos & uiSizeMask, uiBlkPos >> uiLog2Size );
+				m_pcBinDecoder->decodeBin( uiSig, m_cCtx.acSig[chType][iCtxSig] );
+			}
+			if( uiSig )
+			{
+				auiBlkPos[uiNumNonZero++] = uiBlkPos;
+			}
+		}
+		if( !uiNumNonZero )
+		{
+			continue;
+		}
+		abSigGroup[iGroupPos] = true;
+
+		unsigned int auiAbsCoeff[16];
+		for( unsigned int uiIdx = 0; uiIdx < uiNumNonZero; uiIdx++ )
+		{
+			auiAbsCoeff[uiIdx] = 1;
+		}
+		const int iCtxSet = ( ( iGroupScanPos > 0 && bLuma ) ? 2 : 0 ) + ( c1 == 0 );
+		c1 = 1;
+		const unsigned int uiNumC1Flag = std::min<unsigned int>( uiNumNonZero, C1FLAG_NUMBER );
+		int iFirstC2FlagIdx = -1;
+		for( unsigned int uiIdx = 0; uiIdx < uiNumC1Flag; uiIdx++ )
+		{
+			unsigned int uiBin;
+			m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acOneFlag[chType][iCtxSet * 4 + c1] );
+			if( uiBin )
+			{
+				auiAbsCoeff[uiIdx] = 2;
+				c1 = 0;
+				if( iFirstC2FlagIdx == -1 )
+				{
+					iFirstC2FlagIdx = uiIdx;
+				}
+			}
+			else if( c1 < 3 && c1 > 0 )
+			{
+				c1++;
+			}
+		}
+		if( iFirstC2FlagIdx != -1 )
+		{
+			unsigned int uiBin;
+			m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acAbsFlag[chType][iCtxSet] );
+			auiAbsCoeff[iFirstC2FlagIdx] += uiBin;
+		}
+
+		unsigned int uiSigns;
+		m_pcBinDecoder->decodeBinsEP( uiSigns, uiNumNonZero );
+
+		unsigned int uiFirstCoeff2 = 1;
+		unsigned int uiGoRice = 0;
+		for( unsigned int uiIdx = 0; uiIdx < uiNumNonZero; uiIdx++ )
+		{
+			const unsigned int uiBaseLevel = uiIdx < (unsigned int)C1FLAG_NUMBER ? 2 + uiFirstCoeff2 : 1;
+			if( auiAbsCoeff[uiIdx] == uiBaseLevel )
+			{
+				unsigned int uiEscape;
+				xReadCoefRemainExGolomb( uiEscape, uiGoRice );
+				auiAbsCoeff[uiIdx] += uiEscape;
+				if( auiAbsCoeff[uiIdx] > ( 3u << uiGoRice ) )
+				{
+					uiGoRice = std::min<unsigned int>( uiGoRice + 1, MAX_GO_RICE_PARAMETER );
+				}
+			}
+			if( auiAbsCoeff[uiIdx] >= 2 )
+			{
+				uiFirstCoeff2 = 0;
+			}
+			const bool bNegative = ( uiSigns >> ( uiNumNonZero - 1 - uiIdx ) ) & 1;
+			pcCoef[auiBlkPos[uiIdx]] = bNegative ? -(TCoeff)auiAbsCoeff[uiIdx] : (TCoeff)auiAbsCoeff[uiIdx];
+			rcInfo.uiAbsSum += auiAbsCoeff[uiIdx];
+		}
+		for( unsigned int uiIdx = uiNumC1Flag; uiIdx < uiNumNonZero; uiIdx++ )
+		{
+			c1 = auiAbsCoeff[uiIdx] > 1 ? 0 : c1;
+		}
+	}
+}
+
+void GvcSbacDecoder::xParseLastSignificantXY( unsigned int& ruiPosX, unsigned int& ruiPosY, unsigned int uiLog2Size, ChannelType chType,
+											  COEFF_SCAN_TYPE eScanIdx )
+{
+	int iCtxOffset, iShift;
+	GvcTrQuant::getLastSignificantContextParameters( uiLog2Size, chType, iCtxOffset, iShift );
+	const unsigned int uiMaxGroup = g_uiGroupIdx[( 1 << uiLog2Size ) - 1];
+
+	unsigned int uiBin;
+	unsigned int uiGroupIdxX = 0;
+	for( ; uiGroupIdxX < uiMaxGroup; uiGroupIdxX++ )
+	{
+		m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acLastX[chType][iCtxOffset + ( uiGroupIdxX >> iShift )] );
+		if( !uiBin )
+		{
+			break;
+		}
+	}
+	unsigned int uiGroupIdxY = 0;
+	for( ; uiGroupIdxY < uiMaxGroup; uiGroupIdxY++ )
+	{
+		m_pcBinDecoder->decodeBin( uiBin, m_cCtx.acLastY[chType][iCtxOffset + ( uiGroupIdxY >> iShift )] );
+		if( !uiBin )
+		{
+			break;
+		}
+	}
+	ruiPosX = g_uiMinInGroup[uiGroupIdxX];
+	if( uiGroupIdxX > 3 )
+	{
+		m_pcBinDecoder->decodeBinsEP( uiBin, ( uiGroupIdxX - 2 ) >> 1 );
+		ruiPosX += uiBin;
+	}
+	ruiPosY = g_uiMinInGroup[uiGroupIdxY];
+	if( uiGroupIdxY > 3 )
+	{
+		m_pcBinDecoder->decodeBinsEP( uiBin, ( uiGroupIdxY - 2 ) >> 1 );
+		ruiPosY += uiBin;
+	}
+	if( eScanIdx == SCAN_VER )
+	{
+		std::swap( ruiPosX, ruiPosY );
+	}
+}
+
+/** Prefix of ones closed by a zero, then a Rice suffix for a short prefix or an Exp-Golomb suffix for a long one.
+ */
+void GvcSbacDecoder::xReadCoefRemainExGolomb( unsigned int& ruiSymbol, unsigned int uiGoRice )
+{
+	unsigned int uiPrefix = 0;
+	unsigned int uiBin;
+	do
+	{
+		m_pcBinDecoder->decodeBinEP( uiBin );
+		uiPrefix += uiBin;
+	} while( uiBin && uiPrefix < 32 );
+
+	unsigned int uiSuffix = 0;
+	if( uiPrefix < (unsigned int)COEF_REMAIN_BIN_REDUCTION )
+	{
+		if( uiGoRice )
+		{
+			m_pcBinDecoder->decodeBinsEP( uiSuffix, uiGoRice );
+		}
+		ruiSymbol = ( uiPrefix << uiGoRice ) + uiSuffix;
+		return;
+	}
+	// a damaged stream may ask for more suffix bins than a symbol holds
+	const unsigned int uiLength = std::min<unsigned int>( uiPrefix - COEF_REMAIN_BIN_REDUCTION + uiGoRice, 24 );
+	m_pcBinDecoder->decodeBinsEP( uiSuffix, uiLength );
+	ruiSymbol = ( COEF_REMAIN_BIN_REDUCTION << uiGoRice ) + ( 1u << uiLength ) - ( 1u << uiGoRice ) + uiSuffix;
+}
+
+void GvcSbacDecoder::xReadEpExGolomb( unsigned int& ruiSymbol, unsigned int uiCount )
+{
+	unsigned int uiSymbol = 0;
+	unsigned int uiBin = 1;
+	while( uiBin && uiCount < 24 )
+	{
+		m_pcBinDecoder->decodeBinEP( uiBin );
+		uiSymbol += uiBin << uiCount++;
+	}
+	if( --uiCount )
+	{
+		m_pcBinDecoder->decodeBinsEP( uiBin, uiCount );
+		uiSymbol += uiBin;
+	}
+	ruiSymbol = uiSymbol;
+}
@@ -0,0 +1,79 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcSbacDecoder.h
+ * \brief    Context adaptive parsing of the syntax elements of the block units
+ */
+
+#ifndef __GVCSBACDECODER_H__
+#define __GVCSBACDECODER_H__
+
+#include "TypeDef.h"
+#include "GvcBinDecoderCABAC.h"
+#include "GvcMv.h"
+#include "GvcSbac.h"
+
+class GvcBlockUnit;
+struct GvcSaoBlkParam;
+struct GvcTUCoeffInfo;
+
+/**
+ * \class    GvcSbacDecoder
+ * \brief    Parses the block unit syntax written by GvcSbac, with the same binarizations and context selection
+ *
+ * The elements that describe a coding unit are stored in the BU they are parsed for, at its partitions, where the
+ * context selection of the following ones looks for them as the encoder does.
+ */
+class GvcSbacDecoder
+{
+	GvcBinDecoderCABAC* m_pcBinDecoder;
+	GvcSbacContexts m_cCtx;
+
+  public:
+	GvcSbacDecoder();
+	~GvcSbacDecoder();
+
+	void init( GvcBinDecoderCABAC* pcBinDecoder ) { m_pcBinDecoder = pcBinDecoder; }
+	/// initial state of every context model, at the start of a substream
+	void resetEntropy( FrameType eFrameType, int iQp );
+	void loadContexts( const GvcSbacContexts& rcCtx ) { m_cCtx = rcCtx; }
+	void storeContexts( GvcSbacContexts& rcCtx ) const { rcCtx = m_cCtx; }
+
+	/// sets the depth of the partitions of the coding unit to uiDepth, or to uiDepth + 1 when it is split
+	void parseSplitFlag( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+	void parsePredMode( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+	void parseIntraDirLumaAng( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+	void parseIntraDirChroma( GvcBlockUnit* pcBU, unsigned int uiAbsPartIdx, unsigned int uiDepth );
+	/// vector difference in quarter samples
+	void parseMvd( GvcMv& rcMvd );
+	/// coded block flag of a transform unit and its levels, in raster order, with the summary the inverse transform needs
+	void parseCoeffNxN( TCoeff* pcCoef, const ComponentID compID, unsigned int uiSize, COEFF_SCAN_TYPE eScanIdx, GvcTUCoeffInfo& rcInfo );
+	/// merge mode and the offsets of a BU that is not merged, a merged BU takes its offsets from the caller
+	void parseSaoBlkParam( GvcSaoBlkParam& rcParam, bool bLeftAvail, bool bAboveAvail, ChromaFormat chromaFormat, const int* piBitDepth );
+	/// end of frame flag after each BU
+	void parseTerminatingBit( unsigned int& ruiBin ) { m_pcBinDecoder->decodeBinTrm( ruiBin ); }
+
+  private:
+	void xParseLastSignificantXY( unsigned int& ruiPosX, unsigned int& ruiPosY, unsigned int uiLog2Size, ChannelType chType, COEFF_SCAN_TYPE eScanIdx );
+	void xReadCoefRemainExGolomb( unsigned int& ruiSymbol, unsigned int uiGoRice );
+	void xReadEpExGolomb( unsigned int& ruiSymbol, unsigned int uiCount );
+};
+
+#endif  // __GVCSBACDECODER_H__
@@ -0,0 +1,301 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcThreadPool.cpp
+ * \brief    Worker threads of the encoder
+ */
+
+#include "GvcThreadPool.h"
+
+#include <algorithm>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#elif defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/// the pool and index of the worker running on this thread, so that the jobs it queues stay on its own queue
+static thread_local const GvcThreadPool* s_pcWorkerPool = NULL;
+static thread_local int s_iWorkerIdx = -1;
+
+/// best effort, a thread that cannot be pinned runs anywhere
+static void pinThread( std::thread& rcThread, int iCore )
+{
+#if defined( _WIN32 )
+	SetThreadAffinityMask( rcThread.native_handle(), (DWORD_PTR)1 << ( iCore % ( 8 * sizeof( DWORD_PTR ) ) ) );
+#elif defined( __linux__ )
+	cpu_set_t cpuSet;
+	CPU_ZERO( &cpuSet );
+	CPU_SET( iCore % CPU_SETSIZE, &cpuSet );
+	pthread_setaffinity_np( rcThread.native_handle(), sizeof( cpuSet ), &cpuSet );
+#else
+	(void)rcThread;
+	(void)iCore;
+#endif
+}
+
+GvcThreadPool::GvcThreadPool()
+	: m_iNumThreads( 0 )
+	, m_pcQueues( NULL )
+	, m_uiNextQueue( 0 )
+	, m_iNumQueued( 0 )
+	, m_iMaxQueued( 0 )
+	, m_iNumPending( 0 )
+	, m_bRunning( false )
+{
+}
+
+GvcThreadPool::~GvcThreadPool()
+{
+	destroy();
+}
+
+void GvcThreadPool::create( int iNumThreads, bool bPinThreads )
+{
+	m_pcQueues = new WorkerQueue[iNumThreads];
+	for( int i = 0; i < iNumThreads; i++ )
+	{
+		m_pcQueues[i].uiNumJobs = 0;
+		m_pcQueues[i].uiNumSteals = 0;
+	}
+	m_uiNextQueue = 0;
+	m_iNumQueued = 0;
+	m_iMaxQueued = 0;
+	m_bRunning = true;
+	// the workers steal from each other as soon as they start, the vector of threads grows meanwhile
+	m_iNumThreads = iNumThreads;
+	m_acThreads.reserve( iNumThreads );
+	const int iNumCores = std::max( 1, (int)std::thread::hardware_concurrency() );
+	for( int i = 0; i < iNumThreads; i++ )
+	{
+		m_acThreads.push_back( std::thread( &GvcThreadPool::xWorker, this, i ) );
+		if( bPinThreads )
+		{
+			pinThread( m_acThreads.back(), i % iNumCores );
+		}
+	}
+}
+
+void GvcThreadPool::destroy()
+{
+	if( m_acThreads.empty() )
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		m_bRunning = false;
+	}
+	m_cJobCond.notify_all();
+	for( size_t i = 0; i < m_acThreads.size(); i++ )
+	{
+		m_acThreads[i].join();
+	}
+	m_acThreads.clear();
+	m_iNumThreads = 0;
+	delete[] m_pcQueues;
+	m_pcQueues = NULL;
+}
+
+void GvcThreadPool::enqueue( const std::function<void( int )>& rcJob, int iPriority )
+{
+	const int iNumThreads = m_iNumThreads;
+	const int iQueue = s_pcWorkerPool == this ? s_iWorkerIdx : (int)( m_uiNextQueue++ % iNumThreads );
+	WorkerQueue& rcQueue = m_pcQueues[iQueue];
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		m_iNumPending++;
+	}
+	{
+		// behind the jobs of the same or a more urgent priority, nearly always at the back
+		std::lock_guard<std::mutex> lock( rcQueue.cMutex );
+		std::deque<Job>::iterator it = rcQueue.acJobs.end();
+		while( it != rcQueue.acJobs.begin() && ( it - 1 )->iPriority > iPriority )
+		{
+			--it;
+		}
+		Job cJob;
+		cJob.cFunc = rcJob;
+		cJob.iPriority = iPriority;
+		rcQueue.acJobs.insert( it, cJob );
+	}
+	{
+		// counted under the lock the idle workers check it with, so that none of them misses the job
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		const int iNumQueued = ++m_iNumQueued;
+		if( iNumQueued > m_iMaxQueued )
+		{
+			m_iMaxQueued = iNumQueued;
+		}
+	}
+	m_cJobCond.notify_one();
+}
+
+void GvcThreadPool::waitAll()
+{
+	std::unique_lock<std::mutex> lock( m_cMutex );
+	m_cIdleCond.wait( lock, [this] { return m_iNumPending == 0; } );
+}
+
+/** Takes the first job of the worker's own queue, or else the most urgent first job of the other queues.
+ */
+bool GvcThreadPool::xPopJob( int iThreadIdx, Job& rcJob )
+{
+	const int iNumThreads = m_iNumThreads;
+	WorkerQueue& rcOwnQueue = m_pcQueues[iThreadIdx];
+	{
+		std::lock_guard<std::mutex> lock( rcOwnQueue.cMutex );
+		if( !rcOwnQueue.acJobs.empty() )
+		{
+			rcJob = rcOwnQueue.acJobs.front();
+			rcOwnQueue.acJobs.pop_front();
+			m_iNumQueued--;
+			rcOwnQueue.uiNumJobs++;
+			return true;
+		}
+	}
+	while( m_iNumQueued.load( std::memory_order_relaxed ) > 0 )
+	{
+		int iVictim = -1;
+		int iPriority = 0;
+		for( int i = 1; i < iNumThreads; i++ )
+		{
+			WorkerQueue& rcQueue = m_pcQueues[( iThreadIdx + i ) % iNumThreads];
+			std::lock_guard<std::mutex> lock( rcQueue.cMutex );
+			if( !rcQueue.acJobs.empty() && ( iVictim < 0 || rcQueue.acJobs.front().iPriority < iPriority ) )
+			{
+				iVictim = ( iThreadIdx + i ) % iNumThreads;
+				iPriority = rcQueue.acJobs.front().iPriority;
+			}
+		}
+		if( iVictim < 0 )
+		{
+			return false;
+		}
+		WorkerQueue& rcQueue = m_pcQueues[iVictim];
+		std::lock_guard<std::mutex> lock( rcQueue.cMutex );
+		// another worker may have been quicker, look again
+		if( !rcQueue.acJobs.empty() )
+		{
+			rcJob = rcQueue.acJobs.front();
+			rcQueue.acJobs.pop_front();
+			m_iNumQueued--;
+			rcOwnQueue.uiNumJobs++;
+			rcOwnQueue.uiNumSteals++;
+			return true;
+		}
+	}
+	return false;
+}
+
+void GvcThreadPool::xWorker( int iThreadIdx )
+{
+	s_pcWorkerPool = this;
+	s_iWorkerIdx = iThreadIdx;
+	Job cJob;
+	for( ;; )
+	{
+		if( xPopJob( iThreadIdx, cJob ) )
+		{
+			cJob.cFunc( iThreadIdx );
+			cJob.cFunc = std::function<void( int )>();
+			std::lock_guard<std::mutex> lock( m_cMutex );
+			if( --m_iNumPending == 0 )
+			{
+				m_cIdleCond.notify_all();
+			}
+			continue;
+		}
+		std::unique_lock<std::mutex> lock( m_cMutex );
+		m_cJobCond.wait( lock, [this] { return !m_bRunning || m_iNumQueued.load( std::memory_order_relaxed ) > 0; } );
+		if( !m_bRunning && m_iNumQueued.load( std::memory_order_relaxed ) == 0 )
+		{
+			return;
+		}
+	}
+}
+
+void GvcRowProgress::set( int iNumDone )
+{
+	// the store is made under the lock so that a waiter cannot miss it between its check and its sleep
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		m_iNumDone.store( iNumDone, std::memory_order_release );
+	}
+	m_cCond.notify_all();
+}
+
+void GvcRowProgress::wait( int iNumDone )
+{
+	if( get() >= iNumDone )
+	{
+		return;
+	}
+	std::unique_lock<std::mutex> lock( m_cMutex );
+	m_cCond.wait( lock, [this, iNumDone] { return get() >= iNumDone; } );
+}
+
+void GvcForkedJob::fork( GvcThreadPool* pcPool, const std::function<void()>& rcFunc, int iPriority )
+{
+	m_cFunc = rcFunc;
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		m_bDone = false;
+	}
+	m_uiTicket = m_uiTicket + 1 ? m_uiTicket + 1 : 1;
+	const unsigned int uiTicket = m_uiTicket;
+	m_uiPending.store( uiTicket, std::memory_order_release );
+	pcPool->enqueue( [this, uiTicket]( int ) {
+		if( xClaim( uiTicket ) )
+		{
+			xRun();
+		}
+	}, iPriority );
+}
+
+void GvcForkedJob::join()
+{
+	if( xClaim( m_uiTicket ) )
+	{
+		xRun();
+		return;
+	}
+	std::unique_lock<std::mutex> lock( m_cMutex );
+	m_cCond.wait( lock, [this] { return m_bDone; } );
+}
+
+/// true for the one thread that gets to run the fork uiTicket
+bool GvcForkedJob::xClaim( unsigned int uiTicket )
+{
+	unsigned int uiExpected = uiTicket;
+	return m_uiPending.compare_exchange_strong( uiExpected, 0, std::memory_order_acq_rel );
+}
+
+void GvcForkedJob::xRun()
+{
+	m_cFunc();
+	{
+		std::lock_guard<std::mutex> lock( m_cMutex );
+		m_bDone = true;
+	}
+	m_cCond.notify_all();
+}
@@ -0,0 +1,155 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcThreadPool.h
+ * \brief    Worker threads of the encoder (header)
+ */
+
+#ifndef __GVCTHREADPOOL_H__
+#define __GVCTHREADPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "TypeDef.h"
+
+/**
+ * \class    GvcThreadPool
+ * \brief    Fixed set of threads shared by every stage of the encoder, with a job queue per thread
+ *
+ * A job gets the index of the thread that runs it, to pick the per thread state it works on. Jobs queued from a
+ * worker go to its own queue, the others are spread over the queues in turn; a worker whose queue is empty steals the
+ * most urgent job of the others. Each queue is kept in priority order, lower values first and equal ones in queue
+ * order, so that the rows of the oldest frame run before those of the frames after it.
+ *
+ * A job may wait for another one only if that one has a lower priority, or the same and was queued before it, and
+ * the priorities must not decrease in the order the jobs waited for are queued: a worker then never picks a job while
+ * one that the job waits for stays queued behind it. Jobs that never wait may be queued in any order.
+ */
+class GvcThreadPool
+{
+	struct Job
+	{
+		std::function<void( int )> cFunc;
+		int iPriority;
+	};
+	/// jobs queued on a worker, the most urgent first
+	struct WorkerQueue
+	{
+		std::mutex cMutex;
+		std::deque<Job> acJobs;
+		unsigned long long uiNumJobs;    ///< jobs run by the worker
+		unsigned long long uiNumSteals;  ///< of which taken from another queue
+	};
+
+	std::vector<std::thread> m_acThreads;
+	int m_iNumThreads;                        ///< set before the first worker starts, the workers read it
+	WorkerQueue* m_pcQueues;
+	std::atomic<unsigned int> m_uiNextQueue;  ///< queue of the next job queued from outside the pool
+	std::atomic<int> m_iNumQueued;
+	std::atomic<int> m_iMaxQueued;
+	std::mutex m_cMutex;
+	std::condition_variable m_cJobCond;   ///< a job was queued or the pool stops
+	std::condition_variable m_cIdleCond;  ///< the last pending job finished
+	int m_iNumPending;                    ///< jobs queued or running
+	bool m_bRunning;
+
+  public:
+	GvcThreadPool();
+	virtual ~GvcThreadPool();
+
+	/// with bPinThreads, worker i only runs on logical core i, modulo their number
+	void create( int iNumThreads, bool bPinThreads = false );
+	void destroy();
+	int  getNumThreads() const { return m_iNumThreads; }
+	void enqueue( const std::function<void( int )>& rcJob, int iPriority = 0 );
+	/// returns once every queued job has run
+	void waitAll();
+
+	// statistics, for tuning the thread counts
+	int  getNumQueued() const { return m_iNumQueued.load( std::memory_order_relaxed ); }
+	int  getMaxQueued() const { return m_iMaxQueued.load( std::memory_order_relaxed ); }
+	unsigned long long getNumJobs( int iThreadIdx ) const { return m_pcQueues[iThreadIdx].uiNumJobs; }
+	unsigned long long getNumSteals( int iThreadIdx ) const { return m_pcQueues[iThreadIdx].uiNumSteals; }
+
+  private:
+	bool xPopJob( int iThreadIdx, Job& rcJob );
+	void xWorker( int iThreadIdx );
+};
+
+/**
+ * \class    GvcRowProgress
+ * \brief    Number of BUs of a BU row that are done, for the rows that depend on it
+ *
+ * The count only grows within a frame. Reading it is a single atomic load; a waiter only takes the lock when it
+ * has to sleep.
+ */
+class GvcRowProgress
+{
+	std::atomic<int> m_iNumDone;
+	std::mutex m_cMutex;
+	std::condition_variable m_cCond;
+
+  public:
+	GvcRowProgress() : m_iNumDone( 0 ) {}
+
+	void reset() { m_iNumDone.store( 0, std::memory_order_relaxed ); }
+	int  get() const { return m_iNumDone.load( std::memory_order_acquire ); }
+	void set( int iNumDone );
+	/// returns once at least iNumDone BUs are done
+	void wait( int iNumDone );
+};
+
+/**
+ * \class    GvcForkedJob
+ * \brief    Job handed to the pool by a thread that joins it later, and runs it itself if no worker took it yet
+ *
+ * The joining thread never sleeps on a job that is still queued, so the job may be forked from within another job
+ * and with any priority. The object serves one fork at a time and is reused; the queued copy of a fork that the
+ * joining thread ran itself does nothing when a worker picks it up, but still reads the object, which therefore
+ * outlives the jobs of the pool: the pool is stopped, or waited for with waitAll, before it goes.
+ */
+class GvcForkedJob
+{
+	std::function<void()> m_cFunc;
+	unsigned int m_uiTicket;                ///< number of the last fork
+	std::atomic<unsigned int> m_uiPending;  ///< ticket of the fork no thread started yet, 0 when none
+	std::mutex m_cMutex;
+	std::condition_variable m_cCond;
+	bool m_bDone;
+
+  public:
+	GvcForkedJob() : m_uiTicket( 0 ), m_uiPending( 0 ), m_bDone( true ) {}
+
+	void fork( GvcThreadPool* pcPool, const std::function<void()>& rcFunc, int iPriority );
+	/// returns once the job of the last fork has run
+	void join();
+
+  private:
+	bool xClaim( unsigned int uiTicket );
+	void xRun();
+};
+
+#endif  // __GVCTHREADPOOL_H__
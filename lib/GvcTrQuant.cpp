@@ -0,0 +1,895 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcTrQuant.cpp
+ * \brief    Transform and quantization of the residual blocks
+ */
+
+#include "GvcTrQuant.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "TComChromaFormat.h"
+
+static const int REMAINING_BITS_TABLE_SIZE = 64;
+static const unsigned char s_aucCtxIndMap4x4[16] = { 0, 1, 4, 5, 2, 3, 4, 5, 6, 6, 8, 8, 7, 7, 8, 8 };
+
+static inline int getTransformSizeIdx( unsigned int uiSize )
+{
+	int iIdx = 0;
+	while( ( MIN_TU_SIZE << iIdx ) < (int)uiSize )
+	{
+		iIdx++;
+	}
+	return iIdx;
+}
+
+/// bits of the coeff_abs_level_remaining code of a symbol: truncated Rice prefix, Exp-Golomb escape
+static int getRemainingBits( unsigned int uiSymbol, unsigned int uiGoRice )
+{
+	if( uiSymbol < ( (unsigned int)COEF_REMAIN_BIN_REDUCTION << uiGoRice ) )
+	{
+		return ( uiSymbol >> uiGoRice ) + 1 + uiGoRice;
+	}
+	unsigned int uiLength = uiGoRice;
+	uiSymbol -= COEF_REMAIN_BIN_REDUCTION << uiGoRice;
+	while( uiSymbol >= ( 1u << uiLength ) )
+	{
+		uiSymbol -= 1u << uiLength++;
+	}
+	return COEF_REMAIN_BIN_REDUCTION + uiLength + 1 - uiGoRice + uiLength;
+}
+
+/// fractional rate of the remaining level codes of the small symbols, one table per Rice parameter
+struct RemainingBitsTable
+{
+	int aaiBits[MAX_GO_RICE_PARAMETER + 1][REMAINING_BITS_TABLE_SIZE];
+
+	RemainingBitsTable()
+	{
+		for( unsigned int uiGoRice = 0; uiGoRice <= (unsigned int)MAX_GO_RICE_PARAMETER; uiGoRice++ )
+		{
+			for( unsigned int uiSymbol = 0; uiSymbol < (unsigned int)REMAINING_BITS_TABLE_SIZE; uiSymbol++ )
+			{
+				aaiBits[uiGoRice][uiSymbol] = getRemainingBits( uiSymbol, uiGoRice ) << FRAC_BITS_SCALE;
+			}
+		}
+	}
+	int get( unsigned int uiSymbol, unsigned int uiGoRice ) const
+	{
+		return uiSymbol < (unsigned int)REMAINING_BITS_TABLE_SIZE ? aaiBits[uiGoRice][uiSymbol] : getRemainingBits( uiSymbol, uiGoRice ) << FRAC_BITS_SCALE;
+	}
+};
+
+static const RemainingBitsTable s_cRemainingBits;
+
+// ====================================================================================================================
+// Rate estimates
+// ====================================================================================================================
+
+static inline void setBinBits( int* piBits, double dProbOne )
+{
+	piBits[0] = (int)( -log2( 1.0 - dProbOne ) * ( 1 << FRAC_BITS_SCALE ) + 0.5 );
+	piBits[1] = (int)( -log2( dProbOne ) * ( 1 << FRAC_BITS_SCALE ) + 0.5 );
+}
+
+/**
+ * Probabilities of a typical intra coded residual: significance falls with the distance to DC and rises
+ * with the number of significant neighbour groups, large levels get rarer along each coefficient group.
+ */
+void GvcEstBitsSbac::setDefault()
+{
+	for( int ch = 0; ch < MAX_NUM_CHANNEL_TYPE; ch++ )
+	{
+		const bool bLuma = ch == CHANNEL_TYPE_LUMA;
+		for( int ctx = 0; ctx < NUM_QT_CBF_CTX_PER_SET; ctx++ )
+		{
+			setBinBits( blockCbpBits[ch][ctx], bLuma ? 0.6 : 0.35 );
+		}
+		setBinBits( significantCoeffGroupBits[ch][0], 0.35 );
+		setBinBits( significantCoeffGroupBits[ch][1], 0.75 );
+
+		setBinBits( significantBits[ch][0], 0.8 );
+		for( int ctx = 1; ctx < 9; ctx++ )
+		{
+			setBinBits( significantBits[ch][ctx], 0.7 - 0.05 * ctx );
+		}
+		const int iNumSigCtx = bLuma ? NUM_SIG_FLAG_CTX_LUMA : NUM_SIG_FLAG_CTX_CHROMA;
+		for( int ctx = 9; ctx < NUM_SIG_FLAG_CTX; ctx++ )
+		{
+			// neighbourhood contexts come in sets of three: no, one or both neighbour groups significant
+			const int iSet = ( ctx - 9 ) / 3;
+			const int iCnt = ( ctx - 9 ) % 3;
+			const double dFirstGroup = bLuma && ( iSet & 1 ) == 0 ? 0.05 : 0.0;
+			setBinBits( significantBits[ch][ctx], ctx < iNumSigCtx ? 0.25 + 0.15 * iCnt + dFirstGroup : 0.5 );
+		}
+
+		for( int ctx = 0; ctx < NUM_CTX_LAST_FLAG_XY; ctx++ )
+		{
+			setBinBits( lastXBits[ch][ctx], 0.5 );
+			setBinBits( lastYBits[ch][ctx], 0.5 );
+		}
+		static const double adGreaterOneProb[4] = { 0.55, 0.35, 0.25, 0.2 };
+		for( int ctx = 0; ctx < NUM_ONE_FLAG_CTX; ctx++ )
+		{
+			setBinBits( greaterOneBits[ch][ctx], adGreaterOneProb[ctx & 3] );
+		}
+		for( int ctx = 0; ctx < NUM_ABS_FLAG_CTX; ctx++ )
+		{
+			setBinBits( levelAbsBits[ch][ctx], 0.4 );
+		}
+	}
+}
+
+// ====================================================================================================================
+// Constructor / destructor / create / destroy
+// ====================================================================================================================
+
+GvcTrQuant::GvcTrQuant()
+	: m_bUseRDOQ( false )
+	, m_eScalingListMode( SCALING_LIST_OFF )
+{
+	for( int comp = 0; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		m_adLambda[comp] = 0.0;
+	}
+	memset( m_aaapiQuantCoef, 0, sizeof( m_aaapiQuantCoef ) );
+	memset( m_aaapiDequantCoef, 0, sizeof( m_aaapiDequantCoef ) );
+	memset( m_aaapdErrScale, 0, sizeof( m_aaapdErrScale ) );
+	m_cEstBits.setDefault();
+}
+
+GvcTrQuant::~GvcTrQuant()
+{
+	destroy();
+}
+
+void GvcTrQuant::create()
+{
+	if( m_aaapiQuantCoef[0][0][0] )
+	{
+		return;
+	}
+	for( int iSizeIdx = 0; iSizeIdx < NUM_TRANSFORM_SIZES; iSizeIdx++ )
+	{
+		const int iNumCoeff = ( MIN_TU_SIZE << iSizeIdx ) * ( MIN_TU_SIZE << iSizeIdx );
+		for( int iList = 0; iList < SCALING_LIST_NUM; iList++ )
+		{
+			for( int iRem = 0; iRem < SCALING_LIST_REM_NUM; iRem++ )
+			{
+				m_aaapiQuantCoef[iSizeIdx][iList][iRem] = new int[iNumCoeff];
+				m_aaapiDequantCoef[iSizeIdx][iList][iRem] = new int[iNumCoeff];
+				m_aaapdErrScale[iSizeIdx][iList][iRem] = new double[iNumCoeff];
+			}
+		}
+	}
+}
+
+void GvcTrQuant::destroy()
+{
+	for( int iSizeIdx = 0; iSizeIdx < NUM_TRANSFORM_SIZES; iSizeIdx++ )
+	{
+		for( int iList = 0; iList < SCALING_LIST_NUM; iList++ )
+		{
+			for( int iRem = 0; iRem < SCALING_LIST_REM_NUM; iRem++ )
+			{
+				delete[] m_aaapiQuantCoef[iSizeIdx][iList][iRem];
+				delete[] m_aaapiDequantCoef[iSizeIdx][iList][iRem];
+				delete[] m_aaapdErrScale[iSizeIdx][iList][iRem];
+				m_aaapiQuantCoef[iSizeIdx][iList][iRem] = NULL;
+				m_aaapiDequantCoef[iSizeIdx][iList][iRem] = NULL;
+				m_aaapdErrScale[iSizeIdx][iList][iRem] = NULL;
+			}
+		}
+	}
+}
+
+void GvcTrQuant::init( bool bUseRDOQ, ScalingListMode eScalingListMode )
+{
+	m_bUseRDOQ = bUseRDOQ;
+	m_eScalingListMode = eScalingListMode;
+	xSetScalingList();
+}
+
+/**
+ * Flat quantization is the scaling list with every entry at 16, so both cases share the per-position
+ * tables. The default 8x8 matrices are replicated for the 16x16 and 32x32 blocks, whose DC keeps 16.
+ */
+void GvcTrQuant::xSetScalingList()
+{
+	int aiList8x8[64];
+	for( int iList = 0; iList < SCALING_LIST_NUM; iList++ )
+	{
+		const int* piDefault = iList < MAX_NUM_COMPONENT ? g_quantIntraDefault8x8 : g_quantInterDefault8x8;
+		for( int i = 0; i < 64; i++ )
+		{
+			aiList8x8[g_auiDiagScan8x8[i]] = m_eScalingListMode == SCALING_LIST_DEFAULT ? piDefault[i] : 1 << LOG2_SCALING_LIST_NEUTRAL_VALUE;
+		}
+		for( int iSizeIdx = 0; iSizeIdx < NUM_TRANSFORM_SIZES; iSizeIdx++ )
+		{
+			const int iSize = MIN_TU_SIZE << iSizeIdx;
+			const int iRatio = iSize / 8;
+			for( int iRem = 0; iRem < SCALING_LIST_REM_NUM; iRem++ )
+			{
+				int* piQuant = m_aaapiQuantCoef[iSizeIdx][iList][iRem];
+				int* piDequant = m_aaapiDequantCoef[iSizeIdx][iList][iRem];
+				double* pdErrScale = m_aaapdErrScale[iSizeIdx][iList][iRem];
+				for( int y = 0; y < iSize; y++ )
+				{
+					for( int x = 0; x < iSize; x++ )
+					{
+						int iScale = 1 << LOG2_SCALING_LIST_NEUTRAL_VALUE;
+						if( iSize > 4 && ( x || y ) )
+						{
+							iScale = aiList8x8[( y / iRatio ) * 8 + x / iRatio];
+						}
+						const int iPos = y * iSize + x;
+						piQuant[iPos] = ( g_quantScales[iRem] << LOG2_SCALING_LIST_NEUTRAL_VALUE ) / iScale;
+						piDequant[iPos] = g_invQuantScales[iRem] * iScale;
+						pdErrScale[iPos] = 1.0 / ( (double)piQuant[iPos] * piQuant[iPos] );
+					}
+				}
+			}
+		}
+	}
+}
+
+void GvcTrQuant::setQP( int iQpY, ChromaFormat chFmt )
+{
+	m_acQP[COMPONENT_Y].setQp( iQpY );
+	for( int comp = COMPONENT_Cb; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		m_acQP[comp].setQp( getScaledChromaQP( iQpY, chFmt ) );
+	}
+}
+
+void GvcTrQuant::setLambda( double dLambda )
+{
+	for( int comp = 0; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		m_adLambda[comp] = dLambda / pow( 2.0, ( m_acQP[COMPONENT_Y].iQp - m_acQP[comp].iQp ) / 3.0 );
+	}
+}
+
+// ====================================================================================================================
+// Public member functions
+// ====================================================================================================================
+
+void GvcTrQuant::transformNxN( const ComponentID compID, PredMode ePredMode, const short* pResi, int iResiStride, TCoeff* pLevel, unsigned int uiSize,
+							   bool bUseDST, int iBitDepth, COEFF_SCAN_TYPE eScanIdx, GvcTUCoeffInfo& rcInfo )
+{
+	const unsigned int uiLog2Size = getTransformSizeIdx( uiSize ) + MIN_LOG2_TU_SIZE;
+	xT( pResi, iResiStride, m_aiCoeff, uiSize, bUseDST, iBitDepth );
+	if( m_bUseRDOQ )
+	{
+		rcInfo.uiAbsSum = xRateDistOptQuant( compID, ePredMode, m_aiCoeff, pLevel, uiLog2Size, iBitDepth, eScanIdx );
+	}
+	else
+	{
+		rcInfo.uiAbsSum = xQuant( compID, ePredMode, m_aiCoeff, pLevel, uiLog2Size, iBitDepth );
+	}
+
+	const ChannelType chType = toChannelType( compID );
+	rcInfo.iLastScanPos = -1;
+	rcInfo.uiLastPosX = rcInfo.uiLastPosY = 0;
+	if( !rcInfo.uiAbsSum )
+	{
+		rcInfo.iFracBits = m_cEstBits.blockCbpBits[chType][0][0];
+		return;
+	}
+	const unsigned short* puiScan = g_auiScanOrder[eScanIdx][uiLog2Size - MIN_LOG2_TU_SIZE];
+	int iScanPos = uiSize * uiSize - 1;
+	while( !pLevel[puiScan[iScanPos]] )
+	{
+		iScanPos--;
+	}
+	rcInfo.iLastScanPos = iScanPos;
+	rcInfo.uiLastPosX = puiScan[iScanPos] & ( uiSize - 1 );
+	rcInfo.uiLastPosY = puiScan[iScanPos] >> uiLog2Size;
+	rcInfo.iFracBits = xGetCoeffBits( chType, pLevel, uiLog2Size, eScanIdx, iScanPos );
+}
+
+void GvcTrQuant::invTransformNxN( const ComponentID compID, PredMode ePredMode, const TCoeff* pLevel, short* pResi, int iResiStride, unsigned int uiSize,
+								  bool bUseDST, int iBitDepth, COEFF_SCAN_TYPE eScanIdx, const GvcTUCoeffInfo& rcInfo )
+{
+	if( !rcInfo.uiAbsSum )
+	{
+		for( unsigned int y = 0; y < uiSize; y++ )
+		{
+			memset( pResi + y * iResiStride, 0, uiSize * sizeof( short ) );
+		}
+		return;
+	}
+	const unsigned int uiLog2Size = getTransformSizeIdx( uiSize ) + MIN_LOG2_TU_SIZE;
+	int iNumRows, iNumCols;
+	getNonZeroRegion( uiSize, rcInfo.uiLastPosX, rcInfo.uiLastPosY, eScanIdx, iNumRows, iNumCols );
+	// the levels are contiguous by rows, only the rows that may hold one are scaled (the kernels take multiples of 8)
+	const int iNumCoeff = std::max<int>( iNumRows * uiSize, 16 );
+	xDeQuant( compID, ePredMode, pLevel, m_aiCoeff, uiLog2Size, iBitDepth, iNumCoeff );
+	xIT( m_aiCoeff, pResi, iResiStride, uiSize, bUseDST, iBitDepth, iNumRows, iNumCols );
+}
+
+/**
+ * Coefficients are scanned in 4x4 sub-blocks. With the diagonal scan every position coded before the
+ * last one lies on an earlier or the same anti-diagonal, of sub-blocks or of positions inside a single
+ * 4x4 block. The horizontal scan can only reach the sub-block rows up to the last one and the vertical
+ * scan the sub-block columns up to the last one.
+ */
+COEFF_SCAN_TYPE GvcTrQuant::getCoefScanIdx( const ComponentID compID, const ChromaFormat chFmt, PredMode ePredMode, unsigned int uiDirMode, unsigned int uiSize )
+{
+	if( ePredMode != MODE_INTRA || uiSize > (unsigned int)( MDCS_MAXIMUM_WIDTH >> getComponentScaleX( compID, chFmt ) ) ||
+		uiSize > (unsigned int)( MDCS_MAXIMUM_WIDTH >> getComponentScaleY( compID, chFmt ) ) )
+	{
+		return SCAN_DIAG;
+	}
+	if( abs( (int)uiDirMode - VER_IDX ) <= MDCS_ANGLE_LIMIT )
+	{
+		return SCAN_HOR;
+	}
+	if( abs( (int)uiDirMode - HOR_IDX ) <= MDCS_ANGLE_LIMIT )
+	{
+		return SCAN_VER;
+	}
+	return SCAN_DIAG;
+}
+
+void GvcTrQuant::getNonZeroRegion( unsigned int uiSize, unsigned int uiLastPosX, unsigned int uiLastPosY, COEFF_SCAN_TYPE eScanIdx, int& riNumRows, int& riNumCols )
+{
+	switch( eScanIdx )
+	{
+	case SCAN_HOR:
+		riNumRows = std::min<int>( uiSize, ( uiLastPosY | 3 ) + 1 );
+		riNumCols = uiSize;
+		break;
+	case SCAN_VER:
+		riNumRows = uiSize;
+		riNumCols = std::min<int>( uiSize, ( uiLastPosX | 3 ) + 1 );
+		break;
+	default:
+		if( uiSize == 4 )
+		{
+			riNumRows = riNumCols = std::min<int>( 4, uiLastPosX + uiLastPosY + 1 );
+		}
+		else
+		{
+			riNumRows = riNumCols = std::min<int>( uiSize, 4 * ( ( uiLastPosX >> 2 ) + ( uiLastPosY >> 2 ) + 1 ) );
+		}
+		break;
+	}
+}
+
+int GvcTrQuant::getSigCtxInc( int iPatternSigCtx, unsigned int uiLog2Size, ChannelType chType, COEFF_SCAN_TYPE eScanIdx, unsigned int uiPosX, unsigned int uiPosY )
+{
+	if( uiPosX + uiPosY == 0 )
+	{
+		return 0;
+	}
+	if( uiLog2Size == 2 )
+	{
+		return s_aucCtxIndMap4x4[( uiPosY << 2 ) + uiPosX];
+	}
+	int iCnt = 0;
+	switch( iPatternSigCtx )
+	{
+	case 0:
+	{
+		const unsigned int uiPosTotalInSubset = ( uiPosX & 3 ) + ( uiPosY & 3 );
+		iCnt = uiPosTotalInSubset >= 3 ? 0 : ( uiPosTotalInSubset > 0 ? 1 : 2 );
+		break;
+	}
+	case 1:
+		iCnt = ( uiPosY & 3 ) >= 2 ? 0 : ( ( uiPosY & 3 ) > 0 ? 1 : 2 );
+		break;
+	case 2:
+		iCnt = ( uiPosX & 3 ) >= 2 ? 0 : ( ( uiPosX & 3 ) > 0 ? 1 : 2 );
+		break;
+	default:
+		iCnt = 2;
+		break;
+	}
+	int iFirstCtx = significanceMapContextSetStart[chType][2];
+	if( uiLog2Size == 3 )
+	{
+		iFirstCtx = significanceMapContextSetStart[chType][1] + ( eScanIdx != SCAN_DIAG ? nonDiagonalScan8x8ContextOffset[chType] : 0 );
+	}
+	const bool bNotFirstGroup = ( ( uiPosX >> 2 ) + ( uiPosY >> 2 ) ) > 0;
+	return iFirstCtx + ( bNotFirstGroup ? notFirstGroupNeighbourhoodContextOffset[chType] : 0 ) + iCnt;
+}
+
+void GvcTrQuant::getLastSignificantContextParameters( unsigned int uiLog2Size, ChannelType chType, int& riOffset, int& riShift )
+{
+	if( isLuma( chType ) )
+	{
+		riOffset = 3 * ( uiLog2Size - 2 ) + ( ( uiLog2Size - 1 ) >> 2 );
+		riShift = ( uiLog2Size + 1 ) >> 2;
+	}
+	else
+	{
+		riOffset = 0;
+		riShift = uiLog2Size - 2;
+	}
+}
+
+// ====================================================================================================================
+// Private member functions
+// ====================================================================================================================
+
+void GvcTrQuant::xT( const short* pResi, int iResiStride, TCoeff* pCoeff, unsigned int uiSize, bool bUseDST, int iBitDepth )
+{
+	if( bUseDST && uiSize == 4 )
+	{
+		g_gvcPrimitives.fwdDst4x4( pResi, iResiStride, pCoeff, iBitDepth );
+		return;
+	}
+	g_gvcPrimitives.fwdDct[getTransformSizeIdx( uiSize )]( pResi, iResiStride, pCoeff, iBitDepth );
+}
+
+void GvcTrQuant::xIT( const TCoeff* pCoeff, short* pResi, int iResiStride, unsigned int uiSize, bool bUseDST, int iBitDepth, int iNumRows, int iNumCols )
+{
+	if( bUseDST && uiSize == 4 )
+	{
+		g_gvcPrimitives.invDst4x4( pCoeff, pResi, iResiStride, iBitDepth, iNumRows, iNumCols );
+		return;
+	}
+	g_gvcPrimitives.invDct[getTransformSizeIdx( uiSize )]( pCoeff, pResi, iResiStride, iBitDepth, iNumRows, iNumCols );
+}
+
+unsigned int GvcTrQuant::xQuant( const ComponentID compID, PredMode ePredMode, const TCoeff* pCoeff, TCoeff* pLevel, unsigned int uiLog2Size, int iBitDepth )
+{
+	const GvcQpParam& cQP = m_acQP[compID];
+	const int iQBits = QUANT_SHIFT + cQP.iPer + getTransformShift( iBitDepth, uiLog2Size, MAX_TR_DYNAMIC_RANGE );
+	const int iAdd = ( ePredMode == MODE_INTRA ? 171 : 85 ) << ( iQBits - 9 );
+	const int* piQuantCoef = m_aaapiQuantCoef[uiLog2Size - MIN_LOG2_TU_SIZE][getScalingListType( ePredMode, compID )][cQP.iRem];
+	return g_gvcPrimitives.quant( pCoeff, pLevel, piQuantCoef, iQBits, iAdd, 1 << ( 2 * uiLog2Size ) );
+}
+
+void GvcTrQuant::xDeQuant( const ComponentID compID, PredMode ePredMode, const TCoeff* pLevel, TCoeff* pCoeff, unsigned int uiLog2Size, int iBitDepth,
+						   int iNumCoeff )
+{
+	const GvcQpParam& cQP = m_acQP[compID];
+	const int iTransformShift = getTransformShift( iBitDepth, uiLog2Size, MAX_TR_DYNAMIC_RANGE );
+	const int iShift = IQUANT_SHIFT - ( iTransformShift + cQP.iPer ) + LOG2_SCALING_LIST_NEUTRAL_VALUE;
+	const int* piDequantCoef = m_aaapiDequantCoef[uiLog2Size - MIN_LOG2_TU_SIZE][getScalingListType( ePredMode, compID )][cQP.iRem];
+	g_gvcPrimitives.dequant( pLevel, pCoeff, piDequantCoef, iShift, iNumCoeff );
+}
+
+/** Rate of each last position prefix group, including the bypass coded suffix.
+ */
+void GvcTrQuant::xGetLastPosBits( ChannelType chType, unsigned int uiLog2Size, int* piLastXBits, int* piLastYBits ) const
+{
+	int iOffset, iShift;
+	getLastSignificantContextParameters( uiLog2Size, chType, iOffset, iShift );
+	const int iMaxGroup = g_uiGroupIdx[( 1 << uiLog2Size ) - 1];
+	int iBitsX = 0, iBitsY = 0;
+	for( int iGroup = 0; iGroup <= iMaxGroup; iGroup++ )
+	{
+		const int iCtx = iOffset + ( iGroup >> iShift );
+		const int iSuffix = iGroup > 3 ? ( ( iGroup >> 1 ) - 1 ) << FRAC_BITS_SCALE : 0;
+		piLastXBits[iGroup] = iBitsX + iSuffix + ( iGroup < iMaxGroup ? m_cEstBits.lastXBits[chType][iCtx][0] : 0 );
+		piLastYBits[iGroup] = iBitsY + iSuffix + ( iGroup < iMaxGroup ? m_cEstBits.lastYBits[chType][iCtx][0] : 0 );
+		iBitsX += m_cEstBits.lastXBits[chType][iCtx][1];
+		iBitsY += m_cEstBits.lastYBits[chType][iCtx][1];
+	}
+}
+
+/** Rate of a non-zero level, sign included, given the greater than 1/2 contexts and the Rice parameter.
+ */
+int GvcTrQuant::xGetICRate( unsigned int uiAbsLevel, int iCtxNumOne, int iCtxNumAbs, unsigned int uiGoRice, unsigned int c1Idx, unsigned int c2Idx,
+							ChannelType chType ) const
+{
+	int iRate = 1 << FRAC_BITS_SCALE;
+	const unsigned int uiBaseLevel = ( c1Idx < (unsigned int)C1FLAG_NUMBER ) ? ( 2 + ( c2Idx < (unsigned int)C2FLAG_NUMBER ) ) : 1;
+	if( uiAbsLevel >= uiBaseLevel )
+	{
+		iRate += s_cRemainingBits.get( uiAbsLevel - uiBaseLevel, uiGoRice );
+		if( c1Idx < (unsigned int)C1FLAG_NUMBER )
+		{
+			iRate += m_cEstBits.greaterOneBits[chType][iCtxNumOne][1];
+			if( c2Idx < (unsigned int)C2FLAG_NUMBER )
+			{
+				iRate += m_cEstBits.levelAbsBits[chType][iCtxNumAbs][1];
+			}
+		}
+	}
+	else if( uiAbsLevel == 1 )
+	{
+		iRate += m_cEstBits.greaterOneBits[chType][iCtxNumOne][0];
+	}
+	else if( uiAbsLevel == 2 )
+	{
+		iRate += m_cEstBits.greaterOneBits[chType][iCtxNumOne][1];
+		iRate += m_cEstBits.levelAbsBits[chType][iCtxNumAbs][0];
+	}
+	else
+	{
+		iRate = 0;
+	}
+	return iRate;
+}
+
+/** Best level of one coefficient among zero, the level rounded to nearest and the one below it.
+ */
+unsigned int GvcTrQuant::xGetCodedLevel( double& rdCodedCost, double& rdCodedCost0, double& rdCodedCostSig, long long iLevelDouble, unsigned int uiMaxAbsLevel,
+										 int iCtxNumSig, int iCtxNumOne, int iCtxNumAbs, unsigned int uiGoRice, unsigned int c1Idx, unsigned int c2Idx, int iQBits,
+										 double dErrScale, bool bLast, ChannelType chType, double dLambda ) const
+{
+	double dCurrCostSig = 0;
+	unsigned int uiBestAbsLevel = 0;
+	if( !bLast && uiMaxAbsLevel < 3 )
+	{
+		rdCodedCostSig = dLambda * m_cEstBits.significantBits[chType][iCtxNumSig][0];
+		rdCodedCost = rdCodedCost0 + rdCodedCostSig;
+		if( uiMaxAbsLevel == 0 )
+		{
+			return uiBestAbsLevel;
+		}
+	}
+	else
+	{
+		rdCodedCost = MAX_DOUBLE;
+	}
+	if( !bLast )
+	{
+		dCurrCostSig = dLambda * m_cEstBits.significantBits[chType][iCtxNumSig][1];
+	}
+	const unsigned int uiMinAbsLevel = uiMaxAbsLevel > 1 ? uiMaxAbsLevel - 1 : 1;
+	for( unsigned int uiAbsLevel = uiMaxAbsLevel; uiAbsLevel >= uiMinAbsLevel; uiAbsLevel-- )
+	{
+		const double dErr = double( iLevelDouble - ( (long long)uiAbsLevel << iQBits ) );
+		const double dCurrCost = dErr * dErr * dErrScale + dLambda * xGetICRate( uiAbsLevel, iCtxNumOne, iCtxNumAbs, uiGoRice, c1Idx, c2Idx, chType ) + dCurrCostSig;
+		if( dCurrCost < rdCodedCost )
+		{
+			uiBestAbsLevel = uiAbsLevel;
+			rdCodedCost = dCurrCost;
+			rdCodedCostSig = dCurrCostSig;
+		}
+	}
+	return uiBestAbsLevel;
+}
+
+/**
+ * Rate-distortion optimized quantization. Each level is chosen among zero, the level rounded to nearest
+ * and the one below, then whole coefficient groups are zeroed when that is cheaper, then the last
+ * position is moved back while it pays off, and finally the block is compared with not coding it.
+ * Blocks whose levels are all zero when rounded to nearest are left at once.
+ */
+unsigned int GvcTrQuant::xRateDistOptQuant( const ComponentID compID, PredMode ePredMode, const TCoeff* pCoeff, TCoeff* pLevel, unsigned int uiLog2Size,
+											int iBitDepth, COEFF_SCAN_TYPE eScanIdx )
+{
+	const ChannelType chType = toChannelType( compID );
+	const bool bLuma = isLuma( chType );
+	const GvcQpParam& cQP = m_acQP[compID];
+	const int iSizeIdx = uiLog2Size - MIN_LOG2_TU_SIZE;
+	const int iListType = getScalingListType( ePredMode, compID );
+	const int iNumCoeff = 1 << ( 2 * uiLog2Size );
+	const int iTransformShift = getTransformShift( iBitDepth, uiLog2Size, MAX_TR_DYNAMIC_RANGE );
+	const int iQBits = QUANT_SHIFT + cQP.iPer + iTransformShift;
+	const int* piQuantCoef = m_aaapiQuantCoef[iSizeIdx][iListType][cQP.iRem];
+	const double* pdErrScale = m_aaapdErrScale[iSizeIdx][iListType][cQP.iRem];
+	const double dTransformScale = pow( 2.0, -2.0 * iTransformShift );
+	const double dLambda = m_adLambda[compID] / ( 1 << FRAC_BITS_SCALE );
+
+	// early termination: nothing survives even the largest rounding offset
+	if( !g_gvcPrimitives.quant( pCoeff, m_aiMaxLevel, piQuantCoef, iQBits, 1 << ( iQBits - 1 ), iNumCoeff ) )
+	{
+		memset( pLevel, 0, iNumCoeff * sizeof( TCoeff ) );
+		return 0;
+	}
+
+	const unsigned short* puiScan = g_auiScanOrder[eScanIdx][iSizeIdx];
+	const int iLog2Groups = uiLog2Size - 2;
+	const int iNumGroups = iNumCoeff >> 4;
+	const unsigned int uiSizeMask = ( 1 << uiLog2Size ) - 1;
+	int aiLastXBits[LAST_SIGNIFICANT_GROUPS], aiLastYBits[LAST_SIGNIFICANT_GROUPS];
+	xGetLastPosBits( chType, uiLog2Size, aiLastXBits, aiLastYBits );
+
+	bool abSigGroup[64];
+	double adCostGroupSig[64];
+	memset( abSigGroup, 0, sizeof( abSigGroup ) );
+	memset( adCostGroupSig, 0, sizeof( adCostGroupSig ) );
+	memset( pLevel, 0, iNumCoeff * sizeof( TCoeff ) );
+
+	double dBlockUncodedCost = 0;
+	double dBaseCost = 0;
+	int iLastScanPos = -1;
+	int iGroupLastScanPos = -1;
+	unsigned int c1 = 1, c1Idx = 0, c2Idx = 0, uiGoRice = 0;
+	int iCtxSet = 0;
+
+	for( int iGroupScanPos = iNumGroups - 1; iGroupScanPos >= 0; iGroupScanPos-- )
+	{
+		const unsigned int uiGroupX = ( puiScan[iGroupScanPos << 4] & uiSizeMask ) >> 2;
+		const unsigned int uiGroupY = ( puiScan[iGroupScanPos << 4] >> uiLog2Size ) >> 2;
+		const int iGroupPos = ( uiGroupY << iLog2Groups ) + uiGroupX;
+		const unsigned int uiSigRight = uiGroupX + 1 < ( 1u << iLog2Groups ) ? abSigGroup[iGroupPos + 1] : 0;
+		const unsigned int uiSigLower = uiGroupY + 1 < ( 1u << iLog2Groups ) ? abSigGroup[iGroupPos + ( 1 << iLog2Groups )] : 0;
+		const int iPatternSigCtx = uiSigRight + ( uiSigLower << 1 );
+
+		double dCodedLevelAndDist = 0, dUncodedDist = 0, dSigCost = 0;
+		int iNumNonZero = 0;
+		for( int iScanPosInGroup = 15; iScanPosInGroup >= 0; iScanPosInGroup-- )
+		{
+			const int iScanPos = ( iGroupScanPos << 4 ) + iScanPosInGroup;
+			const unsigned int uiBlkPos = puiScan[iScanPos];
+			const unsigned int uiMaxAbsLevel = std::abs( m_aiMaxLevel[uiBlkPos] );
+			const long long iLevelDouble = (long long)std::abs( pCoeff[uiBlkPos] ) * piQuantCoef[uiBlkPos];
+			const double dErrScale = pdErrScale[uiBlkPos] * dTransformScale;
+
+			m_adCostCoeff0[iScanPos] = double( iLevelDouble ) * double( iLevelDouble ) * dErrScale;
+			dBlockUncodedCost += m_adCostCoeff0[iScanPos];
+			m_adCostSig[iScanPos] = 0;
+
+			if( uiMaxAbsLevel && iLastScanPos < 0 )
+			{
+				iLastScanPos = iScanPos;
+				iGroupLastScanPos = iGroupScanPos;
+				iCtxSet = ( iGroupScanPos > 0 && bLuma ) ? 2 : 0;
+			}
+			if( iLastScanPos >= 0 )
+			{
+				const unsigned int uiPosX = uiBlkPos & uiSizeMask;
+				const unsigned int uiPosY = uiBlkPos >> uiLog2Size;
+				const int iCtxSig = iScanPos == iLastScanPos ? 0 : getSigCtxInc( iPatternSigCtx, uiLog2Size, chType, eScanIdx, uiPosX, uiPosY );
+				const unsigned int uiLevel =
+					xGetCodedLevel( m_adCostCoeff[iScanPos], m_adCostCoeff0[iScanPos], m_adCostSig[iScanPos], iLevelDouble, uiMaxAbsLevel, iCtxSig, iCtxSet * 4 + c1,
+									iCtxSet, uiGoRice, c1Idx, c2Idx, iQBits, dErrScale, iScanPos == iLastScanPos, chType, dLambda );
+				pLevel[uiBlkPos] = uiLevel;
+				dBaseCost += m_adCostCoeff[iScanPos];
+
+				const unsigned int uiBaseLevel = ( c1Idx < (unsigned int)C1FLAG_NUMBER ) ? ( 2 + ( c2Idx < (unsigned int)C2FLAG_NUMBER ) ) : 1;
+				if( uiLevel >= uiBaseLevel && uiLevel > ( 3u << uiGoRice ) )
+				{
+					uiGoRice = std::min<unsigned int>( uiGoRice + 1, MAX_GO_RICE_PARAMETER );
+				}
+				if( uiLevel >= 1 )
+				{
+					c1Idx++;
+				}
+				if( uiLevel > 1 )
+				{
+					c1 = 0;
+					c2Idx++;
+				}
+				else if( c1 < 3 && c1 > 0 && uiLevel )
+				{
+					c1++;
+				}
+				if( iScanPosInGroup == 0 )
+				{
+					// context set of the next group
+					iCtxSet = ( ( iGroupScanPos - 1 ) > 0 && bLuma ) ? 2 : 0;
+					iCtxSet += c1 == 0;
+					c1 = 1;
+					c1Idx = 0;
+					c2Idx = 0;
+					uiGoRice = 0;
+				}
+			}
+			else
+			{
+				dBaseCost += m_adCostCoeff0[iScanPos];
+			}
+			dSigCost += m_adCostSig[iScanPos];
+			if( pLevel[uiBlkPos] )
+			{
+				iNumNonZero++;
+				dCodedLevelAndDist += m_adCostCoeff[iScanPos] - m_adCostSig[iScanPos];
+				dUncodedDist += m_adCostCoeff0[iScanPos];
+			}
+		}
+
+		if( iLastScanPos < 0 )
+		{
+			continue;
+		}
+		if( iGroupScanPos == 0 )
+		{
+			abSigGroup[iGroupPos] = true;
+			continue;
+		}
+		const int iCtxGroup = std::min<unsigned int>( uiSigRight + uiSigLower, 1 );
+		if( !iNumNonZero )
+		{
+			// the significance flags of an empty group are not coded, only its group flag
+			adCostGroupSig[iGroupScanPos] = dLambda * m_cEstBits.significantCoeffGroupBits[chType][iCtxGroup][0];
+			dBaseCost += adCostGroupSig[iGroupScanPos] - dSigCost;
+			continue;
+		}
+		abSigGroup[iGroupPos] = true;
+		if( iGroupScanPos < iGroupLastScanPos )
+		{
+			double dCostZeroGroup = dBaseCost;
+			adCostGroupSig[iGroupScanPos] = dLambda * m_cEstBits.significantCoeffGroupBits[chType][iCtxGroup][1];
+			dBaseCost += adCostGroupSig[iGroupScanPos];
+			const double dCostGroupSig0 = dLambda * m_cEstBits.significantCoeffGroupBits[chType][iCtxGroup][0];
+			dCostZeroGroup += dCostGroupSig0 + dUncodedDist - dCodedLevelAndDist - dSigCost;
+			if( dCostZeroGroup < dBaseCost )
+			{
+				abSigGroup[iGroupPos] = false;
+				dBaseCost = dCostZeroGroup;
+				adCostGroupSig[iGroupScanPos] = dCostGroupSig0;
+				for( int iScanPosInGroup = 15; iScanPosInGroup >= 0; iScanPosInGroup-- )
+				{
+					const int iScanPos = ( iGroupScanPos << 4 ) + iScanPosInGroup;
+					if( pLevel[puiScan[iScanPos]] )
+					{
+						pLevel[puiScan[iScanPos]] = 0;
+						m_adCostCoeff[iScanPos] = m_adCostCoeff0[iScanPos];
+					}
+					m_adCostSig[iScanPos] = 0;
+				}
+			}
+		}
+	}
+
+	// last position: walk back from the initial one, each step drops the level and codes a closer position
+	double dBestCost = dBlockUncodedCost + dLambda * m_cEstBits.blockCbpBits[chType][0][0];
+	dBaseCost += dLambda * m_cEstBits.blockCbpBits[chType][0][1];
+	int iBestLastIdxP1 = 0;
+	bool bFoundLast = false;
+	for( int iGroupScanPos = iGroupLastScanPos; iGroupScanPos >= 0 && !bFoundLast; iGroupScanPos-- )
+	{
+		const unsigned int uiGroupBlkPos = puiScan[iGroupScanPos << 4];
+		const int iGroupPos = ( ( ( uiGroupBlkPos >> uiLog2Size ) >> 2 ) << iLog2Groups ) + ( ( uiGroupBlkPos & uiSizeMask ) >> 2 );
+		dBaseCost -= adCostGroupSig[iGroupScanPos];
+		if( !abSigGroup[iGroupPos] )
+		{
+			continue;
+		}
+		for( int iScanPosInGroup = 15; iScanPosInGroup >= 0; iScanPosInGroup-- )
+		{
+			const int iScanPos = ( iGroupScanPos << 4 ) + iScanPosInGroup;
+			if( iScanPos > iLastScanPos )
+			{
+				continue;
+			}
+			const unsigned int uiBlkPos = puiScan[iScanPos];
+			if( pLevel[uiBlkPos] )
+			{
+				const unsigned int uiPosX = uiBlkPos & uiSizeMask;
+				const unsigned int uiPosY = uiBlkPos >> uiLog2Size;
+				const int iLastBits = eScanIdx == SCAN_VER ? aiLastXBits[g_uiGroupIdx[uiPosY]] + aiLastYBits[g_uiGroupIdx[uiPosX]]
+														   : aiLastXBits[g_uiGroupIdx[uiPosX]] + aiLastYBits[g_uiGroupIdx[uiPosY]];
+				const double dTotalCost = dBaseCost + dLambda * iLastBits - m_adCostSig[iScanPos];
+				if( dTotalCost < dBestCost )
+				{
+					iBestLastIdxP1 = iScanPos + 1;
+					dBestCost = dTotalCost;
+				}
+				if( pLevel[uiBlkPos] > 1 )
+				{
+					bFoundLast = true;
+					break;
+				}
+				dBaseCost -= m_adCostCoeff[iScanPos];
+				dBaseCost += m_adCostCoeff0[iScanPos];
+			}
+			else
+			{
+				dBaseCost -= m_adCostSig[iScanPos];
+			}
+		}
+	}
+
+	unsigned int uiAbsSum = 0;
+	for( int iScanPos = 0; iScanPos < iBestLastIdxP1; iScanPos++ )
+	{
+		const unsigned int uiBlkPos = puiScan[iScanPos];
+		const TCoeff iLevel = pLevel[uiBlkPos];
+		uiAbsSum += iLevel;
+		pLevel[uiBlkPos] = pCoeff[uiBlkPos] < 0 ? -iLevel : iLevel;
+	}
+	for( int iScanPos = iBestLastIdxP1; iScanPos <= iLastScanPos; iScanPos++ )
+	{
+		pLevel[puiScan[iScanPos]] = 0;
+	}
+	return uiAbsSum;
+}
+
+/** Rate of the coded block flag, the last position and the levels, following the coding order.
+ */
+int GvcTrQuant::xGetCoeffBits( ChannelType chType, const TCoeff* pLevel, unsigned int uiLog2Size, COEFF_SCAN_TYPE eScanIdx, int iLastScanPos ) const
+{
+	const bool bLuma = isLuma( chType );
+	const unsigned short* puiScan = g_auiScanOrder[eScanIdx][uiLog2Size - MIN_LOG2_TU_SIZE];
+	const int iLog2Groups = uiLog2Size - 2;
+	const unsigned int uiSizeMask = ( 1 << uiLog2Size ) - 1;
+	int aiLastXBits[LAST_SIGNIFICANT_GROUPS], aiLastYBits[LAST_SIGNIFICANT_GROUPS];
+	xGetLastPosBits( chType, uiLog2Size, aiLastXBits, aiLastYBits );
+
+	int iBits = m_cEstBits.blockCbpBits[chType][0][1];
+	const unsigned int uiLastPosX = puiScan[iLastScanPos] & uiSizeMask;
+	const unsigned int uiLastPosY = puiScan[iLastScanPos] >> uiLog2Size;
+	iBits += eScanIdx == SCAN_VER ? aiLastXBits[g_uiGroupIdx[uiLastPosY]] + aiLastYBits[g_uiGroupIdx[uiLastPosX]]
+								  : aiLastXBits[g_uiGroupIdx[uiLastPosX]] + aiLastYBits[g_uiGroupIdx[uiLastPosY]];
+
+	bool abSigGroup[64];
+	memset( abSigGroup, 0, sizeof( abSigGroup ) );
+	const int iGroupLastScanPos = iLastScanPos >> 4;
+	unsigned int c1 = 1;
+	for( int iGroupScanPos = iGroupLastScanPos; iGroupScanPos >= 0; iGroupScanPos-- )
+	{
+		const unsigned int uiGroupX = ( puiScan[iGroupScanPos << 4] & uiSizeMask ) >> 2;
+		const unsigned int uiGroupY = ( puiScan[iGroupScanPos << 4] >> uiLog2Size ) >> 2;
+		const int iGroupPos = ( uiGroupY << iLog2Groups ) + uiGroupX;
+		const unsigned int uiSigRight = uiGroupX + 1 < ( 1u << iLog2Groups ) ? abSigGroup[iGroupPos + 1] : 0;
+		const unsigned int uiSigLower = uiGroupY + 1 < ( 1u << iLog2Groups ) ? abSigGroup[iGroupPos + ( 1 << iLog2Groups )] : 0;
+		const int iPatternSigCtx = uiSigRight + ( uiSigLower << 1 );
+
+		bool bNonZero = false;
+		for( int iScanPos = iGroupScanPos << 4; iScanPos < ( iGroupScanPos + 1 ) << 4 && !bNonZero; iScanPos++ )
+		{
+			bNonZero = pLevel[puiScan[iScanPos]] != 0;
+		}
+		if( iGroupScanPos > 0 && iGroupScanPos < iGroupLastScanPos )
+		{
+			iBits += m_cEstBits.significantCoeffGroupBits[chType][std::min<unsigned int>( uiSigRight + uiSigLower, 1 )][bNonZero];
+		}
+		if( !bNonZero )
+		{
+			continue;
+		}
+		abSigGroup[iGroupPos] = true;
+
+		int iCtxSet = ( iGroupScanPos > 0 && bLuma ) ? 2 : 0;
+		iCtxSet += c1 == 0;
+		c1 = 1;
+		unsigned int c1Idx = 0, c2Idx = 0, uiGoRice = 0;
+		for( int iScanPosInGroup = 15; iScanPosInGroup >= 0; iScanPosInGroup-- )
+		{
+			const int iScanPos = ( iGroupScanPos << 4 ) + iScanPosInGroup;
+			if( iScanPos > iLastScanPos )
+			{
+				continue;
+			}
+			const unsigned int uiBlkPos = puiScan[iScanPos];
+			const unsigned int uiLevel = std::abs( pLevel[uiBlkPos] );
+			if( iScanPos != iLastScanPos )
+			{
+				const int iCtxSig = getSigCtxInc( iPatternSigCtx, uiLog2Size, chType, eScanIdx, uiBlkPos & uiSizeMask, uiBlkPos >> uiLog2Size );
+				iBits += m_cEstBits.significantBits[chType][iCtxSig][uiLevel != 0];
+			}
+			if( !uiLevel )
+			{
+				continue;
+			}
+			iBits += xGetICRate( uiLevel, iCtxSet * 4 + c1, iCtxSet, uiGoRice, c1Idx, c2Idx, chType );
+
+			const unsigned int uiBaseLevel = ( c1Idx < (unsigned int)C1FLAG_NUMBER ) ? ( 2 + ( c2Idx < (unsigned int)C2FLAG_NUMBER ) ) : 1;
+			if( uiLevel >= uiBaseLevel && uiLevel > ( 3u << uiGoRice ) )
+			{
+				uiGoRice = std::min<unsigned int>( uiGoRice + 1, MAX_GO_RICE_PARAMETER );
+			}
+			c1Idx++;
+			if( uiLevel > 1 )
+			{
+				c1 = 0;
+				c2Idx++;
+			}
+			else if( c1 < 3 && c1 > 0 )
+			{
+				c1++;
+			}
+		}
+	}
+	return iBits;
+}
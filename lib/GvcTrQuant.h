@@ -0,0 +1,174 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcTrQuant.h
+ * \brief    Transform and quantization of the residual blocks
+ */
+
+#ifndef __GVCTRQUANT_H__
+#define __GVCTRQUANT_H__
+
+#include "TypeDef.h"
+#include "GvcContextTables.h"
+#include "GvcPrimitives.h"
+#include "GvcRom.h"
+
+// ====================================================================================================================
+// Constants
+// ====================================================================================================================
+
+static const int QUANT_SHIFT = 14;                    ///< precision of the forward quantization scales
+static const int IQUANT_SHIFT = 6;                    ///< precision of the inverse quantization scales
+static const int LOG2_SCALING_LIST_NEUTRAL_VALUE = 4; ///< a scaling list entry of 16 leaves the step size unchanged
+static const int C1FLAG_NUMBER = 8;                   ///< greater than 1 flags coded per coefficient group
+static const int C2FLAG_NUMBER = 1;                   ///< greater than 2 flags coded per coefficient group
+static const int COEF_REMAIN_BIN_REDUCTION = 3;       ///< prefix length switching the remaining level to Exp-Golomb
+static const int MAX_GO_RICE_PARAMETER = 4;
+static const int MDCS_ANGLE_LIMIT = 4;                ///< intra modes this close to horizontal/vertical use a mode dependent scan
+static const int MDCS_MAXIMUM_WIDTH = 8;              ///< largest luma transform using a mode dependent scan
+
+/// scaling list selection
+enum ScalingListMode
+{
+	SCALING_LIST_OFF = 0,      ///< flat quantization
+	SCALING_LIST_DEFAULT = 1,  ///< default frequency weighting matrices
+	SCALING_LIST_FILE_READ = 2 ///< matrices read from a file (not supported)
+};
+
+// ====================================================================================================================
+// Type definition
+// ====================================================================================================================
+
+/// quantization parameter split into the step size octave and its position inside the octave
+struct GvcQpParam
+{
+	int iQp;
+	int iPer;
+	int iRem;
+
+	GvcQpParam() : iQp( 0 ), iPer( 0 ), iRem( 0 ) {}
+	void setQp( int qp )
+	{
+		iQp = qp;
+		iPer = qp / 6;
+		iRem = qp % 6;
+	}
+};
+
+/**
+ * \struct   GvcEstBitsSbac
+ * \brief    Rate of each residual syntax element bin value, in 1 / 32768 bit, per context model
+ *
+ * Filled from the entropy coder contexts when available, otherwise from a fixed probability model.
+ */
+struct GvcEstBitsSbac
+{
+	int blockCbpBits[MAX_NUM_CHANNEL_TYPE][NUM_QT_CBF_CTX_PER_SET][2];
+	int significantCoeffGroupBits[MAX_NUM_CHANNEL_TYPE][NUM_SIG_CG_FLAG_CTX][2];
+	int significantBits[MAX_NUM_CHANNEL_TYPE][NUM_SIG_FLAG_CTX][2];
+	int lastXBits[MAX_NUM_CHANNEL_TYPE][NUM_CTX_LAST_FLAG_XY][2];
+	int lastYBits[MAX_NUM_CHANNEL_TYPE][NUM_CTX_LAST_FLAG_XY][2];
+	int greaterOneBits[MAX_NUM_CHANNEL_TYPE][NUM_ONE_FLAG_CTX][2];
+	int levelAbsBits[MAX_NUM_CHANNEL_TYPE][NUM_ABS_FLAG_CTX][2];
+
+	void setDefault();
+};
+
+/// summary of the quantized levels of a transform unit
+struct GvcTUCoeffInfo
+{
+	unsigned int uiAbsSum;    ///< sum of absolute levels, 0 for a block without coded coefficients
+	int iLastScanPos;         ///< scan position of the last significant level, -1 if none
+	unsigned int uiLastPosX;
+	unsigned int uiLastPosY;
+	int iFracBits;            ///< estimated rate of the coded block flag and of the levels, 1 / 32768 bit
+};
+
+/**
+ * \class    GvcTrQuant
+ * \brief    Square transform units from 4x4 to 32x32, DCT or 4x4 DST, uniform or rate-distortion optimized quantization
+ */
+class GvcTrQuant
+{
+  public:
+	GvcTrQuant();
+	virtual ~GvcTrQuant();
+
+	void create();
+	void destroy();
+	void init( bool bUseRDOQ, ScalingListMode eScalingListMode );
+
+	/// QP of the luma component, the chroma QPs follow the mapping of the chroma format
+	void setQP( int iQpY, ChromaFormat chFmt );
+	const GvcQpParam& getQP( const ComponentID compID ) const { return m_acQP[compID]; }
+	/// lambda per bit of the luma component, chroma lambdas are scaled by the luma to chroma step size ratio
+	void setLambda( double dLambda );
+	GvcEstBitsSbac& getEstBits() { return m_cEstBits; }
+
+	/// forward transform and quantization, pLevel receives the levels in raster order
+	void transformNxN( const ComponentID compID, PredMode ePredMode, const short* pResi, int iResiStride, TCoeff* pLevel, unsigned int uiSize, bool bUseDST,
+					   int iBitDepth, COEFF_SCAN_TYPE eScanIdx, GvcTUCoeffInfo& rcInfo );
+	/// dequantization and inverse transform of the levels produced by transformNxN
+	void invTransformNxN( const ComponentID compID, PredMode ePredMode, const TCoeff* pLevel, short* pResi, int iResiStride, unsigned int uiSize, bool bUseDST,
+						  int iBitDepth, COEFF_SCAN_TYPE eScanIdx, const GvcTUCoeffInfo& rcInfo );
+
+	/// coefficient scan of a transform unit: intra modes near horizontal (vertical) scan small blocks vertically (horizontally)
+	static COEFF_SCAN_TYPE getCoefScanIdx( const ComponentID compID, const ChromaFormat chFmt, PredMode ePredMode, unsigned int uiDirMode, unsigned int uiSize );
+	/// rows and columns of the top-left area that can hold non-zero coefficients given the last significant position
+	static void getNonZeroRegion( unsigned int uiSize, unsigned int uiLastPosX, unsigned int uiLastPosY, COEFF_SCAN_TYPE eScanIdx, int& riNumRows, int& riNumCols );
+	/// context of the significance flag at (uiPosX, uiPosY) given the coded group flags at the right and below
+	static int getSigCtxInc( int iPatternSigCtx, unsigned int uiLog2Size, ChannelType chType, COEFF_SCAN_TYPE eScanIdx, unsigned int uiPosX, unsigned int uiPosY );
+	/// context of the first last position prefix bin and the bins sharing each context
+	static void getLastSignificantContextParameters( unsigned int uiLog2Size, ChannelType chType, int& riOffset, int& riShift );
+
+  private:
+	bool m_bUseRDOQ;
+	ScalingListMode m_eScalingListMode;
+	GvcQpParam m_acQP[MAX_NUM_COMPONENT];
+	double m_adLambda[MAX_NUM_COMPONENT];
+	GvcEstBitsSbac m_cEstBits;
+
+	int* m_aaapiQuantCoef[NUM_TRANSFORM_SIZES][SCALING_LIST_NUM][SCALING_LIST_REM_NUM];    ///< forward scale per raster position
+	int* m_aaapiDequantCoef[NUM_TRANSFORM_SIZES][SCALING_LIST_NUM][SCALING_LIST_REM_NUM];  ///< inverse scale per raster position
+	double* m_aaapdErrScale[NUM_TRANSFORM_SIZES][SCALING_LIST_NUM][SCALING_LIST_REM_NUM];  ///< 1 / scale^2, squared error of a level to distortion
+
+	TCoeff m_aiCoeff[MAX_TU_SIZE * MAX_TU_SIZE];       ///< transform coefficients / dequantized levels
+	TCoeff m_aiMaxLevel[MAX_TU_SIZE * MAX_TU_SIZE];    ///< RDOQ: levels rounded to nearest
+	double m_adCostCoeff[MAX_TU_SIZE * MAX_TU_SIZE];   ///< RDOQ: cost of the chosen level, per scan position
+	double m_adCostSig[MAX_TU_SIZE * MAX_TU_SIZE];     ///< RDOQ: cost of the significance flag, per scan position
+	double m_adCostCoeff0[MAX_TU_SIZE * MAX_TU_SIZE];  ///< RDOQ: cost of quantizing to zero, per scan position
+
+	void xSetScalingList();
+	void xT( const short* pResi, int iResiStride, TCoeff* pCoeff, unsigned int uiSize, bool bUseDST, int iBitDepth );
+	void xIT( const TCoeff* pCoeff, short* pResi, int iResiStride, unsigned int uiSize, bool bUseDST, int iBitDepth, int iNumRows, int iNumCols );
+	unsigned int xQuant( const ComponentID compID, PredMode ePredMode, const TCoeff* pCoeff, TCoeff* pLevel, unsigned int uiLog2Size, int iBitDepth );
+	unsigned int xRateDistOptQuant( const ComponentID compID, PredMode ePredMode, const TCoeff* pCoeff, TCoeff* pLevel, unsigned int uiLog2Size, int iBitDepth,
+									COEFF_SCAN_TYPE eScanIdx );
+	void xDeQuant( const ComponentID compID, PredMode ePredMode, const TCoeff* pLevel, TCoeff* pCoeff, unsigned int uiLog2Size, int iBitDepth, int iNumCoeff );
+
+	void xGetLastPosBits( ChannelType chType, unsigned int uiLog2Size, int* piLastXBits, int* piLastYBits ) const;
+	int xGetICRate( unsigned int uiAbsLevel, int iCtxNumOne, int iCtxNumAbs, unsigned int uiGoRice, unsigned int c1Idx, unsigned int c2Idx, ChannelType chType ) const;
+	unsigned int xGetCodedLevel( double& rdCodedCost, double& rdCodedCost0, double& rdCodedCostSig, long long iLevelDouble, unsigned int uiMaxAbsLevel, int iCtxNumSig,
+								 int iCtxNumOne, int iCtxNumAbs, unsigned int uiGoRice, unsigned int c1Idx, unsigned int c2Idx, int iQBits, double dErrScale,
+								 bool bLast, ChannelType chType, double dLambda ) const;
+	int xGetCoeffBits( ChannelType chType, const TCoeff* pLevel, unsigned int uiLog2Size, COEFF_SCAN_TYPE eScanIdx, int iLastScanPos ) const;
+};
+
+#endif  // __GVCTRQUANT_H__
@@ -0,0 +1,260 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcTransform.cpp
+ * \brief    Reference C++ implementation of the integer transforms (partial butterflies)
+ */
+
+#include "GvcPrimitives.h"
+#include "GvcRom.h"
+
+namespace
+{
+template <int N>
+inline const short* dctMatrix();
+template <>
+inline const short* dctMatrix<4>()
+{
+	return &g_aiT4[0][0];
+}
+template <>
+inline const short* dctMatrix<8>()
+{
+	return &g_aiT8[0][0];
+}
+template <>
+inline const short* dctMatrix<16>()
+{
+	return &g_aiT16[0][0];
+}
+template <>
+inline const short* dctMatrix<32>()
+{
+	return &g_aiT32[0][0];
+}
+
+inline int rightShiftRound( int iValue, int iShift )
+{
+	return ( iValue + ( 1 << ( iShift - 1 ) ) ) >> iShift;
+}
+
+inline int clipCoeff16( int iValue )
+{
+	return Clip3( -32768, 32767, iValue );
+}
+
+/// unscaled N-point forward DCT of one line, odd outputs from the differences, even outputs recursively
+template <int N>
+inline void partialButterfly( const int* pSrc, int* pDst )
+{
+	const short* M = dctMatrix<N>();
+	int aiE[N / 2], aiO[N / 2], aiEven[N / 2];
+	for( int k = 0; k < N / 2; k++ )
+	{
+		aiE[k] = pSrc[k] + pSrc[N - 1 - k];
+		aiO[k] = pSrc[k] - pSrc[N - 1 - k];
+	}
+	for( int k = 1; k < N; k += 2 )
+	{
+		int iSum = 0;
+		for( int n = 0; n < N / 2; n++ )
+		{
+			iSum += M[k * N + n] * aiO[n];
+		}
+		pDst[k] = iSum;
+	}
+	partialButterfly<N / 2>( aiE, aiEven );
+	for( int k = 0; k < N / 2; k++ )
+	{
+		pDst[2 * k] = aiEven[k];
+	}
+}
+
+template <>
+inline void partialButterfly<4>( const int* pSrc, int* pDst )
+{
+	const int E0 = pSrc[0] + pSrc[3];
+	const int O0 = pSrc[0] - pSrc[3];
+	const int E1 = pSrc[1] + pSrc[2];
+	const int O1 = pSrc[1] - pSrc[2];
+	pDst[0] = g_aiT4[0][0] * E0 + g_aiT4[0][1] * E1;
+	pDst[2] = g_aiT4[2][0] * E0 + g_aiT4[2][1] * E1;
+	pDst[1] = g_aiT4[1][0] * O0 + g_aiT4[1][1] * O1;
+	pDst[3] = g_aiT4[3][0] * O0 + g_aiT4[3][1] * O1;
+}
+
+/// unscaled N-point inverse DCT of one line where only the first iLimit coefficients may be non-zero
+template <int N>
+inline void partialButterflyInverse( const int* pSrc, int iLimit, int* pDst )
+{
+	const short* M = dctMatrix<N>();
+	int aiO[N / 2], aiE[N / 2], aiEvenSrc[N / 2];
+	for( int n = 0; n < N / 2; n++ )
+	{
+		int iSum = 0;
+		for( int k = 1; k < iLimit; k += 2 )
+		{
+			iSum += M[k * N + n] * pSrc[k];
+		}
+		aiO[n] = iSum;
+	}
+	const int iEvenLimit = ( iLimit + 1 ) >> 1;
+	for( int k = 0; k < iEvenLimit; k++ )
+	{
+		aiEvenSrc[k] = pSrc[2 * k];
+	}
+	partialButterflyInverse<N / 2>( aiEvenSrc, iEvenLimit, aiE );
+	for( int n = 0; n < N / 2; n++ )
+	{
+		pDst[n] = aiE[n] + aiO[n];
+		pDst[N - 1 - n] = aiE[n] - aiO[n];
+	}
+}
+
+template <>
+inline void partialButterflyInverse<4>( const int* pSrc, int iLimit, int* pDst )
+{
+	const int c0 = iLimit > 0 ? pSrc[0] : 0;
+	const int c1 = iLimit > 1 ? pSrc[1] : 0;
+	const int c2 = iLimit > 2 ? pSrc[2] : 0;
+	const int c3 = iLimit > 3 ? pSrc[3] : 0;
+	const int O0 = g_aiT4[1][0] * c1 + g_aiT4[3][0] * c3;
+	const int O1 = g_aiT4[1][1] * c1 + g_aiT4[3][1] * c3;
+	const int E0 = g_aiT4[0][0] * c0 + g_aiT4[2][0] * c2;
+	const int E1 = g_aiT4[0][1] * c0 + g_aiT4[2][1] * c2;
+	pDst[0] = E0 + O0;
+	pDst[1] = E1 + O1;
+	pDst[2] = E1 - O1;
+	pDst[3] = E0 - O0;
+}
+
+inline void forwardDst( const int* pSrc, int* pDst )
+{
+	for( int k = 0; k < 4; k++ )
+	{
+		pDst[k] = g_as_DST_MAT_4[k][0] * pSrc[0] + g_as_DST_MAT_4[k][1] * pSrc[1] + g_as_DST_MAT_4[k][2] * pSrc[2] + g_as_DST_MAT_4[k][3] * pSrc[3];
+	}
+}
+
+inline void inverseDst( const int* pSrc, int iLimit, int* pDst )
+{
+	for( int n = 0; n < 4; n++ )
+	{
+		int iSum = 0;
+		for( int k = 0; k < iLimit; k++ )
+		{
+			iSum += g_as_DST_MAT_4[k][n] * pSrc[k];
+		}
+		pDst[n] = iSum;
+	}
+}
+
+template <int N>
+struct Dct
+{
+	static void forward( const int* pSrc, int* pDst ) { partialButterfly<N>( pSrc, pDst ); }
+	static void inverse( const int* pSrc, int iLimit, int* pDst ) { partialButterflyInverse<N>( pSrc, iLimit, pDst ); }
+};
+
+struct Dst
+{
+	static void forward( const int* pSrc, int* pDst ) { forwardDst( pSrc, pDst ); }
+	static void inverse( const int* pSrc, int iLimit, int* pDst ) { inverseDst( pSrc, iLimit, pDst ); }
+};
+
+/// rows first (shift log2(N) + bitDepth - 9), then columns (shift log2(N) + 6), as in HM
+template <int N, int LOG2N, class T>
+void fwdTransform_c( const short* pResi, int iResiStride, TCoeff* pCoeff, int iBitDepth )
+{
+	const int iShift1st = LOG2N + iBitDepth - 9;
+	const int iShift2nd = LOG2N + 6;
+	int aiTmp[N * N];
+	int aiLine[N], aiOut[N];
+	for( int r = 0; r < N; r++ )
+	{
+		for( int n = 0; n < N; n++ )
+		{
+			aiLine[n] = pResi[r * iResiStride + n];
+		}
+		T::forward( aiLine, aiOut );
+		for( int k = 0; k < N; k++ )
+		{
+			aiTmp[r * N + k] = rightShiftRound( aiOut[k], iShift1st );
+		}
+	}
+	for( int k = 0; k < N; k++ )
+	{
+		for( int r = 0; r < N; r++ )
+		{
+			aiLine[r] = aiTmp[r * N + k];
+		}
+		T::forward( aiLine, aiOut );
+		for( int m = 0; m < N; m++ )
+		{
+			pCoeff[m * N + k] = rightShiftRound( aiOut[m], iShift2nd );
+		}
+	}
+}
+
+/// columns first (shift 7), then rows (shift 20 - bitDepth); both stages clip to 16 bits, as in HM
+template <int N, class T>
+void invTransform_c( const TCoeff* pCoeff, short* pResi, int iResiStride, int iBitDepth, int iNumRows, int iNumCols )
+{
+	const int iShift1st = 7;
+	const int iShift2nd = 20 - iBitDepth;
+	int aiTmp[N * N];
+	int aiLine[N], aiOut[N];
+	// columns right of iNumCols only hold zero coefficients and are not needed by the second stage
+	for( int k = 0; k < iNumCols; k++ )
+	{
+		for( int m = 0; m < iNumRows; m++ )
+		{
+			aiLine[m] = pCoeff[m * N + k];
+		}
+		T::inverse( aiLine, iNumRows, aiOut );
+		for( int n = 0; n < N; n++ )
+		{
+			aiTmp[n * N + k] = clipCoeff16( rightShiftRound( aiOut[n], iShift1st ) );
+		}
+	}
+	for( int n = 0; n < N; n++ )
+	{
+		T::inverse( aiTmp + n * N, iNumCols, aiOut );
+		for( int m = 0; m < N; m++ )
+		{
+			pResi[n * iResiStride + m] = (short)clipCoeff16( rightShiftRound( aiOut[m], iShift2nd ) );
+		}
+	}
+}
+}  // namespace
+
+void setupTransformPrimitivesC( GvcPrimitives& p )
+{
+	p.fwdDct[TRANSFORM_4x4] = fwdTransform_c<4, 2, Dct<4> >;
+	p.fwdDct[TRANSFORM_8x8] = fwdTransform_c<8, 3, Dct<8> >;
+	p.fwdDct[TRANSFORM_16x16] = fwdTransform_c<16, 4, Dct<16> >;
+	p.fwdDct[TRANSFORM_32x32] = fwdTransform_c<32, 5, Dct<32> >;
+	p.invDct[TRANSFORM_4x4] = invTransform_c<4, Dct<4> >;
+	p.invDct[TRANSFORM_8x8] = invTransform_c<8, Dct<8> >;
+	p.invDct[TRANSFORM_16x16] = invTransform_c<16, Dct<16> >;
+	p.invDct[TRANSFORM_32x32] = invTransform_c<32, Dct<32> >;
+	p.fwdDst4x4 = fwdTransform_c<4, 2, Dst>;
+	p.invDst4x4 = invTransform_c<4, Dst>;
+}
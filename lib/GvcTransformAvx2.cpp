@@ -0,0 +1,220 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcTransformAvx2.cpp
+ * \brief    AVX2 implementation of the 8x8 to 32x32 integer transforms
+ *
+ * Each 1D stage is a matrix product along the columns: two input rows are interleaved so that one
+ * madd multiplies a pair of samples of eight columns by a pair of basis coefficients. Row stages are
+ * obtained by transposing around a column stage. The 4x4 transforms stay on the C path.
+ */
+
+#include <immintrin.h>
+
+#include "GvcPrimitives.h"
+#include "GvcRom.h"
+
+namespace
+{
+/// basis coefficients packed two per 32-bit word: forward pairs run along n, inverse pairs along k
+template <int N>
+struct MatrixPairs
+{
+	int aiFwd[N][N / 2];
+	int aiInv[N][N / 2];
+
+	void init( const short* M )
+	{
+		for( int k = 0; k < N; k++ )
+		{
+			for( int j = 0; j < N / 2; j++ )
+			{
+				// the low and high halves of the pair, packed as unsigned values: the coefficients may be negative
+				aiFwd[k][j] = (int)( (unsigned short)M[k * N + 2 * j] | ( (unsigned int)(unsigned short)M[k * N + 2 * j + 1] << 16 ) );
+				aiInv[k][j] = (int)( (unsigned short)M[2 * j * N + k] | ( (unsigned int)(unsigned short)M[( 2 * j + 1 ) * N + k] << 16 ) );
+			}
+		}
+	}
+};
+
+MatrixPairs<8> s_cPairs8;
+MatrixPairs<16> s_cPairs16;
+MatrixPairs<32> s_cPairs32;
+
+template <int N>
+inline const MatrixPairs<N>& matrixPairs();
+template <>
+inline const MatrixPairs<8>& matrixPairs<8>()
+{
+	return s_cPairs8;
+}
+template <>
+inline const MatrixPairs<16>& matrixPairs<16>()
+{
+	return s_cPairs16;
+}
+template <>
+inline const MatrixPairs<32>& matrixPairs<32>()
+{
+	return s_cPairs32;
+}
+
+inline void transpose8x8( const short* pSrc, int iSrcStride, short* pDst, int iDstStride )
+{
+	__m128i r[8];
+	for( int i = 0; i < 8; i++ )
+	{
+		r[i] = _mm_loadu_si128( (const __m128i*)( pSrc + i * iSrcStride ) );
+	}
+	const __m128i t0 = _mm_unpacklo_epi16( r[0], r[1] );
+	const __m128i t1 = _mm_unpackhi_epi16( r[0], r[1] );
+	const __m128i t2 = _mm_unpacklo_epi16( r[2], r[3] );
+	const __m128i t3 = _mm_unpackhi_epi16( r[2], r[3] );
+	const __m128i t4 = _mm_unpacklo_epi16( r[4], r[5] );
+	const __m128i t5 = _mm_unpackhi_epi16( r[4], r[5] );
+	const __m128i t6 = _mm_unpacklo_epi16( r[6], r[7] );
+	const __m128i t7 = _mm_unpackhi_epi16( r[6], r[7] );
+	const __m128i u0 = _mm_unpacklo_epi32( t0, t2 );
+	const __m128i u1 = _mm_unpackhi_epi32( t0, t2 );
+	const __m128i u2 = _mm_unpacklo_epi32( t1, t3 );
+	const __m128i u3 = _mm_unpackhi_epi32( t1, t3 );
+	const __m128i u4 = _mm_unpacklo_epi32( t4, t6 );
+	const __m128i u5 = _mm_unpackhi_epi32( t4, t6 );
+	const __m128i u6 = _mm_unpacklo_epi32( t5, t7 );
+	const __m128i u7 = _mm_unpackhi_epi32( t5, t7 );
+	_mm_storeu_si128( (__m128i*)( pDst + 0 * iDstStride ), _mm_unpacklo_epi64( u0, u4 ) );
+	_mm_storeu_si128( (__m128i*)( pDst + 1 * iDstStride ), _mm_unpackhi_epi64( u0, u4 ) );
+	_mm_storeu_si128( (__m128i*)( pDst + 2 * iDstStride ), _mm_unpacklo_epi64( u1, u5 ) );
+	_mm_storeu_si128( (__m128i*)( pDst + 3 * iDstStride ), _mm_unpackhi_epi64( u1, u5 ) );
+	_mm_storeu_si128( (__m128i*)( pDst + 4 * iDstStride ), _mm_unpacklo_epi64( u2, u6 ) );
+	_mm_storeu_si128( (__m128i*)( pDst + 5 * iDstStride ), _mm_unpackhi_epi64( u2, u6 ) );
+	_mm_storeu_si128( (__m128i*)( pDst + 6 * iDstStride ), _mm_unpacklo_epi64( u3, u7 ) );
+	_mm_storeu_si128( (__m128i*)( pDst + 7 * iDstStride ), _mm_unpackhi_epi64( u3, u7 ) );
+}
+
+/// transposes the first iNumColGroups groups of 8 columns of an N-row block
+template <int N>
+inline void transpose( const short* pSrc, int iSrcStride, short* pDst, int iDstStride, int iNumColGroups )
+{
+	for( int i = 0; i < N / 8; i++ )
+	{
+		for( int j = 0; j < iNumColGroups; j++ )
+		{
+			transpose8x8( pSrc + 8 * i * iSrcStride + 8 * j, iSrcStride, pDst + 8 * j * iDstStride + 8 * i, iDstStride );
+		}
+	}
+}
+
+/**
+ * One 1D stage along the columns: pDst[k][c] = round( sum_j pair(k, j) . (pSrc[2j][c], pSrc[2j+1][c]) ) >> iShift
+ * for the first iNumPairs row pairs of the source and the first iNumColGroups groups of 8 columns.
+ * The result is saturated to 16 bits, or stored as 32-bit coefficients when STORE32 is set.
+ */
+template <int N, bool STORE32>
+inline void transformColumns( const short* pSrc, int iSrcStride, const int ( *paiPairs )[N / 2], int iNumPairs, int iNumColGroups, int iShift, void* pDst, int iDstStride )
+{
+	const __m256i vRound = _mm256_set1_epi32( 1 << ( iShift - 1 ) );
+	for( int g = 0; g < iNumColGroups; g++ )
+	{
+		__m256i avIn[N / 2];
+		for( int j = 0; j < iNumPairs; j++ )
+		{
+			const __m128i a = _mm_loadu_si128( (const __m128i*)( pSrc + 2 * j * iSrcStride + 8 * g ) );
+			const __m128i b = _mm_loadu_si128( (const __m128i*)( pSrc + ( 2 * j + 1 ) * iSrcStride + 8 * g ) );
+			avIn[j] = _mm256_set_m128i( _mm_unpackhi_epi16( a, b ), _mm_unpacklo_epi16( a, b ) );
+		}
+		for( int k = 0; k < N; k++ )
+		{
+			__m256i vSum = _mm256_setzero_si256();
+			for( int j = 0; j < iNumPairs; j++ )
+			{
+				vSum = _mm256_add_epi32( vSum, _mm256_madd_epi16( avIn[j], _mm256_set1_epi32( paiPairs[k][j] ) ) );
+			}
+			vSum = _mm256_srai_epi32( _mm256_add_epi32( vSum, vRound ), iShift );
+			if( STORE32 )
+			{
+				_mm256_storeu_si256( (__m256i*)( (int*)pDst + k * iDstStride + 8 * g ), vSum );
+			}
+			else
+			{
+				const __m128i vPacked = _mm_packs_epi32( _mm256_castsi256_si128( vSum ), _mm256_extracti128_si256( vSum, 1 ) );
+				_mm_storeu_si128( (__m128i*)( (short*)pDst + k * iDstStride + 8 * g ), vPacked );
+			}
+		}
+	}
+}
+
+template <int N, int LOG2N>
+void fwdDct_avx2( const short* pResi, int iResiStride, TCoeff* pCoeff, int iBitDepth )
+{
+	const MatrixPairs<N>& cPairs = matrixPairs<N>();
+	short asTmp0[N * N];
+	short asTmp1[N * N];
+	// rows: transform the columns of the transposed residual
+	transpose<N>( pResi, iResiStride, asTmp0, N, N / 8 );
+	transformColumns<N, false>( asTmp0, N, cPairs.aiFwd, N / 2, N / 8, LOG2N + iBitDepth - 9, asTmp1, N );
+	// columns
+	transpose<N>( asTmp1, N, asTmp0, N, N / 8 );
+	transformColumns<N, true>( asTmp0, N, cPairs.aiFwd, N / 2, N / 8, LOG2N + 6, pCoeff, N );
+}
+
+/// only the iNumRows x iNumCols top-left coefficients are read and transformed
+template <int N>
+void invDct_avx2( const TCoeff* pCoeff, short* pResi, int iResiStride, int iBitDepth, int iNumRows, int iNumCols )
+{
+	const MatrixPairs<N>& cPairs = matrixPairs<N>();
+	const int iRowPairs = ( iNumRows + 1 ) >> 1;
+	const int iColPairs = ( iNumCols + 1 ) >> 1;
+	const int iColGroups = ( iNumCols + 7 ) >> 3;
+	short asCoeff[N * N];
+	short asTmp0[N * N];
+	short asTmp1[N * N];
+
+	// 16-bit copy of the non-zero region
+	for( int m = 0; m < 2 * iRowPairs; m++ )
+	{
+		for( int g = 0; g < iColGroups; g++ )
+		{
+			const __m256i v = _mm256_loadu_si256( (const __m256i*)( pCoeff + m * N + 8 * g ) );
+			_mm_storeu_si128( (__m128i*)( asCoeff + m * N + 8 * g ), _mm_packs_epi32( _mm256_castsi256_si128( v ), _mm256_extracti128_si256( v, 1 ) ) );
+		}
+	}
+	// columns, the groups right of the non-zero region stay zero and are never read
+	transformColumns<N, false>( asCoeff, N, cPairs.aiInv, iRowPairs, iColGroups, 7, asTmp0, N );
+	// rows
+	transpose<N>( asTmp0, N, asTmp1, N, iColGroups );
+	transformColumns<N, false>( asTmp1, N, cPairs.aiInv, iColPairs, N / 8, 20 - iBitDepth, asTmp0, N );
+	transpose<N>( asTmp0, N, pResi, iResiStride, N / 8 );
+}
+}  // namespace
+
+void setupTransformPrimitivesAvx2( GvcPrimitives& p )
+{
+	s_cPairs8.init( &g_aiT8[0][0] );
+	s_cPairs16.init( &g_aiT16[0][0] );
+	s_cPairs32.init( &g_aiT32[0][0] );
+
+	p.fwdDct[TRANSFORM_8x8] = fwdDct_avx2<8, 3>;
+	p.fwdDct[TRANSFORM_16x16] = fwdDct_avx2<16, 4>;
+	p.fwdDct[TRANSFORM_32x32] = fwdDct_avx2<32, 5>;
+	p.invDct[TRANSFORM_8x8] = invDct_avx2<8>;
+	p.invDct[TRANSFORM_16x16] = invDct_avx2<16>;
+	p.invDct[TRANSFORM_32x32] = invDct_avx2<32>;
+}
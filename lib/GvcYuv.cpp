@@ -0,0 +1,146 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcYuv.cpp
+ * \brief    General YUV buffer for a block unit
+ */
+
+#include "GvcYuv.h"
+
+#include <cstring>
+
+#include "GvcFrameUnit.h"
+#include "GvcRom.h"
+
+GvcYuv::GvcYuv()
+	: m_iWidth( 0 ), m_iHeight( 0 ), m_chromaFormatIDC( CHROMA_420 )
+{
+	for( unsigned int comp = 0; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		m_apiBuf[comp] = NULL;
+	}
+}
+
+GvcYuv::~GvcYuv()
+{
+	destroy();
+}
+
+void GvcYuv::create( unsigned int iWidth, unsigned int iHeight, ChromaFormat chromaFormatIDC )
+{
+	m_iWidth = iWidth;
+	m_iHeight = iHeight;
+	m_chromaFormatIDC = chromaFormatIDC;
+	for( unsigned int comp = 0; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		m_apiBuf[comp] = (short*)xMalloc( short, getWidth( compID ) * getHeight( compID ) );
+	}
+}
+
+void GvcYuv::destroy()
+{
+	for( unsigned int comp = 0; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		if( m_apiBuf[comp] )
+		{
+			xFree( m_apiBuf[comp] );
+			m_apiBuf[comp] = NULL;
+		}
+	}
+}
+
+void GvcYuv::clear()
+{
+	for( unsigned int comp = 0; comp < MAX_NUM_COMPONENT; comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		memset( m_apiBuf[comp], 0, sizeof( short ) * getWidth( compID ) * getHeight( compID ) );
+	}
+}
+
+short* GvcYuv::getAddr( const ComponentID id, const unsigned int uiPartUnitIdx )
+{
+	const int iOffsetX = g_auiZscanToPelX[uiPartUnitIdx] >> getComponentScaleX( id );
+	const int iOffsetY = g_auiZscanToPelY[uiPartUnitIdx] >> getComponentScaleY( id );
+	return m_apiBuf[id] + iOffsetY * getStride( id ) + iOffsetX;
+}
+
+unsigned int GvcYuv::getSize() const
+{
+	unsigned int uiSize = 0;
+	for( unsigned int comp = 0; comp < getNumberValidComponents(); comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		uiSize += getWidth( compID ) * getHeight( compID ) * sizeof( short );
+	}
+	return uiSize;
+}
+
+unsigned int GvcYuv::copyToFrame( GvcFrameUnit* pcFrameDst, unsigned int buRsAddr, unsigned int uiAbsZorderIdx )
+{
+	const int iBUPelX = ( buRsAddr % pcFrameDst->getFrameWidthInBUs() ) * pcFrameDst->getMaxBUWidth() + g_auiZscanToPelX[uiAbsZorderIdx];
+	const int iBUPelY = ( buRsAddr / pcFrameDst->getFrameWidthInBUs() ) * pcFrameDst->getMaxBUHeight() + g_auiZscanToPelY[uiAbsZorderIdx];
+	const int iWidth = std::min<int>( m_iWidth, pcFrameDst->getWidth( COMPONENT_Y ) - iBUPelX );
+	const int iHeight = std::min<int>( m_iHeight, pcFrameDst->getHeight( COMPONENT_Y ) - iBUPelY );
+	unsigned int uiBytes = 0;
+
+	for( unsigned int comp = 0; comp < getNumberValidComponents(); comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		const int iCompWidth = iWidth >> getComponentScaleX( compID );
+		const int iCompHeight = iHeight >> getComponentScaleY( compID );
+		const int iSrcStride = getStride( compID );
+		const int iDstStride = pcFrameDst->getStride( compID );
+		const short* pSrc = getAddr( compID );
+		short* pDst = pcFrameDst->getAddr( compID, buRsAddr, uiAbsZorderIdx );
+		for( int y = 0; y < iCompHeight; y++ )
+		{
+			memcpy( pDst, pSrc, sizeof( short ) * iCompWidth );
+			pSrc += iSrcStride;
+			pDst += iDstStride;
+		}
+		uiBytes += sizeof( short ) * iCompWidth * iCompHeight;
+	}
+	return uiBytes;
+}
+
+unsigned int GvcYuv::copyToPartYuv( GvcYuv* pcYuvDst, unsigned int uiDstPartIdx )
+{
+	unsigned int uiBytes = 0;
+	for( unsigned int comp = 0; comp < getNumberValidComponents(); comp++ )
+	{
+		const ComponentID compID = ComponentID( comp );
+		const int iWidth = getWidth( compID );
+		const int iHeight = getHeight( compID );
+		const int iSrcStride = getStride( compID );
+		const int iDstStride = pcYuvDst->getStride( compID );
+		const short* pSrc = getAddr( compID );
+		short* pDst = pcYuvDst->getAddr( compID, uiDstPartIdx );
+		for( int y = 0; y < iHeight; y++ )
+		{
+			memcpy( pDst, pSrc, sizeof( short ) * iWidth );
+			pSrc += iSrcStride;
+			pDst += iDstStride;
+		}
+		uiBytes += sizeof( short ) * iWidth * iHeight;
+	}
+	return uiBytes;
+}
@@ -0,0 +1,72 @@
+/*    This file is a part of GVC project
+ *    Copyright (C) 2018  by Ricardo Monteiro
+ *                           Joao Carreira
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     GvcYuv.h
+ * \brief    General YUV buffer for a block unit
+ */
+
+#ifndef __GVCYUV_H__
+#define __GVCYUV_H__
+
+#include "TypeDef.h"
+#include "TComChromaFormat.h"
+
+class GvcFrameUnit;
+
+/**
+ * \class    GvcYuv
+ * \brief    YUV samples of a (sub) block unit, stored without margin
+ */
+class GvcYuv
+{
+  private:
+	short* m_apiBuf[MAX_NUM_COMPONENT];
+	unsigned int m_iWidth;
+	unsigned int m_iHeight;
+	ChromaFormat m_chromaFormatIDC;
+
+  public:
+	GvcYuv();
+	virtual ~GvcYuv();
+
+	void create( unsigned int iWidth, unsigned int iHeight, ChromaFormat chromaFormatIDC );
+	void destroy();
+	void clear();
+
+	/// copy the whole buffer into a frame at the given BU/partition, clipped to the frame area; returns the bytes copied
+	unsigned int copyToFrame( GvcFrameUnit* pcFrameDst, unsigned int buRsAddr, unsigned int uiAbsZorderIdx );
+	/// copy the whole buffer into a partition of a larger buffer; returns the bytes copied
+	unsigned int copyToPartYuv( GvcYuv* pcYuvDst, unsigned int uiDstPartIdx );
+
+	short* getAddr( const ComponentID id ) { return m_apiBuf[id]; }
+	const short* getAddr( const ComponentID id ) const { return m_apiBuf[id]; }
+	short* getAddr( const ComponentID id, const unsigned int uiPartUnitIdx );
+	int getStride( const ComponentID id ) const { return m_iWidth >> getComponentScaleX( id ); }
+	unsigned int getWidth( const ComponentID id ) const { return m_iWidth >> getComponentScaleX( id ); }
+	unsigned int getHeight( const ComponentID id ) const { return m_iHeight >> getComponentScaleY( id ); }
+	ChromaFormat getChromaFormat() const { return m_chromaFormatIDC; }
+	unsigned int getNumberValidComponents() const { return ::getNumberValidComponents( m_chromaFormatIDC ); }
+	unsigned int getComponentScaleX( const ComponentID id ) const { return ::getComponentScaleX( id, m_chromaFormatIDC ); }
+	unsigned int getComponentScaleY( const ComponentID id ) const { return ::getComponentScaleY( id, m_chromaFormatIDC ); }
+	/// bytes of sample data held by the buffer
+	unsigned int getSize() const;
+};
+
+#endif  // __GVCYUV_H__
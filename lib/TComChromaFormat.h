@@ -38,6 +38,7 @@
 #include <vector>
 #include <assert.h>
 #include "TypeDef.h"
+#include "GvcRom.h"
 
 
 //======================================================================================================================
@@ -155,7 +156,7 @@ static inline bool filterintraReferenceSamples (const ChannelType chType, const
 /*static inline bool TUCompRectHasAssociatedTransformSkipFlag(const TComRectangle &rectSamples, const unsigned int transformSkipLog2MaxSize)
 {
   return (rectSamples.width <= (1<<transformSkipLog2MaxSize));
-}
+}*/
 
 
 //------------------------------------------------
@@ -171,7 +172,7 @@ static inline int getTransformShift(const int channelBitDepth, const unsigned in
 static inline int getScaledChromaQP(int unscaledChromaQP, const ChromaFormat chFmt)
 {
   return g_aucChromaScale[chFmt][Clip3(0, (chromaQPMappingTableSize - 1), unscaledChromaQP)];
-}*/
+}
 
 
 //======================================================================================================================
@@ -5,6 +5,8 @@
 #ifndef GVC_TYPEDEF_H
 #define GVC_TYPEDEF_H
 
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
 
 //! \ingroup TLibCommon
@@ -17,6 +19,41 @@ template <typename T> inline T Clip3 (const T minVal, const T maxVal, const T a)
 static const unsigned int   MAX_UINT =                            0xFFFFFFFFU; ///< max. value of unsigned 32-bit integer
 static const int    MAX_INT =                              2147483647; ///< max. value of signed 32-bit integer
 static const double MAX_DOUBLE =                             1.7e+308; ///< max. value of Double-type value
+
+static const int MAX_BU_SIZE =                                     64; ///< max. BU width/height in pixels
+static const int MIN_BU_SIZE =                                      8; ///< min. coding unit width/height in pixels
+static const int MIN_PU_SIZE =                                      4; ///< size of the minimum partition (4x4 luma samples)
+static const int MAX_BU_DEPTH =                                     4; ///< max. number of quadtree levels below a BU (64 -> 8)
+static const int MAX_NUM_PART_IDXS_IN_BU_WIDTH = MAX_BU_SIZE / MIN_PU_SIZE; ///< max. number of minimum partitions in a BU row
+static const int MAX_NUM_PART_IDXS_IN_BU = MAX_NUM_PART_IDXS_IN_BU_WIDTH * MAX_NUM_PART_IDXS_IN_BU_WIDTH;
+static const int MAX_TU_SIZE =                                     32; ///< max. transform width/height
+static const int MIN_TU_SIZE =                                      4; ///< min. transform width/height
+static const int MAX_LOG2_TU_SIZE =                                 5;
+static const int MIN_LOG2_TU_SIZE =                                 2;
+static const int MAX_TR_DYNAMIC_RANGE =                            15; ///< coefficients are kept within 16 bits
+static const int MAX_QP =                                          51;
+static const int NTAPS_LUMA =                                       8; ///< taps of the luma interpolation filter
+static const int NTAPS_CHROMA =                                     4; ///< taps of the chroma interpolation filter
+static const int LUMA_INTERPOLATION_FILTER_SUB_SAMPLE_POSITIONS =   4; ///< luma vectors are in quarter samples
+static const int CHROMA_INTERPOLATION_FILTER_SUB_SAMPLE_POSITIONS = 8; ///< chroma phases are in eighth samples
+static const int IF_INTERNAL_PREC =                                14; ///< precision of the interpolation intermediates
+static const int IF_FILTER_PREC =                                   6; ///< log2 of the sum of the filter coefficients
+static const int IF_INTERNAL_OFFS =         1 << (IF_INTERNAL_PREC-1); ///< intermediates are centred on zero
+static const int NUM_PYRAMID_LEVELS =                               3; ///< full, half and quarter resolution luma of the hierarchical motion search
+
+static const int NUM_LUMA_MODE =                                   35; ///< planar, DC and 33 angular modes
+static const int NUM_CHROMA_MODE =                                  5; ///< planar, vertical, horizontal, DC and the luma mode
+static const int PLANAR_IDX =                                       0;
+static const int DC_IDX =                                           1;
+static const int HOR_IDX =                                         10;
+static const int DIA_IDX =                                         18;
+static const int VER_IDX =                                         26;
+static const int VDIA_IDX =                                        34;
+static const int DM_CHROMA_IDX =                                   36; ///< chroma mode derived from the luma mode
+static const int NUM_MOST_PROBABLE_MODES =                          3; ///< luma modes signalled with an index into the predictor list
+static const int FRAC_BITS_SCALE =                                 15; ///< estimated rates are in units of 1 / 32768 bit
+
+typedef       int             TCoeff;     ///< transform coefficient
 // ====================================================================================================================
 // Enumeration
 // ====================================================================================================================
@@ -68,6 +105,23 @@ enum PredMode
     NUMBER_OF_PREDICTION_MODES = 2,
 };
 
+/// frame coding type, selects the initialization of the context models
+enum FrameType
+{
+    P_FRAME                    = 0,     ///< predicted from the previous frame
+    I_FRAME                    = 1,     ///< intra only
+    NUMBER_OF_FRAME_TYPES      = 2
+};
+
+
+/// coefficient scanning type used in ACS
+enum COEFF_SCAN_TYPE
+{
+    SCAN_DIAG = 0,        ///< up-right diagonal scan
+    SCAN_HOR  = 1,        ///< horizontal first scan
+    SCAN_VER  = 2,        ///< vertical first scan
+    SCAN_NUMBER_OF_TYPES = 3
+};
 
 enum InputColourSpaceConversion // defined in terms of conversion prior to input of encoder.
 {